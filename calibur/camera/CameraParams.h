@@ -161,6 +161,15 @@ typedef struct _MV_FRAME_OUT_INFO_EX_
     unsigned int        nReserved[41];       // ����
 }MV_FRAME_OUT_INFO_EX;
 
+// Frame in an SDK-owned buffer (MV_CC_GetImageBuffer / MV_CC_FreeImageBuffer, SDK 3.x+)
+typedef struct _MV_FRAME_OUT_
+{
+    unsigned char*          pBufAddr;           // image data, valid until MV_CC_FreeImageBuffer
+    MV_FRAME_OUT_INFO_EX    stFrameInfo;        // frame info
+
+    unsigned int            nRes[16];           // reserved
+}MV_FRAME_OUT;
+
 typedef struct _MV_DISPLAY_FRAME_INFO_
 {
     void*                    hWnd;
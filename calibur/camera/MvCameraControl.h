@@ -227,6 +227,27 @@ MV_CAMCTRL_API int __stdcall MV_CC_GetImageForBGR(IN void* handle, IN OUT unsign
  ***********************************************************************/
 MV_CAMCTRL_API int __stdcall MV_CC_GetOneFrameTimeout(IN void* handle, IN OUT unsigned char * pData , IN unsigned int nDataSize, IN OUT MV_FRAME_OUT_INFO_EX* pFrameInfo, unsigned int nMsec);
 
+/***********************************************************************
+ *  @fn         MV_CC_GetImageBuffer
+ *  @brief      Get one frame in an SDK-owned buffer, without copying (SDK 3.x+)
+ *              The buffer stays valid until MV_CC_FreeImageBuffer; every
+ *              buffer obtained must be freed before MV_CC_StopGrabbing
+ *  @param       handle                 [IN]          handle
+ *  @param       pstFrame               [OUT]         buffer address and frame info
+ *  @param       nMsec                  [IN]          timeout, ms
+ *  @return MV_OK on success, error code otherwise
+ ***********************************************************************/
+MV_CAMCTRL_API int __stdcall MV_CC_GetImageBuffer(IN void* handle, OUT MV_FRAME_OUT* pstFrame, unsigned int nMsec);
+
+/***********************************************************************
+ *  @fn         MV_CC_FreeImageBuffer
+ *  @brief      Return a buffer obtained with MV_CC_GetImageBuffer to the SDK
+ *  @param       handle                 [IN]          handle
+ *  @param       pstFrame               [IN]          frame from MV_CC_GetImageBuffer
+ *  @return MV_OK on success, error code otherwise
+ ***********************************************************************/
+MV_CAMCTRL_API int __stdcall MV_CC_FreeImageBuffer(IN void* handle, IN MV_FRAME_OUT* pstFrame);
+
 /***********************************************************************
  *  @fn         MV_CC_Display
  *  @brief      ��ʾһ֡ͼ��ע����ʾ���ڣ��ڲ��Զ���ʾ
@@ -0,0 +1,132 @@
+// calibur/imu/imu_clock.cpp
+#include "imu_clock.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+ImuClock::ImuClock(const ImuClockParams &p) : p_(p) {
+    p_.window      = std::clamp(p_.window, 4, kImuClockMaxWin);
+    p_.min_samples = std::clamp(p_.min_samples, 2, p_.window);
+    p_.reset_count = std::max(p_.reset_count, 1);
+}
+
+void ImuClock::reset() {
+    const uint64_t resets = est_.resets;
+    n_ = head_ = 0;
+    have_tick_ = false;
+    wraps_     = 0;
+    jumps_     = 0;
+    next_fit_  = 0.0;
+    est_ = ImuClockEstimate();
+    est_.resets = resets;
+}
+
+double ImuClock::unwrap(uint32_t tick) {
+    if (have_tick_ && tick < last_tick_ && last_tick_ - tick > 0x80000000u) ++wraps_;
+    have_tick_ = true;
+    last_tick_ = tick;
+    return double((wraps_ << 32) | tick) / p_.tick_hz;
+}
+
+double ImuClock::device_seconds(uint32_t tick) const {
+    const uint64_t last = (wraps_ << 32) | last_tick_;
+    return (double(last) + double(int32_t(tick - last_tick_))) / p_.tick_hz;
+}
+
+bool ImuClock::to_host(uint32_t tick, TimePoint &out) const {
+    if (!est_.valid) return false;
+    out = time_point(est_.arrival(device_seconds(tick)) - p_.latency);
+    return true;
+}
+
+ImuClock::TimePoint ImuClock::on_sample(uint32_t tick, TimePoint first_byte) {
+    double d = unwrap(tick);
+    const double h = seconds(first_byte);
+    ++est_.samples;
+
+    if (est_.valid && std::fabs(h - est_.arrival(d)) > p_.reset_jump) {
+        // a stall only delays a frame or two; a tick that stays off the
+        // line means the device restarted (or its clock did)
+        if (++jumps_ < p_.reset_count) return time_point(est_.arrival(d) - p_.latency);
+        reset();
+        ++est_.resets;
+        d = unwrap(tick);
+        ++est_.samples;
+    } else {
+        jumps_ = 0;
+    }
+
+    if (n_ == 0 || d - last_kept_ >= p_.min_spacing) {
+        win_[head_] = Obs{d, h - d};
+        head_ = (head_ + 1) % p_.window;
+        n_    = std::min(n_ + 1, p_.window);
+        last_kept_ = d;
+    }
+    if (n_ >= p_.min_samples && h >= next_fit_) {
+        fit();
+        next_fit_ = h + p_.refit_period;
+    }
+    return est_.valid ? time_point(est_.arrival(d) - p_.latency)
+                      : first_byte - std::chrono::duration_cast<TimePoint::duration>(
+                                         std::chrono::duration<double>(p_.latency));
+}
+
+void ImuClock::fit() {
+    const double d_ref = win_[(head_ + p_.window - 1) % p_.window].d;
+
+    double x_min = 0.0, x_max = 0.0;
+    for (int i = 0; i < n_; ++i) {
+        const double x = win_[i].d - d_ref;
+        x_min = std::min(x_min, x);
+        x_max = std::max(x_max, x);
+    }
+    const bool fit_slope = x_max - x_min >= p_.min_span;
+
+    // line through the observations whose residual is within the cut (all
+    // when res is null); the slope keeps its last value until the window
+    // is long enough
+    auto line = [&](double cut_lo, double cut_hi, const double *res,
+                    double &c, double &s) -> int {
+        double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+        int cnt = 0;
+        for (int i = 0; i < n_; ++i) {
+            if (res && (res[i] < cut_lo || res[i] > cut_hi)) continue;
+            const double x = win_[i].d - d_ref;
+            const double y = win_[i].y;
+            sx += x; sy += y; sxx += x * x; sxy += x * y;
+            ++cnt;
+        }
+        if (cnt == 0) return 0;
+        const double xbar = sx / cnt, ybar = sy / cnt;
+        const double vxx  = sxx - cnt * xbar * xbar;
+        if (fit_slope && cnt >= 3 && vxx > 0.0) s = (sxy - cnt * xbar * ybar) / vxx;
+        c = ybar - s * xbar;
+        return cnt;
+    };
+
+    double c = 0.0, s = est_.slope;
+    line(0.0, 0.0, nullptr, c, s);
+
+    // robust scale of the residuals: median and MAD
+    double *res = res_.data();
+    for (int i = 0; i < n_; ++i) res[i] = win_[i].y - (c + s * (win_[i].d - d_ref));
+    std::copy(res, res + n_, scratch_.begin());
+    const int mid = n_ / 2;
+    std::nth_element(scratch_.begin(), scratch_.begin() + mid, scratch_.begin() + n_);
+    const double med = scratch_[mid];
+    for (int i = 0; i < n_; ++i) scratch_[i] = std::fabs(res[i] - med);
+    std::nth_element(scratch_.begin(), scratch_.begin() + mid, scratch_.begin() + n_);
+    const double sigma = std::max(1.4826 * scratch_[mid], p_.noise_floor);
+
+    const double cut = p_.reject_sigma * sigma;
+    const int used = line(med - cut, med + cut, res, c, s);
+    if (used == 0) return;
+
+    est_.valid    = true;
+    est_.d_ref    = d_ref;
+    est_.offset   = c;
+    est_.slope    = s;
+    est_.sigma    = sigma;
+    est_.used     = used;
+    est_.rejected = n_ - used;
+}
@@ -0,0 +1,112 @@
+// calibur/imu/imu_clock.hpp
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+// Maps the IMU's own sample timestamps (free-running 32-bit microsecond
+// tick) to host steady_clock.
+//
+// Each frame gives a device tick d and the host time h its first byte
+// arrived (last-byte read time minus the frame's transfer time). Their
+// difference is
+//
+//   h - d = offset + slope * (d - d_ref) + latency + delay
+//
+// where the slope is the rate mismatch of the two clocks and delay is
+// whatever the USB/UART path and the reader thread added on top of the
+// fixed latency. A line is fitted through a window of these differences;
+// late arrivals (scheduling stalls, burst reads) are rejected by their
+// residual against a robust (MAD) scale and the line refitted on the
+// rest. The sample's capture time is then the fitted arrival minus the
+// fixed sample-to-transmit latency, with the per-frame delay jitter gone.
+//
+// The tick is unwrapped across its 2^32 us (~71 min) wrap. A device reset
+// (tick jumping away from the fit for reset_count frames in a row) starts
+// the fit over.
+
+struct ImuClockParams {
+    double tick_hz      = 1e6;
+    double latency      = 0.0;     // s, sample instant to first byte on the wire (datasheet)
+    int    window       = 2048;    // observations kept, <= kImuClockMaxWin
+    double min_spacing  = 0.002;   // s of device time between kept observations
+    double refit_period = 0.05;    // s
+    double min_span     = 1.0;     // s of observations before the slope is fitted
+    int    min_samples  = 20;      // observations before the mapping is valid
+    double reject_sigma = 3.0;     // residual cut, in robust sigmas
+    double noise_floor  = 5e-6;    // s, lower bound on the robust sigma
+    double reset_jump   = 0.05;    // s off the fit that counts as a discontinuity
+    int    reset_count  = 20;      // consecutive discontinuities that restart the fit
+};
+
+constexpr int kImuClockMaxWin = 4096;
+
+struct ImuClockEstimate {
+    bool     valid    = false;
+    double   d_ref    = 0.0;   // device s (unwrapped) the line is anchored at
+    double   offset   = 0.0;   // s, host - device at d_ref (includes the mean path delay)
+    double   slope    = 0.0;   // d(host - device) / d(device)
+    double   sigma    = 0.0;   // s, robust residual scale (arrival jitter)
+    int      used     = 0;     // observations in the last fit
+    int      rejected = 0;     // of which rejected as late
+    uint64_t samples  = 0;
+    uint64_t resets   = 0;
+
+    // device tick rate error against the host (ticks per host s, minus one)
+    double drift() const { return 1.0 / (1.0 + slope) - 1.0; }
+
+    // host s of the first byte for device s
+    double arrival(double dev_s) const { return dev_s + offset + slope * (dev_s - d_ref); }
+};
+
+class ImuClock {
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    explicit ImuClock(const ImuClockParams &p = ImuClockParams());
+
+    // Adds the observation for a frame with device tick `tick` whose first
+    // byte arrived at `first_byte`; returns the sample's capture time
+    // (first_byte - latency until the mapping is valid).
+    TimePoint on_sample(uint32_t tick, TimePoint first_byte);
+
+    // Host time of any device tick near the latest one (e.g. the
+    // data-ready stamp); false until the mapping is valid.
+    bool to_host(uint32_t tick, TimePoint &out) const;
+
+    // Unwrapped device seconds of a tick within +-35 min of the latest.
+    double device_seconds(uint32_t tick) const;
+
+    const ImuClockEstimate &estimate() const { return est_; }
+    const ImuClockParams   &params() const { return p_; }
+    void reset();
+
+    static double seconds(TimePoint t) {
+        return std::chrono::duration<double>(t.time_since_epoch()).count();
+    }
+    static TimePoint time_point(double s) {
+        return TimePoint(std::chrono::duration_cast<TimePoint::duration>(std::chrono::duration<double>(s)));
+    }
+
+private:
+    struct Obs {
+        double d;   // device s
+        double y;   // host - device, s
+    };
+
+    double unwrap(uint32_t tick);
+    void   fit();
+
+    ImuClockParams p_;
+    std::array<Obs, kImuClockMaxWin> win_;
+    std::array<double, kImuClockMaxWin> res_, scratch_;   // fit() only
+    int      n_ = 0, head_ = 0;
+    bool     have_tick_ = false;
+    uint32_t last_tick_ = 0;
+    uint64_t wraps_     = 0;
+    double   last_kept_ = 0.0;
+    double   next_fit_  = 0.0;
+    int      jumps_     = 0;
+    ImuClockEstimate est_;
+};
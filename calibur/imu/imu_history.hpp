@@ -0,0 +1,198 @@
+// calibur/imu/imu_history.hpp
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+#include "imu_data.hpp"
+
+// Attitude sample stamped with the host time it refers to.
+struct ImuSample {
+    std::chrono::steady_clock::time_point t;
+    uint16_t seq          = 0;
+    uint32_t ts_sample_us = 0;                        // device tick, if sent
+    float    euler_deg[3] = {0.0f, 0.0f, 0.0f};       // pitch, roll, yaw (sensor order)
+    float    quat[4]      = {1.0f, 0.0f, 0.0f, 0.0f}; // w, x, y, z
+    float    gyro_dps[3]  = {0.0f, 0.0f, 0.0f};
+};
+
+inline ImuSample imu_sample(const IMUData &d, std::chrono::steady_clock::time_point t) {
+    ImuSample s;
+    s.t            = t;
+    s.seq          = d.seq;
+    s.ts_sample_us = d.ts_sample_us;
+    for (int i = 0; i < 3; ++i) s.euler_deg[i] = d.euler_deg[i];
+    for (int i = 0; i < 4; ++i) s.quat[i] = d.quat[i];
+    for (int i = 0; i < 3; ++i) s.gyro_dps[i] = d.gyro_dps[i];
+    return s;
+}
+
+// ===== interpolation =====
+
+// Shortest-arc SLERP of unit quaternions (w, x, y, z); nlerp when nearly
+// parallel.
+inline void imu_slerp(const float *a, const float *b, float alpha, float *out) {
+    float dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+    float sb  = 1.0f;
+    if (dot < 0.0f) { dot = -dot; sb = -1.0f; }
+
+    float wa = 1.0f - alpha, wb = alpha;
+    if (dot < 0.9995f) {
+        const float th = std::acos(dot);
+        const float s  = 1.0f / std::sin(th);
+        wa = std::sin((1.0f - alpha) * th) * s;
+        wb = std::sin(alpha * th) * s;
+    }
+    float n = 0.0f;
+    for (int i = 0; i < 4; ++i) {
+        out[i] = wa * a[i] + sb * wb * b[i];
+        n += out[i] * out[i];
+    }
+    n = 1.0f / std::sqrt(n);
+    for (int i = 0; i < 4; ++i) out[i] *= n;
+}
+
+// Linear in degrees along the shorter way round, result in [-180, 180).
+inline float imu_lerp_deg(float a, float b, float alpha) {
+    float d = std::fmod(b - a + 180.0f, 360.0f);
+    if (d < 0.0f) d += 360.0f;
+    float v = a + alpha * (d - 180.0f);
+    v = std::fmod(v + 180.0f, 360.0f);
+    if (v < 0.0f) v += 360.0f;
+    return v - 180.0f;
+}
+
+inline void imu_interpolate(const ImuSample &a, const ImuSample &b,
+                            std::chrono::steady_clock::time_point t, ImuSample &out) {
+    const auto span = b.t - a.t;
+    const float alpha = span.count() > 0
+        ? std::chrono::duration<float>(t - a.t).count() / std::chrono::duration<float>(span).count()
+        : 1.0f;
+    out = alpha < 0.5f ? a : b;   // seq, device tick of the nearer sample
+    out.t = t;
+    for (int i = 0; i < 3; ++i) {
+        out.euler_deg[i] = imu_lerp_deg(a.euler_deg[i], b.euler_deg[i], alpha);
+        out.gyro_dps[i]  = a.gyro_dps[i] + alpha * (b.gyro_dps[i] - a.gyro_dps[i]);
+    }
+    imu_slerp(a.quat, b.quat, alpha, out.quat);
+}
+
+// ===== history =====
+//
+// Ring of the last kCapacity samples (~1 s at 1 kHz). One writer (the IMU
+// reader thread) pushes in time order; any number of readers look samples
+// up without locks or allocation.
+//
+// Each slot carries a version: odd while the writer fills it, 2 * index + 2
+// once sample `index` is complete. Readers copy a slot and check the
+// version before and after, so a slot recycled under them is detected and
+// the lookup retried instead of returning a torn sample. The oldest kGuard
+// slots are never searched, which keeps such retries rare.
+class ImuHistory {
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    static constexpr uint64_t kCapacity = 1024;   // power of two
+    static constexpr uint64_t kGuard    = 32;
+
+    // Writer thread only. Samples must arrive in non-decreasing time.
+    void push(const ImuSample &s) {
+        const uint64_t i = head_.load(std::memory_order_relaxed);
+        Slot &slot = slots_[i & (kCapacity - 1)];
+        slot.ver.store(2 * i + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.t_ns.store(s.t.time_since_epoch().count(), std::memory_order_relaxed);
+        slot.s = s;
+        slot.ver.store(2 * i + 2, std::memory_order_release);
+        head_.store(i + 1, std::memory_order_release);
+    }
+
+    uint64_t count() const { return head_.load(std::memory_order_acquire); }
+    bool     empty() const { return count() == 0; }
+
+    bool latest(ImuSample &out) const {
+        for (int attempt = 0; attempt < 4; ++attempt) {
+            const uint64_t h = count();
+            if (h == 0) return false;
+            if (read(h - 1, out)) return true;
+        }
+        return false;
+    }
+
+    // Attitude at host time t: interpolated between the samples around t
+    // (binary search), the newest sample when t is past it. False when
+    // empty or t is older than the retained window.
+    bool at(TimePoint t, ImuSample &out) const {
+        const int64_t tn = t.time_since_epoch().count();
+        for (int attempt = 0; attempt < 4; ++attempt) {
+            const uint64_t h = count();
+            if (h == 0) return false;
+            const uint64_t lo0 = h > kCapacity ? h - kCapacity + kGuard : 0;
+
+            if (time_ns(h - 1) <= tn) {
+                if (read(h - 1, out)) return true;
+                continue;
+            }
+            if (time_ns(lo0) > tn) return false;
+
+            // last index in [lo0, h - 1) with time <= tn
+            uint64_t lo = lo0, hi = h - 1;
+            while (hi - lo > 1) {
+                const uint64_t mid = lo + (hi - lo) / 2;
+                if (time_ns(mid) <= tn) lo = mid;
+                else                    hi = mid;
+            }
+            ImuSample a, b;
+            if (!read(lo, a) || !read(lo + 1, b)) continue;
+            if (a.t > t || b.t < t) continue;   // recycled during the search
+            imu_interpolate(a, b, t, out);
+            return true;
+        }
+        return false;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> ver{0};
+        std::atomic<int64_t>  t_ns{0};
+        ImuSample             s;
+    };
+
+    int64_t time_ns(uint64_t i) const {
+        return slots_[i & (kCapacity - 1)].t_ns.load(std::memory_order_relaxed);
+    }
+
+    bool read(uint64_t i, ImuSample &out) const {
+        const Slot &slot = slots_[i & (kCapacity - 1)];
+        const uint64_t v = slot.ver.load(std::memory_order_acquire);
+        if (v != 2 * i + 2) return false;
+        out = slot.s;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.ver.load(std::memory_order_relaxed) == v;
+    }
+
+    Slot slots_[kCapacity];
+    std::atomic<uint64_t> head_{0};   // samples pushed
+};
+
+// ===== gimbal attitude =====
+
+// euler_deg = {pitch, roll, yaw} in *world frame*; yaw as the IMU reports
+// it, not relative to any start-up yaw.
+inline void imu_yaw_pitch(const ImuSample &s, float &yaw_cam_world, float &pitch_cam_world) {
+    const float deg = 3.14159265f / 180.0f;
+    pitch_cam_world = s.euler_deg[0] * deg;
+    yaw_cam_world   = s.euler_deg[2] * deg;
+}
+
+// Attitude at time t (e.g. frame capture), interpolated from the history;
+// the latest sample if t is outside it.
+inline bool imu_yaw_pitch_at(const ImuHistory &h, std::chrono::steady_clock::time_point t,
+                             float &yaw_cam_world, float &pitch_cam_world) {
+    ImuSample s;
+    if (!h.at(t, s) && !h.latest(s)) return false;
+    imu_yaw_pitch(s, yaw_cam_world, pitch_cam_world);
+    return true;
+}
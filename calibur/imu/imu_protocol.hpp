@@ -0,0 +1,279 @@
+// calibur/imu/imu_protocol.hpp
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "imu_data.hpp"
+
+// IMU serial frame:
+//
+//   0x59 0x53 | seq (u16 LE) | len (u8) | TLV blocks [len] | ck1 ck2
+//
+// TLV block: id (u8) | length (u8) | value. The checksum is a Fletcher-style
+// pair over seq, len and the payload (not the header). Fixed-point fields
+// are i32 LE scaled by 1e-6 (accel m/s^2, gyro dps, euler deg, quaternion),
+// 1e-3 for raw magnetometer mG; temperature is i16 in 0.01 C.
+
+static constexpr uint8_t IMU_HDR0        = 0x59;
+static constexpr uint8_t IMU_HDR1        = 0x53;
+static constexpr size_t  IMU_MAX_PAYLOAD = 255;
+static constexpr size_t  IMU_FRAME_EXTRA = 7;   // header x2, seq x2, len, ck x2
+
+static constexpr uint8_t ID_TEMP          = 0x01;
+static constexpr uint8_t ID_ACCEL         = 0x10;
+static constexpr uint8_t ID_GYRO          = 0x20;
+static constexpr uint8_t ID_MAGN_NORM     = 0x30;
+static constexpr uint8_t ID_MAGN_RAW      = 0x31;
+static constexpr uint8_t ID_EULER         = 0x40;
+static constexpr uint8_t ID_QUAT          = 0x41;
+static constexpr uint8_t ID_TS_SAMPLE     = 0x51;
+static constexpr uint8_t ID_TS_DATAREADY  = 0x52;
+static constexpr uint8_t ID_POS           = 0x68;
+static constexpr uint8_t ID_VEL           = 0x70;
+static constexpr uint8_t ID_FUSION_STATE  = 0x80;
+
+inline void imu_checksum(const uint8_t *p, size_t n, uint8_t &ck1, uint8_t &ck2) {
+    ck1 = 0;
+    ck2 = 0;
+    for (size_t i = 0; i < n; ++i) {
+        ck1 = static_cast<uint8_t>(ck1 + p[i]);
+        ck2 = static_cast<uint8_t>(ck2 + ck1);
+    }
+}
+
+// ---- Decoding ----
+
+inline uint16_t imu_u16_le(const uint8_t *p) {
+    return static_cast<uint16_t>(p[0]) |
+           static_cast<uint16_t>(p[1]) << 8;
+}
+
+inline uint32_t imu_u32_le(const uint8_t *p) {
+    return static_cast<uint32_t>(p[0])
+         | (static_cast<uint32_t>(p[1]) << 8)
+         | (static_cast<uint32_t>(p[2]) << 16)
+         | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline void imu_get_scaled(const uint8_t *p, float *v, int n, float scale) {
+    for (int i = 0; i < n; ++i) v[i] = static_cast<int32_t>(imu_u32_le(p + 4 * i)) * scale;
+}
+
+// One TLV block into out; unknown ids and unexpected lengths are ignored.
+inline void imu_decode_block(uint8_t id, const uint8_t *v, uint8_t len, IMUData &out) {
+    switch (id) {
+    case ID_TEMP:
+        if (len == 2) {
+            out.temp_c   = static_cast<int16_t>(imu_u16_le(v)) * 0.01f;
+            out.has_temp = true;
+        }
+        break;
+    case ID_ACCEL:
+        if (len == 12) { imu_get_scaled(v, out.accel_mps2, 3, 1e-6f); out.has_accel = true; }
+        break;
+    case ID_GYRO:
+        if (len == 12) { imu_get_scaled(v, out.gyro_dps, 3, 1e-6f); out.has_gyro = true; }
+        break;
+    case ID_MAGN_NORM:
+        if (len == 12) { imu_get_scaled(v, out.mag_norm, 3, 1e-6f); out.has_mag_norm = true; }
+        break;
+    case ID_MAGN_RAW:
+        if (len == 12) { imu_get_scaled(v, out.mag_mg, 3, 1e-3f); out.has_mag_mg = true; }
+        break;
+    case ID_EULER:   // pitch, roll, yaw
+        if (len == 12) { imu_get_scaled(v, out.euler_deg, 3, 1e-6f); out.has_euler = true; }
+        break;
+    case ID_QUAT:
+        if (len == 16) { imu_get_scaled(v, out.quat, 4, 1e-6f); out.has_quat = true; }
+        break;
+    case ID_TS_SAMPLE:
+        if (len == 4) { out.ts_sample_us = imu_u32_le(v); out.has_ts_sample = true; }
+        break;
+    case ID_TS_DATAREADY:
+        if (len == 4) { out.ts_dataready_us = imu_u32_le(v); out.has_ts_dataready = true; }
+        break;
+    case ID_FUSION_STATE:
+        if (len == 1) {
+            out.fusion_state = v[0] & 0x0F;
+            out.gnss_state   = (v[0] >> 4) & 0x0F;
+            out.has_fusion   = true;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// Full payload (list of TLVs); a truncated last block is dropped.
+inline void imu_decode_payload(const uint8_t *p, size_t n, IMUData &out) {
+    size_t i = 0;
+    while (i + 2 <= n) {
+        const uint8_t id  = p[i++];
+        const uint8_t len = p[i++];
+        if (i + len > n) break;
+        imu_decode_block(id, p + i, len, out);
+        i += len;
+    }
+}
+
+// ---- Incremental frame parser ----
+//
+// Bytes land in a fixed ring, either copied in by feed() or read() straight
+// into write_ptr() / commit(). parse() then walks it:
+//
+//   HEADER  discard bytes until 0x59 0x53
+//   LENGTH  wait for seq and len
+//   BODY    wait for len + 7 bytes, check, decode, hand out
+//
+// A frame failing its checksum costs one byte: the scan restarts right
+// after its first header byte, so a real frame hidden behind a false
+// header is not lost. No allocation; the ring always holds a full frame.
+class ImuFrameParser {
+public:
+    struct Stats {
+        uint64_t frames       = 0;
+        uint64_t bad_checksum = 0;
+        uint64_t skipped      = 0;   // bytes outside any frame
+    };
+
+    static constexpr size_t kRingSize = 1024;   // power of two, > 2 frames
+
+    // Contiguous free space at the write end; room is never 0 after parse().
+    uint8_t *write_ptr(size_t &room) {
+        const size_t pos = tail_ & (kRingSize - 1);
+        room = std::min(kRingSize - (tail_ - head_), kRingSize - pos);
+        return ring_ + pos;
+    }
+
+    void commit(size_t n) { tail_ += n; }
+
+    // Calls on_frame(const IMUData &) for every complete frame buffered;
+    // returns how many.
+    template <class F>
+    size_t parse(F &&on_frame) {
+        size_t n = 0;
+        for (;;) {
+            const size_t avail = tail_ - head_;
+            if (avail == 0) break;
+            if (at(0) != IMU_HDR0 || (avail >= 2 && at(1) != IMU_HDR1)) {
+                ++head_;
+                ++stats_.skipped;
+                continue;
+            }
+            if (avail < 5) break;
+            const size_t len = at(4);
+            if (avail < len + IMU_FRAME_EXTRA) break;
+
+            copy_out(2, len + 3, scratch_);   // seq, len, payload
+            uint8_t ck1, ck2;
+            imu_checksum(scratch_, len + 3, ck1, ck2);
+            if (ck1 != at(len + 5) || ck2 != at(len + 6)) {
+                ++stats_.bad_checksum;
+                ++stats_.skipped;
+                ++head_;
+                continue;
+            }
+            IMUData d;
+            d.seq = imu_u16_le(scratch_);
+            imu_decode_payload(scratch_ + 3, len, d);
+            head_ += len + IMU_FRAME_EXTRA;
+            last_size_ = len + IMU_FRAME_EXTRA;
+            ++stats_.frames;
+            ++n;
+            on_frame(static_cast<const IMUData &>(d));
+        }
+        return n;
+    }
+
+    template <class F>
+    size_t feed(const uint8_t *data, size_t n, F &&on_frame) {
+        size_t frames = 0;
+        while (n > 0) {
+            size_t room;
+            uint8_t *w = write_ptr(room);
+            const size_t k = std::min(room, n);
+            std::memcpy(w, data, k);
+            commit(k);
+            frames += parse(on_frame);
+            data += k;
+            n -= k;
+        }
+        return frames;
+    }
+
+    size_t buffered() const { return tail_ - head_; }
+    // Size of the frame being handed out (valid inside on_frame).
+    size_t last_frame_size() const { return last_size_; }
+    const Stats &stats() const { return stats_; }
+    void reset() { head_ = tail_ = 0; }
+
+private:
+    uint8_t at(size_t i) const { return ring_[(head_ + i) & (kRingSize - 1)]; }
+
+    void copy_out(size_t off, size_t n, uint8_t *dst) const {
+        const size_t pos   = (head_ + off) & (kRingSize - 1);
+        const size_t first = std::min(n, kRingSize - pos);
+        std::memcpy(dst, ring_ + pos, first);
+        std::memcpy(dst + first, ring_, n - first);
+    }
+
+    uint8_t ring_[kRingSize];
+    uint8_t scratch_[IMU_MAX_PAYLOAD + 3];
+    size_t  head_ = 0, tail_ = 0;   // free-running
+    size_t  last_size_ = 0;
+    Stats   stats_;
+};
+
+// ---- Encoding (simulators, tests) ----
+
+inline size_t imu_put_tlv(uint8_t *p, uint8_t id, const void *value, uint8_t len) {
+    p[0] = id;
+    p[1] = len;
+    std::memcpy(p + 2, value, len);
+    return size_t(len) + 2;
+}
+
+inline size_t imu_put_scaled(uint8_t *p, uint8_t id, const float *v, int n, float scale) {
+    int32_t raw[4];
+    for (int i = 0; i < n; ++i) raw[i] = static_cast<int32_t>(std::lround(v[i] * scale));
+    return imu_put_tlv(p, id, raw, uint8_t(4 * n));
+}
+
+// TLV payload for every field of d that is present; returns its length.
+inline size_t imu_encode_payload(const IMUData &d, uint8_t *p) {
+    size_t n = 0;
+    if (d.has_temp) {
+        const int16_t t = static_cast<int16_t>(std::lround(d.temp_c * 100.0f));
+        n += imu_put_tlv(p + n, ID_TEMP, &t, 2);
+    }
+    if (d.has_accel)    n += imu_put_scaled(p + n, ID_ACCEL, d.accel_mps2, 3, 1e6f);
+    if (d.has_gyro)     n += imu_put_scaled(p + n, ID_GYRO, d.gyro_dps, 3, 1e6f);
+    if (d.has_mag_norm) n += imu_put_scaled(p + n, ID_MAGN_NORM, d.mag_norm, 3, 1e6f);
+    if (d.has_mag_mg)   n += imu_put_scaled(p + n, ID_MAGN_RAW, d.mag_mg, 3, 1e3f);
+    if (d.has_euler)    n += imu_put_scaled(p + n, ID_EULER, d.euler_deg, 3, 1e6f);
+    if (d.has_quat)     n += imu_put_scaled(p + n, ID_QUAT, d.quat, 4, 1e6f);
+    if (d.has_ts_sample)    n += imu_put_tlv(p + n, ID_TS_SAMPLE, &d.ts_sample_us, 4);
+    if (d.has_ts_dataready) n += imu_put_tlv(p + n, ID_TS_DATAREADY, &d.ts_dataready_us, 4);
+    if (d.has_fusion) {
+        const uint8_t s = uint8_t((d.fusion_state & 0x0F) | (d.gnss_state << 4));
+        n += imu_put_tlv(p + n, ID_FUSION_STATE, &s, 1);
+    }
+    return n;
+}
+
+// Complete frame around a payload of len <= IMU_MAX_PAYLOAD bytes; out
+// must hold len + IMU_FRAME_EXTRA. Returns the frame size.
+inline size_t imu_encode_frame(uint16_t seq, const uint8_t *payload, size_t len, uint8_t *out) {
+    out[0] = IMU_HDR0;
+    out[1] = IMU_HDR1;
+    out[2] = uint8_t(seq & 0xFF);
+    out[3] = uint8_t(seq >> 8);
+    out[4] = uint8_t(len);
+    std::memcpy(out + 5, payload, len);
+    imu_checksum(out + 2, len + 3, out[5 + len], out[6 + len]);
+    return len + IMU_FRAME_EXTRA;
+}
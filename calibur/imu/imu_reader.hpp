@@ -7,7 +7,10 @@
 #include <mutex>
 #include <cstdint>
 
+#include "imu_clock.hpp"
 #include "imu_data.hpp"
+#include "imu_history.hpp"
+#include "imu_protocol.hpp"
 
 class IMUReader {
 public:
@@ -23,14 +26,27 @@ public:
     // Thread-safe copy of latest IMU data
     bool get_latest(IMUData &out);
 
+    // Every frame is also pushed to h (before start()), stamped with its
+    // capture time: the device sample stamp mapped to host time by an
+    // ImuClock, or the arrival time minus the latency without one.
+    void set_history(ImuHistory *h) { history_ = h; }
+    void set_clock_params(const ImuClockParams &p) { clock_ = ImuClock(p); }
+
+    // Current device -> host clock mapping
+    ImuClockEstimate clock_estimate();
+
+    // Parser counters, updated after every read burst
+    ImuFrameParser::Stats stats();
+
 private:
     void worker();
 
-    int  open_serial();
+    int  open_serial(bool verbose = true);
     void close_serial();
 
-    bool read_exact(uint8_t *buf, size_t n);
-    bool read_frame(IMUData &out);
+    // Read everything pending into the parser and publish the frames;
+    // bytes read, -1 on a read error.
+    long drain();
 
 private:
     std::string device_;
@@ -42,7 +58,13 @@ private:
     std::atomic<bool> running_;
     std::thread       thread_;
 
+    ImuFrameParser parser_;   // worker thread only
+    ImuHistory    *history_ = nullptr;
+    ImuClock       clock_;
+
     std::mutex data_mutex_;
     IMUData    latest_;
     bool       has_data_;
+    ImuFrameParser::Stats stats_;
+    ImuClockEstimate      clock_est_;
 };
@@ -0,0 +1,233 @@
+// compact.hpp
+#pragma once
+
+#include <cstdint>
+#include "rbpf_params.hpp"
+#include "philox.hpp"   // philox_float_bits / philox_bits_float
+
+#if defined(__CUDACC__)
+#include <cuda_fp16.h>
+#elif defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+// Compact particle storage: the fast-moving, finite-differenced fields stay
+// fp32, the slowly-varying ones (accelerations, geometry, KF covariance
+// diagonals) are stored as 16-bit floats and widened to fp32 in registers for
+// the per-particle model in rbpf_model.hpp. 100 B per particle instead of
+// 132 B, and resampling moves one record instead of six scattered slices.
+
+#ifndef PF_HD
+#ifdef __CUDACC__
+#define PF_HD __host__ __device__
+#else
+#define PF_HD
+#endif
+#endif
+
+enum class ParticleStorage : uint8_t {
+    FP32 = 0,   // RBPFHostParticles / RBPFDevice, the default
+    FP16 = 1,   // IEEE half: 11-bit significand, range 6e-8 .. 65504
+    BF16 = 2    // bfloat16: 8-bit significand, fp32 range
+};
+
+inline const char *particle_storage_name(ParticleStorage s) {
+    switch (s) {
+        case ParticleStorage::FP16: return "fp16";
+        case ParticleStorage::BF16: return "bf16";
+        default:                    return "fp32";
+    }
+}
+
+// ======================= 16-BIT CODECS ================
+// Round-to-nearest-even, inf/NaN preserved. The *_soft versions are the
+// portable bit-level reference; the plain ones use F16C / CUDA intrinsics
+// where available and give identical results.
+
+PF_HD inline uint16_t f32_to_f16_soft(float f) {
+    uint32_t u = philox_float_bits(f);
+    const uint32_t sign = (u >> 16) & 0x8000u;
+    u &= 0x7FFFFFFFu;
+
+    uint32_t o;
+    if (u >= 0x47800000u) {                     // >= 65536, inf, NaN
+        o = (u > 0x7F800000u) ? 0x7E00u : 0x7C00u;
+    } else if (u < 0x38800000u) {               // half subnormal / zero
+        // adding 0.5 aligns the value to a 2^-24 grid with RNE
+        const float a = philox_bits_float(u) + 0.5f;
+        o = philox_float_bits(a) - 0x3F000000u;
+    } else {
+        const uint32_t odd = (u >> 13) & 1u;
+        u += 0xC8000FFFu + odd;                 // rebias exponent, round
+        o = u >> 13;
+    }
+    return uint16_t(o | sign);
+}
+
+PF_HD inline float f16_to_f32_soft(uint16_t h) {
+    const uint32_t shifted_exp = 0x7C00u << 13;
+    uint32_t u = uint32_t(h & 0x7FFFu) << 13;
+    const uint32_t e = u & shifted_exp;
+    u += (127u - 15u) << 23;
+    float f;
+    if (e == shifted_exp) {                     // inf / NaN
+        u += (128u - 16u) << 23;
+        f = philox_bits_float(u);
+    } else if (e == 0) {                        // zero / subnormal
+        u += 1u << 23;
+        f = philox_bits_float(u) - 6.103515625e-05f;
+    } else {
+        f = philox_bits_float(u);
+    }
+    return philox_bits_float(philox_float_bits(f) | (uint32_t(h & 0x8000u) << 16));
+}
+
+PF_HD inline uint16_t f32_to_f16(float f) {
+#if defined(__CUDA_ARCH__)
+    return __half_as_ushort(__float2half_rn(f));
+#elif defined(__F16C__)
+    return uint16_t(_cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT));
+#else
+    return f32_to_f16_soft(f);
+#endif
+}
+
+PF_HD inline float f16_to_f32(uint16_t h) {
+#if defined(__CUDA_ARCH__)
+    return __half2float(__ushort_as_half(h));
+#elif defined(__F16C__)
+    return _cvtsh_ss(h);
+#else
+    return f16_to_f32_soft(h);
+#endif
+}
+
+PF_HD inline uint16_t f32_to_bf16(float f) {
+    const uint32_t u = philox_float_bits(f);
+    if ((u & 0x7FFFFFFFu) > 0x7F800000u) return uint16_t((u >> 16) | 0x0040u);   // quiet NaN
+    return uint16_t((u + 0x7FFFu + ((u >> 16) & 1u)) >> 16);
+}
+
+PF_HD inline float bf16_to_f32(uint16_t h) {
+    return philox_bits_float(uint32_t(h) << 16);
+}
+
+// ======================= PACKED PARTICLE ==============
+
+constexpr int RBPF_PACKED_SLOW = 17;
+
+// slow[] layout
+enum PackedSlowIdx {
+    SLOW_ACC   = 0,    // ax, ay, az, alpha        (state)
+    SLOW_GEOM  = 4,    // r1, r2, h                (state)
+    SLOW_KF_G  = 7,    // r1, r2, h                (KF mean)
+    SLOW_PVEL  = 10,   // vx, vy, vz, yaw_rate     (KF cov diag)
+    SLOW_PGEOM = 14    // r1, r2, h                (KF cov diag)
+};
+
+struct RBPFPackedParticle {
+    float    fast[8];       // tx, ty, tz, vx, vy, vz, yaw, omega
+    float    kf_vel[4];     // KF mean vx, vy, vz, yaw_rate
+    float    prev_pos[3];
+    float    prev_yaw;
+    uint16_t slow[RBPF_PACKED_SLOW];
+    uint16_t pad;
+};
+
+static_assert(sizeof(RBPFPackedParticle) == 100, "packed particle layout");
+
+// Unpacked working copy of one particle, laid out for rbpf_model.hpp.
+struct RBPFParticleRegs {
+    float X[D];
+    float mean[KF_D];
+    float Pvel[4];
+    float Pgeom[3];
+    float prev_pos[3];
+    float prev_yaw;
+};
+
+// Widen / narrow all 17 slow fields at once: two 8-wide F16C conversions for
+// fp16 on x86, a shift loop the compiler vectorizes for bf16.
+template <ParticleStorage S>
+PF_HD inline void rbpf_unpack_slow(const uint16_t *slow, float *f) {
+#if defined(__F16C__) && !defined(__CUDA_ARCH__)
+    if (S == ParticleStorage::FP16) {
+        _mm256_storeu_ps(f,     _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)slow)));
+        _mm256_storeu_ps(f + 8, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(slow + 8))));
+        f[16] = f16_to_f32(slow[16]);
+        return;
+    }
+#endif
+    for (int k = 0; k < RBPF_PACKED_SLOW; ++k)
+        f[k] = (S == ParticleStorage::BF16) ? bf16_to_f32(slow[k]) : f16_to_f32(slow[k]);
+}
+
+template <ParticleStorage S>
+PF_HD inline void rbpf_pack_slow(const float *f, uint16_t *slow) {
+#if defined(__F16C__) && !defined(__CUDA_ARCH__)
+    if (S == ParticleStorage::FP16) {
+        _mm_storeu_si128((__m128i *)slow,
+                         _mm256_cvtps_ph(_mm256_loadu_ps(f), _MM_FROUND_TO_NEAREST_INT));
+        _mm_storeu_si128((__m128i *)(slow + 8),
+                         _mm256_cvtps_ph(_mm256_loadu_ps(f + 8), _MM_FROUND_TO_NEAREST_INT));
+        slow[16] = f32_to_f16(f[16]);
+        return;
+    }
+#endif
+    for (int k = 0; k < RBPF_PACKED_SLOW; ++k)
+        slow[k] = (S == ParticleStorage::BF16) ? f32_to_bf16(f[k]) : f32_to_f16(f[k]);
+}
+
+template <ParticleStorage S>
+PF_HD inline void rbpf_unpack_particle(const RBPFPackedParticle &p, RBPFParticleRegs &r) {
+    float f[RBPF_PACKED_SLOW];
+    rbpf_unpack_slow<S>(p.slow, f);
+
+    for (int k = 0; k < 6; ++k) r.X[IDX_TX + k] = p.fast[k];
+    r.X[IDX_YAW]   = p.fast[6];
+    r.X[IDX_OMEGA] = p.fast[7];
+    for (int k = 0; k < 3; ++k) r.X[IDX_AX + k] = f[SLOW_ACC + k];
+    r.X[IDX_ALPHA] = f[SLOW_ACC + 3];
+    for (int k = 0; k < 3; ++k) r.X[IDX_R1 + k] = f[SLOW_GEOM + k];
+
+    for (int k = 0; k < 4; ++k) r.mean[k]     = p.kf_vel[k];
+    for (int k = 0; k < 3; ++k) r.mean[4 + k] = f[SLOW_KF_G + k];
+    for (int k = 0; k < 4; ++k) r.Pvel[k]     = f[SLOW_PVEL + k];
+    for (int k = 0; k < 3; ++k) r.Pgeom[k]    = f[SLOW_PGEOM + k];
+
+    for (int k = 0; k < 3; ++k) r.prev_pos[k] = p.prev_pos[k];
+    r.prev_yaw = p.prev_yaw;
+}
+
+template <ParticleStorage S>
+PF_HD inline void rbpf_pack_particle(const RBPFParticleRegs &r, RBPFPackedParticle &p) {
+    float f[RBPF_PACKED_SLOW];
+    for (int k = 0; k < 3; ++k) f[SLOW_ACC + k] = r.X[IDX_AX + k];
+    f[SLOW_ACC + 3] = r.X[IDX_ALPHA];
+    for (int k = 0; k < 3; ++k) f[SLOW_GEOM + k]  = r.X[IDX_R1 + k];
+    for (int k = 0; k < 3; ++k) f[SLOW_KF_G + k]  = r.mean[4 + k];
+    for (int k = 0; k < 4; ++k) f[SLOW_PVEL + k]  = r.Pvel[k];
+    for (int k = 0; k < 3; ++k) f[SLOW_PGEOM + k] = r.Pgeom[k];
+    rbpf_pack_slow<S>(f, p.slow);
+
+    for (int k = 0; k < 6; ++k) p.fast[k] = r.X[IDX_TX + k];
+    p.fast[6] = r.X[IDX_YAW];
+    p.fast[7] = r.X[IDX_OMEGA];
+    for (int k = 0; k < 4; ++k) p.kf_vel[k] = r.mean[k];
+    for (int k = 0; k < 3; ++k) p.prev_pos[k] = r.prev_pos[k];
+    p.prev_yaw = r.prev_yaw;
+    p.pad = 0;
+}
+
+// Runtime-format entry points (construction, reset, tests).
+inline void rbpf_unpack_particle(const RBPFPackedParticle &p, ParticleStorage s,
+                                 RBPFParticleRegs &r) {
+    if (s == ParticleStorage::BF16) rbpf_unpack_particle<ParticleStorage::BF16>(p, r);
+    else                            rbpf_unpack_particle<ParticleStorage::FP16>(p, r);
+}
+
+inline void rbpf_pack_particle(const RBPFParticleRegs &r, ParticleStorage s,
+                               RBPFPackedParticle &p) {
+    if (s == ParticleStorage::BF16) rbpf_pack_particle<ParticleStorage::BF16>(r, p);
+    else                            rbpf_pack_particle<ParticleStorage::FP16>(r, p);
+}
@@ -0,0 +1,60 @@
+// detection_log.cpp
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include "detection_log.hpp"
+
+namespace {
+constexpr int kLogFields[] = {IDX_TX, IDX_TY, IDX_TZ, IDX_YAW, IDX_R1, IDX_R2, IDX_H};
+constexpr int kNumLogFields = sizeof(kLogFields) / sizeof(kLogFields[0]);
+}
+
+bool detection_log_read(const std::string &path, std::vector<DetectionRecord> &out) {
+    std::ifstream in(path);
+    if (!in) return false;
+
+    std::string line;
+    int lineno = 0;
+    while (std::getline(in, line)) {
+        ++lineno;
+        if (line.empty() || line[0] == '#' || line[0] == 't') continue;   // comment / header
+
+        DetectionRecord r{};
+        const char *s = line.c_str();
+        char *end = nullptr;
+        r.t = std::strtod(s, &end);
+        bool ok = end != s;
+        for (int k = 0; ok && k < kNumLogFields; ++k) {
+            if (*end != ',') { ok = false; break; }
+            s = end + 1;
+            r.z[kLogFields[k]] = std::strtof(s, &end);
+            ok = end != s;
+        }
+        if (!ok) {
+            std::cerr << "[PF] " << path << ":" << lineno << ": malformed detection\n";
+            return false;
+        }
+        out.push_back(r);
+    }
+    return true;
+}
+
+bool DetectionLogWriter::open(const std::string &path) {
+    close();
+    f_ = std::fopen(path.c_str(), "w");
+    if (!f_) return false;
+    std::fprintf(f_, "t,x,y,z,yaw,r1,r2,h\n");
+    return true;
+}
+
+void DetectionLogWriter::append(double t, const float *z) {
+    if (!f_) return;
+    std::fprintf(f_, "%.6f", t);
+    for (int k : kLogFields) std::fprintf(f_, ",%.6g", z[k]);
+    std::fputc('\n', f_);
+}
+
+void DetectionLogWriter::close() {
+    if (f_) std::fclose(f_);
+    f_ = nullptr;
+}
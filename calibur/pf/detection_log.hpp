@@ -0,0 +1,41 @@
+// detection_log.hpp
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "rbpf_params.hpp"
+
+// Recorded detection stream for offline replay (pf_tune, tests). One CSV
+// line per detection, capture time in seconds then the measured fields:
+//
+//   t,x,y,z,yaw,r1,r2,h
+//
+// Lines starting with '#' are comments. A gap larger than the tracker's
+// coast limit is treated as a track loss by the replay, so separate
+// engagements can share one file.
+
+struct DetectionRecord {
+    double t;
+    float  z[D];   // laid out like the state, unused dims 0
+};
+
+// Appends to `path`; false if it cannot be read / parsed.
+bool detection_log_read(const std::string &path, std::vector<DetectionRecord> &out);
+
+class DetectionLogWriter {
+public:
+    DetectionLogWriter() = default;
+    ~DetectionLogWriter() { close(); }
+
+    DetectionLogWriter(const DetectionLogWriter&) = delete;
+    DetectionLogWriter& operator=(const DetectionLogWriter&) = delete;
+
+    bool open(const std::string &path);
+    void append(double t, const float *z);
+    void close();
+    bool is_open() const { return f_ != nullptr; }
+
+private:
+    std::FILE *f_ = nullptr;
+};
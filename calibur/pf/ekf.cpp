@@ -0,0 +1,140 @@
+// ekf.cpp
+#include <cmath>
+#include <Eigen/Cholesky>
+#include "ekf.hpp"
+#include "rbpf_model.hpp"
+
+// measurement rows -> state index
+static constexpr int kMeasIdx[EKF_Z] = {
+    IDX_TX, IDX_TY, IDX_TZ, IDX_YAW, IDX_OMEGA, IDX_R1, IDX_R2, IDX_H
+};
+
+// effectively "no observation" for the yaw-rate row when it is unavailable
+static constexpr float kNoObsVar = 1e8f;
+
+EKFTracker::EKFTracker(int num_slots, const RBPFParams &p)
+    : params_(p), slots_(num_slots)
+{
+    s_.x.setZero();
+    s_.P.setIdentity();
+    s_.z_yaw_prev = NAN;
+}
+
+void EKFTracker::reset(const float *z) {
+    s_.x.setZero();
+    for (int k = 0; k < D; ++k) s_.x(k) = z[k];
+    s_.x(IDX_YAW) = wrap_to_pi(z[IDX_YAW]);
+    // the measurement carries pos / yaw / geometry only, motion starts at rest
+    for (int k = 0; k < 3; ++k) {
+        s_.x(IDX_VX + k) = 0.0f;
+        s_.x(IDX_AX + k) = 0.0f;
+    }
+    s_.x(IDX_OMEGA) = 0.0f;
+    s_.x(IDX_ALPHA) = 0.0f;
+
+    s_.P.setZero();
+    for (int k = 0; k < 3; ++k) {
+        s_.P(IDX_TX + k, IDX_TX + k) = params_.Rz_pos_diag[k];
+        s_.P(IDX_VX + k, IDX_VX + k) = params_.init_vel_std[k] * params_.init_vel_std[k];
+        s_.P(IDX_AX + k, IDX_AX + k) = params_.Q_acc_diag[k];
+        s_.P(IDX_R1 + k, IDX_R1 + k) = params_.init_geom_std[k] * params_.init_geom_std[k];
+    }
+    s_.P(IDX_YAW, IDX_YAW)     = params_.Rz_yaw;
+    s_.P(IDX_OMEGA, IDX_OMEGA) = params_.init_vel_std[3] * params_.init_vel_std[3];
+    s_.P(IDX_ALPHA, IDX_ALPHA) = params_.Q_yawalpha;
+
+    s_.z_yaw_prev = NAN;
+}
+
+// x <- F x,  P <- F P F^T + Q  with the CA model of rbpf_predict_particle
+void EKFTracker::predict(float dt) {
+    if (dt <= 0.0f) return;
+
+    float xp[D];
+    rbpf_extrapolate_state(s_.x.data(), dt, xp);
+    for (int k = 0; k < D; ++k) s_.x(k) = xp[k];
+
+    StateMat F = StateMat::Identity();
+    const float h2 = 0.5f * dt * dt;
+    for (int k = 0; k < 3; ++k) {
+        F(IDX_TX + k, IDX_VX + k) = dt;
+        F(IDX_TX + k, IDX_AX + k) = h2;
+        F(IDX_VX + k, IDX_AX + k) = dt;
+    }
+    F(IDX_YAW, IDX_OMEGA)   = dt;
+    F(IDX_YAW, IDX_ALPHA)   = h2;
+    F(IDX_OMEGA, IDX_ALPHA) = dt;
+
+    s_.P = (F * s_.P * F.transpose()).eval();
+
+    for (int k = 0; k < 3; ++k) {
+        s_.P(IDX_TX + k, IDX_TX + k) += params_.Q_pos_diag[k]  * dt;
+        s_.P(IDX_VX + k, IDX_VX + k) += params_.Q_vel_diag[k]  * dt;
+        s_.P(IDX_AX + k, IDX_AX + k) += params_.Q_acc_diag[k]  * dt;
+        s_.P(IDX_R1 + k, IDX_R1 + k) += params_.Q_geom_diag[k] * dt;
+    }
+    s_.P(IDX_YAW, IDX_YAW)     += params_.Q_yaw      * dt;
+    s_.P(IDX_OMEGA, IDX_OMEGA) += params_.Q_vel_diag[3] * dt;
+    s_.P(IDX_ALPHA, IDX_ALPHA) += params_.Q_yawalpha * dt;
+}
+
+// H selects state entries (linear); only the yaw innovation needs wrapping.
+void EKFTracker::update(const float *z, float dt) {
+    float y_rate = 0.0f, R_rate = kNoObsVar;
+    const bool have_rate = rbpf_yaw_rate_obs(z[IDX_YAW], s_.z_yaw_prev, dt,
+                                             params_.Rz_yaw, y_rate, R_rate);
+    s_.z_yaw_prev = z[IDX_YAW];
+    if (!have_rate) { y_rate = s_.x(IDX_OMEGA); R_rate = kNoObsVar; }
+
+    MeasVec y;
+    MeasMat R = MeasMat::Zero();
+    for (int k = 0; k < 3; ++k) {
+        y(k)           = z[IDX_TX + k] - s_.x(IDX_TX + k);
+        R(k, k)        = params_.Rz_pos_diag[k];
+        y(5 + k)       = z[IDX_R1 + k] - s_.x(IDX_R1 + k);
+        R(5 + k, 5 + k) = params_.Rc_geom_diag[k];
+    }
+    y(3)    = wrap_to_pi(z[IDX_YAW] - s_.x(IDX_YAW));
+    R(3, 3) = params_.Rz_yaw;
+    y(4)    = y_rate - s_.x(IDX_OMEGA);
+    R(4, 4) = R_rate;
+
+    // S = H P H^T + R and P H^T are row/column picks of P
+    GainMat PHt;
+    MeasMat S;
+    for (int j = 0; j < EKF_Z; ++j) {
+        PHt.col(j) = s_.P.col(kMeasIdx[j]);
+        for (int i = 0; i < EKF_Z; ++i) S(i, j) = s_.P(kMeasIdx[i], kMeasIdx[j]);
+    }
+    S += R;
+
+    const Eigen::LLT<MeasMat> llt(S);
+    const GainMat K = llt.solve(PHt.transpose()).transpose();
+
+    s_.x += K * y;
+    s_.x(IDX_YAW) = wrap_to_pi(s_.x(IDX_YAW));
+
+    // Joseph form: P = (I - KH) P (I - KH)^T + K R K^T
+    StateMat IKH = StateMat::Identity();
+    for (int j = 0; j < EKF_Z; ++j) IKH.col(kMeasIdx[j]) -= K.col(j);
+    s_.P = (IKH * s_.P * IKH.transpose() + K * R * K.transpose()).eval();
+}
+
+void EKFTracker::step(const float *z, float dt) {
+    predict(dt);
+    update(z, dt);
+}
+
+bool EKFTracker::poll_estimate(PosteriorSummary &out) {
+    for (int k = 0; k < D; ++k) {
+        out.mean[k] = s_.x(k);
+        out.var[k]  = s_.P(k, k);
+    }
+    out.ess           = 0.0f;
+    out.weight_sum    = 0.0f;
+    out.num_particles = 0;
+    return true;
+}
+
+void EKFTracker::checkpoint_save(int slot)    { slots_[slot] = s_; }
+void EKFTracker::checkpoint_restore(int slot) { s_ = slots_[slot]; }
@@ -0,0 +1,57 @@
+// ekf.hpp
+#pragma once
+
+#include <vector>
+#include <Eigen/Core>
+#include "tracker.hpp"
+
+// Extended Kalman filter over the same 15-dim state, process model
+// (constant acceleration for pos and yaw, random-walk geometry) and
+// measurement model (pos, wrapped yaw, yaw-rate from finite-differenced yaw,
+// direct [r1, r2, h]) as the RBPF. Noise levels come from the same
+// RBPFParams. A fraction of the RBPF's cost for targets that move
+// predictably.
+//
+// Fixed-size Eigen throughout: step() does not allocate.
+
+constexpr int EKF_Z = 8;   // [x, y, z, yaw, yaw_rate, r1, r2, h]
+
+struct EKFState {
+    Eigen::Matrix<float, D, 1> x;
+    Eigen::Matrix<float, D, D> P;
+    float z_yaw_prev;
+};
+
+class EKFTracker final : public Tracker {
+public:
+    using StateVec = Eigen::Matrix<float, D, 1>;
+    using StateMat = Eigen::Matrix<float, D, D>;
+    using MeasVec  = Eigen::Matrix<float, EKF_Z, 1>;
+    using MeasMat  = Eigen::Matrix<float, EKF_Z, EKF_Z>;
+    using GainMat  = Eigen::Matrix<float, D, EKF_Z>;
+
+    explicit EKFTracker(int num_slots, const RBPFParams &p = default_params());
+
+    const char *name() const override { return "ekf"; }
+
+    void reset(const float *z) override;
+    void predict(float dt);
+    void step(const float *z, float dt) override;
+
+    void request_estimate() override {}
+    bool poll_estimate(PosteriorSummary &out) override;
+
+    RBPFTelemetry telemetry() override { return RBPFTelemetry{}; }
+
+    void checkpoint_save(int slot) override;
+    void checkpoint_restore(int slot) override;
+
+    const EKFState &state() const { return s_; }
+
+private:
+    RBPFParams            params_;
+    EKFState              s_;
+    std::vector<EKFState> slots_;
+
+    void update(const float *z, float dt);
+};
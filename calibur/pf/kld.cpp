@@ -0,0 +1,15 @@
+// kld.cpp
+#include <algorithm>
+#include "kld.hpp"
+
+int cpu_kld_count_bins(const float *X, int N, const KLDParams &p,
+                       uint64_t *table, int table_size)
+{
+    std::fill(table, table + table_size, KLD_EMPTY_KEY);
+
+    int count = 0;
+    for (int i = 0; i < N; ++i) {
+        if (kld_table_insert(table, table_size, kld_bin_key(&X[i * D], p))) ++count;
+    }
+    return count;
+}
@@ -0,0 +1,47 @@
+// kld.cu
+#include <cuda_runtime.h>
+#include "kld.cuh"
+
+// one thread per particle: insert its bin key, count first insertions
+__global__ void kld_insert_kernel(const float *X, int N, KLDParams p,
+                                  unsigned long long *table, int table_size,
+                                  int *count)
+{
+    int i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= N) return;
+
+    const unsigned long long key  = kld_bin_key(&X[i * D], p);
+    const unsigned int       mask = unsigned(table_size - 1);
+    unsigned int h = kld_hash(key) & mask;
+
+    for (int probe = 0; probe < table_size; ++probe) {
+        const unsigned long long prev = atomicCAS(&table[h], KLD_EMPTY_KEY, key);
+        if (prev == KLD_EMPTY_KEY) { atomicAdd(count, 1); return; }
+        if (prev == key) return;
+        h = (h + 1) & mask;
+    }
+}
+
+void kld_workspace_alloc(KLDWorkspace &ws, int max_particles) {
+    ws.table_size = kld_table_size(max_particles);
+    cudaMalloc(&ws.table, size_t(ws.table_size) * sizeof(unsigned long long));
+    cudaMalloc(&ws.count, sizeof(int));
+}
+
+void kld_workspace_free(KLDWorkspace &ws) {
+    cudaFree(ws.table);
+    cudaFree(ws.count);
+    ws = KLDWorkspace{};
+}
+
+void gpu_kld_count_bins(const float *d_X, int N, const KLDParams &p,
+                        KLDWorkspace &ws, cudaStream_t stream)
+{
+    cudaMemsetAsync(ws.table, 0, size_t(ws.table_size) * sizeof(unsigned long long), stream);
+    cudaMemsetAsync(ws.count, 0, sizeof(int), stream);
+    if (N <= 0) return;
+
+    const int block = 256;
+    const int grid  = (N + block - 1) / block;
+    kld_insert_kernel<<<grid, block, 0, stream>>>(d_X, N, p, ws.table, ws.table_size, ws.count);
+}
@@ -0,0 +1,19 @@
+// kld.cuh
+#pragma once
+
+#include <cuda_runtime.h>
+#include "kld.hpp"
+
+// Device hash set for counting occupied KLD bins (allocated once per filter).
+struct KLDWorkspace {
+    int                 table_size = 0;
+    unsigned long long *table      = nullptr;  // [table_size]
+    int                *count      = nullptr;  // [1] occupied bins
+};
+
+void kld_workspace_alloc(KLDWorkspace &ws, int max_particles);
+void kld_workspace_free(KLDWorkspace &ws);
+
+// Occupied bins of X[N * D] -> *ws.count (device), no host sync.
+void gpu_kld_count_bins(const float *d_X, int N, const KLDParams &p,
+                        KLDWorkspace &ws, cudaStream_t stream);
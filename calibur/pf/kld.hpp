@@ -0,0 +1,107 @@
+// kld.hpp
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "rbpf_params.hpp"
+
+// KLD-sampling (Fox 2003) for the RBPF particle count.
+//
+// After resampling, particles are dropped into a grid over position, yaw and
+// the per-particle KF velocity (geometry is shared by all particles and would
+// only add noise to the count). With k occupied bins, the number of particles needed so that
+// the KL divergence between the sample-based and the true posterior stays
+// below epsilon with probability 1 - delta is
+//
+//   n(k) = (k - 1) / (2 eps) * (1 - 2 / (9 (k - 1)) + sqrt(2 / (9 (k - 1))) z)^3
+//
+// The filter uses n(k), clamped to [min_particles, max_particles], as the
+// output size of its next resample.
+
+#ifndef PF_HD
+#ifdef __CUDACC__
+#define PF_HD __host__ __device__
+#else
+#define PF_HD
+#endif
+#endif
+
+struct KLDParams {
+    int   min_particles = 500;
+    int   max_particles = 10000;
+    float epsilon       = 0.05f;   // KL bound
+    float z_quantile    = 2.326f;  // upper (1 - delta) quantile of N(0,1), delta = 0.01
+    float bin_pos       = 0.02f;   // [m]   grid size of x, y, z
+    float bin_yaw       = 0.05f;   // [rad] grid size of yaw
+    float bin_vel       = 0.10f;   // [m/s] grid size of vx, vy, vz
+};
+
+constexpr uint64_t KLD_EMPTY_KEY = 0ULL;
+
+// Quantized (x, y, z, yaw, vx, vy, vz) packed as 7 x 9 bit. Each field wraps
+// every 512 bins, which only merges particles that are 512 bins apart on that
+// axis (10 m at the default position grid) -- never the case for one target.
+// Bit 63 is always set so a key is never KLD_EMPTY_KEY.
+PF_HD inline uint64_t kld_bin_key(const float *Xi, const KLDParams &p) {
+    const float inv_pos = 1.0f / p.bin_pos;
+    const float inv_yaw = 1.0f / p.bin_yaw;
+    const float inv_vel = 1.0f / p.bin_vel;
+    const float v[7] = {
+        Xi[IDX_TX] * inv_pos, Xi[IDX_TY] * inv_pos, Xi[IDX_TZ] * inv_pos,
+        Xi[IDX_YAW] * inv_yaw,
+        // velocity bins are centred on 0 so a stationary target does not
+        // straddle a bin edge on every axis
+        Xi[IDX_VX] * inv_vel + 0.5f, Xi[IDX_VY] * inv_vel + 0.5f, Xi[IDX_VZ] * inv_vel + 0.5f,
+    };
+    uint64_t key = 1ULL << 63;
+    for (int k = 0; k < 7; ++k) {
+        const uint64_t q = static_cast<uint64_t>(static_cast<int64_t>(floorf(v[k]))) & 0x1FFULL;
+        key |= q << (9 * k);
+    }
+    return key;
+}
+
+PF_HD inline uint32_t kld_hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDULL;
+    key ^= key >> 33;
+    return static_cast<uint32_t>(key);
+}
+
+// Host table insert (linear probing). Returns true if key was new.
+inline bool kld_table_insert(uint64_t *table, int table_size, uint64_t key) {
+    const uint32_t mask = uint32_t(table_size - 1);
+    uint32_t h = kld_hash(key) & mask;
+    for (int probe = 0; probe < table_size; ++probe) {
+        if (table[h] == KLD_EMPTY_KEY) { table[h] = key; return true; }
+        if (table[h] == key) return false;
+        h = (h + 1) & mask;
+    }
+    return false;
+}
+
+// Open-addressing table size for up to max_particles distinct keys (load <= 0.5)
+inline int kld_table_size(int max_particles) {
+    int s = 1024;
+    while (s < 2 * max_particles) s <<= 1;
+    return s;
+}
+
+// n(k) clamped to [min_particles, max_particles]
+inline int kld_required_particles(int k, const KLDParams &p) {
+    int n = p.min_particles;
+    if (k > 1) {
+        const double km1 = double(k - 1);
+        const double a   = 2.0 / (9.0 * km1);
+        const double t   = 1.0 - a + std::sqrt(a) * double(p.z_quantile);
+        n = static_cast<int>(std::ceil(km1 / (2.0 * double(p.epsilon)) * t * t * t));
+    }
+    if (n < p.min_particles) n = p.min_particles;
+    if (n > p.max_particles) n = p.max_particles;
+    return n;
+}
+
+// Number of occupied bins among N particles (X is [N * D]). `table` is caller
+// scratch of kld_table_size(N) entries, cleared here.
+int cpu_kld_count_bins(const float *X, int N, const KLDParams &p,
+                       uint64_t *table, int table_size);
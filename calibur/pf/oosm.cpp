@@ -0,0 +1,38 @@
+// oosm.cpp
+#include <algorithm>
+#include <cstring>
+#include "oosm.hpp"
+
+int oosm_num_checkpoints(size_t budget_bytes, int n_particles) {
+    const size_t per = oosm_checkpoint_bytes(std::max(n_particles, 1));
+    const size_t k   = budget_bytes / per;
+    return int(std::min<size_t>(std::max<size_t>(k, 2), OOSM_MAX_CHECKPOINTS));
+}
+
+OOSMHistory::OOSMHistory(int capacity)
+    : capacity_(std::min(std::max(capacity, 2), OOSM_MAX_CHECKPOINTS))
+{
+}
+
+int OOSMHistory::position(double t) const {
+    int k = size_;
+    while (k > 0 && entries_[k - 1].t > t) --k;
+    return (size_ > 0 && k == 0) ? -1 : k;
+}
+
+int OOSMHistory::insert(int k, double t, const float *z) {
+    int slot = size_;                      // slots 0..size_-1 are in use
+    if (size_ == capacity_) {
+        slot = entries_[0].slot;           // evict the oldest
+        std::memmove(&entries_[0], &entries_[1], size_t(size_ - 1) * sizeof(OOSMEntry));
+        --size_;
+        k = std::max(k - 1, 0);
+    }
+
+    std::memmove(&entries_[k + 1], &entries_[k], size_t(size_ - k) * sizeof(OOSMEntry));
+    entries_[k].t    = t;
+    entries_[k].slot = slot;
+    std::memcpy(entries_[k].z, z, D * sizeof(float));
+    ++size_;
+    return k;
+}
@@ -0,0 +1,104 @@
+// oosm.hpp
+#pragma once
+
+#include <cstddef>
+#include "rbpf_params.hpp"
+
+// Out-of-sequence measurement handling for the RBPF.
+//
+// The filter keeps a checkpoint of the full particle set after every fused
+// measurement, for the last K measurements. When a detection arrives whose
+// capture time is older than the filter time, the filter is rolled back to the
+// newest checkpoint before it, the late measurement is fused at its own time,
+// and the later measurements are replayed (re-checkpointing each one).
+//
+// Checkpoint storage belongs to the backend (rbpf_cpu.hpp / rbpf.cuh) and is
+// allocated once: K is derived from a byte budget and the particle capacity.
+// The history below only tracks times, measurements and slot indices.
+
+constexpr int OOSM_MAX_CHECKPOINTS = 64;
+
+// Bytes of one checkpoint slot of `n_particles` (particle SoA + weights).
+constexpr size_t oosm_checkpoint_bytes(int n_particles) {
+    return size_t(n_particles) * (D + KF_D + 4 + 3 + 3 + 1 + 1) * sizeof(float);
+}
+
+// Number of slots that fit into `budget_bytes`, clamped to [2, OOSM_MAX_CHECKPOINTS].
+int oosm_num_checkpoints(size_t budget_bytes, int n_particles);
+
+struct OOSMEntry {
+    double t;      // capture time [s]
+    float  z[D];   // measurement, laid out like the state
+    int    slot;   // checkpoint slot holding the state right after fusing z
+};
+
+// Time-ordered list of the last K fused measurements (oldest first).
+class OOSMHistory {
+public:
+    explicit OOSMHistory(int capacity);
+
+    int  capacity() const { return capacity_; }
+    int  size()     const { return size_; }
+    bool empty()    const { return size_ == 0; }
+    void clear()          { size_ = 0; }
+
+    const OOSMEntry &at(int k) const { return entries_[k]; }
+    double newest_time() const { return entries_[size_ - 1].t; }
+    double oldest_time() const { return entries_[0].t; }
+
+    // Index a measurement at time t would take (after every entry with time
+    // <= t), or -1 when it is not newer than the oldest entry, i.e. there is
+    // no checkpoint to roll back to.
+    int position(double t) const;
+
+    // Insert at position(t) == k. When full, the oldest entry is evicted and
+    // its slot reused, so the new entry ends up at k - 1. Returns its index.
+    int insert(int k, double t, const float *z);
+
+private:
+    int       capacity_;
+    int       size_ = 0;
+    OOSMEntry entries_[OOSM_MAX_CHECKPOINTS];
+};
+
+// Backend interface used by oosm_fuse():
+//   void checkpoint_save(int slot);
+//   void checkpoint_restore(int slot);
+//   void step(const float *z, float dt);
+
+// Start a new track at time t from measurement z (caller has reset the filter).
+template <class Backend>
+void oosm_start(OOSMHistory &h, Backend &b, double t, const float *z) {
+    h.clear();
+    const int k = h.insert(0, t, z);
+    b.checkpoint_save(h.at(k).slot);
+}
+
+// Fuse z captured at time t, in or out of order. Returns the number of filter
+// steps run (1 in order, more when later measurements were replayed), or -1
+// when the measurement is older than the whole history and was dropped.
+template <class Backend>
+int oosm_fuse(OOSMHistory &h, Backend &b, double t, const float *z, float min_dt) {
+    if (h.empty()) return -1;
+
+    int k = h.position(t);
+    if (k < 0) return -1;
+
+    // roll back to the checkpoint right before the new entry (before insert,
+    // which may evict and reuse that very slot)
+    double t_prev = h.at(k - 1).t;
+    if (k < h.size()) b.checkpoint_restore(h.at(k - 1).slot);
+
+    k = h.insert(k, t, z);
+
+    int steps = 0;
+    for (int j = k; j < h.size(); ++j) {
+        const OOSMEntry &e = h.at(j);
+        const float dt = float(e.t - t_prev);
+        b.step(e.z, dt > min_dt ? dt : min_dt);
+        b.checkpoint_save(e.slot);
+        t_prev = e.t;
+        ++steps;
+    }
+    return steps;
+}
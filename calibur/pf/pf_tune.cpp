@@ -0,0 +1,151 @@
+// pf_tune.cpp
+//
+// Offline RBPF parameter search over recorded detection logs (detection_log.hpp,
+// written by PFWorker when PF_RECORD_DETECTIONS is set). Replays every trial
+// on the CPU filter, one trial per core, and writes the best parameter set as
+// YAML that PFWorker loads at startup (PF_PARAMS_YAML).
+//
+//   pf_tune [options] log.csv [log.csv ...]
+//     --trials N          trials in total (200)
+//     --method tpe|random search strategy (tpe)
+//     --threads N         worker threads (all cores)
+//     --batch N           trials per search round (one per thread); fix it to
+//                         reproduce a run with another thread count
+//     --particles N       filter size per trial (1000)
+//     --horizon S         look-ahead scored for hits, seconds (0.15)
+//     --hit-radius M      hit tolerance, metres (0.065)
+//     --rmse-weight W     loss weight of the one-step RMSE per metre (1.0)
+//     --seed N            search seed (1)
+//     --base FILE         start from this YAML instead of the defaults
+//     --out FILE          output YAML (config/pf_params.yaml)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tune.hpp"
+#include "rbpf_params_yaml.hpp"
+
+static void usage(const char *argv0) {
+    std::cerr << "usage: " << argv0 << " [--trials N] [--method tpe|random] [--threads N]"
+              << " [--batch N] [--particles N] [--horizon S] [--hit-radius M] [--rmse-weight W]"
+              << " [--seed N] [--base FILE] [--out FILE] log.csv [log.csv ...]\n";
+}
+
+static void print_trial(const char *tag, int i, const TuneScore &s) {
+    std::printf("%s #%-4d loss %.4f  hit %5.1f%%  track %.4f m  pred %.4f m\n",
+                tag, i, s.loss, 100.0 * s.hit_rate, s.track_rmse, s.pred_rmse);
+}
+
+int main(int argc, char **argv) {
+    TuneSearch  search;
+    TuneOptions opt;
+    std::string out_path = "config/pf_params.yaml";
+    std::string base_path;
+    std::vector<std::string> log_paths;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (i + 1 >= argc) { usage(argv[0]); std::exit(2); }
+            return argv[++i];
+        };
+        if      (a == "--trials")      search.trials     = std::atoi(next());
+        else if (a == "--threads")     search.threads    = std::atoi(next());
+        else if (a == "--batch")       search.batch      = std::atoi(next());
+        else if (a == "--seed")        search.seed       = std::strtoull(next(), nullptr, 10);
+        else if (a == "--particles")   opt.num_particles = std::atoi(next());
+        else if (a == "--horizon")     opt.horizon       = std::atof(next());
+        else if (a == "--hit-radius")  opt.hit_radius    = std::atof(next());
+        else if (a == "--rmse-weight") opt.rmse_weight   = std::atof(next());
+        else if (a == "--base")        base_path         = next();
+        else if (a == "--out")         out_path          = next();
+        else if (a == "--method") {
+            const std::string m = next();
+            if      (m == "tpe")    search.method = TuneMethod::TPE;
+            else if (m == "random") search.method = TuneMethod::RANDOM;
+            else { usage(argv[0]); return 2; }
+        }
+        else if (a == "-h" || a == "--help") { usage(argv[0]); return 0; }
+        else if (!a.empty() && a[0] == '-')  { usage(argv[0]); return 2; }
+        else log_paths.push_back(a);
+    }
+    if (log_paths.empty() || search.trials < 1) { usage(argv[0]); return 2; }
+
+    std::vector<DetectionLog> logs;
+    size_t n_det = 0;
+    for (const std::string &p : log_paths) {
+        DetectionLog log;
+        if (!detection_log_read(p, log)) {
+            std::cerr << "[TUNE] cannot read " << p << std::endl;
+            return 1;
+        }
+        n_det += log.size();
+        logs.push_back(std::move(log));
+    }
+
+    RBPFParams base = default_params();
+    if (!base_path.empty() && !rbpf_params_load(base_path, base)) {
+        std::cerr << "[TUNE] cannot load " << base_path << std::endl;
+        return 1;
+    }
+
+    const int threads = search.threads > 0 ? search.threads
+                                           : int(std::max(1u, std::thread::hardware_concurrency()));
+    std::cout << "[TUNE] " << logs.size() << " logs, " << n_det << " detections, "
+              << search.trials << " trials ("
+              << (search.method == TuneMethod::TPE ? "tpe" : "random") << "), "
+              << threads << " threads, batch " << (search.batch > 0 ? search.batch : threads)
+              << ", " << opt.num_particles << " particles" << std::endl;
+
+    double best_loss = INFINITY;
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<TuneTrial> trials = tune_run(logs, base, search, opt,
+        [&](int i, const TuneTrial &t) {
+            if (i == 0) print_trial("[TUNE] base ", i, t.score);
+            else if (t.score.loss < best_loss) print_trial("[TUNE] best ", i, t.score);
+            best_loss = std::min(best_loss, t.score.loss);
+        });
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    const double replayed = trials.front().score.log_seconds * trials.size();
+    std::printf("[TUNE] %zu trials in %.1f s, %.0fx real time\n",
+                trials.size(), wall, replayed / std::max(wall, 1e-9));
+
+    std::vector<int> order(trials.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = int(i);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return trials[a].score.loss < trials[b].score.loss;
+    });
+    for (int k = 0; k < std::min<int>(5, int(order.size())); ++k)
+        print_trial("[TUNE] top  ", order[k], trials[order[k]].score);
+
+    const TuneTrial &best = trials[order.front()];
+    const TuneScore &b0   = trials.front().score;
+
+    std::ostringstream hdr;
+    hdr << "RBPF parameters from pf_tune, " << trials.size() << " trials\n";
+    char line[160];
+    std::snprintf(line, sizeof(line), "loss %.4f  hit %.1f%%  track %.4f m  (base: loss %.4f  hit %.1f%%  track %.4f m)\n",
+                  best.score.loss, 100.0 * best.score.hit_rate, best.score.track_rmse,
+                  b0.loss, 100.0 * b0.hit_rate, b0.track_rmse);
+    hdr << line;
+    std::snprintf(line, sizeof(line), "horizon %.3f s  hit radius %.3f m  particles %d\n",
+                  opt.horizon, opt.hit_radius, opt.num_particles);
+    hdr << line;
+    for (const std::string &p : log_paths) hdr << "log: " << p << "\n";
+
+    if (!rbpf_params_save(out_path, best.params, hdr.str())) {
+        std::cerr << "[TUNE] cannot write " << out_path << std::endl;
+        return 1;
+    }
+    std::cout << "[TUNE] wrote " << out_path << std::endl;
+    return 0;
+}
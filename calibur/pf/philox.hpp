@@ -0,0 +1,229 @@
+// philox.hpp
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+// Counter-based RNG for particle noise: Philox4x32-10 (Salmon et al., SC'11).
+//
+// A draw is a pure function of (seed, stream, particle, step, block), so no
+// per-particle generator state is stored or loaded, any particle can be
+// regenerated independently, and a replayed log reproduces the same noise.
+// Each call yields 4 uint32 -> 4 standard normals (Box-Muller).
+//
+// Host and device run the same integer rounds, and the float transform below
+// uses only +, *, sqrtf and explicit fmaf (no libm log/sin/cos), so CPU and
+// GPU produce bit-identical normals. Do not build this with fast-math.
+
+#ifndef PF_HD
+#ifdef __CUDACC__
+#define PF_HD __host__ __device__
+#else
+#define PF_HD
+#endif
+#endif
+
+// counter word 3: which consumer the draw belongs to
+enum PhiloxStream : uint32_t {
+    PHILOX_PREDICT = 0,
+    PHILOX_ATTACH  = 1
+};
+
+constexpr uint32_t PHILOX_M0 = 0xD2511F53u;
+constexpr uint32_t PHILOX_M1 = 0xCD9E8D57u;
+constexpr uint32_t PHILOX_W0 = 0x9E3779B9u;
+constexpr uint32_t PHILOX_W1 = 0xBB67AE85u;
+
+PF_HD inline uint32_t philox_mulhilo(uint32_t a, uint32_t b, uint32_t &hi) {
+    const uint64_t p = uint64_t(a) * uint64_t(b);
+    hi = uint32_t(p >> 32);
+    return uint32_t(p);
+}
+
+// 10 rounds in place on ctr[4] with key (k0, k1)
+PF_HD inline void philox4x32_10(uint32_t *ctr, uint32_t k0, uint32_t k1) {
+    for (int r = 0; r < 10; ++r) {
+        uint32_t hi0, hi1;
+        const uint32_t lo0 = philox_mulhilo(PHILOX_M0, ctr[0], hi0);
+        const uint32_t lo1 = philox_mulhilo(PHILOX_M1, ctr[2], hi1);
+        const uint32_t c0 = hi1 ^ ctr[1] ^ k0;
+        const uint32_t c2 = hi0 ^ ctr[3] ^ k1;
+        ctr[0] = c0;
+        ctr[1] = lo1;
+        ctr[2] = c2;
+        ctr[3] = lo0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+}
+
+// ======================= FLOAT TRANSFORM ==============
+
+PF_HD inline uint32_t philox_float_bits(float f) {
+#ifdef __CUDA_ARCH__
+    return __float_as_uint(f);
+#else
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+#endif
+}
+
+PF_HD inline float philox_bits_float(uint32_t u) {
+#ifdef __CUDA_ARCH__
+    return __uint_as_float(u);
+#else
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+#endif
+}
+
+// uniform in (0, 1], exactly representable (24 bits)
+PF_HD inline float philox_u01(uint32_t x) {
+    return float((x >> 8) + 1u) * (1.0f / 16777216.0f);
+}
+
+// ln(u) for u in (0, 1]: exponent split + minimax polynomial on
+// [sqrt(1/2), sqrt(2)) (Cephes logf), abs error < 2e-7. Branch-free.
+PF_HD inline float philox_log(float u) {
+    const uint32_t b  = philox_float_bits(u);
+    const float    m0 = philox_bits_float((b & 0x007FFFFFu) | 0x3F000000u);  // [0.5, 1)
+    const bool     lo = m0 < 0.70710678f;
+    const float    m  = lo ? m0 + m0 : m0;
+    const int      e  = int(b >> 23) - (lo ? 127 : 126);
+    const float    x  = m - 1.0f;                                         // exact
+    const float    x2 = x * x;
+
+    float p = 7.0376836292e-2f;
+    p = fmaf(p, x, -1.1514610310e-1f);
+    p = fmaf(p, x,  1.1676998740e-1f);
+    p = fmaf(p, x, -1.2420140846e-1f);
+    p = fmaf(p, x,  1.4249322787e-1f);
+    p = fmaf(p, x, -1.6668057665e-1f);
+    p = fmaf(p, x,  2.0000714765e-1f);
+    p = fmaf(p, x, -2.4999993993e-1f);
+    p = fmaf(p, x,  3.3333331174e-1f);
+
+    float y = (x2 * x) * p;
+    y = fmaf(-0.5f, x2, y);
+    const float fe = float(e);
+    y = fmaf(fe, -2.12194440e-4f, y);
+    return fmaf(fe, 0.693359375f, x + y);
+}
+
+// sin / cos of 2*pi*t, t = int32(x) / 2^32 in [-0.5, 0.5). The quadrant split
+// is done on the integer so the reduced argument is exact; Cephes polynomials
+// on [-pi/4, pi/4]. Branch-free.
+PF_HD inline void philox_sincos_2pi(uint32_t x, float &s, float &c) {
+    const int32_t t  = int32_t(x) >> 8;                   // [-2^23, 2^23)
+    const int32_t q  = (t + (1 << 21)) >> 22;             // nearest quadrant, -2..2
+    const float   f  = float(t - q * (1 << 22)) * (1.0f / 16777216.0f);   // [-1/8, 1/8)
+    const float   a  = 6.28318530718f * f;
+    const float   a2 = a * a;
+
+    float ps = -1.9515295891e-4f;
+    ps = fmaf(ps, a2,  8.3321608736e-3f);
+    ps = fmaf(ps, a2, -1.6666654611e-1f);
+    const float sa = fmaf(ps * a2, a, a);
+
+    float pc = 2.443315711809948e-5f;
+    pc = fmaf(pc, a2, -1.388731625493765e-3f);
+    pc = fmaf(pc, a2,  4.166664568298827e-2f);
+    const float ca = fmaf(pc * a2, a2, fmaf(-0.5f, a2, 1.0f));
+
+    const int   qi = q & 3;
+    const float s0 = (qi & 1) ? ca : sa;
+    const float c0 = (qi & 1) ? sa : ca;
+    s = (qi & 2) ? -s0 : s0;
+    c = (qi == 1 || qi == 2) ? -c0 : c0;
+}
+
+// Box-Muller on two raw words -> two normals
+PF_HD inline void philox_box_muller(uint32_t x0, uint32_t x1, float &n0, float &n1) {
+    const float r = sqrtf(-2.0f * philox_log(philox_u01(x0)));
+    float s, c;
+    philox_sincos_2pi(x1, s, c);
+    n0 = r * c;
+    n1 = r * s;
+}
+
+// ======================= NORMALS ======================
+
+// Four standard normals for (seed, stream, particle, step, block).
+PF_HD inline void philox_normal4(uint64_t seed, uint32_t stream, uint32_t particle,
+                                 uint32_t step, uint32_t block, float *out) {
+    uint32_t ctr[4] = { particle, step, block, stream };
+    philox4x32_10(ctr, uint32_t(seed), uint32_t(seed >> 32));
+
+    philox_box_muller(ctr[0], ctr[1], out[0], out[1]);
+    philox_box_muller(ctr[2], ctr[3], out[2], out[3]);
+}
+
+// n standard normals for one particle/step, ceil(n / 4) Philox calls.
+PF_HD inline void philox_normals(uint64_t seed, uint32_t stream, uint32_t particle,
+                                 uint32_t step, float *out, int n) {
+    float buf[4];
+    for (int b = 0; 4 * b < n; ++b) {
+        philox_normal4(seed, stream, particle, step, uint32_t(b), buf);
+        for (int k = 0; k < 4 && 4 * b + k < n; ++k) out[4 * b + k] = buf[k];
+    }
+}
+
+// ======================= HOST BATCH ===================
+
+constexpr int PHILOX_LANES = 8;
+
+// per-particle stride of philox_normals_batch output: n rounded up to 4
+constexpr int philox_batch_stride(int n) { return (n + 3) & ~3; }
+
+// CPU path: the same draws as philox_normals() for particles 0..N-1, written
+// to out[i * philox_batch_stride(n) + k]. Particles are processed in lanes of
+// PHILOX_LANES with fixed-trip inner loops so the compiler can keep the
+// rounds and the transform in SIMD registers (needs -fno-math-errno for
+// sqrtf, and FMA hardware, e.g. -mfma / -march=native, to vectorize fmaf).
+inline void philox_normals_batch(uint64_t seed, uint32_t stream, uint32_t step,
+                                 int N, int n, float *out) {
+    const int      stride = philox_batch_stride(n);
+    const uint32_t k0 = uint32_t(seed), k1 = uint32_t(seed >> 32);
+
+    for (int i0 = 0; i0 < N; i0 += PHILOX_LANES) {
+        const int lanes = (N - i0 < PHILOX_LANES) ? N - i0 : PHILOX_LANES;
+        for (int b = 0; 4 * b < n; ++b) {
+            uint32_t c0[PHILOX_LANES], c1[PHILOX_LANES], c2[PHILOX_LANES], c3[PHILOX_LANES];
+            for (int l = 0; l < PHILOX_LANES; ++l) {
+                c0[l] = uint32_t(i0 + l);
+                c1[l] = step;
+                c2[l] = uint32_t(b);
+                c3[l] = stream;
+            }
+            uint32_t r0 = k0, r1 = k1;
+            for (int r = 0; r < 10; ++r) {
+                for (int l = 0; l < PHILOX_LANES; ++l) {
+                    uint32_t hi0, hi1;
+                    const uint32_t lo0 = philox_mulhilo(PHILOX_M0, c0[l], hi0);
+                    const uint32_t lo1 = philox_mulhilo(PHILOX_M1, c2[l], hi1);
+                    const uint32_t n0 = hi1 ^ c1[l] ^ r0;
+                    const uint32_t n2 = hi0 ^ c3[l] ^ r1;
+                    c0[l] = n0;
+                    c1[l] = lo1;
+                    c2[l] = n2;
+                    c3[l] = lo0;
+                }
+                r0 += PHILOX_W0;
+                r1 += PHILOX_W1;
+            }
+
+            float g[4][PHILOX_LANES];
+            for (int l = 0; l < PHILOX_LANES; ++l) {
+                philox_box_muller(c0[l], c1[l], g[0][l], g[1][l]);
+                philox_box_muller(c2[l], c3[l], g[2][l], g[3][l]);
+            }
+            for (int l = 0; l < lanes; ++l) {
+                float *o = out + size_t(i0 + l) * stride + 4 * b;
+                for (int k = 0; k < 4; ++k) o[k] = g[k][l];
+            }
+        }
+    }
+}
@@ -0,0 +1,24 @@
+// posterior.cpp
+#include "posterior.hpp"
+
+void cpu_posterior_summary(const float *X, const float *W, int N, PosteriorSummary &out)
+{
+    PosteriorAccum acc;
+    posterior_accum_zero(acc);
+    if (N <= 0) {
+        posterior_finalize(acc, X, 0, out);
+        return;
+    }
+
+    // per-lane partials, merged at the end like the GPU block reduction
+    constexpr int LANES = 8;
+    PosteriorAccum lane[LANES];
+    for (auto &l : lane) posterior_accum_zero(l);
+
+    for (int i = 0; i < N; ++i) {
+        posterior_accum_add(lane[i % LANES], &X[i * D], X, W ? W[i] : 1.0f);
+    }
+    for (const auto &l : lane) posterior_accum_merge(acc, l);
+
+    posterior_finalize(acc, X, N, out);
+}
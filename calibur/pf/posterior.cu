@@ -0,0 +1,106 @@
+// posterior.cu
+#include <cuda_runtime.h>
+#include "posterior.cuh"
+
+__device__ inline void warp_reduce_accum(PosteriorAccum &a) {
+    #pragma unroll
+    for (int off = 16; off > 0; off >>= 1) {
+        a.sw  += __shfl_down_sync(0xffffffffu, a.sw,  off);
+        a.sw2 += __shfl_down_sync(0xffffffffu, a.sw2, off);
+        #pragma unroll
+        for (int k = 0; k < D; ++k) {
+            a.s1[k] += __shfl_down_sync(0xffffffffu, a.s1[k], off);
+            a.s2[k] += __shfl_down_sync(0xffffffffu, a.s2[k], off);
+        }
+    }
+}
+
+// Block-wide reduction, result valid in thread 0.
+__device__ inline void block_reduce_accum(PosteriorAccum &a, PosteriorAccum *s_warp) {
+    const int lane = threadIdx.x & 31;
+    const int warp = threadIdx.x >> 5;
+    const int nwarps = (blockDim.x + 31) >> 5;
+
+    warp_reduce_accum(a);
+    if (lane == 0) s_warp[warp] = a;
+    __syncthreads();
+
+    if (warp == 0) {
+        if (lane < nwarps) a = s_warp[lane];
+        else               posterior_accum_zero(a);
+        warp_reduce_accum(a);
+    }
+}
+
+// Grid-stride accumulation, one partial per block; the last block to finish
+// merges the partials and writes the summary (no second launch).
+__global__ void posterior_kernel(const float* __restrict__ X,
+                                 const float* __restrict__ W,
+                                 int N,
+                                 PosteriorAccum *partials,
+                                 unsigned int *done,
+                                 PosteriorSummary *out)
+{
+    __shared__ PosteriorAccum s_warp[POSTERIOR_BLOCK_SIZE / 32];
+    __shared__ bool s_last;
+    __shared__ float s_ref[D];
+
+    if (threadIdx.x < D) s_ref[threadIdx.x] = (N > 0) ? X[threadIdx.x] : 0.0f;
+    __syncthreads();
+
+    PosteriorAccum a;
+    posterior_accum_zero(a);
+    for (int i = blockIdx.x * blockDim.x + threadIdx.x; i < N; i += gridDim.x * blockDim.x) {
+        posterior_accum_add(a, &X[i * D], s_ref, W ? W[i] : 1.0f);
+    }
+
+    block_reduce_accum(a, s_warp);
+
+    if (threadIdx.x == 0) {
+        partials[blockIdx.x] = a;
+        __threadfence();
+        const unsigned int ticket = atomicAdd(done, 1u);
+        s_last = (ticket == gridDim.x - 1);
+    }
+    __syncthreads();
+    if (!s_last) return;
+
+    // last block: fold the per-block partials
+    __threadfence();
+    if (threadIdx.x < gridDim.x) {
+        a = partials[threadIdx.x];
+    } else {
+        posterior_accum_zero(a);
+    }
+    block_reduce_accum(a, s_warp);
+
+    if (threadIdx.x == 0) {
+        posterior_finalize(a, s_ref, N, *out);
+        *done = 0;  // ready for the next launch
+    }
+}
+
+void posterior_workspace_alloc(PosteriorWorkspace &ws) {
+    cudaMalloc(&ws.partials, POSTERIOR_MAX_BLOCKS * sizeof(PosteriorAccum));
+    cudaMalloc(&ws.done,     sizeof(unsigned int));
+    cudaMalloc(&ws.summary,  sizeof(PosteriorSummary));
+    cudaMemset(ws.done, 0, sizeof(unsigned int));
+}
+
+void posterior_workspace_free(PosteriorWorkspace &ws) {
+    cudaFree(ws.partials);
+    cudaFree(ws.done);
+    cudaFree(ws.summary);
+    ws = PosteriorWorkspace{};
+}
+
+void gpu_posterior_summary(const float *d_X, const float *d_W, int N,
+                           PosteriorWorkspace &ws, cudaStream_t stream)
+{
+    const int block = POSTERIOR_BLOCK_SIZE;
+    int grid = (N + block - 1) / block;
+    if (grid < 1) grid = 1;
+    if (grid > POSTERIOR_MAX_BLOCKS) grid = POSTERIOR_MAX_BLOCKS;
+
+    posterior_kernel<<<grid, block, 0, stream>>>(d_X, d_W, N, ws.partials, ws.done, ws.summary);
+}
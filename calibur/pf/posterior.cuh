@@ -0,0 +1,23 @@
+// posterior.cuh
+#pragma once
+
+#include <cuda_runtime.h>
+#include "posterior.hpp"
+
+constexpr int POSTERIOR_BLOCK_SIZE = 256;
+constexpr int POSTERIOR_MAX_BLOCKS = 32;
+
+// Per-block partials + completion counter for the single-pass reduction.
+struct PosteriorWorkspace {
+    PosteriorAccum   *partials = nullptr;  // [POSTERIOR_MAX_BLOCKS]
+    unsigned int     *done     = nullptr;  // [1] blocks finished, reset by the last one
+    PosteriorSummary *summary  = nullptr;  // [1] device result block
+};
+
+void posterior_workspace_alloc(PosteriorWorkspace &ws);
+void posterior_workspace_free(PosteriorWorkspace &ws);
+
+// Weighted summary of X[N * D] / W[N] -> *ws.summary (device), no host sync.
+// d_W == nullptr means uniform weights.
+void gpu_posterior_summary(const float *d_X, const float *d_W, int N,
+                           PosteriorWorkspace &ws, cudaStream_t stream);
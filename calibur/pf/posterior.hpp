@@ -0,0 +1,94 @@
+// posterior.hpp
+#pragma once
+
+#include <cmath>
+#include "rbpf_params.hpp"
+
+// Weighted posterior summary of the particle set in one pass:
+//   - weighted mean of every state dim, circular mean for IDX_YAW
+//   - weighted variance per dim (yaw: wrapped-normal -2 ln R)
+//   - ESS = (sum w)^2 / sum w^2 of the weights summarized
+//
+// Linear dims accumulate x - x_ref with x_ref = particle 0, so the float
+// sums stay small for targets metres away and the variance does not cancel.
+// Weights need not be normalized.
+
+#ifndef PF_HD
+#ifdef __CUDACC__
+#define PF_HD __host__ __device__
+#else
+#define PF_HD
+#endif
+#endif
+
+// Result block, read back to the host as one struct.
+struct PosteriorSummary {
+    float mean[D];
+    float var[D];
+    float ess;            // the filters report it before their last resample
+    float weight_sum;
+    int   num_particles;
+};
+
+// Partial sums. For k == IDX_YAW, s1 holds sum w cos(yaw), s2 sum w sin(yaw).
+struct PosteriorAccum {
+    float sw;
+    float sw2;
+    float s1[D];
+    float s2[D];
+};
+
+constexpr int POSTERIOR_ACCUM_FLOATS = 2 + 2 * D;
+
+PF_HD inline void posterior_accum_zero(PosteriorAccum &a) {
+    a.sw = 0.0f;
+    a.sw2 = 0.0f;
+    for (int k = 0; k < D; ++k) { a.s1[k] = 0.0f; a.s2[k] = 0.0f; }
+}
+
+PF_HD inline void posterior_accum_add(PosteriorAccum &a, const float *Xi,
+                                      const float *X_ref, float w) {
+    a.sw  += w;
+    a.sw2 += w * w;
+    for (int k = 0; k < D; ++k) {
+        if (k == IDX_YAW) {
+            a.s1[k] += w * cosf(Xi[k]);
+            a.s2[k] += w * sinf(Xi[k]);
+        } else {
+            const float d = Xi[k] - X_ref[k];
+            a.s1[k] += w * d;
+            a.s2[k] += w * d * d;
+        }
+    }
+}
+
+PF_HD inline void posterior_accum_merge(PosteriorAccum &a, const PosteriorAccum &b) {
+    a.sw  += b.sw;
+    a.sw2 += b.sw2;
+    for (int k = 0; k < D; ++k) { a.s1[k] += b.s1[k]; a.s2[k] += b.s2[k]; }
+}
+
+PF_HD inline void posterior_finalize(const PosteriorAccum &a, const float *X_ref, int N,
+                                     PosteriorSummary &out) {
+    out.num_particles = N;
+    out.weight_sum    = a.sw;
+    out.ess           = (a.sw2 > 0.0f) ? a.sw * a.sw / a.sw2 : 0.0f;
+
+    const float inv = (a.sw > 0.0f) ? 1.0f / a.sw : 0.0f;
+    for (int k = 0; k < D; ++k) {
+        if (k == IDX_YAW) {
+            const float c = a.s1[k] * inv;
+            const float s = a.s2[k] * inv;
+            const float R = sqrtf(c * c + s * s);
+            out.mean[k] = atan2f(s, c);
+            out.var[k]  = (R > 0.0f) ? -2.0f * logf(fminf(R, 1.0f)) : INFINITY;
+        } else {
+            const float m = a.s1[k] * inv;
+            out.mean[k] = X_ref[k] + m;
+            out.var[k]  = fmaxf(a.s2[k] * inv - m * m, 0.0f);
+        }
+    }
+}
+
+// X is [N * D], W is [N] (nullptr = uniform weights).
+void cpu_posterior_summary(const float *X, const float *W, int N, PosteriorSummary &out);
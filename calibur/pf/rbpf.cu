@@ -1,6 +1,6 @@
 // rbpf_posyaw.cu
 #include <cuda_runtime.h>
-#include <curand_kernel.h>
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include "rbpf.cuh"
@@ -21,54 +21,8 @@
 
 
 
-__host__ RBPFParams default_params() {
-    RBPFParams p{};
-
-    // PF diffusion
-    p.Q_pos_diag[0] = p.Q_pos_diag[1] = p.Q_pos_diag[2] = Q_POS_DIFFUSION;
-    p.Q_yaw = Q_YAW_DIFFUSION;
-    p.Q_acc_diag[0] = p.Q_acc_diag[1] = p.Q_acc_diag[2] = Q_ACC_RANDOMWALK;
-    p.Q_yawalpha = Q_YAWACC_RANDOMWALK;
-
-    // KF diffusion
-    p.Q_vel_diag[0] = p.Q_vel_diag[1] = p.Q_vel_diag[2] = Q_VEL_DIFFUSION;
-    p.Q_vel_diag[3] = Q_YAWRATE_DIFFUSION;
-    p.Q_geom_diag[0] = p.Q_geom_diag[1] = p.Q_geom_diag[2] = Q_GEOM_DRIFT;
-
-    // Measurement noise
-    p.Rz_pos_diag[0] = p.Rz_pos_diag[1] = p.Rz_pos_diag[2] = RZ_POS_NOISE;
-    p.Rz_yaw = RZ_YAW_NOISE;
-
-    p.Ry_vel_diag[0] = p.Ry_vel_diag[1] = p.Ry_vel_diag[2] = RY_VEL_NOISE;
-    p.Ry_yawr       = RY_YAWR_NOISE;
-
-    p.Rc_geom_diag[0] = p.Rc_geom_diag[1] = p.Rc_geom_diag[2] = RC_GEOM_NOISE;
-
-    // Init spreads
-    p.init_vel_std[0] = p.init_vel_std[1] = p.init_vel_std[2] = INIT_VEL_STD;
-    p.init_vel_std[3] = INIT_VEL_STD;
-
-    p.init_geom_mean[0] = p.init_geom_mean[1] = INIT_GEOM_MEAN_R;
-    p.init_geom_std[0]  = p.init_geom_std[1]  = INIT_GEOM_STD_R;
-    p.init_geom_mean[2] = INIT_GEOM_MEAN_H;
-    p.init_geom_std[2]  = INIT_GEOM_STD_H;
-
-    return p;
-}
-
 // ======================= DEVICE HELPERS ==================
 
-__device__ inline float wrap_to_pi(float a) {
-    float twopi = 2.0f * M_PI;
-    a = fmodf(a + M_PI, twopi);
-    if (a < 0.0f) a += twopi;
-    return a - M_PI;
-}
-
-__device__ float gaussian(curandState *state) {
-    return curand_normal(state);
-}
-
 __global__ void broadcast_X0_kernel(float* X, int N, int D) {
     int idx = blockIdx.x * blockDim.x + threadIdx.x;
     if (idx >= N * D) return;
@@ -104,45 +58,22 @@ __global__ void compute_ess_kernel(const float* w, int N, float* out_ess_inv) {
 
 // ======================= KERNELS =========================
 
-// RNG init
-__global__ void init_rng_kernel(curandState *rng_states, int N, unsigned long long seed) {
-    int i = blockIdx.x * blockDim.x + threadIdx.x;
-    if (i >= N) return;
-    curand_init(seed, i, 0, &rng_states[i]);
-}
-
 // KF attach/init (similar to Python attach)
-__global__ void kf_attach_kernel(RBPFDevice dev, RBPFParams params) {
+__global__ void kf_attach_kernel(RBPFDevice dev, RBPFParams params, uint64_t seed) {
     int i = blockIdx.x * blockDim.x + threadIdx.x;
     if (i >= dev.N) return;
 
-    curandState local = dev.rng_states[i];
-
-    float *mean = &dev.kf_mean[i * KF_D];
-    float *Pvel = &dev.P_vel_diag[i * 4];
-    float *Pgeom = &dev.P_geom_diag[i * 3];
+    float n[RBPF_ATTACH_NOISE];
+    philox_normals(seed, PHILOX_ATTACH, uint32_t(i), 0u, n, RBPF_ATTACH_NOISE);
 
-    // vel0 = N(0, init_vel_std)
-    for (int k = 0; k < 4; ++k) {
-        float z = gaussian(&local);
-        mean[k] = z * params.init_vel_std[k];
-        Pvel[k] = params.init_vel_std[k] * params.init_vel_std[k];
-    }
-
-    // geom0 = init_geom_mean + N(0, init_geom_std)
-    for (int k = 0; k < 3; ++k) {
-        float z = gaussian(&local);
-        mean[4 + k] = params.init_geom_mean[k] + z * params.init_geom_std[k];
-        Pgeom[k] = params.init_geom_std[k] * params.init_geom_std[k];
-    }
+    rbpf_kf_attach_particle(&dev.kf_mean[i * KF_D], &dev.P_vel_diag[i * 4],
+                            &dev.P_geom_diag[i * 3], params, n);
 
     // prev_pos, prev_yaw start at 0
     dev.prev_pos[i * 3 + 0] = 0.0f;
     dev.prev_pos[i * 3 + 1] = 0.0f;
     dev.prev_pos[i * 3 + 2] = 0.0f;
     dev.prev_yaw[i] = 0.0f;
-
-    dev.rng_states[i] = local;
 }
 
 // on_before_predict: cache current pos and yaw
@@ -150,120 +81,23 @@ __global__ void on_before_predict_kernel(RBPFDevice dev) {
     int i = blockIdx.x * blockDim.x + threadIdx.x;
     if (i >= dev.N) return;
 
-    float *Xi = &dev.X[i * D];
-
-    dev.prev_pos[i * 3 + 0] = Xi[IDX_TX];
-    dev.prev_pos[i * 3 + 1] = Xi[IDX_TY];
-    dev.prev_pos[i * 3 + 2] = Xi[IDX_TZ];
-
-    dev.prev_yaw[i] = Xi[IDX_YAW];
+    rbpf_cache_prev(&dev.X[i * D], &dev.prev_pos[i * 3], &dev.prev_yaw[i]);
 }
 
 // predict kernel (PF + KF cov predict)
-__global__ void predict_kernel(RBPFDevice dev, RBPFParams params, float dt) {
+// noise keyed by (seed, slot, step): no per-particle generator state
+__global__ void predict_kernel(RBPFDevice dev, RBPFParams params, float dt,
+                               uint64_t seed, uint32_t step) {
     int i = blockIdx.x * blockDim.x + threadIdx.x;
     if (i >= dev.N) return;
     if (dt <= 0.0f) return;
 
-    curandState local = dev.rng_states[i];
-    float *Xi    = &dev.X[i * D];
-    float *mean  = &dev.kf_mean[i * KF_D];
-    float *Pvel  = &dev.P_vel_diag[i * 4];
-    float *Pgeom = &dev.P_geom_diag[i * 3];
-
-    // === KF covariance predict (diag) ===
-    for (int k = 0; k < 4; ++k) {
-        Pvel[k]  += params.Q_vel_diag[k]  * dt;
-    }
-    for (int k = 0; k < 3; ++k) {
-        Pgeom[k] += params.Q_geom_diag[k] * dt;
-    }
-
-    // === Precompute std for PF noises ===
-    float qpos_std[3];
-    float qacc_std[3];
-    for (int k = 0; k < 3; ++k) {
-        qpos_std[k] = sqrtf(params.Q_pos_diag[k] * dt);
-        qacc_std[k] = sqrtf(params.Q_acc_diag[k] * dt);
-    }
-    float qyaw_std  = sqrtf(params.Q_yaw      * dt);
-    float qyawa_std = sqrtf(params.Q_yawalpha * dt);
-
-    float qgeom_std[3];
-    for (int k = 0; k < 3; ++k) {
-        qgeom_std[k] = sqrtf(params.Q_geom_diag[k] * dt);
-    }
-
-    // === State views ===
-    float &x = Xi[IDX_TX];
-    float &y = Xi[IDX_TY];
-    float &z = Xi[IDX_TZ];
-
-    float &vx = Xi[IDX_VX];
-    float &vy = Xi[IDX_VY];
-    float &vz = Xi[IDX_VZ];
-
-    float &ax = Xi[IDX_AX];
-    float &ay = Xi[IDX_AY];
-    float &az = Xi[IDX_AZ];
-
-    float &yaw  = Xi[IDX_YAW];
-    float &yawr = Xi[IDX_OMEGA];
-    float &yawa = Xi[IDX_ALPHA];
-
-    float &r1 = Xi[IDX_R1];
-    float &r2 = Xi[IDX_R2];
-    float &h  = Xi[IDX_H];
-
-    // Pull KF mean velocities / yaw_rate into PF state
-    vx   = mean[0];
-    vy   = mean[1];
-    vz   = mean[2];
-    yawr = mean[3];
-    r1   = mean[4];
-    r2   = mean[5];
-    h    = mean[6];
-
-    // --- draw noises ---
-    float n_pos[3];
-    float n_acc[3];
-    for (int k = 0; k < 3; ++k) {
-        n_pos[k] = gaussian(&local) * qpos_std[k];
-        n_acc[k] = gaussian(&local) * qacc_std[k];
-    }
-    float n_yaw  = gaussian(&local) * qyaw_std;
-    float n_yawa = gaussian(&local) * qyawa_std;
-    float n_geom[3];
-    for (int k = 0; k < 3; ++k) {
-        n_geom[k] = gaussian(&local) * qgeom_std[k];
-    }
-
-    float dt2 = dt * dt;
-
-    // --- linear CA integration ---
-    x += vx * dt + 0.5f * ax * dt2 + n_pos[0];
-    y += vy * dt + 0.5f * ay * dt2 + n_pos[1];
-    z += vz * dt + 0.5f * az * dt2 + n_pos[2];
+    float n[RBPF_PREDICT_NOISE];
+    philox_normals(seed, PHILOX_PREDICT, uint32_t(i), step, n, RBPF_PREDICT_NOISE);
 
-    vx += ax * dt;
-    vy += ay * dt;
-    vz += az * dt;
-
-    ax += n_acc[0];
-    ay += n_acc[1];
-    az += n_acc[2];
-
-    // --- yaw CA integration ---
-    yaw  = wrap_to_pi(yaw + yawr * dt + 0.5f * yawa * dt2 + n_yaw);
-    yawr += yawa * dt;
-    yawa += n_yawa;
-
-    // --- geom slow drift ---
-    r1 += n_geom[0];
-    r2 += n_geom[1];
-    h  += n_geom[2];
-
-    dev.rng_states[i] = local;
+    rbpf_predict_particle(&dev.X[i * D], &dev.kf_mean[i * KF_D],
+                          &dev.P_vel_diag[i * 4], &dev.P_geom_diag[i * 3],
+                          params, dt, n);
 }
 
 // log-likelihood kernel: pos(3) + yaw
@@ -276,42 +110,17 @@ __global__ void loglik_kernel(
     int i = blockIdx.x * blockDim.x + threadIdx.x;
     if (i >= dev.N) return;
 
-    const float *Xi = &dev.X[i * D];
-
-    // Position diff
-    float diff_p[3];
-    diff_p[0] = Xi[IDX_TX] - z[IDX_TX];
-    diff_p[1] = Xi[IDX_TY] - z[IDX_TY];
-    diff_p[2] = Xi[IDX_TZ] - z[IDX_TZ];
-
-    float quad_p = 0.0f;
-    float const_p = 0.0f;
-    for (int k = 0; k < 3; ++k) {
-        float invR = 1.0f / params.Rz_pos_diag[k];
-        quad_p += diff_p[k] * diff_p[k] * invR;
-        const_p += logf(2.0f * M_PI * params.Rz_pos_diag[k]);
-    }
-    const_p *= -0.5f;
-
-    // Yaw diff
-    float diff_y = wrap_to_pi(Xi[IDX_YAW] - z[IDX_YAW]);
-    float invR_y = 1.0f / params.Rz_yaw;
-    float quad_y = diff_y * diff_y * invR_y;
-    float const_y = -0.5f * logf(2.0f * M_PI * params.Rz_yaw);
-
-    out_loglik[i] = (const_p - 0.5f * quad_p) + (const_y - 0.5f * quad_y);
+    out_loglik[i] = rbpf_loglik_particle(&dev.X[i * D], z, params);
 }
 
 // KF update kernel
 // - dt: timestep
-// - z:  obs vector, layout as state
 // - have_yaw_obs, y_obs, R_obs_yawr: for strong yaw-rate from obs yaw
 // - have_geom_obs, y_geom[3]: direct measurement of [r1,r2,h] (same for all particles)
 __global__ void kf_update_kernel(
     RBPFDevice dev,
     RBPFParams params,
     float dt,
-    const float *z,
     bool have_yaw_obs,
     float y_obs,
     float R_obs_yawr,
@@ -320,147 +129,19 @@ __global__ void kf_update_kernel(
 {
     int i = blockIdx.x * blockDim.x + threadIdx.x;
     if (i >= dev.N) return;
-    if (dt <= 0.0f) return;
-
-    float *Xi    = &dev.X[i * D];
-    float *mean  = &dev.kf_mean[i * KF_D];
-    float *Pvel  = &dev.P_vel_diag[i * 4];
-    float *Pgeom = &dev.P_geom_diag[i * 3];
-
-    // ---------- (A) Velocity from finite-diff pos ----------
-    float y_vel[3];
-    float prev_x = dev.prev_pos[i * 3 + 0];
-    float prev_y = dev.prev_pos[i * 3 + 1];
-    float prev_z = dev.prev_pos[i * 3 + 2];
-    y_vel[0] = (Xi[IDX_TX] - prev_x) / dt;
-    y_vel[1] = (Xi[IDX_TY] - prev_y) / dt;
-    y_vel[2] = (Xi[IDX_TZ] - prev_z) / dt;
-
-    // mu_v in KF mean: [0..2]
-    for (int k = 0; k < 3; ++k) {
-        float mu = mean[k];
-        float P  = Pvel[k];
-        float R  = params.Ry_vel_diag[k];
-        float S  = P + R;
-        float K  = (S > 0.0f) ? (P / S) : 0.0f;
-        float innov = y_vel[k] - mu;
-        mean[k] = mu + K * innov;
-        Pvel[k] = (1.0f - K) * P;
-    }
-
-    // ---------- (B) Yaw-rate from finite-diff yaw (weak pseudo) ----------
-    float prev_yaw = dev.prev_yaw[i];
-    float y_pseudo = wrap_to_pi(Xi[IDX_YAW] - prev_yaw) / dt;
-    {
-        int k = 3; // yaw_rate index in KF
-        float mu = mean[k];
-        float P  = Pvel[k];
-        float R  = params.Ry_yawr * 10.0f; // inflated
-        float S  = P + R;
-        float K  = (S > 0.0f) ? (P / S) : 0.0f;
-        float innov = y_pseudo - mu;
-        mean[k] = mu + K * innov;
-        Pvel[k] = (1.0f - K) * P;
-    }
-
-    // ---------- (C) Stronger yaw-rate from obs yaw (if provided) ----------
-    if (have_yaw_obs) {
-        int k = 3;
-        float mu = mean[k];
-        float P  = Pvel[k];
-        float R  = R_obs_yawr;
-        float S  = P + R;
-        float K  = (S > 0.0f) ? (P / S) : 0.0f;
-        float innov = y_obs - mu;
-        mean[k] = mu + K * innov;
-        Pvel[k] = (1.0f - K) * P;
-    }
-
-    // ---------- (D) Geometry update r1,r2,h (if provided) ----------
-    if (have_geom_obs) {
-        for (int k = 0; k < 3; ++k) {
-            float mu = mean[4 + k];
-            float P  = Pgeom[k];
-            float R  = params.Rc_geom_diag[k];
-            float S  = P + R;
-            float K  = (S > 0.0f) ? (P / S) : 0.0f;
-            float yg[3] = { y_geom0, y_geom1, y_geom2 };
-            float innov = yg[k] - mu;
-            mean[4 + k] = mu + K * innov;
-            Pgeom[k] = (1.0f - K) * P;
-        }
-    }
-
-    // ---------- (E) Write back KF means into PF state ----------
-    Xi[IDX_VX] = mean[0];
-    Xi[IDX_VY] = mean[1];
-    Xi[IDX_VZ] = mean[2];
-    Xi[IDX_OMEGA] = mean[3];      // yaw_rate
-    Xi[IDX_R1] = mean[4];
-    Xi[IDX_R2] = mean[5];
-    Xi[IDX_H]  = mean[6];
-}
-
-template<int D>
-__global__ void mean_kernel(const float* __restrict__ X,
-                                  int N,
-                                  float* __restrict__ out_mean)
-{
-    extern __shared__ float sdata[]; // size = blockDim.x * D
-    int tid = threadIdx.x;
 
-    // 1) Per-thread accumulators in registers (float)
-    float acc[D];
-    #pragma unroll
-    for (int k = 0; k < D; ++k) {
-        acc[k] = 0.0f;
-    }
-
-    // 2) Striped accumulation over N (no atomics, all float)
-    for (int idx = tid; idx < N; idx += blockDim.x) {
-        const float* Xi = X + idx * D;  // Xi[0..D-1] are float
-        #pragma unroll
-        for (int k = 0; k < D; ++k) {
-            acc[k] += Xi[k];
-        }
-    }
-
-    // 3) Store per-thread partials into shared memory (float)
-    float* srow = &sdata[tid * D];
-    #pragma unroll
-    for (int k = 0; k < D; ++k) {
-        srow[k] = acc[k];
-    }
-    __syncthreads();
-
-    // 4) Parallel reduction across threads in the block (float)
-    for (int stride = blockDim.x / 2; stride > 0; stride >>= 1) {
-        if (tid < stride) {
-            float* srow_dst = &sdata[tid * D];
-            float* srow_src = &sdata[(tid + stride) * D];
-            #pragma unroll
-            for (int k = 0; k < D; ++k) {
-                srow_dst[k] += srow_src[k];
-            }
-        }
-        __syncthreads();
-    }
-
-    // 5) Thread 0 writes means (float)
-    if (tid == 0) {
-        float invN = 1.0f / float(N);
-        float* srow0 = &sdata[0];
-        #pragma unroll
-        for (int k = 0; k < D; ++k) {
-            out_mean[k] = srow0[k] * invN;
-        }
-    }
+    rbpf_kf_update_particle(&dev.X[i * D], &dev.kf_mean[i * KF_D],
+                            &dev.P_vel_diag[i * 4], &dev.P_geom_diag[i * 3],
+                            &dev.prev_pos[i * 3], dev.prev_yaw[i],
+                            params, dt,
+                            have_yaw_obs, y_obs, R_obs_yawr,
+                            have_geom_obs, y_geom0, y_geom1, y_geom2);
 }
 
 // ======================= HOST WRAPPER ====================
 
 RBPFPosYawModelGPU::RBPFPosYawModelGPU(int N_, const RBPFParams &p)
-    : N(N_), params(p), z_yaw_prev(NAN)
+    : N(N_), N_max(N_), params(p), N_next(N_), z_yaw_prev(NAN)
 {
     dev.N = N;
 
@@ -470,12 +151,9 @@ RBPFPosYawModelGPU::RBPFPosYawModelGPU(int N_, const RBPFParams &p)
     size_t szPgeom   = N * 3    * sizeof(float);
     size_t szPrevPos = N * 3    * sizeof(float);
     size_t szPrevYaw = N        * sizeof(float);
-    size_t szRng     = N        * sizeof(curandState);
     size_t szLoglik  = N        * sizeof(float);
     size_t szObs     = D        * sizeof(float);
     size_t szW       = N        * sizeof(float);
-    size_t szCDF     = N        * sizeof(float);
-    size_t szMeanVec = D        * sizeof(float);
 
     CHECK(cudaStreamCreateWithPriority(&stream, cudaStreamNonBlocking, 1));
 
@@ -485,35 +163,42 @@ RBPFPosYawModelGPU::RBPFPosYawModelGPU(int N_, const RBPFParams &p)
     cudaMalloc(&dev.P_geom_diag,szPgeom);
     cudaMalloc(&dev.prev_pos,   szPrevPos);
     cudaMalloc(&dev.prev_yaw,   szPrevYaw);
-    cudaMalloc(&dev.rng_states, szRng);
+
+    dev_back = dev;
+    cudaMalloc(&dev_back.X,          szX);
+    cudaMalloc(&dev_back.kf_mean,    szMean);
+    cudaMalloc(&dev_back.P_vel_diag, szPvel);
+    cudaMalloc(&dev_back.P_geom_diag,szPgeom);
+    cudaMalloc(&dev_back.prev_pos,   szPrevPos);
+    cudaMalloc(&dev_back.prev_yaw,   szPrevYaw);
 
     cudaMalloc(&d_loglik, szLoglik);
     cudaMalloc(&d_obs,    szObs);
     cudaMalloc(&d_W,      szW);
-    cudaMalloc(&d_cdf,    szCDF);
-    cudaMalloc(&d_mean,   szMeanVec);
     cudaMalloc(&d_max, sizeof(float));
     cudaMalloc(&d_sum, sizeof(float));
 
-    cudaMalloc(&X_new,     szX);
-    cudaMalloc(&kf_new,    szMean);
-    cudaMalloc(&Pvel_new,  szPvel);
-    cudaMalloc(&Pgeom_new, szPgeom);
-
     cudaMalloc(&d_ess_inv, sizeof(float));
 
-    // init RNG
-    int block = CUDA_BLOCK_SIZE;
-    int grid  = (N + block - 1) / block;
-    init_rng_kernel<<<grid, block, 0, stream>>>(dev.rng_states, N, 1234ULL);
+    resample_workspace_alloc(resample_ws, N);
+
+    CHECK(cudaMallocHost(&h_stats, sizeof(StatsHost)));
+    CHECK(cudaEventCreateWithFlags(&stats_event, cudaEventDisableTiming));
+
+    posterior_workspace_alloc(post_ws);
+    CHECK(cudaMallocHost(&h_summary, sizeof(PosteriorSummary)));
+    CHECK(cudaEventCreateWithFlags(&summary_event, cudaEventDisableTiming));
+    telemetry.num_particles = N;
+    telemetry.ess           = float(N);
 
     // attach/init KF
-    kf_attach_kernel<<<grid, block, 0, stream>>>(dev, params);
+    int block = CUDA_BLOCK_SIZE;
+    int grid  = (N + block - 1) / block;
+    kf_attach_kernel<<<grid, block, 0, stream>>>(dev, params, rng_seed);
 
     // init weights uniform
-    float w0 = 1.0f / float(N);
-    // simple kernel or thrust; for now assume kernel exists
-    // gpu_set_uniform_weights(d_W, N, stream);
+    gpu_set_uniform_weights(d_W, N, stream);
+    compute_ess_kernel<<<1, 256, 0, stream>>>(d_W, N, d_ess_inv);
 
     cudaStreamSynchronize(stream);
 }
@@ -525,22 +210,32 @@ RBPFPosYawModelGPU::~RBPFPosYawModelGPU() {
     cudaFree(dev.P_geom_diag);
     cudaFree(dev.prev_pos);
     cudaFree(dev.prev_yaw);
-    cudaFree(dev.rng_states);
+
+    cudaFree(dev_back.X);
+    cudaFree(dev_back.kf_mean);
+    cudaFree(dev_back.P_vel_diag);
+    cudaFree(dev_back.P_geom_diag);
+    cudaFree(dev_back.prev_pos);
+    cudaFree(dev_back.prev_yaw);
 
     cudaFree(d_W);
     cudaFree(d_loglik);
-    cudaFree(d_mean);
     cudaFree(d_obs);
-    cudaFree(d_cdf);
     cudaFree(d_max);
     cudaFree(d_sum);
-    cudaFree(X_new);
-    cudaFree(kf_new);
-    cudaFree(Pvel_new);
-    cudaFree(Pgeom_new);
 
     cudaFree(d_ess_inv);
 
+    resample_workspace_free(resample_ws);
+    if (kld_enabled) kld_workspace_free(kld_ws);
+
+    cudaFreeHost(h_stats);
+    cudaEventDestroy(stats_event);
+
+    posterior_workspace_free(post_ws);
+    cudaFreeHost(h_summary);
+    cudaEventDestroy(summary_event);
+
     cudaStreamDestroy(stream);
 }
 
@@ -581,7 +276,7 @@ void RBPFPosYawModelGPU::predict_device(float dt) {
     int block = CUDA_BLOCK_SIZE;
     int grid  = (N + block - 1) / block;
     on_before_predict_kernel<<<grid, block, 0, stream>>>(dev);
-    predict_kernel<<<grid, block, 0, stream>>>(dev, params, dt);
+    predict_kernel<<<grid, block, 0, stream>>>(dev, params, dt, rng_seed, rng_step++);
 }
 
 void RBPFPosYawModelGPU::loglik_device() {
@@ -599,17 +294,61 @@ void RBPFPosYawModelGPU::kf_update_device(
     int grid  = (N + block - 1) / block;
     kf_update_kernel<<<grid, block, 0, stream>>>(
         dev, params, dt,
-        d_obs,
         have_yaw_obs, y_obs, R_obs_yawr,
         have_geom_obs, g0, g1, g2
     );
 }
 
-void RBPFPosYawModelGPU::mean_device() {
-    int block = 256;  // e.g. 32
-    int grid  = 1;
-    size_t shared_mem = block * D * sizeof(float);
-    mean_kernel<D><<<grid, block, shared_mem, stream>>>(dev.X, N, d_mean);
+void RBPFPosYawModelGPU::resample_device() {
+    const int M = kld_enabled ? N_next : N;
+    gpu_resample_particles(dev, dev_back, d_W, resample_ws,
+                           resample_scheme, resample_seed, resample_step++,
+                           N, M, stream);
+    N = M;
+    gpu_set_uniform_weights(d_W, N, stream);
+
+    // occupied bins of the new set decide the size of the next resample
+    if (kld_enabled) {
+        gpu_kld_count_bins(dev.X, N, kld, kld_ws, stream);
+    }
+}
+
+// Queue ESS (and KLD bin count) readback; never waits on the stream.
+void RBPFPosYawModelGPU::record_stats_device() {
+    cudaMemcpyAsync(&h_stats->ess_inv, d_ess_inv, sizeof(float),
+                    cudaMemcpyDeviceToHost, stream);
+    if (kld_enabled) {
+        cudaMemcpyAsync(&h_stats->occupied_bins, kld_ws.count, sizeof(int),
+                        cudaMemcpyDeviceToHost, stream);
+    }
+    cudaEventRecord(stats_event, stream);
+    stats_pending = true;
+}
+
+// Consume the last readback if it has landed; otherwise keep the old values.
+void RBPFPosYawModelGPU::poll_telemetry() {
+    telemetry.num_particles = N;
+    if (!stats_pending || cudaEventQuery(stats_event) != cudaSuccess) return;
+    stats_pending = false;
+
+    telemetry.ess = (h_stats->ess_inv > 0.0f) ? 1.0f / h_stats->ess_inv : 0.0f;
+    if (kld_enabled) {
+        telemetry.occupied_bins = h_stats->occupied_bins;
+        N_next = kld_required_particles(h_stats->occupied_bins, kld);
+    }
+}
+
+// Weighted mean / circular yaw / variance / ESS in one pass, copied to the
+// pinned h_summary; summary_event marks completion.
+void RBPFPosYawModelGPU::summary_device() {
+    gpu_posterior_summary(dev.X, d_W, N, post_ws, stream);
+    cudaMemcpyAsync(h_summary, post_ws.summary, sizeof(PosteriorSummary),
+                    cudaMemcpyDeviceToHost, stream);
+    cudaMemcpyAsync(&h_stats->summary_ess_inv, d_ess_inv, sizeof(float),
+                    cudaMemcpyDeviceToHost, stream);
+    cudaEventRecord(summary_event, stream);
+    summary_pending = true;
+    summary_stamp   = Clock::now();
 }
 
 void RBPFPosYawModelGPU::set_state_single(const float *X0) {
@@ -643,8 +382,8 @@ static inline void robotStateToObs(const RobotState &meas, float *z) {
     }
 }
 
-RBPFPosYawModelGPU *rbpf_create(int N) {
-    return new RBPFPosYawModelGPU(N);
+RBPFPosYawModelGPU *rbpf_create(int N, const RBPFParams &p) {
+    return new RBPFPosYawModelGPU(N, p);
 }
 
 void rbpf_destroy(RBPFPosYawModelGPU *pf) {
@@ -656,15 +395,28 @@ void rbpf_predict(RBPFPosYawModelGPU *pf, float dt) {
 }
 
 void rbpf_reset_from_meas(RBPFPosYawModelGPU *pf, const RobotState &meas) {
+    // re-acquisition: start from the full particle budget again
+    pf->N = pf->kld_enabled ? pf->kld.max_particles : pf->N_max;
+    pf->N_next = pf->N;
+    pf->dev.N = pf->dev_back.N = pf->N;
+    pf->stats_pending = false;   // drop a readback from before the reset
+    pf->summary_pending = false;
+    pf->telemetry.ess = float(pf->N);
+
     float X0[D];
     for (int i = 0; i < ROBOT_STATE_VEC_LEN; ++i)
         X0[i] = meas.state[i];
 
     pf->set_state_single(X0);
+    gpu_set_uniform_weights(pf->d_W, pf->N, pf->stream);
+    compute_ess_kernel<<<1, 256, 0, pf->stream>>>(pf->d_W, pf->N, pf->d_ess_inv);
 }
 
 
 void rbpf_step(RBPFPosYawModelGPU *pf, const RobotState &meas, float dt) {
+    // 0) pick up last step's ESS / KLD count (and thus this step's N_next)
+    pf->poll_telemetry();
+
     // 1) H2D: obs (only transfer this)
     float h_obs[D];
     robotStateToObs(meas, h_obs);
@@ -687,37 +439,19 @@ void rbpf_step(RBPFPosYawModelGPU *pf, const RobotState &meas, float dt) {
 
     // Only resample if necessary
     if (ESS < pf->N * 0.5f) {
-        gpu_resample_particles(
-            pf->dev, pf->d_W, pf->d_cdf,
-            pf->X_new, pf->kf_new, pf->Pvel_new, pf->Pgeom_new,
-            pf->N, pf->stream);
-
-        gpu_set_uniform_weights(pf->d_W, pf->N, pf->stream);
+        pf->resample_device();
     }
 #else
-    gpu_resample_particles(
-            pf->dev, pf->d_W, pf->d_cdf,
-            pf->X_new, pf->kf_new, pf->Pvel_new, pf->Pgeom_new,
-            pf->N, pf->stream);
-
-    gpu_set_uniform_weights(pf->d_W, pf->N, pf->stream);
+    pf->resample_device();
 #endif
+    pf->record_stats_device();
 
     // 5) KF update – compute y_obs, R_obs on host
-    bool  have_yaw_obs = false;
     float y_obs = 0.0f;
     float R_obs = 0.0f;
     float z_yaw = h_obs[IDX_YAW];
-
-    if (!std::isnan(pf->z_yaw_prev)) {
-        float dy = std::fmod(z_yaw - pf->z_yaw_prev + M_PI, 2.0f * M_PI);
-        if (dy < 0.0f) dy += 2.0f * M_PI;
-        dy -= M_PI;
-        y_obs = dy / dt;
-        float gain = 2.0f;
-        R_obs = gain * pf->params.Rz_yaw / (dt * dt);
-        have_yaw_obs = true;
-    }
+    bool  have_yaw_obs = rbpf_yaw_rate_obs(z_yaw, pf->z_yaw_prev, dt,
+                                           pf->params.Rz_yaw, y_obs, R_obs);
     pf->z_yaw_prev = z_yaw;
 
     bool  have_geom = true;
@@ -726,33 +460,57 @@ void rbpf_step(RBPFPosYawModelGPU *pf, const RobotState &meas, float dt) {
     pf->kf_update_device(dt, have_yaw_obs, y_obs, R_obs, have_geom, g0, g1, g2);
 }
 
-RobotState rbpf_get_mean(RBPFPosYawModelGPU *pf) {
-    pf->mean_device();
-
-    float host_mean[D];
-    cudaMemcpyAsync(host_mean, pf->d_mean, D*sizeof(float),
-                    cudaMemcpyDeviceToHost, pf->stream);
-    cudaStreamSynchronize(pf->stream);
-
+static RobotState summary_to_state(const PosteriorSummary &sm, TimePoint stamp) {
     RobotState rs{};
-    // TODO: map host_mean[0..14] -> rs fields
     for (int i = 0; i < ROBOT_STATE_VEC_LEN; ++i) {
-        rs.state[i] = host_mean[i];
+        rs.state[i] = sm.mean[i];
     }
+    rs.timestamp = stamp;
+    return rs;
+}
+
+void rbpf_request_summary(RBPFPosYawModelGPU *pf) {
+    pf->summary_device();
+}
 
-    // you can also set extra fields if you want:
-    // rs.class_id = 0; // or track it somewhere
-    // rs.pf_state = PF_STATE_OK;
-    rs.timestamp = Clock::now();
+bool rbpf_poll_summary(RBPFPosYawModelGPU *pf, PosteriorSummary &out) {
+    if (!pf->summary_pending || cudaEventQuery(pf->summary_event) != cudaSuccess)
+        return false;
+    pf->summary_pending = false;
+    out = *pf->h_summary;
+    const float ess_inv = pf->h_stats->summary_ess_inv;
+    out.ess = (ess_inv > 0.0f) ? 1.0f / ess_inv : 0.0f;
+    return true;
+}
 
-    // std::fprintf(stderr,
-    //     "[RBPF mean] x=%f y=%f z=%f yaw=%f\n",
-    //     rs.state[IDX_TX],
-    //     rs.state[IDX_TY],
-    //     rs.state[IDX_TZ],
-    //     rs.state[IDX_YAW]);
+bool rbpf_poll_mean(RBPFPosYawModelGPU *pf, RobotState &out) {
+    const TimePoint stamp = pf->summary_stamp;
+    PosteriorSummary sm;
+    if (!rbpf_poll_summary(pf, sm)) return false;
+    out = summary_to_state(sm, stamp);
+    return true;
+}
 
-    return rs;
+RobotState rbpf_get_mean(RBPFPosYawModelGPU *pf) {
+    pf->summary_device();
+    cudaEventSynchronize(pf->summary_event);
+    pf->summary_pending = false;
+    return summary_to_state(*pf->h_summary, pf->summary_stamp);
+}
+
+void rbpf_enable_kld(RBPFPosYawModelGPU *pf, const KLDParams &kp) {
+    if (!pf->kld_enabled) kld_workspace_alloc(pf->kld_ws, pf->N_max);
+
+    pf->kld = kp;
+    pf->kld.max_particles = std::min(kp.max_particles, pf->N_max);
+    pf->kld.min_particles = std::max(1, std::min(kp.min_particles, pf->kld.max_particles));
+    pf->kld_enabled = true;
+    pf->N_next = std::min(pf->N, pf->kld.max_particles);
+}
+
+RBPFTelemetry rbpf_get_telemetry(RBPFPosYawModelGPU *pf) {
+    pf->poll_telemetry();
+    return pf->telemetry;
 }
 
 // =================== WEIGHT UPDATE / RESAMPLE HELPERS ===================
@@ -837,72 +595,39 @@ __global__ void set_uniform_weights_kernel(float *d_W, int N, float w0) {
     d_W[i] = w0;
 }
 
-// build CDF (prefix sum) of weights in a single thread (simple & safe)
-__global__ void build_cdf_kernel(const float *d_W, float *d_cdf, int N) {
-    if (blockIdx.x == 0 && threadIdx.x == 0) {
-        float c = 0.0f;
-        for (int i = 0; i < N; ++i) {
-            c += d_W[i];
-            d_cdf[i] = c;
-        }
-        // small numerical fix: ensure last element is exactly 1.0
-        if (N > 0) d_cdf[N - 1] = 1.0f;
-    }
-}
-
-// resample particles (systematic, deterministic u0 = 0.5/N)
-__global__ void resample_kernel(
-        RBPFDevice dev,
-        const float *d_cdf,
-        float *X_new,
-        float *kf_new,
-        float *Pvel_new,
-        float *Pgeom_new,
+// gather resampled particles into the back buffer (prev_pos/prev_yaw travel
+// with their particle so the KF finite differences stay consistent)
+__global__ void gather_particles_kernel(
+        RBPFDevice src,
+        RBPFDevice dst,
+        const int *ancestors,
         int N)
 {
     int i = blockIdx.x * blockDim.x + threadIdx.x;
     if (i >= N) return;
 
-    // systematic resampling with fixed offset (no RNG needed)
-    float u0 = 0.5f / float(N);
-    float u  = u0 + float(i) / float(N);
+    const int idx = ancestors[i];
 
-    // binary search in CDF
-    int lo = 0, hi = N - 1;
-    while (lo < hi) {
-        int mid = (lo + hi) >> 1;
-        if (d_cdf[mid] >= u) hi = mid;
-        else                  lo = mid + 1;
-    }
-    int idx = lo;  // chosen ancestor index
-
-    // copy PF state
-    const float *X_src = &dev.X[idx * D];
-    float       *X_dst = &X_new[i * D];
-    for (int k = 0; k < D; ++k) {
-        X_dst[k] = X_src[k];
-    }
-
-    // copy KF mean
-    const float *kf_src = &dev.kf_mean[idx * KF_D];
-    float       *kf_dst = &kf_new[i * KF_D];
-    for (int k = 0; k < KF_D; ++k) {
-        kf_dst[k] = kf_src[k];
-    }
+    const float *X_src = &src.X[idx * D];
+    float       *X_dst = &dst.X[i * D];
+    #pragma unroll
+    for (int k = 0; k < D; ++k) X_dst[k] = X_src[k];
 
-    // copy KF cov diagonals
-    const float *Pvel_src  = &dev.P_vel_diag[idx * 4];
-    float       *Pvel_dst  = &Pvel_new[i * 4];
-    for (int k = 0; k < 4; ++k) {
-        Pvel_dst[k] = Pvel_src[k];
-    }
+    const float *kf_src = &src.kf_mean[idx * KF_D];
+    float       *kf_dst = &dst.kf_mean[i * KF_D];
+    #pragma unroll
+    for (int k = 0; k < KF_D; ++k) kf_dst[k] = kf_src[k];
 
-    const float *Pgeom_src = &dev.P_geom_diag[idx * 3];
-    float       *Pgeom_dst = &Pgeom_new[i * 3];
+    #pragma unroll
+    for (int k = 0; k < 4; ++k) dst.P_vel_diag[i * 4 + k] = src.P_vel_diag[idx * 4 + k];
+    #pragma unroll
     for (int k = 0; k < 3; ++k) {
-        Pgeom_dst[k] = Pgeom_src[k];
+        dst.P_geom_diag[i * 3 + k] = src.P_geom_diag[idx * 3 + k];
+        dst.prev_pos[i * 3 + k]    = src.prev_pos[idx * 3 + k];
     }
+    dst.prev_yaw[i] = src.prev_yaw[idx];
 }
+
 void gpu_update_and_normalize_weights(
         const float *d_loglik,
         float *d_W,
@@ -931,42 +656,142 @@ void gpu_set_uniform_weights(float *d_W, int N, cudaStream_t stream) {
     set_uniform_weights_kernel<<<grid, block, 0, stream>>>(d_W, N, w0);
 }
 void gpu_resample_particles(
-        RBPFDevice dev,
-        float *d_W,
-        float *d_cdf,
-        float *X_new,
-        float *kf_new,
-        float *Pvel_new,
-        float *Pgeom_new,
+        RBPFDevice &dev,
+        RBPFDevice &dev_back,
+        const float *d_W,
+        ResampleWorkspace &ws,
+        ResampleScheme scheme,
+        uint64_t seed,
+        uint32_t step,
         int N,
+        int M,
         cudaStream_t stream)
 {
-    // 1) build CDF of weights (device-only)
-    build_cdf_kernel<<<1, 1, 0, stream>>>(d_W, d_cdf, N);
-
-    // 2) allocate temporary arrays for resampled state + KF stuff
-    size_t szX     = size_t(N) * D    * sizeof(float);
-    size_t szMean  = size_t(N) * KF_D * sizeof(float);
-    size_t szPvel  = size_t(N) * 4    * sizeof(float);
-    size_t szPgeom = size_t(N) * 3    * sizeof(float);
+    // 1) N weights -> ancestor per output slot (parallel scan + O(N) fill)
+    gpu_resample_ancestors(d_W, N, M, scheme, seed, step, ws, stream);
 
+    // 2) gather M particles into back buffer, 3) swap front/back (no device memcpy)
     int block = CUDA_BLOCK_SIZE;
-    int grid  = (N + block - 1) / block;
+    int grid  = (M + block - 1) / block;
+    gather_particles_kernel<<<grid, block, 0, stream>>>(dev, dev_back, ws.ancestors, M);
+
+    swap_particle_buffers(dev, dev_back);
+    dev.N = dev_back.N = M;
+}
 
-    // 3) resample into new arrays (systematic with fixed u0)
-    resample_kernel<<<grid, block, 0, stream>>>(
-        dev, d_cdf, X_new, kf_new, Pvel_new, Pgeom_new, N);
+// =================== OOSM CHECKPOINTS ===================
 
-    // 4) overwrite original device arrays with resampled ones
-    cudaMemcpyAsync(dev.X,          X_new,     szX,
-                    cudaMemcpyDeviceToDevice, stream);
-    cudaMemcpyAsync(dev.kf_mean,    kf_new,    szMean,
-                    cudaMemcpyDeviceToDevice, stream);
-    cudaMemcpyAsync(dev.P_vel_diag, Pvel_new,  szPvel,
-                    cudaMemcpyDeviceToDevice, stream);
-    cudaMemcpyAsync(dev.P_geom_diag,Pgeom_new, szPgeom,
-                    cudaMemcpyDeviceToDevice, stream);
+static void copy_particles_async(const RBPFDevice &src, RBPFDevice &dst, int N,
+                                 cudaStream_t stream) {
+    const size_t n = size_t(N);
+    cudaMemcpyAsync(dst.X,           src.X,           n * D    * sizeof(float), cudaMemcpyDeviceToDevice, stream);
+    cudaMemcpyAsync(dst.kf_mean,     src.kf_mean,     n * KF_D * sizeof(float), cudaMemcpyDeviceToDevice, stream);
+    cudaMemcpyAsync(dst.P_vel_diag,  src.P_vel_diag,  n * 4    * sizeof(float), cudaMemcpyDeviceToDevice, stream);
+    cudaMemcpyAsync(dst.P_geom_diag, src.P_geom_diag, n * 3    * sizeof(float), cudaMemcpyDeviceToDevice, stream);
+    cudaMemcpyAsync(dst.prev_pos,    src.prev_pos,    n * 3    * sizeof(float), cudaMemcpyDeviceToDevice, stream);
+    cudaMemcpyAsync(dst.prev_yaw,    src.prev_yaw,    n        * sizeof(float), cudaMemcpyDeviceToDevice, stream);
 }
 
+RBPFCheckpointsGPU::RBPFCheckpointsGPU(RBPFPosYawModelGPU *pf_, int num_slots)
+    : pf(pf_), slots(num_slots)
+{
+    const size_t n = size_t(pf->N_max);
+    for (auto &c : slots) {
+        c.buf = RBPFDevice{};
+        cudaMalloc(&c.buf.X,           n * D    * sizeof(float));
+        cudaMalloc(&c.buf.kf_mean,     n * KF_D * sizeof(float));
+        cudaMalloc(&c.buf.P_vel_diag,  n * 4    * sizeof(float));
+        cudaMalloc(&c.buf.P_geom_diag, n * 3    * sizeof(float));
+        cudaMalloc(&c.buf.prev_pos,    n * 3    * sizeof(float));
+        cudaMalloc(&c.buf.prev_yaw,    n        * sizeof(float));
+        cudaMalloc(&c.W,               n        * sizeof(float));
+        c.N = 0;
+        c.N_next = 0;
+        c.z_yaw_prev = NAN;
+        c.rng_step = 0;
+        c.resample_step = 0;
+    }
+}
+
+RBPFCheckpointsGPU::~RBPFCheckpointsGPU() {
+    cudaStreamSynchronize(pf->stream);
+    for (auto &c : slots) {
+        cudaFree(c.buf.X);
+        cudaFree(c.buf.kf_mean);
+        cudaFree(c.buf.P_vel_diag);
+        cudaFree(c.buf.P_geom_diag);
+        cudaFree(c.buf.prev_pos);
+        cudaFree(c.buf.prev_yaw);
+        cudaFree(c.W);
+    }
+}
+
+void RBPFCheckpointsGPU::checkpoint_save(int slot) {
+    RBPFCheckpointGPU &c = slots[slot];
+    copy_particles_async(pf->dev, c.buf, pf->N, pf->stream);
+    cudaMemcpyAsync(c.W, pf->d_W, size_t(pf->N) * sizeof(float),
+                    cudaMemcpyDeviceToDevice, pf->stream);
+    c.N          = pf->N;
+    c.N_next     = pf->N_next;
+    c.z_yaw_prev = pf->z_yaw_prev;
+    c.rng_step      = pf->rng_step;
+    c.resample_step = pf->resample_step;
+}
+
+void RBPFCheckpointsGPU::checkpoint_restore(int slot) {
+    const RBPFCheckpointGPU &c = slots[slot];
+    copy_particles_async(c.buf, pf->dev, c.N, pf->stream);
+    cudaMemcpyAsync(pf->d_W, c.W, size_t(c.N) * sizeof(float),
+                    cudaMemcpyDeviceToDevice, pf->stream);
+    pf->N          = c.N;
+    pf->N_next     = c.N_next;
+    pf->dev.N      = pf->dev_back.N = c.N;
+    pf->z_yaw_prev = c.z_yaw_prev;
+    pf->rng_step      = c.rng_step;
+    pf->resample_step = c.resample_step;
+    pf->stats_pending   = false;   // readbacks in flight describe the rolled-back state
+    pf->summary_pending = false;
+}
+
+void RBPFCheckpointsGPU::step(const float *z, float dt) {
+    RobotState meas{};
+    for (int i = 0; i < ROBOT_STATE_VEC_LEN; ++i) meas.state[i] = z[i];
+    rbpf_step(pf, meas, dt);
+}
+
+// =================== TRACKER ADAPTER ===================
+
+RBPFTrackerGPU::RBPFTrackerGPU(int N, int num_slots, const RBPFParams &p)
+    : pf_(rbpf_create(N, p)), ckpt_(new RBPFCheckpointsGPU(pf_, num_slots))
+{
+}
 
+RBPFTrackerGPU::~RBPFTrackerGPU() {
+    delete ckpt_;
+    rbpf_destroy(pf_);
+}
+
+void RBPFTrackerGPU::reset(const float *z) {
+    RobotState meas{};
+    for (int i = 0; i < ROBOT_STATE_VEC_LEN; ++i) meas.state[i] = z[i];
+    rbpf_reset_from_meas(pf_, meas);
+}
+
+void RBPFTrackerGPU::step(const float *z, float dt) {
+    ckpt_->step(z, dt);
+}
+
+void RBPFTrackerGPU::request_estimate() {
+    rbpf_request_summary(pf_);
+}
+
+bool RBPFTrackerGPU::poll_estimate(PosteriorSummary &out) {
+    return rbpf_poll_summary(pf_, out);
+}
+
+RBPFTelemetry RBPFTrackerGPU::telemetry() {
+    return rbpf_get_telemetry(pf_);
+}
 
+void RBPFTrackerGPU::checkpoint_save(int slot)    { ckpt_->checkpoint_save(slot); }
+void RBPFTrackerGPU::checkpoint_restore(int slot) { ckpt_->checkpoint_restore(slot); }
@@ -1,73 +1,21 @@
 // rbpf.cuh
 #pragma once
 
-#include <curand_kernel.h>
+#include <utility>
+#include <vector>
 #include "workers.hpp"
 #include "types.hpp"
+#include "rbpf_params.hpp"
+#include "rbpf_model.hpp"
+#include "philox.hpp"
+#include "resample.cuh"
+#include "kld.cuh"
+#include "posterior.cuh"
+#include "oosm.hpp"
+#include "tracker.hpp"
 
 constexpr int CUDA_BLOCK_SIZE = 256;
 
-// ===================== Process Noise (PF) =====================
-constexpr float Q_POS_DIFFUSION     = 1e-3f;
-constexpr float Q_YAW_DIFFUSION     = 5e-2f;
-constexpr float Q_ACC_RANDOMWALK    = 2e-2f;
-constexpr float Q_YAWACC_RANDOMWALK = 1e-3f;
-
-// ===================== Process Noise (KF) =====================
-constexpr float Q_VEL_DIFFUSION     = 2e-3f;
-constexpr float Q_YAWRATE_DIFFUSION = 5e-4f;
-constexpr float Q_GEOM_DRIFT        = 1e-5f;
-
-// ===================== Measurement Noise =====================
-constexpr float RZ_POS_NOISE        = 2e-3f;
-constexpr float RZ_YAW_NOISE        = 4e-3f;
-
-// ===================== Pseudo-measurements ===================
-constexpr float RY_VEL_NOISE        = 5e-2f;
-constexpr float RY_YAWR_NOISE       = 2e-2f;
-
-// ===================== Geometry direct measurement ==========
-constexpr float RC_GEOM_NOISE       = 1e-3f;
-
-// ===================== Initialization spreads ================
-constexpr float INIT_VEL_STD        = 0.2f;
-constexpr float INIT_GEOM_MEAN_R   = 0.30f;
-constexpr float INIT_GEOM_MEAN_H   = 0.0f;
-constexpr float INIT_GEOM_STD_R    = 0.05f;
-constexpr float INIT_GEOM_STD_H    = 0.05f;
-
-// ======================= CONFIG ==========================
-constexpr int D    = 15;  // PF state dim
-constexpr int KF_D = 7;   // KF state dim: [vx,vy,vz,yaw_rate,r1,r2,h]
-
-// ======================= PARAMS ==========================
-
-struct RBPFParams {
-    // Process noise (PF)
-    float Q_pos_diag[3];
-    float Q_yaw;
-    float Q_acc_diag[3];
-    float Q_yawalpha;
-
-    // KF process noise
-    float Q_vel_diag[4];    // [vx,vy,vz,yaw_rate]
-    float Q_geom_diag[3];   // [r1,r2,h]
-
-    // Measurement covariances
-    float Rz_pos_diag[3];
-    float Rz_yaw;
-
-    float Ry_vel_diag[3];
-    float Ry_yawr;
-
-    float Rc_geom_diag[3];
-
-    // Init spreads
-    float init_vel_std[4];
-    float init_geom_mean[3];
-    float init_geom_std[3];
-};
-
 // ======================= DEVICE STATE ====================
 
 struct RBPFDevice {
@@ -80,36 +28,71 @@ struct RBPFDevice {
 
     float *prev_pos;    // [N * 3]
     float *prev_yaw;    // [N]
-
-    curandState *rng_states; // [N]
 };
 
-// Forward declaration of default params
-RBPFParams default_params();
+// Swap particle arrays of two buffers.
+inline void swap_particle_buffers(RBPFDevice &a, RBPFDevice &b) {
+    std::swap(a.X,           b.X);
+    std::swap(a.kf_mean,     b.kf_mean);
+    std::swap(a.P_vel_diag,  b.P_vel_diag);
+    std::swap(a.P_geom_diag, b.P_geom_diag);
+    std::swap(a.prev_pos,    b.prev_pos);
+    std::swap(a.prev_yaw,    b.prev_yaw);
+}
 
 // ======================= MAIN GPU OBJECT =================
 
 struct RBPFPosYawModelGPU {
-    int N;
+    int N;        // active particles
+    int N_max;    // allocated capacity
     RBPFParams params;
     RBPFDevice dev;
+    RBPFDevice dev_back;    // resample target, swapped with dev after gather
 
     float *d_W;
     float *d_loglik;
-    float *d_mean;
     float *d_obs;
-    float *d_cdf;
 
     // scratch
     float *d_max = nullptr;
     float *d_sum = nullptr;
-    float *X_new = nullptr;
-    float *kf_new = nullptr;
-    float *Pvel_new = nullptr;
-    float *Pgeom_new = nullptr;
 
     float *d_ess_inv = nullptr;
 
+    // resampling
+    ResampleWorkspace resample_ws;
+    ResampleScheme    resample_scheme = ResampleScheme::SYSTEMATIC;
+    uint64_t          resample_seed   = 1234ULL;
+    uint32_t          resample_step   = 0;
+
+    // process noise: Philox keyed by (rng_seed, slot, rng_step), see philox.hpp
+    uint64_t          rng_seed        = 1234ULL;
+    uint32_t          rng_step        = 0;
+
+    // adaptive particle count (KLD-sampling), off until rbpf_enable_kld
+    bool         kld_enabled = false;
+    KLDParams    kld;
+    KLDWorkspace kld_ws;
+    int          N_next;
+
+    // telemetry: ESS / occupied bins copied to pinned memory every step and
+    // picked up by poll_telemetry() once the event has completed
+    struct StatsHost { float ess_inv; int occupied_bins; float summary_ess_inv; };
+    StatsHost    *h_stats = nullptr;
+    cudaEvent_t   stats_event;
+    bool          stats_pending = false;
+    RBPFTelemetry telemetry;
+
+    // posterior summary: fused reduction -> pinned block, completion tracked
+    // by summary_event so the caller can poll instead of syncing the stream;
+    // its ESS is d_ess_inv of the last update (h_stats->summary_ess_inv), as
+    // the weights are uniform again after resampling
+    PosteriorWorkspace post_ws;
+    PosteriorSummary  *h_summary = nullptr;
+    cudaEvent_t        summary_event;
+    bool               summary_pending = false;
+    TimePoint          summary_stamp;
+
     float z_yaw_prev;
     cudaStream_t stream;
 
@@ -127,18 +110,31 @@ struct RBPFPosYawModelGPU {
     void kf_update_device(float dt,
                           bool have_yaw_obs, float y_obs, float R_obs_yawr,
                           bool have_geom_obs, float g0, float g1, float g2);
-    void mean_device();
+    void resample_device();
+    void summary_device();
+
+    void record_stats_device();
+    void poll_telemetry();
 };
 
 // ======================= C API WRAPPERS ==================
 
-RBPFPosYawModelGPU *rbpf_create(int N);
+RBPFPosYawModelGPU *rbpf_create(int N, const RBPFParams &p = default_params());
 void rbpf_destroy(RBPFPosYawModelGPU *pf);
 
 void rbpf_reset_from_meas(RBPFPosYawModelGPU *pf, const RobotState &meas);
 void rbpf_predict(RBPFPosYawModelGPU *pf, float dt);
 void rbpf_step(RBPFPosYawModelGPU *pf, const RobotState &meas, float dt);
-RobotState rbpf_get_mean(RBPFPosYawModelGPU *pf);
+RobotState rbpf_get_mean(RBPFPosYawModelGPU *pf);   // blocking, request + wait
+
+// Async posterior readback: request after predict/step, poll until it lands.
+// A new request supersedes one that has not been consumed yet.
+void rbpf_request_summary(RBPFPosYawModelGPU *pf);
+bool rbpf_poll_summary(RBPFPosYawModelGPU *pf, PosteriorSummary &out);
+bool rbpf_poll_mean(RBPFPosYawModelGPU *pf, RobotState &out);
+
+void rbpf_enable_kld(RBPFPosYawModelGPU *pf, const KLDParams &kp);
+RBPFTelemetry rbpf_get_telemetry(RBPFPosYawModelGPU *pf);
 void gpu_update_and_normalize_weights(
         const float *d_loglik,
         float *d_W,
@@ -149,12 +145,69 @@ void gpu_update_and_normalize_weights(
         cudaStream_t stream);
 void gpu_set_uniform_weights(float *d_W, int N, cudaStream_t stream);
 void gpu_resample_particles(
-        RBPFDevice dev,
-        float *d_W,
-        float *d_cdf,
-        float *X_new,
-        float *kf_new,
-        float *Pvel_new,
-        float *Pgeom_new,
+        RBPFDevice &dev,
+        RBPFDevice &dev_back,
+        const float *d_W,
+        ResampleWorkspace &ws,
+        ResampleScheme scheme,
+        uint64_t seed,
+        uint32_t step,
         int N,
+        int M,
         cudaStream_t stream);
+
+// ======================= OOSM CHECKPOINTS ================
+
+// Device snapshot of the active particle set. The RNG counters are rewound
+// too, so a replay draws the same noise an in-order run would have.
+struct RBPFCheckpointGPU {
+    RBPFDevice buf;
+    float     *W;
+    int        N;
+    int        N_next;
+    float      z_yaw_prev;
+    uint32_t   rng_step;
+    uint32_t   resample_step;
+};
+
+// Fixed pool of checkpoints for out-of-sequence replay (oosm.hpp backend).
+// All copies are device-to-device on pf->stream, nothing syncs the host.
+struct RBPFCheckpointsGPU {
+    RBPFPosYawModelGPU            *pf;
+    std::vector<RBPFCheckpointGPU> slots;
+
+    RBPFCheckpointsGPU(RBPFPosYawModelGPU *pf_, int num_slots);
+    ~RBPFCheckpointsGPU();
+
+    RBPFCheckpointsGPU(const RBPFCheckpointsGPU&) = delete;
+    RBPFCheckpointsGPU& operator=(const RBPFCheckpointsGPU&) = delete;
+
+    void checkpoint_save(int slot);
+    void checkpoint_restore(int slot);
+    void step(const float *z, float dt);
+};
+
+// ======================= TRACKER ADAPTER =================
+
+// The GPU filter behind the Tracker interface used by PFWorker.
+class RBPFTrackerGPU final : public Tracker {
+public:
+    RBPFTrackerGPU(int N, int num_slots, const RBPFParams &p = default_params());
+    ~RBPFTrackerGPU() override;
+
+    const char *name() const override { return "rbpf"; }
+
+    void reset(const float *z) override;
+    void step(const float *z, float dt) override;
+    void request_estimate() override;
+    bool poll_estimate(PosteriorSummary &out) override;
+    RBPFTelemetry telemetry() override;
+    void checkpoint_save(int slot) override;
+    void checkpoint_restore(int slot) override;
+
+    RBPFPosYawModelGPU *model() { return pf_; }
+
+private:
+    RBPFPosYawModelGPU *pf_;
+    RBPFCheckpointsGPU *ckpt_;
+};
@@ -0,0 +1,355 @@
+// rbpf_cpu.cpp
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "rbpf_cpu.hpp"
+
+// ===================== compact storage loops =====================
+// Templated on the 16-bit format so the widen/narrow loops vectorize.
+
+template <ParticleStorage S>
+static void predict_packed(RBPFPackedParticle *P, int N, const RBPFParams &params,
+                           float dt, const float *noise, int stride) {
+    for (int i = 0; i < N; ++i) {
+        RBPFParticleRegs r;
+        rbpf_unpack_particle<S>(P[i], r);
+        rbpf_cache_prev(r.X, r.prev_pos, &r.prev_yaw);
+        rbpf_predict_particle(r.X, r.mean, r.Pvel, r.Pgeom, params, dt,
+                              &noise[size_t(i) * stride]);
+        rbpf_pack_particle<S>(r, P[i]);
+    }
+}
+
+template <ParticleStorage S>
+static void kf_update_packed(RBPFPackedParticle *P, int N, const RBPFParams &params,
+                             float dt, bool have_yaw_obs, float y_obs, float R_obs,
+                             const float *z) {
+    for (int i = 0; i < N; ++i) {
+        RBPFParticleRegs r;
+        rbpf_unpack_particle<S>(P[i], r);
+        rbpf_kf_update_particle(r.X, r.mean, r.Pvel, r.Pgeom, r.prev_pos, r.prev_yaw,
+                                params, dt,
+                                have_yaw_obs, y_obs, R_obs,
+                                true, z[IDX_R1], z[IDX_R2], z[IDX_H]);
+        rbpf_pack_particle<S>(r, P[i]);
+    }
+}
+
+// same lane layout as cpu_posterior_summary, on widened particles
+template <ParticleStorage S>
+static void summary_packed(const RBPFPackedParticle *P, const float *W, int N,
+                           PosteriorSummary &out) {
+    PosteriorAccum acc;
+    posterior_accum_zero(acc);
+    RBPFParticleRegs ref = {}, r;
+    if (N > 0) rbpf_unpack_particle<S>(P[0], ref);
+
+    constexpr int LANES = 8;
+    PosteriorAccum lane[LANES];
+    for (auto &l : lane) posterior_accum_zero(l);
+    for (int i = 0; i < N; ++i) {
+        rbpf_unpack_particle<S>(P[i], r);
+        posterior_accum_add(lane[i % LANES], r.X, ref.X, W[i]);
+    }
+    for (const auto &l : lane) posterior_accum_merge(acc, l);
+
+    posterior_finalize(acc, ref.X, N, out);
+}
+
+// =================================================================
+
+void RBPFHostParticles::resize(int N) {
+    X.assign(size_t(N) * D, 0.0f);
+    kf_mean.assign(size_t(N) * KF_D, 0.0f);
+    P_vel_diag.assign(size_t(N) * 4, 0.0f);
+    P_geom_diag.assign(size_t(N) * 3, 0.0f);
+    prev_pos.assign(size_t(N) * 3, 0.0f);
+    prev_yaw.assign(size_t(N), 0.0f);
+}
+
+RBPFPosYawModelCPU::RBPFPosYawModelCPU(int N_, const RBPFParams &p, uint64_t seed,
+                                       ParticleStorage storage_)
+    : N(N_), N_max(N_), params(p), storage(storage_), N_next(N_), z_yaw_prev(NAN)
+{
+    if (compact()) {
+        packed.assign(N_max, RBPFPackedParticle{});
+        packed_back.assign(N_max, RBPFPackedParticle{});
+    } else {
+        front.resize(N_max);
+        back.resize(N_max);
+    }
+    W.assign(N_max, 1.0f / float(N_max));
+    loglik.assign(N_max, 0.0f);
+    cdf.assign(N_max, 0.0f);
+    aux.assign(N_max, 0.0f);
+    ancestors.assign(N_max, 0);
+    noise.assign(size_t(N_max) * philox_batch_stride(RBPF_PREDICT_NOISE), 0.0f);
+    resample_seed = seed;
+    rng_seed      = seed;
+
+    // attach/init KF
+    float n[RBPF_ATTACH_NOISE];
+    for (int i = 0; i < N_max; ++i) {
+        philox_normals(rng_seed, PHILOX_ATTACH, uint32_t(i), 0u, n, RBPF_ATTACH_NOISE);
+        if (compact()) {
+            RBPFParticleRegs r = {};
+            rbpf_kf_attach_particle(r.mean, r.Pvel, r.Pgeom, params, n);
+            rbpf_pack_particle(r, storage, packed[i]);
+        } else {
+            rbpf_kf_attach_particle(&front.kf_mean[i * KF_D], &front.P_vel_diag[i * 4],
+                                    &front.P_geom_diag[i * 3], params, n);
+        }
+    }
+
+    telemetry.num_particles = N;
+    telemetry.ess           = float(N);
+}
+
+size_t RBPFPosYawModelCPU::bytes_per_particle() const {
+    return compact() ? sizeof(RBPFPackedParticle)
+                     : sizeof(float) * (D + KF_D + 4 + 3 + 3 + 1);
+}
+
+void RBPFPosYawModelCPU::enable_kld(const KLDParams &kp) {
+    kld = kp;
+    kld.max_particles = std::min(kld.max_particles, N_max);
+    kld.min_particles = std::max(1, std::min(kld.min_particles, kld.max_particles));
+    kld_table.assign(kld_table_size(kld.max_particles), KLD_EMPTY_KEY);
+    kld_enabled = true;
+    N_next = std::min(N, kld.max_particles);
+}
+
+void RBPFPosYawModelCPU::reset(const float *X0) {
+    // re-acquisition: start from the full particle budget again
+    N = kld_enabled ? kld.max_particles : N_max;
+    N_next = N;
+    for (int i = 0; i < N; ++i) {
+        if (compact()) {
+            RBPFParticleRegs r;
+            rbpf_unpack_particle(packed[i], storage, r);
+            std::memcpy(r.X, X0, D * sizeof(float));
+            rbpf_pack_particle(r, storage, packed[i]);
+        } else {
+            std::memcpy(&front.X[i * D], X0, D * sizeof(float));
+        }
+    }
+    std::fill(W.begin(), W.begin() + N, 1.0f / float(N));
+    telemetry.num_particles = N;
+    telemetry.ess           = float(N);
+}
+
+void RBPFPosYawModelCPU::predict(float dt) {
+    const uint32_t step = rng_step++;
+
+    // draw the whole step's noise first: the Philox loop has no cross-particle
+    // dependency and vectorizes, the model loop below stays scalar
+    constexpr int stride = philox_batch_stride(RBPF_PREDICT_NOISE);
+    if (dt > 0.0f) {
+        philox_normals_batch(rng_seed, PHILOX_PREDICT, step, N, RBPF_PREDICT_NOISE,
+                             noise.data());
+    }
+
+    if (compact()) {
+        // widen to registers, same model, narrow on the way out
+        if (storage == ParticleStorage::BF16)
+            predict_packed<ParticleStorage::BF16>(packed.data(), N, params, dt, noise.data(), stride);
+        else
+            predict_packed<ParticleStorage::FP16>(packed.data(), N, params, dt, noise.data(), stride);
+        return;
+    }
+
+    for (int i = 0; i < N; ++i) {
+        float *Xi = &front.X[i * D];
+        const float *n = &noise[size_t(i) * stride];
+        rbpf_cache_prev(Xi, &front.prev_pos[i * 3], &front.prev_yaw[i]);
+        rbpf_predict_particle(Xi, &front.kf_mean[i * KF_D],
+                              &front.P_vel_diag[i * 4], &front.P_geom_diag[i * 3],
+                              params, dt, n);
+    }
+}
+
+void RBPFPosYawModelCPU::update_weights() {
+    float mx = -1e30f;
+    for (int i = 0; i < N; ++i) mx = std::max(mx, loglik[i]);
+
+    float sum = 0.0f;
+    for (int i = 0; i < N; ++i) {
+        W[i] = std::exp(loglik[i] - mx);
+        sum += W[i];
+    }
+
+    float ess_inv = 0.0f;
+    for (int i = 0; i < N; ++i) {
+        if (sum > 0.0f) W[i] /= sum;
+        ess_inv += W[i] * W[i];
+    }
+    telemetry.ess = (ess_inv > 0.0f) ? 1.0f / ess_inv : 0.0f;
+}
+
+void RBPFPosYawModelCPU::resample() {
+    const int M = kld_enabled ? N_next : N;
+
+    cpu_resample_ancestors(W.data(), N, M, resample_scheme, resample_seed, resample_step++,
+                           cdf.data(), aux.data(), ancestors.data());
+
+    // gather into back buffer, then swap
+    if (compact()) {
+        for (int j = 0; j < M; ++j) packed_back[j] = packed[ancestors[j]];
+        std::swap(packed, packed_back);
+    } else {
+        gather_fp32(M);
+    }
+    N = M;
+    std::fill(W.begin(), W.begin() + N, 1.0f / float(N));
+
+    if (kld_enabled) {
+        telemetry.occupied_bins = count_bins();
+        N_next = kld_required_particles(telemetry.occupied_bins, kld);
+    }
+    telemetry.num_particles = N;
+}
+
+void RBPFPosYawModelCPU::gather_fp32(int M) {
+    for (int j = 0; j < M; ++j) {
+        const int a = ancestors[j];
+        std::memcpy(&back.X[j * D],          &front.X[a * D],          D * sizeof(float));
+        std::memcpy(&back.kf_mean[j * KF_D], &front.kf_mean[a * KF_D], KF_D * sizeof(float));
+        std::memcpy(&back.P_vel_diag[j * 4], &front.P_vel_diag[a * 4], 4 * sizeof(float));
+        std::memcpy(&back.P_geom_diag[j * 3],&front.P_geom_diag[a * 3],3 * sizeof(float));
+        std::memcpy(&back.prev_pos[j * 3],   &front.prev_pos[a * 3],   3 * sizeof(float));
+        back.prev_yaw[j] = front.prev_yaw[a];
+    }
+    std::swap(front, back);
+}
+
+int RBPFPosYawModelCPU::count_bins() {
+    if (!compact()) {
+        return cpu_kld_count_bins(front.X.data(), N, kld, kld_table.data(), int(kld_table.size()));
+    }
+    // the bin key only reads pos / vel / yaw, all in the fp32 part
+    std::fill(kld_table.begin(), kld_table.end(), KLD_EMPTY_KEY);
+    float Xi[D] = {};
+    int count = 0;
+    for (int i = 0; i < N; ++i) {
+        const RBPFPackedParticle &p = packed[i];
+        for (int k = 0; k < 6; ++k) Xi[IDX_TX + k] = p.fast[k];
+        Xi[IDX_YAW] = p.fast[6];
+        if (kld_table_insert(kld_table.data(), int(kld_table.size()), kld_bin_key(Xi, kld))) ++count;
+    }
+    return count;
+}
+
+void RBPFPosYawModelCPU::step(const float *z, float dt) {
+    predict(dt);
+
+    if (compact()) {
+        float Xi[D] = {};
+        for (int i = 0; i < N; ++i) {
+            const RBPFPackedParticle &p = packed[i];
+            Xi[IDX_TX] = p.fast[0];
+            Xi[IDX_TY] = p.fast[1];
+            Xi[IDX_TZ] = p.fast[2];
+            Xi[IDX_YAW] = p.fast[6];
+            loglik[i] = rbpf_loglik_particle(Xi, z, params);
+        }
+    } else {
+        for (int i = 0; i < N; ++i) {
+            loglik[i] = rbpf_loglik_particle(&front.X[i * D], z, params);
+        }
+    }
+    update_weights();
+    resample();
+
+    // KF update
+    float y_obs = 0.0f, R_obs = 0.0f;
+    const bool have_yaw_obs = rbpf_yaw_rate_obs(z[IDX_YAW], z_yaw_prev, dt, params.Rz_yaw,
+                                                y_obs, R_obs);
+    z_yaw_prev = z[IDX_YAW];
+
+    if (compact()) {
+        if (storage == ParticleStorage::BF16)
+            kf_update_packed<ParticleStorage::BF16>(packed.data(), N, params, dt,
+                                                    have_yaw_obs, y_obs, R_obs, z);
+        else
+            kf_update_packed<ParticleStorage::FP16>(packed.data(), N, params, dt,
+                                                    have_yaw_obs, y_obs, R_obs, z);
+        return;
+    }
+
+    for (int i = 0; i < N; ++i) {
+        rbpf_kf_update_particle(&front.X[i * D], &front.kf_mean[i * KF_D],
+                                &front.P_vel_diag[i * 4], &front.P_geom_diag[i * 3],
+                                &front.prev_pos[i * 3], front.prev_yaw[i],
+                                params, dt,
+                                have_yaw_obs, y_obs, R_obs,
+                                true, z[IDX_R1], z[IDX_R2], z[IDX_H]);
+    }
+}
+
+void RBPFPosYawModelCPU::summary(PosteriorSummary &out) const {
+    if (storage == ParticleStorage::BF16)
+        summary_packed<ParticleStorage::BF16>(packed.data(), W.data(), N, out);
+    else if (storage == ParticleStorage::FP16)
+        summary_packed<ParticleStorage::FP16>(packed.data(), W.data(), N, out);
+    else
+        cpu_posterior_summary(front.X.data(), W.data(), N, out);
+    // W is uniform after resampling; report the ESS of the update instead
+    out.ess = telemetry.ess;
+}
+
+void RBPFPosYawModelCPU::mean(float *out) const {
+    PosteriorSummary sm;
+    summary(sm);
+    for (int k = 0; k < D; ++k) out[k] = sm.mean[k];
+}
+
+// ===================== OOSM checkpoints =====================
+
+static void copy_particles(const RBPFHostParticles &src, RBPFHostParticles &dst, int N) {
+    std::copy_n(src.X.begin(),           size_t(N) * D,    dst.X.begin());
+    std::copy_n(src.kf_mean.begin(),     size_t(N) * KF_D, dst.kf_mean.begin());
+    std::copy_n(src.P_vel_diag.begin(),  size_t(N) * 4,    dst.P_vel_diag.begin());
+    std::copy_n(src.P_geom_diag.begin(), size_t(N) * 3,    dst.P_geom_diag.begin());
+    std::copy_n(src.prev_pos.begin(),    size_t(N) * 3,    dst.prev_pos.begin());
+    std::copy_n(src.prev_yaw.begin(),    size_t(N),        dst.prev_yaw.begin());
+}
+
+RBPFCheckpointsCPU::RBPFCheckpointsCPU(RBPFPosYawModelCPU &pf_, int num_slots)
+    : pf(pf_), slots(num_slots)
+{
+    for (auto &c : slots) {
+        if (pf.compact()) c.packed.resize(pf.N_max);
+        else              c.p.resize(pf.N_max);
+        c.W.assign(pf.N_max, 0.0f);
+        c.N = 0;
+        c.N_next = 0;
+        c.z_yaw_prev = NAN;
+        c.rng_step = 0;
+        c.resample_step = 0;
+    }
+}
+
+void RBPFCheckpointsCPU::checkpoint_save(int slot) {
+    RBPFCheckpointCPU &c = slots[slot];
+    if (pf.compact()) std::copy_n(pf.packed.begin(), pf.N, c.packed.begin());
+    else              copy_particles(pf.front, c.p, pf.N);
+    std::copy_n(pf.W.begin(), pf.N, c.W.begin());
+    c.N          = pf.N;
+    c.N_next     = pf.N_next;
+    c.z_yaw_prev = pf.z_yaw_prev;
+    c.rng_step      = pf.rng_step;
+    c.resample_step = pf.resample_step;
+}
+
+void RBPFCheckpointsCPU::checkpoint_restore(int slot) {
+    const RBPFCheckpointCPU &c = slots[slot];
+    if (pf.compact()) std::copy_n(c.packed.begin(), c.N, pf.packed.begin());
+    else              copy_particles(c.p, pf.front, c.N);
+    std::copy_n(c.W.begin(), c.N, pf.W.begin());
+    pf.N          = c.N;
+    pf.N_next     = c.N_next;
+    pf.z_yaw_prev = c.z_yaw_prev;
+    pf.rng_step      = c.rng_step;
+    pf.resample_step = c.resample_step;
+    pf.telemetry.num_particles = c.N;
+}
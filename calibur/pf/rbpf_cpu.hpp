@@ -0,0 +1,131 @@
+// rbpf_cpu.hpp
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "rbpf_model.hpp"
+#include "philox.hpp"
+#include "compact.hpp"
+#include "resample.hpp"
+#include "kld.hpp"
+#include "posterior.hpp"
+#include "oosm.hpp"
+#include "tracker.hpp"
+
+// CPU mirror of RBPFPosYawModelGPU. Same per-particle model (rbpf_model.hpp),
+// same resampler and KLD logic, plain std::vector storage. Used by tests,
+// benchmarks and offline tools that must run without a GPU.
+
+struct RBPFHostParticles {
+    std::vector<float> X;           // [N * D]
+    std::vector<float> kf_mean;     // [N * KF_D]
+    std::vector<float> P_vel_diag;  // [N * 4]
+    std::vector<float> P_geom_diag; // [N * 3]
+    std::vector<float> prev_pos;    // [N * 3]
+    std::vector<float> prev_yaw;    // [N]
+
+    void resize(int N);
+};
+
+struct RBPFPosYawModelCPU {
+    int N;        // active particles
+    int N_max;    // allocated capacity
+    RBPFParams params;
+
+    // FP32 uses front/back, the 16-bit modes packed/packed_back (compact.hpp)
+    ParticleStorage storage;
+    RBPFHostParticles front;
+    RBPFHostParticles back;
+    std::vector<RBPFPackedParticle> packed;
+    std::vector<RBPFPackedParticle> packed_back;
+
+    std::vector<float> W;
+    std::vector<float> loglik;
+
+    // resampling
+    std::vector<float> cdf;
+    std::vector<float> aux;
+    std::vector<int>   ancestors;
+    std::vector<float> noise;   // [N_max * philox_batch_stride(RBPF_PREDICT_NOISE)]
+    ResampleScheme     resample_scheme = ResampleScheme::SYSTEMATIC;
+    uint64_t           resample_seed   = 1234ULL;
+    uint32_t           resample_step   = 0;
+
+    // adaptive particle count
+    bool                  kld_enabled = false;
+    KLDParams             kld;
+    std::vector<uint64_t> kld_table;
+    int                   N_next;
+
+    RBPFTelemetry telemetry;
+    float z_yaw_prev;
+
+    // process noise, same Philox streams as the GPU backend
+    uint64_t rng_seed = 1234ULL;
+    uint32_t rng_step = 0;
+
+    RBPFPosYawModelCPU(int N_, const RBPFParams &p = default_params(), uint64_t seed = 1234ULL,
+                       ParticleStorage storage_ = ParticleStorage::FP32);
+
+    void enable_kld(const KLDParams &kp);
+
+    void reset(const float *X0);                // broadcast X0[D] to all particles
+    void predict(float dt);
+    void step(const float *z, float dt);        // z laid out like the state
+    void summary(PosteriorSummary &out) const;  // weighted, circular yaw; ESS before resampling
+    void mean(float *out) const;                // out[D] = summary().mean
+
+    bool compact() const { return storage != ParticleStorage::FP32; }
+    size_t bytes_per_particle() const;          // particle storage, excl. W
+
+private:
+    void update_weights();
+    void resample();
+    void gather_fp32(int M);
+    int  count_bins();
+};
+
+// Snapshot of the active particle set, preallocated for N_max particles.
+struct RBPFCheckpointCPU {
+    RBPFHostParticles  p;
+    std::vector<RBPFPackedParticle> packed;   // compact storage modes
+    std::vector<float> W;
+    int   N;
+    int   N_next;
+    float z_yaw_prev;
+    uint32_t rng_step;
+    uint32_t resample_step;
+};
+
+// Fixed pool of checkpoints for out-of-sequence replay (oosm.hpp backend).
+struct RBPFCheckpointsCPU {
+    RBPFPosYawModelCPU            &pf;
+    std::vector<RBPFCheckpointCPU> slots;
+
+    RBPFCheckpointsCPU(RBPFPosYawModelCPU &pf_, int num_slots);
+
+    void checkpoint_save(int slot);
+    void checkpoint_restore(int slot);
+    void step(const float *z, float dt) { pf.step(z, dt); }
+};
+
+// RBPFPosYawModelCPU behind the Tracker interface (tests, offline tools).
+class RBPFTrackerCPU final : public Tracker {
+public:
+    RBPFTrackerCPU(int N, int num_slots, const RBPFParams &p = default_params(),
+                   uint64_t seed = 1234ULL)
+        : pf(N, p, seed), ckpt(pf, num_slots) {}
+
+    const char *name() const override { return "rbpf_cpu"; }
+
+    void reset(const float *z) override             { pf.reset(z); }
+    void step(const float *z, float dt) override    { pf.step(z, dt); }
+    void request_estimate() override                {}
+    bool poll_estimate(PosteriorSummary &out) override { pf.summary(out); return true; }
+    RBPFTelemetry telemetry() override              { return pf.telemetry; }
+    void checkpoint_save(int slot) override         { ckpt.checkpoint_save(slot); }
+    void checkpoint_restore(int slot) override      { ckpt.checkpoint_restore(slot); }
+
+    RBPFPosYawModelCPU pf;
+    RBPFCheckpointsCPU ckpt;
+};
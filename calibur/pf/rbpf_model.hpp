@@ -0,0 +1,233 @@
+// rbpf_model.hpp
+#pragma once
+
+#include <cmath>
+#include "rbpf_params.hpp"
+
+// Per-particle model of the pos/yaw RBPF, written once for both the CUDA
+// kernels in rbpf.cu and the CPU mirror in rbpf_cpu.cpp. Every function works
+// on one particle's slices of the SoA buffers; random draws are passed in so
+// the caller owns the RNG.
+
+#ifndef PF_HD
+#ifdef __CUDACC__
+#define PF_HD __host__ __device__
+#else
+#define PF_HD
+#endif
+#endif
+
+constexpr float RBPF_PI = 3.14159265358979323846f;
+
+// Standard normals consumed by one predict, in draw order:
+//   [pos_x, acc_x, pos_y, acc_y, pos_z, acc_z, yaw, yaw_acc, r1, r2, h]
+constexpr int RBPF_PREDICT_NOISE = 11;
+// Standard normals consumed by kf attach: [vx, vy, vz, yaw_rate, r1, r2, h]
+constexpr int RBPF_ATTACH_NOISE  = KF_D;
+
+PF_HD inline float wrap_to_pi(float a) {
+    const float twopi = 2.0f * RBPF_PI;
+    a = fmodf(a + RBPF_PI, twopi);
+    if (a < 0.0f) a += twopi;
+    return a - RBPF_PI;
+}
+
+// KF attach/init: velocities ~ N(0, init_vel_std), geometry around its prior
+PF_HD inline void rbpf_kf_attach_particle(float *mean, float *Pvel, float *Pgeom,
+                                          const RBPFParams &params, const float *n) {
+    for (int k = 0; k < 4; ++k) {
+        mean[k] = n[k] * params.init_vel_std[k];
+        Pvel[k] = params.init_vel_std[k] * params.init_vel_std[k];
+    }
+    for (int k = 0; k < 3; ++k) {
+        mean[4 + k] = params.init_geom_mean[k] + n[4 + k] * params.init_geom_std[k];
+        Pgeom[k]    = params.init_geom_std[k] * params.init_geom_std[k];
+    }
+}
+
+// on_before_predict: cache current pos and yaw for the KF finite differences
+PF_HD inline void rbpf_cache_prev(const float *Xi, float *prev_pos, float *prev_yaw) {
+    prev_pos[0] = Xi[IDX_TX];
+    prev_pos[1] = Xi[IDX_TY];
+    prev_pos[2] = Xi[IDX_TZ];
+    *prev_yaw   = Xi[IDX_YAW];
+}
+
+// PF constant-acceleration predict + KF covariance predict (diag)
+PF_HD inline void rbpf_predict_particle(float *Xi, const float *mean,
+                                        float *Pvel, float *Pgeom,
+                                        const RBPFParams &params, float dt,
+                                        const float *n) {
+    if (dt <= 0.0f) return;
+
+    // === KF covariance predict (diag) ===
+    for (int k = 0; k < 4; ++k) Pvel[k]  += params.Q_vel_diag[k]  * dt;
+    for (int k = 0; k < 3; ++k) Pgeom[k] += params.Q_geom_diag[k] * dt;
+
+    // === noises ===
+    float n_pos[3], n_acc[3], n_geom[3];
+    for (int k = 0; k < 3; ++k) {
+        n_pos[k]  = n[2 * k]     * sqrtf(params.Q_pos_diag[k]  * dt);
+        n_acc[k]  = n[2 * k + 1] * sqrtf(params.Q_acc_diag[k]  * dt);
+        n_geom[k] = n[8 + k]     * sqrtf(params.Q_geom_diag[k] * dt);
+    }
+    const float n_yaw  = n[6] * sqrtf(params.Q_yaw      * dt);
+    const float n_yawa = n[7] * sqrtf(params.Q_yawalpha * dt);
+
+    // === State views ===
+    float &x = Xi[IDX_TX];
+    float &y = Xi[IDX_TY];
+    float &z = Xi[IDX_TZ];
+
+    float &vx = Xi[IDX_VX];
+    float &vy = Xi[IDX_VY];
+    float &vz = Xi[IDX_VZ];
+
+    float &ax = Xi[IDX_AX];
+    float &ay = Xi[IDX_AY];
+    float &az = Xi[IDX_AZ];
+
+    float &yaw  = Xi[IDX_YAW];
+    float &yawr = Xi[IDX_OMEGA];
+    float &yawa = Xi[IDX_ALPHA];
+
+    float &r1 = Xi[IDX_R1];
+    float &r2 = Xi[IDX_R2];
+    float &h  = Xi[IDX_H];
+
+    // Pull KF mean velocities / yaw_rate / geometry into PF state
+    vx   = mean[0];
+    vy   = mean[1];
+    vz   = mean[2];
+    yawr = mean[3];
+    r1   = mean[4];
+    r2   = mean[5];
+    h    = mean[6];
+
+    const float dt2 = dt * dt;
+
+    // --- linear CA integration ---
+    x += vx * dt + 0.5f * ax * dt2 + n_pos[0];
+    y += vy * dt + 0.5f * ay * dt2 + n_pos[1];
+    z += vz * dt + 0.5f * az * dt2 + n_pos[2];
+
+    vx += ax * dt;
+    vy += ay * dt;
+    vz += az * dt;
+
+    ax += n_acc[0];
+    ay += n_acc[1];
+    az += n_acc[2];
+
+    // --- yaw CA integration ---
+    yaw  = wrap_to_pi(yaw + yawr * dt + 0.5f * yawa * dt2 + n_yaw);
+    yawr += yawa * dt;
+    yawa += n_yawa;
+
+    // --- geom slow drift ---
+    r1 += n_geom[0];
+    r2 += n_geom[1];
+    h  += n_geom[2];
+}
+
+// Noise-free constant-acceleration extrapolation of one state vector (e.g. the
+// posterior mean) by dt, same integration as rbpf_predict_particle. Used to
+// predict the output to "now" between measurements without touching the
+// particles. out may alias X.
+PF_HD inline void rbpf_extrapolate_state(const float *X, float dt, float *out) {
+    const float dt2 = dt * dt;
+    float tmp[D];
+    for (int k = 0; k < D; ++k) tmp[k] = X[k];
+
+    for (int k = 0; k < 3; ++k) {
+        tmp[IDX_TX + k] = X[IDX_TX + k] + X[IDX_VX + k] * dt + 0.5f * X[IDX_AX + k] * dt2;
+        tmp[IDX_VX + k] = X[IDX_VX + k] + X[IDX_AX + k] * dt;
+    }
+    tmp[IDX_YAW]   = wrap_to_pi(X[IDX_YAW] + X[IDX_OMEGA] * dt + 0.5f * X[IDX_ALPHA] * dt2);
+    tmp[IDX_OMEGA] = X[IDX_OMEGA] + X[IDX_ALPHA] * dt;
+
+    for (int k = 0; k < D; ++k) out[k] = tmp[k];
+}
+
+// log-likelihood: pos(3) + yaw, z laid out like the state
+PF_HD inline float rbpf_loglik_particle(const float *Xi, const float *z,
+                                        const RBPFParams &params) {
+    float quad_p  = 0.0f;
+    float const_p = 0.0f;
+    for (int k = 0; k < 3; ++k) {
+        const float d = Xi[IDX_TX + k] - z[IDX_TX + k];
+        quad_p  += d * d / params.Rz_pos_diag[k];
+        const_p += logf(2.0f * RBPF_PI * params.Rz_pos_diag[k]);
+    }
+    const_p *= -0.5f;
+
+    const float diff_y  = wrap_to_pi(Xi[IDX_YAW] - z[IDX_YAW]);
+    const float quad_y  = diff_y * diff_y / params.Rz_yaw;
+    const float const_y = -0.5f * logf(2.0f * RBPF_PI * params.Rz_yaw);
+
+    return (const_p - 0.5f * quad_p) + (const_y - 0.5f * quad_y);
+}
+
+// scalar KF update of mean[k] / P[k] with observation y, noise R
+PF_HD inline void rbpf_kf_scalar_update(float &mu, float &P, float y, float R) {
+    const float S = P + R;
+    const float K = (S > 0.0f) ? (P / S) : 0.0f;
+    mu += K * (y - mu);
+    P   = (1.0f - K) * P;
+}
+
+// KF update
+// - velocity from finite-diff pos, weak yaw-rate from finite-diff yaw
+// - have_yaw_obs, y_obs, R_obs_yawr: stronger yaw-rate from obs yaw
+// - have_geom_obs, g0..g2: direct measurement of [r1,r2,h]
+PF_HD inline void rbpf_kf_update_particle(float *Xi, float *mean,
+                                          float *Pvel, float *Pgeom,
+                                          const float *prev_pos, float prev_yaw,
+                                          const RBPFParams &params, float dt,
+                                          bool have_yaw_obs, float y_obs, float R_obs_yawr,
+                                          bool have_geom_obs, float g0, float g1, float g2) {
+    if (dt <= 0.0f) return;
+
+    // (A) velocity from finite-diff pos
+    for (int k = 0; k < 3; ++k) {
+        const float y_vel = (Xi[IDX_TX + k] - prev_pos[k]) / dt;
+        rbpf_kf_scalar_update(mean[k], Pvel[k], y_vel, params.Ry_vel_diag[k]);
+    }
+
+    // (B) yaw-rate from finite-diff yaw (weak pseudo, inflated R)
+    const float y_pseudo = wrap_to_pi(Xi[IDX_YAW] - prev_yaw) / dt;
+    rbpf_kf_scalar_update(mean[3], Pvel[3], y_pseudo, params.Ry_yawr * 10.0f);
+
+    // (C) stronger yaw-rate from obs yaw
+    if (have_yaw_obs) {
+        rbpf_kf_scalar_update(mean[3], Pvel[3], y_obs, R_obs_yawr);
+    }
+
+    // (D) geometry r1,r2,h
+    if (have_geom_obs) {
+        const float yg[3] = { g0, g1, g2 };
+        for (int k = 0; k < 3; ++k) {
+            rbpf_kf_scalar_update(mean[4 + k], Pgeom[k], yg[k], params.Rc_geom_diag[k]);
+        }
+    }
+
+    // (E) write back KF means into PF state
+    Xi[IDX_VX]    = mean[0];
+    Xi[IDX_VY]    = mean[1];
+    Xi[IDX_VZ]    = mean[2];
+    Xi[IDX_OMEGA] = mean[3];
+    Xi[IDX_R1]    = mean[4];
+    Xi[IDX_R2]    = mean[5];
+    Xi[IDX_H]     = mean[6];
+}
+
+// Host side: yaw-rate observation from consecutive measured yaws.
+// Returns false on the first measurement (z_yaw_prev is NaN).
+inline bool rbpf_yaw_rate_obs(float z_yaw, float z_yaw_prev, float dt, float Rz_yaw,
+                              float &y_obs, float &R_obs) {
+    if (std::isnan(z_yaw_prev) || dt <= 0.0f) return false;
+    y_obs = wrap_to_pi(z_yaw - z_yaw_prev) / dt;
+    const float gain = 2.0f;
+    R_obs = gain * Rz_yaw / (dt * dt);
+    return true;
+}
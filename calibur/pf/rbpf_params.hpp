@@ -0,0 +1,112 @@
+// rbpf_params.hpp
+#pragma once
+
+#include "state_index.hpp"
+
+// Noise constants, dimensions and parameter block of the pos/yaw RBPF.
+// Shared by the CUDA filter (rbpf.cu) and its CPU mirror (rbpf_cpu.cpp).
+
+// ===================== Process Noise (PF) =====================
+constexpr float Q_POS_DIFFUSION     = 1e-3f;
+constexpr float Q_YAW_DIFFUSION     = 5e-2f;
+constexpr float Q_ACC_RANDOMWALK    = 2e-2f;
+constexpr float Q_YAWACC_RANDOMWALK = 1e-3f;
+
+// ===================== Process Noise (KF) =====================
+constexpr float Q_VEL_DIFFUSION     = 2e-3f;
+constexpr float Q_YAWRATE_DIFFUSION = 5e-4f;
+constexpr float Q_GEOM_DRIFT        = 1e-5f;
+
+// ===================== Measurement Noise =====================
+constexpr float RZ_POS_NOISE        = 2e-3f;
+constexpr float RZ_YAW_NOISE        = 4e-3f;
+
+// ===================== Pseudo-measurements ===================
+constexpr float RY_VEL_NOISE        = 5e-2f;
+constexpr float RY_YAWR_NOISE       = 2e-2f;
+
+// ===================== Geometry direct measurement ==========
+constexpr float RC_GEOM_NOISE       = 1e-3f;
+
+// ===================== Initialization spreads ================
+constexpr float INIT_VEL_STD        = 0.2f;
+constexpr float INIT_GEOM_MEAN_R   = 0.30f;
+constexpr float INIT_GEOM_MEAN_H   = 0.0f;
+constexpr float INIT_GEOM_STD_R    = 0.05f;
+constexpr float INIT_GEOM_STD_H    = 0.05f;
+
+// ======================= CONFIG ==========================
+constexpr int D    = 15;  // PF state dim
+constexpr int KF_D = 7;   // KF state dim: [vx,vy,vz,yaw_rate,r1,r2,h]
+
+// ======================= PARAMS ==========================
+
+struct RBPFParams {
+    // Process noise (PF)
+    float Q_pos_diag[3];
+    float Q_yaw;
+    float Q_acc_diag[3];
+    float Q_yawalpha;
+
+    // KF process noise
+    float Q_vel_diag[4];    // [vx,vy,vz,yaw_rate]
+    float Q_geom_diag[3];   // [r1,r2,h]
+
+    // Measurement covariances
+    float Rz_pos_diag[3];
+    float Rz_yaw;
+
+    float Ry_vel_diag[3];
+    float Ry_yawr;
+
+    float Rc_geom_diag[3];
+
+    // Init spreads
+    float init_vel_std[4];
+    float init_geom_mean[3];
+    float init_geom_std[3];
+};
+
+inline RBPFParams default_params() {
+    RBPFParams p{};
+
+    // PF diffusion
+    p.Q_pos_diag[0] = p.Q_pos_diag[1] = p.Q_pos_diag[2] = Q_POS_DIFFUSION;
+    p.Q_yaw = Q_YAW_DIFFUSION;
+    p.Q_acc_diag[0] = p.Q_acc_diag[1] = p.Q_acc_diag[2] = Q_ACC_RANDOMWALK;
+    p.Q_yawalpha = Q_YAWACC_RANDOMWALK;
+
+    // KF diffusion
+    p.Q_vel_diag[0] = p.Q_vel_diag[1] = p.Q_vel_diag[2] = Q_VEL_DIFFUSION;
+    p.Q_vel_diag[3] = Q_YAWRATE_DIFFUSION;
+    p.Q_geom_diag[0] = p.Q_geom_diag[1] = p.Q_geom_diag[2] = Q_GEOM_DRIFT;
+
+    // Measurement noise
+    p.Rz_pos_diag[0] = p.Rz_pos_diag[1] = p.Rz_pos_diag[2] = RZ_POS_NOISE;
+    p.Rz_yaw = RZ_YAW_NOISE;
+
+    p.Ry_vel_diag[0] = p.Ry_vel_diag[1] = p.Ry_vel_diag[2] = RY_VEL_NOISE;
+    p.Ry_yawr       = RY_YAWR_NOISE;
+
+    p.Rc_geom_diag[0] = p.Rc_geom_diag[1] = p.Rc_geom_diag[2] = RC_GEOM_NOISE;
+
+    // Init spreads
+    p.init_vel_std[0] = p.init_vel_std[1] = p.init_vel_std[2] = INIT_VEL_STD;
+    p.init_vel_std[3] = INIT_VEL_STD;
+
+    p.init_geom_mean[0] = p.init_geom_mean[1] = INIT_GEOM_MEAN_R;
+    p.init_geom_std[0]  = p.init_geom_std[1]  = INIT_GEOM_STD_R;
+    p.init_geom_mean[2] = INIT_GEOM_MEAN_H;
+    p.init_geom_std[2]  = INIT_GEOM_STD_H;
+
+    return p;
+}
+
+// ======================= TELEMETRY =======================
+
+// Per-step filter health, read back asynchronously on the GPU path.
+struct RBPFTelemetry {
+    int   num_particles = 0;
+    float ess           = 0.0f;   // effective sample size before resampling
+    int   occupied_bins = 0;      // KLD bins after the last resample (0 if KLD off)
+};
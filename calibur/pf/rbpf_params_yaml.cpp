@@ -0,0 +1,110 @@
+// rbpf_params_yaml.cpp
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "rbpf_params_yaml.hpp"
+
+namespace {
+
+struct ParamField {
+    const char *key;
+    size_t      offset;   // into RBPFParams
+    int         count;
+};
+
+const ParamField kFields[] = {
+    {"q_pos",          offsetof(RBPFParams, Q_pos_diag),     3},
+    {"q_yaw",          offsetof(RBPFParams, Q_yaw),          1},
+    {"q_acc",          offsetof(RBPFParams, Q_acc_diag),     3},
+    {"q_yawalpha",     offsetof(RBPFParams, Q_yawalpha),     1},
+    {"q_vel",          offsetof(RBPFParams, Q_vel_diag),     4},
+    {"q_geom",         offsetof(RBPFParams, Q_geom_diag),    3},
+    {"rz_pos",         offsetof(RBPFParams, Rz_pos_diag),    3},
+    {"rz_yaw",         offsetof(RBPFParams, Rz_yaw),         1},
+    {"ry_vel",         offsetof(RBPFParams, Ry_vel_diag),    3},
+    {"ry_yawr",        offsetof(RBPFParams, Ry_yawr),        1},
+    {"rc_geom",        offsetof(RBPFParams, Rc_geom_diag),   3},
+    {"init_vel_std",   offsetof(RBPFParams, init_vel_std),   4},
+    {"init_geom_mean", offsetof(RBPFParams, init_geom_mean), 3},
+    {"init_geom_std",  offsetof(RBPFParams, init_geom_std),  3},
+};
+
+float *field_ptr(RBPFParams &p, const ParamField &f) {
+    return reinterpret_cast<float *>(reinterpret_cast<char *>(&p) + f.offset);
+}
+
+} // namespace
+
+bool rbpf_params_from_yaml(const YAML::Node &node, RBPFParams &p) {
+    if (!node || !node.IsMap()) return false;
+
+    RBPFParams out = p;
+    try {
+        for (const ParamField &f : kFields) {
+            const YAML::Node v = node[f.key];
+            if (!v) continue;
+            float *dst = field_ptr(out, f);
+            if (f.count == 1) {
+                dst[0] = v.as<float>();
+            } else if (v.IsScalar()) {
+                // one value for every axis
+                for (int k = 0; k < f.count; ++k) dst[k] = v.as<float>();
+            } else {
+                if (!v.IsSequence() || int(v.size()) != f.count) {
+                    std::cerr << "[PF] params: '" << f.key << "' needs " << f.count
+                              << " values\n";
+                    return false;
+                }
+                for (int k = 0; k < f.count; ++k) dst[k] = v[k].as<float>();
+            }
+        }
+    } catch (const YAML::Exception &e) {
+        std::cerr << "[PF] params: " << e.what() << "\n";
+        return false;
+    }
+    p = out;
+    return true;
+}
+
+YAML::Node rbpf_params_to_yaml(const RBPFParams &p) {
+    RBPFParams tmp = p;
+    YAML::Node node;
+    for (const ParamField &f : kFields) {
+        const float *src = field_ptr(tmp, f);
+        if (f.count == 1) {
+            node[f.key] = src[0];
+        } else {
+            YAML::Node seq;
+            seq.SetStyle(YAML::EmitterStyle::Flow);
+            for (int k = 0; k < f.count; ++k) seq.push_back(src[k]);
+            node[f.key] = seq;
+        }
+    }
+    return node;
+}
+
+bool rbpf_params_load(const std::string &path, RBPFParams &p) {
+    std::ifstream in(path);
+    if (!in) return false;
+    try {
+        const YAML::Node root = YAML::Load(in);
+        return rbpf_params_from_yaml(root["rbpf"], p);
+    } catch (const YAML::Exception &e) {
+        std::cerr << "[PF] " << path << ": " << e.what() << "\n";
+        return false;
+    }
+}
+
+bool rbpf_params_save(const std::string &path, const RBPFParams &p, const std::string &header) {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    std::istringstream lines(header);
+    for (std::string line; std::getline(lines, line);) out << "# " << line << "\n";
+
+    YAML::Node root;
+    root["rbpf"] = rbpf_params_to_yaml(p);
+    out << root << "\n";
+    return bool(out);
+}
@@ -0,0 +1,27 @@
+// rbpf_params_yaml.hpp
+#pragma once
+
+#include <string>
+#include <yaml-cpp/yaml.h>
+#include "rbpf_params.hpp"
+
+// RBPFParams <-> YAML. The file has one top-level `rbpf:` map; each key is a
+// field of RBPFParams (lower case), per-axis fields are sequences:
+//
+//   rbpf:
+//     q_pos: [0.001, 0.001, 0.001]
+//     q_yaw: 0.05
+//     ...
+//
+// Keys that are missing keep the value already in `p`, so a file can
+// override a subset of default_params(). Written by the offline tuner
+// (pf_tune), read by PFWorker at startup.
+
+bool rbpf_params_from_yaml(const YAML::Node &node, RBPFParams &p);
+YAML::Node rbpf_params_to_yaml(const RBPFParams &p);
+
+// File helpers. load returns false (and leaves p untouched) if the file is
+// missing or malformed; header is written as leading '#' comment lines.
+bool rbpf_params_load(const std::string &path, RBPFParams &p);
+bool rbpf_params_save(const std::string &path, const RBPFParams &p,
+                      const std::string &header = "");
@@ -0,0 +1,141 @@
+// resample.cpp
+#include <algorithm>
+#include <vector>
+#include "resample.hpp"
+
+// ======================= SCAN ==========================
+
+// Exclusive Blelloch scan of one block (length SCAN_ELEMS_PER_BLOCK, zero padded)
+// in place; returns the block total. Mirrors scan_block_kernel in resample.cu.
+static float blelloch_block(float *t) {
+    constexpr int n = SCAN_ELEMS_PER_BLOCK;
+
+    int offset = 1;
+    for (int d = n >> 1; d > 0; d >>= 1) {          // up-sweep
+        for (int tid = 0; tid < d; ++tid) {
+            int ai = offset * (2 * tid + 1) - 1;
+            int bi = offset * (2 * tid + 2) - 1;
+            t[bi] += t[ai];
+        }
+        offset <<= 1;
+    }
+
+    float total = t[n - 1];
+    t[n - 1] = 0.0f;
+
+    for (int d = 1; d < n; d <<= 1) {               // down-sweep
+        offset >>= 1;
+        for (int tid = 0; tid < d; ++tid) {
+            int ai = offset * (2 * tid + 1) - 1;
+            int bi = offset * (2 * tid + 2) - 1;
+            float tmp = t[ai];
+            t[ai]  = t[bi];
+            t[bi] += tmp;
+        }
+    }
+    return total;
+}
+
+void cpu_inclusive_scan(const float *in, float *out, int N) {
+    if (N <= 0) return;
+
+    const int num_blocks = (N + SCAN_ELEMS_PER_BLOCK - 1) / SCAN_ELEMS_PER_BLOCK;
+    std::vector<float> block_sums(num_blocks);
+    float tile[SCAN_ELEMS_PER_BLOCK];
+
+    // 1) per-block inclusive scan
+    for (int b = 0; b < num_blocks; ++b) {
+        const int base = b * SCAN_ELEMS_PER_BLOCK;
+        const int len  = std::min(SCAN_ELEMS_PER_BLOCK, N - base);
+        for (int k = 0; k < SCAN_ELEMS_PER_BLOCK; ++k) {
+            tile[k] = (k < len) ? in[base + k] : 0.0f;
+        }
+        block_sums[b] = blelloch_block(tile);
+        for (int k = 0; k < len; ++k) {
+            out[base + k] = tile[k] + in[base + k];
+        }
+    }
+    if (num_blocks == 1) return;
+
+    // 2) scan of block totals, 3) add offsets
+    std::vector<float> block_cdf(num_blocks);
+    cpu_inclusive_scan(block_sums.data(), block_cdf.data(), num_blocks);
+    for (int b = 1; b < num_blocks; ++b) {
+        const int base = b * SCAN_ELEMS_PER_BLOCK;
+        const int len  = std::min(SCAN_ELEMS_PER_BLOCK, N - base);
+        const float add = block_cdf[b - 1];
+        for (int k = 0; k < len; ++k) out[base + k] += add;
+    }
+}
+
+// ======================= RESAMPLE ======================
+
+void cpu_resample_ancestors(const float *W, int N, int M,
+                            ResampleScheme scheme,
+                            uint64_t seed, uint32_t step,
+                            float *cdf, float *aux,
+                            int *ancestors)
+{
+    if (N <= 0 || M <= 0) return;
+
+    const float u = resample_uniform(seed, step, 0xFFFFFFFFu);
+
+    switch (scheme) {
+    case ResampleScheme::SYSTEMATIC: {
+        cpu_inclusive_scan(W, cdf, N);
+        const float total = cdf[N - 1];
+        const float scale = (total > 0.0f) ? float(M) / total : 0.0f;
+        for (int i = 0; i < N; ++i) systematic_fill(cdf, i, N, M, scale, u, ancestors);
+        break;
+    }
+    case ResampleScheme::STRATIFIED: {
+        cpu_inclusive_scan(W, cdf, N);
+        const float total = cdf[N - 1];
+        const float scale = (total > 0.0f) ? float(M) / total : 0.0f;
+        for (int i = 0; i < N; ++i) stratified_fill(cdf, i, N, M, scale, seed, step, ancestors);
+        break;
+    }
+    case ResampleScheme::RESIDUAL: {
+        // total weight first (same scan as the other schemes)
+        cpu_inclusive_scan(W, cdf, N);
+        const float total = cdf[N - 1];
+        const float scale = (total > 0.0f) ? float(M) / total : 0.0f;
+
+        // cdf <- n_i, aux <- residual, then scan both in place
+        for (int i = 0; i < N; ++i) {
+            const float nw = W[i] * scale;
+            const float n  = floorf(nw);
+            cdf[i] = n;
+            aux[i] = nw - n;
+        }
+        cpu_inclusive_scan(cdf, cdf, N);
+        cpu_inclusive_scan(aux, aux, N);
+        for (int i = 0; i < N; ++i) residual_fill(cdf, aux, i, N, M, u, ancestors);
+        break;
+    }
+    }
+}
+
+void cpu_resample_binary_search(const float *W, int N, float u,
+                                float *cdf, int *ancestors)
+{
+    if (N <= 0) return;
+
+    float c = 0.0f;
+    for (int i = 0; i < N; ++i) {
+        c += W[i];
+        cdf[i] = c;
+    }
+    const float inv_total = (c > 0.0f) ? 1.0f / c : 0.0f;
+
+    for (int j = 0; j < N; ++j) {
+        const float x = (float(j) + u) / float(N);
+        int lo = 0, hi = N - 1;
+        while (lo < hi) {
+            int mid = (lo + hi) >> 1;
+            if (cdf[mid] * inv_total >= x) hi = mid;
+            else                           lo = mid + 1;
+        }
+        ancestors[j] = lo;
+    }
+}
@@ -0,0 +1,185 @@
+// resample.cu
+#include <cuda_runtime.h>
+#include <cstdio>
+#include "resample.cuh"
+
+// ======================= SCAN KERNELS ==================
+
+// Blelloch scan of SCAN_ELEMS_PER_BLOCK elements per block. Writes the
+// *inclusive* result to out (in == out is allowed) and the block total to
+// block_sums[blockIdx.x] when block_sums != nullptr.
+__global__ void scan_block_kernel(const float *in, float *out, int N, float *block_sums) {
+    __shared__ float t[SCAN_ELEMS_PER_BLOCK];
+
+    const int tid  = threadIdx.x;
+    const int base = blockIdx.x * SCAN_ELEMS_PER_BLOCK;
+    const int ia   = base + 2 * tid;
+    const int ib   = ia + 1;
+
+    const float va = (ia < N) ? in[ia] : 0.0f;
+    const float vb = (ib < N) ? in[ib] : 0.0f;
+    t[2 * tid]     = va;
+    t[2 * tid + 1] = vb;
+
+    // up-sweep
+    int offset = 1;
+    for (int d = SCAN_ELEMS_PER_BLOCK >> 1; d > 0; d >>= 1) {
+        __syncthreads();
+        if (tid < d) {
+            int ai = offset * (2 * tid + 1) - 1;
+            int bi = offset * (2 * tid + 2) - 1;
+            t[bi] += t[ai];
+        }
+        offset <<= 1;
+    }
+
+    if (tid == 0) {
+        if (block_sums) block_sums[blockIdx.x] = t[SCAN_ELEMS_PER_BLOCK - 1];
+        t[SCAN_ELEMS_PER_BLOCK - 1] = 0.0f;
+    }
+
+    // down-sweep
+    for (int d = 1; d < SCAN_ELEMS_PER_BLOCK; d <<= 1) {
+        offset >>= 1;
+        __syncthreads();
+        if (tid < d) {
+            int ai = offset * (2 * tid + 1) - 1;
+            int bi = offset * (2 * tid + 2) - 1;
+            float tmp = t[ai];
+            t[ai]  = t[bi];
+            t[bi] += tmp;
+        }
+    }
+    __syncthreads();
+
+    // exclusive -> inclusive
+    if (ia < N) out[ia] = t[2 * tid]     + va;
+    if (ib < N) out[ib] = t[2 * tid + 1] + vb;
+}
+
+// out[i] += block_cdf[b - 1] for every block b > 0
+__global__ void scan_add_offsets_kernel(float *out, int N, const float *block_cdf) {
+    const int b = blockIdx.x + 1;
+    const int i = b * SCAN_ELEMS_PER_BLOCK + threadIdx.x;
+    const float add = block_cdf[b - 1];
+    if (i < N)                   out[i]                   += add;
+    if (i + SCAN_BLOCK_SIZE < N) out[i + SCAN_BLOCK_SIZE] += add;
+}
+
+// ======================= RESAMPLE KERNELS ==============
+
+// M / total weight, total read from the last cdf entry
+__device__ inline float weight_scale(const float *cdf, int N, int M) {
+    const float total = cdf[N - 1];
+    return (total > 0.0f) ? float(M) / total : 0.0f;
+}
+
+__global__ void systematic_fill_kernel(const float *cdf, int N, int M, float u, int *ancestors) {
+    int i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= N) return;
+    systematic_fill(cdf, i, N, M, weight_scale(cdf, N, M), u, ancestors);
+}
+
+__global__ void stratified_fill_kernel(const float *cdf, int N, int M,
+                                       uint64_t seed, uint32_t step, int *ancestors) {
+    int i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= N) return;
+    stratified_fill(cdf, i, N, M, weight_scale(cdf, N, M), seed, step, ancestors);
+}
+
+// W, total (from cdf) -> n_i into counts, residual into resid
+__global__ void residual_split_kernel(const float *W, const float *cdf, int N, int M,
+                                      float *counts, float *resid) {
+    int i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= N) return;
+    const float nw = W[i] * weight_scale(cdf, N, M);
+    const float n  = floorf(nw);
+    counts[i] = n;
+    resid[i]  = nw - n;
+}
+
+__global__ void residual_fill_kernel(const float *n_cdf, const float *r_cdf, int N, int M,
+                                     float u, int *ancestors) {
+    int i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= N) return;
+    residual_fill(n_cdf, r_cdf, i, N, M, u, ancestors);
+}
+
+// ======================= HOST API ======================
+
+void resample_workspace_alloc(ResampleWorkspace &ws, int N) {
+    ws.N = N;
+    cudaMalloc(&ws.cdf,        size_t(N) * sizeof(float));
+    cudaMalloc(&ws.aux,        size_t(N) * sizeof(float));
+    cudaMalloc(&ws.resid,      size_t(N) * sizeof(float));
+    cudaMalloc(&ws.block_sums, size_t(2 * SCAN_ELEMS_PER_BLOCK) * sizeof(float));
+    cudaMalloc(&ws.ancestors,  size_t(N) * sizeof(int));
+}
+
+void resample_workspace_free(ResampleWorkspace &ws) {
+    cudaFree(ws.cdf);
+    cudaFree(ws.aux);
+    cudaFree(ws.resid);
+    cudaFree(ws.block_sums);
+    cudaFree(ws.ancestors);
+    ws = ResampleWorkspace{};
+}
+
+void gpu_inclusive_scan(const float *d_in, float *d_out, int N,
+                        float *d_block_sums, cudaStream_t stream)
+{
+    if (N <= 0) return;
+    const int num_blocks = (N + SCAN_ELEMS_PER_BLOCK - 1) / SCAN_ELEMS_PER_BLOCK;
+
+    if (num_blocks == 1) {
+        scan_block_kernel<<<1, SCAN_BLOCK_SIZE, 0, stream>>>(d_in, d_out, N, nullptr);
+        return;
+    }
+    if (num_blocks > SCAN_ELEMS_PER_BLOCK) {
+        std::fprintf(stderr, "[RESAMPLE] gpu_inclusive_scan: N=%d exceeds two-level limit\n", N);
+        return;
+    }
+
+    scan_block_kernel<<<num_blocks, SCAN_BLOCK_SIZE, 0, stream>>>(d_in, d_out, N, d_block_sums);
+    scan_block_kernel<<<1, SCAN_BLOCK_SIZE, 0, stream>>>(d_block_sums, d_block_sums, num_blocks, nullptr);
+    scan_add_offsets_kernel<<<num_blocks - 1, SCAN_BLOCK_SIZE, 0, stream>>>(d_out, N, d_block_sums);
+}
+
+void gpu_resample_ancestors(const float *d_W, int N, int M,
+                            ResampleScheme scheme,
+                            uint64_t seed, uint32_t step,
+                            ResampleWorkspace &ws,
+                            cudaStream_t stream)
+{
+    if (N <= 0 || M <= 0) return;
+    if (N > ws.N || M > ws.N) {
+        std::fprintf(stderr, "[RESAMPLE] gpu_resample_ancestors: N=%d M=%d exceed workspace %d\n",
+                     N, M, ws.N);
+        return;
+    }
+
+    const int block = SCAN_BLOCK_SIZE;
+    const int grid  = (N + block - 1) / block;
+    const float u   = resample_uniform(seed, step, 0xFFFFFFFFu);
+
+    gpu_inclusive_scan(d_W, ws.cdf, N, ws.block_sums, stream);
+
+    switch (scheme) {
+    case ResampleScheme::SYSTEMATIC:
+        systematic_fill_kernel<<<grid, block, 0, stream>>>(ws.cdf, N, M, u, ws.ancestors);
+        break;
+
+    case ResampleScheme::STRATIFIED:
+        stratified_fill_kernel<<<grid, block, 0, stream>>>(ws.cdf, N, M, seed, step, ws.ancestors);
+        break;
+
+    case ResampleScheme::RESIDUAL:
+        // counts -> aux, residuals -> resid (cdf still holds the total), then
+        // scan both in place and fill deterministic + residual slots
+        residual_split_kernel<<<grid, block, 0, stream>>>(d_W, ws.cdf, N, M, ws.aux, ws.resid);
+        gpu_inclusive_scan(ws.aux,   ws.aux,   N, ws.block_sums, stream);
+        gpu_inclusive_scan(ws.resid, ws.resid, N, ws.block_sums, stream);
+        residual_fill_kernel<<<grid, block, 0, stream>>>(ws.aux, ws.resid, N, M, u, ws.ancestors);
+        break;
+    }
+}
@@ -0,0 +1,31 @@
+// resample.cuh
+#pragma once
+
+#include <cuda_runtime.h>
+#include "resample.hpp"
+
+// Device scratch for gpu_resample_ancestors (allocated once per filter).
+struct ResampleWorkspace {
+    int    N           = 0;        // capacity (max particles)
+    float *cdf         = nullptr;  // [N]  weight CDF
+    float *aux         = nullptr;  // [N]  residual: scan of deterministic copy counts
+    float *resid       = nullptr;  // [N]  residual: scan of fractional weights
+    float *block_sums  = nullptr;  // [2 * SCAN_ELEMS_PER_BLOCK] per-level block totals
+    int   *ancestors   = nullptr;  // [N]
+};
+
+void resample_workspace_alloc(ResampleWorkspace &ws, int N);
+void resample_workspace_free(ResampleWorkspace &ws);
+
+// Work-efficient (Blelloch) inclusive scan, in-place safe.
+// Supports N <= SCAN_ELEMS_PER_BLOCK^2 (262144) with two levels.
+void gpu_inclusive_scan(const float *d_in, float *d_out, int N,
+                        float *d_block_sums, cudaStream_t stream);
+
+// N weights -> M entries of ws.ancestors, fully on device (no host sync).
+// N, M <= ws.N.
+void gpu_resample_ancestors(const float *d_W, int N, int M,
+                            ResampleScheme scheme,
+                            uint64_t seed, uint32_t step,
+                            ResampleWorkspace &ws,
+                            cudaStream_t stream);
@@ -0,0 +1,134 @@
+// resample.hpp
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+
+// Shared host/device helpers for particle resampling.
+//
+// The resampler never copies particle state itself: it turns normalized (or
+// unnormalized) weights into an ancestor index per output slot. The caller then
+// gathers particles into its back buffer and swaps front/back pointers.
+//
+// All three schemes are O(N) after the prefix sum: every *source* particle i
+// owns a contiguous range of output slots, computed from cdf[i-1] and cdf[i]
+// only, so no per-slot binary search is needed.
+//
+// N source particles are resampled into M output slots; M != N lets the
+// filter grow or shrink its particle set (KLD-sampling) in the same pass.
+
+#ifndef PF_HD
+#ifdef __CUDACC__
+#define PF_HD __host__ __device__
+#else
+#define PF_HD
+#endif
+#endif
+
+enum class ResampleScheme {
+    SYSTEMATIC = 0,
+    STRATIFIED = 1,
+    RESIDUAL   = 2
+};
+
+constexpr int SCAN_BLOCK_SIZE      = 256;                  // threads per scan block
+constexpr int SCAN_ELEMS_PER_BLOCK = 2 * SCAN_BLOCK_SIZE;  // each thread owns 2 elements
+
+// ======================= RNG ==========================
+
+// Stateless uniform in [0, 1) keyed by (seed, step, i) (splitmix64 finalizer).
+PF_HD inline float resample_uniform(uint64_t seed, uint32_t step, uint32_t i) {
+    uint64_t z = seed
+               + 0x9E3779B97F4A7C15ULL * (static_cast<uint64_t>(step) + 1ULL)
+               + 0xBF58476D1CE4E5B9ULL * (static_cast<uint64_t>(i) + 1ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z =  z ^ (z >> 31);
+    // top 24 bits -> exactly representable float in [0, 1)
+    return static_cast<float>(z >> 40) * (1.0f / 16777216.0f);
+}
+
+// ======================= SLOT RANGES ==================
+
+// First output slot j with (j + u) > s, i.e. floor(s - u) + 1, clamped to [0, M].
+PF_HD inline int systematic_slot(float s, float u, int M) {
+    int j = static_cast<int>(floorf(s - u)) + 1;
+    return j < 0 ? 0 : (j > M ? M : j);
+}
+
+// Systematic: source i (of N) owns slots j (of M) with s_prev < j + u <= s_i,
+// where s = cdf * scale (scale = M / total weight). Neighbouring particles
+// evaluate the same expression on the same cdf value, so ranges tile [0, M).
+PF_HD inline void systematic_span(const float *cdf, int i, int N, int M,
+                                  float scale, float u, int &lo, int &hi) {
+    lo = (i == 0)     ? 0 : systematic_slot(cdf[i - 1] * scale, u, M);
+    hi = (i == N - 1) ? M : systematic_slot(cdf[i]     * scale, u, M);
+}
+
+PF_HD inline void systematic_fill(const float *cdf, int i, int N, int M,
+                                  float scale, float u, int *ancestors) {
+    int lo, hi;
+    systematic_span(cdf, i, N, M, scale, u, lo, hi);
+    for (int j = lo; j < hi; ++j) ancestors[j] = i;
+}
+
+// Stratified: slot k draws t_k = k + U_k. Source i owns t_k in (s_prev, s_i].
+// Only strata overlapping [s_prev, s_i] (+-1 for rounding) are checked, so the
+// total work over all i is still O(N).
+PF_HD inline void stratified_fill(const float *cdf, int i, int N, int M, float scale,
+                                  uint64_t seed, uint32_t step, int *ancestors) {
+    const float s_prev = (i == 0)     ? -1.0f           : cdf[i - 1] * scale;
+    const float s_cur  = (i == N - 1) ? float(M) + 1.0f : cdf[i]     * scale;
+
+    int k0 = static_cast<int>(floorf(s_prev)) - 1;
+    int k1 = static_cast<int>(floorf(s_cur))  + 1;
+    if (k0 < 0)     k0 = 0;
+    if (k1 > M - 1) k1 = M - 1;
+
+    for (int k = k0; k <= k1; ++k) {
+        const float t = float(k) + resample_uniform(seed, step, uint32_t(k));
+        if (s_prev < t && t <= s_cur) ancestors[k] = i;
+    }
+}
+
+// Residual: n_i = floor(M * w_i) deterministic copies, then the remaining
+// R = M - sum(n) slots are filled systematically from the residual weights.
+//   n_cdf : inclusive scan of n
+//   r_cdf : inclusive scan of residuals (M * w_i - n_i)
+PF_HD inline void residual_fill(const float *n_cdf, const float *r_cdf, int i, int N, int M,
+                                float u, int *ancestors) {
+    const float n_prev = (i == 0) ? 0.0f : n_cdf[i - 1];
+    const int   off    = static_cast<int>(n_prev);
+    const int   n_i    = static_cast<int>(n_cdf[i] - n_prev);
+
+    for (int j = off; j < off + n_i && j < M; ++j) ancestors[j] = i;
+
+    const int   S_n    = static_cast<int>(n_cdf[N - 1]);
+    const int   R      = M - S_n;
+    const float r_tot  = r_cdf[N - 1];
+    if (R <= 0 || !(r_tot > 0.0f)) return;
+
+    int lo, hi;
+    systematic_span(r_cdf, i, N, R, float(R) / r_tot, u, lo, hi);
+    for (int j = S_n + lo; j < S_n + hi && j < M; ++j) ancestors[j] = i;
+}
+
+// ======================= CPU PATH =====================
+
+// Inclusive prefix sum using the same blocked Blelloch up/down-sweep as the GPU
+// kernel, so CPU and GPU produce the same float summation order.
+void cpu_inclusive_scan(const float *in, float *out, int N);
+
+// N weights -> M ancestors. `cdf` and `aux` are caller scratch of N floats
+// each (aux is only touched by RESIDUAL), `ancestors` holds M ints. Weights
+// need not be normalized.
+void cpu_resample_ancestors(const float *W, int N, int M,
+                            ResampleScheme scheme,
+                            uint64_t seed, uint32_t step,
+                            float *cdf, float *aux,
+                            int *ancestors);
+
+// Reference: sequential CDF + per-slot binary search (the previous GPU
+// algorithm), slot j at (j + u) / N. Kept for tests and benchmarks.
+void cpu_resample_binary_search(const float *W, int N, float u,
+                                float *cdf, int *ancestors);
@@ -0,0 +1,38 @@
+// tracker.hpp
+#pragma once
+
+#include "rbpf_params.hpp"
+#include "posterior.hpp"
+
+// Common interface of the target trackers PFWorker can run (RBPF on GPU or
+// CPU, EKF). Measurements and estimates are laid out like the 15-dim state
+// (state_index.hpp); a measurement carries pos, yaw and [r1, r2, h], the same
+// fields rbpf_step consumes.
+//
+// Every tracker is also an OOSM backend (oosm.hpp): checkpoint slots
+// 0..num_slots-1 are allocated when the tracker is constructed.
+
+enum class TrackerKind {
+    RBPF = 0,
+    EKF  = 1
+};
+
+class Tracker {
+public:
+    virtual ~Tracker() = default;
+
+    virtual const char *name() const = 0;
+
+    virtual void reset(const float *z) = 0;
+    virtual void step(const float *z, float dt) = 0;
+
+    // Estimate readback; completes asynchronously on the GPU, so callers
+    // request once and poll until it lands.
+    virtual void request_estimate() = 0;
+    virtual bool poll_estimate(PosteriorSummary &out) = 0;
+
+    virtual RBPFTelemetry telemetry() = 0;
+
+    virtual void checkpoint_save(int slot) = 0;
+    virtual void checkpoint_restore(int slot) = 0;
+};
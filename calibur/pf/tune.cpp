@@ -0,0 +1,310 @@
+// tune.cpp
+#include "tune.hpp"
+#include "rbpf_cpu.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <random>
+#include <thread>
+
+// ===================== Search space =====================
+
+// Noise constants span two decades either side of the hand-tuned defaults;
+// the init spreads get plain physical ranges.
+static const TuneDim kSpace[TUNE_DIMS] = {
+    {"Q_POS_DIFFUSION",     Q_POS_DIFFUSION     * 0.1f, Q_POS_DIFFUSION     * 10.0f, true},
+    {"Q_YAW_DIFFUSION",     Q_YAW_DIFFUSION     * 0.1f, Q_YAW_DIFFUSION     * 10.0f, true},
+    {"Q_ACC_RANDOMWALK",    Q_ACC_RANDOMWALK    * 0.1f, Q_ACC_RANDOMWALK    * 10.0f, true},
+    {"Q_YAWACC_RANDOMWALK", Q_YAWACC_RANDOMWALK * 0.1f, Q_YAWACC_RANDOMWALK * 10.0f, true},
+    {"Q_VEL_DIFFUSION",     Q_VEL_DIFFUSION     * 0.1f, Q_VEL_DIFFUSION     * 10.0f, true},
+    {"Q_YAWRATE_DIFFUSION", Q_YAWRATE_DIFFUSION * 0.1f, Q_YAWRATE_DIFFUSION * 10.0f, true},
+    {"Q_GEOM_DRIFT",        Q_GEOM_DRIFT        * 0.1f, Q_GEOM_DRIFT        * 10.0f, true},
+    {"RZ_POS_NOISE",        RZ_POS_NOISE        * 0.1f, RZ_POS_NOISE        * 10.0f, true},
+    {"RZ_YAW_NOISE",        RZ_YAW_NOISE        * 0.1f, RZ_YAW_NOISE        * 10.0f, true},
+    {"RY_VEL_NOISE",        RY_VEL_NOISE        * 0.1f, RY_VEL_NOISE        * 10.0f, true},
+    {"RY_YAWR_NOISE",       RY_YAWR_NOISE       * 0.1f, RY_YAWR_NOISE       * 10.0f, true},
+    {"RC_GEOM_NOISE",       RC_GEOM_NOISE       * 0.1f, RC_GEOM_NOISE       * 10.0f, true},
+    {"INIT_VEL_STD",        0.05f,  1.0f, true},
+    {"INIT_GEOM_STD_R",     0.005f, 0.2f, true},
+    {"INIT_GEOM_STD_H",     0.005f, 0.2f, true},
+};
+
+const TuneDim *tune_space() { return kSpace; }
+
+static float dim_decode(const TuneDim &d, float u) {
+    u = std::min(std::max(u, 0.0f), 1.0f);
+    if (d.log_scale) return d.lo * std::pow(d.hi / d.lo, u);
+    return d.lo + (d.hi - d.lo) * u;
+}
+
+static float dim_encode(const TuneDim &d, float v) {
+    float u = d.log_scale ? std::log(std::max(v, 1e-30f) / d.lo) / std::log(d.hi / d.lo)
+                          : (v - d.lo) / (d.hi - d.lo);
+    return std::min(std::max(u, 0.0f), 1.0f);
+}
+
+// Per-axis diagonals are tuned as one value (the defaults are isotropic too).
+void tune_apply(const TunePoint &u, RBPFParams &p) {
+    float v[TUNE_DIMS];
+    for (int i = 0; i < TUNE_DIMS; ++i) v[i] = dim_decode(kSpace[i], u[i]);
+
+    for (int k = 0; k < 3; ++k) p.Q_pos_diag[k] = v[0];
+    p.Q_yaw = v[1];
+    for (int k = 0; k < 3; ++k) p.Q_acc_diag[k] = v[2];
+    p.Q_yawalpha = v[3];
+    for (int k = 0; k < 3; ++k) p.Q_vel_diag[k] = v[4];
+    p.Q_vel_diag[3] = v[5];
+    for (int k = 0; k < 3; ++k) p.Q_geom_diag[k] = v[6];
+    for (int k = 0; k < 3; ++k) p.Rz_pos_diag[k] = v[7];
+    p.Rz_yaw = v[8];
+    for (int k = 0; k < 3; ++k) p.Ry_vel_diag[k] = v[9];
+    p.Ry_yawr = v[10];
+    for (int k = 0; k < 3; ++k) p.Rc_geom_diag[k] = v[11];
+    for (int k = 0; k < 4; ++k) p.init_vel_std[k] = v[12];
+    p.init_geom_std[0] = p.init_geom_std[1] = v[13];
+    p.init_geom_std[2] = v[14];
+}
+
+TunePoint tune_encode(const RBPFParams &p) {
+    const float v[TUNE_DIMS] = {
+        p.Q_pos_diag[0], p.Q_yaw, p.Q_acc_diag[0], p.Q_yawalpha,
+        p.Q_vel_diag[0], p.Q_vel_diag[3], p.Q_geom_diag[0],
+        p.Rz_pos_diag[0], p.Rz_yaw, p.Ry_vel_diag[0], p.Ry_yawr, p.Rc_geom_diag[0],
+        p.init_vel_std[0], p.init_geom_std[0], p.init_geom_std[2],
+    };
+    TunePoint u;
+    for (int i = 0; i < TUNE_DIMS; ++i) u[i] = dim_encode(kSpace[i], v[i]);
+    return u;
+}
+
+// ===================== Scoring ==========================
+
+// Diverged filters produce NaN / huge errors; cap them so one bad track
+// cannot swamp the RMSE of a whole log.
+constexpr double kMaxError = 1.0;   // m
+
+static double pos_error(const float *X, const float *z) {
+    const double dx = X[IDX_TX] - z[IDX_TX];
+    const double dy = X[IDX_TY] - z[IDX_TY];
+    const double dz = X[IDX_TZ] - z[IDX_TZ];
+    const double e = std::sqrt(dx * dx + dy * dy + dz * dz);
+    return std::isfinite(e) ? std::min(e, kMaxError) : kMaxError;
+}
+
+TuneScore tune_evaluate(const std::vector<DetectionLog> &logs, const RBPFParams &p,
+                        const TuneOptions &opt) {
+    struct Pending { double t; float X[D]; };
+
+    RBPFPosYawModelCPU pf(opt.num_particles, p, opt.seed);
+    PosteriorSummary   post;
+    std::deque<Pending> pending;
+
+    TuneScore s;
+    double se_track = 0.0, se_pred = 0.0;
+    int hits = 0;
+
+    for (const DetectionLog &log : logs) {
+        if (log.empty()) continue;
+        s.log_seconds += log.back().t - log.front().t;
+
+        bool   live = false;
+        double t_prev = 0.0;
+        int    since_reset = 0;
+
+        for (const DetectionRecord &r : log) {
+            const double dt = r.t - t_prev;
+            if (live && dt < opt.min_dt) continue;
+
+            if (!live || dt > opt.max_coast) {
+                pf.reset(r.z);
+                pf.summary(post);
+                pending.clear();
+                live = true;
+                t_prev = r.t;
+                since_reset = 0;
+                continue;
+            }
+
+            const bool scored = ++since_reset > opt.warmup_steps;
+
+            // one-step prediction from the previous posterior
+            if (scored) {
+                float Xp[D];
+                rbpf_extrapolate_state(post.mean, float(dt), Xp);
+                const double e = pos_error(Xp, r.z);
+                se_track += e * e;
+                ++s.steps;
+            }
+
+            // horizon predictions that have come due
+            while (!pending.empty() && r.t >= pending.front().t + opt.horizon) {
+                const Pending &q = pending.front();
+                float Xp[D];
+                rbpf_extrapolate_state(q.X, float(r.t - q.t), Xp);
+                const double e = pos_error(Xp, r.z);
+                se_pred += e * e;
+                hits += e < opt.hit_radius;
+                ++s.predictions;
+                pending.pop_front();
+            }
+
+            pf.step(r.z, float(dt));
+            t_prev = r.t;
+
+            pf.summary(post);
+            if (scored) {
+                pending.emplace_back();
+                pending.back().t = r.t;
+                std::copy(post.mean, post.mean + D, pending.back().X);
+            }
+        }
+        pending.clear();
+    }
+
+    s.track_rmse = s.steps       ? std::sqrt(se_track / s.steps)      : kMaxError;
+    s.pred_rmse  = s.predictions ? std::sqrt(se_pred / s.predictions) : kMaxError;
+    s.hit_rate   = s.predictions ? double(hits) / s.predictions       : 0.0;
+    s.loss = (1.0 - s.hit_rate) + opt.rmse_weight * s.track_rmse;
+    return s;
+}
+
+// ===================== Search ===========================
+
+namespace {
+
+// Independent per-dimension Parzen estimator over points in [0, 1]: one
+// Gaussian per observation plus a uniform prior component, bandwidth from
+// Scott's rule with a floor so a tight cluster still explores.
+struct Parzen {
+    std::vector<float> mu;
+    float sigma;
+
+    explicit Parzen(std::vector<float> x) : mu(std::move(x)) {
+        const int n = int(mu.size());
+        double m = 0.0, v = 0.0;
+        for (float a : mu) m += a;
+        m /= std::max(n, 1);
+        for (float a : mu) v += (a - m) * (a - m);
+        const double sd = n > 1 ? std::sqrt(v / (n - 1)) : 0.5;
+        sigma = float(std::min(std::max(1.06 * sd * std::pow(std::max(n, 1), -0.2), 0.03), 0.5));
+    }
+
+    double pdf(float x) const {
+        const double inv = 1.0 / (sigma * std::sqrt(2.0 * M_PI));
+        double acc = 1.0;                              // uniform prior on [0, 1]
+        for (float m : mu) {
+            const double d = (x - m) / sigma;
+            acc += inv * std::exp(-0.5 * d * d);
+        }
+        return acc / (mu.size() + 1);
+    }
+
+    float sample(std::mt19937_64 &rng) const {
+        std::uniform_int_distribution<int> pick(0, int(mu.size()));
+        std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+        const int k = pick(rng);
+        if (k == int(mu.size())) return uni(rng);      // prior component
+        std::normal_distribution<float> nd(mu[k], sigma);
+        for (int tries = 0; tries < 16; ++tries) {     // truncate to [0, 1]
+            const float x = nd(rng);
+            if (x >= 0.0f && x <= 1.0f) return x;
+        }
+        return std::min(std::max(mu[k], 0.0f), 1.0f);
+    }
+};
+
+TunePoint random_point(std::mt19937_64 &rng) {
+    std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+    TunePoint u;
+    for (float &x : u) x = uni(rng);
+    return u;
+}
+
+TunePoint tpe_propose(const std::vector<TuneTrial> &hist, const TuneSearch &search,
+                      std::mt19937_64 &rng) {
+    std::vector<int> order(hist.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = int(i);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return hist[a].score.loss < hist[b].score.loss;
+    });
+    const int n_good = std::max(1, int(std::ceil(search.gamma * hist.size())));
+
+    std::vector<Parzen> good, bad;
+    for (int d = 0; d < TUNE_DIMS; ++d) {
+        std::vector<float> g, b;
+        for (size_t i = 0; i < order.size(); ++i)
+            (int(i) < n_good ? g : b).push_back(hist[order[i]].u[d]);
+        good.emplace_back(std::move(g));
+        bad.emplace_back(std::move(b));
+    }
+
+    TunePoint best{};
+    double best_ei = -INFINITY;
+    for (int c = 0; c < search.candidates; ++c) {
+        TunePoint u;
+        double ei = 0.0;                               // log l(x) - log g(x)
+        for (int d = 0; d < TUNE_DIMS; ++d) {
+            u[d] = good[d].sample(rng);
+            ei += std::log(good[d].pdf(u[d])) - std::log(bad[d].pdf(u[d]));
+        }
+        if (ei > best_ei) { best_ei = ei; best = u; }
+    }
+    return best;
+}
+
+} // namespace
+
+std::vector<TuneTrial> tune_run(const std::vector<DetectionLog> &logs,
+                                const RBPFParams &base,
+                                const TuneSearch &search, const TuneOptions &opt,
+                                const std::function<void(int, const TuneTrial &)> &progress) {
+    std::mt19937_64 rng(search.seed);
+    std::vector<TuneTrial> hist;
+    hist.reserve(search.trials);
+
+    int threads = search.threads > 0 ? search.threads
+                                     : int(std::thread::hardware_concurrency());
+    threads = std::max(threads, 1);
+    const int batch = search.batch > 0 ? search.batch : threads;
+
+    while (int(hist.size()) < search.trials) {
+        const int first = int(hist.size());
+        const int n = std::min(batch, search.trials - first);
+
+        // propose the whole round up front, from finished trials only
+        std::vector<TuneTrial> round(n);
+        for (int i = 0; i < n; ++i) {
+            TuneTrial &t = round[i];
+            const int idx = first + i;
+            if (idx == 0) {
+                t.u = tune_encode(base);
+                t.params = base;                       // exact, not re-decoded
+                continue;
+            }
+            const bool use_tpe = search.method == TuneMethod::TPE &&
+                                 first >= std::max(search.startup, 2);
+            t.u = use_tpe ? tpe_propose(hist, search, rng) : random_point(rng);
+            t.params = base;
+            tune_apply(t.u, t.params);
+        }
+
+        std::atomic<int> next{0};
+        auto work = [&]() {
+            for (int i; (i = next.fetch_add(1)) < n; )
+                round[i].score = tune_evaluate(logs, round[i].params, opt);
+        };
+        const int nt = std::min(threads, n);
+        std::vector<std::thread> pool;
+        for (int k = 1; k < nt; ++k) pool.emplace_back(work);
+        work();
+        for (std::thread &th : pool) th.join();
+
+        for (int i = 0; i < n; ++i) {
+            hist.push_back(round[i]);
+            if (progress) progress(first + i, hist.back());
+        }
+    }
+    return hist;
+}
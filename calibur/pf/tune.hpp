@@ -0,0 +1,100 @@
+// tune.hpp
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "rbpf_params.hpp"
+#include "detection_log.hpp"
+
+// Offline parameter search for the RBPF (pf_tune). Every trial replays the
+// recorded detection logs through the CPU backend (RBPFPosYawModelCPU) and is
+// scored on what the aiming pipeline needs:
+//   - track RMSE: one-step prediction of each detection from the previous
+//     posterior (the innovation), metres
+//   - hit rate:   the posterior extrapolated `horizon` seconds ahead lands
+//     within `hit_radius` of the detection recorded at that time
+// loss = (1 - hit_rate) + rmse_weight * track_rmse, lower is better.
+//
+// The search runs in the unit cube over TUNE_DIMS scalars (log-scaled for the
+// noise constants of rbpf_params.hpp), either pure random or TPE (a
+// tree-structured Parzen estimator, the Bayesian optimiser of hyperopt),
+// evaluating a batch of candidates in parallel per round.
+
+// ===================== Search space =====================
+
+struct TuneDim {
+    const char *name;       // rbpf_params.hpp constant it replaces
+    float lo, hi;
+    bool  log_scale;
+};
+
+constexpr int TUNE_DIMS = 15;
+using TunePoint = std::array<float, TUNE_DIMS>;   // each coordinate in [0, 1]
+
+const TuneDim *tune_space();
+void tune_apply(const TunePoint &u, RBPFParams &p);          // unit cube -> params
+TunePoint tune_encode(const RBPFParams &p);                  // params -> unit cube (clamped)
+
+// ===================== Scoring ==========================
+
+struct TuneOptions {
+    int   num_particles = 1000;
+    float hit_radius    = 0.065f;   // m, half the armor plate (WIDTH_TOLERANCE / 2)
+    float horizon       = 0.15f;    // s, look-ahead scored for hits (~bullet flight)
+    float max_coast     = 0.3f;     // s, a larger gap is a track loss (PFWorker::kMaxCoast)
+    float min_dt        = 1e-4f;    // s, duplicate timestamps are skipped
+    int   warmup_steps  = 10;       // steps after each (re)init that are not scored
+    float rmse_weight   = 1.0f;     // per metre of track RMSE
+    uint64_t seed       = 1234ULL;  // filter seed, the same for every trial
+};
+
+struct TuneScore {
+    double loss        = 0.0;
+    double hit_rate    = 0.0;
+    double track_rmse  = 0.0;       // m
+    double pred_rmse   = 0.0;       // m, at the horizon
+    int    steps       = 0;         // scored filter steps
+    int    predictions = 0;         // scored horizon predictions
+    double log_seconds = 0.0;       // recorded time replayed
+};
+
+using DetectionLog = std::vector<DetectionRecord>;
+
+TuneScore tune_evaluate(const std::vector<DetectionLog> &logs, const RBPFParams &p,
+                        const TuneOptions &opt);
+
+// ===================== Search ===========================
+
+enum class TuneMethod { RANDOM, TPE };
+
+struct TuneSearch {
+    TuneMethod method   = TuneMethod::TPE;
+    int        trials   = 200;
+    int        startup  = 32;       // random trials before TPE takes over
+    int        batch    = 0;        // trials proposed per round, evaluated in parallel; 0: threads
+    int        threads  = 0;        // 0: std::thread::hardware_concurrency()
+    float      gamma    = 0.25f;    // TPE: fraction of trials modelled as "good"
+    int        candidates = 24;     // TPE: samples from l(x) per proposal
+    uint64_t   seed     = 1ULL;
+};
+
+struct TuneTrial {
+    TunePoint  u;
+    RBPFParams params;
+    TuneScore  score;
+};
+
+// Trial 0 is always the starting parameter set `base` (usually the
+// defaults). A round evaluates at most `batch` trials at once, so that is
+// the parallelism whatever the thread count. Proposals depend only on
+// `seed` and the finished rounds, so for a given batch the result does not
+// depend on the thread count; the default batch follows it, so fix batch to
+// reproduce a run on another machine. progress(i, trial) is called
+// from the caller's thread after each round, in trial order. Returns all
+// trials in evaluation order.
+std::vector<TuneTrial> tune_run(const std::vector<DetectionLog> &logs,
+                                const RBPFParams &base,
+                                const TuneSearch &search, const TuneOptions &opt,
+                                const std::function<void(int, const TuneTrial &)> &progress = {});
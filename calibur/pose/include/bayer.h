@@ -0,0 +1,162 @@
+#ifndef BAYER_H
+#define BAYER_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef __CUDACC__
+#define BAYER_HD __host__ __device__
+#else
+#define BAYER_HD
+#endif
+
+// Bilinear demosaic of 8-bit Bayer frames, vectorized with NEON (Jetson) or
+// SSE2 (x86-64) and a scalar fallback, bit-exact with OpenCV's bilinear
+// cvtColor (borders replicated from the adjacent row / column).
+//
+// Patterns use the GenICam / Hik names (colour of the top-left pixel's
+// 2x2 cell, row by row). OpenCV names them by the second row instead:
+// BayerRG8 is cv::COLOR_BayerBG2BGR and BayerBG8 is cv::COLOR_BayerRG2BGR.
+
+enum class BayerPattern : uint8_t {
+    RG = 0,   // R G / G B  (PixelType_Gvsp_BayerRG8)
+    BG = 1    // B G / G R  (PixelType_Gvsp_BayerBG8)
+};
+
+bool bayer_to_bgr(const uint8_t* src, size_t srcStride, int width, int height, BayerPattern pattern,
+                  uint8_t* dst, size_t dstStride);
+/*
+src:        Bayer frame, width x height bytes, rows srcStride apart
+dst:        BGR8 output, rows dstStride apart
+return:     false for frames smaller than 3 x 3
+*/
+
+// Letterbox placement of a srcW x srcH frame in a dstW x dstH input, as
+// the CUDA preprocess does it.
+struct LetterboxRect {
+    int x = 0, y = 0;   // top-left of the resized frame
+    int w = 0, h = 0;   // resized size
+};
+
+LetterboxRect letterbox_rect(int srcW, int srcH, int dstW, int dstH);
+
+// ===== per-pixel form, shared by the CPU reference and the CUDA kernel =====
+
+// Demosaiced pixel (x, y) as R, G, B, with bayer_to_bgr's borders (row 0 /
+// h - 1 and column 0 / w - 1 repeat their neighbours).
+BAYER_HD inline void bayer_pixel(const uint8_t* src, size_t stride, int w, int h, BayerPattern pattern,
+                                 int x, int y, int rgb[3])
+{
+    x = x < 1 ? 1 : (x > w - 2 ? w - 2 : x);
+    y = y < 1 ? 1 : (y > h - 2 ? h - 2 : y);
+    const uint8_t* up  = src + (y - 1) * stride;
+    const uint8_t* cur = src + y * stride;
+    const uint8_t* dn  = src + (y + 1) * stride;
+
+    // even rows hold the top-left colour at even x, odd rows the other one
+    // at odd x; P is the row's colour, Q the other
+    const bool evenRow = (y & 1) == 0;
+    const int  P = (evenRow == (pattern == BayerPattern::RG)) ? 0 : 2;
+    const int  Q = 2 - P;
+    const int  horiz = cur[x - 1] + cur[x + 1];
+    const int  vert  = up[x] + dn[x];
+    if (((x & 1) == 0) == evenRow) {
+        rgb[P] = cur[x];
+        rgb[1] = (horiz + vert + 2) >> 2;
+        rgb[Q] = (up[x - 1] + up[x + 1] + dn[x - 1] + dn[x + 1] + 2) >> 2;
+    } else {
+        rgb[1] = cur[x];
+        rgb[P] = (horiz + 1) >> 1;
+        rgb[Q] = (vert + 1) >> 1;
+    }
+}
+
+// cv::resize INTER_LINEAR tap of output index i: first source index and the
+// weight of the next one.
+BAYER_HD inline void bayer_linear_tap(int i, int srcN, int dstN, int& s, float& u)
+{
+    const double f = (i + 0.5) * (double(srcN) / dstN) - 0.5;
+    s = (int)floor(f);
+    u = float(f - s);
+    if (s < 0) { s = 0; u = 0.0f; }
+    if (s >= srcN - 1) { s = srcN - 1; u = 0.0f; }
+}
+
+// Network input pixel (ox, oy) as R, G, B / 255: what BayerLetterbox::run
+// writes there, in the same order of operations.
+BAYER_HD inline void bayer_letterbox_pixel(const uint8_t* src, size_t stride, int w, int h, BayerPattern pattern,
+                                           const LetterboxRect& r, int ox, int oy, float rgb[3])
+{
+    const int cx = ox - r.x, cy = oy - r.y;
+    if (cx < 0 || cx >= r.w || cy < 0 || cy >= r.h) {
+        rgb[0] = rgb[1] = rgb[2] = 128.0f / 255.0f;
+        return;
+    }
+    int x0, y0;
+    float fx, fy;
+    bayer_linear_tap(cx, w, r.w, x0, fx);
+    bayer_linear_tap(cy, h, r.h, y0, fy);
+    const int x1 = x0 + 1 < w ? x0 + 1 : w - 1;
+    const int y1 = y0 + 1 < h ? y0 + 1 : h - 1;
+
+    int a[3], b[3], c[3], d[3];
+    bayer_pixel(src, stride, w, h, pattern, x0, y0, a);
+    bayer_pixel(src, stride, w, h, pattern, x1, y0, b);
+    bayer_pixel(src, stride, w, h, pattern, x0, y1, c);
+    bayer_pixel(src, stride, w, h, pattern, x1, y1, d);
+    for (int k = 0; k < 3; ++k) {
+        const float top = float(a[k]) + fx * (float(b[k]) - float(a[k]));
+        const float bot = float(c[k]) + fx * (float(d[k]) - float(c[k]));
+        rgb[k] = (top + fy * (bot - top)) * (1.0f / 255.0f);
+    }
+}
+
+// Bayer frame -> letterboxed, bilinearly resized, planar RGB float / 255
+// network input in one pass on the CPU: each source row is demosaiced once
+// into a small row cache and resized straight from there, so the full BGR
+// frame never goes through memory. Resampling follows cv::resize
+// INTER_LINEAR (half-pixel centres); padding is 128 / 255 like the CUDA
+// path. Same result as bayer_letterbox_pixel over every output pixel, which
+// is what preprocess_bayer() runs on the GPU.
+class BayerLetterbox
+{
+public:
+    BayerLetterbox(int dstW, int dstH);
+
+    bool run(const uint8_t* src, size_t srcStride, int width, int height, BayerPattern pattern,
+             float* dst);
+    /*
+    src:        Bayer frame, width x height bytes, rows srcStride apart
+    dst:        3 x dstH x dstW floats, R plane first
+    return:     false for frames smaller than 3 x 3
+    */
+
+    const LetterboxRect& rect() const { return rect_; }
+
+private:
+    void setup(int width, int height);
+    const float* resampled_row(int sy, int keep);
+
+    int dstW_, dstH_;
+    int srcW_ = 0, srcH_ = 0;
+    LetterboxRect rect_;
+
+    // per output column / row: first source index and weight of the next
+    std::vector<int>   x0_, y0_;
+    std::vector<float> fx_, fy_;
+
+    // demosaiced source row (planar R, G, B) and two horizontally resampled
+    // rows per channel, keyed by source row
+    std::vector<uint8_t> rgb_;
+    std::vector<float>   rows_;
+    int rowKey_[2] = {-1, -1};
+    int nextSlot_ = 0;
+
+    const uint8_t* src_ = nullptr;
+    size_t stride_ = 0;
+    BayerPattern pattern_ = BayerPattern::RG;
+};
+
+#endif  // BAYER_H
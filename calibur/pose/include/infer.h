@@ -10,6 +10,7 @@
 #include "public.h"
 #include "types.h"
 #include "config.h"
+#include "bayer.h"
 
 using namespace nvinfer1;
 
@@ -27,6 +28,9 @@ public:
     YoloDetector& operator=(YoloDetector&& other) noexcept;
 
     std::vector<Detection> inference(cv::Mat& img);
+    // Raw Bayer frame: uploaded at 1 byte per pixel, then demosaic, letterbox
+    // and normalization run as one CUDA kernel into the input tensor
+    std::vector<Detection> inference(const cv::Mat& bayer, BayerPattern pattern);
     bool is_valid() const { return valid_; }
 
     static void draw_image(
@@ -38,6 +42,7 @@ public:
 
 private:
     void get_engine();
+    std::vector<Detection> run_input(cv::Mat& img);   // vBufferD[0] filled; boxes scaled to img
 
 private:
     Logger              gLogger;
@@ -54,6 +59,9 @@ private:
     float*              transposeDevice = nullptr;
     float*              decodeDevice    = nullptr;
 
+    uint8_t*            bayerDevice      = nullptr;  // Bayer path only, grown to the frame
+    size_t              bayerDeviceBytes = 0;
+
     int                 OUTPUT_CANDIDATES = 0;  // 8400: 80*80 + 40*40 + 20*20
     bool                valid_ = false;
 };
@@ -4,6 +4,8 @@
 #include <opencv2/opencv.hpp>
 #include <cuda_runtime.h>
 
+#include "bayer.h"
+
 void preprocess(const cv::Mat& srcImg, float* dstDevData, const int dstHeight, const int dstWidth, cudaStream_t stream);
 /*
 srcImg:     source image for inference
@@ -12,4 +14,15 @@ dstHeight:  CNN input height
 dstWidth:   CNN input width
 */
 
+void preprocess_bayer(const uint8_t* src, size_t srcStride, int srcWidth, int srcHeight, BayerPattern pattern,
+                      uint8_t* bayerDevData, float* dstDevData, const int dstHeight, const int dstWidth,
+                      cudaStream_t stream);
+/*
+src:          raw 8-bit Bayer frame on the host, rows srcStride apart
+bayerDevData: device buffer of at least srcWidth * srcHeight bytes for the upload
+dstDevData:   data after preprocess (demosaic / letterbox / rgb planes / normalize)
+The frame goes up at 1 byte per pixel and one kernel writes the network
+input (bayer_letterbox_pixel per output pixel); no BGR frame is formed.
+*/
+
 #endif  // PREPROCESS_H
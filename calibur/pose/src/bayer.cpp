@@ -0,0 +1,289 @@
+#include "bayer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// A Bayer row holds one colour P (at even x when colorEven) and G; the
+// rows above and below hold the other colour Q. Per site:
+//   P site:  P = c,  G = (up + down + left + right + 2) >> 2,  Q = (4 diagonals + 2) >> 2
+//   G site:  G = c,  P = (left + right + 1) >> 1,              Q = (up + down + 1) >> 1
+// Interior columns only; the border columns are copied from their
+// neighbours afterwards.
+
+static inline void demosaic_px(const uint8_t* up, const uint8_t* cur, const uint8_t* dn, int x,
+                               bool colorSite, uint8_t* P, uint8_t* G, uint8_t* Q)
+{
+    const int horiz = cur[x - 1] + cur[x + 1];
+    const int vert  = up[x] + dn[x];
+    if (colorSite) {
+        P[x] = cur[x];
+        G[x] = (uint8_t)((horiz + vert + 2) >> 2);
+        Q[x] = (uint8_t)((up[x - 1] + up[x + 1] + dn[x - 1] + dn[x + 1] + 2) >> 2);
+    } else {
+        G[x] = cur[x];
+        P[x] = (uint8_t)((horiz + 1) >> 1);
+        Q[x] = (uint8_t)((vert + 1) >> 1);
+    }
+}
+
+// 16 pixels from even x0: needs columns x0 - 1 .. x0 + 16
+static inline int demosaic_simd(const uint8_t* up, const uint8_t* cur, const uint8_t* dn, int x0, int xEnd,
+                                bool colorEven, uint8_t* P, uint8_t* G, uint8_t* Q)
+{
+#if defined(__ARM_NEON)
+    for (; x0 + 16 <= xEnd; x0 += 16) {
+        // vld2 splits even / odd columns
+        const uint8x8x2_t uL = vld2_u8(up + x0 - 1),  uC = vld2_u8(up + x0),  uR = vld2_u8(up + x0 + 1);
+        const uint8x8x2_t cL = vld2_u8(cur + x0 - 1), cC = vld2_u8(cur + x0), cR = vld2_u8(cur + x0 + 1);
+        const uint8x8x2_t dL = vld2_u8(dn + x0 - 1),  dC = vld2_u8(dn + x0),  dR = vld2_u8(dn + x0 + 1);
+
+        const uint16x8_t horizE = vaddl_u8(cL.val[0], cC.val[1]);
+        const uint16x8_t horizO = vaddl_u8(cC.val[0], cR.val[1]);
+        const uint16x8_t vertE  = vaddl_u8(uC.val[0], dC.val[0]);
+        const uint16x8_t vertO  = vaddl_u8(uC.val[1], dC.val[1]);
+        const uint16x8_t diagE  = vaddq_u16(vaddl_u8(uL.val[0], uC.val[1]), vaddl_u8(dL.val[0], dC.val[1]));
+        const uint16x8_t diagO  = vaddq_u16(vaddl_u8(uC.val[0], uR.val[1]), vaddl_u8(dC.val[0], dR.val[1]));
+
+        uint8x8x2_t p, g, q;
+        if (colorEven) {
+            p.val[0] = cC.val[0];
+            g.val[0] = vrshrn_n_u16(vaddq_u16(horizE, vertE), 2);
+            q.val[0] = vrshrn_n_u16(diagE, 2);
+            g.val[1] = cC.val[1];
+            p.val[1] = vrshrn_n_u16(horizO, 1);
+            q.val[1] = vrshrn_n_u16(vertO, 1);
+        } else {
+            g.val[0] = cC.val[0];
+            p.val[0] = vrshrn_n_u16(horizE, 1);
+            q.val[0] = vrshrn_n_u16(vertE, 1);
+            p.val[1] = cC.val[1];
+            g.val[1] = vrshrn_n_u16(vaddq_u16(horizO, vertO), 2);
+            q.val[1] = vrshrn_n_u16(diagO, 2);
+        }
+        vst2_u8(P + x0, p);
+        vst2_u8(G + x0, g);
+        vst2_u8(Q + x0, q);
+    }
+#elif defined(__SSE2__)
+    const __m128i lo = _mm_set1_epi16(0x00FF);
+    const __m128i one = _mm_set1_epi16(1), two = _mm_set1_epi16(2);
+    // 16-bit lanes: even column in the low byte, odd in the high byte
+    auto even = [&](const uint8_t* p) { return _mm_and_si128(_mm_loadu_si128((const __m128i*)p), lo); };
+    auto odd  = [&](const uint8_t* p) { return _mm_srli_epi16(_mm_loadu_si128((const __m128i*)p), 8); };
+    auto pack = [&](__m128i e, __m128i o) { return _mm_or_si128(e, _mm_slli_epi16(o, 8)); };
+    auto avg2 = [&](__m128i s) { return _mm_srli_epi16(_mm_add_epi16(s, one), 1); };
+    auto avg4 = [&](__m128i s) { return _mm_srli_epi16(_mm_add_epi16(s, two), 2); };
+
+    for (; x0 + 16 <= xEnd; x0 += 16) {
+        const __m128i uE = even(up + x0),  uO = odd(up + x0);
+        const __m128i cE = even(cur + x0), cO = odd(cur + x0);
+        const __m128i dE = even(dn + x0),  dO = odd(dn + x0);
+
+        const __m128i horizE = _mm_add_epi16(even(cur + x0 - 1), cO);
+        const __m128i horizO = _mm_add_epi16(cE, odd(cur + x0 + 1));
+        const __m128i vertE  = _mm_add_epi16(uE, dE);
+        const __m128i vertO  = _mm_add_epi16(uO, dO);
+        const __m128i diagE  = _mm_add_epi16(_mm_add_epi16(even(up + x0 - 1), uO), _mm_add_epi16(even(dn + x0 - 1), dO));
+        const __m128i diagO  = _mm_add_epi16(_mm_add_epi16(uE, odd(up + x0 + 1)), _mm_add_epi16(dE, odd(dn + x0 + 1)));
+
+        __m128i p, g, q;
+        if (colorEven) {
+            p = pack(cE, avg2(horizO));
+            g = pack(avg4(_mm_add_epi16(horizE, vertE)), cO);
+            q = pack(avg4(diagE), avg2(vertO));
+        } else {
+            p = pack(avg2(horizE), cO);
+            g = pack(cE, avg4(_mm_add_epi16(horizO, vertO)));
+            q = pack(avg2(vertE), avg4(diagO));
+        }
+        _mm_storeu_si128((__m128i*)(P + x0), p);
+        _mm_storeu_si128((__m128i*)(G + x0), g);
+        _mm_storeu_si128((__m128i*)(Q + x0), q);
+    }
+#else
+    (void)up; (void)cur; (void)dn; (void)xEnd; (void)colorEven; (void)P; (void)G; (void)Q;
+#endif
+    return x0;
+}
+
+// Demosaiced source row y (rows 0 and h - 1 repeat rows 1 and h - 2) as
+// planar R, G, B.
+static void demosaic_row(const uint8_t* src, size_t stride, int w, int h, BayerPattern pattern, int y,
+                         uint8_t* R, uint8_t* G, uint8_t* B)
+{
+    y = std::clamp(y, 1, h - 2);
+    const uint8_t* up  = src + (y - 1) * stride;
+    const uint8_t* cur = src + y * stride;
+    const uint8_t* dn  = src + (y + 1) * stride;
+
+    // even rows hold the top-left colour at even x, odd rows the other one
+    // at odd x
+    const bool evenRow   = (y & 1) == 0;
+    const bool firstIsR  = pattern == BayerPattern::RG;
+    uint8_t* P = (evenRow == firstIsR) ? R : B;
+    uint8_t* Q = (P == R) ? B : R;
+    const bool colorEven = evenRow;
+
+    demosaic_px(up, cur, dn, 1, !colorEven, P, G, Q);
+    // the last SIMD load ends at x0 + 16, which must stay inside the row
+    int x = demosaic_simd(up, cur, dn, 2, w - 1, colorEven, P, G, Q);
+    for (; x <= w - 2; ++x) demosaic_px(up, cur, dn, x, ((x & 1) == 0) == colorEven, P, G, Q);
+
+    R[0] = R[1]; G[0] = G[1]; B[0] = B[1];
+    R[w - 1] = R[w - 2]; G[w - 1] = G[w - 2]; B[w - 1] = B[w - 2];
+}
+
+bool bayer_to_bgr(const uint8_t* src, size_t srcStride, int width, int height, BayerPattern pattern,
+                  uint8_t* dst, size_t dstStride)
+{
+    if (width < 3 || height < 3) return false;
+
+    std::vector<uint8_t> planes(3 * size_t(width));
+    uint8_t* R = planes.data();
+    uint8_t* G = R + width;
+    uint8_t* B = G + width;
+
+    for (int y = 1; y <= height - 2; ++y) {
+        demosaic_row(src, srcStride, width, height, pattern, y, R, G, B);
+        uint8_t* out = dst + y * dstStride;
+        int x = 0;
+#if defined(__ARM_NEON)
+        for (; x + 16 <= width; x += 16) {
+            uint8x16x3_t bgr;
+            bgr.val[0] = vld1q_u8(B + x);
+            bgr.val[1] = vld1q_u8(G + x);
+            bgr.val[2] = vld1q_u8(R + x);
+            vst3q_u8(out + 3 * x, bgr);
+        }
+#endif
+        for (; x < width; ++x) {
+            out[3 * x]     = B[x];
+            out[3 * x + 1] = G[x];
+            out[3 * x + 2] = R[x];
+        }
+    }
+    std::memcpy(dst, dst + dstStride, 3 * size_t(width));
+    std::memcpy(dst + (height - 1) * dstStride, dst + (height - 2) * dstStride, 3 * size_t(width));
+    return true;
+}
+
+LetterboxRect letterbox_rect(int srcW, int srcH, int dstW, int dstH)
+{
+    // same arithmetic as preprocess() in preprocess.cu
+    LetterboxRect r;
+    float r_w = dstW / (srcW * 1.0);
+    float r_h = dstH / (srcH * 1.0);
+    if (r_h > r_w) {
+        r.w = dstW;
+        r.h = r_w * srcH;
+        r.x = 0;
+        r.y = (dstH - r.h) / 2;
+    }
+    else {
+        r.w = r_h * srcW;
+        r.h = dstH;
+        r.x = (dstW - r.w) / 2;
+        r.y = 0;
+    }
+    return r;
+}
+
+BayerLetterbox::BayerLetterbox(int dstW, int dstH)
+    : dstW_(dstW), dstH_(dstH)
+{}
+
+// cv::resize INTER_LINEAR source index and weight of each output pixel
+static void linear_table(int srcN, int dstN, std::vector<int>& idx, std::vector<float>& frac)
+{
+    idx.resize(dstN);
+    frac.resize(dstN);
+    for (int i = 0; i < dstN; ++i) bayer_linear_tap(i, srcN, dstN, idx[i], frac[i]);
+}
+
+void BayerLetterbox::setup(int width, int height)
+{
+    srcW_ = width;
+    srcH_ = height;
+    rect_ = letterbox_rect(width, height, dstW_, dstH_);
+    linear_table(width, rect_.w, x0_, fx_);
+    linear_table(height, rect_.h, y0_, fy_);
+    rgb_.resize(3 * size_t(width));
+    rows_.resize(2 * 3 * size_t(rect_.w));
+}
+
+// Slot holding source row sy resampled to rect_.w columns, loading it into
+// the slot not holding `keep` if needed.
+const float* BayerLetterbox::resampled_row(int sy, int keep)
+{
+    for (int s = 0; s < 2; ++s) {
+        if (rowKey_[s] == sy) return rows_.data() + s * 3 * size_t(rect_.w);
+    }
+    const int s = (rowKey_[0] == keep) ? 1 : (rowKey_[1] == keep) ? 0 : nextSlot_;
+    nextSlot_ = 1 - s;
+    rowKey_[s] = sy;
+
+    uint8_t* R = rgb_.data();
+    uint8_t* G = R + srcW_;
+    uint8_t* B = G + srcW_;
+    demosaic_row(src_, stride_, srcW_, srcH_, pattern_, sy, R, G, B);
+
+    float* out = rows_.data() + s * 3 * size_t(rect_.w);
+    const uint8_t* planes[3] = {R, G, B};
+    const int last = srcW_ - 1;
+    for (int c = 0; c < 3; ++c) {
+        const uint8_t* p = planes[c];
+        float* o = out + c * size_t(rect_.w);
+        for (int i = 0; i < rect_.w; ++i) {
+            const int   x = x0_[i];
+            const float a = p[x];
+            o[i] = a + fx_[i] * (float(p[std::min(x + 1, last)]) - a);
+        }
+    }
+    return out;
+}
+
+bool BayerLetterbox::run(const uint8_t* src, size_t srcStride, int width, int height, BayerPattern pattern,
+                         float* dst)
+{
+    if (width < 3 || height < 3) return false;
+    if (width != srcW_ || height != srcH_) setup(width, height);
+    src_     = src;
+    stride_  = srcStride;
+    pattern_ = pattern;
+    rowKey_[0] = rowKey_[1] = -1;
+    nextSlot_ = 0;
+
+    const float pad = 128.0f / 255.0f;
+    const float k   = 1.0f / 255.0f;
+    const size_t plane = size_t(dstW_) * dstH_;
+    for (int oy = 0; oy < dstH_; ++oy) {
+        const int r = oy - rect_.y;
+        if (r < 0 || r >= rect_.h) {
+            for (int c = 0; c < 3; ++c) std::fill_n(dst + c * plane + size_t(oy) * dstW_, dstW_, pad);
+            continue;
+        }
+        const int sy0 = y0_[r];
+        const int sy1 = std::min(sy0 + 1, srcH_ - 1);
+        const float* h0 = resampled_row(sy0, sy1);
+        const float* h1 = resampled_row(sy1, sy0);
+        const float  v  = fy_[r];
+
+        for (int c = 0; c < 3; ++c) {
+            float* out = dst + c * plane + size_t(oy) * dstW_;
+            std::fill_n(out, rect_.x, pad);
+            std::fill_n(out + rect_.x + rect_.w, dstW_ - rect_.x - rect_.w, pad);
+            const float* a = h0 + c * size_t(rect_.w);
+            const float* b = h1 + c * size_t(rect_.w);
+            float* o = out + rect_.x;
+            for (int i = 0; i < rect_.w; ++i) o[i] = (a[i] + v * (b[i] - a[i])) * k;
+        }
+    }
+    return true;
+}
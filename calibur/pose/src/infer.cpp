@@ -197,6 +197,10 @@ YoloDetector::~YoloDetector() {
         cudaFree(decodeDevice);
         decodeDevice = nullptr;
     }
+    if (bayerDevice) {
+        cudaFree(bayerDevice);
+        bayerDevice = nullptr;
+    }
 
     delete[] outputData;
     outputData = nullptr;
@@ -219,6 +223,8 @@ YoloDetector::YoloDetector(YoloDetector&& other) noexcept
       vBufferD(std::move(other.vBufferD)),
       transposeDevice(other.transposeDevice),
       decodeDevice(other.decodeDevice),
+      bayerDevice(other.bayerDevice),
+      bayerDeviceBytes(other.bayerDeviceBytes),
       OUTPUT_CANDIDATES(other.OUTPUT_CANDIDATES),
       valid_(other.valid_)
 {
@@ -229,6 +235,8 @@ YoloDetector::YoloDetector(YoloDetector&& other) noexcept
     other.outputData = nullptr;
     other.transposeDevice = nullptr;
     other.decodeDevice = nullptr;
+    other.bayerDevice = nullptr;
+    other.bayerDeviceBytes = 0;
     other.vBufferD.clear();
     other.OUTPUT_CANDIDATES = 0;
     other.valid_ = false;
@@ -250,7 +258,28 @@ std::vector<Detection> YoloDetector::inference(cv::Mat& img){
 
     // put input on device, then letterbox、bgr to rgb、hwc to chw、normalize.
     preprocess(img, (float*)vBufferD[0], kInputH, kInputW, stream);
+    return run_input(img);
+}
+
+std::vector<Detection> YoloDetector::inference(const cv::Mat& bayer, BayerPattern pattern){
+    if (bayer.empty() || bayer.type() != CV_8UC1 || bayer.cols < 3 || bayer.rows < 3) return {};
+    const size_t bytes = size_t(bayer.cols) * bayer.rows;
+    if (bytes > bayerDeviceBytes) {
+        // run_input() synchronizes the stream, so the old buffer is idle
+        if (bayerDevice) cudaFree(bayerDevice);
+        CHECK(cudaMalloc((void**)&bayerDevice, bytes));
+        bayerDeviceBytes = bytes;
+    }
+
+    // put the mosaic on device, then demosaic、letterbox、hwc to chw、normalize in one kernel
+    preprocess_bayer(bayer.data, bayer.step, bayer.cols, bayer.rows, pattern,
+                     bayerDevice, (float*)vBufferD[0], kInputH, kInputW, stream);
+
+    cv::Mat img = bayer;   // header only, for the frame size
+    return run_input(img);
+}
 
+std::vector<Detection> YoloDetector::run_input(cv::Mat& img){
     // tensorrt inference (TensorRT 10 style)
     const ICudaEngine& eng = context->getEngine();
     const char* inputName  = eng.getIOTensorName(0);
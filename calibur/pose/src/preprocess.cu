@@ -139,3 +139,34 @@ void preprocess(const cv::Mat& srcImg, float* dstDevData, const int dstHeight, c
     cudaFree(srcDevData);
     cudaFree(midDevData);
 }
+
+
+__global__ void bayer_letterbox(const uint8_t* srcData, const int srcW, const int srcH, const BayerPattern pattern,
+    const LetterboxRect rect, float* tgtData, const int tgtH, const int tgtW)
+{
+    int ix = threadIdx.x + blockDim.x * blockIdx.x;
+    int iy = threadIdx.y + blockDim.y * blockIdx.y;
+    if (ix >= tgtW || iy >= tgtH) return;
+
+    float rgb[3];
+    bayer_letterbox_pixel(srcData, srcW, srcW, srcH, pattern, rect, ix, iy, rgb);
+    int idx = ix + iy * tgtW;
+    tgtData[idx] = rgb[0];
+    tgtData[idx + tgtH * tgtW] = rgb[1];
+    tgtData[idx + tgtH * tgtW * 2] = rgb[2];
+}
+
+void preprocess_bayer(const uint8_t* src, size_t srcStride, int srcWidth, int srcHeight, BayerPattern pattern,
+                      uint8_t* bayerDevData, float* dstDevData, const int dstHeight, const int dstWidth,
+                      cudaStream_t stream)
+{
+    // 1 byte per pixel, rows packed on the device
+    cudaMemcpy2DAsync(bayerDevData, srcWidth, src, srcStride, srcWidth, srcHeight,
+                      cudaMemcpyHostToDevice, stream);
+
+    const LetterboxRect rect = letterbox_rect(srcWidth, srcHeight, dstWidth, dstHeight);
+    dim3 blockSize(32, 8);
+    dim3 gridSize((dstWidth + blockSize.x - 1) / blockSize.x, (dstHeight + blockSize.y - 1) / blockSize.y);
+    bayer_letterbox<<<gridSize, blockSize, 0, stream>>>(bayerDevData, srcWidth, srcHeight, pattern, rect,
+                                                        dstDevData, dstHeight, dstWidth);
+}
@@ -0,0 +1,74 @@
+// calibur/sim/camera_sim.cpp
+#include "camera_sim.hpp"
+
+#include <algorithm>
+
+CameraSim::CameraSim(const CameraSimParams &p, TimePoint t0)
+    : p_(p), now_(t0), next_start_(t0)
+{
+    roi_     = SensorRoi{0, 0, p_.limits.width, p_.limits.height};
+    latched_ = roi_;
+}
+
+double CameraSim::period(const SensorRoi &roi) const {
+    const double readout  = p_.row_time * roi.h + p_.frame_overhead;
+    const double transfer = double(roi.w) * roi.h * p_.bytes_per_pixel / p_.link_rate;
+    return std::max(readout, transfer);
+}
+
+CameraSimFrame CameraSim::next_frame() {
+    CameraSimFrame f;
+    f.start = next_start_;
+    while (!writes_.empty() && writes_.front().from <= f.start) {
+        latched_ = writes_.front().roi;
+        writes_.pop_front();
+    }
+    f.roi       = latched_;
+    f.frame_num = ++frame_num_;
+    f.capture   = f.start + span(0.5 * p_.exposure);
+
+    const double readout  = p_.row_time * f.roi.h + p_.frame_overhead;
+    const double transfer = double(f.roi.w) * f.roi.h * p_.bytes_per_pixel / p_.link_rate;
+    f.delivered = f.start + span(p_.exposure + readout + transfer);
+
+    next_start_ = f.start + span(period(f.roi));
+    now_        = std::max(now_, f.delivered + span(p_.host_delay));
+    ++frames_;
+    return f;
+}
+
+bool CameraSim::valid(const SensorRoi &r) const {
+    const SensorLimits &l = p_.limits;
+    const bool full_w = r.w == l.width, full_h = r.h == l.height;
+    return r.w >= l.min_w && r.h >= l.min_h &&
+           (full_w || r.w % l.inc_w == 0) && (full_h || r.h % l.inc_h == 0) &&
+           r.x >= 0 && r.y >= 0 && r.x % l.inc_x == 0 && r.y % l.inc_y == 0 &&
+           r.x + r.w <= l.width && r.y + r.h <= l.height;
+}
+
+bool CameraSim::move_roi(int x, int y) {
+    const SensorRoi next{x, y, roi_.w, roi_.h};
+    if (!valid(next)) {
+        ++refused_;
+        return false;
+    }
+    roi_ = next;
+    writes_.push_back(Write{now_ + span(p_.apply_delay), next});
+    return true;
+}
+
+bool CameraSim::resize_roi(const SensorRoi &r) {
+    if (!valid(r)) {
+        ++refused_;
+        return false;
+    }
+    // frames in flight are discarded with the stop
+    roi_     = r;
+    latched_ = r;
+    writes_.clear();
+    now_        = now_ + span(p_.restart_time);
+    next_start_ = now_;
+    frame_num_  = 0;
+    ++restarts_;
+    return true;
+}
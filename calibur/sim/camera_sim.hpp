@@ -0,0 +1,93 @@
+// calibur/sim/camera_sim.hpp
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+
+#include "../worker/camera_roi.hpp"
+
+// Camera stand-in behind CameraControl, stepped frame by frame in virtual
+// time (no thread, no pixels): what it models is which window each frame
+// is read out with and when it arrives.
+//
+// Frames are exposed back to back. A frame period is the longer of the
+// sensor readout (row_time per row of the window plus overhead) and the
+// link transfer of its pixels, so a smaller window runs faster. The window
+// is latched at exposure start: an offset write made at host time t is in
+// every frame started after t + apply_delay. Frames are handed over once
+// read out and transferred.
+//
+// The host is taken to write controls at the hand-over of the last frame
+// it took (plus host_delay). A resize stops acquisition, discards the
+// frames in flight and restarts after restart_time with the frame number
+// starting over, as MV_CC_StopGrabbing / StartGrabbing does. Writes
+// breaking the node constraints are refused.
+
+struct CameraSimParams {
+    SensorLimits limits;
+    double exposure        = 0.002;    // s
+    double row_time        = 8e-6;     // s per window row read out
+    double frame_overhead  = 3e-4;     // s per frame
+    double link_rate       = 360e6;    // bytes / s over USB
+    int    bytes_per_pixel = 1;        // 1: Bayer8, 3: BGR8
+    double apply_delay     = 0.001;    // s, offset write to the first exposure start with it
+    double restart_time    = 0.05;     // s, acquisition stop + start on resize
+    double host_delay      = 0.0;      // s, hand-over to the host's control write
+};
+
+struct CameraSimFrame {
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    uint32_t  frame_num = 0;
+    TimePoint start;       // exposure start (window latched)
+    TimePoint capture;     // mid exposure
+    TimePoint delivered;   // handed to the host
+    SensorRoi roi;         // window it was read out with
+};
+
+class CameraSim : public CameraControl {
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    explicit CameraSim(const CameraSimParams &p = CameraSimParams(),
+                       TimePoint t0 = std::chrono::steady_clock::now());
+
+    // Next frame handed over; the host clock moves to its hand-over.
+    CameraSimFrame next_frame();
+
+    // Host time control writes are stamped with.
+    TimePoint now() const { return now_; }
+
+    // Frame period with window `roi`, s.
+    double period(const SensorRoi &roi) const;
+
+    SensorLimits limits() const override { return p_.limits; }
+    SensorRoi    roi() const override { return roi_; }
+    bool move_roi(int x, int y) override;
+    bool resize_roi(const SensorRoi &roi) override;
+
+    uint64_t frames() const { return frames_; }
+    uint64_t restarts() const { return restarts_; }
+    uint64_t refused() const { return refused_; }
+
+private:
+    static TimePoint::duration span(double s) {
+        return std::chrono::duration_cast<TimePoint::duration>(std::chrono::duration<double>(s));
+    }
+    bool valid(const SensorRoi &roi) const;
+
+    struct Write {
+        TimePoint from;   // exposure starts from here on have it
+        SensorRoi roi;
+    };
+
+    CameraSimParams   p_;
+    SensorRoi         roi_;      // last written
+    SensorRoi         latched_;  // of the last frame started
+    std::deque<Write> writes_;
+    TimePoint         now_;
+    TimePoint         next_start_;
+    uint32_t          frame_num_ = 0;
+    uint64_t          frames_ = 0, restarts_ = 0, refused_ = 0;
+};
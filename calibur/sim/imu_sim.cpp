@@ -0,0 +1,164 @@
+// calibur/sim/imu_sim.cpp
+#include "imu_sim.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "../imu/imu_protocol.hpp"
+
+static constexpr double kPi = 3.14159265358979323846;
+
+ImuSimulator::ImuSimulator(const ImuSimParams &p)
+    : p_(p), emitted_(new std::atomic<int64_t>[65536]) {
+    for (int i = 0; i < 65536; ++i) emitted_[i].store(0, std::memory_order_relaxed);
+}
+
+ImuSimulator::~ImuSimulator() {
+    stop();
+}
+
+bool ImuSimulator::start(const std::string &link) {
+    if (running_.load()) return true;
+    if (!port_.open(link)) return false;
+    start_ = std::chrono::steady_clock::now();
+    running_.store(true);
+    thread_ = std::thread(&ImuSimulator::run, this);
+    return true;
+}
+
+void ImuSimulator::stop() {
+    running_.store(false);
+    if (thread_.joinable()) thread_.join();
+    port_.close();
+}
+
+ImuSimStats ImuSimulator::stats() const {
+    ImuSimStats s;
+    s.frames    = frames_.load();
+    s.bytes     = bytes_.load();
+    s.corrupted = corrupted_.load();
+    s.dropped   = dropped_.load();
+    s.garbage   = garbage_.load();
+    s.late      = late_.load();
+    s.stalled   = stalled_.load();
+    return s;
+}
+
+bool ImuSimulator::emitted_at(uint16_t seq, TimePoint &t) const {
+    const int64_t ns = emitted_[seq].load(std::memory_order_acquire);
+    if (ns == 0) return false;
+    t = TimePoint(std::chrono::duration_cast<TimePoint::duration>(std::chrono::nanoseconds(ns)));
+    return true;
+}
+
+IMUData ImuSimulator::sample(double t) const {
+    const double wy = 2.0 * kPi * p_.yaw_freq;
+    const double wp = 2.0 * kPi * p_.pitch_freq;
+    const double yaw   = p_.yaw0 + p_.yaw_amp * std::sin(wy * t);
+    const double pitch = p_.pitch_amp * std::sin(wp * t);
+    const double roll  = 0.0;
+
+    IMUData d;
+    d.has_euler    = true;
+    d.euler_deg[0] = float(pitch);
+    d.euler_deg[1] = float(roll);
+    d.euler_deg[2] = float(yaw);
+
+    // ZYX: yaw about z, then pitch about y, then roll about x
+    const double hy = 0.5 * yaw * kPi / 180.0, hp = 0.5 * pitch * kPi / 180.0, hr = 0.5 * roll * kPi / 180.0;
+    const double cy = std::cos(hy), sy = std::sin(hy);
+    const double cp = std::cos(hp), sp = std::sin(hp);
+    const double cr = std::cos(hr), sr = std::sin(hr);
+    d.has_quat = true;
+    d.quat[0]  = float(cr * cp * cy + sr * sp * sy);
+    d.quat[1]  = float(sr * cp * cy - cr * sp * sy);
+    d.quat[2]  = float(cr * sp * cy + sr * cp * sy);
+    d.quat[3]  = float(cr * cp * sy - sr * sp * cy);
+
+    d.has_gyro    = true;
+    d.gyro_dps[0] = 0.0f;
+    d.gyro_dps[1] = float(p_.pitch_amp * wp * std::cos(wp * t));
+    d.gyro_dps[2] = float(p_.yaw_amp * wy * std::cos(wy * t));
+
+    d.has_accel     = true;
+    d.accel_mps2[2] = 9.81f;
+    d.has_temp      = true;
+    d.temp_c        = 41.5f;
+    d.has_fusion    = true;
+    d.fusion_state  = 3;
+
+    d.has_ts_sample = true;
+    d.ts_sample_us  = uint32_t(uint64_t(p_.tick_start_us) +
+                               uint64_t(std::llround(t * (1.0 + p_.clock_drift) * 1e6)));
+    return d;
+}
+
+void ImuSimulator::run() {
+    std::mt19937 rng(p_.seed);
+    std::normal_distribution<double> jitter(0.0, p_.jitter_us * 1e-6);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+
+    const double period = 1.0 / p_.rate_hz;
+    uint8_t payload[IMU_MAX_PAYLOAD];
+    uint8_t frame[IMU_MAX_PAYLOAD + IMU_FRAME_EXTRA];
+    uint8_t junk[16];
+
+    for (uint64_t k = 0; running_.load(std::memory_order_relaxed); ++k) {
+        const double t_sample = k * period;
+        const IMUData d = sample(t_sample);
+        const size_t len = imu_encode_payload(d, payload);
+        size_t n = imu_encode_frame(uint16_t(k), payload, len, frame);
+
+        double t_write = t_sample + p_.latency_us * 1e-6 + jitter(rng);
+        if (p_.baud > 0) t_write += n * 10.0 / p_.baud;
+        if (u(rng) < p_.stall_prob) {
+            t_write += p_.stall_us * 1e-6;
+            stalled_.fetch_add(1);
+        }
+        const auto due = start_ + std::chrono::duration_cast<TimePoint::duration>(
+                                      std::chrono::duration<double>(std::max(t_write, 0.0)));
+        std::this_thread::sleep_until(due);
+        const auto now = std::chrono::steady_clock::now();
+        if (now - due > std::chrono::duration<double>(period)) late_.fetch_add(1);
+
+        const uint16_t seq = uint16_t(k);
+        emitted_[seq].store(0, std::memory_order_relaxed);
+        if (u(rng) < p_.drop_prob) {
+            dropped_.fetch_add(1);
+            continue;
+        }
+
+        if (u(rng) < p_.corrupt_prob) {
+            frame[2 + rng() % (n - 2)] ^= uint8_t(1u << (rng() % 8));
+            corrupted_.fetch_add(1);
+        }
+        if (u(rng) < p_.garbage_prob) {
+            const size_t g = 1 + rng() % sizeof(junk);
+            for (size_t i = 0; i < g; ++i) junk[i] = (rng() % 4 == 0) ? IMU_HDR0 : uint8_t(rng());
+            port_.write_all(junk, g, 2);
+            garbage_.fetch_add(1);
+            bytes_.fetch_add(g);
+        }
+
+        // stamp before the write: the reader may see the frame before
+        // write() returns
+        const auto t_emit = std::chrono::steady_clock::now();
+        emitted_[seq].store(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(t_emit.time_since_epoch()).count(),
+            std::memory_order_release);
+        bool ok = true;
+        for (size_t off = 0; off < n && ok;) {
+            const size_t c = p_.max_chunk > 0 ? std::min(n - off, 1 + size_t(rng() % p_.max_chunk)) : n;
+            ok  = port_.write_all(frame + off, c, 2);
+            off += c;
+        }
+        if (!ok) {
+            emitted_[seq].store(0, std::memory_order_relaxed);
+            dropped_.fetch_add(1);   // nobody is draining the port
+            continue;
+        }
+        frames_.fetch_add(1);
+        bytes_.fetch_add(n);
+    }
+}
@@ -0,0 +1,92 @@
+// calibur/sim/imu_sim.hpp
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "../imu/imu_data.hpp"
+#include "pty_port.hpp"
+
+// IMU stand-in on a pty: emits 0x59 0x53 TLV frames (imu_protocol.hpp)
+// with euler, quaternion, gyro, accel, temperature and device sample
+// timestamps for a scripted gimbal motion.
+//
+// Sample k is taken at k / rate_hz on the device clock and written
+// latency_us later (plus the frame's transfer time at `baud`) with
+// Gaussian jitter, the way a real IMU's UART output trails its sampling. The device tick (ts_sample_us) runs clock_drift
+// fast and wraps at 2^32 us. Faults are injected per frame.
+
+struct ImuSimParams {
+    double   rate_hz       = 1000.0;
+    double   jitter_us     = 30.0;    // sigma of the write time around its nominal slot
+    double   latency_us    = 500.0;   // sample instant to first byte on the wire
+    int      baud          = 0;       // > 0: the write also waits out the frame's transfer (8N1)
+    double   clock_drift   = 0.0;     // device tick rate error (e.g. 50e-6)
+    uint32_t tick_start_us = 0;       // device tick of sample 0
+
+    // motion, degrees: yaw0 + yaw_amp sin(2 pi yaw_freq t), pitch_amp sin(2 pi pitch_freq t)
+    float yaw0       = 0.0f;
+    float yaw_amp    = 30.0f;
+    float yaw_freq   = 0.5f;
+    float pitch_amp  = 10.0f;
+    float pitch_freq = 0.3f;
+
+    // faults, per frame
+    double corrupt_prob = 0.0;   // one byte after the header flipped
+    double drop_prob    = 0.0;   // frame not written (its seq is skipped)
+    double garbage_prob = 0.0;   // 1..16 random bytes written before the frame
+    double stall_prob   = 0.0;   // frame held back stall_us (host/USB hiccup); later ones queue up
+    double stall_us     = 2000.0;
+    int    max_chunk    = 0;     // > 0: frames written in random pieces of 1..max_chunk bytes
+    uint32_t seed       = 1;
+};
+
+struct ImuSimStats {
+    uint64_t frames    = 0;   // written, including corrupted ones
+    uint64_t bytes     = 0;
+    uint64_t corrupted = 0;
+    uint64_t dropped   = 0;
+    uint64_t garbage   = 0;   // garbage bursts
+    uint64_t late      = 0;   // writes more than one period behind schedule
+    uint64_t stalled   = 0;
+};
+
+class ImuSimulator {
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    explicit ImuSimulator(const ImuSimParams &p = ImuSimParams());
+    ~ImuSimulator();
+
+    // Opens the pty (and the optional symlink) and starts emitting.
+    bool start(const std::string &link = "");
+    void stop();
+
+    const std::string &device() const { return port_.device(); }
+    ImuSimStats stats() const;
+
+    // Ground truth: sample taken t seconds after start (device schedule).
+    IMUData sample(double t) const;
+    TimePoint start_time() const { return start_; }
+
+    // Host time frame `seq` was written (last 65536 frames); false if it
+    // was dropped or not written yet.
+    bool emitted_at(uint16_t seq, TimePoint &t) const;
+
+private:
+    void run();
+
+    ImuSimParams      p_;
+    PtyPort           port_;
+    TimePoint         start_;
+    std::atomic<bool> running_{false};
+    std::thread       thread_;
+
+    std::unique_ptr<std::atomic<int64_t>[]> emitted_;   // ns since epoch per seq, 0: none
+    std::atomic<uint64_t> frames_{0}, bytes_{0}, corrupted_{0}, dropped_{0}, garbage_{0}, late_{0},
+                          stalled_{0};
+};
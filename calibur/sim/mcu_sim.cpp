@@ -0,0 +1,257 @@
+// calibur/sim/mcu_sim.cpp
+#include "mcu_sim.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <poll.h>
+
+McuSimulator::McuSimulator(const McuSimParams &p)
+    : p_(p), rng_(p.seed), speed_(p.bullet_speed), mode_(p.speed_mode) {}
+
+McuSimulator::~McuSimulator() {
+    stop();
+}
+
+bool McuSimulator::start(const std::string &link) {
+    if (running_.load()) return true;
+    if (!port_.open(link)) return false;
+    start_ = last_step_ = next_feedback_ = next_shot_ = std::chrono::steady_clock::now();
+    running_.store(true);
+    thread_ = std::thread(&McuSimulator::run, this);
+    return true;
+}
+
+void McuSimulator::stop() {
+    running_.store(false);
+    if (thread_.joinable()) thread_.join();
+    port_.close();
+}
+
+McuSimStats McuSimulator::stats() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return stats_;
+}
+
+McuCommand McuSimulator::last_command() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return cmd_;
+}
+
+void McuSimulator::gimbal(float &yaw, float &pitch) const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    yaw   = gimbal_yaw_;
+    pitch = gimbal_pitch_;
+}
+
+void McuSimulator::set_bullet_speed(float speed, uint8_t mode) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    speed_ = speed;
+    mode_  = mode;
+}
+
+double McuSimulator::mcu_seconds(TimePoint t) const {
+    const double s = std::chrono::duration<double>(t - start_).count();
+    return p_.tick_start_us * 1e-6 + s * (1.0 + p_.clock_drift);
+}
+
+uint32_t McuSimulator::tick(TimePoint t) const {
+    const double s = std::chrono::duration<double>(t - start_).count();
+    return uint32_t(uint64_t(p_.tick_start_us) + uint64_t(std::llround(s * (1.0 + p_.clock_drift) * 1e6)));
+}
+
+// ===================== wire =====================
+
+void McuSimulator::receive(TimePoint now) {
+    const auto delay = std::chrono::duration_cast<TimePoint::duration>(
+        std::chrono::duration<double>(p_.link_delay_us * 1e-6));
+    uint8_t buf[512];
+    for (;;) {
+        const long n = port_.read_some(buf, sizeof(buf));
+        if (n <= 0) break;
+        parser_.feed(buf, size_t(n), [&](uint8_t type, const uint8_t *payload, uint16_t len) {
+            Pending f;
+            f.t    = now + delay;
+            f.type = type;
+            f.len  = len;
+            std::memcpy(f.payload, payload, len);
+            in_.push_back(f);
+        });
+    }
+    std::lock_guard<std::mutex> lk(mtx_);
+    stats_.rx_bad = parser_.stats().bad_checksum + parser_.stats().oversize;
+}
+
+void McuSimulator::queue_out(TimePoint t, uint8_t type, const void *payload, uint16_t len) {
+    Pending f;
+    f.t    = t;
+    f.type = type;
+    f.len  = len;
+    std::memcpy(f.payload, payload, len);
+    auto it = std::upper_bound(out_.begin(), out_.end(), t,
+                               [](TimePoint a, const Pending &b) { return a < b.t; });
+    out_.insert(it, f);
+}
+
+void McuSimulator::flush_out(TimePoint now) {
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    uint8_t frame[kUsbMaxPayload + kUsbFrameExtra];
+    uint8_t junk[16];
+    while (!out_.empty() && out_.front().t <= now) {
+        const Pending &f = out_.front();
+        const size_t n = usb_encode_frame(f.type, f.payload, f.len, frame);
+        out_.pop_front();
+
+        if (u(rng_) < p_.drop_prob) {
+            std::lock_guard<std::mutex> lk(mtx_);
+            ++stats_.dropped;
+            continue;
+        }
+        if (u(rng_) < p_.corrupt_prob) {
+            frame[1 + rng_() % (n - 1)] ^= uint8_t(1u << (rng_() % 8));
+            std::lock_guard<std::mutex> lk(mtx_);
+            ++stats_.corrupted;
+        }
+        if (u(rng_) < p_.garbage_prob) {
+            const size_t g = 1 + rng_() % sizeof(junk);
+            for (size_t i = 0; i < g; ++i) junk[i] = (rng_() % 4 == 0) ? kUsbHeader : uint8_t(rng_());
+            port_.write_all(junk, g, 2);
+        }
+        port_.write_all(frame, n, 2);
+    }
+}
+
+// ===================== behaviour =====================
+
+void McuSimulator::handle(const Pending &f) {
+    if (f.type == USB_TX_AIM && f.len == kUsbAimLen) {
+        float cmd[2];
+        std::memcpy(cmd, f.payload, sizeof(cmd));
+        // relative to where the gimbal is when the command lands
+        yaw_set_.emplace_back(f.t + std::chrono::duration_cast<TimePoint::duration>(
+                                        std::chrono::duration<float>(p_.yaw.dead_time)),
+                              yaw_ + cmd[0]);
+        pitch_set_.emplace_back(f.t + std::chrono::duration_cast<TimePoint::duration>(
+                                          std::chrono::duration<float>(p_.pitch.dead_time)),
+                                pitch_ + cmd[1]);
+        std::lock_guard<std::mutex> lk(mtx_);
+        cmd_.yaw   = cmd[0];
+        cmd_.pitch = cmd[1];
+        ++cmd_.count;
+        ++stats_.aims;
+    } else if (f.type == USB_TX_STATE && f.len == kUsbStateLen) {
+        int32_t st[3];
+        std::memcpy(st, f.payload, sizeof(st));
+        std::lock_guard<std::mutex> lk(mtx_);
+        cmd_.aim   = st[0];
+        cmd_.fire  = st[1];
+        cmd_.chase = st[2];
+        ++stats_.states;
+    } else if (f.type == USB_TX_PING && f.len == kUsbPingLen) {
+        const auto t3 = f.t + std::chrono::duration_cast<TimePoint::duration>(
+                                  std::chrono::duration<double>(p_.turnaround_us * 1e-6));
+        uint8_t pong[kUsbPongLen];
+        std::memcpy(pong, f.payload, kUsbPingLen);
+        const uint32_t rx = tick(f.t), tx = tick(t3);
+        std::memcpy(pong + 12, &rx, 4);
+        std::memcpy(pong + 16, &tx, 4);
+        queue_out(t3 + std::chrono::duration_cast<TimePoint::duration>(
+                           std::chrono::duration<double>(p_.link_delay_us * 1e-6)),
+                  USB_RX_PONG, pong, kUsbPongLen);
+        std::lock_guard<std::mutex> lk(mtx_);
+        ++stats_.pings;
+    }
+}
+
+void McuSimulator::step_gimbal(TimePoint now) {
+    constexpr float kMaxStep = 2.5e-4f;
+    float left = std::chrono::duration<float>(now - last_step_).count();
+    TimePoint t = last_step_;
+    while (left > 0.0f) {
+        const float h = std::min(left, kMaxStep);
+        t += std::chrono::duration_cast<TimePoint::duration>(std::chrono::duration<float>(h));
+        while (!yaw_set_.empty() && yaw_set_.front().first <= t) {
+            yaw_target_ = yaw_set_.front().second;
+            yaw_set_.erase(yaw_set_.begin());
+        }
+        while (!pitch_set_.empty() && pitch_set_.front().first <= t) {
+            pitch_target_ = pitch_set_.front().second;
+            pitch_set_.erase(pitch_set_.begin());
+        }
+        gimbal_axis_step(p_.yaw, yaw_target_, h, yaw_, yaw_rate_);
+        gimbal_axis_step(p_.pitch, pitch_target_, h, pitch_, pitch_rate_);
+        left -= h;
+    }
+    last_step_ = now;
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    gimbal_yaw_   = yaw_;
+    gimbal_pitch_ = pitch_;
+}
+
+void McuSimulator::run() {
+    std::normal_distribution<float> noise(0.0f, p_.speed_sigma);
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+    const auto delay = std::chrono::duration_cast<TimePoint::duration>(
+        std::chrono::duration<double>(p_.link_delay_us * 1e-6));
+
+    while (running_.load(std::memory_order_relaxed)) {
+        // wake for input, the next delayed frame, or the 1 ms gimbal step
+        TimePoint wake = std::chrono::steady_clock::now() + std::chrono::milliseconds(1);
+        if (!in_.empty())  wake = std::min(wake, in_.front().t);
+        if (!out_.empty()) wake = std::min(wake, out_.front().t);
+        const auto wait = std::max(wake - std::chrono::steady_clock::now(), TimePoint::duration::zero());
+        const timespec ts{time_t(std::chrono::duration_cast<std::chrono::seconds>(wait).count()),
+                          long(std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count() % 1000000000)};
+        pollfd pfd{port_.master(), POLLIN, 0};
+        ::ppoll(&pfd, 1, &ts, nullptr);
+        const TimePoint now = std::chrono::steady_clock::now();
+
+        receive(now);
+        while (!in_.empty() && in_.front().t <= now) {
+            handle(in_.front());
+            in_.pop_front();
+        }
+        step_gimbal(now);
+
+        if (p_.feedback_rate_hz > 0.0 && now >= next_feedback_) {
+            uint8_t fb[kUsbGimbalLen];
+            const uint32_t t = tick(now);
+            std::memcpy(fb, &yaw_, 4);
+            std::memcpy(fb + 4, &pitch_, 4);
+            std::memcpy(fb + 8, &t, 4);
+            queue_out(now + delay, USB_RX_GIMBAL, fb, kUsbGimbalLen);
+            next_feedback_ += std::chrono::duration_cast<TimePoint::duration>(
+                std::chrono::duration<double>(1.0 / p_.feedback_rate_hz));
+            if (next_feedback_ < now) next_feedback_ = now;
+            std::lock_guard<std::mutex> lk(mtx_);
+            ++stats_.feedback;
+        }
+
+        float speed;
+        uint8_t mode;
+        int fire;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            speed = speed_;
+            mode  = mode_;
+            fire  = cmd_.fire;
+        }
+        if (!fire || p_.shot_rate_hz <= 0.0) {
+            next_shot_ = now;
+        } else if (now >= next_shot_) {
+            float v = speed + noise(rng_);
+            if (u(rng_) < p_.speed_outlier_prob) v += (u(rng_) < 0.5f ? -1.0f : 1.0f) * (3.0f + 5.0f * u(rng_));
+            uint8_t rep[kUsbShooterLen];
+            std::memcpy(rep, &v, 4);
+            rep[4] = mode;
+            queue_out(now + delay, USB_RX_SHOOTER, rep, kUsbShooterLen);
+            next_shot_ = now + std::chrono::duration_cast<TimePoint::duration>(
+                                   std::chrono::duration<double>(1.0 / p_.shot_rate_hz));
+            std::lock_guard<std::mutex> lk(mtx_);
+            ++stats_.shots;
+        }
+
+        flush_out(now);
+    }
+}
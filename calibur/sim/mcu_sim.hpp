@@ -0,0 +1,130 @@
+// calibur/sim/mcu_sim.hpp
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../worker/gimbal_model.hpp"
+#include "../worker/usb_protocol.hpp"
+#include "pty_port.hpp"
+
+// Gimbal MCU stand-in on a pty, speaking usb_protocol.hpp:
+//
+//  - USB_TX_AIM moves the simulated gimbal: the command is relative to the
+//    current angle, the axes follow the rate-limited second-order model of
+//    gimbal_model.hpp (dead time included).
+//  - USB_TX_STATE latches aim / fire / chase; while fire is set the shooter
+//    reports a muzzle speed (USB_RX_SHOOTER) at shot_rate_hz.
+//  - USB_TX_PING is answered with USB_RX_PONG stamped by a drifting,
+//    wrapping 32-bit microsecond tick.
+//  - USB_RX_GIMBAL reports the measured gimbal angles at feedback_rate_hz.
+//
+// Every frame in either direction is delayed by link_delay_us on the
+// simulated wire. Outgoing frames can be corrupted, dropped or preceded by
+// line noise.
+
+struct McuSimParams {
+    double   clock_drift   = 0.0;    // MCU tick rate error
+    uint32_t tick_start_us = 0;      // MCU tick at start
+    double   link_delay_us = 0.0;    // per direction
+    double   turnaround_us = 20.0;   // ping reception to pong transmission
+
+    double  shot_rate_hz       = 10.0;
+    float   bullet_speed       = 15.5f;   // m/s
+    float   speed_sigma        = 0.15f;
+    double  speed_outlier_prob = 0.0;     // report off by 3..8 m/s
+    uint8_t speed_mode         = 0;
+
+    GimbalAxisParams yaw;
+    GimbalAxisParams pitch;
+    double feedback_rate_hz = 200.0;      // 0: no USB_RX_GIMBAL
+
+    // faults on outgoing frames
+    double   corrupt_prob = 0.0;
+    double   drop_prob    = 0.0;
+    double   garbage_prob = 0.0;
+    uint32_t seed         = 1;
+};
+
+struct McuSimStats {
+    uint64_t aims      = 0;   // USB_TX_AIM received
+    uint64_t states    = 0;   // USB_TX_STATE received
+    uint64_t pings     = 0;
+    uint64_t rx_bad    = 0;   // bad checksum / oversize on the command stream
+    uint64_t shots     = 0;   // USB_RX_SHOOTER sent
+    uint64_t feedback  = 0;   // USB_RX_GIMBAL sent
+    uint64_t corrupted = 0;
+    uint64_t dropped   = 0;
+};
+
+struct McuCommand {
+    float yaw = 0.0f, pitch = 0.0f;
+    int   aim = 0, fire = 0, chase = 0;
+    uint64_t count = 0;
+};
+
+class McuSimulator {
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    explicit McuSimulator(const McuSimParams &p = McuSimParams());
+    ~McuSimulator();
+
+    bool start(const std::string &link = "");
+    void stop();
+
+    const std::string &device() const { return port_.device(); }
+    McuSimStats stats() const;
+
+    McuCommand last_command() const;
+    void gimbal(float &yaw, float &pitch) const;
+    void set_bullet_speed(float speed, uint8_t mode);
+
+    // Ground truth MCU clock, seconds, unwrapped.
+    double mcu_seconds(TimePoint t) const;
+
+private:
+    struct Pending {
+        TimePoint t;   // due: processed (incoming) or written (outgoing)
+        uint8_t   type;
+        uint16_t  len;
+        uint8_t   payload[kUsbMaxPayload];
+    };
+
+    void run();
+    void receive(TimePoint now);
+    void handle(const Pending &f);
+    void queue_out(TimePoint t, uint8_t type, const void *payload, uint16_t len);
+    void flush_out(TimePoint now);
+    void step_gimbal(TimePoint now);
+    uint32_t tick(TimePoint t) const;
+
+    McuSimParams p_;
+    PtyPort      port_;
+    TimePoint    start_;
+    std::atomic<bool> running_{false};
+    std::thread       thread_;
+
+    // sim thread only
+    UsbFrameParser      parser_;
+    std::deque<Pending> in_, out_;
+    std::vector<std::pair<TimePoint, float>> yaw_set_, pitch_set_;   // setpoints waiting out the dead time
+    float     yaw_ = 0.0f, yaw_rate_ = 0.0f, pitch_ = 0.0f, pitch_rate_ = 0.0f;
+    float     yaw_target_ = 0.0f, pitch_target_ = 0.0f;
+    TimePoint last_step_, next_feedback_, next_shot_;
+    std::mt19937 rng_;
+
+    mutable std::mutex mtx_;   // shared with the accessors
+    McuCommand  cmd_;
+    McuSimStats stats_;
+    float       gimbal_yaw_ = 0.0f, gimbal_pitch_ = 0.0f;
+    float       speed_;
+    uint8_t     mode_;
+};
@@ -0,0 +1,76 @@
+// calibur/sim/pty_port.cpp
+#include "pty_port.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+PtyPort::~PtyPort() {
+    close();
+}
+
+bool PtyPort::open(const std::string &link) {
+    close();
+
+    termios tio{};
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, B460800);
+    cfsetospeed(&tio, B460800);
+    char name[256];
+    if (openpty(&master_, &slave_, name, &tio, nullptr) != 0) {
+        std::perror("openpty");
+        master_ = slave_ = -1;
+        return false;
+    }
+    slave_name_ = name;
+
+    const int flags = fcntl(master_, F_GETFL);
+    fcntl(master_, F_SETFL, flags | O_NONBLOCK);
+    fcntl(master_, F_SETFD, FD_CLOEXEC);
+    fcntl(slave_, F_SETFD, FD_CLOEXEC);
+
+    if (!link.empty()) {
+        ::unlink(link.c_str());
+        if (::symlink(slave_name_.c_str(), link.c_str()) != 0) {
+            std::perror("symlink");
+            close();
+            return false;
+        }
+        link_ = link;
+    }
+    return true;
+}
+
+void PtyPort::close() {
+    if (!link_.empty()) ::unlink(link_.c_str());
+    link_.clear();
+    if (slave_ >= 0) ::close(slave_);
+    if (master_ >= 0) ::close(master_);
+    master_ = slave_ = -1;
+    slave_name_.clear();
+}
+
+bool PtyPort::write_all(const uint8_t *p, size_t n, int timeout_ms) {
+    size_t off = 0;
+    while (off < n) {
+        const ssize_t w = ::write(master_, p + off, n - off);
+        if (w > 0) {
+            off += size_t(w);
+            continue;
+        }
+        if (w < 0 && errno != EAGAIN && errno != EINTR) return false;
+        pollfd pfd{master_, POLLOUT, 0};
+        if (::poll(&pfd, 1, timeout_ms) <= 0) return false;
+    }
+    return true;
+}
+
+long PtyPort::read_some(uint8_t *p, size_t n) {
+    const ssize_t r = ::read(master_, p, n);
+    if (r < 0) return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+    return long(r);
+}
@@ -0,0 +1,38 @@
+// calibur/sim/pty_port.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Pseudo-terminal pair for the serial simulators. The simulator talks on
+// the master side; the code under test opens device() as if it were the
+// real /dev/tty*. The slave starts in raw mode and is held open, so the
+// pair survives the client closing and reopening it.
+class PtyPort {
+public:
+    PtyPort() = default;
+    ~PtyPort();
+    PtyPort(const PtyPort &) = delete;
+    PtyPort &operator=(const PtyPort &) = delete;
+
+    // link: optional symlink to the slave (e.g. /tmp/ttyIMU), replaced if
+    // it already exists.
+    bool open(const std::string &link = "");
+    void close();
+
+    int master() const { return master_; }
+    const std::string &device() const { return link_.empty() ? slave_name_ : link_; }
+
+    // Writes everything, waiting up to timeout_ms for the client to drain.
+    bool write_all(const uint8_t *p, size_t n, int timeout_ms = 100);
+
+    // Non-blocking read: bytes read, 0 if nothing is pending, -1 on error.
+    long read_some(uint8_t *p, size_t n);
+
+private:
+    int         master_ = -1;
+    int         slave_  = -1;
+    std::string slave_name_;
+    std::string link_;
+};
@@ -10,8 +10,9 @@ namespace calibur {
 
 static calibur::Logger::ptr g_logger = CALIBUR_LOG_NAME("usb");
 
-    USBCommunication::USBCommunication(const std::string& device_path)
+    USBCommunication::USBCommunication(const std::string& device_path, int baudrate)
         : device_path_(device_path)
+        , baudrate_(baudrate)
         , fd_(-1)
         , is_open_(false) {
         CALIBUR_LOG_INFO(g_logger) << "USBCommunication created for device: " << device_path_;
@@ -38,7 +39,7 @@ static calibur::Logger::ptr g_logger = CALIBUR_LOG_NAME("usb");
         
         is_open_ = true;
         CALIBUR_LOG_INFO(g_logger) << "USB device opened successfully";
-        return configure();
+        return configure(baudrate_);
     }
 
     bool USBCommunication::close() {
@@ -100,6 +101,8 @@ static calibur::Logger::ptr g_logger = CALIBUR_LOG_NAME("usb");
         tty.c_lflag = 0;
         tty.c_oflag = 0;
         tty.c_iflag &= ~(IXON | IXOFF | IXANY);
+        // binary input: no CR/NL translation, stripping or break handling
+        tty.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL);
         
         // Non-blocking writes
         tty.c_cc[VMIN]  = 0;
@@ -147,4 +150,21 @@ static calibur::Logger::ptr g_logger = CALIBUR_LOG_NAME("usb");
         return true;
     }
 
-} 
\ No newline at end of file
+    ssize_t USBCommunication::readData(uint8_t* buf, size_t len) {
+        if (!is_open_ || fd_ < 0) {
+            return -1;
+        }
+
+        // VMIN = VTIME = 0: returns at once with what the driver holds
+        ssize_t n = read(fd_, buf, len);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                return 0;
+            }
+            CALIBUR_LOG_ERROR(g_logger) << "Read failed: " << strerror(errno);
+            return -1;
+        }
+        return n;
+    }
+
+}  
\ No newline at end of file
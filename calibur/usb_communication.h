@@ -3,12 +3,13 @@
 
 #include <string>
 #include <cstdint>
+#include <sys/types.h>
 
 namespace calibur {
 
     class USBCommunication {
         public:
-        USBCommunication(const std::string& device_path);
+        USBCommunication(const std::string& device_path, int baudrate = 115200);
         ~USBCommunication();
         
         bool open();
@@ -17,12 +18,19 @@ namespace calibur {
         
         // Send yaw and pitch
         bool sendData(float yaw, float pitch, bool is_fire);
+
+        // Non-blocking read of whatever has arrived: bytes read, 0 if
+        // nothing is pending, -1 on error.
+        ssize_t readData(uint8_t* buf, size_t len);
+
+        int fd() const { return fd_; }
         
         // Configuration
         bool configure(int baudrate = 115200);
 
         private:
             std::string device_path_;
+            int baudrate_;
             int fd_;
             bool is_open_;
     };  
@@ -0,0 +1,242 @@
+// ballistic.cpp
+#include "ballistic.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// Integration runs in double: ~2000 steps of float RK4 accumulate ~0.3 mm.
+struct Shot { double x, y, vx, vy; };
+
+inline Shot deriv(const Shot &s, double k, double g) {
+    const double v = std::sqrt(s.vx * s.vx + s.vy * s.vy);
+    return {s.vx, s.vy, -k * v * s.vx, -k * v * s.vy - g};
+}
+
+inline Shot rk4(const Shot &s, double dt, double k, double g) {
+    const double h = 0.5 * dt;
+    const Shot k1 = deriv(s, k, g);
+    const Shot k2 = deriv({s.x + h * k1.x, s.y + h * k1.y, s.vx + h * k1.vx, s.vy + h * k1.vy}, k, g);
+    const Shot k3 = deriv({s.x + h * k2.x, s.y + h * k2.y, s.vx + h * k2.vx, s.vy + h * k2.vy}, k, g);
+    const Shot k4 = deriv({s.x + dt * k3.x, s.y + dt * k3.y, s.vx + dt * k3.vx, s.vy + dt * k3.vy}, k, g);
+    const double w = dt / 6.0;
+    return {s.x  + w * (k1.x  + 2.0 * k2.x  + 2.0 * k3.x  + k4.x),
+            s.y  + w * (k1.y  + 2.0 * k2.y  + 2.0 * k3.y  + k4.y),
+            s.vx + w * (k1.vx + 2.0 * k2.vx + 2.0 * k3.vx + k4.vx),
+            s.vy + w * (k1.vy + 2.0 * k2.vy + 2.0 * k3.vy + k4.vy)};
+}
+
+inline Shot launch(double speed, double pitch) {
+    return {0.0, 0.0, speed * std::cos(pitch), speed * std::sin(pitch)};
+}
+
+// Cubic Hermite between two integration steps, parametrized by x:
+// dy/dx = vy / vx, dt/dx = 1 / vx.
+inline void hermite_at(const Shot &a, const Shot &b, double t0, double dt, double x,
+                       float &y, float &t) {
+    const double dx = b.x - a.x;
+    const double s  = (x - a.x) / dx;
+    const double s2 = s * s, s3 = s2 * s;
+    const double h00 = 2.0 * s3 - 3.0 * s2 + 1.0;
+    const double h10 = s3 - 2.0 * s2 + s;
+    const double h01 = -2.0 * s3 + 3.0 * s2;
+    const double h11 = s3 - s2;
+    y = float(h00 * a.y + h10 * dx * (a.vy / a.vx) + h01 * b.y + h11 * dx * (b.vy / b.vx));
+    t = float(h00 * t0  + h10 * dx / a.vx          + h01 * (t0 + dt) + h11 * dx / b.vx);
+}
+
+} // namespace
+
+// ===================== Direct integration =====================
+
+bool ballistic_simulate(float speed, float pitch, float d, const BallisticParams &p,
+                        float &h, float &t) {
+    Shot s = launch(speed, pitch);
+    double ts = 0.0;
+    while (ts < p.t_max) {
+        const Shot n = rk4(s, p.dt, p.drag_k, p.g);
+        if (n.x >= d) {
+            // land exactly on x = d: shorten the last step (two Newton passes)
+            double tau = p.dt * (d - s.x) / (n.x - s.x);
+            for (int it = 0; it < 2; ++it) {
+                const Shot m = rk4(s, tau, p.drag_k, p.g);
+                tau += (d - m.x) / m.vx;
+            }
+            const Shot m = rk4(s, tau, p.drag_k, p.g);
+            h = float(m.y);
+            t = float(ts + tau);
+            return true;
+        }
+        s = n;
+        ts += p.dt;
+    }
+    return false;
+}
+
+bool ballistic_solve(float speed, float d, float h, const BallisticParams &p,
+                     BallisticSolution &out) {
+    // coarse scan up the low-arc branch for a bracket, then bisect
+    constexpr float kScan = 0.02f;
+    float lo = p.pitch_min, h_prev = -std::numeric_limits<float>::infinity(), y, t;
+    float hi = lo;
+    bool bracketed = false;
+    for (float a = p.pitch_min; a <= p.pitch_max; a += kScan) {
+        if (!ballistic_simulate(speed, a, d, p, y, t)) y = -std::numeric_limits<float>::infinity();
+        if (y < h_prev) break;                 // past the top of the low arc
+        if (y >= h) {
+            hi = a;
+            bracketed = a > p.pitch_min;
+            break;
+        }
+        lo = a;
+        h_prev = y;
+    }
+    if (!bracketed) return false;
+
+    for (int it = 0; it < 40; ++it) {
+        const float mid = 0.5f * (lo + hi);
+        if (ballistic_simulate(speed, mid, d, p, y, t) && y >= h) hi = mid;
+        else lo = mid;
+    }
+    out.pitch = 0.5f * (lo + hi);
+    return ballistic_simulate(speed, out.pitch, d, p, y, out.time);
+}
+
+bool ballistic_solve_vacuum(float speed, float d, float h, float g, BallisticSolution &out) {
+    const float v2   = speed * speed;
+    const float disc = v2 * v2 - g * (g * d * d + 2.0f * h * v2);
+    if (disc < 0.0f || d <= 0.0f) return false;
+    out.pitch = std::atan2(v2 - std::sqrt(disc), g * d);
+    out.time  = d / (speed * std::cos(out.pitch));
+    return true;
+}
+
+// ===================== Lookup table ===========================
+
+BallisticTable::BallisticTable(float speed, const BallisticParams &p)
+    : speed_(speed), p_(p)
+{
+    nd_ = int(std::lround((p.d_max - p.d_min) / p.d_step)) + 1;
+    nh_ = int(std::lround((p.h_max - p.h_min) / p.h_step)) + 1;
+    inv_d_step_ = 1.0f / p.d_step;
+    inv_h_step_ = 1.0f / p.h_step;
+
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const int na = int(std::lround((p.pitch_max - p.pitch_min) / p.pitch_step)) + 1;
+
+    // 1) fan of shots: height / time where each crosses every grid distance
+    std::vector<float> Y(size_t(na) * nd_, nan), T(size_t(na) * nd_, nan);
+    const float y_floor = p.h_min - 1.0f;
+    for (int j = 0; j < na; ++j) {
+        float *yj = &Y[size_t(j) * nd_];
+        float *tj = &T[size_t(j) * nd_];
+        Shot s = launch(speed, p.pitch_min + j * double(p.pitch_step));
+        double ts = 0.0;
+        int i = 0;
+        while (i < nd_ && ts < p.t_max) {
+            const Shot n = rk4(s, p.dt, p.drag_k, p.g);
+            for (; i < nd_; ++i) {
+                const double d = p.d_min + i * double(p.d_step);
+                if (d > n.x) break;
+                if (d >= s.x) hermite_at(s, n, ts, p.dt, d, yj[i], tj[i]);
+            }
+            s = n;
+            ts += p.dt;
+            if (s.vy < 0.0f && s.y < y_floor) break;     // below the grid for good
+        }
+    }
+
+    // 2) invert h(pitch) at each distance on the rising (low-arc) branch
+    cells_.assign(size_t(nh_) * nd_, Cell{nan, nan});
+    for (int i = 0; i < nd_; ++i) {
+        int j = 0;
+        while (j < na && !(Y[size_t(j) * nd_ + i] == Y[size_t(j) * nd_ + i])) ++j;
+        if (j >= na) continue;
+        const int j0 = j;
+
+        for (int k = 0; k < nh_; ++k) {
+            const float h = p.h_min + k * p.h_step;
+            if (h < Y[size_t(j0) * nd_ + i]) continue;   // needs more than pitch_min down
+
+            // advance until Y[j] <= h < Y[j + 1], stop at the top of the arc
+            while (j + 1 < na) {
+                const float yn = Y[size_t(j + 1) * nd_ + i];
+                if (!(yn > Y[size_t(j) * nd_ + i]) || yn > h) break;
+                ++j;
+            }
+            if (j + 1 >= na) break;
+            const float ya = Y[size_t(j) * nd_ + i], yb = Y[size_t(j + 1) * nd_ + i];
+            if (!(yb > ya) || h > yb) break;             // above the reachable apex
+
+            const float w  = (h - ya) / (yb - ya);
+            const float ta = T[size_t(j) * nd_ + i], tb = T[size_t(j + 1) * nd_ + i];
+            Cell &c = cells_[size_t(k) * nd_ + i];
+            c.pitch = p.pitch_min + (j + w) * p.pitch_step;
+            c.time  = ta + w * (tb - ta);
+        }
+    }
+}
+
+// ===================== Speed tracking =========================
+
+BallisticSolver::BallisticSolver(const BallisticParams &p, float initial_speed, float quantum,
+                                 int cache_size)
+    : p_(p), quantum_(quantum), cache_size_(std::max(cache_size, 1))
+{
+    const float q = quantize(initial_speed);
+    auto t = std::make_shared<const BallisticTable>(q, p_);
+    builds_.store(1, std::memory_order_relaxed);
+    wanted_.store(q);
+    cache_.push_back(t);
+    std::atomic_store(&table_, t);
+}
+
+std::shared_ptr<const BallisticTable> BallisticSolver::find_cached(float speed_q) {
+    std::lock_guard<std::mutex> lk(cache_mtx_);
+    for (auto it = cache_.begin(); it != cache_.end(); ++it) {
+        if (std::fabs((*it)->speed() - speed_q) < 0.01f * quantum_) {
+            auto t = *it;
+            cache_.erase(it);
+            cache_.push_back(t);
+            return t;
+        }
+    }
+    return nullptr;
+}
+
+void BallisticSolver::update_speed(float speed) {
+    if (!std::isfinite(speed) || speed <= 1.0f) return;
+
+    const auto cur = std::atomic_load(&table_);
+    if (cur && std::fabs(speed - cur->speed()) <= 0.75f * quantum_) return;
+
+    const float q = quantize(speed);
+    if (auto t = find_cached(q)) {
+        std::atomic_store(&table_, t);
+        return;
+    }
+    wanted_.store(q);
+    if (!pending_.exchange(true, std::memory_order_acq_rel)) {
+        pool_.submit([this] { build_loop(); });
+    }
+}
+
+// Runs on pool_. Builds until the wanted speed stops changing under it.
+void BallisticSolver::build_loop() {
+    for (;;) {
+        const float q = wanted_.load();
+        auto t = find_cached(q);
+        if (!t) {
+            t = std::make_shared<const BallisticTable>(q, p_);
+            builds_.fetch_add(1, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lk(cache_mtx_);
+            cache_.push_back(t);
+            if (int(cache_.size()) > cache_size_) cache_.erase(cache_.begin());
+        }
+        std::atomic_store(&table_, t);
+
+        pending_.store(false, std::memory_order_release);
+        if (wanted_.load() == q || pending_.exchange(true, std::memory_order_acq_rel)) return;
+    }
+}
@@ -0,0 +1,152 @@
+// ballistic.hpp
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+// Projectile with quadratic air drag, a = -k |v| v - g, in the vertical plane
+// of the shot: d horizontal distance from the muzzle, h height above it (up
+// positive). k = 0.5 * rho * Cd * A / m.
+//
+// BallisticTable precomputes, for one bullet speed, the launch pitch and the
+// flight time over a (d, h) grid (low arc only), so PredictionWorker gets
+// both from a bilinear lookup instead of re-solving the trajectory.
+// BallisticSolver keeps the table of the current (quantized) bullet speed and
+// rebuilds it on a background thread when the measured speed drifts.
+
+struct BallisticParams {
+    float g          = 9.81f;
+    float drag_k     = 0.019f;    // 1/m, 17 mm projectile: 3.2 g, Cd 0.47
+
+    // lookup grid
+    float d_min      = 0.5f;      // m
+    float d_max      = 25.0f;
+    float d_step     = 0.05f;
+    float h_min      = -3.0f;
+    float h_max      = 3.0f;
+    float h_step     = 0.05f;
+
+    // build: fan of launch angles integrated with RK4
+    float pitch_min  = -0.8f;     // rad
+    float pitch_max  = 0.8f;
+    float pitch_step = 2e-3f;
+    float dt         = 1e-3f;     // s
+    float t_max      = 3.0f;      // s, longest flight tabulated
+};
+
+struct BallisticSolution {
+    float pitch;   // launch elevation, rad, up positive
+    float time;    // flight time, s
+};
+
+// ===================== Direct integration =====================
+
+// Height and time at which a shot (speed, pitch) reaches horizontal distance
+// d. False if it never gets there (falls short within t_max).
+bool ballistic_simulate(float speed, float pitch, float d, const BallisticParams &p,
+                        float &h, float &t);
+
+// Low-arc pitch that hits (d, h), by bisection on ballistic_simulate.
+// Reference solution for tests, a few ms per call.
+bool ballistic_solve(float speed, float d, float h, const BallisticParams &p,
+                     BallisticSolution &out);
+
+// Drag-free closed form (the model the table replaces), for comparison.
+bool ballistic_solve_vacuum(float speed, float d, float h, float g, BallisticSolution &out);
+
+// ===================== Lookup table ===========================
+
+class BallisticTable {
+public:
+    BallisticTable(float speed, const BallisticParams &p);
+
+    float speed() const { return speed_; }
+    const BallisticParams &params() const { return p_; }
+    size_t bytes() const { return cells_.size() * sizeof(Cell); }
+
+    // Bilinear in (d, h). False outside the grid or where a corner is
+    // unreachable (too high / too far for this speed).
+    bool lookup(float d, float h, BallisticSolution &out) const {
+        const float fx = (d - p_.d_min) * inv_d_step_;
+        const float fy = (h - p_.h_min) * inv_h_step_;
+        if (!(fx >= 0.0f && fx <= float(nd_ - 1) && fy >= 0.0f && fy <= float(nh_ - 1)))
+            return false;
+
+        const int ix = std::min(int(fx), nd_ - 2);
+        const int iy = std::min(int(fy), nh_ - 2);
+        const float ax = fx - float(ix);
+        const float ay = fy - float(iy);
+
+        const Cell *c0 = &cells_[size_t(iy) * nd_ + ix];
+        const Cell *c1 = c0 + nd_;
+        const float p0 = c0[0].pitch + ax * (c0[1].pitch - c0[0].pitch);
+        const float p1 = c1[0].pitch + ax * (c1[1].pitch - c1[0].pitch);
+        const float t0 = c0[0].time  + ax * (c0[1].time  - c0[0].time);
+        const float t1 = c1[0].time  + ax * (c1[1].time  - c1[0].time);
+
+        out.pitch = p0 + ay * (p1 - p0);
+        out.time  = t0 + ay * (t1 - t0);
+        return out.pitch == out.pitch;   // NaN marks unreachable cells
+    }
+
+private:
+    struct Cell { float pitch, time; };
+
+    float speed_;
+    BallisticParams p_;
+    int   nd_, nh_;
+    float inv_d_step_, inv_h_step_;
+    std::vector<Cell> cells_;   // [nh_][nd_], distance fastest
+};
+
+// ===================== Speed tracking =========================
+
+class BallisticSolver {
+public:
+    // quantum: table speeds are multiples of it; a rebuild starts once the
+    // measured speed is more than 0.75 quantum away from the table's.
+    BallisticSolver(const BallisticParams &p, float initial_speed, float quantum = 0.1f,
+                    int cache_size = 4);
+
+    BallisticSolver(const BallisticSolver&) = delete;
+    BallisticSolver& operator=(const BallisticSolver&) = delete;
+
+    // Non-blocking. Swaps in a cached table or queues a background build;
+    // lookups keep using the previous table until the new one is ready.
+    void update_speed(float speed);
+
+    bool lookup(float d, float h, BallisticSolution &out) const {
+        const std::shared_ptr<const BallisticTable> t = std::atomic_load(&table_);
+        return t && t->lookup(d, h, out);
+    }
+
+    std::shared_ptr<const BallisticTable> table() const { return std::atomic_load(&table_); }
+    int  builds() const { return builds_.load(std::memory_order_relaxed); }
+    bool rebuilding() const { return pending_.load(std::memory_order_acquire); }
+
+private:
+    float quantize(float speed) const { return std::round(speed / quantum_) * quantum_; }
+    std::shared_ptr<const BallisticTable> find_cached(float speed_q);
+    void build_loop();
+
+    BallisticParams p_;
+    float quantum_;
+    int   cache_size_;
+
+    std::shared_ptr<const BallisticTable> table_;      // atomic_load / atomic_store
+    std::atomic<float> wanted_{0.0f};                  // quantized speed to build
+    std::atomic<bool>  pending_{false};
+    std::atomic<int>   builds_{0};
+
+    std::mutex cache_mtx_;
+    std::vector<std::shared_ptr<const BallisticTable>> cache_;   // most recent last
+
+    ThreadPool pool_{1};   // declared last: joined before the members above go
+};
@@ -0,0 +1,107 @@
+// bullet_speed.cpp
+#include "bullet_speed.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+float median(const float *v, int n) {
+    float tmp[kBulletSpeedMaxWin];
+    std::copy(v, v + n, tmp);
+    const int h = n / 2;
+    std::nth_element(tmp, tmp + h, tmp + n);
+    if (n & 1) return tmp[h];
+    const float hi = tmp[h];
+    return 0.5f * (hi + *std::max_element(tmp, tmp + h));
+}
+
+} // namespace
+
+// ===================== BulletSpeedEstimator =====================
+
+BulletSpeedEstimator::BulletSpeedEstimator(const BulletSpeedParams &p) : p_(p) {
+    p_.window        = std::clamp(p_.window, 1, kBulletSpeedMaxWin);
+    p_.relock        = std::clamp(p_.relock, 1, kBulletSpeedMaxWin);
+    p_.min_to_reject = std::max(p_.min_to_reject, 1);
+}
+
+float BulletSpeedEstimator::estimate(int mode) const {
+    const Track &t = tracks_[std::clamp(mode, 0, kBulletSpeedModes - 1)];
+    return t.valid ? t.ewma : p_.default_speed;
+}
+
+void BulletSpeedEstimator::push(Track &t, float v) {
+    t.win[t.head] = v;
+    t.head = (t.head + 1) % p_.window;
+    t.n    = std::min(t.n + 1, p_.window);
+}
+
+bool BulletSpeedEstimator::add(float speed, int mode) {
+    mode_ = std::clamp(mode, 0, kBulletSpeedModes - 1);
+    if (!(speed >= p_.min_speed && speed <= p_.max_speed)) {
+        ++rejected_;
+        return false;
+    }
+    Track &t = tracks_[mode_];
+
+    if (t.n >= p_.min_to_reject && std::fabs(speed - median(t.win, t.n)) > p_.max_dev) {
+        // keep the latest `relock` outliers; once they agree, they are the new speed
+        if (t.n_pending == p_.relock) {
+            std::copy(t.pending + 1, t.pending + t.n_pending, t.pending);
+            --t.n_pending;
+        }
+        t.pending[t.n_pending++] = speed;
+
+        if (t.n_pending == p_.relock) {
+            const float m = median(t.pending, t.n_pending);
+            bool agree = true;
+            for (int i = 0; i < t.n_pending; ++i)
+                agree = agree && std::fabs(t.pending[i] - m) <= p_.max_dev;
+            if (agree) {
+                t.n = t.head = 0;
+                for (int i = 0; i < t.n_pending; ++i) push(t, t.pending[i]);
+                t.n_pending = 0;
+                t.ewma = m;
+                ++accepted_;
+                return true;
+            }
+        }
+        ++rejected_;
+        return false;
+    }
+
+    t.n_pending = 0;
+    push(t, speed);
+    const float m = median(t.win, t.n);
+    if (t.valid) {
+        t.ewma += p_.alpha * (m - t.ewma);
+    } else {
+        t.ewma  = m;
+        t.valid = true;
+    }
+    ++accepted_;
+    return true;
+}
+
+// ===================== BulletSpeedRx =====================
+
+BulletSpeedRx::BulletSpeedRx(const BulletSpeedParams &p, std::atomic<float> &out)
+    : est_(p), out_(out) {}
+
+size_t BulletSpeedRx::feed(const uint8_t *data, size_t n) {
+    size_t reports = 0;
+    parser_.feed(data, n, [&](uint8_t type, const uint8_t *payload, uint16_t len) {
+        reports += on_frame(type, payload, len);
+    });
+    return reports;
+}
+
+bool BulletSpeedRx::on_frame(uint8_t type, const uint8_t *payload, uint16_t len) {
+    if (type != USB_RX_SHOOTER || len != kUsbShooterLen) return false;
+    float speed;
+    std::memcpy(&speed, payload, sizeof(speed));
+    est_.add(speed, payload[4]);
+    out_.store(est_.estimate(), std::memory_order_release);
+    return true;
+}
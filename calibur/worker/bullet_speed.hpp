@@ -0,0 +1,89 @@
+// bullet_speed.hpp
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "usb_protocol.hpp"
+
+// Bullet speed from the shooter's muzzle-speed reports (referee system via
+// the MCU, USB_RX_SHOOTER frames).
+//
+// Reports are noisy and occasionally garbage (double counts, a bullet that
+// grazed the barrel), and the speed moves in steps when the referee speed
+// mode changes. Per speed mode the estimator keeps the last `window`
+// accepted reports; a report further than max_dev from their median is an
+// outlier, the estimate is an EWMA of the median. If reports keep landing
+// away from the median but agree with each other (new projectile batch,
+// barrel heat), the window re-locks onto them.
+
+constexpr int kBulletSpeedModes  = 4;
+constexpr int kBulletSpeedMaxWin = 31;
+
+struct BulletSpeedParams {
+    int   window        = 9;       // reports per median, <= kBulletSpeedMaxWin
+    float alpha         = 0.2f;    // EWMA weight of the newest median
+    float max_dev       = 1.5f;    // m/s, outlier threshold around the median
+    int   min_to_reject = 4;       // window fill before outliers are rejected
+    int   relock        = 4;       // consecutive agreeing outliers that re-lock
+    float min_speed     = 5.0f;    // m/s, reports outside are dropped
+    float max_speed     = 35.0f;
+    float default_speed = 15.0f;   // until a mode has reports
+};
+
+class BulletSpeedEstimator {
+public:
+    explicit BulletSpeedEstimator(const BulletSpeedParams &p = BulletSpeedParams());
+
+    // Adds one report and makes `mode` current. False if it was rejected.
+    bool add(float speed, int mode);
+
+    float estimate() const { return estimate(mode_); }
+    float estimate(int mode) const;
+    int   mode() const { return mode_; }
+
+    uint64_t accepted() const { return accepted_; }
+    uint64_t rejected() const { return rejected_; }
+
+private:
+    struct Track {
+        float win[kBulletSpeedMaxWin];
+        int   n = 0, head = 0;
+        float pending[kBulletSpeedMaxWin];   // consecutive outliers
+        int   n_pending = 0;
+        float ewma = 0.0f;
+        bool  valid = false;
+    };
+
+    void push(Track &t, float v);
+
+    BulletSpeedParams p_;
+    std::array<Track, kBulletSpeedModes> tracks_;
+    int      mode_     = 0;
+    uint64_t accepted_ = 0;
+    uint64_t rejected_ = 0;
+};
+
+// RX glue: parses the raw byte stream, feeds shooter reports to the
+// estimator and publishes the current estimate to `out` (a single atomic
+// float store; readers never wait).
+class BulletSpeedRx {
+public:
+    BulletSpeedRx(const BulletSpeedParams &p, std::atomic<float> &out);
+
+    // Returns the number of shooter reports in data.
+    size_t feed(const uint8_t *data, size_t n);
+
+    // One parsed frame (from SerialLink); true if it was a shooter report.
+    bool on_frame(uint8_t type, const uint8_t *payload, uint16_t len);
+
+    const BulletSpeedEstimator &estimator() const { return est_; }
+    const UsbFrameParser       &parser()    const { return parser_; }
+
+private:
+    BulletSpeedEstimator est_;
+    UsbFrameParser       parser_;
+    std::atomic<float>  &out_;
+};
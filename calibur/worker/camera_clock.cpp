@@ -0,0 +1,177 @@
+// calibur/worker/camera_clock.cpp
+#include "camera_clock.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+CameraClock::CameraClock(const CameraClockParams &p) : p_(p) {
+    p_.window        = std::clamp(p_.window, 4, kCameraClockMaxWin);
+    p_.min_samples   = std::clamp(p_.min_samples, 2, p_.window);
+    p_.best_fraction = std::clamp(p_.best_fraction, 0.01f, 1.0f);
+    p_.reset_count   = std::max(p_.reset_count, 1);
+}
+
+void CameraClock::reset() {
+    const uint64_t frames = est_.frames, dropped = est_.dropped, resets = est_.resets;
+    n_ = head_ = 0;
+    have_frame_ = false;
+    period_     = 0.0;
+    next_fit_   = 0.0;
+    jumps_      = 0;
+    est_ = CameraClockEstimate();
+    est_.frames  = frames;
+    est_.dropped = dropped;
+    est_.resets  = resets;
+}
+
+uint32_t CameraClock::count_dropped(uint32_t frame_num, double dt) {
+    uint32_t gap = 0;   // frame periods since the last frame
+    if (frame_num != last_num_) {
+        const uint32_t step = frame_num - last_num_;
+        gap = step < 0x10000u ? step : 0;   // backwards: grabbing restarted
+    } else if (period_ > 0.0 && dt > 1.5 * period_) {
+        gap = uint32_t(std::llround(dt / period_));
+    } else if (dt > 0.0) {
+        gap = 1;
+    }
+    if (gap > 0 && dt > 0.0) {
+        const double per = dt / gap;
+        if (period_ == 0.0) period_ = per;
+        else if (per < 1.5 * period_) period_ += 0.05 * (per - period_);
+    }
+    return gap > 1 ? gap - 1 : 0;
+}
+
+CameraFrameTime CameraClock::on_frame(uint32_t frame_num, uint64_t tick, double exposure,
+                                      TimePoint received) {
+    const double h = seconds(received);
+    CameraFrameTime out;
+    out.capture = time_point(h - p_.latency - 0.5 * exposure);
+    ++est_.frames;
+
+    if (have_frame_ && tick < last_tick_) {
+        // device time went backwards: the camera was reset
+        reset();
+        ++est_.resets;
+    }
+    if (!have_frame_) {
+        have_frame_ = true;
+        tick_base_  = tick;
+        detect_h_   = h;
+        est_.tick_hz = p_.tick_hz > 0.0 ? p_.tick_hz : 0.0;
+    } else {
+        const double dt = est_.tick_hz > 0.0 ? double(tick - last_tick_) / est_.tick_hz : 0.0;
+        out.dropped = count_dropped(frame_num, dt);
+        est_.dropped += out.dropped;
+    }
+    last_num_  = frame_num;
+    last_tick_ = tick;
+
+    if (est_.tick_hz <= 0.0) {
+        // unknown tick rate: the nearest power of ten to ticks per host s
+        if (h - detect_h_ < p_.detect_span || tick == tick_base_) return out;
+        const double rate = double(tick - tick_base_) / (h - detect_h_);
+        const double p10  = std::pow(10.0, std::round(std::log10(rate)));
+        est_.tick_hz = std::fabs(rate / p10 - 1.0) < 0.05 ? p10 : rate;
+    }
+
+    const double d = double(tick - tick_base_) / est_.tick_hz;
+    const double y = h - exposure - d;
+
+    if (est_.valid && std::fabs(y - (est_.handover(d) - d)) > p_.reset_jump) {
+        // a long queue only delays a frame or two; a device time that
+        // stays off the line means its clock was reset or re-latched
+        if (++jumps_ < p_.reset_count) {
+            out.capture = time_point(est_.handover(d) - p_.latency + 0.5 * exposure);
+            out.mapped  = true;
+            return out;
+        }
+        const uint32_t dropped = out.dropped;
+        reset();
+        ++est_.resets;
+        --est_.frames;
+        out = on_frame(frame_num, tick, exposure, received);
+        out.dropped = dropped;
+        return out;
+    }
+    jumps_ = 0;
+
+    if (n_ == 0 || d - last_kept_ >= p_.min_spacing) {
+        win_[head_] = Obs{d, y};
+        head_ = (head_ + 1) % p_.window;
+        n_    = std::min(n_ + 1, p_.window);
+        last_kept_ = d;
+    }
+    if (n_ >= p_.min_samples && h >= next_fit_) {
+        fit();
+        next_fit_ = h + p_.refit_period;
+    }
+    if (est_.valid) {
+        out.capture = time_point(est_.handover(d) - p_.latency + 0.5 * exposure);
+        out.mapped  = true;
+    }
+    return out;
+}
+
+void CameraClock::fit() {
+    const double d_ref = win_[(head_ + p_.window - 1) % p_.window].d;
+
+    double x_min = 0.0, x_max = 0.0;
+    for (int i = 0; i < n_; ++i) {
+        const double x = win_[i].d - d_ref;
+        x_min = std::min(x_min, x);
+        x_max = std::max(x_max, x);
+    }
+    const bool fit_slope = x_max - x_min >= p_.min_span;
+
+    // line through the observations whose residual is at most thr (all
+    // when res is null); the slope keeps its last value until the window
+    // is long enough
+    auto line = [&](double thr, const double *res, double &c, double &s) -> int {
+        double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+        int cnt = 0;
+        for (int i = 0; i < n_; ++i) {
+            if (res && res[i] > thr) continue;
+            const double x = win_[i].d - d_ref;
+            const double y = win_[i].y;
+            sx += x; sy += y; sxx += x * x; sxy += x * y;
+            ++cnt;
+        }
+        if (cnt == 0) return 0;
+        const double xbar = sx / cnt, ybar = sy / cnt;
+        const double vxx  = sxx - cnt * xbar * xbar;
+        if (fit_slope && cnt >= 3 && vxx > 0.0) s = (sxy - cnt * xbar * ybar) / vxx;
+        c = ybar - s * xbar;
+        return cnt;
+    };
+
+    // residual of every observation against the line, and the k-th lowest
+    double *res = res_.data();
+    auto residuals = [&](double c, double s, int k) -> double {
+        for (int i = 0; i < n_; ++i) res[i] = win_[i].y - (c + s * (win_[i].d - d_ref));
+        std::copy(res, res + n_, scratch_.begin());
+        std::nth_element(scratch_.begin(), scratch_.begin() + k, scratch_.begin() + n_);
+        return scratch_[k];
+    };
+
+    // mean line first, then twice through the lowest-delay fraction of its
+    // residuals: the first pass still leans towards the queued frames
+    const int k = std::clamp(int(p_.best_fraction * n_) - 1, 1, n_ - 1);
+    double c = 0.0, s = est_.slope;
+    line(0.0, nullptr, c, s);
+    int used = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        const double thr = residuals(c, s, k);
+        const int cnt = line(thr, res, c, s);
+        if (cnt == 0) break;
+        used = cnt;
+    }
+    if (used == 0) return;
+
+    est_.valid  = true;
+    est_.d_ref  = d_ref;
+    est_.offset = c;
+    est_.slope  = s;
+    est_.delay  = residuals(c, s, n_ / 2);
+    est_.used   = used;
+}
@@ -0,0 +1,120 @@
+// calibur/worker/camera_clock.hpp
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+// Maps the camera's device timestamps (MV_FRAME_OUT_INFO_EX
+// nDevTimeStampHigh/Low, a free-running 64-bit tick latched at frame
+// start) to host steady_clock, and counts frames the camera produced but
+// the host never saw.
+//
+// Each frame gives its device time d, its exposure e and the host time h
+// the SDK handed it over. Then
+//
+//   h - e - d = offset + slope * (d - d_ref) + latency + delay
+//
+// with the slope the rate mismatch of the two clocks, latency the fixed
+// readout + USB transfer time and delay whatever the SDK queue, the grab
+// loop and the pixel conversion added. Delay is one sided and often
+// several ms (a frame waiting in the SDK queue), so as in ClockSync the
+// line is fitted through the lowest-delay fraction of a window of
+// observations, not through their mean. The capture time is the fitted
+// frame start minus latency plus half the exposure.
+//
+// Frame numbers give dropped frames; when the camera leaves nFrameNum at
+// zero, gaps in device time of more than 1.5 frame periods do. Device
+// time going backwards (camera reset, grabbing restarted) or staying off
+// the fit for reset_count frames starts the fit over.
+
+struct CameraClockParams {
+    double tick_hz       = 1e9;     // device ticks per s; <= 0 detects the power of ten
+    double latency       = 0.0;     // s, exposure end to the earliest possible hand-over
+    int    window        = 2048;    // observations kept, <= kCameraClockMaxWin
+    double min_spacing   = 0.004;   // s of device time between kept observations
+    double refit_period  = 0.2;     // s
+    float  best_fraction = 0.1f;    // lowest-delay share used for the fit
+    double min_span      = 2.0;     // s of observations before the slope is fitted
+    int    min_samples   = 10;      // observations before the mapping is valid
+    double detect_span   = 0.5;     // s of frames used to detect tick_hz
+    double reset_jump    = 0.1;     // s off the fit that counts as a discontinuity
+    int    reset_count   = 5;       // consecutive discontinuities that restart the fit
+};
+
+constexpr int kCameraClockMaxWin = 4096;
+
+struct CameraClockEstimate {
+    bool     valid   = false;
+    double   tick_hz = 0.0;   // detected or configured
+    double   d_ref   = 0.0;   // device s (since the first frame) the line is anchored at
+    double   offset  = 0.0;   // s, host - device at d_ref (includes latency)
+    double   slope   = 0.0;   // d(host - device) / d(device)
+    double   delay   = 0.0;   // s, median hand-over delay above the fitted line
+    int      used    = 0;     // observations in the last fit
+    uint64_t frames  = 0;
+    uint64_t dropped = 0;     // frames lost between the camera and the host
+    uint64_t resets  = 0;
+
+    // device tick rate error against the host (ticks per host s, minus one)
+    double drift() const { return 1.0 / (1.0 + slope) - 1.0; }
+
+    // host s of the earliest hand-over of a frame started at device s
+    double handover(double dev_s) const { return dev_s + offset + slope * (dev_s - d_ref); }
+};
+
+struct CameraFrameTime {
+    std::chrono::steady_clock::time_point capture;   // mid exposure, host clock
+    uint32_t dropped = 0;                            // frames lost just before this one
+    bool     mapped  = false;                        // false: from the hand-over time
+};
+
+class CameraClock {
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    explicit CameraClock(const CameraClockParams &p = CameraClockParams());
+
+    // Adds a frame with SDK frame number `frame_num`, device tick `tick`
+    // and exposure `exposure` s, handed over at `received`; returns its
+    // capture time (received - latency - exposure / 2 until the mapping is
+    // valid).
+    CameraFrameTime on_frame(uint32_t frame_num, uint64_t tick, double exposure, TimePoint received);
+
+    const CameraClockEstimate &estimate() const { return est_; }
+    const CameraClockParams   &params() const { return p_; }
+    void reset();
+
+    static uint64_t device_tick(uint32_t high, uint32_t low) { return (uint64_t(high) << 32) | low; }
+
+    static double seconds(TimePoint t) {
+        return std::chrono::duration<double>(t.time_since_epoch()).count();
+    }
+    static TimePoint time_point(double s) {
+        return TimePoint(std::chrono::duration_cast<TimePoint::duration>(std::chrono::duration<double>(s)));
+    }
+
+private:
+    struct Obs {
+        double d;   // device s since tick_base_
+        double y;   // host - exposure - device, s
+    };
+
+    uint32_t count_dropped(uint32_t frame_num, double dt);
+    void     fit();
+
+    CameraClockParams p_;
+    std::array<Obs, kCameraClockMaxWin> win_;
+    std::array<double, kCameraClockMaxWin> res_, scratch_;   // fit() only
+    int      n_ = 0, head_ = 0;
+    bool     have_frame_ = false;
+    uint32_t last_num_   = 0;
+    uint64_t tick_base_  = 0;
+    uint64_t last_tick_  = 0;
+    double   period_     = 0.0;   // s, device time between consecutive frames
+    double   detect_h_   = 0.0;   // host s of the first frame while detecting tick_hz
+    double   last_kept_  = 0.0;
+    double   next_fit_   = 0.0;
+    int      jumps_      = 0;
+    CameraClockEstimate est_;
+};
@@ -0,0 +1,196 @@
+// calibur/worker/camera_roi.cpp
+#include "camera_roi.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+RoiController::RoiController(const SensorLimits &limits, const RoiParams &p, const SensorRoi &current)
+    : lim_(limits), p_(p)
+{
+    lim_.inc_w = std::max(lim_.inc_w, 1);
+    lim_.inc_h = std::max(lim_.inc_h, 1);
+    lim_.inc_x = std::max(lim_.inc_x, 1);
+    lim_.inc_y = std::max(lim_.inc_y, 1);
+    p_.size_step = std::max(p_.size_step, 1);
+    current_ = (current.w > 0 && current.h > 0) ? current : full();
+    prev_    = current_;
+}
+
+// Window side for a wanted extent: up to the size step and the node
+// increment, within [lo, full]
+int RoiController::side(float want, int inc, int lo, int full) const {
+    int s = int(std::ceil(want / p_.size_step)) * p_.size_step;
+    s = (s + inc - 1) / inc * inc;
+    s = std::max(s, lo);
+    return std::min(s, full);
+}
+
+// Aligned offset centring `size` on `centre`, inside the sensor
+int RoiController::place(float centre, int size, int inc, int full) {
+    int o = int(std::lround((centre - 0.5f * size) / inc)) * inc;
+    o = std::min(o, (full - size) / inc * inc);
+    return std::max(o, 0);
+}
+
+RoiCommand RoiController::update(const RoiTarget *target, TimePoint now) {
+    RoiCommand cmd;
+    if (pending_) return cmd;
+
+    const bool seen = target && target->w > 0.0f && target->h > 0.0f &&
+                      seconds(now - target->timestamp) <= p_.lost_timeout;
+    if (!seen) {
+        tracking_  = false;
+        shrinking_ = false;
+        if (current_ != full()) {
+            cmd.kind = RoiCommand::RESIZE;
+            cmd.roi  = full();
+        }
+        return cmd;
+    }
+
+    // image velocity of the box centre, from successive sightings
+    const float cx = target->x + 0.5f * target->w;
+    const float cy = target->y + 0.5f * target->h;
+    if (target->timestamp != last_seen_) {
+        const double gap = seconds(target->timestamp - last_seen_);
+        if (!tracking_ || gap <= 0.0 || gap > p_.lost_timeout) {
+            vx_ = vy_ = 0.0f;
+            anchor_time_ = target->timestamp;
+            anchor_cx_   = cx;
+            anchor_cy_   = cy;
+        } else {
+            const double dt = seconds(target->timestamp - anchor_time_);
+            if (dt >= p_.velocity_span) {
+                const float a = p_.velocity_alpha;
+                vx_ += a * (float((cx - anchor_cx_) / dt) - vx_);
+                vy_ += a * (float((cy - anchor_cy_) / dt) - vy_);
+                anchor_time_ = target->timestamp;
+                anchor_cx_   = cx;
+                anchor_cy_   = cy;
+            }
+        }
+        tracking_  = true;
+        last_seen_ = target->timestamp;
+    }
+    const float ahead = float(std::min(seconds(now - target->timestamp), p_.lost_timeout) + p_.lead);
+    const float px = cx + vx_ * ahead;
+    const float py = cy + vy_ * ahead;
+
+    // size: grow at once, shrink with hysteresis
+    const int want_w = side(target->w * (1.0f + 2.0f * p_.margin), lim_.inc_w, std::max(p_.min_size, lim_.min_w), lim_.width);
+    const int want_h = side(target->h * (1.0f + 2.0f * p_.margin), lim_.inc_h, std::max(p_.min_size, lim_.min_h), lim_.height);
+    int w = std::max(want_w, current_.w);
+    int h = std::max(want_h, current_.h);
+    if (w == current_.w && h == current_.h) {
+        const bool small_w = want_w < p_.shrink_ratio * current_.w;
+        const bool small_h = want_h < p_.shrink_ratio * current_.h;
+        if (small_w || small_h) {
+            if (!shrinking_) {
+                shrinking_    = true;
+                shrink_since_ = now;
+            }
+            if (seconds(now - shrink_since_) >= p_.shrink_hold &&
+                seconds(now - last_resize_) >= p_.resize_holdoff) {
+                if (small_w) w = want_w;
+                if (small_h) h = want_h;
+            }
+        } else {
+            shrinking_ = false;
+        }
+    }
+    if (w != current_.w || h != current_.h) {
+        cmd.kind = RoiCommand::RESIZE;
+        cmd.roi  = SensorRoi{place(px, w, lim_.inc_x, lim_.width), place(py, h, lim_.inc_y, lim_.height), w, h};
+        return cmd;
+    }
+
+    // position: only when off centre or near an edge
+    const float gx = p_.guard * current_.w, gy = p_.guard * current_.h;
+    const bool off_centre = std::fabs(px - (current_.x + 0.5f * current_.w)) > p_.recenter * current_.w ||
+                            std::fabs(py - (current_.y + 0.5f * current_.h)) > p_.recenter * current_.h;
+    const bool near_edge = px - 0.5f * target->w < current_.x + gx ||
+                           px + 0.5f * target->w > current_.x + current_.w - gx ||
+                           py - 0.5f * target->h < current_.y + gy ||
+                           py + 0.5f * target->h > current_.y + current_.h - gy;
+    if (off_centre || near_edge) {
+        // lead along the motion, short of the recentring threshold
+        const float lx = std::clamp(float(vx_ * p_.travel), -0.5f * p_.recenter * current_.w,
+                                    0.5f * p_.recenter * current_.w);
+        const float ly = std::clamp(float(vy_ * p_.travel), -0.5f * p_.recenter * current_.h,
+                                    0.5f * p_.recenter * current_.h);
+        const SensorRoi next{place(px + lx, current_.w, lim_.inc_x, lim_.width),
+                             place(py + ly, current_.h, lim_.inc_y, lim_.height), current_.w, current_.h};
+        if (next != current_) {
+            cmd.kind = RoiCommand::MOVE;
+            cmd.roi  = next;
+        }
+    }
+    return cmd;
+}
+
+void RoiController::applied(const RoiCommand &cmd, TimePoint now) {
+    if (cmd.kind == RoiCommand::NONE) return;
+    prev_    = current_;
+    current_ = cmd.roi;
+    if (cmd.kind == RoiCommand::RESIZE) {
+        // acquisition restarted: every frame from here on has the new window
+        ++stats_.resizes;
+        last_resize_ = now;
+        shrinking_   = false;
+        pending_     = false;
+        prev_        = current_;
+        return;
+    }
+    ++stats_.moves;
+    pending_     = true;
+    change_time_ = now;
+    settle_left_ = p_.settle_frames;
+}
+
+RoiCommand RoiController::drive(CameraControl &camera, const RoiTarget *target, TimePoint now,
+                                const std::function<void()> &release, const std::function<bool()> &idle) {
+    const RoiCommand cmd = update(target, now);
+    bool ok = false;
+    if (cmd.kind == RoiCommand::MOVE) {
+        ok = camera.move_roi(cmd.roi.x, cmd.roi.y);
+    } else if (cmd.kind == RoiCommand::RESIZE) {
+        release();
+        if (!idle()) {
+            ++stats_.held;
+            return RoiCommand();
+        }
+        ok = camera.resize_roi(cmd.roi);
+    }
+    if (!ok) return RoiCommand();
+    applied(cmd, now);
+    return cmd;
+}
+
+bool RoiController::frame_roi(TimePoint start, bool mapped, int w, int h, SensorRoi &out) {
+    if (pending_) {
+        if (mapped) {
+            if (start < change_time_) {
+                out = prev_;
+                return true;
+            }
+            if (seconds(start - change_time_) < p_.apply_latency) {
+                ++stats_.unknown;
+                return false;
+            }
+        } else if (settle_left_ > 0) {
+            --settle_left_;
+            ++stats_.unknown;
+            return false;
+        }
+        // frames arrive in order: everything from here on has the new window
+        pending_ = false;
+    }
+    out = current_;
+    if (w != out.w || h != out.h) {
+        // not the size asked for (camera refused or adjusted it): keep its
+        // offset, take the frame's size
+        out.w = w;
+        out.h = h;
+    }
+    return true;
+}
@@ -0,0 +1,170 @@
+// calibur/worker/camera_roi.hpp
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+// Dynamic sensor ROI: while a target is locked the camera reads out only a
+// window around it (OffsetX / OffsetY / Width / Height), which raises the
+// frame rate and cuts USB transfer and preprocessing with the pixel count.
+// On loss it goes back to full frame.
+//
+// RoiController picks the window from the target's box (full-sensor
+// pixels), projected to the time the window will be in use with the box's
+// image velocity, with hysteresis on both position and size:
+//
+//  - the window moves (an offset write, taken while grabbing) only when
+//    the target is more than `recenter` of the window off its centre or
+//    within `guard` of an edge, and then leads the target along its
+//    motion so the next move is as far off as it can be;
+//  - it grows as soon as the target needs more room, but shrinks only
+//    once a size below shrink_ratio of the current one has been wanted
+//    for shrink_hold s, and at most once per resize_holdoff. Width and
+//    Height are locked while grabbing, so every resize restarts
+//    acquisition;
+//  - sides are multiples of size_step, so the range changing a little
+//    does not resize.
+//
+// An offset write lands on whichever frame starts next, which the host
+// cannot see. frame_roi() therefore tells the window a frame was read out
+// with from its start time: frames started before the write have the old
+// one, frames started apply_latency after it the new one, and frames in
+// between are reported unknown (to be dropped). No new command is issued
+// until the last one shows in the frames.
+//
+// The camera sits behind CameraControl (HikCameraControl, or CameraSim in
+// calibur/sim for tests).
+
+// Sensor readout window, in pixels of the full frame
+struct SensorRoi {
+    int x = 0, y = 0;
+    int w = 0, h = 0;
+
+    bool operator==(const SensorRoi &o) const { return x == o.x && y == o.y && w == o.w && h == o.h; }
+    bool operator!=(const SensorRoi &o) const { return !(*this == o); }
+};
+
+// Full sensor size and the node constraints of the window
+struct SensorLimits {
+    int width  = 1080, height = 1080;   // full frame
+    int min_w  = 64,   min_h  = 64;
+    int inc_w  = 8,    inc_h  = 8;      // Width / Height step
+    int inc_x  = 8,    inc_y  = 8;      // OffsetX / OffsetY step
+};
+
+class CameraControl {
+public:
+    virtual ~CameraControl() = default;
+
+    virtual SensorLimits limits() const = 0;
+    virtual SensorRoi    roi() const = 0;
+
+    // Moves the window, size unchanged; taken while grabbing, from the
+    // next frame that starts.
+    virtual bool move_roi(int x, int y) = 0;
+
+    // New window size and position. Restarts acquisition: the caller has
+    // made sure no SDK buffer is held.
+    virtual bool resize_roi(const SensorRoi &roi) = 0;
+};
+
+struct RoiParams {
+    float  margin         = 1.0f;    // room on each side of the target, times its size
+    int    min_size       = 256;     // px, smallest window side
+    int    size_step      = 128;     // px, window sides are multiples of this
+    float  recenter       = 0.2f;    // move when the target is this far off centre, times the window side
+    float  guard          = 0.1f;    // move when the target comes this close to an edge, times the window side
+    float  shrink_ratio   = 0.6f;    // shrink only below this times the current side
+    double shrink_hold    = 0.5;     // s a smaller window must be wanted before shrinking
+    double resize_holdoff = 1.0;     // s between shrinks (each restarts acquisition)
+    double lost_timeout   = 0.25;    // s without the target before going back to full frame
+    double lead           = 0.02;    // s, project the target this far past now
+    double velocity_span  = 0.03;    // s, shortest baseline of an image velocity sample (detection noise)
+    float  velocity_alpha = 0.5f;    // EWMA weight of the newest image velocity
+    double travel         = 0.05;    // s of image velocity a moved window leads the target by (<= recenter)
+    double apply_latency  = 0.003;   // s, offset write to the first frame start that has it
+    int    settle_frames  = 3;       // frames treated as unknown after a write when start times are not mapped
+};
+
+// Box of the locked target in full-sensor pixels, from the frame captured
+// at `timestamp`
+struct RoiTarget {
+    float x = 0.0f, y = 0.0f;
+    float w = 0.0f, h = 0.0f;
+    std::chrono::steady_clock::time_point timestamp;
+};
+
+struct RoiCommand {
+    enum Kind { NONE, MOVE, RESIZE };
+    Kind      kind = NONE;
+    SensorRoi roi;
+};
+
+struct RoiStats {
+    uint64_t moves   = 0;
+    uint64_t resizes = 0;
+    uint64_t unknown = 0;   // frames whose window could not be told
+    uint64_t held    = 0;   // resizes put off, frame buffers still held
+};
+
+class RoiController {
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    // `current` is the window the camera has now (full frame if empty)
+    explicit RoiController(const SensorLimits &limits, const RoiParams &p = RoiParams(),
+                           const SensorRoi &current = SensorRoi());
+
+    // Window change wanted at `now` for the last target seen (nullptr:
+    // none); NONE while the last change has not shown up in the frames.
+    RoiCommand update(const RoiTarget *target, TimePoint now);
+
+    // The camera took `cmd`; `now` from just before it was written.
+    void applied(const RoiCommand &cmd, TimePoint now);
+
+    // update() and the camera write in one: a move is written at once; a
+    // resize restarts acquisition, so `release` first drops the frame the
+    // caller published and `idle` waits for consumers to return every
+    // frame buffer (false: still held, retried after the next frame). The
+    // caller must not hold a frame itself. Returns the command the camera
+    // took (NONE if none).
+    RoiCommand drive(CameraControl &camera, const RoiTarget *target, TimePoint now,
+                     const std::function<void()> &release, const std::function<bool()> &idle);
+
+    // Window of a w x h frame that started exposing at `start` (`mapped`:
+    // start is from the camera clock, else only frame order is used).
+    // False if it may have been read out with either window.
+    bool frame_roi(TimePoint start, bool mapped, int w, int h, SensorRoi &out);
+
+    const SensorRoi &current() const { return current_; }
+    SensorRoi        full() const { return SensorRoi{0, 0, lim_.width, lim_.height}; }
+    const RoiStats  &stats() const { return stats_; }
+
+private:
+    static double seconds(TimePoint::duration d) { return std::chrono::duration<double>(d).count(); }
+
+    int side(float want, int inc, int lo, int full) const;
+    static int place(float centre, int size, int inc, int full);
+
+    SensorLimits lim_;
+    RoiParams    p_;
+    SensorRoi    current_, prev_;
+
+    // pending change: frames started before change_time_ have prev_
+    bool      pending_ = false;
+    TimePoint change_time_{};
+    int       settle_left_ = 0;
+
+    // target image velocity, px / s, over at least velocity_span
+    TimePoint last_seen_{}, anchor_time_{};
+    float     anchor_cx_ = 0.0f, anchor_cy_ = 0.0f;
+    float     vx_ = 0.0f, vy_ = 0.0f;
+    bool      tracking_ = false;
+
+    bool      shrinking_ = false;
+    TimePoint shrink_since_{};
+    TimePoint last_resize_{};
+
+    RoiStats stats_;
+};
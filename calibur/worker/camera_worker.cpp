@@ -1,4 +1,5 @@
 #include "workers.hpp"
+#include "hik_camera_control.hpp"
 #include "../camera/MvCameraControl.h"
 
 #include <iostream>
@@ -17,18 +18,37 @@ CameraWorker::CameraWorker(void* cam_handle,
     : cam_(cam_handle),
       shared_(shared),
       stop_(stop_flag),
-      mode_(mode)
+      mode_(mode),
+      clock_([] {
+          CameraClockParams p;
+          p.tick_hz = CAMERA_TICK_HZ;
+          p.latency = CAMERA_HANDOVER_LATENCY;
+          return p;
+      }()),
+      buffers_(cam_handle, hik_sdk_mvs(), [] {
+          HikBufferParams p;
+          p.buffers = CAMERA_SDK_BUFFERS;
+          return p;
+      }())
 {
     if (mode_ == CameraMode::VIDEO_FILE) {
         // Open debug video file
-        cap_.open(VIDEO_PATH);
-        if (!cap_.isOpened()) {
+        auto decoder = open_video_decoder(VIDEO_PATH);
+        if (!decoder) {
             std::cerr << "[CameraWorker] ERROR: Failed to open video file: "
                       << VIDEO_PATH << std::endl;
             use_stub_ = true;
         } else {
-            std::cout << "[CameraWorker] Using video file: "
-                      << VIDEO_PATH << std::endl;
+            VideoSourceParams p;
+            p.pacing = VIDEO_PACING;
+            p.rate   = VIDEO_FIXED_RATE;
+            p.ahead  = VIDEO_DECODE_AHEAD;
+            p.slots  = VIDEO_FRAME_SLOTS;
+            video_   = std::make_unique<VideoSource>(std::move(decoder), p);
+            std::cout << "[CameraWorker] Using video file: " << VIDEO_PATH;
+            if (video_->period() > 0.0) std::cout << " at " << 1.0 / video_->period() << " fps";
+            else                        std::cout << " as fast as YOLO takes frames";
+            std::cout << std::endl;
             use_stub_ = false;
         }
     } else {
@@ -49,14 +69,47 @@ void CameraWorker::operator()() {
 
     // Start grabbing for Hik mode
     if (!use_stub_ && mode_ == CameraMode::HIK_USB) {
+#ifdef CAMERA_BAYER_FORMAT
+        nRet = MV_CC_SetEnumValue(cam_, "PixelFormat", CAMERA_BAYER_FORMAT);
+        if (nRet != MV_OK) {
+            std::cerr << "[CameraWorker] Setting PixelFormat to Bayer failed: " << nRet
+                      << ". Keeping the camera's format.\n";
+        }
+#endif
+        nRet = buffers_.configure();
+        if (nRet != MV_OK) {
+            std::cerr << "[CameraWorker] MV_CC_SetImageNodeNum(" << buffers_.params().buffers
+                      << ") failed: " << nRet << ". Using the SDK default.\n";
+        }
         nRet = MV_CC_StartGrabbing(cam_);
         if (nRet != MV_OK) {
             std::cerr << "[CameraWorker] MV_CC_StartGrabbing failed: " << nRet
                       << ". Using stub frames instead.\n";
             use_stub_ = true;
+        } else {
+            MVCC_FLOATVALUE exp;
+            memset(&exp, 0, sizeof(MVCC_FLOATVALUE));
+            if (MV_CC_GetFloatValue(cam_, "ExposureTime", &exp) == MV_OK) {
+                exposure_s_ = exp.fCurValue * 1e-6;   // us
+            }
+            next_report_ = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                              std::chrono::duration<double>(CAMERA_CLOCK_REPORT_PERIOD));
+#ifdef CAMERA_DYNAMIC_ROI
+            auto control = std::make_unique<HikCameraControl>(cam_);
+            if (control->valid()) {
+                roi_     = std::make_unique<RoiController>(control->limits());
+                control_ = std::move(control);
+            }
+#endif
         }
     }
 
+    if (video_) {
+        video_->start();
+        next_report_ = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                          std::chrono::duration<double>(CAMERA_CLOCK_REPORT_PERIOD));
+    }
+
     while (!stop_.load(std::memory_order_relaxed)) {
         CameraFrame frame;
 
@@ -64,26 +117,88 @@ void CameraWorker::operator()() {
         if (use_stub_) {
             grab_frame_stub(frame);
         } else if (mode_ == CameraMode::HIK_USB) {
-            grab_frame_from_hik(frame);
+            if (!grab_frame_from_hik(frame)) continue;   // read out while the window moved
+            if (frame.dropped > 0) {
+                std::cerr << "[CameraWorker] " << frame.dropped << " frame(s) dropped before #"
+                          << frame.frame_num << std::endl;
+            }
+            if (frame.timestamp >= next_report_) {
+                const CameraClockEstimate &e = clock_.estimate();
+                if (e.valid) {
+                    std::cout << "[CameraWorker] clock: drift " << 1e6 * e.drift() << " ppm, hand-over delay "
+                              << 1e3 * e.delay << " ms, " << e.dropped << "/" << e.frames + e.dropped
+                              << " dropped, " << e.resets << " resets" << std::endl;
+                }
+                const HikBufferStats b = buffers_.stats();
+                std::cout << "[CameraWorker] buffers: " << b.grabbed << " grabbed, " << b.copied
+                          << " copied (all leased), " << b.timeouts << " timeouts, " << b.errors
+                          << " errors" << std::endl;
+                if (roi_) {
+                    const RoiStats &r = roi_->stats();
+                    const SensorRoi &c = roi_->current();
+                    std::cout << "[CameraWorker] ROI " << c.w << "x" << c.h << " at (" << c.x << ", " << c.y
+                              << "): " << r.moves << " moves, " << r.resizes << " resizes, " << r.unknown
+                              << " frames dropped while moving, " << r.held
+                              << " resizes put off (buffers held)" << std::endl;
+                }
+                next_report_ = frame.timestamp + std::chrono::duration_cast<Clock::duration>(
+                                                     std::chrono::duration<double>(CAMERA_CLOCK_REPORT_PERIOD));
+            }
         } else { // VIDEO_FILE
-            grab_frame_from_video(frame);
+            if (!grab_frame_from_video(frame)) continue;
+            if (frame.timestamp >= next_report_) {
+                // decoding runs ahead on its own thread: its cost is not in the frame latency
+                const VideoSourceStats v = video_->stats();
+                std::cout << "[CameraWorker] video: decode " << 1e3 * v.decode_mean << " ms mean / "
+                          << 1e3 * v.decode_max << " ms max, rewind " << 1e3 * v.rewind_max << " ms max; "
+                          << v.delivered << " delivered, " << v.dropped << " dropped, " << v.starved
+                          << " waited on the decoder, " << v.slips << " schedule slips, " << v.loops
+                          << " loops" << std::endl;
+                next_report_ = frame.timestamp + std::chrono::duration_cast<Clock::duration>(
+                                                     std::chrono::duration<double>(CAMERA_CLOCK_REPORT_PERIOD));
+            }
         }
 
         // 2) Publish raw frame to shared
-        auto ptr = std::make_shared<CameraFrame>(std::move(frame));
-        std::atomic_store(&shared_.camera, ptr);
-        shared_.camera_ver.fetch_add(1, std::memory_order_relaxed);
+        const TimePoint published = frame.timestamp;
+        {
+            // not held past here: a resize waits for every SDK buffer lease
+            auto ptr = std::make_shared<CameraFrame>(std::move(frame));
+            std::atomic_store(&shared_.camera, ptr);
+            shared_.camera_ver.fetch_add(1, std::memory_order_relaxed);
+        }
 
+        // 3) Follow the target with the readout window
+        if (roi_) control_roi();
+
+        if (video_ && !use_stub_) {
+            // the video source paces itself; at max speed the next frame
+            // goes out once YOLO is done with this one
+            if (video_->period() == 0.0) wait_consumed(published);
+            continue;
+        }
 
         std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
 
     if (!use_stub_ && mode_ == CameraMode::HIK_USB) {
+        // every SDK buffer has to be back before StopGrabbing: drop the
+        // published frame and give consumers a moment to let go of theirs
+        std::atomic_store(&shared_.camera, std::shared_ptr<CameraFrame>());
+        if (roi_ && roi_->current() != roi_->full() && buffers_.wait_idle(std::chrono::milliseconds(500))) {
+            // leave the camera at full frame: the next start takes its
+            // frame as the full one
+            control_->resize_roi(roi_->full());
+        }
+        if (!buffers_.drain(std::chrono::milliseconds(500))) {
+            std::cerr << "[CameraWorker] " << buffers_.stats().outstanding
+                      << " frame(s) still held at stop\n";
+        }
         MV_CC_StopGrabbing(cam_);
     }
 
-    if (mode_ == CameraMode::VIDEO_FILE && cap_.isOpened()) {
-        cap_.release();
+    if (video_) {
+        video_->stop();
     }
 
 }
@@ -98,53 +213,92 @@ void CameraWorker::grab_frame_stub(CameraFrame &frame) {
         frame.width,
         CV_8UC3,
         cv::Scalar(128, 128, 128));
+    frame.roi         = SensorRoi{0, 0, frame.width, frame.height};
+    frame.full_width  = frame.width;
+    frame.full_height = frame.height;
 }
 
-// ---------- HIK camera grab ----------
-void CameraWorker::grab_frame_from_hik(CameraFrame &frame) {
-    static const unsigned int MAX_SRC_BUF = 1080 * 1080 * 3;
-    static unsigned char* pSrcData = [](){
-        auto ptr = new unsigned char[MAX_SRC_BUF];
-        return ptr;
-    }();
-
-    // Big enough for RGB/BGR8
-    static const unsigned int MAX_DST_BUF = 1080 * 1080 * 3;
-    static unsigned char* pDstData = [](){
-        auto ptr = new unsigned char[MAX_DST_BUF];
-        return ptr;
-    }();
-
-    MV_FRAME_OUT_INFO_EX frameInfo;
-    memset(&frameInfo, 0, sizeof(MV_FRAME_OUT_INFO_EX));
-
-    int nRet = MV_CC_GetOneFrameTimeout(
-        cam_,
-        pSrcData,
-        MAX_SRC_BUF,
-        &frameInfo,
-        1000  // timeout ms
-    );
+// ---------- ROI control ----------
+// Runs after each published frame: moves are written while grabbing;
+// a resize needs acquisition stopped, so the published frame is dropped
+// and consumers get a moment to return their SDK buffers first.
+void CameraWorker::control_roi() {
+    auto target = std::atomic_load(&shared_.roi_target);
+    const RoiCommand cmd = roi_->drive(
+        *control_, target.get(), Clock::now(),
+        [this] { std::atomic_store(&shared_.camera, std::shared_ptr<CameraFrame>()); },
+        [this] { return buffers_.wait_idle(std::chrono::milliseconds(CAMERA_ROI_RESIZE_WAIT)); });
+    if (cmd.kind == RoiCommand::RESIZE) {
+        std::cout << "[CameraWorker] ROI " << cmd.roi.w << "x" << cmd.roi.h << " at (" << cmd.roi.x
+                  << ", " << cmd.roi.y << ")" << std::endl;
+    }
+}
 
+// ---------- HIK camera grab ----------
+// Frames stay in the SDK's buffer: BGR8 frames are published as a view
+// over it (leased until the last consumer drops the frame). Bayer RG8 / BG8
+// frames are demosaiced in-house into raw_data and the Bayer view is kept
+// alongside for consumers that read it directly. Anything else is
+// converted straight into the frame's own Mat and the buffer returned.
+// With a dynamic ROI, frames read out while the window moved are dropped
+// before any conversion.
+bool CameraWorker::grab_frame_from_hik(CameraFrame &frame) {
+    HikBuffer buf;
+    int nRet = buffers_.grab(1000 /* timeout ms */, buf);
     if (nRet != MV_OK) {
-        std::cerr << "[CameraWorker] MV_CC_GetOneFrameTimeout failed: "
+        std::cerr << "[CameraWorker] MV_CC_GetImageBuffer failed: "
                   << nRet << std::endl;
         grab_frame_stub(frame);
-        return;
+        return true;
     }
-
-    frame.timestamp = Clock::now();
+    const MV_FRAME_OUT_INFO_EX &frameInfo = buf.info;
+    unsigned char *pSrcData = const_cast<unsigned char *>(buf.data);
+
+    // capture time from the camera's own clock: the hand-over time alone
+    // includes the exposure, readout, transfer and however long the frame
+    // sat in the SDK queue
+    const TimePoint received = Clock::now();
+    const uint64_t  tick = CameraClock::device_tick(frameInfo.nDevTimeStampHigh, frameInfo.nDevTimeStampLow);
+    const double exposure = frameInfo.fExposureTime > 0.0f ? frameInfo.fExposureTime * 1e-6 : exposure_s_;
+    bool mapped = false;
+    if (tick != 0) {
+        const CameraFrameTime ft = clock_.on_frame(frameInfo.nFrameNum, tick, exposure, received);
+        frame.timestamp = ft.capture;
+        frame.dropped   = ft.dropped;
+        mapped          = ft.mapped;
+    } else {
+        frame.timestamp = received;
+    }
+    frame.frame_num = frameInfo.nFrameNum;
     frame.width  = frameInfo.nWidth;
     frame.height = frameInfo.nHeight;
 
+    if (roi_) {
+        const TimePoint start = frame.timestamp - std::chrono::duration_cast<Clock::duration>(
+                                                      std::chrono::duration<double>(0.5 * exposure));
+        if (!roi_->frame_roi(start, mapped, frame.width, frame.height, frame.roi)) return false;
+        frame.full_width  = roi_->full().w;
+        frame.full_height = roi_->full().h;
+    } else {
+        frame.roi         = SensorRoi{0, 0, frame.width, frame.height};
+        frame.full_width  = frame.width;
+        frame.full_height = frame.height;
+    }
+
     // --- If already BGR8/RGB8, we can skip conversion ---
     if (frameInfo.enPixelType == PixelType_Gvsp_BGR8_Packed) {
         cv::Mat bgr(frameInfo.nHeight,
                     frameInfo.nWidth,
                     CV_8UC3,
                     pSrcData);
-        frame.raw_data = bgr.clone();
-        return;
+        if (buf.must_copy) {
+            // consumers already hold most of the SDK's buffers
+            frame.raw_data = bgr.clone();
+        } else {
+            frame.raw_data = bgr;
+            frame.lease    = std::move(buf.lease);
+        }
+        return true;
     }
     if (frameInfo.enPixelType == PixelType_Gvsp_RGB8_Packed) {
         cv::Mat rgb(frameInfo.nHeight,
@@ -152,10 +306,31 @@ void CameraWorker::grab_frame_from_hik(CameraFrame &frame) {
                     CV_8UC3,
                     pSrcData);
         // Convert RGB to BGR for OpenCV
-        cv::Mat bgr;
-        cv::cvtColor(rgb, bgr, cv::COLOR_RGB2BGR);
-        frame.raw_data = bgr;
-        return;
+        cv::cvtColor(rgb, frame.raw_data, cv::COLOR_RGB2BGR);
+        return true;
+    }
+
+    if (frameInfo.enPixelType == PixelType_Gvsp_BayerRG8 ||
+        frameInfo.enPixelType == PixelType_Gvsp_BayerBG8) {
+        cv::Mat bayer(frameInfo.nHeight,
+                      frameInfo.nWidth,
+                      CV_8UC1,
+                      pSrcData);
+        frame.bayer_pattern = frameInfo.enPixelType == PixelType_Gvsp_BayerRG8 ? BayerPattern::RG
+                                                                               : BayerPattern::BG;
+        frame.raw_data.create(frameInfo.nHeight, frameInfo.nWidth, CV_8UC3);
+        if (!bayer_to_bgr(bayer.data, bayer.step, bayer.cols, bayer.rows, frame.bayer_pattern,
+                          frame.raw_data.data, frame.raw_data.step)) {
+            grab_frame_stub(frame);
+            return true;
+        }
+        if (buf.must_copy) {
+            frame.bayer = bayer.clone();
+        } else {
+            frame.bayer = bayer;
+            frame.lease = std::move(buf.lease);
+        }
+        return true;
     }
 
     // --- Otherwise, convert to BGR8 using MV_CC_ConvertPixelType ---
@@ -167,8 +342,9 @@ void CameraWorker::grab_frame_from_hik(CameraFrame &frame) {
     convParam.nSrcDataLen     = frameInfo.nFrameLen;
     convParam.enSrcPixelType  = frameInfo.enPixelType;
     convParam.enDstPixelType  = PixelType_Gvsp_BGR8_Packed;
-    convParam.pDstBuffer      = pDstData;
-    convParam.nDstBufferSize  = MAX_DST_BUF;
+    frame.raw_data.create(frameInfo.nHeight, frameInfo.nWidth, CV_8UC3);
+    convParam.pDstBuffer      = frame.raw_data.data;
+    convParam.nDstBufferSize  = static_cast<unsigned int>(frame.raw_data.total() * frame.raw_data.elemSize());
 
     nRet = MV_CC_ConvertPixelType(cam_, &convParam);
     if (nRet != MV_OK) {
@@ -176,35 +352,47 @@ void CameraWorker::grab_frame_from_hik(CameraFrame &frame) {
                   << nRet << " (src pixel type 0x"
                   << std::hex << frameInfo.enPixelType << std::dec << ")\n";
         grab_frame_stub(frame);
-        return;
+        return true;
     }
-
-    cv::Mat bgr(frameInfo.nHeight,
-                frameInfo.nWidth,
-                CV_8UC3,
-                pDstData);
-    frame.raw_data = bgr.clone();
+    return true;
 }
 
 
 // ---------- Video file grab ----------
-void CameraWorker::grab_frame_from_video(CameraFrame &frame) {
-    cv::Mat bgr;
-    if (!cap_.read(bgr) || bgr.empty()) {
-        // Loop when reaching EOF
-        cap_.set(cv::CAP_PROP_POS_FRAMES, 0);
-
-        if (!cap_.read(bgr) || bgr.empty()) {
-            std::cerr << "[CameraWorker] Video read failed after rewind. "
+// Frames come decoded (and looped at EOF) from the video source's thread;
+// raw_data is a view of its buffer, which goes back to the pool with the
+// frame.
+bool CameraWorker::grab_frame_from_video(CameraFrame &frame) {
+    VideoFrame vf;
+    if (!video_->next(vf, std::chrono::milliseconds(100))) {
+        if (video_->finished()) {
+            std::cerr << "[CameraWorker] Video decode failed. "
                          "Switching to stub.\n";
             use_stub_ = true;
-            grab_frame_stub(frame);
-            return;
         }
+        return false;
     }
 
-    frame.timestamp = Clock::now();
-    frame.width  = bgr.cols;
-    frame.height = bgr.rows;
-    frame.raw_data = bgr.clone();
+    frame.timestamp = vf.timestamp;
+    frame.width     = vf.width;
+    frame.height    = vf.height;
+    frame.frame_num = static_cast<uint32_t>(vf.index);
+    frame.dropped   = vf.dropped;
+    frame.raw_data  = cv::Mat(vf.height, vf.width, CV_8UC(vf.channels), const_cast<uint8_t *>(vf.data), vf.step);
+    frame.lease     = std::move(vf.lease);
+    frame.roi         = SensorRoi{0, 0, frame.width, frame.height};
+    frame.full_width  = frame.width;
+    frame.full_height = frame.height;
+    return true;
+}
+
+// MAX pacing: wait (up to VIDEO_CONSUMER_WAIT) until YOLO has published
+// its result for the frame stamped `timestamp`
+void CameraWorker::wait_consumed(TimePoint timestamp) {
+    const TimePoint deadline = Clock::now() + std::chrono::milliseconds(VIDEO_CONSUMER_WAIT);
+    while (!stop_.load(std::memory_order_relaxed) && Clock::now() < deadline) {
+        auto yo = std::atomic_load(&shared_.yolo);
+        if (yo && yo->timestamp >= timestamp) return;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
 }
@@ -0,0 +1,107 @@
+// clock_sync.cpp
+#include "clock_sync.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+ClockSync::ClockSync(const ClockSyncParams &p) : p_(p) {
+    p_.window        = std::clamp(p_.window, 2, kClockSyncMaxWin);
+    p_.best_fraction = std::clamp(p_.best_fraction, 0.01f, 1.0f);
+    p_.min_samples   = std::max(p_.min_samples, 1);
+}
+
+size_t ClockSync::make_ping(TimePoint now, uint8_t *out) {
+    const uint64_t ns = uint64_t(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count());
+    uint8_t payload[kUsbPingLen];
+    std::memcpy(payload, &seq_, 4);
+    std::memcpy(payload + 4, &ns, 8);
+    ++seq_;
+    next_ping_ = now + std::chrono::duration_cast<TimePoint::duration>(
+                           std::chrono::duration<double>(p_.ping_period));
+    return usb_encode_frame(USB_TX_PING, payload, kUsbPingLen, out);
+}
+
+uint64_t ClockSync::unwrap(uint32_t tick) {
+    if (have_tick_ && tick < last_tick_ && last_tick_ - tick > 0x80000000u) ++wraps_;
+    have_tick_ = true;
+    last_tick_ = tick;
+    return (wraps_ << 32) | tick;
+}
+
+bool ClockSync::on_pong(const uint8_t *payload, uint16_t len, TimePoint t4) {
+    if (len != kUsbPongLen) {
+        ++rejected_;
+        return false;
+    }
+    uint64_t t1_ns;
+    uint32_t t2_tick, t3_tick;
+    std::memcpy(&t1_ns, payload + 4, 8);
+    std::memcpy(&t2_tick, payload + 12, 4);
+    std::memcpy(&t3_tick, payload + 16, 4);
+
+    // unwrap even if the exchange is dropped, to keep up with the tick
+    const double t2 = double(unwrap(t2_tick)) / p_.tick_hz;
+    const double t3 = double(unwrap(t3_tick)) / p_.tick_hz;
+    const double t1 = 1e-9 * double(t1_ns);
+    const double t4s = seconds(t4);
+
+    const double rtt   = t4s - t1;
+    const double delay = rtt - (t3 - t2);
+    // one tick of slack for the MCU stamps
+    if (!(rtt >= 0.0) || rtt > p_.max_rtt || t3 < t2 || delay < -1.0 / p_.tick_hz) {
+        ++rejected_;
+        return false;
+    }
+
+    Sample &s = win_[head_];
+    s.t      = 0.5 * (t1 + t4s);
+    s.offset = 0.5 * ((t2 - t1) + (t3 - t4s));
+    s.delay  = std::max(delay, 0.0);
+    head_ = (head_ + 1) % p_.window;
+    n_    = std::min(n_ + 1, p_.window);
+    hist_.add(0.5e6 * s.delay);
+
+    ++est_.samples;
+    update();
+    est_.valid = est_.samples >= uint64_t(p_.min_samples);
+    return true;
+}
+
+void ClockSync::update() {
+    double d[kClockSyncMaxWin];
+    for (int i = 0; i < n_; ++i) d[i] = win_[i].delay;
+
+    const int mid = n_ / 2;
+    std::nth_element(d, d + mid, d + n_);
+    est_.one_way     = float(0.5 * d[mid]);
+    est_.one_way_min = float(0.5 * *std::min_element(d, d + n_));
+
+    const int m = std::clamp(int(std::ceil(p_.best_fraction * n_)), std::min(n_, 2), n_);
+    std::nth_element(d, d + m - 1, d + n_);
+    const double thr = d[m - 1];
+
+    // line fit of offset over time through the low-delay exchanges,
+    // anchored at the newest one
+    const double t_ref = win_[(head_ + p_.window - 1) % p_.window].t;
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    double x_min = 0.0, x_max = 0.0;
+    int cnt = 0;
+    for (int i = 0; i < n_; ++i) {
+        if (win_[i].delay > thr) continue;
+        const double x = win_[i].t - t_ref;
+        const double y = win_[i].offset;
+        sx += x; sy += y; sxx += x * x; sxy += x * y;
+        x_min = cnt ? std::min(x_min, x) : x;
+        x_max = cnt ? std::max(x_max, x) : x;
+        ++cnt;
+    }
+    const double xbar = sx / cnt, ybar = sy / cnt;
+    const double vxx  = sxx - cnt * xbar * xbar;
+    if (cnt >= 3 && x_max - x_min >= p_.min_span && vxx > 0.0) {
+        est_.drift = (sxy - cnt * xbar * ybar) / vxx;
+    }
+    est_.t_ref  = t_ref;
+    est_.offset = ybar - est_.drift * xbar;
+}
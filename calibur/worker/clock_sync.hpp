@@ -0,0 +1,106 @@
+// clock_sync.hpp
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "command_streamer.hpp"
+#include "usb_protocol.hpp"
+
+// Host <-> MCU clock synchronisation over the serial link, NTP style.
+//
+// The host sends USB_TX_PING stamped with its steady_clock (t1); the MCU
+// stamps reception (t2) and transmission (t3) with its free-running 32-bit
+// microsecond tick and answers USB_RX_PONG; the host stamps the pong at
+// dispatch (t4). Per exchange
+//
+//   offset = ((t2 - t1) + (t3 - t4)) / 2      MCU clock - host clock
+//   delay  = (t4 - t1) - (t3 - t2)            round trip on the wire
+//
+// Queueing only ever adds delay, and the offset error is bounded by half
+// the delay asymmetry, so the clock model (offset + drift) is a line fit
+// through the lowest-delay fraction of the recent exchanges. The one-way
+// link delay is half the median round trip over the same window.
+
+struct ClockSyncParams {
+    double ping_period   = 0.05;    // s, between pings
+    double tick_hz       = 1e6;     // MCU tick rate
+    int    window        = 256;     // exchanges kept, <= kClockSyncMaxWin
+    float  best_fraction = 0.25f;   // lowest-delay share used for the clock fit
+    double max_rtt       = 0.02;    // s, slower exchanges are dropped
+    double min_span      = 1.0;     // s of fit samples before drift is estimated
+    int    min_samples   = 4;       // exchanges before the estimate is valid
+};
+
+constexpr int kClockSyncMaxWin = 1024;
+
+struct ClockSyncEstimate {
+    bool     valid   = false;
+    double   t_ref   = 0.0;    // host s (steady_clock epoch) the model is anchored at
+    double   offset  = 0.0;    // s, MCU - host at t_ref
+    double   drift   = 0.0;    // MCU s per host s, minus one
+    float    one_way = 0.0f;   // s, typical host -> MCU delay (half the median round trip)
+    float    one_way_min = 0.0f;
+    uint64_t samples = 0;
+
+    double host_to_mcu(double host_s) const { return host_s + offset + drift * (host_s - t_ref); }
+    double mcu_to_host(double mcu_s) const {
+        return (mcu_s - offset + drift * t_ref) / (1.0 + drift);
+    }
+};
+
+class ClockSync {
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    explicit ClockSync(const ClockSyncParams &p = ClockSyncParams());
+
+    // True when the next ping is due.
+    bool due(TimePoint now) const { return now >= next_ping_; }
+
+    // Encodes a ping stamped with now into out (kUsbPingLen +
+    // kUsbFrameExtra bytes); returns its size.
+    size_t make_ping(TimePoint now, uint8_t *out);
+
+    // USB_RX_PONG payload received at t4. False if it was malformed or
+    // slower than max_rtt.
+    bool on_pong(const uint8_t *payload, uint16_t len, TimePoint t4);
+
+    const ClockSyncEstimate &estimate() const { return est_; }
+
+    // One-way delay (half round trip) distribution since the last reset.
+    JitterStats delay_stats() const { return hist_.stats(0); }
+    void        reset_delay_stats() { hist_.reset(); }
+
+    uint64_t rejected() const { return rejected_; }
+
+    // Extends a wrapping 32-bit tick; ticks must arrive roughly in order.
+    uint64_t unwrap(uint32_t tick);
+
+    static double seconds(TimePoint t) {
+        return std::chrono::duration<double>(t.time_since_epoch()).count();
+    }
+
+private:
+    struct Sample {
+        double t;        // host s, exchange midpoint
+        double offset;   // s
+        double delay;    // s
+    };
+
+    void update();
+
+    ClockSyncParams p_;
+    std::array<Sample, kClockSyncMaxWin> win_;
+    int        n_ = 0, head_ = 0;
+    uint32_t   seq_ = 0;
+    TimePoint  next_ping_{};
+    bool       have_tick_ = false;
+    uint32_t   last_tick_ = 0;
+    uint64_t   wraps_     = 0;
+    uint64_t   rejected_  = 0;
+    ClockSyncEstimate est_;
+    JitterHistogram   hist_;
+};
@@ -0,0 +1,148 @@
+// command_streamer.cpp
+#include "command_streamer.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+using SteadyClock = std::chrono::steady_clock;
+
+// ===================== JitterHistogram =====================
+
+void JitterHistogram::add(double us) {
+    us = std::max(us, 0.0);
+    ++bins_[std::min(int(us), kBins)];
+    ++n_;
+    sum_us_ += us;
+    max_us_  = std::max(max_us_, us);
+}
+
+void JitterHistogram::reset() {
+    bins_.fill(0);
+    n_      = 0;
+    sum_us_ = 0.0;
+    max_us_ = 0.0;
+}
+
+JitterStats JitterHistogram::stats(uint64_t missed) const {
+    JitterStats s;
+    s.ticks  = n_;
+    s.missed = missed;
+    if (n_ == 0) return s;
+    s.mean_us = sum_us_ / double(n_);
+    s.max_us  = max_us_;
+
+    // upper edge of the bin holding the quantile (overflow bin: max)
+    auto quantile = [&](double q) {
+        const uint64_t rank = uint64_t(q * double(n_ - 1)) + 1;
+        uint64_t seen = 0;
+        for (int b = 0; b <= kBins; ++b) {
+            seen += bins_[b];
+            if (seen >= rank) return b < kBins ? std::min(double(b + 1), max_us_) : max_us_;
+        }
+        return max_us_;
+    };
+    s.p50_us = quantile(0.50);
+    s.p99_us = quantile(0.99);
+    return s;
+}
+
+// ===================== CommandStreamer =====================
+
+CommandStreamer::CommandStreamer(const StreamerParams &p) : p_(p) {}
+
+JitterStats CommandStreamer::window() const {
+    std::lock_guard<std::mutex> lk(stats_mtx_);
+    return window_;
+}
+
+JitterStats CommandStreamer::total() const {
+    std::lock_guard<std::mutex> lk(stats_mtx_);
+    return total_;
+}
+
+static timespec to_timespec(SteadyClock::duration d) {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    timespec ts;
+    ts.tv_sec  = time_t(ns / 1000000000);
+    ts.tv_nsec = long(ns % 1000000000);
+    return ts;
+}
+
+bool CommandStreamer::run(const std::atomic<bool> &stop, const Tick &tick) {
+    // steady_clock is CLOCK_MONOTONIC on Linux, so expiries are scheduled
+    // in the same time base the commands are stamped in
+    const int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "[CMD ERROR] timerfd_create: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    const auto period = std::chrono::duration_cast<SteadyClock::duration>(
+        std::chrono::duration<double>(1.0 / std::max(p_.rate_hz, 1.0)));
+    const auto start = SteadyClock::now() + period;
+
+    itimerspec spec{};
+    spec.it_value    = to_timespec(start.time_since_epoch());
+    spec.it_interval = to_timespec(period);
+    if (timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) {
+        std::cerr << "[CMD ERROR] timerfd_settime: " << std::strerror(errno) << "\n";
+        close(fd);
+        return false;
+    }
+
+    JitterHistogram win, all;
+    uint64_t expirations = 0;    // timer periods elapsed since start
+    uint64_t win_missed = 0, all_missed = 0;
+    const auto report_every = std::chrono::duration_cast<SteadyClock::duration>(
+        std::chrono::duration<double>(p_.report_period > 0.0 ? p_.report_period : 1.0));
+    auto next_report = start + report_every;
+
+    auto publish = [&]() {
+        std::lock_guard<std::mutex> lk(stats_mtx_);
+        window_ = win.stats(win_missed);
+        total_  = all.stats(all_missed);
+    };
+
+    while (!stop.load(std::memory_order_relaxed)) {
+        uint64_t n = 0;
+        if (read(fd, &n, sizeof(n)) != ssize_t(sizeof(n))) {
+            if (errno == EINTR) continue;
+            std::cerr << "[CMD ERROR] timerfd read: " << std::strerror(errno) << "\n";
+            break;
+        }
+        const auto now = SteadyClock::now();
+
+        // the most recent expiry is the one this tick serves; n > 1 means
+        // the earlier ones were slept through
+        expirations += n;
+        const auto scheduled = start + period * int64_t(expirations - 1);
+        const double late_us = std::chrono::duration<double, std::micro>(now - scheduled).count();
+        win.add(late_us);
+        all.add(late_us);
+        win_missed += n - 1;
+        all_missed += n - 1;
+
+        tick(now);
+
+        if (now >= next_report) {
+            publish();
+            if (p_.report_period > 0.0) {
+                const JitterStats s = win.stats(win_missed);
+                std::cout << "[CMD] " << p_.rate_hz << " Hz: " << s.ticks << " ticks, "
+                          << s.missed << " missed, jitter mean " << s.mean_us
+                          << " us, p50 " << s.p50_us << " us, p99 " << s.p99_us
+                          << " us, max " << s.max_us << " us\n";
+            }
+            win.reset();
+            win_missed  = 0;
+            next_report = now + report_every;
+        }
+    }
+
+    publish();
+    close(fd);
+    return true;
+}
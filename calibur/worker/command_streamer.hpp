@@ -0,0 +1,133 @@
+// command_streamer.hpp
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+#include "../imu/imu_history.hpp"
+
+// Fixed-rate gimbal command stage.
+//
+// PredictionWorker publishes a setpoint whenever the tracker has a new
+// posterior (irregular, ~100 Hz with gaps). CommandStreamer wakes on a
+// periodic timerfd instead, and on every tick the caller sends the latest
+// setpoint extrapolated to that exact instant with extrapolate_command.
+// The setpoint already leads the target by the gimbal latency, so the
+// extrapolation only covers the time since it was computed. Setpoints are
+// relative to the gimbal attitude they were computed against, and the
+// gimbal keeps turning in between, so rebase_command then re-expresses the
+// extrapolated one against the attitude at send time.
+//
+// Wake-up jitter (actual wake - scheduled expiry) and missed periods are
+// measured per tick and reported as percentiles every report_period.
+
+struct StreamerParams {
+    double rate_hz           = 1000.0;
+    float  max_extrapolation = 0.05f;   // s, hold the last extrapolated value beyond this
+    float  stale_after       = 0.25f;   // s, stop sending fire / aim on older setpoints
+    double report_period     = 5.0;     // s, 0: never print
+};
+
+struct JitterStats {
+    uint64_t ticks   = 0;
+    uint64_t missed  = 0;      // timer periods that expired without a tick
+    double   mean_us = 0.0;
+    double   p50_us  = 0.0;
+    double   p99_us  = 0.0;
+    double   max_us  = 0.0;
+};
+
+// Wake-up latency histogram: 1 us bins up to kBins us, plus overflow.
+// Fixed size, no allocation on the tick path.
+class JitterHistogram {
+public:
+    void add(double us);
+    void reset();
+    JitterStats stats(uint64_t missed) const;
+
+private:
+    static constexpr int kBins = 4096;
+    std::array<uint32_t, kBins + 1> bins_{};
+    uint64_t n_      = 0;
+    double   sum_us_ = 0.0;
+    double   max_us_ = 0.0;
+};
+
+class CommandStreamer {
+public:
+    using Tick = std::function<void(std::chrono::steady_clock::time_point now)>;
+
+    explicit CommandStreamer(const StreamerParams &p = StreamerParams());
+
+    // Calls tick at rate_hz until stop is set. Blocks; run it on its own
+    // thread. False if the timer could not be created.
+    bool run(const std::atomic<bool> &stop, const Tick &tick);
+
+    const StreamerParams &params() const { return p_; }
+
+    JitterStats window() const;   // last completed report window
+    JitterStats total() const;    // since run() started
+
+private:
+    StreamerParams p_;
+
+    mutable std::mutex stats_mtx_;
+    JitterStats window_;
+    JitterStats total_;
+};
+
+// Highest setpoint rate a serial link at `baud` (8N1: 10 bits a byte)
+// carries with frame_bytes per setpoint, using `share` of its bytes/s.
+// Streaming faster only queues stale setpoints in the driver.
+inline double link_command_rate(int baud, size_t frame_bytes, double share) {
+    if (baud <= 0 || frame_bytes == 0) return 0.0;
+    return share * (double(baud) / 10.0) / double(frame_bytes);
+}
+
+// Setpoint advanced to time t along its angular rate. Works on any command
+// with yaw / pitch / yaw_rate / pitch_rate / aim / fire / timestamp fields.
+template <class Cmd>
+Cmd extrapolate_command(const Cmd &c, std::chrono::steady_clock::time_point t,
+                        const StreamerParams &p) {
+    Cmd out = c;
+    const float age = std::chrono::duration<float>(t - c.timestamp).count();
+    const float dt  = std::clamp(age, 0.0f, p.max_extrapolation);
+    out.yaw   = c.yaw   + c.yaw_rate   * dt;
+    out.pitch = c.pitch + c.pitch_rate * dt;
+    if (age > p.stale_after) {
+        out.aim  = 0;
+        out.fire = 0;
+    }
+    return out;
+}
+
+// Command relative to the attitude (att_yaw, att_pitch) it was computed
+// against, re-expressed relative to (yaw_now, pitch_now): the absolute
+// setpoint, attitude + command, stays where it was. Commands without an
+// attitude pass through unchanged.
+template <class Cmd>
+Cmd rebase_command(const Cmd &c, float yaw_now, float pitch_now) {
+    Cmd out = c;
+    if (!c.att_valid) return out;
+    const float two_pi = 6.28318530718f;
+    out.yaw   = c.yaw   + std::remainder(c.att_yaw - yaw_now, two_pi);
+    out.pitch = c.pitch + (c.att_pitch - pitch_now);
+    return out;
+}
+
+// rebase_command against the IMU attitude at t, read the way the attitude
+// in att_yaw / att_pitch was (imu_yaw_pitch_at: absolute IMU yaw). Unchanged
+// if the history is empty.
+template <class Cmd>
+Cmd rebase_command_at(const Cmd &c, const ImuHistory &h, std::chrono::steady_clock::time_point t) {
+    float yaw = 0.0f, pitch = 0.0f;
+    if (!imu_yaw_pitch_at(h, t, yaw, pitch)) return c;
+    return rebase_command(c, yaw, pitch);
+}
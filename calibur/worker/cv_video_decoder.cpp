@@ -0,0 +1,62 @@
+// calibur/worker/cv_video_decoder.cpp
+#include "video_source.hpp"
+
+#include <cstring>
+#include <opencv2/videoio.hpp>
+
+namespace {
+
+// cv::VideoCapture behind VideoDecoder. Frames are retrieved straight into
+// the slot's storage once it has the stream's size (VideoCapture copies
+// its decoded frame into an output Mat that already fits).
+class CvVideoDecoder : public VideoDecoder {
+public:
+    explicit CvVideoDecoder(const std::string &path) : path_(path) { cap_.open(path_); }
+
+    bool opened() const { return cap_.isOpened(); }
+
+    double fps() const override { return cap_.get(cv::CAP_PROP_FPS); }
+
+    bool read(VideoImage &out) override {
+        if (!cap_.grab()) return false;
+        if (!out.data.empty()) {
+            cv::Mat dst(out.height, out.width, CV_8UC(out.channels), out.data.data(), out.step);
+            if (!cap_.retrieve(dst) || dst.empty()) return false;
+            if (dst.data == out.data.data()) return true;
+            tmp_ = dst;   // size or type changed: reallocated
+        } else if (!cap_.retrieve(tmp_) || tmp_.empty()) {
+            return false;
+        }
+        if (tmp_.depth() != CV_8U) return false;
+
+        out.width    = tmp_.cols;
+        out.height   = tmp_.rows;
+        out.channels = tmp_.channels();
+        out.step     = tmp_.cols * tmp_.elemSize();
+        out.data.resize(out.step * out.height);
+        for (int r = 0; r < tmp_.rows; ++r) {
+            std::memcpy(out.data.data() + r * out.step, tmp_.ptr(r), out.step);
+        }
+        return true;
+    }
+
+    bool rewind() override {
+        if (cap_.set(cv::CAP_PROP_POS_FRAMES, 0)) return true;
+        // not seekable: open it again
+        cap_.release();
+        return cap_.open(path_);
+    }
+
+private:
+    std::string      path_;
+    cv::VideoCapture cap_;
+    cv::Mat          tmp_;
+};
+
+}  // namespace
+
+std::unique_ptr<VideoDecoder> open_video_decoder(const std::string &path) {
+    auto dec = std::make_unique<CvVideoDecoder>(path);
+    if (!dec->opened()) return nullptr;
+    return dec;
+}
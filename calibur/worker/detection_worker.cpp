@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <vector>
 #include <stdlib.h>
 #include <atomic>
@@ -70,7 +72,6 @@ void DetectionWorker::operator()() {
 
     static thread_local float imu_yaw, imu_pitch;
     static thread_local RobotState local_robot_state;   //keep track of what robot is being tracked
-    static thread_local std::shared_ptr<IMUState> imu;
     static thread_local std::vector<DetectionResult> selected_armors;
     static thread_local std::vector<DetectionResult> dets;
     static thread_local std::vector<DetectionResult> refined_dets;
@@ -92,8 +93,7 @@ void DetectionWorker::operator()() {
         last_cam_ver_ = cur_ver;
 
         auto yolo_result = std::atomic_load(&shared_.yolo);
-        imu = std::atomic_load(&shared_.imu);
-        if (!yolo_result || !imu) {
+        if (!yolo_result || shared_.imu_history.empty()) {
             sleep_small();
             continue;
         }
@@ -108,7 +108,7 @@ void DetectionWorker::operator()() {
         
         // Refine yolo detections using traditional CV methods for armorplate 
         // 2) keypoint refine + filtering by confidence
-        refined_dets = refine_keypoints(shared_.camera, dets);
+        refined_dets = refine_keypoints(std::atomic_load(&shared_.camera), dets);
 
         // 3) solvePnP + yaw in cam frame
         solvepnp_and_yaw(dets);
@@ -119,9 +119,14 @@ void DetectionWorker::operator()() {
         selected_armors.clear();
         select_armor(grouped_armors, ttl_, selected_robot_id_, initial_yaw_, selected_armors);
 
-        // 5) transform to world using latest IMU
+#ifdef CAMERA_DYNAMIC_ROI
+        // 4b) box of the locked robot for the camera window
+        publish_roi_target(selected_armors, yolo_result->timestamp);
+#endif
+
+        // 5) transform to world using the IMU attitude at capture time
         //TODO: considering whether to do pnp first or select robot first
-        bool success = get_imu_yaw_pitch(this->shared_, imu_yaw, imu_pitch);
+        bool success = get_imu_yaw_pitch_at(this->shared_, yolo_result->timestamp, imu_yaw, imu_pitch);
         float init_yaw = std::atomic_load(&scalars_.initial_yaw);
 
         std::cout << "[PNP]: x=" << selected_armors[0].tvec[0]
@@ -151,7 +156,8 @@ void DetectionWorker::operator()() {
                 }
                 auto ptr = std::make_shared<RobotState>(*robot);
                 std::atomic_store(&shared_.detection_out, ptr);
-                shared_.detection_ver.fetch_add(1, std::memory_order_relaxed);
+                shared_.detection_ver.fetch_add(1, std::memory_order_release);
+                shared_.detection_signal.notify();
             }
         }   //TODO: else...
     }
@@ -167,8 +173,10 @@ DetectionWorker::yolo_predict(const std::vector<uint8_t> &raw, int w, int h, std
 }
 
 std::vector<DetectionResult> DetectionWorker::refine_keypoints(std::shared_ptr<CameraFrame> camera_frame, std::vector<DetectionResult> &dets) {
-    int height = camera_frame->height;
-    int width = camera_frame->width;
+    if (!camera_frame) return dets;   // dropped for a camera window resize
+    // keypoints are in full-frame pixels
+    int height = camera_frame->full_height;
+    int width = camera_frame->full_width;
     cv::Mat img = camera_frame->raw_data;
     int count = 0;
     for(const DetectionResult& det : dets) {
@@ -210,6 +218,30 @@ std::vector<DetectionResult> DetectionWorker::refine_keypoints(std::shared_ptr<C
     return dets;
 }
 
+void DetectionWorker::publish_roi_target(const std::vector<DetectionResult> &armors, TimePoint timestamp) {
+    float x_min = std::numeric_limits<float>::max();
+    float y_min = std::numeric_limits<float>::max();
+    float x_max = std::numeric_limits<float>::lowest();
+    float y_max = std::numeric_limits<float>::lowest();
+    for (const auto &det : armors) {
+        for (const auto &p : det.keypoints) {
+            x_min = std::min(x_min, p.x);
+            y_min = std::min(y_min, p.y);
+            x_max = std::max(x_max, p.x);
+            y_max = std::max(y_max, p.y);
+        }
+    }
+    if (x_max <= x_min || y_max <= y_min) return;
+
+    auto target = std::make_shared<RoiTarget>();
+    target->x         = x_min;
+    target->y         = y_min;
+    target->w         = x_max - x_min;
+    target->h         = y_max - y_min;
+    target->timestamp = timestamp;
+    std::atomic_store(&shared_.roi_target, std::shared_ptr<RoiTarget>(std::move(target)));
+}
+
 void DetectionWorker::solvepnp_and_yaw(std::vector<DetectionResult> &dets) {
     // solvePnP, Rodrigues, decompose, yaw_rad
     for (auto &det : dets)
@@ -31,7 +31,18 @@ void DisplayWorker::operator()() {
             continue;
         }
 
-        cv::Mat img = cam_ptr->raw_data.clone();
+        cv::Mat img;
+        const SensorRoi &roi = cam_ptr->roi;
+        if (roi.w < cam_ptr->full_width || roi.h < cam_ptr->full_height) {
+            // a readout window: shown in place on the full frame, so the
+            // overlays (full-frame coordinates) line up
+            img = cv::Mat(cam_ptr->full_height, cam_ptr->full_width, CV_8UC3, cv::Scalar(40, 40, 40));
+            const cv::Rect r(roi.x, roi.y, cam_ptr->raw_data.cols, cam_ptr->raw_data.rows);
+            cam_ptr->raw_data.copyTo(img(r));
+            cv::rectangle(img, r, cv::Scalar(0, 160, 0), 1);
+        } else {
+            img = cam_ptr->raw_data.clone();
+        }
 
         // --- 2. PREDICTION (for aim marker) ---
         auto pred_ptr = std::atomic_load(&shared_.prediction_out);
@@ -44,7 +55,7 @@ void DisplayWorker::operator()() {
         // --- Draw all overlays ---
         draw_yolo_overlay(img, yolo);
         draw_crosshair(img, pred);
-        draw_target_dot(img, pred, cam_ptr->width, cam_ptr->height);
+        draw_target_dot(img, pred, cam_ptr->full_width, cam_ptr->full_height);
         draw_info_panel(img, pred, fps);
 
         // --- FPS measure ---
@@ -0,0 +1,135 @@
+// fire_control.cpp
+#include "fire_control.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+constexpr float kPi       = 3.14159265358979f;
+constexpr float kTwoPi    = 2.0f * kPi;
+constexpr float kHalfPi   = 0.5f * kPi;
+
+// Round to nearest without a libm call: adding 1.5 * 2^23 pushes the
+// fraction out of the mantissa (|x| < 2^22). Needs IEEE evaluation order,
+// i.e. no -ffast-math on this file.
+inline float round_fast(float x) {
+    constexpr float kMagic = 12582912.0f;
+    return (x + kMagic) - kMagic;
+}
+
+// sin / cos on [-pi/4, pi/4], Taylor to x^7 / x^8 (error < 4e-7).
+inline float sin_q(float x) {
+    const float x2 = x * x;
+    return x * (1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f))));
+}
+
+inline float cos_q(float x) {
+    const float x2 = x * x;
+    return 1.0f + x2 * (-0.5f + x2 * (1.0f / 24.0f + x2 * (-1.0f / 720.0f + x2 * (1.0f / 40320.0f))));
+}
+
+} // namespace
+
+FireControl::FireControl(const FireControlParams &p)
+    : p_(p), K_((std::max(p.samples, 8) + 7) & ~7)
+{
+    noise_.resize(size_t(kNoiseDims) * K_);
+    std::mt19937 rng(p.seed);
+    std::normal_distribution<float> nd(0.0f, 1.0f);
+    for (int d = 0; d < kNoiseDims; ++d) {
+        float *n = &noise_[size_t(d) * K_];
+        for (int i = 0; i < K_; i += 2) {   // antithetic pairs: exact zero mean
+            n[i]     = nd(rng);
+            n[i + 1] = -n[i];
+        }
+    }
+}
+
+FireDecision FireControl::evaluate(const float *mean, const float *var, float t_lead,
+                                   const float *aim) const {
+    FireDecision out;
+    out.range = std::sqrt(aim[0] * aim[0] + aim[1] * aim[1] + aim[2] * aim[2]);
+
+    float sd[ROBOT_STATE_VEC_LEN];
+    for (int k = 0; k < ROBOT_STATE_VEC_LEN; ++k) {
+        if (!(var[k] >= 0.0f) || !std::isfinite(mean[k])) return out;   // NaN: never fire
+        sd[k] = std::min(std::sqrt(var[k]), 10.0f);                    // inf: just very wide
+    }
+
+    const float t   = std::max(t_lead, 0.0f);
+    const float t2h = 0.5f * t * t;
+
+    // line of sight to the mean center at impact: the plate facing the
+    // muzzle has outward normal (sin psi, -cos psi) ~ -center
+    const float cx = mean[IDX_TX] + mean[IDX_VX] * t + mean[IDX_AX] * t2h;
+    const float cz = mean[IDX_TZ] + mean[IDX_VZ] * t + mean[IDX_AZ] * t2h;
+    const float ch = std::sqrt(cx * cx + cz * cz);
+    if (!(ch > 1e-3f)) return out;
+    const float psi_los = std::atan2(-cx, cz);
+    const float s_los = std::sin(psi_los), c_los = std::cos(psi_los);
+    const float ux = cz / ch, uz = -cx / ch;        // horizontal, across the line of sight
+
+    const float gun    = p_.gun_sigma * out.range;
+    const float half_w = p_.plate_half_w;
+    const float half_h = p_.plate_half_h;
+    const float ax = aim[0], ay = aim[1], az = aim[2];
+
+    const int K = K_;
+    const float *n = noise_.data();
+    auto dim = [&](int d) { return n + size_t(d) * K; };
+    const float *n_tx = dim(IDX_TX), *n_ty = dim(IDX_TY), *n_tz = dim(IDX_TZ);
+    const float *n_vx = dim(IDX_VX), *n_vy = dim(IDX_VY), *n_vz = dim(IDX_VZ);
+    const float *n_ax = dim(IDX_AX), *n_ay = dim(IDX_AY), *n_az = dim(IDX_AZ);
+    const float *n_yw = dim(IDX_YAW), *n_om = dim(IDX_OMEGA), *n_al = dim(IDX_ALPHA);
+    const float *n_r1 = dim(IDX_R1), *n_r2 = dim(IDX_R2), *n_h = dim(IDX_H);
+    const float *n_gx = dim(ROBOT_STATE_VEC_LEN), *n_gy = dim(ROBOT_STATE_VEC_LEN + 1);
+
+    int hits = 0;
+    for (int i = 0; i < K; ++i) {
+        // sample, carried to impact
+        const float px = mean[IDX_TX] + sd[IDX_TX] * n_tx[i]
+                       + (mean[IDX_VX] + sd[IDX_VX] * n_vx[i]) * t
+                       + (mean[IDX_AX] + sd[IDX_AX] * n_ax[i]) * t2h;
+        const float py = mean[IDX_TY] + sd[IDX_TY] * n_ty[i]
+                       + (mean[IDX_VY] + sd[IDX_VY] * n_vy[i]) * t
+                       + (mean[IDX_AY] + sd[IDX_AY] * n_ay[i]) * t2h;
+        const float pz = mean[IDX_TZ] + sd[IDX_TZ] * n_tz[i]
+                       + (mean[IDX_VZ] + sd[IDX_VZ] * n_vz[i]) * t
+                       + (mean[IDX_AZ] + sd[IDX_AZ] * n_az[i]) * t2h;
+        const float yaw = mean[IDX_YAW] + sd[IDX_YAW] * n_yw[i]
+                        + (mean[IDX_OMEGA] + sd[IDX_OMEGA] * n_om[i]) * t
+                        + (mean[IDX_ALPHA] + sd[IDX_ALPHA] * n_al[i]) * t2h;
+
+        // facing plate: yaw_k - psi_los in [-pi/4, pi/4]
+        float d = yaw - psi_los;
+        d -= kTwoPi * round_fast(d * (1.0f / kTwoPi));
+        const float q  = round_fast(d * (1.0f / kHalfPi));
+        const float pr = d - q * kHalfPi;
+        const bool odd = (int(q) & 1) != 0;
+
+        const float r1 = mean[IDX_R1] + sd[IDX_R1] * n_r1[i];
+        const float r2 = mean[IDX_R2] + sd[IDX_R2] * n_r2[i];
+        const float hh = mean[IDX_H]  + sd[IDX_H]  * n_h[i];
+        const float r  = odd ? r2 : r1;
+        const float dy = odd ? -hh : 0.0f;
+
+        const float sr = sin_q(pr), cr = cos_q(pr);
+        const float sk = s_los * cr + c_los * sr;   // sin(psi_los + pr)
+        const float ck = c_los * cr - s_los * sr;
+
+        // aim point relative to the plate, across the line of sight
+        const float ex = ax - (px + r * sk);
+        const float ey = ay - (py + dy);
+        const float ez = az - (pz - r * ck);
+        const float lat = ex * ux + ez * uz + gun * n_gx[i];
+        const float ver = ey + gun * n_gy[i];
+
+        hits += (std::fabs(lat) < half_w * cr) & (std::fabs(ver) < half_h);
+    }
+
+    out.hit_prob = float(hits) / float(K);
+    out.fire     = out.hit_prob >= p_.min_hit_prob;
+    return out;
+}
@@ -0,0 +1,63 @@
+// fire_control.hpp
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "state_index.hpp"
+
+// Fire decision from the tracker posterior instead of a fixed tolerance box.
+//
+// The posterior (mean + marginal variances, world frame, PosteriorSummary
+// layout) is sampled K times, each sample is carried forward by the lead
+// time with the constant-acceleration model of rbpf_extrapolate_state, and
+// the armor plate facing the shooter is placed from its yaw / radii / height
+// offset the way DetectionWorker builds the state:
+//
+//   plate k: yaw_k = yaw - k * pi/2, r = k odd ? r2 : r1, dy = k odd ? -h : 0
+//            pos   = center + (r sin yaw_k, dy, -r cos yaw_k)
+//
+// A sample counts as a hit if the aim point, plus the gun's angular
+// dispersion, falls on that plate as seen from the muzzle (width shrunk by
+// the plate's angle to the line of sight). The hit probability is the hit
+// fraction; fire when it clears the threshold.
+//
+// The standard normals are drawn once at construction (antithetic pairs)
+// and stored per dimension, so a decision is deterministic for a given
+// input and the per-sample loop is branch-free and vectorizes.
+
+struct FireControlParams {
+    int      samples      = 256;      // rounded up to a multiple of 8
+    float    plate_half_w = 0.0675f;  // m, small armor 135 mm
+    float    plate_half_h = 0.0275f;  // m, 55 mm light-bar height
+    float    gun_sigma    = 0.003f;   // rad, 1-sigma shot dispersion per axis
+    float    min_hit_prob = 0.6f;
+    uint32_t seed         = 1234u;
+};
+
+struct FireDecision {
+    float hit_prob = 0.0f;
+    bool  fire     = false;
+    float range    = 0.0f;   // m, muzzle to aim point
+};
+
+class FireControl {
+public:
+    explicit FireControl(const FireControlParams &p = FireControlParams());
+
+    // mean / var: [ROBOT_STATE_VEC_LEN] posterior, world frame (y up).
+    // t_lead: s from the posterior's time to impact.
+    // aim: [3] world point the shot passes through at impact.
+    FireDecision evaluate(const float *mean, const float *var, float t_lead,
+                          const float *aim) const;
+
+    int samples() const { return K_; }
+    const FireControlParams &params() const { return p_; }
+
+private:
+    static constexpr int kNoiseDims = ROBOT_STATE_VEC_LEN + 2;   // state + gun x/y
+
+    FireControlParams p_;
+    int K_;
+    std::vector<float> noise_;   // [kNoiseDims][K_]
+};
@@ -0,0 +1,234 @@
+// gimbal_id.cpp
+#include "gimbal_id.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+// ===================== Log I/O =====================
+
+bool gimbal_log_read(const std::string &path, std::vector<GimbalLogRecord> &out) {
+    std::ifstream in(path);
+    if (!in) return false;
+
+    std::string line;
+    int lineno = 0;
+    while (std::getline(in, line)) {
+        ++lineno;
+        if (line.empty() || line[0] == '#' || line[0] == 't') continue;   // comment / header
+
+        GimbalLogRecord r{};
+        float *fields[4] = {&r.set[0], &r.set[1], &r.meas[0], &r.meas[1]};
+        const char *s = line.c_str();
+        char *end = nullptr;
+        r.t = std::strtod(s, &end);
+        bool ok = end != s;
+        for (int k = 0; ok && k < 4; ++k) {
+            if (*end != ',') { ok = false; break; }
+            s = end + 1;
+            *fields[k] = std::strtof(s, &end);
+            ok = end != s;
+        }
+        if (!ok) {
+            std::cerr << "[GIMBAL] " << path << ":" << lineno << ": malformed record\n";
+            return false;
+        }
+        out.push_back(r);
+    }
+    return true;
+}
+
+bool GimbalLogWriter::open(const std::string &path) {
+    close();
+    f_ = std::fopen(path.c_str(), "w");
+    if (!f_) return false;
+    std::fprintf(f_, "t,yaw_set,pitch_set,yaw_imu,pitch_imu\n");
+    return true;
+}
+
+void GimbalLogWriter::append(double t, float yaw_set, float pitch_set,
+                             float yaw_imu, float pitch_imu) {
+    if (!f_) return;
+    std::fprintf(f_, "%.6f,%.7g,%.7g,%.7g,%.7g\n", t, yaw_set, pitch_set, yaw_imu, pitch_imu);
+}
+
+void GimbalLogWriter::close() {
+    if (f_) std::fclose(f_);
+    f_ = nullptr;
+}
+
+// ===================== Replay =====================
+
+double gimbal_replay_rmse(const std::vector<GimbalLogRecord> &log, int axis,
+                          const GimbalAxisParams &p, const GimbalIdOptions &opt,
+                          size_t *samples) {
+    double sse = 0.0;
+    size_t n   = 0;
+
+    size_t seg = 0;
+    while (seg < log.size()) {
+        size_t end = seg + 1;
+        while (end < log.size() && log[end].t - log[end - 1].t <= opt.max_gap) ++end;
+
+        float theta = log[seg].meas[axis];
+        float omega = 0.0f;
+        size_t j    = seg;       // last setpoint issued before t - dead_time
+        bool   live = false;     // any setpoint old enough yet
+        for (size_t i = seg + 1; i < end; ++i) {
+            const double t0 = log[i - 1].t;
+            const double span = log[i].t - t0;
+            const int    sub  = std::max(1, int(std::ceil(span / opt.sim_dt)));
+            const float  h    = float(span / sub);
+            for (int k = 1; k <= sub; ++k) {
+                const double td = t0 + span * k / sub - p.dead_time;
+                while (j + 1 < end && log[j + 1].t <= td) ++j;
+                live = live || log[j].t <= td;
+                const float u = live ? log[j].set[axis] : log[seg].meas[axis];
+                gimbal_axis_step(p, u, h, theta, omega);
+            }
+            const double e = double(theta) - double(log[i].meas[axis]);
+            sse += e * e;
+            ++n;
+        }
+        seg = end;
+    }
+
+    if (samples) *samples = n;
+    return n ? std::sqrt(sse / double(n)) : 0.0;
+}
+
+// ===================== Identification =====================
+
+namespace {
+
+using Vec3 = std::array<double, 3>;   // ln wn, ln zeta, ln rate_limit
+
+GimbalAxisParams decode(const Vec3 &x, float dead_time) {
+    GimbalAxisParams p;
+    p.wn         = float(std::exp(std::clamp(x[0], std::log(1.0), std::log(400.0))));
+    p.zeta       = float(std::exp(std::clamp(x[1], std::log(0.05), std::log(5.0))));
+    p.rate_limit = float(std::exp(std::clamp(x[2], std::log(0.1), std::log(200.0))));
+    p.dead_time  = dead_time;
+    return p;
+}
+
+Vec3 encode(const GimbalAxisParams &p) {
+    return {std::log(double(p.wn)), std::log(double(p.zeta)), std::log(double(p.rate_limit))};
+}
+
+// Plain Nelder-Mead; returns the best vertex, f(best) in fbest.
+template <class F>
+Vec3 nelder_mead(const F &f, const Vec3 &x0, double step, int iters, double &fbest) {
+    std::array<Vec3, 4>   x;
+    std::array<double, 4> fx;
+    for (int v = 0; v < 4; ++v) {
+        x[v] = x0;
+        if (v > 0) x[v][v - 1] += step;
+        fx[v] = f(x[v]);
+    }
+
+    for (int it = 0; it < iters; ++it) {
+        std::array<int, 4> o = {0, 1, 2, 3};
+        std::sort(o.begin(), o.end(), [&](int a, int b) { return fx[a] < fx[b]; });
+        const int best = o[0], worst = o[3], second = o[2];
+        if (fx[worst] - fx[best] < 1e-12 * (1.0 + fx[best])) break;
+
+        Vec3 c{0.0, 0.0, 0.0};
+        for (int v = 0; v < 4; ++v)
+            if (v != worst)
+                for (int d = 0; d < 3; ++d) c[d] += x[v][d] / 3.0;
+
+        auto along = [&](double a) {
+            Vec3 y;
+            for (int d = 0; d < 3; ++d) y[d] = c[d] + a * (x[worst][d] - c[d]);
+            return y;
+        };
+
+        const Vec3 xr = along(-1.0);
+        const double fr = f(xr);
+        if (fr < fx[best]) {
+            const Vec3 xe = along(-2.0);
+            const double fe = f(xe);
+            if (fe < fr) { x[worst] = xe; fx[worst] = fe; }
+            else         { x[worst] = xr; fx[worst] = fr; }
+        } else if (fr < fx[second]) {
+            x[worst] = xr; fx[worst] = fr;
+        } else {
+            const Vec3 xc = along(fr < fx[worst] ? -0.5 : 0.5);
+            const double fc = f(xc);
+            if (fc < std::min(fr, fx[worst])) {
+                x[worst] = xc; fx[worst] = fc;
+            } else {
+                for (int v = 0; v < 4; ++v) {   // shrink towards the best
+                    if (v == best) continue;
+                    for (int d = 0; d < 3; ++d) x[v][d] = x[best][d] + 0.5 * (x[v][d] - x[best][d]);
+                    fx[v] = f(x[v]);
+                }
+            }
+        }
+    }
+
+    const int b = int(std::min_element(fx.begin(), fx.end()) - fx.begin());
+    fbest = fx[b];
+    return x[b];
+}
+
+} // namespace
+
+GimbalFit gimbal_identify_axis(const std::vector<GimbalLogRecord> &log, int axis,
+                               const GimbalIdOptions &opt) {
+    GimbalFit fit;
+    if (log.size() < 2) return fit;
+
+    auto fit_at = [&](float dead_time, const Vec3 &x0, double step, int iters, double &rmse) {
+        auto f = [&](const Vec3 &x) {
+            return gimbal_replay_rmse(log, axis, decode(x, dead_time), opt);
+        };
+        return nelder_mead(f, x0, step, iters, rmse);
+    };
+
+    // Start from the fastest slew seen in the log (over ~5 ms, so IMU noise
+    // does not count): the rate limit is otherwise easy to lose, any value
+    // above the largest slew fits the small moves equally well.
+    GimbalAxisParams start;
+    double max_slew = 0.0;
+    for (size_t i = 0; i < log.size(); ++i) {
+        size_t j = i + 1;
+        while (j < log.size() && log[j].t - log[i].t < 0.005) ++j;
+        if (j >= log.size() || log[j].t - log[i].t > opt.max_gap) continue;
+        max_slew = std::max(max_slew, std::fabs(double(log[j].meas[axis]) - log[i].meas[axis])
+                                          / (log[j].t - log[i].t));
+    }
+    if (max_slew > 0.1) start.rate_limit = float(max_slew);
+    const Vec3 x0 = encode(start);
+
+    // coarse pass over the dead-time grid
+    struct Cand { float dead_time; Vec3 x; double rmse; };
+    std::vector<Cand> cands;
+    const int nd = int(std::floor(opt.max_dead_time / opt.dead_time_step + 1e-6)) + 1;
+    for (int k = 0; k < nd; ++k) {
+        const float dt = float(k) * opt.dead_time_step;
+        double rmse = 0.0;
+        const Vec3 x = fit_at(dt, x0, 0.4, std::max(opt.iters / 4, 10), rmse);
+        cands.push_back({dt, x, rmse});
+    }
+
+    // refine the best few
+    std::sort(cands.begin(), cands.end(),
+              [](const Cand &a, const Cand &b) { return a.rmse < b.rmse; });
+    cands.resize(std::min<size_t>(cands.size(), 3));
+    fit.rmse = 1e300;
+    for (const Cand &c : cands) {
+        double rmse = 0.0;
+        const Vec3 xr = fit_at(c.dead_time, c.x, 0.1, opt.iters, rmse);
+        if (rmse < fit.rmse) {
+            fit.rmse   = rmse;
+            fit.params = decode(xr, c.dead_time);
+        }
+    }
+    gimbal_replay_rmse(log, axis, fit.params, opt, &fit.samples);
+    return fit;
+}
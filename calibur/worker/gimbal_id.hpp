@@ -0,0 +1,71 @@
+// gimbal_id.hpp
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "gimbal_model.hpp"
+
+// Offline identification of GimbalAxisParams from logged command / IMU
+// pairs. One CSV line per command sent, angles in rad:
+//
+//   t,yaw_set,pitch_set,yaw_imu,pitch_imu
+//
+// *_set is the absolute angle the gimbal was told to go to, *_imu the angle
+// it was at when the command went out. Lines starting with '#' are
+// comments; a gap longer than GimbalIdOptions::max_gap starts a new segment.
+
+struct GimbalLogRecord {
+    double t;
+    float  set[2];    // [yaw, pitch]
+    float  meas[2];
+};
+
+enum GimbalAxis { GIMBAL_YAW = 0, GIMBAL_PITCH = 1 };
+
+// Appends to `out`; false if the file cannot be read / parsed.
+bool gimbal_log_read(const std::string &path, std::vector<GimbalLogRecord> &out);
+
+class GimbalLogWriter {
+public:
+    GimbalLogWriter() = default;
+    ~GimbalLogWriter() { close(); }
+
+    GimbalLogWriter(const GimbalLogWriter&) = delete;
+    GimbalLogWriter& operator=(const GimbalLogWriter&) = delete;
+
+    bool open(const std::string &path);
+    void append(double t, float yaw_set, float pitch_set, float yaw_imu, float pitch_imu);
+    void close();
+    bool is_open() const { return f_ != nullptr; }
+
+private:
+    std::FILE *f_ = nullptr;
+};
+
+struct GimbalIdOptions {
+    float  max_dead_time  = 0.05f;    // s, dead-time grid upper end
+    float  dead_time_step = 0.001f;   // s
+    int    iters          = 200;      // Nelder-Mead iterations per dead time
+    float  sim_dt         = 5e-4f;    // s
+    double max_gap        = 0.1;      // s, longer gaps split the log
+};
+
+struct GimbalFit {
+    GimbalAxisParams params;
+    double rmse    = 0.0;   // rad, simulated vs measured
+    size_t samples = 0;
+};
+
+// Replays the logged setpoints of one axis through the model (state reset
+// to the measurement at each segment start) and returns the RMS error
+// against the measured angle.
+double gimbal_replay_rmse(const std::vector<GimbalLogRecord> &log, int axis,
+                          const GimbalAxisParams &p, const GimbalIdOptions &opt,
+                          size_t *samples = nullptr);
+
+// Least-squares fit: grid over the dead time, Nelder-Mead over
+// (wn, zeta, rate_limit) at each.
+GimbalFit gimbal_identify_axis(const std::vector<GimbalLogRecord> &log, int axis,
+                               const GimbalIdOptions &opt = GimbalIdOptions());
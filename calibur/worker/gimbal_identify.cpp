@@ -0,0 +1,108 @@
+// gimbal_identify.cpp
+//
+// Offline gimbal identification over recorded command / IMU logs
+// (gimbal_id.hpp, written by USBWorker when GIMBAL_RECORD_LOG is set).
+// Fits the rate-limited second-order model per axis and writes the YAML
+// PredictionWorker loads at startup (GIMBAL_MODEL_YAML).
+//
+//   gimbal_identify [options] log.csv [log.csv ...]
+//     --max-dead-time S   dead-time search range, seconds (0.05)
+//     --iters N           Nelder-Mead iterations per dead time (200)
+//     --sim-dt S          replay step, seconds (5e-4)
+//     --settle-tol R      "on target" band for the delay table, rad (0.005)
+//     --out FILE          output YAML (config/gimbal_model.yaml)
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gimbal_id.hpp"
+#include "gimbal_model.hpp"
+
+static void usage(const char *argv0) {
+    std::cerr << "usage: " << argv0 << " [--max-dead-time S] [--iters N] [--sim-dt S]"
+              << " [--settle-tol R] [--out FILE] log.csv [log.csv ...]\n";
+}
+
+int main(int argc, char **argv) {
+    GimbalIdOptions   opt;
+    GimbalModelParams model;
+    std::string out_path = "config/gimbal_model.yaml";
+    std::vector<std::string> log_paths;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (i + 1 >= argc) { usage(argv[0]); std::exit(2); }
+            return argv[++i];
+        };
+        if      (a == "--max-dead-time") opt.max_dead_time = std::atof(next());
+        else if (a == "--iters")         opt.iters         = std::atoi(next());
+        else if (a == "--sim-dt")        opt.sim_dt        = std::atof(next());
+        else if (a == "--settle-tol")    model.settle_tol  = std::atof(next());
+        else if (a == "--out")           out_path          = next();
+        else if (a == "-h" || a == "--help") { usage(argv[0]); return 0; }
+        else if (!a.empty() && a[0] == '-')  { usage(argv[0]); return 2; }
+        else log_paths.push_back(a);
+    }
+    if (log_paths.empty() || opt.iters < 1 || !(opt.sim_dt > 0.0f)) { usage(argv[0]); return 2; }
+
+    // logs are concatenated with a gap in between, so each replays from rest
+    std::vector<GimbalLogRecord> log;
+    for (const std::string &p : log_paths) {
+        std::vector<GimbalLogRecord> one;
+        if (!gimbal_log_read(p, one)) {
+            std::cerr << "[GIMBAL] cannot read " << p << "\n";
+            return 1;
+        }
+        const double shift = log.empty() || one.empty() ? 0.0
+                           : log.back().t + 2.0 * opt.max_gap - one.front().t;
+        for (GimbalLogRecord &r : one) r.t += shift;
+        log.insert(log.end(), one.begin(), one.end());
+    }
+    std::printf("[GIMBAL] %zu records from %zu log(s)\n", log.size(), log_paths.size());
+    if (log.size() < 100) {
+        std::cerr << "[GIMBAL] not enough data\n";
+        return 1;
+    }
+
+    const char *names[2] = {"yaw", "pitch"};
+    GimbalAxisParams *axes[2] = {&model.yaw, &model.pitch};
+    std::ostringstream header;
+    header << "gimbal_identify over";
+    for (const std::string &p : log_paths) header << " " << p;
+    header << "\n";
+
+    for (int a = 0; a < 2; ++a) {
+        const auto t0 = std::chrono::steady_clock::now();
+        const GimbalFit fit = gimbal_identify_axis(log, a, opt);
+        const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        const double base = gimbal_replay_rmse(log, a, GimbalAxisParams(), opt);
+
+        *axes[a] = fit.params;
+        std::printf("[GIMBAL] %-5s wn %.2f rad/s  zeta %.3f  dead %.1f ms  rate %.2f rad/s"
+                    "  rmse %.2e rad (defaults %.2e)  %.1f s\n",
+                    names[a], fit.params.wn, fit.params.zeta, 1e3 * fit.params.dead_time,
+                    fit.params.rate_limit, fit.rmse, base, s);
+        header << names[a] << " rmse " << fit.rmse << " rad over " << fit.samples << " samples\n";
+    }
+
+    // what the predictor will see
+    const GimbalModel m(model);
+    std::printf("[GIMBAL] actuation delay by step:");
+    for (float step : {0.0f, 0.02f, 0.05f, 0.1f, 0.2f, 0.5f, 1.0f})
+        std::printf("  %.2f rad %.0f/%.0f ms", step, 1e3f * m.yaw().delay(step),
+                    1e3f * m.pitch().delay(step));
+    std::printf("  (yaw/pitch)\n");
+
+    if (!gimbal_params_save(out_path, model, header.str())) {
+        std::cerr << "[GIMBAL] cannot write " << out_path << "\n";
+        return 1;
+    }
+    std::printf("[GIMBAL] wrote %s\n", out_path.c_str());
+    return 0;
+}
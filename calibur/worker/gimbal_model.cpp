@@ -0,0 +1,123 @@
+// gimbal_model.cpp
+#include "gimbal_model.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <yaml-cpp/yaml.h>
+
+// ===================== Step response =====================
+
+GimbalStepResponse gimbal_step_response(const GimbalAxisParams &p, float step,
+                                        const GimbalModelParams &grid) {
+    const float target = std::fabs(step);
+    const float dt     = grid.sim_dt;
+    const int   steps  = int(std::ceil(grid.t_max / dt));
+
+    float theta = 0.0f, omega = 0.0f;
+    float last_out = target > grid.settle_tol ? 0.0f : -1.0f;   // last time outside the band
+    float peak = 0.0f;
+    for (int i = 1; i <= steps; ++i) {
+        gimbal_axis_step(p, target, dt, theta, omega);
+        peak = std::max(peak, theta);
+        if (std::fabs(theta - target) > grid.settle_tol) last_out = float(i) * dt;
+    }
+
+    GimbalStepResponse r;
+    r.settle    = p.dead_time + std::max(last_out, 0.0f);
+    r.overshoot = std::max(peak - target, 0.0f);
+    return r;
+}
+
+// ===================== GimbalAxisModel =====================
+
+GimbalAxisModel::GimbalAxisModel(const GimbalAxisParams &p, const GimbalModelParams &grid)
+    : p_(p)
+{
+    const int n = std::max(grid.table_size, 2);
+    const float lo = grid.settle_tol * (1.0f + 1e-4f);   // first step outside the band
+    const float dstep = std::max(grid.max_step - lo, 1e-6f) / float(n - 1);
+    step0_    = lo;
+    inv_step_ = 1.0f / dstep;
+
+    settle_.resize(n + 1);
+    overshoot_.resize(n + 1);
+    settle_[0]    = gimbal_step_response(p, 0.0f, grid).settle;
+    overshoot_[0] = 0.0f;
+    for (int i = 1; i <= n; ++i) {
+        const GimbalStepResponse r = gimbal_step_response(p, lo + float(i - 1) * dstep, grid);
+        settle_[i]    = r.settle;
+        overshoot_[i] = r.overshoot;
+    }
+
+    lag_rate_  = 2.0f * p.zeta / p.wn;
+    lag_accel_ = 1.0f / (p.wn * p.wn);
+}
+
+GimbalModel::GimbalModel(const GimbalModelParams &p)
+    : p_(p), yaw_(p.yaw, p), pitch_(p.pitch, p) {}
+
+// ===================== YAML =====================
+
+namespace {
+
+bool axis_from_yaml(const YAML::Node &n, GimbalAxisParams &a) {
+    if (!n) return true;
+    if (!n.IsMap()) return false;
+    if (n["wn"])         a.wn         = n["wn"].as<float>();
+    if (n["zeta"])       a.zeta       = n["zeta"].as<float>();
+    if (n["dead_time"])  a.dead_time  = n["dead_time"].as<float>();
+    if (n["rate_limit"]) a.rate_limit = n["rate_limit"].as<float>();
+    return a.wn > 0.0f && a.zeta > 0.0f && a.dead_time >= 0.0f && a.rate_limit > 0.0f;
+}
+
+YAML::Node axis_to_yaml(const GimbalAxisParams &a) {
+    YAML::Node n;
+    n.SetStyle(YAML::EmitterStyle::Flow);
+    n["wn"]         = a.wn;
+    n["zeta"]       = a.zeta;
+    n["dead_time"]  = a.dead_time;
+    n["rate_limit"] = a.rate_limit;
+    return n;
+}
+
+} // namespace
+
+bool gimbal_params_load(const std::string &path, GimbalModelParams &p) {
+    GimbalModelParams out = p;
+    try {
+        const YAML::Node g = YAML::LoadFile(path)["gimbal"];
+        if (!g || !g.IsMap()) {
+            std::cerr << "[GIMBAL] " << path << ": no 'gimbal' map\n";
+            return false;
+        }
+        if (!axis_from_yaml(g["yaw"], out.yaw) || !axis_from_yaml(g["pitch"], out.pitch)) {
+            std::cerr << "[GIMBAL] " << path << ": bad axis parameters\n";
+            return false;
+        }
+        if (g["settle_tol"]) out.settle_tol = g["settle_tol"].as<float>();
+    } catch (const YAML::Exception &e) {
+        std::cerr << "[GIMBAL] " << path << ": " << e.what() << "\n";
+        return false;
+    }
+    p = out;
+    return true;
+}
+
+bool gimbal_params_save(const std::string &path, const GimbalModelParams &p,
+                        const std::string &header) {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    std::istringstream lines(header);
+    for (std::string line; std::getline(lines, line);) out << "# " << line << "\n";
+
+    YAML::Node root;
+    root["gimbal"]["yaw"]        = axis_to_yaml(p.yaw);
+    root["gimbal"]["pitch"]      = axis_to_yaml(p.pitch);
+    root["gimbal"]["settle_tol"] = p.settle_tol;
+    out << root << "\n";
+    return bool(out);
+}
@@ -0,0 +1,134 @@
+// gimbal_model.hpp
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Gimbal response model, per axis a rate-limited second-order system behind
+// a transport delay:
+//
+//   theta'' = wn^2 (u(t - dead_time) - theta) - 2 zeta wn theta',  |theta'| <= rate_limit
+//
+// The rate limit is what makes the response depend on the step size: small
+// corrections settle in ~4 / (zeta wn), large retargets slew at rate_limit.
+// Parameters are identified offline from logged command / IMU pairs
+// (gimbal_id.hpp, gimbal_identify tool) and loaded from YAML.
+//
+// GimbalAxisModel tabulates the step response once (time until the axis
+// stays within settle_tol of the target, and the overshoot) over step sizes,
+// so PredictionWorker gets the actuation delay of the current retarget from
+// a linear lookup, and the feed-forward that cancels the tracking lag of a
+// moving setpoint in closed form.
+
+struct GimbalAxisParams {
+    float wn         = 30.0f;    // rad/s, natural frequency
+    float zeta       = 0.7f;     // damping ratio
+    float dead_time  = 0.008f;   // s, command to first motion
+    float rate_limit = 12.0f;    // rad/s, slew limit
+};
+
+struct GimbalModelParams {
+    GimbalAxisParams yaw;
+    GimbalAxisParams pitch;
+
+    // step-response table
+    float settle_tol = 0.005f;   // rad, "on target": ~half a small plate at 7 m
+    float max_step   = 1.2f;     // rad, largest step tabulated (larger: clamped)
+    int   table_size = 128;
+    float sim_dt     = 2.5e-4f;  // s
+    float t_max      = 2.0f;     // s, longest response simulated
+};
+
+// One integration step of the plant for input u (already delayed).
+// Semi-implicit Euler; stable for dt * wn < ~1.
+inline void gimbal_axis_step(const GimbalAxisParams &p, float u, float dt,
+                             float &theta, float &omega) {
+    const float acc = p.wn * p.wn * (u - theta) - 2.0f * p.zeta * p.wn * omega;
+    omega += acc * dt;
+    omega  = omega > p.rate_limit ? p.rate_limit : (omega < -p.rate_limit ? -p.rate_limit : omega);
+    theta += omega * dt;
+}
+
+struct GimbalStepResponse {
+    float settle;      // s, including dead time
+    float overshoot;   // rad, past the target
+};
+
+// Direct simulation of a step of `step` rad from rest (reference for the table).
+GimbalStepResponse gimbal_step_response(const GimbalAxisParams &p, float step,
+                                        const GimbalModelParams &grid);
+
+class GimbalAxisModel {
+public:
+    GimbalAxisModel(const GimbalAxisParams &p, const GimbalModelParams &grid);
+
+    // Actuation delay / overshoot for a step of |step| rad; steps within
+    // settle_tol cost the dead time only.
+    float delay(float step) const     { return lookup(step, settle_); }
+    float overshoot(float step) const { return lookup(step, overshoot_); }
+
+    // Setpoint offset that cancels the steady tracking lag of a setpoint
+    // moving at rate (rad/s) and accel (rad/s^2): the inverse of the linear
+    // part of the plant. The dead time is not in it, it is covered by
+    // leading the target by delay().
+    float feed_forward(float rate, float accel = 0.0f) const {
+        return lag_rate_ * rate + lag_accel_ * accel;
+    }
+
+    const GimbalAxisParams &params() const { return p_; }
+
+private:
+    // Entry 0 covers steps inside the band; entries 1.. run from the band
+    // edge (step0_) to max_step. No interpolation across the edge, the
+    // delay jumps there.
+    float lookup(float step, const std::vector<float> &t) const {
+        const float s = step < 0.0f ? -step : step;
+        if (!(s >= step0_)) return t[0];
+        const float last = float(t.size() - 1);
+        float f = 1.0f + (s - step0_) * inv_step_;
+        f = f < last ? f : last;
+        const int   i = int(f) < int(t.size()) - 1 ? int(f) : int(t.size()) - 2;
+        const float a = f - float(i);
+        return t[i] + a * (t[i + 1] - t[i]);
+    }
+
+    GimbalAxisParams   p_;
+    float              step0_, inv_step_;
+    float              lag_rate_, lag_accel_;
+    std::vector<float> settle_;      // [table_size + 1]: in-band, then uniform in step
+    std::vector<float> overshoot_;
+};
+
+class GimbalModel {
+public:
+    explicit GimbalModel(const GimbalModelParams &p = GimbalModelParams());
+
+    // Time until both axes are on a target dyaw / dpitch away.
+    float actuation_delay(float dyaw, float dpitch) const {
+        const float ty = yaw_.delay(dyaw);
+        const float tp = pitch_.delay(dpitch);
+        return ty > tp ? ty : tp;
+    }
+
+    const GimbalAxisModel   &yaw()    const { return yaw_; }
+    const GimbalAxisModel   &pitch()  const { return pitch_; }
+    const GimbalModelParams &params() const { return p_; }
+
+private:
+    GimbalModelParams p_;
+    GimbalAxisModel   yaw_;
+    GimbalAxisModel   pitch_;
+};
+
+// YAML, one top-level `gimbal:` map:
+//
+//   gimbal:
+//     yaw:   {wn: 30, zeta: 0.7, dead_time: 0.008, rate_limit: 12}
+//     pitch: {wn: 40, zeta: 0.8, dead_time: 0.006, rate_limit: 8}
+//     settle_tol: 0.005
+//
+// Missing keys keep the value already in `p`. load returns false (p
+// untouched) if the file is missing or malformed.
+bool gimbal_params_load(const std::string &path, GimbalModelParams &p);
+bool gimbal_params_save(const std::string &path, const GimbalModelParams &p,
+                        const std::string &header = "");
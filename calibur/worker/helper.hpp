@@ -1,6 +1,8 @@
 #ifndef HELPER_HPP
 #define HELPER_HPP
 
+#include <cstdlib>
+#include <string>
 #include <vector>
 #include <Eigen/Dense>
 #include "types.hpp"
@@ -33,31 +35,33 @@ inline float deg2rad(float deg) {
     return deg * (PI / 180.0f);
 }
 
+// Serial device from the environment if set (e.g. a serial_sim pty),
+// else the compiled-in path.
+inline std::string serial_device(const char *env, const char *fallback) {
+    const char *v = std::getenv(env);
+    return (v && *v) ? std::string(v) : std::string(fallback);
+}
+
 inline bool get_imu_yaw_pitch(const SharedLatest &shared,
                               float &yaw_cam_world,
                               float &pitch_cam_world) {
-    std::shared_ptr<IMUState> imu_ptr = std::atomic_load(&shared.imu);
-    if (!imu_ptr) {
-        return false;
-    }
-
-    const IMUState &imu = *imu_ptr;
-
-    if (imu.euler_angle.size() < 3) {
+    ImuSample s;
+    if (!shared.imu_history.latest(s)) {
         return false;
     }
-    // euler_angle = {roll, pitch, yaw} in *world frame*
-    // float roll_deg  = imu.euler_angle[0];
-    float pitch_deg = imu.euler_angle[1];
-    float yaw_deg   = imu.euler_angle[2];
-
-
-    pitch_cam_world = deg2rad(pitch_deg);
-    yaw_cam_world   = deg2rad(yaw_deg);
-
+    imu_yaw_pitch(s, yaw_cam_world, pitch_cam_world);
     return true;
 }
 
+// Attitude at time t (e.g. frame capture), interpolated from the IMU
+// history; the latest sample if t is outside it.
+inline bool get_imu_yaw_pitch_at(const SharedLatest &shared,
+                                 TimePoint t,
+                                 float &yaw_cam_world,
+                                 float &pitch_cam_world) {
+    return imu_yaw_pitch_at(shared.imu_history, t, yaw_cam_world, pitch_cam_world);
+}
+
 inline Eigen::Matrix3f make_R_cam2world_from_yaw_pitch(float yaw_cam_world,
                                                         float pitch_cam_world)
 {
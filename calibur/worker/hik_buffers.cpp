@@ -0,0 +1,79 @@
+// calibur/worker/hik_buffers.cpp
+#include "hik_buffers.hpp"
+
+#include <algorithm>
+
+HikBufferPool::HikBufferPool(void *handle, const HikSdk &sdk, const HikBufferParams &p)
+    : p_(p), st_(std::make_shared<State>())
+{
+    p_.buffers = std::clamp(p_.buffers, 1u, 30u);
+    if (p_.max_leased == 0) p_.max_leased = p_.buffers > 2 ? p_.buffers - 2 : 1;
+    p_.max_leased = std::min(p_.max_leased, p_.buffers);
+    st_->handle = handle;
+    st_->sdk    = sdk;
+}
+
+int HikBufferPool::configure() {
+    return st_->sdk.set_image_node_num(st_->handle, p_.buffers);
+}
+
+void HikBufferPool::State::release(MV_FRAME_OUT *frame) {
+    {
+        // under the lock so a drain() that gives up cannot race a free
+        // into MV_CC_StopGrabbing
+        std::lock_guard<std::mutex> lk(mtx);
+        if (!closed.load(std::memory_order_relaxed) && sdk.free_image_buffer(handle, frame) != MV_OK) {
+            free_errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        outstanding.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    released.notify_all();
+    delete frame;
+}
+
+int HikBufferPool::grab(unsigned int timeout_ms, HikBuffer &out) {
+    auto *frame = new MV_FRAME_OUT();
+    const int ret = st_->sdk.get_image_buffer(st_->handle, frame, timeout_ms);
+    if (ret != MV_OK || frame->pBufAddr == nullptr) {
+        delete frame;
+        const unsigned int code = static_cast<unsigned int>(ret);
+        if (code == MV_E_NODATA || code == MV_E_GC_TIMEOUT) ++timeouts_;
+        else ++get_errors_;
+        return ret != MV_OK ? ret : int(MV_E_NODATA);
+    }
+    ++grabbed_;
+
+    // the lease keeps the state alive, so a frame may outlive the pool
+    const int held = st_->outstanding.fetch_add(1, std::memory_order_acq_rel) + 1;
+    std::shared_ptr<State> st = st_;
+    out.data      = frame->pBufAddr;
+    out.info      = frame->stFrameInfo;
+    out.lease     = std::shared_ptr<void>(frame, [st](void *f) { st->release(static_cast<MV_FRAME_OUT *>(f)); });
+    out.must_copy = held > int(p_.max_leased);
+    if (out.must_copy) ++copied_;
+    return MV_OK;
+}
+
+bool HikBufferPool::wait_idle(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lk(st_->mtx);
+    return st_->released.wait_for(lk, timeout, [this] {
+        return st_->outstanding.load(std::memory_order_acquire) == 0;
+    });
+}
+
+bool HikBufferPool::drain(std::chrono::milliseconds timeout) {
+    const bool done = wait_idle(timeout);
+    std::lock_guard<std::mutex> lk(st_->mtx);
+    st_->closed.store(true, std::memory_order_release);
+    return done;
+}
+
+HikBufferStats HikBufferPool::stats() const {
+    HikBufferStats s;
+    s.grabbed     = grabbed_;
+    s.copied      = copied_;
+    s.timeouts    = timeouts_;
+    s.errors      = get_errors_ + st_->free_errors.load(std::memory_order_relaxed);
+    s.outstanding = st_->outstanding.load(std::memory_order_relaxed);
+    return s;
+}
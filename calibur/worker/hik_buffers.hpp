@@ -0,0 +1,104 @@
+// calibur/worker/hik_buffers.hpp
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "../camera/MvCameraControl.h"
+
+// Zero-copy Hik acquisition: frames stay in the SDK's own image buffers
+// (MV_CC_GetImageBuffer) and are handed out as leases, a shared_ptr whose
+// last release calls MV_CC_FreeImageBuffer from whichever thread drops it.
+// A frame published to SharedLatest therefore pins one SDK buffer until
+// every consumer has let go of it.
+//
+// The SDK owns MV_CC_SetImageNodeNum buffers. Leases beyond max_leased are
+// still handed out but flagged must_copy, so the caller copies (or
+// converts) and releases at once and the SDK always has buffers to fill.
+// All buffers must be back before MV_CC_StopGrabbing: drain() waits for
+// them and afterwards stray releases no longer touch the SDK.
+//
+// The SDK calls go through HikSdk so tests can run the pool on a mock.
+
+struct HikSdk {
+    int (*set_image_node_num)(void *handle, unsigned int num);
+    int (*get_image_buffer)(void *handle, MV_FRAME_OUT *frame, unsigned int timeout_ms);
+    int (*free_image_buffer)(void *handle, MV_FRAME_OUT *frame);
+};
+
+// The MVS SDK itself (only referenced, and linked, where it is used)
+inline HikSdk hik_sdk_mvs() {
+    return HikSdk{
+        [](void *h, unsigned int n) { return MV_CC_SetImageNodeNum(h, n); },
+        [](void *h, MV_FRAME_OUT *f, unsigned int ms) { return MV_CC_GetImageBuffer(h, f, ms); },
+        [](void *h, MV_FRAME_OUT *f) { return MV_CC_FreeImageBuffer(h, f); },
+    };
+}
+
+struct HikBufferParams {
+    unsigned int buffers    = 8;   // SDK image nodes, [1, 30]
+    unsigned int max_leased = 0;   // outstanding leases before must_copy; 0: buffers - 2
+};
+
+struct HikBufferStats {
+    uint64_t grabbed     = 0;
+    uint64_t copied      = 0;   // handed out with must_copy
+    uint64_t timeouts    = 0;
+    uint64_t errors      = 0;   // get / free failures
+    int      outstanding = 0;   // buffers held by leases right now
+};
+
+// One frame in an SDK buffer. `data` is valid while `lease` (or a copy of
+// it) is alive.
+struct HikBuffer {
+    const unsigned char   *data = nullptr;
+    MV_FRAME_OUT_INFO_EX   info{};
+    std::shared_ptr<void>  lease;
+    bool                   must_copy = false;
+};
+
+class HikBufferPool {
+public:
+    HikBufferPool(void *handle, const HikSdk &sdk, const HikBufferParams &p = HikBufferParams());
+
+    // Sets the SDK buffer count; call before MV_CC_StartGrabbing.
+    int configure();
+
+    // Next frame, waiting up to timeout_ms; the SDK's return code
+    // (MV_OK with out filled in).
+    int grab(unsigned int timeout_ms, HikBuffer &out);
+
+    // Waits until every lease is released, up to timeout; false if some
+    // are still out. The pool stays usable (a restart of acquisition).
+    bool wait_idle(std::chrono::milliseconds timeout);
+
+    // Waits until every lease is released, up to timeout; then (or on
+    // timeout) stops returning buffers to the SDK. Call before
+    // MV_CC_StopGrabbing. False if leases were still out.
+    bool drain(std::chrono::milliseconds timeout);
+
+    HikBufferStats stats() const;
+    const HikBufferParams &params() const { return p_; }
+
+private:
+    // shared with the leases, which may outlive the pool
+    struct State {
+        void                 *handle = nullptr;
+        HikSdk                sdk{};
+        std::atomic<int>      outstanding{0};
+        std::atomic<bool>     closed{false};
+        std::atomic<uint64_t> free_errors{0};
+        std::mutex              mtx;
+        std::condition_variable released;
+
+        void release(MV_FRAME_OUT *frame);
+    };
+
+    HikBufferParams        p_;
+    std::shared_ptr<State> st_;
+    uint64_t grabbed_ = 0, copied_ = 0, timeouts_ = 0, get_errors_ = 0;
+};
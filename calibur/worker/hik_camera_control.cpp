@@ -0,0 +1,81 @@
+// calibur/worker/hik_camera_control.cpp
+#include "hik_camera_control.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "../camera/MvCameraControl.h"
+
+static bool get_int(void *cam, const char *key, MVCC_INTVALUE &v) {
+    memset(&v, 0, sizeof(MVCC_INTVALUE));
+    return MV_CC_GetIntValue(cam, key, &v) == MV_OK;
+}
+
+HikCameraControl::HikCameraControl(void *handle)
+    : cam_(handle)
+{
+    if (!cam_) return;
+
+    MVCC_INTVALUE w, h, ox, oy;
+    if (!get_int(cam_, "Width", w) || !get_int(cam_, "Height", h) ||
+        !get_int(cam_, "OffsetX", ox) || !get_int(cam_, "OffsetY", oy)) {
+        std::cerr << "[CameraWorker] ROI nodes not readable, dynamic ROI off\n";
+        return;
+    }
+    // the frame configured at start-up (main) is the full frame, and its
+    // offset the origin of the window
+    base_x_     = int(ox.nCurValue);
+    base_y_     = int(oy.nCurValue);
+    lim_.width  = int(w.nCurValue);
+    lim_.height = int(h.nCurValue);
+    lim_.min_w  = std::max(int(w.nMin), 1);
+    lim_.min_h  = std::max(int(h.nMin), 1);
+    lim_.inc_w  = std::max(int(w.nInc), 1);
+    lim_.inc_h  = std::max(int(h.nInc), 1);
+    lim_.inc_x  = std::max(int(ox.nInc), 1);
+    lim_.inc_y  = std::max(int(oy.nInc), 1);
+    roi_   = SensorRoi{0, 0, lim_.width, lim_.height};
+    valid_ = true;
+}
+
+bool HikCameraControl::move_roi(int x, int y) {
+    if (!valid_) return false;
+    if (MV_CC_SetIntValue(cam_, "OffsetX", base_x_ + x) != MV_OK) return false;
+    if (MV_CC_SetIntValue(cam_, "OffsetY", base_y_ + y) != MV_OK) {
+        MV_CC_SetIntValue(cam_, "OffsetX", base_x_ + roi_.x);
+        return false;
+    }
+    roi_.x = x;
+    roi_.y = y;
+    return true;
+}
+
+// offsets cleared first so the new size fits whatever the old offset was
+bool HikCameraControl::write_window(const SensorRoi &r) {
+    return MV_CC_SetIntValue(cam_, "OffsetX", 0) == MV_OK &&
+           MV_CC_SetIntValue(cam_, "OffsetY", 0) == MV_OK &&
+           MV_CC_SetIntValue(cam_, "Width", r.w) == MV_OK &&
+           MV_CC_SetIntValue(cam_, "Height", r.h) == MV_OK &&
+           MV_CC_SetIntValue(cam_, "OffsetX", base_x_ + r.x) == MV_OK &&
+           MV_CC_SetIntValue(cam_, "OffsetY", base_y_ + r.y) == MV_OK;
+}
+
+bool HikCameraControl::resize_roi(const SensorRoi &r) {
+    if (!valid_) return false;
+    MV_CC_StopGrabbing(cam_);
+    bool ok = write_window(r);
+    if (ok) {
+        roi_ = r;
+    } else {
+        std::cerr << "[CameraWorker] ROI " << r.w << "x" << r.h << " at (" << r.x << ", " << r.y
+                  << ") refused, keeping " << roi_.w << "x" << roi_.h << "\n";
+        write_window(roi_);
+    }
+    const int nRet = MV_CC_StartGrabbing(cam_);
+    if (nRet != MV_OK) {
+        std::cerr << "[CameraWorker] MV_CC_StartGrabbing after ROI change failed: " << nRet << "\n";
+        return false;
+    }
+    return ok;
+}
@@ -0,0 +1,31 @@
+// calibur/worker/hik_camera_control.hpp
+#pragma once
+
+#include "camera_roi.hpp"
+
+// CameraControl over an open Hik camera: the window is the OffsetX /
+// OffsetY / Width / Height nodes. Offsets are written while grabbing;
+// Width and Height are locked then, so resize_roi() stops grabbing,
+// writes the nodes and starts again. The frame configured when this is
+// constructed is the full frame: window coordinates are relative to its
+// offset, and the increments come from the nodes.
+class HikCameraControl : public CameraControl {
+public:
+    explicit HikCameraControl(void *handle);
+
+    bool valid() const { return valid_; }
+
+    SensorLimits limits() const override { return lim_; }
+    SensorRoi    roi() const override { return roi_; }
+    bool move_roi(int x, int y) override;
+    bool resize_roi(const SensorRoi &roi) override;
+
+private:
+    bool write_window(const SensorRoi &roi);
+
+    void        *cam_;
+    bool         valid_ = false;
+    int          base_x_ = 0, base_y_ = 0;   // offset of the full frame on the sensor
+    SensorLimits lim_;
+    SensorRoi    roi_;
+};
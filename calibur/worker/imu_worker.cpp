@@ -4,93 +4,42 @@
 #include <iostream>
 
 #include "workers.hpp"
+#include "helper.hpp"
 
 IMUWorker::IMUWorker(SharedLatest &shared, std::atomic<bool> &stop_flag)
     : shared_(shared),
       stop_flag_(stop_flag),
-      reader_("/dev/ttyACM0", 460800, 0.2f)
+      reader_(serial_device("CALIBUR_IMU_DEVICE", IMU_DEVICE_PATH), 460800, 0.2f)
 {
+    // sample stamps from the IMU's own clock, mapped to host time
+    ImuClockParams cp;
+    cp.latency = IMU_SAMPLE_LATENCY;
+    reader_.set_clock_params(cp);
 }
 
 void IMUWorker::operator()() {
+    // the reader thread fills the history with every frame; consumers read
+    // the attitude there (latest() or at(t)), so nothing is republished
+    // here and this thread only reports the device clock fit
+    reader_.set_history(&shared_.imu_history);
     reader_.start();
 
-    size_t print_counter = 0;  // throttle printing
+    const auto report_every = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(IMU_CLOCK_REPORT_PERIOD));
+    TimePoint next_report = Clock::now() + report_every;
 
     while (!stop_flag_.load(std::memory_order_relaxed)) {
-        IMUData raw;
-        if (!reader_.get_latest(raw)) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            continue;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));   // stop latency only
+        const TimePoint now = Clock::now();
+        if (now < next_report) continue;
+        next_report = now + report_every;
+
+        const ImuClockEstimate e = reader_.clock_estimate();
+        if (e.valid) {
+            std::cout << "[IMU] clock: drift " << 1e6 * e.drift() << " ppm, jitter "
+                      << 1e6 * e.sigma << " us, " << e.rejected << "/" << e.used + e.rejected
+                      << " late, " << e.resets << " resets" << std::endl;
         }
-
-        IMUState st;
-
-        // euler_angle = [roll, pitch, yaw] in degrees
-        if (raw.has_euler) {
-            st.euler_angle.clear();
-            st.euler_angle.reserve(3);
-
-            float pitch = raw.euler_deg[0];
-            float roll  = raw.euler_deg[1];
-            float yaw   = raw.euler_deg[2];
-
-            st.euler_angle.push_back(roll);
-            st.euler_angle.push_back(pitch);
-            st.euler_angle.push_back(yaw);
-        }
-
-        // quaternion
-        if (raw.has_quat) {
-            st.quaternion.clear();
-            st.quaternion.reserve(4);
-            st.quaternion.push_back(raw.quat[0]);
-            st.quaternion.push_back(raw.quat[1]);
-            st.quaternion.push_back(raw.quat[2]);
-            st.quaternion.push_back(raw.quat[3]);
-        }
-
-        // time from IMU
-        if (raw.has_ts_sample) {
-            st.time = raw.ts_sample_us * 1e-6f;
-        } else {
-            st.time = 0.0f;
-        }
-
-        st.timestamp = Clock::now();
-
-        // write to shared memory
-        auto ptr = std::make_shared<IMUState>(st);
-        std::atomic_store(&shared_.imu, ptr);
-        shared_.imu_ver.fetch_add(1, std::memory_order_relaxed);
-
-        // if (++print_counter >= 10) {
-        //     print_counter = 0;
-
-        //     std::cout << "[IMU] ";
-
-        //     if (!st.euler_angle.empty()) {
-        //         std::cout << "Roll="  << st.euler_angle[0]
-        //                   << "  Pitch=" << st.euler_angle[1]
-        //                   << "  Yaw="   << st.euler_angle[2];
-        //     }
-
-        //     if (!st.quaternion.empty()) {
-        //         std::cout << "  |  Q=("
-        //                   << st.quaternion[0] << ", "
-        //                   << st.quaternion[1] << ", "
-        //                   << st.quaternion[2] << ", "
-        //                   << st.quaternion[3] << ")";
-        //     }
-
-        //     if (raw.has_temp) {
-        //         std::cout << "  |  Temp=" << raw.temp_c << "°C";
-        //     }
-
-        //     std::cout << std::endl;
-        // }
-
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
 
     reader_.stop();
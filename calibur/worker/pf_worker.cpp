@@ -2,6 +2,9 @@
 #include <thread>
 #include "workers.hpp"
 #include "rbpf.cuh"
+#include "ekf.hpp"
+#include "rbpf_params_yaml.hpp"
+#include "detection_log.hpp"
 
 #include <rerun.hpp> // [RERUN CHANGE]
 #include <deque> //[RERUN CHANGE]
@@ -12,41 +15,99 @@
 using timestamp_clock_t= std::chrono::steady_clock;
 
 PFWorker::PFWorker(SharedLatest &shared,
-                   std::atomic<bool> &stop_flag)
+                   std::atomic<bool> &stop_flag,
+                   TrackerKind kind)
     : shared_(shared),
       stop_(stop_flag),
       last_det_ver_(0),
-      g_pf(nullptr),
-      frames_without_detection_(0) 
+      kind_(kind),
+      tracker_(nullptr),
+      oosm_(oosm_num_checkpoints(PF_OOSM_BUDGET_BYTES, NUM_PARTICLES))
 {
 }
 
-void PFWorker::gpu_pf_init() {
-    if (!g_pf) {
-        g_pf.reset(rbpf_create(NUM_PARTICLES));
-        RobotState init{};
-        // Initialize to zero/invalid state
-        for (int i = 0; i < ROBOT_STATE_VEC_LEN; i++) {
-            init.state[i] = 0.0f;
+void PFWorker::tracker_init() {
+    if (tracker_) return;
+
+    if (kind_ == TrackerKind::EKF) {
+        tracker_.reset(new EKFTracker(oosm_.capacity()));
+    } else {
+        RBPFParams params = default_params();
+        if (rbpf_params_load(PF_PARAMS_YAML, params)) {
+            std::cout << "[PF] params from " << PF_PARAMS_YAML << std::endl;
+        } else {
+            std::cout << "[PF] " << PF_PARAMS_YAML << " not loaded, using defaults" << std::endl;
         }
-        rbpf_reset_from_meas(g_pf.get(), init);
+        auto *rbpf = new RBPFTrackerGPU(NUM_PARTICLES, oosm_.capacity(), params);
+#ifdef PF_ADAPTIVE_PARTICLES
+        KLDParams kp;
+        kp.min_particles = PF_MIN_PARTICLES;
+        kp.max_particles = NUM_PARTICLES;
+        kp.epsilon       = PF_KLD_EPSILON;
+        kp.bin_pos       = PF_KLD_BIN_POS;
+        kp.bin_yaw       = PF_KLD_BIN_YAW;
+        kp.bin_vel       = PF_KLD_BIN_VEL;
+        rbpf_enable_kld(rbpf->model(), kp);
+#endif
+        tracker_.reset(rbpf);
     }
+
+    // Initialize to zero/invalid state
+    float init[ROBOT_STATE_VEC_LEN] = {};
+    tracker_->reset(init);
+    std::cout << "[PF] tracker: " << tracker_->name() << std::endl;
 }
 
-void PFWorker::gpu_pf_reset(const RobotState &meas) {
-    rbpf_reset_from_meas(g_pf.get(), meas);
+static inline double to_seconds(TimePoint t) {
+    return std::chrono::duration<double>(t.time_since_epoch()).count();
 }
 
-void PFWorker::gpu_pf_predict_only() {
-    rbpf_predict(g_pf.get(), kDt);
+void PFWorker::tracker_reset(const RobotState &meas) {
+    tracker_->reset(meas.state.data());
+    oosm_start(oosm_, *tracker_, to_seconds(meas.timestamp), meas.state.data());
+}
+
+// Fuse at the capture time; a late detection rolls back and replays.
+// Returns false if it is older than the checkpoint history.
+bool PFWorker::tracker_step(const RobotState &meas) {
+    const int steps = oosm_fuse(oosm_, *tracker_, to_seconds(meas.timestamp),
+                                meas.state.data(), kMinDt);
+    if (steps > 1) {
+        std::cout << "[PF] late detection, replayed " << steps << " steps\n";
+    }
+    return steps > 0;
+}
+
+// Request the estimate and wait for its readback by polling (on the GPU an
+// event, never the stream). Gives up at `deadline` (the next tick); the late
+// result is then dropped and superseded by the next request.
+bool PFWorker::tracker_result(RobotState &out, TimePoint deadline){
+    PosteriorSummary sm;
+    tracker_->request_estimate();
+    while (!tracker_->poll_estimate(sm)) {
+        if (timestamp_clock_t::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    out = RobotState{};
+    for (int i = 0; i < ROBOT_STATE_VEC_LEN; ++i) {
+        out.state[i] = sm.mean[i];
+        out.var[i]   = sm.var[i];
+    }
+    return true;
 }
 
-void PFWorker::gpu_pf_step(const RobotState &meas) {
-    rbpf_step(g_pf.get(), meas, kDt);
+RBPFTelemetry PFWorker::tracker_telemetry(){
+    return tracker_->telemetry();
 }
 
-RobotState PFWorker::gpu_return_result(){
-    return rbpf_get_mean(g_pf.get());
+// Analytic constant-acceleration extrapolation of the last posterior mean;
+// no particle work, no GPU round trip.
+RobotState PFWorker::predict_to(TimePoint t) const {
+    RobotState out = posterior_;
+    const float dt = std::chrono::duration<float>(t - filter_time_).count();
+    rbpf_extrapolate_state(posterior_.state.data(), dt, out.state.data());
+    out.timestamp = t;
+    return out;
 }
 
 bool PFWorker::is_state_valid(const RobotState &state) {
@@ -196,11 +257,8 @@ static void push_track_and_log(
 
 
 void PFWorker::operator()() {
-    gpu_pf_init();
+    tracker_init();
 
-    auto next_tick = timestamp_clock_t::now();
-    
-    constexpr int MAX_FRAMES_WITHOUT_DETECTION = 30;  // ~0.3 seconds at 100Hz
     bool pf_initialized = false;
     
     // [RERUN] ---- create a recording stream once (per process) ----
@@ -225,27 +283,40 @@ void PFWorker::operator()() {
     // [RERUN] ------------------------------------------------------
 
 
+#ifdef PF_RECORD_DETECTIONS
+    static DetectionLogWriter det_log;
+    if (!det_log.is_open() && !det_log.open(PF_RECORD_DETECTIONS)) {
+        std::cerr << "[PF] cannot record detections to " << PF_RECORD_DETECTIONS << "\n";
+    }
+#endif
+
+    auto next_out = timestamp_clock_t::now() + kOutputPeriod;
+
     while (!stop_.load(std::memory_order_acquire)) {
-        next_tick += std::chrono::milliseconds(10);
-        std::this_thread::sleep_until(next_tick);
-        
+        // wake on a new detection, or at the output period to republish
+        const bool woke = shared_.detection_signal.wait_for_change(
+            shared_.detection_ver, last_det_ver_, next_out);
+
         // [RERUN] set time for this thread’s subsequent logs
         rec.set_time_sequence("tick", tick++);  // per-thread timeline :contentReference[oaicite:2]{index=2}
         // [RERUN] --------------------------------------------
 
         bool       has_meas = false;
         RobotState meas;
-        
-        uint64_t det_ver = shared_.detection_ver.load(std::memory_order_acquire);
-        if (det_ver != last_det_ver_) {
-            auto det_ptr = shared_.detection_out;
+
+        if (woke) {
+            const uint64_t det_ver = shared_.detection_ver.load(std::memory_order_acquire);
+            auto det_ptr = std::atomic_load(&shared_.detection_out);
+            last_det_ver_ = det_ver;
             if (det_ptr) {
-                meas          = *det_ptr;
-                last_det_ver_ = det_ver;
-                has_meas      = true;
+                meas     = *det_ptr;
+                has_meas = true;
             }
         }
 
+        const auto now = timestamp_clock_t::now();
+        if (!has_meas) next_out = now + kOutputPeriod;
+
         RobotState pf_state;
         
         if (has_meas) {
@@ -253,13 +324,6 @@ void PFWorker::operator()() {
             // Got new detection (already in WORLD frame)
             // ============================================================
             
-            // std::cout << "[PF] got meas (WORLD frame): "
-            //           << "x=" << meas.state[IDX_TX]
-            //           << " y=" << meas.state[IDX_TY]
-            //           << " z=" << meas.state[IDX_TZ]
-            //           << " yaw=" << meas.state[IDX_YAW]
-            //           << std::endl;
-            
             // Validate detection
             if (!is_state_valid(meas)) {
                 std::cout << "[PF WARNING] Invalid detection received, skipping\n";
@@ -267,6 +331,10 @@ void PFWorker::operator()() {
                 continue;
             }
 
+#ifdef PF_RECORD_DETECTIONS
+            if (det_log.is_open()) det_log.append(to_seconds(meas.timestamp), meas.state.data());
+#endif
+
             // [RERUN CHANGE] robot glyph + measurement track
             log_robot_glyph(rec, "world/meas_robot", meas, rerun::Color(0, 255, 0));
 
@@ -278,48 +346,51 @@ void PFWorker::operator()() {
                 rerun::Color(0, 255, 0),
                 MAX_TRACK_LEN
             );
-            
-            // If not initialized or diverged, initialize/reset from measurement
-            if (!pf_initialized) {
-                std::cout << "[PF] Initializing from first detection\n";
-                gpu_pf_reset(meas);
+
+            // dt between the measurement and the filter, from the capture
+            // timestamps; a long gap means the track was lost, start over
+            const float dt = std::chrono::duration<float>(meas.timestamp - filter_time_).count();
+
+            if (!pf_initialized || dt > kMaxCoast) {
+                std::cout << "[PF] Initializing from detection\n";
+                tracker_reset(meas);
                 pf_initialized = true;
+                filter_time_   = meas.timestamp;
             } else {
-                // Normal update
-                gpu_pf_step(meas);
+                if (!tracker_step(meas)) {
+                    std::cout << "[PF WARNING] Detection older than PF history, dropped\n";
+                    continue;
+                }
+                if (dt > 0.0f) filter_time_ = meas.timestamp;
             }
-            
-            frames_without_detection_ = 0;  // Reset counter
-            
+
+            if (!tracker_result(pf_state, now + kOutputPeriod)) {
+                continue;  // GPU still busy, publish on the next wake-up
+            }
+            pf_state.timestamp = filter_time_;
+            posterior_         = pf_state;
+            have_posterior_    = true;
+            next_out           = now + kOutputPeriod;
+
         } else {
             // ============================================================
-            // No new detection - just predict
+            // No new detection - extrapolate the last posterior to now
             // ============================================================
-            
-            frames_without_detection_++;
-            
-            if (!pf_initialized) {
-                // Don't predict if never initialized
-                continue;
+
+            if (!pf_initialized || !have_posterior_) {
+                continue;  // Don't output until initialized
             }
-            
-            if (frames_without_detection_ > MAX_FRAMES_WITHOUT_DETECTION) {
-                std::cout << "[PF WARNING] No detection for " << frames_without_detection_ 
-                          << " frames, PF may diverge. Waiting for new detection...\n";
-                // Don't predict anymore - wait for new detection to reset
+
+            const float coast = std::chrono::duration<float>(now - filter_time_).count();
+            if (coast > kMaxCoast) {
+                std::cout << "[PF WARNING] No detection for " << coast
+                          << " s, PF may diverge. Waiting for new detection...\n";
                 continue;
             }
-            
-            // Predict
-            gpu_pf_predict_only();
-        }
-        
-        if (!pf_initialized) {
-            continue;  // Don't output until initialized
+
+            pf_state = predict_to(now);
         }
-        
-        pf_state = gpu_return_result();
-        
+
         // ============ VALIDATE PF OUTPUT ============
         if (!is_state_valid(pf_state)) {
             std::cout << "[PF ERROR] PF output invalid/diverged! "
@@ -329,8 +400,8 @@ void PFWorker::operator()() {
 
 
             // Force re-initialization on next detection
-            pf_initialized = false;
-            frames_without_detection_ = MAX_FRAMES_WITHOUT_DETECTION + 1;
+            pf_initialized  = false;
+            have_posterior_ = false;
             continue;
         }
         
@@ -347,13 +418,20 @@ void PFWorker::operator()() {
         );
         // [RERUN] --------------------------------------------
 
+        // [RERUN] filter health
+        const RBPFTelemetry tm = tracker_telemetry();
+        rec.log("pf/num_particles", rerun::Scalars(double(tm.num_particles)));
+        rec.log("pf/ess",           rerun::Scalars(double(tm.ess)));
+
         std::cout << "[PF ] x=" << pf_state.state[IDX_TX]
                   << " y=" << pf_state.state[IDX_TY]
                   << " z=" << pf_state.state[IDX_TZ]
                   << " yaw=" << pf_state.state[IDX_YAW]
                   << " h= " << pf_state.state[IDX_H]
                   << " r1= " << pf_state.state[IDX_R1]
-                  << " r2= " << pf_state.state[IDX_R2] << std::endl;
+                  << " r2= " << pf_state.state[IDX_R2]
+                  << " N= " << tm.num_particles
+                  << " ESS= " << tm.ess << std::endl;
 
 
         shared_.pf_out = std::make_shared<RobotState>(pf_state);
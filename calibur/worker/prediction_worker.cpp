@@ -14,7 +14,8 @@
 
 inline void  filtering(float &value, float measurement, float alpha);
 inline bool  is_converged(float v, float threshold);
-inline float t_lead_calculation(const Eigen::Vector3f &tvec, const float &bullet_speed);
+inline float t_lead_calculation(const Eigen::Vector3f &tvec, const float &bullet_speed,
+                                const BallisticSolver &ballistic);
 inline int   sector_from_yaw(const float yaw);
 inline void  calculate_robot_final_target_point(Eigen::Vector3f &final_pos, float &final_yaw,
                                                 const float height_offset, const float r1, const float r2);
@@ -22,11 +23,40 @@ inline void  motion_model_robot_pos(const std::array<float, ROBOT_STATE_VEC_LEN>
                                     Eigen::Vector3f &robot_center_lead,
                                     float &yaw_lead, const float &t);
 inline void  calculate_gimbal_correction(const Eigen::Vector3f &tvec, Eigen::Vector2f &correction);
+inline void  calculate_gimbal_rate(const Eigen::Vector3f &tvec, const Eigen::Vector3f &vel,
+                                   Eigen::Vector2f &rate);
 inline int   should_fire(const Eigen::Vector2f &angular_error); 
 
 
 // ===================== PredictionWorker ============================
 
+static BallisticParams ballistic_params() {
+    BallisticParams p;
+    p.drag_k = BALLISTIC_DRAG_K;
+    p.d_max  = BALLISTIC_MAX_DISTANCE;
+    p.h_min  = -BALLISTIC_MAX_HEIGHT;
+    p.h_max  = BALLISTIC_MAX_HEIGHT;
+    return p;
+}
+
+static FireControlParams fire_control_params() {
+    FireControlParams p;
+    p.samples      = FIRE_SAMPLES;
+    p.gun_sigma    = FIRE_GUN_SIGMA;
+    p.min_hit_prob = FIRE_MIN_HIT_PROB;
+    return p;
+}
+
+static GimbalModelParams gimbal_model_params() {
+    GimbalModelParams p;
+    if (gimbal_params_load(GIMBAL_MODEL_YAML, p)) {
+        std::cout << "[PRED] gimbal model from " << GIMBAL_MODEL_YAML << std::endl;
+    } else {
+        std::cout << "[PRED] " << GIMBAL_MODEL_YAML << " not loaded, default gimbal model" << std::endl;
+    }
+    return p;
+}
+
 PredictionWorker::PredictionWorker(SharedLatest &shared,
                                    SharedScalars &scalars,
                                    std::atomic<bool> &stop_flag)
@@ -42,7 +72,11 @@ PredictionWorker::PredictionWorker(SharedLatest &shared,
       aim_state(false),
       vis_yaw_(0.0f),
       vis_pitch_(0.0f),
-      vis_init_(false)
+      vis_init_(false),
+      vis_time_(),
+      ballistic_(ballistic_params(), 15.0f, BALLISTIC_SPEED_QUANTUM),
+      fire_control_(fire_control_params()),
+      gimbal_(gimbal_model_params())
 {}
 
 void PredictionWorker::operator()() {
@@ -54,9 +88,10 @@ void PredictionWorker::operator()() {
         }
         last_pf_ver_ = cur_ver;
 
-        auto pf  = std::atomic_load(&shared_.pf_out);
-        auto imu = std::atomic_load(&shared_.imu);
-        if (!pf || !imu) {
+        // the attitude comes from shared_.imu_history inside; without it
+        // compute_prediction sends a zero command
+        auto pf = std::atomic_load(&shared_.pf_out);
+        if (!pf) {
             continue;
         }
         float init_yaw = std::atomic_load(&scalars_.initial_yaw);
@@ -64,7 +99,7 @@ void PredictionWorker::operator()() {
         float measured_speed = scalars_.bullet_speed.load(std::memory_order_relaxed);
 
         PredictionOut out{};
-        compute_prediction(*pf, imu.get(), measured_speed, init_yaw, out);
+        compute_prediction(*pf, measured_speed, init_yaw, out);
 
         auto ptr = std::make_shared<PredictionOut>(out);
         std::atomic_store(&shared_.prediction_out, ptr);
@@ -77,7 +112,6 @@ void PredictionWorker::sleep_small() {
 }
 
 void PredictionWorker::compute_prediction(const RobotState &rs,
-                                          const IMUState *imu,
                                           float measured_speed,
                                           float init_yaw,
                                           PredictionOut &out)
@@ -126,14 +160,15 @@ void PredictionWorker::compute_prediction(const RobotState &rs,
     }
 
     // ----------------- 1) Bullet speed filtering -----------------
-    float bs = this->bullet_speed;
-    filtering(bs, measured_speed, ALPHA_BULLET_SPEED);
+    // already outlier-filtered per speed mode (BulletSpeedRx in USBWorker)
+    float bs = measured_speed;
     this->bullet_speed = bs;
 
     if (bs < 1.0f || !std::isfinite(bs)) {
         bs = 15.0f;  // fallback
         this->bullet_speed = bs;
     }
+    ballistic_.update_speed(bs);
 
     // ----------------- 2) Processing time estimation --------------
     const auto now = Clock::now();
@@ -158,6 +193,17 @@ void PredictionWorker::compute_prediction(const RobotState &rs,
 
     constexpr float STATIONARY_SPEED_THRESH = 0.05f; // m/s
 
+#ifdef GIMBAL_FEED_FORWARD
+    // Large retargets take longer than small corrections
+    this->t_gimbal_actuation = gimbal_.actuation_delay(last_raw_yaw_, last_raw_pitch_);
+#endif
+
+#ifdef USB_CLOCK_SYNC_PERIOD
+    // the setpoint reaches the gimbal one serial hop after it is sent
+    if (auto cs = std::atomic_load(&shared_.clock_sync)) t_link_ = cs->one_way;
+#endif
+    const float t_actuation = this->t_gimbal_actuation + t_link_;
+
     float t_lead = 0.0f;
 
     if (speed < STATIONARY_SPEED_THRESH) {
@@ -165,16 +211,16 @@ void PredictionWorker::compute_prediction(const RobotState &rs,
         world_pos_lead   = world_pos;
         yaw_lead_world   = yaw_world;
         // Only compensate measurement+gimbal delay (no travel lead)
-        t_lead = proc + this->t_gimbal_actuation;
+        t_lead = proc + t_actuation;
     } else {
         // Full constant-acceleration lead
         world_pos_lead = world_pos;
         yaw_lead_world = yaw_world;
 
         // Initial guess including bullet travel + delays
-        t_lead = t_lead_calculation(world_pos_lead, bs)
+        t_lead = t_lead_calculation(world_pos_lead, bs, ballistic_)
                + proc
-               + this->t_gimbal_actuation;
+               + t_actuation;
 
         int   iter = 0;
         constexpr int MAX_ITERS = PRED_CONV_MAX_ITERS;
@@ -183,9 +229,9 @@ void PredictionWorker::compute_prediction(const RobotState &rs,
         do {
             motion_model_robot_pos(state, world_pos_lead, yaw_lead_world, t_lead_prev);
 
-            t_lead = t_lead_calculation(world_pos_lead, bs)
+            t_lead = t_lead_calculation(world_pos_lead, bs, ballistic_)
                    + proc
-                   + this->t_gimbal_actuation;
+                   + t_actuation;
 
             float diff = std::fabs(t_lead - t_lead_prev);
             t_lead_prev = t_lead;
@@ -198,8 +244,10 @@ void PredictionWorker::compute_prediction(const RobotState &rs,
     }
 
     // ----------------- 5) world -> camera using IMU ----------------
+    // attitude at command time (the newest sample; interpolated if the
+    // history already runs past it)
     float relative_yaw = imu_yaw - init_yaw;
-    bool imu_ok = get_imu_yaw_pitch(this->shared_, relative_yaw, imu_pitch);
+    bool imu_ok = get_imu_yaw_pitch_at(this->shared_, now, relative_yaw, imu_pitch);
     if (!imu_ok) {
         out.yaw   = 0.0f;
         out.pitch = 0.0f;
@@ -239,13 +287,25 @@ void PredictionWorker::compute_prediction(const RobotState &rs,
         state[14],   // height offset
         state[12],   // r1
         state[13]);  // r2
+#ifdef FIRE_HIT_PROBABILITY
+    const Eigen::Vector3f aim_world = R_world2cam.transpose() * armor_cam;   // before drop
+#endif
 
     // ----------------- 7) Bullet drop correction ------------------
-    const float t_bullet_travel =
-        std::max(0.0f, t_lead - this->t_gimbal_actuation - proc);
+    // Drag table: move the aim point onto the launch direction, so the
+    // gimbal pitch below comes out as the launch pitch. Off the table (too
+    // far / unreachable) fall back to the drag-free drop.
+    const float horiz_dist = std::sqrt(armor_cam[0] * armor_cam[0] + armor_cam[2] * armor_cam[2]);
+    BallisticSolution shot;
+    if (ballistic_.lookup(horiz_dist, armor_cam[1], shot)) {
+        armor_cam[1] = horiz_dist * std::tan(shot.pitch);
+    } else {
+        const float t_bullet_travel =
+            std::max(0.0f, t_lead - t_actuation - proc);
 
-    const float drop_correction = 0.5f * 9.81f * t_bullet_travel * t_bullet_travel;
-    armor_cam[1] += drop_correction;
+        const float drop_correction = 0.5f * 9.81f * t_bullet_travel * t_bullet_travel;
+        armor_cam[1] += drop_correction;
+    }
 
     // ----------------- 8) Gimbal correction (yaw, pitch) ----------
     calculate_gimbal_correction(armor_cam, correction);
@@ -257,7 +317,21 @@ void PredictionWorker::compute_prediction(const RobotState &rs,
         return;
     }
 
+    // Angular rate of the setpoint from the center velocity at impact, so
+    // the command streamer can carry it between predictions
+    const Eigen::Vector3f vel_lead(state[3] + state[6] * t_lead,
+                                   state[4] + state[7] * t_lead,
+                                   state[5] + state[8] * t_lead);
+    Eigen::Vector2f rate;
+    calculate_gimbal_rate(armor_cam, R_world2cam * vel_lead, rate);
+
+#ifdef FIRE_HIT_PROBABILITY
+    // Posterior carried to impact vs the point the shot goes through
+    const bool fire_state_raw  =
+        fire_control_.evaluate(state.data(), rs.var.data(), t_lead, aim_world.data()).fire;
+#else
     const bool fire_state_raw  = should_fire(correction);
+#endif
     const bool chase_state_raw = (armor_cam[2] > CHASE_THREASHOLD);
     const bool aim_state_raw   = true; // TODO: hook PF state machine
 
@@ -269,13 +343,23 @@ void PredictionWorker::compute_prediction(const RobotState &rs,
 
     float raw_yaw   = correction[0];
     float raw_pitch = correction[1];
+    last_raw_yaw_   = raw_yaw;
+    last_raw_pitch_ = raw_pitch;
 
     if (!vis_init_) {
         vis_yaw_   = raw_yaw;
         vis_pitch_ = raw_pitch;
+        vis_time_  = now;
         vis_init_  = true;
     }
 
+    // Gains below are per PF output period; predictions arrive irregularly,
+    // so scale them by how many such periods actually passed
+    constexpr float SMOOTH_PERIOD = 0.01f;   // s
+    const float periods = std::clamp(
+        std::chrono::duration<float>(now - vis_time_).count() / SMOOTH_PERIOD, 0.0f, 10.0f);
+    vis_time_ = now;
+
     float dy = raw_yaw   - vis_yaw_;
     float dp = raw_pitch - vis_pitch_;
 
@@ -291,8 +375,9 @@ void PredictionWorker::compute_prediction(const RobotState &rs,
     float alpha = alpha_min +
                   (alpha_max - alpha_min) *
                   std::min(1.0f, error_mag / error_threshold);
+    alpha = 1.0f - std::pow(1.0f - alpha, periods);
 
-    const float max_step = 0.05f;        // ~2.9 deg per update
+    const float max_step = 0.05f * periods;   // ~2.9 deg per period
     dy = std::clamp(dy, -max_step, max_step);
     dp = std::clamp(dp, -max_step, max_step);
 
@@ -330,11 +415,24 @@ void PredictionWorker::compute_prediction(const RobotState &rs,
 
 
     // ----------------- 10) Write Outputs --------------------------
+#ifdef GIMBAL_FEED_FORWARD
+    // Lead the setpoint by the gimbal's tracking lag at the target's rate
+    out.yaw   = vis_yaw_   + gimbal_.yaw().feed_forward(rate[0]);
+    out.pitch = vis_pitch_ + gimbal_.pitch().feed_forward(rate[1]);
+    clamp_to_gimbal_limits(out.yaw, out.pitch);
+#else
     out.yaw   = vis_yaw_;
     out.pitch = vis_pitch_;
+#endif
     out.aim   = aim_state   ? 1 : 0;
     out.fire  = fire_state  ? 1 : 0;
     out.chase = chase_state ? 1 : 0;
+    out.yaw_rate   = rate[0];
+    out.pitch_rate = rate[1];
+    out.timestamp  = now;
+    out.att_yaw    = relative_yaw;   // the IMU's yaw: get_imu_yaw_pitch_at filled it
+    out.att_pitch  = imu_pitch;
+    out.att_valid  = true;
 }
 
 
@@ -349,11 +447,18 @@ inline bool is_converged(float v, float threshold) {
     return std::fabs(v) < threshold;
 }
 
-inline float t_lead_calculation(const Eigen::Vector3f &tvec, const float &bullet_speed) {
+// Flight time with drag from the ballistic table; drag-free range / speed
+// where the table has no entry.
+inline float t_lead_calculation(const Eigen::Vector3f &tvec, const float &bullet_speed,
+                                const BallisticSolver &ballistic) {
     const float dx = tvec[0];
     const float dy = tvec[1];
     const float dz = tvec[2];
 
+    BallisticSolution shot;
+    if (ballistic.lookup(std::sqrt(dx*dx + dz*dz), dy, shot))
+        return shot.time;
+
     const float distance2 = dx*dx + dy*dy + dz*dz;
     const float distance  = std::sqrt(distance2);
 
@@ -415,6 +520,23 @@ inline void calculate_gimbal_correction(const Eigen::Vector3f &tvec,
     correction[1] = std::atan2(y, horizontal_dist); // pitch
 }
 
+// Time derivative of calculate_gimbal_correction for a point moving at vel.
+inline void calculate_gimbal_rate(const Eigen::Vector3f &tvec, const Eigen::Vector3f &vel,
+                                  Eigen::Vector2f &rate)
+{
+    const float x = tvec[0], y = tvec[1], z = tvec[2];
+    const float h2 = x*x + z*z;
+    const float h  = std::sqrt(h2);
+    if (h < 1e-3f) {
+        rate.setZero();
+        return;
+    }
+    rate[0] = (z * vel[0] - x * vel[2]) / h2;                  // yaw
+
+    const float dh = (x * vel[0] + z * vel[2]) / h;
+    rate[1] = (h * vel[1] - y * dh) / (h2 + y*y);              // pitch
+}
+
 inline int should_fire(const Eigen::Vector2f &angular_error) {
     constexpr float HALF = 0.5f;
     const float x_tolerance = WIDTH_TOLERANCE  * TOLERANCE_COEFF * HALF;
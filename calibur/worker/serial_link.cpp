@@ -0,0 +1,186 @@
+// serial_link.cpp
+#include "serial_link.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "calibur/log.h"
+
+static calibur::Logger::ptr g_logger = CALIBUR_LOG_NAME("usb");
+
+SerialLink::SerialLink(FrameHandler on_frame) : on_frame_(std::move(on_frame)) {
+    if (!on_frame_) on_frame_ = [](uint8_t, const uint8_t *, uint16_t) {};
+}
+
+SerialLink::~SerialLink() {
+    detach();
+}
+
+bool SerialLink::attach(int fd) {
+    detach();
+    if (fd < 0) return false;
+
+    const int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        CALIBUR_LOG_ERROR(g_logger) << "Cannot make serial fd non-blocking: " << strerror(errno);
+        return false;
+    }
+    epfd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd_ < 0) {
+        CALIBUR_LOG_ERROR(g_logger) << "epoll_create1 failed: " << strerror(errno);
+        return false;
+    }
+    epoll_event ev{};
+    ev.events  = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        CALIBUR_LOG_ERROR(g_logger) << "epoll_ctl failed: " << strerror(errno);
+        ::close(epfd_);
+        epfd_ = -1;
+        return false;
+    }
+
+    fd_       = fd;
+    want_out_ = false;
+    tx_off_   = tx_len_ = 0;
+    parser_.reset();
+    return true;
+}
+
+void SerialLink::detach() {
+    if (epfd_ >= 0) ::close(epfd_);
+    epfd_   = -1;
+    fd_     = -1;
+    tx_off_ = tx_len_ = 0;
+}
+
+bool SerialLink::send(const uint8_t *bytes, size_t n) {
+    if (fd_ < 0) return false;
+    if (tx_len_ + n > kTxBacklog) {
+        ++stats_.tx_dropped;
+        return false;
+    }
+
+    // backlog first, in the same syscall
+    ssize_t w;
+    if (tx_len_ == 0) {
+        w = ::write(fd_, bytes, n);
+    } else {
+        iovec iov[2] = {{tx_ + tx_off_, tx_len_}, {const_cast<uint8_t *>(bytes), n}};
+        w = ::writev(fd_, iov, 2);
+    }
+    ++stats_.tx_writes;
+    if (w < 0) {
+        if (errno != EAGAIN && errno != EINTR) {
+            CALIBUR_LOG_ERROR(g_logger) << "Serial write failed: " << strerror(errno);
+            return false;
+        }
+        w = 0;
+    }
+    ++stats_.sends;
+    return consume(size_t(w), bytes, n);
+}
+
+// Accounts `written` bytes against backlog + (bytes, n) and queues the rest.
+bool SerialLink::consume(size_t written, const uint8_t *bytes, size_t n) {
+    stats_.tx_bytes += written;
+    const size_t from_backlog = std::min(written, tx_len_);
+    tx_off_ += from_backlog;
+    tx_len_ -= from_backlog;
+    if (tx_len_ == 0) tx_off_ = 0;
+
+    const size_t from_new = written - from_backlog;
+    if (from_new < n || tx_len_ > 0) {
+        ++stats_.tx_partial;
+        const size_t rest = n - from_new;
+        if (tx_off_ + tx_len_ + rest > kTxBacklog) {
+            std::memmove(tx_, tx_ + tx_off_, tx_len_);
+            tx_off_ = 0;
+        }
+        if (rest) std::memcpy(tx_ + tx_off_ + tx_len_, bytes + from_new, rest);
+        tx_len_ += rest;
+    }
+    want_writable(tx_len_ > 0);
+    return true;
+}
+
+bool SerialLink::flush() {
+    if (tx_len_ == 0) {
+        want_writable(false);
+        return true;
+    }
+    const ssize_t w = ::write(fd_, tx_ + tx_off_, tx_len_);
+    ++stats_.tx_writes;
+    if (w < 0) {
+        if (errno == EAGAIN || errno == EINTR) return true;
+        CALIBUR_LOG_ERROR(g_logger) << "Serial write failed: " << strerror(errno);
+        return false;
+    }
+    stats_.tx_bytes += size_t(w);
+    tx_off_ += size_t(w);
+    tx_len_ -= size_t(w);
+    if (tx_len_ == 0) tx_off_ = 0;
+    want_writable(tx_len_ > 0);
+    return true;
+}
+
+void SerialLink::want_writable(bool on) {
+    if (on == want_out_ || epfd_ < 0) return;
+    epoll_event ev{};
+    ev.events  = EPOLLIN | (on ? EPOLLOUT : 0u);
+    ev.data.fd = fd_;
+    if (epoll_ctl(epfd_, EPOLL_CTL_MOD, fd_, &ev) == 0) want_out_ = on;
+}
+
+int SerialLink::drain_rx() {
+    const uint64_t before = parser_.stats().frames;
+    for (;;) {
+        const ssize_t n = ::read(fd_, rx_, kRxChunk);
+        if (n > 0) {
+            ++stats_.rx_reads;
+            stats_.rx_bytes += size_t(n);
+            parser_.feed(rx_, size_t(n), on_frame_);
+            if (size_t(n) < kRxChunk) break;
+            continue;
+        }
+        if (n == 0 || errno == EAGAIN || errno == EINTR) break;
+        CALIBUR_LOG_ERROR(g_logger) << "Serial read failed: " << strerror(errno);
+        return -1;
+    }
+    return int(parser_.stats().frames - before);
+}
+
+size_t SerialLink::queued() const {
+    int out = 0;
+    if (fd_ < 0 || ioctl(fd_, TIOCOUTQ, &out) < 0 || out < 0) out = 0;
+    return tx_len_ + size_t(out);
+}
+
+int SerialLink::poll(int timeout_ms) {
+    if (fd_ < 0) return -1;
+
+    epoll_event ev;
+    const int r = epoll_wait(epfd_, &ev, 1, timeout_ms);
+    if (r < 0) return errno == EINTR ? 0 : -1;
+    if (r == 0) return 0;
+
+    int frames = 0;
+    const uint64_t rx_before = stats_.rx_bytes;
+    if (ev.events & EPOLLIN) {
+        frames = drain_rx();
+        if (frames < 0) return -1;
+    }
+    if ((ev.events & EPOLLOUT) && !flush()) return -1;
+    // a hung-up tty stays readable with nothing to read
+    if ((ev.events & (EPOLLERR | EPOLLHUP)) && stats_.rx_bytes == rx_before) {
+        CALIBUR_LOG_ERROR(g_logger) << "Serial link hung up";
+        return -1;
+    }
+    return frames;
+}
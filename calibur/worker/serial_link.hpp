@@ -0,0 +1,85 @@
+// serial_link.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "usb_protocol.hpp"
+
+// Non-blocking, full-duplex frame transport over an open serial fd
+// (calibur::USBCommunication::fd()). One thread drives both directions
+// through poll():
+//
+//  - TX: send() writes an encoded frame (or several back to back) with a
+//    single syscall. Whatever the driver does not take is kept in a fixed
+//    backlog and flushed when epoll reports the fd writable, together with
+//    later frames via writev. Only whole frames are ever dropped (backlog
+//    full), so the stream on the wire stays frame-aligned.
+//  - RX: readable data is read in bulk into a fixed buffer and run through
+//    UsbFrameParser; complete frames go to the handler.
+//
+// No allocation after construction. The fd stays owned by the caller.
+
+struct SerialLinkStats {
+    uint64_t sends      = 0;   // send() calls accepted
+    uint64_t tx_bytes   = 0;
+    uint64_t tx_writes  = 0;   // write / writev syscalls
+    uint64_t tx_partial = 0;   // writes that left bytes in the backlog
+    uint64_t tx_dropped = 0;   // send() calls refused, backlog full
+    uint64_t rx_bytes   = 0;
+    uint64_t rx_reads   = 0;
+};
+
+class SerialLink {
+public:
+    using FrameHandler = std::function<void(uint8_t type, const uint8_t *payload, uint16_t len)>;
+
+    static constexpr size_t kTxBacklog = 4096;
+    static constexpr size_t kRxChunk   = 1024;
+
+    explicit SerialLink(FrameHandler on_frame);
+    ~SerialLink();
+    SerialLink(const SerialLink &) = delete;
+    SerialLink &operator=(const SerialLink &) = delete;
+
+    // Switches fd to O_NONBLOCK and registers it; false on failure.
+    bool attach(int fd);
+    void detach();
+    bool attached() const { return fd_ >= 0; }
+
+    // Sends n encoded bytes (whole frames). False if the link is down or
+    // the backlog cannot take them; nothing is queued then.
+    bool send(const uint8_t *bytes, size_t n);
+
+    // Waits up to timeout_ms (0: just check) for RX data or TX space,
+    // dispatches received frames and flushes the backlog. Returns the
+    // number of frames dispatched, -1 if the link failed (hang-up, I/O
+    // error); the caller should detach and reopen.
+    int poll(int timeout_ms);
+
+    size_t backlog() const { return tx_len_; }
+
+    // Bytes sent but not yet on the wire: the backlog plus the driver's
+    // output queue (TIOCOUTQ; backlog only where the driver cannot tell).
+    size_t queued() const;
+    const SerialLinkStats       &stats()        const { return stats_; }
+    const UsbFrameParser::Stats &parser_stats() const { return parser_.stats(); }
+
+private:
+    bool flush();
+    bool consume(size_t written, const uint8_t *bytes, size_t n);
+    void want_writable(bool on);
+    int  drain_rx();
+
+    FrameHandler    on_frame_;
+    int             fd_   = -1;
+    int             epfd_ = -1;
+    bool            want_out_ = false;
+
+    uint8_t         tx_[kTxBacklog];
+    size_t          tx_off_ = 0, tx_len_ = 0;
+    uint8_t         rx_[kRxChunk];
+    UsbFrameParser  parser_;
+    SerialLinkStats stats_;
+};
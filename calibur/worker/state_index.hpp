@@ -0,0 +1,15 @@
+#pragma once
+
+// State vector layout shared by workers, the GPU filter and its CPU mirror.
+// Kept free of OpenCV/Eigen so the PF code can be built and tested standalone.
+
+#define ROBOT_STATE_VEC_LEN     15
+
+// State indices in X
+enum StateIdx {
+    IDX_TX = 0, IDX_TY = 1, IDX_TZ = 2,
+    IDX_VX = 3, IDX_VY = 4, IDX_VZ = 5,
+    IDX_AX = 6, IDX_AY = 7, IDX_AZ = 8,
+    IDX_YAW   = 9, IDX_OMEGA = 10, IDX_ALPHA = 11,
+    IDX_R1 = 12, IDX_R2 = 13, IDX_H  = 14
+};
@@ -8,6 +8,11 @@
 #include <atomic>
 
 #include "../imu/imu_data.hpp"
+#include "../imu/imu_history.hpp"
+#include "state_index.hpp"
+#include "version_signal.hpp"
+#include "camera_roi.hpp"
+#include "bayer.h"
 
 #include <opencv2/core.hpp>
 #include <Eigen/Dense>
@@ -16,33 +21,23 @@
 using Clock     = std::chrono::steady_clock;
 using TimePoint = Clock::time_point;
 
-#define ROBOT_STATE_VEC_LEN     15
-
 // =======================
 // Data Structures
 // =======================
 
-// State indices in X
-enum StateIdx {
-    IDX_TX = 0, IDX_TY = 1, IDX_TZ = 2,
-    IDX_VX = 3, IDX_VY = 4, IDX_VZ = 5,
-    IDX_AX = 6, IDX_AY = 7, IDX_AZ = 8,
-    IDX_YAW   = 9, IDX_OMEGA = 10, IDX_ALPHA = 11,
-    IDX_R1 = 12, IDX_R2 = 13, IDX_H  = 14
-};
-
 struct CameraFrame {
     cv::Mat      raw_data;
-    TimePoint    timestamp;
+    TimePoint    timestamp;          // mid exposure when the camera clock is mapped, else hand-over
     int          width  = 640;
     int          height = 640;
-};
-
-struct IMUState {
-    std::vector<float> euler_angle;   // [roll, pitch, yaw] etc.
-    float              time = 0.0f;   // seconds since some ref
-    std::vector<float> quaternion;    // optional, may be empty
-    TimePoint          timestamp;
+    uint32_t     frame_num = 0;      // camera frame number (video: index in the stream; 0 for stub frames)
+    uint32_t     dropped   = 0;      // frames the camera produced since the previous one that never arrived
+    std::shared_ptr<void> lease;     // SDK / decoded video buffer raw_data / bayer point into, if any; returned with the frame
+    cv::Mat      bayer;              // raw 8-bit Bayer frame raw_data was demosaiced from, if the camera sent one
+    BayerPattern bayer_pattern = BayerPattern::RG;
+    SensorRoi    roi;                // window of the full frame raw_data was read out from
+    int          full_width  = 0;    // full frame (camera intrinsics), roi.x / roi.y relative to it
+    int          full_height = 0;
 };
 
 
@@ -75,6 +70,7 @@ enum PfStateFlag {
 struct RobotState {
     // [x, y, z, vx, vy, vz, ax, ay, az, yaw, omega, alpha, r1, r2, h]
     std::array<float, ROBOT_STATE_VEC_LEN> state; // size 15
+    std::array<float, ROBOT_STATE_VEC_LEN> var{}; // posterior marginal variances, 0 if unknown
     int   class_id  = -1;
     int   pf_state  = PF_STATE_OK;
     TimePoint timestamp;
@@ -86,28 +82,49 @@ struct PredictionOut {
     int   aim   = 0;
     int   fire  = 0;
     int   chase = 0;
+
+    // For fixed-rate streaming: angular rate of the setpoint (rad/s) from
+    // the target motion model, and when it was computed.
+    float     yaw_rate   = 0.0f;
+    float     pitch_rate = 0.0f;
+    TimePoint timestamp;
+
+    // Gimbal attitude yaw / pitch are relative to (IMU yaw / pitch as
+    // imu_yaw_pitch_at reads them, rad), so the setpoint can be re-expressed
+    // against the attitude at send time. Unset when no setpoint was computed.
+    float     att_yaw    = 0.0f;
+    float     att_pitch  = 0.0f;
+    bool      att_valid  = false;
 };
 
 
+struct ClockSyncEstimate;   // clock_sync.hpp
+
 // Shared latest values plus version counters for
 // "use-latest, consume-once" semantics.
 
 struct SharedLatest {
     // Data
     std::shared_ptr<CameraFrame>   camera;
-    std::shared_ptr<IMUState>      imu;
     std::shared_ptr<RobotState>    detection_out;
     std::shared_ptr<RobotState>    pf_out;
     std::shared_ptr<PredictionOut> prediction_out;
     std::shared_ptr<YoloOutput>    yolo;
+    std::shared_ptr<ClockSyncEstimate> clock_sync;   // host <-> MCU clock / link delay
+    std::shared_ptr<RoiTarget>     roi_target;       // locked target's box, for the camera ROI
+
+    // Every IMU sample of the last ~1 s, for attitude at a given time
+    ImuHistory imu_history;
 
     // Version counters (increment per new publish)
     std::atomic<uint64_t> camera_ver     {0};
-    std::atomic<uint64_t> imu_ver        {0};
     std::atomic<uint64_t> detection_ver  {0};
     std::atomic<uint64_t> pf_ver         {0};
     std::atomic<uint64_t> prediction_ver {0};
     std::atomic<uint64_t> yolo_ver       {0};
+
+    // Wake-ups for event-driven consumers (PFWorker waits on detections)
+    VersionSignal detection_signal;
 };
 
 struct SharedScalars {
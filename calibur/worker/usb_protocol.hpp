@@ -0,0 +1,169 @@
+// usb_protocol.hpp
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Serial framing shared by host and MCU, both directions:
+//
+//   0xAA | len (u16 LE, payload bytes) | type | payload[len] | crc8 of all previous bytes
+//
+// Multi-byte fields are little-endian, floats IEEE-754. The CRC is the
+// referee-protocol CRC-8 (poly 0x31 reflected, init 0xFF); firmware still
+// on the plain xor checksum needs USB_FRAME_XOR_CHECKSUM.
+
+// #define USB_FRAME_XOR_CHECKSUM
+
+constexpr uint8_t kUsbHeader     = 0xAA;
+constexpr size_t  kUsbFrameExtra = 5;     // header, len x2, type, checksum
+constexpr size_t  kUsbMaxPayload = 64;
+
+enum UsbFrameType : uint8_t {
+    USB_TX_AIM     = 0x01,   // float yaw, float pitch
+    USB_TX_STATE   = 0x02,   // int aim, int fire, int chase
+    USB_TX_PING    = 0x03,   // u32 seq, u64 host_ns
+    USB_RX_SHOOTER = 0x11,   // float bullet_speed (m/s), u8 speed_mode
+    USB_RX_PONG    = 0x12,   // u32 seq, u64 host_ns (echoed), u32 mcu_rx_us, u32 mcu_tx_us
+    USB_RX_GIMBAL  = 0x13,   // float yaw, float pitch (rad, measured), u32 mcu_us
+};
+
+constexpr uint16_t kUsbAimLen     = 8;
+constexpr uint16_t kUsbStateLen   = 12;
+constexpr uint16_t kUsbShooterLen = 5;
+constexpr uint16_t kUsbPingLen    = 12;
+constexpr uint16_t kUsbPongLen    = 20;
+constexpr uint16_t kUsbGimbalLen  = 12;
+
+// USB_TX_AIM + USB_TX_STATE back to back: one write per command
+constexpr size_t kUsbCommandBytes = kUsbAimLen + kUsbStateLen + 2 * kUsbFrameExtra;
+
+constexpr std::array<uint8_t, 256> usb_crc8_table() {
+    std::array<uint8_t, 256> t{};
+    for (int i = 0; i < 256; ++i) {
+        uint8_t c = uint8_t(i);
+        for (int k = 0; k < 8; ++k) c = (c & 1) ? uint8_t((c >> 1) ^ 0x8C) : uint8_t(c >> 1);
+        t[i] = c;
+    }
+    return t;
+}
+
+inline constexpr std::array<uint8_t, 256> kUsbCrc8Table = usb_crc8_table();
+
+inline uint8_t usb_checksum(const uint8_t *p, size_t n) {
+#ifdef USB_FRAME_XOR_CHECKSUM
+    uint8_t c = 0;
+    for (size_t i = 0; i < n; ++i) c ^= p[i];
+    return c;
+#else
+    uint8_t c = 0xFF;
+    for (size_t i = 0; i < n; ++i) c = kUsbCrc8Table[c ^ p[i]];
+    return c;
+#endif
+}
+
+// Writes one frame to out (len + kUsbFrameExtra bytes); returns its size.
+inline size_t usb_encode_frame(uint8_t type, const void *payload, uint16_t len, uint8_t *out) {
+    out[0] = kUsbHeader;
+    out[1] = uint8_t(len & 0xFF);
+    out[2] = uint8_t(len >> 8);
+    out[3] = type;
+    std::memcpy(out + 4, payload, len);
+    out[4 + len] = usb_checksum(out, 4 + len);
+    return len + kUsbFrameExtra;
+}
+
+// Gimbal command as USB_TX_AIM (yaw, pitch) followed by USB_TX_STATE (aim,
+// fire, chase); out must hold kUsbCommandBytes.
+inline size_t usb_encode_command(float yaw, float pitch, int32_t aim, int32_t fire,
+                                 int32_t chase, uint8_t *out) {
+    const float   angles[2] = {yaw, pitch};
+    const int32_t state[3]  = {aim, fire, chase};
+    size_t n = usb_encode_frame(USB_TX_AIM, angles, kUsbAimLen, out);
+    n += usb_encode_frame(USB_TX_STATE, state, kUsbStateLen, out + n);
+    return n;
+}
+
+// Incremental frame parser for a byte stream. Feed whatever read() returned;
+// complete frames are handed to on_frame(type, payload, len). After a bad
+// checksum or an oversize length it resumes at the next 0xAA inside the
+// rejected bytes, so a header that was really a data byte costs at most one
+// frame.
+class UsbFrameParser {
+public:
+    struct Stats {
+        uint64_t frames       = 0;
+        uint64_t bad_checksum = 0;
+        uint64_t oversize     = 0;
+        uint64_t skipped      = 0;   // bytes outside any frame
+    };
+
+    template <class F>
+    void feed(const uint8_t *data, size_t n, F &&on_frame) {
+        for (size_t i = 0; i < n; ++i) push(data[i], on_frame);
+    }
+
+    const Stats &stats() const { return stats_; }
+    void reset() { state_ = WAIT_HEADER; size_ = 0; }
+
+private:
+    enum State { WAIT_HEADER, LEN_LO, LEN_HI, TYPE, PAYLOAD, CHECKSUM };
+
+    template <class F>
+    void push(uint8_t b, F &on_frame) {
+        switch (state_) {
+        case WAIT_HEADER:
+            if (b == kUsbHeader) { buf_[0] = b; size_ = 1; state_ = LEN_LO; }
+            else ++stats_.skipped;
+            return;
+        case LEN_LO:
+            buf_[size_++] = b; state_ = LEN_HI;
+            return;
+        case LEN_HI:
+            buf_[size_++] = b;
+            len_ = uint16_t(buf_[1] | (uint16_t(b) << 8));
+            if (len_ > kUsbMaxPayload) { ++stats_.oversize; resync(on_frame); return; }
+            state_ = TYPE;
+            return;
+        case TYPE:
+            buf_[size_++] = b;
+            state_ = len_ ? PAYLOAD : CHECKSUM;
+            return;
+        case PAYLOAD:
+            buf_[size_++] = b;
+            if (size_ == 4 + size_t(len_)) state_ = CHECKSUM;
+            return;
+        case CHECKSUM:
+            if (b == usb_checksum(buf_, size_)) {
+                ++stats_.frames;
+                state_ = WAIT_HEADER;
+                size_  = 0;
+                on_frame(buf_[3], buf_ + 4, len_);
+            } else {
+                ++stats_.bad_checksum;
+                buf_[size_++] = b;
+                resync(on_frame);
+            }
+            return;
+        }
+    }
+
+    // drop the header byte, re-parse the rest
+    template <class F>
+    void resync(F &on_frame) {
+        uint8_t tail[kUsbMaxPayload + kUsbFrameExtra];
+        const size_t n = size_ - 1;
+        std::memcpy(tail, buf_ + 1, n);
+        state_ = WAIT_HEADER;
+        size_  = 0;
+        ++stats_.skipped;
+        for (size_t i = 0; i < n; ++i) push(tail[i], on_frame);
+    }
+
+    State    state_ = WAIT_HEADER;
+    uint8_t  buf_[kUsbMaxPayload + kUsbFrameExtra];
+    size_t   size_  = 0;
+    uint16_t len_   = 0;
+    Stats    stats_;
+};
@@ -1,6 +1,8 @@
 #include "types.hpp"
 #include <thread>
 #include "workers.hpp"
+#include "helper.hpp"
+#include "gimbal_id.hpp"
 #include "usb_communication.h"
 #include "calibur/log.h"
 
@@ -9,111 +11,211 @@ static calibur::Logger::ptr g_logger = CALIBUR_LOG_NAME("usb");
 USBWorker::USBWorker(SharedLatest &shared,
             SharedScalars &scalars,
             std::atomic<bool> &stop_flag)
-    : shared_(shared), scalars_(scalars), stop_(stop_flag), last_pred_ver_(0) {}
+    : shared_(shared), scalars_(scalars), stop_(stop_flag), last_pred_ver_(0)
+{
+    BulletSpeedParams bp;
+    bp.window        = BULLET_SPEED_WINDOW;
+    bp.alpha         = BULLET_SPEED_ALPHA;
+    bp.max_dev       = BULLET_SPEED_MAX_DEV;
+    bp.default_speed = BULLET_SPEED_DEFAULT;
+    device_   = serial_device("CALIBUR_USB_DEVICE", USB_DEVICE_PATH);
+    usb_      = std::make_shared<calibur::USBCommunication>(device_, USB_BAUD_RATE);
+    speed_rx_ = std::make_shared<BulletSpeedRx>(bp, scalars_.bullet_speed);
+
+    ClockSyncParams cp;
+#ifdef USB_CLOCK_SYNC_PERIOD
+    cp.ping_period = USB_CLOCK_SYNC_PERIOD;
+#endif
+    clock_sync_ = std::make_shared<ClockSync>(cp);
+
+    auto rx = speed_rx_;
+    auto cs = clock_sync_;
+    SharedLatest *sh = &shared_;
+    link_ = std::make_shared<SerialLink>([rx, cs, sh](uint8_t type, const uint8_t *payload, uint16_t len) {
+        if (type == USB_RX_PONG) {
+            if (cs->on_pong(payload, len, Clock::now()) && cs->estimate().valid) {
+                std::atomic_store(&sh->clock_sync, std::make_shared<ClockSyncEstimate>(cs->estimate()));
+            }
+            return;
+        }
+        rx->on_frame(type, payload, len);
+    });
+}
 
 void USBWorker::operator()() {
-    while (!stop_.load(std::memory_order_relaxed)) {
-        process_usb_rx(); // updates scalars_.bullet_speed etc.
+    ensure_link();
+
+#ifdef USB_STREAM_RATE_HZ
+    // Fixed-rate setpoints: every tick sends the latest prediction carried
+    // to the tick time, independent of when predictions arrive
+    StreamerParams sp;
+    sp.rate_hz           = USB_STREAM_RATE_HZ;
+
+    const double link_rate = link_command_rate(USB_BAUD_RATE, kUsbCommandBytes, USB_STREAM_LINK_SHARE);
+    if (sp.rate_hz > link_rate) {
+        CALIBUR_LOG_WARN(g_logger) << "Stream rate " << sp.rate_hz << " Hz is more than " << USB_BAUD_RATE
+                                   << " baud carries, using " << link_rate << " Hz";
+        sp.rate_hz = link_rate;
+    }
+    sp.max_extrapolation = USB_STREAM_MAX_EXTRAPOLATION;
+    sp.stale_after       = USB_STREAM_STALE_AFTER;
+    sp.report_period     = USB_STREAM_REPORT_PERIOD;
+    CommandStreamer streamer(sp);
+    const auto report_every = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(USB_STREAM_REPORT_PERIOD));
+    TimePoint next_report = Clock::now() + report_every;
+    uint64_t  reported    = 0;
+
+    const bool ok = streamer.run(stop_, [&](TimePoint now) {
+        process_usb_rx();
+        if (now >= next_report) {
+            if (stream_skipped_ != reported) {
+                CALIBUR_LOG_WARN(g_logger) << stream_skipped_ - reported
+                                           << " setpoint(s) skipped, link still sending the previous one";
+                reported = stream_skipped_;
+            }
+            next_report = now + report_every;
+        }
+        auto pred = std::atomic_load(&shared_.prediction_out);
+        if (!pred) return;
+        if (link_->queued() >= kUsbCommandBytes) {
+            // the last setpoint is not out yet: a newer one would only
+            // queue behind it
+            ++stream_skipped_;
+            return;
+        }
+        const PredictionOut cmd = rebase_on_gimbal(extrapolate_command(*pred, now, sp), now);
+        usb_send_tx(cmd);
+        record_command(cmd);
+    });
+    if (ok) return;
+    CALIBUR_LOG_ERROR(g_logger) << "Command streamer unavailable, sending per prediction";
+#endif
 
+    while (!stop_.load(std::memory_order_relaxed)) {
         uint64_t cur_ver = shared_.prediction_ver.load(std::memory_order_relaxed);
         if (cur_ver == last_pred_ver_) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            process_usb_rx(1); // waits on the port instead of sleeping
             continue; // no new prediction
         }
         last_pred_ver_ = cur_ver;
+        process_usb_rx(); // updates scalars_.bullet_speed etc.
 
         auto pred = std::atomic_load(&shared_.prediction_out);
         if (pred) {
-            usb_send_tx(*pred);
+            const PredictionOut cmd = rebase_on_gimbal(*pred, Clock::now());
+            usb_send_tx(cmd);
+            record_command(cmd);
         }
     }
 }
 
-void USBWorker::process_usb_rx() {
-    // parse incoming packets
-    // e.g. update scalars_.bullet_speed.store(new_speed);
+// The MCU applies a command relative to the gimbal pose when it arrives,
+// but a prediction is relative to the pose it was computed against. Holds
+// the absolute setpoint by re-expressing it against the attitude at t;
+// sent as computed if the IMU has nothing.
+PredictionOut USBWorker::rebase_on_gimbal(const PredictionOut &out, TimePoint t) {
+    return rebase_command_at(out, shared_.imu_history, t);
 }
 
-void USBWorker::usb_send_tx(const PredictionOut &out) {
-    // encode yaw, pitch, aim, fire, chase to COM
+// Command / IMU pairs for offline gimbal identification (gimbal_identify).
+// Commands are angles relative to the current gimbal pose, so the absolute
+// setpoint is the IMU angle plus the command.
+void USBWorker::record_command(const PredictionOut &out) {
+#ifdef GIMBAL_RECORD_LOG
+    static GimbalLogWriter gimbal_log;
+    static bool tried = false;
+    if (!tried) {
+        tried = true;
+        if (!gimbal_log.open(GIMBAL_RECORD_LOG)) {
+            CALIBUR_LOG_ERROR(g_logger) << "Cannot record gimbal log to " << GIMBAL_RECORD_LOG;
+        }
+    }
+    if (!gimbal_log.is_open()) return;
+
+    float imu_yaw = 0.0f, imu_pitch = 0.0f;
+    if (!get_imu_yaw_pitch(shared_, imu_yaw, imu_pitch)) return;
+    imu_yaw -= std::atomic_load(&scalars_.initial_yaw);
+
+    const double t = std::chrono::duration<double>(Clock::now().time_since_epoch()).count();
+    gimbal_log.append(t, imu_yaw + out.yaw, imu_pitch + out.pitch, imu_yaw, imu_pitch);
+#else
+    (void)out;
+#endif
+}
+
+// Opens the port and attaches the link, at most once per USB_REOPEN_PERIOD.
+bool USBWorker::ensure_link() {
+    if (link_->attached()) return true;
 
-    if (!is_open_ || fd_ < 0) {
-        CALIBUR_LOG_ERROR(g_logger) << "Cannot send: USB device not open";
+    const TimePoint now = Clock::now();
+    if (last_open_try_ != TimePoint() &&
+        now - last_open_try_ < std::chrono::duration<double>(USB_REOPEN_PERIOD)) {
         return false;
     }
+    last_open_try_ = now;
 
-    // packet 1
-    {
-    uint16_t len = 8;
-    uint8_t data_type = 0x01;
-    std::vector<uint8_t> packet = {0xAA, static_cast<uint8_t>(len & 0xFF), static_cast<uint8_t>((len >> 8) & 0xFF), data_type};
-    
-    // yaw
-    uint8_t yaw_len = 4;
-    uint8_t yaw_bytes[4];
-    memcpy(yaw_bytes, &out.yaw, yaw_len);
-    packet.insert(packet.end(), yaw_bytes, yaw_bytes + 4);
-
-    //pitch
-    uint8_t pitch_len = 4;
-    uint8_t pitch_bytes[4];
-    memcpy(pitch_bytes, &out.pitch, pitch_len);
-    packet.insert(packet.end(), pitch_bytes, pitch_bytes + 4);
-
-    //checksum so far
-
-    uint8_t checksum = 0;
-    for (int i = 0; i < packet.size(); i++) {
-        checksum ^= packet[i];
-    }
-    packet.push_back(checksum);
-    
-    ssize_t written = write(fd_, packet.data(), packet.size());
-    if (written != packet.size()) {
-        CALIBUR_LOG_ERROR(g_logger) << "Write failed: yaw, pitch not sent " 
-                                    << written << ", error: " << strerror(errno);
+    usb_->close();
+    if (!usb_->open() || !link_->attach(usb_->fd())) {
+        CALIBUR_LOG_ERROR(g_logger) << "Cannot open " << device_ << ", no shooter feedback";
         return false;
     }
-    
-    CALIBUR_LOG_DEBUG(g_logger) << "Sent data: yaw=" << yaw << ", pitch=" << pitch 
-                                << ", is_fire=" << (is_fire ? "true" : "false");
+    return true;
+}
+
+// Serves the port for up to timeout_ms: received frames update
+// scalars_.bullet_speed, pending TX bytes are flushed.
+void USBWorker::process_usb_rx(int timeout_ms) {
+    if (!ensure_link()) {
+        if (timeout_ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+        return;
+    }
+    if (link_->poll(timeout_ms) < 0) {
+        CALIBUR_LOG_ERROR(g_logger) << "Serial link lost, reopening " << device_;
+        link_->detach();
+        usb_->close();
+        return;
     }
+    clock_sync_tick();
+}
 
-    // Packet 2: 0x02 - aim, fire, chase (three ints, 12 bytes)
-    {
-    uint16_t len = 12;
-    uint8_t data_type = 0x02;
-    std::vector<uint8_t> packet_2 = {0xAA, static_cast<uint8_t>(len & 0xFF), static_cast<uint8_t>((len >> 8) & 0xFF), data_type};
-
-    // aim
-    uint8_t aim_bytes[4];
-    memcpy(aim_bytes, &out.aim, 4);
-    packet_2.insert(packet_2.end(), aim_bytes, aim_bytes + 4);
-
-    // fire
-    uint8_t fire_bytes[4];
-    memcpy(fire_bytes, &out.fire, 4);
-    packet_2.insert(packet_2.end(), fire_bytes, fire_bytes + 4);
-
-    // chase
-    uint8_t chase_bytes[4];
-    memcpy(chase_bytes, &out.chase, 4);
-    packet_2.insert(packet_2.end(), chase_bytes, chase_bytes + 4);
-
-    uint8_t checksum_2 = 0;
-    for (int i = 0; i < packet_2.size(); i++) {
-        checksum_2 ^= packet_2[i];
+// Pings the MCU every USB_CLOCK_SYNC_PERIOD (pongs are handled in the link
+// callback) and reports the link delay distribution.
+void USBWorker::clock_sync_tick() {
+#ifdef USB_CLOCK_SYNC_PERIOD
+    const TimePoint now = Clock::now();
+    if (clock_sync_->due(now)) {
+        uint8_t frame[kUsbPingLen + kUsbFrameExtra];
+        link_->send(frame, clock_sync_->make_ping(now, frame));
     }
-    packet_2.push_back(checksum_2);
 
-    ssize_t written = write(fd_, packet_2.data(), packet_2.size());
-    if (written != packet_2.size()) {
-        CALIBUR_LOG_ERROR(g_logger) << "Failed to send aim/fire/chase packet: wrote " << written << " of " << packet_2.size();
-        return false;
+    if (now < next_sync_report_) return;
+    if (next_sync_report_ != TimePoint()) {
+        const ClockSyncEstimate &e = clock_sync_->estimate();
+        const JitterStats d = clock_sync_->delay_stats();
+        CALIBUR_LOG_INFO(g_logger) << "Link delay over " << d.ticks << " pings: p50 " << d.p50_us
+                                   << " us, p99 " << d.p99_us << " us, max " << d.max_us
+                                   << " us; MCU offset " << e.offset << " s, drift "
+                                   << 1e6 * e.drift << " ppm, " << clock_sync_->rejected()
+                                   << " rejected";
     }
+    clock_sync_->reset_delay_stats();
+    next_sync_report_ = now + std::chrono::duration_cast<Clock::duration>(
+                                  std::chrono::duration<double>(USB_CLOCK_SYNC_REPORT_PERIOD));
+#endif
+}
+
+// yaw, pitch, aim, fire, chase as USB_TX_AIM + USB_TX_STATE in one write
+void USBWorker::usb_send_tx(const PredictionOut &out) {
+    if (!link_->attached()) return;
+
+    uint8_t frame[kUsbCommandBytes];
+    const size_t n = usb_encode_command(out.yaw, out.pitch, out.aim, out.fire, out.chase, frame);
+    if (!link_->send(frame, n)) {
+        CALIBUR_LOG_DEBUG(g_logger) << "Command dropped, " << link_->backlog() << " bytes pending";
+        return;
     }
 
     CALIBUR_LOG_DEBUG(g_logger) << "Sent prediction: yaw=" << out.yaw << ", pitch=" << out.pitch
                                 << ", aim=" << out.aim << ", fire=" << out.fire << ", chase=" << out.chase;
-    return true;
-}
\ No newline at end of file
+}
@@ -0,0 +1,36 @@
+// version_signal.hpp
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Wakes a consumer as soon as a producer bumps one of the SharedLatest
+// version counters, instead of the consumer polling on a fixed tick.
+//
+// The counter stays the source of truth: the producer calls notify() after
+// its fetch_add, and wait_for_change() evaluates the counter under the lock,
+// so a bump that lands between the check and the wait is never missed.
+class VersionSignal {
+public:
+    void notify() {
+        { std::lock_guard<std::mutex> lk(m_); }
+        cv_.notify_all();
+    }
+
+    // true once `ver` != `seen`, false if `deadline` passed first
+    template <class C, class Dur>
+    bool wait_for_change(const std::atomic<uint64_t> &ver, uint64_t seen,
+                         const std::chrono::time_point<C, Dur> &deadline) {
+        std::unique_lock<std::mutex> lk(m_);
+        return cv_.wait_until(lk, deadline, [&] {
+            return ver.load(std::memory_order_acquire) != seen;
+        });
+    }
+
+private:
+    std::mutex              m_;
+    std::condition_variable cv_;
+};
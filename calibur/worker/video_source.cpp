@@ -0,0 +1,197 @@
+// calibur/worker/video_source.cpp
+#include "video_source.hpp"
+
+#include <algorithm>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds(Clock::duration d) { return std::chrono::duration<double>(d).count(); }
+
+}  // namespace
+
+VideoSource::VideoSource(std::unique_ptr<VideoDecoder> decoder, const VideoSourceParams &p)
+    : p_(p), dec_(std::move(decoder)), st_(std::make_shared<State>())
+{
+    p_.ahead = std::max(p_.ahead, 1);
+    p_.slots = std::max(p_.slots, p_.ahead + 1);
+
+    double fps = 0.0;
+    if (p_.pacing == VideoPacing::NATIVE) {
+        // containers without a rate report 0 (or a time base)
+        fps = dec_ ? dec_->fps() : 0.0;
+        if (!(fps > 0.0 && fps <= 1000.0)) fps = p_.rate;
+    } else if (p_.pacing == VideoPacing::FIXED) {
+        fps = p_.rate;
+    }
+    period_ = fps > 0.0 ? 1.0 / fps : 0.0;
+}
+
+VideoSource::~VideoSource() {
+    stop();
+}
+
+void VideoSource::start() {
+    if (thread_.joinable()) return;
+    if (!dec_) {
+        std::lock_guard<std::mutex> lk(st_->mtx);
+        st_->finished = true;
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(st_->mtx);
+        st_->stopping = false;
+    }
+    thread_ = std::thread(&VideoSource::decode_loop, this);
+}
+
+void VideoSource::stop() {
+    {
+        std::lock_guard<std::mutex> lk(st_->mtx);
+        st_->stopping = true;
+    }
+    st_->space_cv.notify_all();
+    st_->decoded_cv.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void VideoSource::State::release(Slot *slot) {
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        free.push_back(slot);
+    }
+    space_cv.notify_one();
+}
+
+void VideoSource::decode_loop() {
+    uint64_t index = 0;
+    uint32_t loop  = 0;
+
+    for (;;) {
+        Slot *slot = nullptr;
+        {
+            std::unique_lock<std::mutex> lk(st_->mtx);
+            st_->space_cv.wait(lk, [this] {
+                return st_->stopping ||
+                       (int(st_->queue.size()) < p_.ahead &&
+                        (!st_->free.empty() || int(st_->slots.size()) < p_.slots));
+            });
+            if (st_->stopping) return;
+            if (!st_->free.empty()) {
+                slot = st_->free.back();
+                st_->free.pop_back();
+            } else {
+                st_->slots.push_back(std::make_unique<Slot>());
+                slot = st_->slots.back().get();
+            }
+        }
+
+        const Clock::time_point t0 = Clock::now();
+        bool   ok     = dec_->read(slot->image);
+        double rewind = -1.0;
+        if (!ok && p_.loop) {
+            const Clock::time_point r0 = Clock::now();
+            ok = dec_->rewind();
+            rewind = seconds(Clock::now() - r0);
+            ok = ok && dec_->read(slot->image);
+        }
+        const double dt = seconds(Clock::now() - t0);
+
+        {
+            std::lock_guard<std::mutex> lk(st_->mtx);
+            if (!ok) {
+                st_->free.push_back(slot);
+                st_->finished = true;
+            } else {
+                if (rewind >= 0.0) {
+                    ++loop;
+                    ++stats_.loops;
+                    stats_.rewind_max = std::max(stats_.rewind_max, rewind);
+                }
+                st_->queue.push_back(Decoded{slot, index++, loop, dt});
+                const double decode = dt - std::max(rewind, 0.0);
+                ++stats_.decoded;
+                decode_total_     += decode;
+                stats_.decode_max  = std::max(stats_.decode_max, decode);
+            }
+        }
+        st_->decoded_cv.notify_all();
+        if (!ok) return;
+    }
+}
+
+bool VideoSource::next(VideoFrame &out, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lk(st_->mtx);
+    if (st_->queue.empty()) {
+        ++stats_.starved;
+        st_->decoded_cv.wait_for(lk, timeout, [this] {
+            return !st_->queue.empty() || st_->finished || st_->stopping;
+        });
+        if (st_->queue.empty()) return false;
+    }
+
+    const TimePoint now = Clock::now();
+    TimePoint due       = now;
+    uint32_t  dropped   = 0;
+    if (period_ > 0.0) {
+        auto due_of = [this](uint64_t k) { return origin_ + span(period_ * double(k)); };
+        if (!started_) {
+            started_ = true;
+            origin_  = now - span(period_ * double(st_->queue.front().index));
+        }
+        // the newest frame that is due, as a camera would have it
+        while (st_->queue.size() >= 2 && due_of(st_->queue[1].index) <= now) {
+            st_->free.push_back(st_->queue.front().slot);
+            st_->queue.pop_front();
+            ++dropped;
+        }
+        due = due_of(st_->queue.front().index);
+        if (now - due > span(period_)) {
+            origin_ += now - due;
+            due = now;
+            ++stats_.slips;
+        }
+    }
+
+    const Decoded d = st_->queue.front();
+    st_->queue.pop_front();
+    stats_.dropped += dropped;
+    ++stats_.delivered;
+    lk.unlock();
+    st_->space_cv.notify_one();
+
+    // the lease keeps the state alive, so a frame may outlive the source
+    std::shared_ptr<State> st = st_;
+    const VideoImage &img = d.slot->image;
+    out.data        = img.data.data();
+    out.width       = img.width;
+    out.height      = img.height;
+    out.channels    = img.channels;
+    out.step        = img.step;
+    out.index       = d.index;
+    out.loop        = d.loop;
+    out.dropped     = dropped;
+    out.decode_time = d.decode_time;
+    out.lease       = std::shared_ptr<void>(d.slot, [st](void *s) { st->release(static_cast<Slot *>(s)); });
+
+    if (period_ > 0.0) {
+        std::this_thread::sleep_until(due);
+        out.timestamp = due;
+    } else {
+        out.timestamp = Clock::now();
+    }
+    return true;
+}
+
+bool VideoSource::finished() const {
+    std::lock_guard<std::mutex> lk(st_->mtx);
+    return st_->finished && st_->queue.empty();
+}
+
+VideoSourceStats VideoSource::stats() const {
+    std::lock_guard<std::mutex> lk(st_->mtx);
+    VideoSourceStats s = stats_;
+    s.decode_mean = stats_.decoded > 0 ? decode_total_ / double(stats_.decoded) : 0.0;
+    return s;
+}
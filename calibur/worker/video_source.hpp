@@ -0,0 +1,187 @@
+// calibur/worker/video_source.hpp
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Video file playback standing in for the camera. A decode thread stays
+// `ahead` frames in front of the reader, in a bounded pool of frame
+// buffers; a frame is handed out as a lease on its buffer (no copy) that
+// goes back to the pool when the last holder drops it, as with the SDK
+// buffers of a live camera. Decode cost therefore stays out of the
+// pipeline's latency and shows up only in stats().
+//
+// Pacing of next():
+//  - NATIVE: frame k is due at start + k / fps, the stream's own rate
+//  - MAX:    frames as fast as the reader takes them
+//  - FIXED:  frame k is due at start + k / rate
+// In the clocked modes the source behaves like a camera: a frame whose
+// successor is already due (and decoded) when the reader comes for it is
+// skipped and counted in `dropped`, and a frame is stamped with its due
+// time. When the reader stalls past the frames decoded ahead, or the
+// decoder cannot keep up, the schedule slips (restarts from the frame
+// handed out) instead of running ever later.
+//
+// At the end of the file the decode thread rewinds and carries on, so the
+// loop point costs the reader nothing while the frames ahead cover the
+// seek; frame indices and the schedule run on across it.
+//
+// The decoder sits behind VideoDecoder (OpenCV's VideoCapture via
+// open_video_decoder(), or a synthetic one in tests).
+
+// A decoded frame, 8-bit interleaved
+struct VideoImage {
+    std::vector<uint8_t> data;
+    int         width    = 0;
+    int         height   = 0;
+    int         channels = 3;
+    std::size_t step     = 0;   // bytes per row
+};
+
+class VideoDecoder {
+public:
+    virtual ~VideoDecoder() = default;
+
+    // Native frame rate, 0 if the stream has none.
+    virtual double fps() const = 0;
+
+    // Decodes the next frame into `out`, reusing its storage when the size
+    // matches. False at the end of the stream or on error.
+    virtual bool read(VideoImage &out) = 0;
+
+    // Back to the first frame; false if the stream cannot be restarted.
+    virtual bool rewind() = 0;
+};
+
+// OpenCV decoder for `path`; nullptr if it cannot be opened.
+std::unique_ptr<VideoDecoder> open_video_decoder(const std::string &path);
+
+enum class VideoPacing {
+    NATIVE,
+    MAX,
+    FIXED
+};
+
+struct VideoSourceParams {
+    VideoPacing pacing = VideoPacing::NATIVE;
+    double rate   = 30.0;   // fps for FIXED, and for NATIVE when the stream has none
+    int    ahead  = 3;      // frames decoded in front of the reader
+    int    slots  = 8;      // frame buffers: ahead + frames consumers hold at once
+    bool   loop   = true;   // rewind at the end of the file
+};
+
+// One frame handed to the reader. `data` is valid while `lease` (or a copy
+// of it) is alive.
+struct VideoFrame {
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    const uint8_t *data = nullptr;
+    int         width    = 0;
+    int         height   = 0;
+    int         channels = 3;
+    std::size_t step     = 0;
+    uint64_t    index    = 0;      // frames since start, across loops
+    uint32_t    loop     = 0;      // times the file was rewound before it
+    uint32_t    dropped  = 0;      // due frames skipped since the previous one
+    TimePoint   timestamp;         // due time (clocked pacing), else hand-over
+    double      decode_time = 0.0; // s, decoding it (and the rewind before it)
+    std::shared_ptr<void> lease;
+};
+
+struct VideoSourceStats {
+    uint64_t decoded    = 0;
+    uint64_t delivered  = 0;
+    uint64_t dropped    = 0;     // skipped to stay on schedule
+    uint64_t starved    = 0;     // next() calls that had to wait for the decoder
+    uint64_t slips      = 0;     // schedule moved back because the decoder fell behind
+    uint64_t loops      = 0;
+    double   decode_mean = 0.0;  // s per frame, rewinds aside
+    double   decode_max  = 0.0;  // s
+    double   rewind_max  = 0.0;  // s
+};
+
+class VideoSource {
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    VideoSource(std::unique_ptr<VideoDecoder> decoder, const VideoSourceParams &p = VideoSourceParams());
+    ~VideoSource();
+
+    VideoSource(const VideoSource &) = delete;
+    VideoSource &operator=(const VideoSource &) = delete;
+
+    // Starts the decode thread.
+    void start();
+
+    // Next frame under the pacing, waiting up to `timeout` for the decoder
+    // (a clocked frame is then held until its due time). False on timeout
+    // or once the stream has ended.
+    bool next(VideoFrame &out, std::chrono::milliseconds timeout);
+
+    // Stops and joins the decode thread. Frames already handed out stay
+    // valid.
+    void stop();
+
+    // The decoder failed, or the file ended without loop.
+    bool finished() const;
+
+    // Frame period of the clocked pacings, s (0 for MAX).
+    double period() const { return period_; }
+
+    VideoSourceStats stats() const;
+    const VideoSourceParams &params() const { return p_; }
+
+private:
+    static TimePoint::duration span(double s) {
+        return std::chrono::duration_cast<TimePoint::duration>(std::chrono::duration<double>(s));
+    }
+
+    struct Slot {
+        VideoImage image;
+    };
+
+    struct Decoded {
+        Slot    *slot = nullptr;
+        uint64_t index = 0;
+        uint32_t loop  = 0;
+        double   decode_time = 0.0;
+    };
+
+    // shared with the leases, which may outlive the source
+    struct State {
+        std::mutex              mtx;
+        std::condition_variable decoded_cv;   // decoder -> reader
+        std::condition_variable space_cv;     // reader / leases -> decoder
+        std::vector<std::unique_ptr<Slot>> slots;
+        std::vector<Slot *>     free;
+        std::deque<Decoded>     queue;
+        bool stopping = false;
+        bool finished = false;
+
+        void release(Slot *slot);
+    };
+
+    void decode_loop();
+
+    VideoSourceParams             p_;
+    std::unique_ptr<VideoDecoder> dec_;
+    std::shared_ptr<State>        st_;
+    std::thread                   thread_;
+    double                        period_ = 0.0;
+
+    // reader side: schedule of the clocked pacings
+    bool      started_ = false;
+    TimePoint origin_{};          // due time of frame 0; frame k is due period_ * k later
+
+    // under st_->mtx
+    VideoSourceStats stats_;
+    double           decode_total_ = 0.0;
+};
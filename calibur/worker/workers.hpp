@@ -10,6 +10,19 @@
 
 #include "types.hpp"
 #include "rbpf.cuh"
+#include "oosm.hpp"
+#include "tracker.hpp"
+#include "ballistic.hpp"
+#include "fire_control.hpp"
+#include "command_streamer.hpp"
+#include "gimbal_model.hpp"
+#include "bullet_speed.hpp"
+#include "serial_link.hpp"
+#include "clock_sync.hpp"
+#include "camera_clock.hpp"
+#include "hik_buffers.hpp"
+#include "camera_roi.hpp"
+#include "video_source.hpp"
 #include "infer.h"
 
 
@@ -24,9 +37,22 @@ const std::string VIDEO_PATH        = "./sample_videos/video1.mp4";
 // #define USE_VIDEO_FILE
 #define DISPLAY_DETECTION
 #define PERFORMANCE_BENCHMARK
+#define CAMERA_TICK_HZ                          0.0     // device timestamp ticks per s; 0 detects the power of ten
+#define CAMERA_HANDOVER_LATENCY                 0.003   // s, exposure end to earliest SDK hand-over (readout + USB transfer)
+#define CAMERA_CLOCK_REPORT_PERIOD              5.0     // s between device clock mapping / dropped frame reports
+#define CAMERA_SDK_BUFFERS                      8       // SDK image buffers frames are leased from, [1, 30]
+#define CAMERA_DYNAMIC_ROI                              // read out a window following the locked target; undef for full frame
+#define CAMERA_ROI_RESIZE_WAIT                  50      // ms to wait for consumers to let go of SDK buffers before a resize
+#define CAMERA_BAYER_FORMAT                     PixelType_Gvsp_BayerRG8  // request raw Bayer (1/3 of BGR8 over USB); undef to keep the camera's format
+#define VIDEO_PACING                            VideoPacing::NATIVE      // VIDEO_FILE: NATIVE file fps, MAX as fast as YOLO takes frames, FIXED VIDEO_FIXED_RATE
+#define VIDEO_FIXED_RATE                        30.0    // fps for FIXED pacing, and for NATIVE when the file has none
+#define VIDEO_DECODE_AHEAD                      3       // frames decoded in front of the camera thread
+#define VIDEO_FRAME_SLOTS                       8       // decoded frame buffers: decode ahead + frames consumers hold at once
+#define VIDEO_CONSUMER_WAIT                     100     // ms, MAX pacing: longest wait for YOLO to finish a frame
 
 // ------------- Detection Constants ---------------
 #define YOLO_CONFIDENCE_THRESHOLD               0.5f
+#define YOLO_BAYER_INPUT                                // YOLO uploads Bayer frames (1 B/px) and demosaics them in its CUDA letterbox
 
 #define DEFAULT_ROBOT_RADIUS                    0.2f
 #define DEFAULT_ROBOT_HEIGHT                    0.0f
@@ -34,11 +60,20 @@ const std::string VIDEO_PATH        = "./sample_videos/video1.mp4";
 
 // ------------- PF constants ----------------------
 // #define PF_CONDITIONAL_RESAMPLE                
-static constexpr int NUM_PARTICLES = 10000;
+#define PF_ADAPTIVE_PARTICLES                           // KLD-sampling between PF_MIN_PARTICLES and NUM_PARTICLES
+static constexpr int   NUM_PARTICLES    = 10000;        // capacity (upper bound when adaptive)
+static constexpr int   PF_MIN_PARTICLES = 500;
+static constexpr float PF_KLD_EPSILON   = 0.05f;        // KL bound
+static constexpr float PF_KLD_BIN_POS   = 0.02f;        // meters
+static constexpr float PF_KLD_BIN_YAW   = 0.05f;        // radians
+static constexpr float PF_KLD_BIN_VEL   = 0.10f;        // m/s
+static constexpr TrackerKind PF_TRACKER = TrackerKind::RBPF; // EKF for power/thermal-limited runs
+static constexpr size_t PF_OOSM_BUDGET_BYTES = 16u << 20; // checkpoints for late detections (12 at 10k particles)
+#define PF_PARAMS_YAML                  "config/pf_params.yaml"  // pf_tune output; built-in defaults if missing
+// #define PF_RECORD_DETECTIONS         "pf_detections.csv"      // record validated detections for pf_tune
 
 
 // ------------- Prediction Constants --------------
-#define ALPHA_BULLET_SPEED                      0.1f    // low-pass filter coeff, detemine using cutoff freq formula: alpha = 2πf_c * dt / (2πf_c * dt + 1)
 #define ALPHA_PROCESSING_TIME                   0.1f
 #define PREDICTION_CONVERGENCE_THRESHOLD        0.01f
 #define CHASE_THREASHOLD                        6.0f
@@ -47,6 +82,46 @@ static constexpr int NUM_PARTICLES = 10000;
 #define HEIGHT_TOLERANCE                        0.13f  // meters
 #define TOLERANCE_COEFF                         1.0f
 
+// ------------- Ballistics ------------------------
+#define BALLISTIC_DRAG_K                        0.019f  // 1/m, 0.5*rho*Cd*A/m (17 mm: 3.2 g, Cd 0.47)
+#define BALLISTIC_SPEED_QUANTUM                 0.1f    // m/s, table speed step, rebuilt in the background on drift
+#define BALLISTIC_MAX_DISTANCE                  25.0f   // meters
+#define BALLISTIC_MAX_HEIGHT                    3.0f    // meters, above / below the muzzle
+
+// ------------- Fire control ----------------------
+#define FIRE_HIT_PROBABILITY                            // fire on posterior hit probability, else the tolerance box
+#define FIRE_MIN_HIT_PROB                       0.6f
+#define FIRE_SAMPLES                            256     // posterior samples per decision
+#define FIRE_GUN_SIGMA                          0.003f  // rad, shot dispersion per axis
+
+// ------------- IMU ------------------------------
+#define IMU_DEVICE_PATH                         "/dev/ttyACM0"  // CALIBUR_IMU_DEVICE overrides
+#define IMU_SAMPLE_LATENCY                      0.0     // s, sample instant to first UART byte (datasheet)
+#define IMU_CLOCK_REPORT_PERIOD                 5.0     // s between device clock mapping reports
+
+// ------------- Serial link / bullet speed -------
+#define USB_DEVICE_PATH                         "/dev/ttyUSB0"  // CALIBUR_USB_DEVICE overrides
+#define USB_BAUD_RATE                           115200  // the MCU UART's rate; 8N1 carries USB_BAUD_RATE / 10 bytes/s
+#define USB_REOPEN_PERIOD                       1.0     // s, between reopen attempts after a hang-up
+#define USB_CLOCK_SYNC_PERIOD                   0.05    // s, MCU ping interval; undef to disable clock sync
+#define USB_CLOCK_SYNC_REPORT_PERIOD            5.0     // s, link delay report interval
+#define BULLET_SPEED_WINDOW                     9       // reports per median, per speed mode
+#define BULLET_SPEED_ALPHA                      0.2f    // EWMA weight of the newest median
+#define BULLET_SPEED_MAX_DEV                    1.5f    // m/s, outlier threshold around the median
+#define BULLET_SPEED_DEFAULT                    15.0f   // m/s, until the shooter reports
+
+// ------------- Gimbal dynamics ------------------
+#define GIMBAL_MODEL_YAML                       "config/gimbal_model.yaml"  // from gimbal_identify; defaults if missing
+#define GIMBAL_FEED_FORWARD                             // step-size dependent actuation delay + lag feed-forward
+// #define GIMBAL_RECORD_LOG                    "gimbal_log.csv"            // record command / IMU pairs for gimbal_identify
+
+// ------------- Command streaming ----------------
+#define USB_STREAM_RATE_HZ                      250.0   // fixed-rate setpoints, capped to the link; undef to send once per prediction
+#define USB_STREAM_LINK_SHARE                   0.75    // of the link's bytes/s for setpoints (rest: pings, retries)
+#define USB_STREAM_MAX_EXTRAPOLATION            0.05f   // s, hold the setpoint beyond this age
+#define USB_STREAM_STALE_AFTER                  0.25f   // s, drop aim / fire beyond this age
+#define USB_STREAM_REPORT_PERIOD                5.0     // s, jitter report interval
+
 //--------------------------------------------Camera Worker--------------------------------------------
 
 enum class CameraMode {
@@ -70,13 +145,27 @@ private:
     std::atomic<bool>& stop_;
     CameraMode mode_;
 
-    // Only used for VIDEO_FILE mode
-    cv::VideoCapture cap_;
+    // Only used for VIDEO_FILE mode: decoded ahead on its own thread
+    std::unique_ptr<VideoSource> video_;
     bool use_stub_ = false;
 
+    // HIK_USB: device timestamps -> host capture times, dropped frames
+    CameraClock clock_;
+    double      exposure_s_ = 0.0;    // ExposureTime node, when frames carry no chunk exposure
+    TimePoint   next_report_{};
+
+    // HIK_USB: frames leased from SDK-owned buffers
+    HikBufferPool buffers_;
+
+    // HIK_USB: readout window following the locked target
+    std::unique_ptr<CameraControl> control_;
+    std::unique_ptr<RoiController> roi_;
+
     void grab_frame_stub(CameraFrame& frame);
-    void grab_frame_from_hik(CameraFrame& frame);
-    void grab_frame_from_video(CameraFrame& frame);
+    bool grab_frame_from_hik(CameraFrame& frame);   // false: nothing to publish
+    void control_roi();
+    bool grab_frame_from_video(CameraFrame& frame); // false: nothing to publish
+    void wait_consumed(TimePoint timestamp);
 };
 
 //--------------------------------------------IMU Worker--------------------------------------------
@@ -123,6 +212,8 @@ private:
     std::atomic<bool>&  stop_;
     uint64_t            last_cam_ver_ = 0;
     YoloDetector        detector_;      // <-- persistent member
+
+    std::vector<Detection> detect(CameraFrame& cam);
 };
 
 //--------------------------------------------Detection Worker--------------------------------------------
@@ -168,6 +259,9 @@ private:
 
     void solvepnp_and_yaw(std::vector<DetectionResult> &dets);
 
+    // Box around the selected armors' keypoints, for the camera window
+    void publish_roi_target(const std::vector<DetectionResult> &armors, TimePoint timestamp);
+
     void group_armors(const std::vector<DetectionResult> &dets,
                       std::vector<std::vector<DetectionResult>> &grouped);
 
@@ -184,12 +278,13 @@ private:
 
 
 //--------------------------------------------PF Worker--------------------------------------------
-struct RBPFPosYawModelGPU;
+struct RBPFTelemetry;
 
 class PFWorker {
 public:
     PFWorker(SharedLatest &shared, 
-             std::atomic<bool> &stop_flag);
+             std::atomic<bool> &stop_flag,
+             TrackerKind kind = PF_TRACKER);
 
     // Runs as dedicated thread (not via pool)
     void operator()();
@@ -200,22 +295,36 @@ public:
     PFWorker& operator=(PFWorker&&) = default;
 
 private:
-    static constexpr float kDt = 0.01f;
+    // Event-driven: the filter is stepped when a detection arrives, with dt
+    // taken from RobotState::timestamp. Between detections the last posterior
+    // is extrapolated to "now" and republished every kOutputPeriod.
+    static constexpr auto  kOutputPeriod = std::chrono::milliseconds(10);
+    static constexpr float kMinDt        = 1e-4f;  // duplicate timestamps
+    static constexpr float kMaxCoast     = 0.3f;   // s without detection before giving up
     SharedLatest      &shared_;
     std::atomic<bool> &stop_;
     uint64_t           last_det_ver_ = 0;
-    int frames_without_detection_;  
 
-    // Heap-allocated PF model
-    std::unique_ptr<RBPFPosYawModelGPU> g_pf;
+    TimePoint  filter_time_;     // time the particle set refers to (newest fused detection)
+    RobotState posterior_;       // last posterior mean, at filter_time_
+    bool       have_posterior_ = false;
+
+    // Heap-allocated tracker: GPU RBPF or EKF (tracker.hpp)
+    TrackerKind              kind_;
+    std::unique_ptr<Tracker> tracker_;
+
+    // Late detections are fused at their capture time by rolling back to a
+    // checkpoint and replaying the newer ones (oosm.hpp)
+    OOSMHistory oosm_;
 
-    // PF / CUDA interfaces to implement in .cpp
-    void gpu_pf_init();
-    void gpu_pf_reset(const RobotState &meas);
-    void gpu_pf_predict_only();
-    void gpu_pf_step(const RobotState &meas);
+    // Tracker interfaces to implement in .cpp
+    void tracker_init();
+    void tracker_reset(const RobotState &meas);
+    bool tracker_step(const RobotState &meas);
     bool is_state_valid(const RobotState &state);
-    RobotState gpu_return_result();
+    bool tracker_result(RobotState &out, TimePoint deadline);
+    RBPFTelemetry tracker_telemetry();
+    RobotState predict_to(TimePoint t) const;
 };
 
 
@@ -244,11 +353,18 @@ private:
     float vis_yaw_   = 0.0f;
     float vis_pitch_ = 0.0f;
     bool  vis_init_  = false;
+    TimePoint vis_time_;
+
+    BallisticSolver ballistic_;   // drag table for the current bullet speed
+    FireControl     fire_control_;
+    GimbalModel     gimbal_;
+    float last_raw_yaw_   = 0.0f;   // angular error of the last prediction,
+    float last_raw_pitch_ = 0.0f;   // i.e. the move the gimbal is making
+    float t_link_         = 0.0f;   // host -> MCU delay from clock sync
 
     void sleep_small();
 
     void compute_prediction(const RobotState &rs,
-                            const IMUState *imu,
                             float bullet_speed,
                             float init_yaw,
                             PredictionOut &out);
@@ -258,6 +374,8 @@ private:
 
 //--------------------------------------------Prediction Worker--------------------------------------------
 
+namespace calibur { class USBCommunication; }
+
 class USBWorker {
 public:
     USBWorker(SharedLatest &shared,
@@ -272,8 +390,22 @@ private:
     std::atomic<bool> &stop_;
     uint64_t        last_pred_ver_;
 
-    void process_usb_rx();
+    // shared: the worker is copied into the thread pool
+    std::string                                device_;
+    std::shared_ptr<calibur::USBCommunication> usb_;
+    std::shared_ptr<BulletSpeedRx>             speed_rx_;
+    std::shared_ptr<SerialLink>                link_;
+    TimePoint                                  last_open_try_;
+    std::shared_ptr<ClockSync>                 clock_sync_;
+    TimePoint                                  next_sync_report_;
+    uint64_t                                   stream_skipped_ = 0;   // ticks with the last setpoint still queued
+
+    bool ensure_link();
+    void process_usb_rx(int timeout_ms = 0);
+    void clock_sync_tick();
+    PredictionOut rebase_on_gimbal(const PredictionOut &out, TimePoint t);
     void usb_send_tx(const PredictionOut &out);
+    void record_command(const PredictionOut &out);
 };
 
 //--------------------------------------------Display Worker--------------------------------------------
@@ -15,6 +15,14 @@ YoloWorker::YoloWorker(SharedLatest& shared,
       detector_(engine_path)          // <-- construct member here
 {}
 
+std::vector<Detection> YoloWorker::detect(CameraFrame& cam) {
+#ifdef YOLO_BAYER_INPUT
+    // Bayer frame up at 1 byte per pixel, demosaiced inside the GPU letterbox
+    if (!cam.bayer.empty()) return detector_.inference(cam.bayer, cam.bayer_pattern);
+#endif
+    return detector_.inference(cam.raw_data);
+}
+
 void YoloWorker::operator()() {
     static thread_local std::vector<DetectionResult> dets;
 
@@ -35,14 +43,14 @@ void YoloWorker::operator()() {
 #ifdef PERFORMANCE_BENCHMARK
         auto t0 = std::chrono::high_resolution_clock::now();
 
-        std::vector<Detection> yolo_dets = detector_.inference(cam->raw_data);
+        std::vector<Detection> yolo_dets = detect(*cam);
 
         auto t1 = std::chrono::high_resolution_clock::now();
         double infer_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
 
         // std::cout << "[YOLO] inference time = " << infer_ms << " ms\n";
 #else
-        std::vector<Detection> yolo_dets = detector_.inference(cam->raw_data);
+        std::vector<Detection> yolo_dets = detect(*cam);
 #endif
 
         dets.clear();
@@ -50,6 +58,13 @@ void YoloWorker::operator()() {
         for (const auto& d : yolo_dets) {
             DetectionResult r{};
             parse_detection_result(d, r);
+            // readout window -> full frame, which the intrinsics are for
+            r.bbox.x += cam->roi.x;
+            r.bbox.y += cam->roi.y;
+            for (auto& k : r.keypoints) {
+                k.x += cam->roi.x;
+                k.y += cam->roi.y;
+            }
             dets.emplace_back(r);
         }
 #ifdef DISPLAY_DETECTION
@@ -61,8 +76,8 @@ void YoloWorker::operator()() {
         // ---- 4) publish YOLO output ----
         auto yo = std::make_shared<YoloOutput>();
         yo->dets      = dets;           // or std::move(dets) if you don’t reuse
-        yo->width     = cam->width;
-        yo->height    = cam->height;
+        yo->width     = cam->full_width;
+        yo->height    = cam->full_height;
         yo->timestamp = cam->timestamp;
 
         std::atomic_store(&shared_.yolo, yo);
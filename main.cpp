@@ -79,7 +79,11 @@ int main() {
     });
     pool.submit(YoloWorker(std::ref(shared), std::ref(g_stop_flag), YOLO_MODEL_PATH));
     pool.submit(DetectionWorker(std::ref(shared), std::ref(scalars), std::ref(g_stop_flag)));
-    pool.submit(PredictionWorker(std::ref(shared), std::ref(scalars), std::ref(g_stop_flag)));
+    pool.submit([&shared, &scalars, &g_stop_flag]() {
+        // built in place: owns the ballistic table builder (not movable)
+        PredictionWorker worker(shared, scalars, g_stop_flag);
+        worker();
+    });
     pool.submit(USBWorker(std::ref(shared), std::ref(scalars), std::ref(g_stop_flag)));
     pool.submit([&shared]() {
         DisplayWorker worker(shared, g_stop_flag);
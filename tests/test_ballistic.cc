@@ -0,0 +1,305 @@
+/*
+ * test_ballistic.cc
+ *
+ * Ballistic table with air drag (calibur/worker/ballistic.hpp): direct RK4
+ * integration against the drag-free closed form, table lookups against
+ * direct integration over the whole grid, unreachable targets, background
+ * rebuild on bullet-speed drift, and per-call cost of the lookup against the
+ * solvers it replaces.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O3 -I calibur/worker tests/test_ballistic.cc \
+ *       calibur/worker/ballistic.cpp -pthread -o test_ballistic
+ *
+ * Run:
+ *   ./test_ballistic
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "ballistic.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+using clk = std::chrono::steady_clock;
+
+static double ms_since(clk::time_point t0) {
+    return std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+}
+
+// ---------------------------------------------------------------------------
+
+static void test_integrator() {
+    std::cout << "[ballistic] integrator vs drag-free closed form\n";
+
+    BallisticParams p;
+    p.drag_k = 0.0f;
+    double max_dh = 0.0, max_dt = 0.0;
+    for (float pitch : {-0.3f, 0.0f, 0.1f, 0.4f}) {
+        for (float d : {1.0f, 5.0f, 12.0f, 20.0f}) {
+            const float v = 25.0f;
+            float h, t;
+            if (!ballistic_simulate(v, pitch, d, p, h, t)) continue;
+            const float c = std::cos(pitch);
+            const double h_ref = d * std::tan(pitch) - p.g * d * d / (2.0 * v * v * c * c);
+            const double t_ref = d / (v * c);
+            max_dh = std::max(max_dh, std::fabs(h - h_ref));
+            max_dt = std::max(max_dt, std::fabs(t - t_ref));
+        }
+    }
+    std::printf("  max |dh| %.2e m, max |dt| %.2e s\n", max_dh, max_dt);
+    EXPECT_TRUE(max_dh < 1e-4);
+    EXPECT_TRUE(max_dt < 1e-5);
+
+    // solve inverts simulate, and agrees with the vacuum solution at k = 0
+    BallisticSolution s, sv;
+    EXPECT_TRUE(ballistic_solve(25.0f, 10.0f, 0.5f, p, s));
+    EXPECT_TRUE(ballistic_solve_vacuum(25.0f, 10.0f, 0.5f, p.g, sv));
+    EXPECT_TRUE(std::fabs(s.pitch - sv.pitch) < 2e-5f);
+    EXPECT_TRUE(std::fabs(s.time - sv.time) < 1e-5f);
+
+    // drag: same shot needs more elevation and takes longer
+    BallisticParams pd;
+    BallisticSolution sd;
+    EXPECT_TRUE(ballistic_solve(25.0f, 20.0f, 0.0f, pd, sd));
+    EXPECT_TRUE(ballistic_solve_vacuum(25.0f, 20.0f, 0.0f, pd.g, sv));
+    std::printf("  20 m @ 25 m/s: pitch %.2f mrad (vacuum %.2f), time %.1f ms (vacuum %.1f)\n",
+                1e3 * sd.pitch, 1e3 * sv.pitch, 1e3 * sd.time, 1e3 * sv.time);
+    EXPECT_TRUE(sd.pitch > sv.pitch + 0.01f);
+    EXPECT_TRUE(sd.time > sv.time + 0.05f);
+    float h, t;
+    EXPECT_TRUE(ballistic_simulate(25.0f, sd.pitch, 20.0f, pd, h, t));
+    EXPECT_TRUE(std::fabs(h) < 1e-4f);
+
+    // out of range
+    EXPECT_TRUE(!ballistic_solve(10.0f, 24.0f, 2.5f, pd, s));
+}
+
+static void test_table_accuracy() {
+    std::cout << "[ballistic] table vs direct integration\n";
+
+    const BallisticParams p;
+    for (float v : {15.0f, 25.0f}) {
+        const auto t0 = clk::now();
+        const BallisticTable table(v, p);
+        const double build_ms = ms_since(t0);
+
+        // random points over the grid against the shooting-method solution
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> ud(p.d_min, p.d_max), uh(p.h_min, p.h_max);
+        std::vector<double> miss_v, dt_v;
+        int n = 0, agree = 0, disagree = 0;
+        for (int k = 0; k < 1500; ++k) {
+            const float d = ud(rng), h = uh(rng);
+            BallisticSolution ref, got;
+            const bool ok_ref = ballistic_solve(v, d, h, p, ref);
+            const bool ok_tab = table.lookup(d, h, got);
+            if (ok_ref != ok_tab) {
+                // only allowed right at the edge of the reachable region
+                BallisticSolution probe;
+                const bool near_edge = table.lookup(d, h - 3 * p.h_step, probe) !=
+                                       table.lookup(d, h + 3 * p.h_step, probe) ||
+                                       ballistic_solve(v, d, h + 3 * p.h_step, p, probe) != ok_ref;
+                disagree += !near_edge;
+                continue;
+            }
+            ++agree;
+            if (!ok_ref) continue;
+            // miss: where the tabulated pitch actually lands at distance d
+            float h_hit, t_hit;
+            if (!ballistic_simulate(v, got.pitch, d, p, h_hit, t_hit)) h_hit = -1e3f;
+            miss_v.push_back(std::fabs(h_hit - h));
+            dt_v.push_back(std::fabs(got.time - ref.time));
+            ++n;
+        }
+        // the worst cells sit just under the apex of lofted max-range shots,
+        // where h(pitch) is flat and the inversion is ill-conditioned
+        std::sort(miss_v.begin(), miss_v.end());
+        std::sort(dt_v.begin(), dt_v.end());
+        const size_t p99 = miss_v.size() * 99 / 100;
+        std::printf("  %4.1f m/s: build %.1f ms, %zu KB, %d reachable of %d, "
+                    "miss p99 %.2f / max %.2f mm, |dt| p99 %.3f / max %.3f ms\n",
+                    v, build_ms, table.bytes() / 1024, n, agree,
+                    1e3 * miss_v[p99], 1e3 * miss_v.back(), 1e3 * dt_v[p99], 1e3 * dt_v.back());
+        EXPECT_TRUE(n > 500);
+        EXPECT_TRUE(disagree == 0);
+        EXPECT_TRUE(miss_v[p99] < 1e-3);      // mm at the target
+        EXPECT_TRUE(miss_v.back() < 5e-3);
+        EXPECT_TRUE(dt_v[p99] < 3e-4);
+        EXPECT_TRUE(dt_v.back() < 3e-3);
+    }
+
+    // outside the grid / unreachable
+    const BallisticTable table(12.0f, p);
+    BallisticSolution s;
+    EXPECT_TRUE(!table.lookup(p.d_min - 0.1f, 0.0f, s));
+    EXPECT_TRUE(!table.lookup(p.d_max + 0.1f, 0.0f, s));
+    EXPECT_TRUE(!table.lookup(5.0f, p.h_max + 0.1f, s));
+    EXPECT_TRUE(!table.lookup(NAN, 0.0f, s));
+    EXPECT_TRUE(!table.lookup(24.0f, 2.9f, s));        // too high that far at 12 m/s
+    EXPECT_TRUE(table.lookup(1.0f, -0.5f, s) && s.pitch < 0.0f);
+    EXPECT_TRUE(table.lookup(5.0f, 0.0f, s) && s.pitch > 0.0f);
+}
+
+static void test_solver_rebuild() {
+    std::cout << "[ballistic] background rebuild\n";
+
+    BallisticParams p;
+    BallisticSolver solver(p, 15.0f, 0.1f, 2);
+    EXPECT_TRUE(solver.builds() == 1);
+    EXPECT_TRUE(std::fabs(solver.table()->speed() - 15.0f) < 1e-4f);
+
+    // within hysteresis: nothing happens
+    solver.update_speed(15.06f);
+    EXPECT_TRUE(!solver.rebuilding() && solver.builds() == 1);
+
+    // drift: lookups keep answering from the old table during the build
+    BallisticSolution before, during, after;
+    EXPECT_TRUE(solver.lookup(10.0f, 0.0f, before));
+    const auto t0 = clk::now();
+    solver.update_speed(16.23f);
+    const double call_ms = ms_since(t0);
+    int lookups = 0;
+    while (solver.rebuilding() && ms_since(t0) < 5000.0) {
+        lookups += solver.lookup(10.0f, 0.0f, during);
+        std::this_thread::yield();
+    }
+    const double rebuild_ms = ms_since(t0);
+    std::printf("  update_speed %.3f ms, rebuild done after %.1f ms, %d lookups meanwhile\n",
+                call_ms, rebuild_ms, lookups);
+    EXPECT_TRUE(call_ms < 0.2 * rebuild_ms);
+    EXPECT_TRUE(!solver.rebuilding());
+    EXPECT_TRUE(std::fabs(solver.table()->speed() - 16.2f) < 1e-4f);
+    EXPECT_TRUE(solver.builds() == 2);
+    EXPECT_TRUE(solver.lookup(10.0f, 0.0f, after));
+    EXPECT_TRUE(after.pitch < before.pitch && after.time < before.time);
+
+    // back to a cached speed: swapped in without a build
+    solver.update_speed(15.0f);
+    EXPECT_TRUE(!solver.rebuilding() && solver.builds() == 2);
+    EXPECT_TRUE(std::fabs(solver.table()->speed() - 15.0f) < 1e-4f);
+
+    // a burst of drifting updates coalesces into few builds, ends on the last
+    for (int k = 0; k <= 48; ++k) solver.update_speed(20.0f + 0.05f * k);
+    while (solver.rebuilding()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::printf("  49 drifting updates -> %d builds\n", solver.builds() - 2);
+    EXPECT_TRUE(solver.builds() - 2 < 10);
+    EXPECT_TRUE(std::fabs(solver.table()->speed() - 22.4f) < 1e-4f);
+
+    // garbage speeds are ignored
+    solver.update_speed(NAN);
+    solver.update_speed(0.0f);
+    EXPECT_TRUE(std::fabs(solver.table()->speed() - 22.4f) < 1e-4f);
+}
+
+// ---------------------------------------------------------------------------
+// Microbenchmark
+
+// The lead loop PredictionWorker used before: flight time = range / speed,
+// drop = g t^2 / 2, iterated on a moving target.
+static float vacuum_iterative(float x, float y, float z, float vx, float vz, float speed,
+                              float &pitch) {
+    float t = std::sqrt(x * x + y * y + z * z) / speed;
+    for (int it = 0; it < 10; ++it) {
+        const float px = x + vx * t, pz = z + vz * t;
+        const float tn = std::sqrt(px * px + y * y + pz * pz) / speed;
+        const bool done = std::fabs(tn - t) < 0.01f;
+        t = tn;
+        if (done) break;
+    }
+    const float px = x + vx * t, pz = z + vz * t;
+    pitch = std::atan2(y + 0.5f * 9.81f * t * t, std::sqrt(px * px + pz * pz));
+    return t;
+}
+
+static void bench_lookup() {
+    std::cout << "[ballistic] benchmark\n";
+
+    const BallisticParams p;
+    const BallisticTable table(25.0f, p);
+
+    constexpr int N = 1 << 16;
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<float> ud(1.0f, 20.0f), uh(-1.0f, 1.0f);
+    std::vector<float> ds(N), hs(N);
+    for (int k = 0; k < N; ++k) { ds[k] = ud(rng); hs[k] = uh(rng); }
+
+    constexpr int REPS = 40;
+    volatile float sink = 0.0f;
+
+    auto t0 = clk::now();
+    float acc = 0.0f;
+    for (int r = 0; r < REPS; ++r)
+        for (int k = 0; k < N; ++k) {
+            BallisticSolution s;
+            if (table.lookup(ds[k], hs[k], s)) acc += s.pitch + s.time;
+        }
+    const double ns_lookup = 1e6 * ms_since(t0) / (double(REPS) * N);
+    sink = acc;
+
+    t0 = clk::now();
+    acc = 0.0f;
+    for (int r = 0; r < REPS; ++r)
+        for (int k = 0; k < N; ++k) {
+            BallisticSolution s;
+            if (ballistic_solve_vacuum(25.0f, ds[k], hs[k], 9.81f, s)) acc += s.pitch + s.time;
+        }
+    const double ns_vacuum = 1e6 * ms_since(t0) / (double(REPS) * N);
+    sink = acc;
+
+    t0 = clk::now();
+    acc = 0.0f;
+    for (int r = 0; r < REPS; ++r)
+        for (int k = 0; k < N; ++k) {
+            float pitch;
+            acc += vacuum_iterative(0.3f, hs[k], ds[k], 1.0f, -0.5f, 25.0f, pitch) + pitch;
+        }
+    const double ns_iter = 1e6 * ms_since(t0) / (double(REPS) * N);
+    sink = acc;
+
+    constexpr int NREF = 200;
+    t0 = clk::now();
+    for (int k = 0; k < NREF; ++k) {
+        BallisticSolution s;
+        if (ballistic_solve(25.0f, ds[k], hs[k], p, s)) acc += s.pitch;
+    }
+    const double us_direct = 1e3 * ms_since(t0) / NREF;
+    sink = acc;
+    (void)sink;
+
+    std::printf("  table lookup (bilinear)      %7.1f ns/call\n", ns_lookup);
+    std::printf("  drag-free closed form        %7.1f ns/call\n", ns_vacuum);
+    std::printf("  drag-free lead iteration     %7.1f ns/call (old PredictionWorker model)\n", ns_iter);
+    std::printf("  drag, direct shooting        %7.1f us/call\n", us_direct);
+    EXPECT_TRUE(ns_lookup < 100.0);
+}
+
+int main() {
+    test_integrator();
+    test_table_accuracy();
+    test_solver_rebuild();
+    bench_lookup();
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all ballistic tests passed\n";
+    return 0;
+}
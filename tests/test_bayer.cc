@@ -0,0 +1,362 @@
+/*
+ * test_bayer.cc
+ *
+ * Bayer demosaic and the fused Bayer -> letterboxed tensor path
+ * (calibur/pose/include/bayer.h). bayer_to_bgr is checked bit-exact
+ * against a plain per-pixel bilinear reference for both patterns, odd
+ * sizes and padded strides, and for accuracy on a smooth scene;
+ * BayerLetterbox against demosaic + a reference INTER_LINEAR resize, and
+ * the per-pixel form the CUDA preprocess runs (bayer_letterbox_pixel)
+ * against BayerLetterbox. When
+ * OpenCV is available both are also compared with cv::cvtColor and
+ * cv::resize. Benchmarks at 1080x1080.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 -I . -I calibur/pose/include tests/test_bayer.cc calibur/pose/src/bayer.cpp \
+ *       -o test_bayer
+ *   (add `pkg-config --cflags --libs opencv4` for the OpenCV comparisons)
+ *
+ * Run:
+ *   ./test_bayer
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "calibur/pose/include/bayer.h"
+
+#if __has_include(<opencv2/imgproc.hpp>)
+#include <opencv2/imgproc.hpp>
+#define HAVE_OPENCV 1
+#endif
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+using SteadyClock = std::chrono::steady_clock;
+
+// ---------------------------------------------------------------------------
+// Reference implementation, one pixel at a time from the colour layout.
+
+enum { CH_B = 0, CH_G = 1, CH_R = 2 };
+
+static int site_colour(BayerPattern p, int x, int y) {
+    const int first = p == BayerPattern::RG ? CH_R : CH_B;
+    const int second = first == CH_R ? CH_B : CH_R;
+    if ((x & 1) == 0 && (y & 1) == 0) return first;
+    if ((x & 1) == 1 && (y & 1) == 1) return second;
+    return CH_G;
+}
+
+static std::vector<uint8_t> ref_demosaic(const std::vector<uint8_t>& src, size_t stride, int w, int h,
+                                         BayerPattern p) {
+    std::vector<uint8_t> out(size_t(w) * h * 3);
+    auto at = [&](int x, int y) { return int(src[y * stride + x]); };
+    for (int y = 1; y < h - 1; ++y) {
+        for (int x = 1; x < w - 1; ++x) {
+            const int own = site_colour(p, x, y);
+            for (int ch = 0; ch < 3; ++ch) {
+                int v;
+                if (ch == own) v = at(x, y);
+                else if (ch == CH_G) v = (at(x - 1, y) + at(x + 1, y) + at(x, y - 1) + at(x, y + 1) + 2) >> 2;
+                else if (own == CH_G && site_colour(p, x - 1, y) == ch) v = (at(x - 1, y) + at(x + 1, y) + 1) >> 1;
+                else if (own == CH_G) v = (at(x, y - 1) + at(x, y + 1) + 1) >> 1;
+                else v = (at(x - 1, y - 1) + at(x + 1, y - 1) + at(x - 1, y + 1) + at(x + 1, y + 1) + 2) >> 2;
+                out[(size_t(y) * w + x) * 3 + ch] = uint8_t(v);
+            }
+        }
+        for (int ch = 0; ch < 3; ++ch) {
+            out[(size_t(y) * w) * 3 + ch] = out[(size_t(y) * w + 1) * 3 + ch];
+            out[(size_t(y) * w + w - 1) * 3 + ch] = out[(size_t(y) * w + w - 2) * 3 + ch];
+        }
+    }
+    std::copy_n(out.begin() + size_t(w) * 3, size_t(w) * 3, out.begin());
+    std::copy_n(out.begin() + size_t(h - 2) * w * 3, size_t(w) * 3, out.begin() + size_t(h - 1) * w * 3);
+    return out;
+}
+
+// cv::resize INTER_LINEAR on one channel of interleaved BGR, then letterbox
+// into planar RGB / 255 with 128 / 255 padding
+static std::vector<float> ref_letterbox(const std::vector<uint8_t>& bgr, int w, int h, int dstW, int dstH) {
+    const LetterboxRect r = letterbox_rect(w, h, dstW, dstH);
+    std::vector<float> out(size_t(3) * dstW * dstH, 128.0f / 255.0f);
+    auto coord = [](int i, int srcN, int dstN, int& i0, double& f) {
+        const double s = (i + 0.5) * double(srcN) / dstN - 0.5;
+        i0 = int(std::floor(s));
+        f = s - i0;
+        if (i0 < 0) { i0 = 0; f = 0.0; }
+        if (i0 >= srcN - 1) { i0 = srcN - 1; f = 0.0; }
+    };
+    for (int oy = 0; oy < r.h; ++oy) {
+        int y0; double fy;
+        coord(oy, h, r.h, y0, fy);
+        const int y1 = std::min(y0 + 1, h - 1);
+        for (int ox = 0; ox < r.w; ++ox) {
+            int x0; double fx;
+            coord(ox, w, r.w, x0, fx);
+            const int x1 = std::min(x0 + 1, w - 1);
+            for (int c = 0; c < 3; ++c) {
+                const int ch = 2 - c;   // R plane first
+                auto px = [&](int x, int y) { return double(bgr[(size_t(y) * w + x) * 3 + ch]); };
+                const double top = px(x0, y0) + fx * (px(x1, y0) - px(x0, y0));
+                const double bot = px(x0, y1) + fx * (px(x1, y1) - px(x0, y1));
+                out[size_t(c) * dstW * dstH + size_t(r.y + oy) * dstW + r.x + ox] = float((top + fy * (bot - top)) / 255.0);
+            }
+        }
+    }
+    return out;
+}
+
+static std::vector<uint8_t> random_mosaic(int h, size_t stride, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> m(stride * h);
+    for (auto& v : m) v = uint8_t(rng());
+    return m;
+}
+
+// Smooth scene (gradients and a soft blob), its mosaic and its BGR truth
+static void smooth_scene(int w, int h, BayerPattern p, std::vector<uint8_t>& mosaic, std::vector<uint8_t>& truth) {
+    mosaic.assign(size_t(w) * h, 0);
+    truth.assign(size_t(w) * h * 3, 0);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            const double u = double(x) / w, v = double(y) / h;
+            const double blob = std::exp(-((u - 0.5) * (u - 0.5) + (v - 0.4) * (v - 0.4)) * 12.0);
+            const double bgr[3] = {40 + 150 * v, 60 + 120 * blob, 30 + 180 * u};
+            for (int ch = 0; ch < 3; ++ch) truth[(size_t(y) * w + x) * 3 + ch] = uint8_t(std::lround(bgr[ch]));
+            mosaic[size_t(y) * w + x] = truth[(size_t(y) * w + x) * 3 + site_colour(p, x, y)];
+        }
+    }
+}
+
+static const char* name(BayerPattern p) { return p == BayerPattern::RG ? "RG" : "BG"; }
+
+// ---------------------------------------------------------------------------
+
+static void test_exact() {
+    std::cout << "[bayer] bit-exact against the reference (sizes, strides, patterns)\n";
+    const int sizes[][2] = {{3, 3}, {4, 5}, {17, 9}, {18, 18}, {33, 7}, {35, 36}, {64, 48}, {101, 77}, {1080, 16}};
+    for (BayerPattern p : {BayerPattern::RG, BayerPattern::BG}) {
+        for (const auto& s : sizes) {
+            const int w = s[0], h = s[1];
+            for (size_t pad : {size_t(0), size_t(13)}) {
+                const size_t stride = w + pad, dstStride = 3 * w + pad;
+                const auto src = random_mosaic(h, stride, uint32_t(w * 131 + h + pad));
+                std::vector<uint8_t> dst(dstStride * h, 0xAB);
+                EXPECT_TRUE(bayer_to_bgr(src.data(), stride, w, h, p, dst.data(), dstStride));
+                const auto ref = ref_demosaic(src, stride, w, h, p);
+                int bad = 0;
+                for (int y = 0; y < h; ++y)
+                    for (int x = 0; x < 3 * w; ++x)
+                        bad += dst[y * dstStride + x] != ref[size_t(y) * w * 3 + x];
+                if (bad) std::printf("  %s %dx%d stride +%zu: %d bytes differ\n", name(p), w, h, pad, bad);
+                EXPECT_TRUE(bad == 0);
+                // row padding untouched
+                if (pad) EXPECT_TRUE(dst[dstStride - 1] == 0xAB);
+            }
+        }
+    }
+    std::vector<uint8_t> tiny(4), out(12);
+    EXPECT_TRUE(!bayer_to_bgr(tiny.data(), 2, 2, 2, BayerPattern::RG, out.data(), 6));
+}
+
+static void test_smooth_accuracy() {
+    std::cout << "[bayer] reconstruction error on a smooth scene\n";
+    const int w = 320, h = 240;
+    for (BayerPattern p : {BayerPattern::RG, BayerPattern::BG}) {
+        std::vector<uint8_t> mosaic, truth, out(size_t(w) * h * 3);
+        smooth_scene(w, h, p, mosaic, truth);
+        bayer_to_bgr(mosaic.data(), w, w, h, p, out.data(), 3 * size_t(w));
+        double sum = 0.0;
+        int worst = 0;
+        for (int y = 2; y < h - 2; ++y)
+            for (int x = 2 * 3; x < (w - 2) * 3; ++x) {
+                const int d = std::abs(int(out[size_t(y) * w * 3 + x]) - int(truth[size_t(y) * w * 3 + x]));
+                sum += d;
+                worst = std::max(worst, d);
+            }
+        const double mean = sum / (double(h - 4) * (w - 4) * 3);
+        std::printf("  %s mean |err| %.3f, max %d\n", name(p), mean, worst);
+        EXPECT_TRUE(mean < 0.6 && worst <= 3);
+    }
+}
+
+static void test_letterbox() {
+    std::cout << "[bayer] fused letterbox against demosaic + reference resize\n";
+    const int cases[][4] = {{1440, 1080, 640, 640}, {1080, 1440, 640, 640}, {1080, 1080, 640, 640},
+                            {333, 201, 160, 96}, {64, 64, 128, 128}, {50, 300, 64, 64}};
+    for (BayerPattern p : {BayerPattern::RG, BayerPattern::BG}) {
+        for (const auto& c : cases) {
+            const int w = c[0], h = c[1], dw = c[2], dh = c[3];
+            const size_t stride = w + 8;
+            const auto src = random_mosaic(h, stride, uint32_t(w + 7 * h));
+            std::vector<uint8_t> bgr(size_t(w) * h * 3);
+            bayer_to_bgr(src.data(), stride, w, h, p, bgr.data(), 3 * size_t(w));
+            const auto ref = ref_letterbox(bgr, w, h, dw, dh);
+
+            BayerLetterbox lb(dw, dh);
+            std::vector<float> out(ref.size(), -1.0f);
+            // twice: the second run reuses the tables
+            for (int k = 0; k < 2; ++k) EXPECT_TRUE(lb.run(src.data(), stride, w, h, p, out.data()));
+            double worst = 0.0;
+            for (size_t i = 0; i < ref.size(); ++i) worst = std::max(worst, double(std::fabs(out[i] - ref[i])));
+            if (worst > 1e-4) std::printf("  %s %dx%d -> %dx%d: max diff %.2e\n", name(p), w, h, dw, dh, worst);
+            EXPECT_TRUE(worst <= 1e-4);
+
+            const LetterboxRect r = lb.rect();
+            EXPECT_TRUE(r.w <= dw && r.h <= dh && (r.w == dw || r.h == dh));
+            EXPECT_TRUE(out[0] == 128.0f / 255.0f || (r.x == 0 && r.y == 0));
+        }
+    }
+    // another size on the same object rebuilds the tables
+    BayerLetterbox lb(64, 64);
+    const auto a = random_mosaic(50, 100, 1), b = random_mosaic(80, 40, 2);
+    std::vector<float> out(3 * 64 * 64);
+    lb.run(a.data(), 100, 100, 50, BayerPattern::RG, out.data());
+    lb.run(b.data(), 40, 40, 80, BayerPattern::RG, out.data());
+    EXPECT_TRUE(lb.rect().h == 64 && lb.rect().w == 32 && lb.rect().x == 16);
+}
+
+// bayer_letterbox_pixel is what each thread of preprocess_bayer() computes;
+// over the whole input it must give BayerLetterbox's tensor.
+static void test_letterbox_pixel() {
+    std::cout << "[bayer] per-pixel letterbox (CUDA kernel body) against BayerLetterbox\n";
+    const int cases[][4] = {{1440, 1080, 640, 640}, {1080, 1440, 640, 640}, {333, 201, 160, 96},
+                            {64, 64, 128, 128}, {50, 300, 64, 64}};
+    for (BayerPattern p : {BayerPattern::RG, BayerPattern::BG}) {
+        for (const auto& c : cases) {
+            const int w = c[0], h = c[1], dw = c[2], dh = c[3];
+            const size_t stride = w + 8;
+            const auto src = random_mosaic(h, stride, uint32_t(3 * w + h));
+
+            BayerLetterbox lb(dw, dh);
+            const size_t plane = size_t(dw) * dh;
+            std::vector<float> ref(3 * plane);
+            lb.run(src.data(), stride, w, h, p, ref.data());
+
+            const LetterboxRect r = letterbox_rect(w, h, dw, dh);
+            double worst = 0.0;
+            for (int oy = 0; oy < dh; ++oy) {
+                for (int ox = 0; ox < dw; ++ox) {
+                    float rgb[3];
+                    bayer_letterbox_pixel(src.data(), stride, w, h, p, r, ox, oy, rgb);
+                    for (int k = 0; k < 3; ++k) {
+                        const size_t i = k * plane + size_t(oy) * dw + ox;
+                        worst = std::max(worst, double(std::fabs(rgb[k] - ref[i])));
+                    }
+                }
+            }
+            if (worst > 1e-6) std::printf("  %s %dx%d -> %dx%d: max diff %.2e\n", name(p), w, h, dw, dh, worst);
+            EXPECT_TRUE(worst <= 1e-6);
+        }
+    }
+}
+
+#ifdef HAVE_OPENCV
+static void test_opencv() {
+    std::cout << "[bayer] against cv::cvtColor / cv::resize\n";
+    const int w = 1440, h = 1080;
+    for (BayerPattern p : {BayerPattern::RG, BayerPattern::BG}) {
+        const auto src = random_mosaic(h, w, 99);
+        cv::Mat bayer(h, w, CV_8UC1, const_cast<uint8_t*>(src.data()));
+        cv::Mat cv_bgr, ours(h, w, CV_8UC3);
+        cv::cvtColor(bayer, cv_bgr, p == BayerPattern::RG ? cv::COLOR_BayerBG2BGR : cv::COLOR_BayerRG2BGR);
+        bayer_to_bgr(src.data(), w, w, h, p, ours.data, ours.step);
+        double worst = 0.0;
+        cv::minMaxLoc(cv::abs(cv_bgr(cv::Rect(1, 1, w - 2, h - 2)) - ours(cv::Rect(1, 1, w - 2, h - 2))), nullptr,
+                      &worst);
+        std::printf("  %s cvtColor max diff %.0f\n", name(p), worst);
+        EXPECT_TRUE(worst <= 1.0);
+
+        const LetterboxRect r = letterbox_rect(w, h, 640, 640);
+        cv::Mat resized, rgb, f;
+        cv::resize(cv_bgr, resized, cv::Size(r.w, r.h), 0, 0, cv::INTER_LINEAR);
+        cv::cvtColor(resized, rgb, cv::COLOR_BGR2RGB);
+        BayerLetterbox lb(640, 640);
+        std::vector<float> out(3 * 640 * 640);
+        lb.run(src.data(), w, w, h, p, out.data());
+        double rworst = 0.0;
+        for (int y = 0; y < r.h; ++y)
+            for (int x = 0; x < r.w; ++x)
+                for (int c = 0; c < 3; ++c)
+                    rworst = std::max(rworst, std::fabs(out[size_t(c) * 640 * 640 + size_t(r.y + y) * 640 + r.x + x] * 255.0 -
+                                                        rgb.at<cv::Vec3b>(y, x)[c]));
+        std::printf("  %s letterbox vs cv::resize max diff %.2f / 255\n", name(p), rworst);
+        EXPECT_TRUE(rworst <= 2.0);
+    }
+}
+#endif
+
+static void bench() {
+    std::cout << "[bayer] 1080x1080 timings\n";
+    const int w = 1080, h = 1080, n = 20;
+    const auto src = random_mosaic(h, w, 5);
+    std::vector<uint8_t> bgr(size_t(w) * h * 3);
+    std::vector<float> tensor(3 * 640 * 640);
+    BayerLetterbox lb(640, 640);
+    uint64_t sink = 0;
+
+    auto time_us = [&](auto&& fn) {
+        fn();
+        const auto t0 = SteadyClock::now();
+        for (int i = 0; i < n; ++i) fn();
+        return std::chrono::duration<double, std::micro>(SteadyClock::now() - t0).count() / n;
+    };
+    const double ref_us = time_us([&] { sink += ref_demosaic(src, w, w, h, BayerPattern::RG)[w * 3 + 5]; });
+    const double simd_us = time_us([&] {
+        bayer_to_bgr(src.data(), w, w, h, BayerPattern::RG, bgr.data(), 3 * size_t(w));
+        sink += bgr[w * 3 + 5];
+    });
+    const double two_us = time_us([&] {
+        bayer_to_bgr(src.data(), w, w, h, BayerPattern::RG, bgr.data(), 3 * size_t(w));
+        sink += size_t(ref_letterbox(bgr, w, h, 640, 640)[1000] * 255.0f);
+    });
+    const double fused_us = time_us([&] {
+        lb.run(src.data(), w, w, h, BayerPattern::RG, tensor.data());
+        sink += size_t(tensor[1000] * 255.0f);
+    });
+    std::printf("  demosaic: reference %.0f us, bayer_to_bgr %.0f us (%.1fx)\n", ref_us, simd_us, ref_us / simd_us);
+    std::printf("  to 640x640 tensor: demosaic + resize %.0f us, fused %.0f us\n", two_us, fused_us);
+#ifdef HAVE_OPENCV
+    cv::Mat bayer(h, w, CV_8UC1, const_cast<uint8_t*>(src.data())), cv_bgr;
+    const double cv_us = time_us([&] {
+        cv::cvtColor(bayer, cv_bgr, cv::COLOR_BayerBG2BGR);
+        sink += cv_bgr.data[5];
+    });
+    std::printf("  cv::cvtColor %.0f us\n", cv_us);
+#endif
+    std::printf("  (sink %llu)\n", (unsigned long long)sink);
+    EXPECT_TRUE(simd_us < ref_us);
+    EXPECT_TRUE(fused_us < two_us);
+}
+
+int main() {
+    test_exact();
+    test_smooth_accuracy();
+    test_letterbox();
+    test_letterbox_pixel();
+#ifdef HAVE_OPENCV
+    test_opencv();
+#endif
+    bench();
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all bayer tests passed\n";
+    return 0;
+}
@@ -0,0 +1,299 @@
+/*
+ * test_bullet_speed.cc
+ *
+ * Bullet-speed feedback (calibur/worker/bullet_speed.hpp, usb_protocol.hpp):
+ * frame parsing with garbage / corruption / split reads, the median + EWMA
+ * estimator against outliers, speed steps and mode switches, and the whole
+ * RX path against a stand-in MCU on a pseudo-terminal.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 -pthread -I . -I calibur -I calibur/worker -I apps/yaml-cpp/include \
+ *       tests/test_bullet_speed.cc calibur/worker/bullet_speed.cpp \
+ *       calibur/usb_communication.cpp calibur/log.cpp calibur/config.cc calibur/util.cpp \
+ *       apps/yaml-cpp/lib/libyaml-cpp.a -lutil -o test_bullet_speed
+ *
+ * Run:
+ *   ./test_bullet_speed
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <pty.h>
+#include <random>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "bullet_speed.hpp"
+#include "usb_protocol.hpp"
+#include "calibur/usb_communication.h"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+static void append_shooter(std::vector<uint8_t> &out, float speed, uint8_t mode) {
+    uint8_t payload[kUsbShooterLen];
+    std::memcpy(payload, &speed, 4);
+    payload[4] = mode;
+    uint8_t frame[kUsbShooterLen + kUsbFrameExtra];
+    const size_t n = usb_encode_frame(USB_RX_SHOOTER, payload, kUsbShooterLen, frame);
+    out.insert(out.end(), frame, frame + n);
+}
+
+// ---------------------------------------------------------------------------
+
+static void test_parser() {
+    std::cout << "[speed] frame parser\n";
+    std::mt19937 rng(5);
+    std::vector<uint8_t> stream;
+    std::vector<float> sent;
+
+    for (int i = 0; i < 300; ++i) {
+        const float v = 10.0f + 0.01f * i;
+        switch (i % 6) {
+        case 0:   // line noise, including stray headers
+            for (int k = 0; k < 7; ++k) stream.push_back(k == 3 ? kUsbHeader : uint8_t(rng()));
+            break;
+        case 1: { // corrupted frame: dropped, must not eat the next one
+            std::vector<uint8_t> bad;
+            append_shooter(bad, 99.0f, 0);
+            bad[5] ^= 0x40;
+            stream.insert(stream.end(), bad.begin(), bad.end());
+            break;
+        }
+        case 2: { // other frame type in between
+            const float aim[2] = {0.1f, -0.2f};
+            uint8_t f[16];
+            const size_t n = usb_encode_frame(USB_TX_AIM, aim, 8, f);
+            stream.insert(stream.end(), f, f + n);
+            break;
+        }
+        case 3:   // header + absurd length
+            stream.push_back(kUsbHeader); stream.push_back(0xFF); stream.push_back(0x7F);
+            break;
+        default:
+            break;
+        }
+        append_shooter(stream, v, uint8_t(i % 3));
+        sent.push_back(v);
+    }
+
+    // same stream in random-size reads
+    UsbFrameParser parser;
+    std::vector<float> got;
+    std::vector<int> modes;
+    int others = 0;
+    size_t pos = 0;
+    while (pos < stream.size()) {
+        const size_t n = std::min<size_t>(stream.size() - pos, 1 + rng() % 23);
+        parser.feed(stream.data() + pos, n, [&](uint8_t type, const uint8_t *p, uint16_t len) {
+            if (type == USB_RX_SHOOTER && len == kUsbShooterLen) {
+                float v;
+                std::memcpy(&v, p, 4);
+                got.push_back(v);
+                modes.push_back(p[4]);
+            } else {
+                ++others;
+            }
+        });
+        pos += n;
+    }
+
+    const UsbFrameParser::Stats &s = parser.stats();
+    std::printf("  %zu bytes: %llu frames, %llu bad checksum, %llu oversize, %llu skipped\n",
+                stream.size(), (unsigned long long)s.frames, (unsigned long long)s.bad_checksum,
+                (unsigned long long)s.oversize, (unsigned long long)s.skipped);
+    EXPECT_TRUE(got == sent);
+    EXPECT_TRUE(others == 50);
+    EXPECT_TRUE(modes.size() == 300 && modes[4] == 1 && modes[5] == 2);
+    EXPECT_TRUE(s.bad_checksum >= 50);
+    EXPECT_TRUE(s.oversize >= 50);
+}
+
+static void test_estimator() {
+    std::cout << "[speed] estimator\n";
+    std::mt19937 rng(9);
+    std::normal_distribution<float> noise(0.0f, 0.25f);
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+
+    BulletSpeedParams p;
+    BulletSpeedEstimator est(p);
+    EXPECT_TRUE(est.estimate() == p.default_speed);
+
+    // 15.6 m/s with 10 % gross outliers (double reports, grazing shots)
+    float lowpass = p.default_speed;
+    float max_err = 0.0f, max_err_lp = 0.0f;
+    for (int i = 0; i < 300; ++i) {
+        float v = 15.6f + noise(rng);
+        if (u(rng) < 0.1f) v += (u(rng) < 0.5f ? -1.0f : 1.0f) * (3.0f + 4.0f * u(rng));
+        est.add(v, 0);
+        lowpass += 0.1f * (v - lowpass);                  // what PredictionWorker did
+        if (i >= 30) {
+            max_err    = std::max(max_err, std::fabs(est.estimate() - 15.6f));
+            max_err_lp = std::max(max_err_lp, std::fabs(lowpass - 15.6f));
+        }
+    }
+    std::printf("  outliers: max error %.3f m/s (plain low-pass %.3f), %llu rejected\n",
+                max_err, max_err_lp, (unsigned long long)est.rejected());
+    EXPECT_TRUE(max_err < 0.25f);
+    EXPECT_TRUE(max_err_lp > 2.0f * max_err);
+    EXPECT_TRUE(est.rejected() > 15 && est.rejected() < 45);
+
+    // out-of-range reports never count
+    const uint64_t rej = est.rejected();
+    est.add(0.0f, 0);
+    est.add(NAN, 0);
+    est.add(80.0f, 0);
+    EXPECT_TRUE(est.rejected() == rej + 3);
+
+    // small drift is followed through the median
+    for (int i = 0; i < 40; ++i) est.add(16.4f + noise(rng), 0);
+    std::printf("  drift to 16.4: estimate %.3f\n", est.estimate());
+    EXPECT_TRUE(std::fabs(est.estimate() - 16.4f) < 0.2f);
+
+    // a jump beyond max_dev re-locks after `relock` agreeing reports
+    int n_relock = 0;
+    while (std::fabs(est.estimate() - 19.0f) > 0.3f && n_relock < 50) {
+        est.add(19.0f + 0.5f * noise(rng), 0);
+        ++n_relock;
+    }
+    std::printf("  jump to 19.0: locked after %d reports\n", n_relock);
+    EXPECT_TRUE(n_relock <= p.relock + 1);
+
+    // per-mode tracks: mode 2 learns its own speed, mode 0 keeps 19
+    for (int i = 0; i < 20; ++i) est.add(24.0f + noise(rng), 2);
+    EXPECT_TRUE(est.mode() == 2);
+    EXPECT_TRUE(std::fabs(est.estimate() - 24.0f) < 0.3f);
+    EXPECT_TRUE(std::fabs(est.estimate(0) - 19.0f) < 0.3f);
+    est.add(19.0f, 0);   // back: immediately on the old value
+    EXPECT_TRUE(std::fabs(est.estimate() - 19.0f) < 0.3f);
+    EXPECT_TRUE(est.estimate(1) == p.default_speed);
+}
+
+// Stand-in MCU on the master side of a pty: reports a shot every 2 ms with
+// noise and outliers, interleaved with other frames and line noise, in
+// arbitrary write sizes. The host side opens the slave through
+// USBCommunication and runs the USBWorker RX path; a third thread reads
+// the published speed concurrently.
+static void test_pty_mcu() {
+    std::cout << "[speed] pty stand-in MCU\n";
+    int master = -1, slave = -1;
+    char name[256];
+    if (openpty(&master, &slave, name, nullptr, nullptr) != 0) {
+        std::cout << "  openpty failed, skipped\n";
+        return;
+    }
+
+    calibur::USBCommunication usb(name);
+    EXPECT_TRUE(usb.open());
+    close(slave);   // the port holds its own fd
+
+    std::atomic<float> published{0.0f};
+    BulletSpeedParams bp;
+    BulletSpeedRx rx(bp, published);
+
+    const int kShots = 500;
+    std::atomic<bool> mcu_done{false};
+    std::thread mcu([&] {
+        std::mt19937 rng(17);
+        std::normal_distribution<float> noise(0.0f, 0.2f);
+        std::uniform_real_distribution<float> u(0.0f, 1.0f);
+        std::vector<uint8_t> out;
+        for (int i = 0; i < kShots; ++i) {
+            float v = (i < 300 ? 15.8f : 22.5f) + noise(rng);
+            const uint8_t mode = i < 300 ? 0 : 1;
+            if (u(rng) < 0.08f) v += 6.0f;
+            if (i % 7 == 0) {
+                const int32_t st[3] = {1, 0, 1};
+                uint8_t f[20];
+                out.insert(out.end(), f, f + usb_encode_frame(USB_TX_STATE, st, 12, f));
+            }
+            if (i % 11 == 0) { out.push_back(0x00); out.push_back(kUsbHeader); out.push_back(0x13); }
+            append_shooter(out, v, mode);
+
+            // write in odd-sized pieces
+            size_t pos = 0;
+            while (pos < out.size()) {
+                const size_t n = std::min<size_t>(out.size() - pos, 1 + rng() % 9);
+                if (write(master, out.data() + pos, n) != ssize_t(n)) break;
+                pos += n;
+            }
+            out.clear();
+            std::this_thread::sleep_for(std::chrono::microseconds(2000));
+        }
+        mcu_done.store(true);
+    });
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> reads{0};
+    std::thread consumer([&] {                     // PredictionWorker side
+        while (!stop.load()) {
+            const float v = published.load(std::memory_order_acquire);
+            if (v != 0.0f && !(v > 5.0f && v < 35.0f)) {
+                std::cout << "  consumer saw " << v << "\n";
+            }
+            reads.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    size_t reports = 0;
+    float at_switch = 0.0f;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    uint8_t buf[256];
+    while (std::chrono::steady_clock::now() < deadline) {
+        const ssize_t n = usb.readData(buf, sizeof(buf));   // USBWorker::process_usb_rx
+        if (n > 0) {
+            reports += rx.feed(buf, size_t(n));
+            if (reports >= 290 && reports < 300) at_switch = published.load();
+        } else if (mcu_done.load() && reports >= size_t(kShots)) {
+            break;
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+    }
+    mcu.join();
+    // drain
+    for (ssize_t n; (n = usb.readData(buf, sizeof(buf))) > 0;) reports += rx.feed(buf, size_t(n));
+    stop.store(true);
+    consumer.join();
+
+    const float final_speed = published.load();
+    std::printf("  %zu / %d reports, %llu rejected, bad checksum %llu\n", reports, kShots,
+                (unsigned long long)rx.estimator().rejected(),
+                (unsigned long long)rx.parser().stats().bad_checksum);
+    std::printf("  mode 0 estimate %.3f (15.8), mode 1 estimate %.3f (22.5), %llu lock-free reads\n",
+                at_switch, final_speed, (unsigned long long)reads.load());
+    EXPECT_TRUE(std::atomic<float>::is_always_lock_free);
+    EXPECT_TRUE(reports == size_t(kShots));
+    EXPECT_TRUE(std::fabs(at_switch - 15.8f) < 0.2f);
+    EXPECT_TRUE(std::fabs(final_speed - 22.5f) < 0.2f);
+    EXPECT_TRUE(std::fabs(rx.estimator().estimate(0) - 15.8f) < 0.2f);
+
+    usb.close();
+    close(master);
+}
+
+int main() {
+    test_parser();
+    test_estimator();
+    test_pty_mcu();
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all bullet speed tests passed\n";
+    return 0;
+}
@@ -0,0 +1,249 @@
+/*
+ * test_camera_clock.cc
+ *
+ * CameraClock (calibur/worker/camera_clock.hpp): camera device timestamp
+ * -> host capture time and dropped-frame counting. Synthetic streams with
+ * drift, varying exposure, one-sided hand-over delay with SDK queue
+ * backlogs, dropped frames with and without frame numbers, an unknown
+ * tick rate, and camera resets backwards and forwards.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 -I . tests/test_camera_clock.cc calibur/worker/camera_clock.cpp \
+ *       -o test_camera_clock
+ *
+ * Run:
+ *   ./test_camera_clock
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "calibur/worker/camera_clock.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+static double percentile(std::vector<double> v, double q) {
+    if (v.empty()) return 0.0;
+    const size_t k = std::min(v.size() - 1, size_t(q * (v.size() - 1) + 0.5));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+static std::vector<double> abs_of(const std::vector<double> &v) {
+    std::vector<double> a(v.size());
+    for (size_t i = 0; i < v.size(); ++i) a[i] = std::fabs(v[i]);
+    return a;
+}
+
+// Synthetic camera: frame k starts exposing at host t0 + k / fps; the
+// device tick runs `drift` fast from tick0. The SDK hands a frame over
+// after its exposure, the fixed readout + transfer latency and a one-sided
+// delay (grab loop jitter, pixel conversion); now and then the grab loop
+// stalls and the queued frames come out back to back. A few frames never
+// arrive.
+struct Stream {
+    double   fps     = 200.0;
+    double   tick_hz = 1e9;
+    double   drift   = 40e-6;
+    uint64_t tick0   = 5000000000000ull;
+    double   latency = 3e-3;
+    double   delay   = 1.5e-3;   // exponential mean
+    double   stall_p = 0.01;
+    double   stall   = 20e-3;
+    double   drop_p  = 0.005;
+    double   t0      = 2000.0;   // host s
+    std::mt19937 rng{7};
+
+    struct Frame {
+        uint64_t k;
+        uint64_t tick;
+        double   exposure;
+        double   received;
+        double   capture;   // truth, mid exposure
+    };
+
+    double exposure(uint64_t k) const { return 4e-3 + 2e-3 * std::sin(0.01 * double(k)); }
+    uint64_t tick(uint64_t k) const {
+        return tick0 + uint64_t(std::llround(k / fps * (1.0 + drift) * tick_hz));
+    }
+
+    // frames 0..n-1 minus the dropped ones, in hand-over order
+    std::vector<Frame> frames(uint64_t n, uint64_t *dropped = nullptr) {
+        std::exponential_distribution<double> ex(1.0 / delay);
+        std::uniform_real_distribution<double> u(0.0, 1.0);
+        std::vector<Frame> f;
+        double held_until = 0.0, last = 0.0;
+        uint64_t drops = 0;
+        for (uint64_t k = 0; k < n; ++k) {
+            const double start = t0 + k / fps;
+            const double e = exposure(k);
+            double h = start + e + latency + ex(rng);
+            if (u(rng) < stall_p) held_until = h + stall * (0.2 + u(rng));
+            h = std::max({h, held_until, last});
+            last = h;
+            if (k > 0 && u(rng) < drop_p) { ++drops; continue; }
+            f.push_back(Frame{k, tick(k), e, h, start + 0.5 * e});
+        }
+        if (dropped) *dropped = drops;
+        return f;
+    }
+};
+
+// ---------------------------------------------------------------------------
+
+static void test_mapping() {
+    std::cout << "[camera clock] drift, exposure, queue delay, drops\n";
+    Stream s;
+    uint64_t dropped = 0;
+    const std::vector<Stream::Frame> fr = s.frames(12000, &dropped);
+
+    CameraClockParams p;
+    p.latency = s.latency;
+    CameraClock c(p);
+    std::vector<double> err, err_recv;
+    uint64_t counted = 0, wrong = 0, prev_k = 0;
+    for (size_t i = 0; i < fr.size(); ++i) {
+        const Stream::Frame &f = fr[i];
+        const CameraFrameTime t = c.on_frame(uint32_t(f.k), f.tick, f.exposure, CameraClock::time_point(f.received));
+        counted += t.dropped;
+        if (i > 0 && t.dropped != f.k - prev_k - 1) ++wrong;
+        prev_k = f.k;
+        if (f.k < 1000) continue;   // after the slope settles
+        EXPECT_TRUE(t.mapped);
+        err.push_back(CameraClock::seconds(t.capture) - f.capture);
+        err_recv.push_back(f.received - s.latency - 0.5 * f.exposure - f.capture);
+    }
+    const CameraClockEstimate &e = c.estimate();
+    const std::vector<double> ae = abs_of(err), ar = abs_of(err_recv);
+    std::printf("  mapped: median %+.1f us, p99 |err| %.1f us, max %.1f us | on hand-over: median %.1f us,"
+                " p99 %.1f us\n",
+                1e6 * percentile(err, 0.5), 1e6 * percentile(ae, 0.99), 1e6 * percentile(ae, 1.0),
+                1e6 * percentile(ar, 0.5), 1e6 * percentile(ar, 0.99));
+    std::printf("  drift %.2f ppm (40), median delay %.2f ms, %llu / %llu dropped counted\n",
+                1e6 * e.drift(), 1e3 * e.delay, (unsigned long long)counted, (unsigned long long)dropped);
+
+    EXPECT_TRUE(e.valid && e.resets == 0);
+    EXPECT_TRUE(std::fabs(e.drift() - 40e-6) < 5e-6);
+    EXPECT_TRUE(std::fabs(percentile(err, 0.5)) < 150e-6);
+    EXPECT_TRUE(percentile(ae, 0.99) < 300e-6);
+    EXPECT_TRUE(percentile(ar, 0.5) > 4.0 * percentile(ae, 0.5));
+    EXPECT_TRUE(percentile(ar, 0.99) > 10.0 * percentile(ae, 0.99));
+    EXPECT_TRUE(counted == dropped && e.dropped == dropped && wrong == 0);
+}
+
+// nFrameNum left at zero: drops from gaps in device time
+static void test_drops_without_numbers() {
+    std::cout << "[camera clock] drops from device time\n";
+    Stream s;
+    s.drop_p = 0.02;
+    uint64_t dropped = 0;
+    const std::vector<Stream::Frame> fr = s.frames(6000, &dropped);
+    CameraClock c;
+    uint64_t wrong = 0, prev_k = 0;
+    for (size_t i = 0; i < fr.size(); ++i) {
+        const CameraFrameTime t = c.on_frame(0, fr[i].tick, fr[i].exposure,
+                                             CameraClock::time_point(fr[i].received));
+        if (i > 0 && t.dropped != fr[i].k - prev_k - 1) ++wrong;
+        prev_k = fr[i].k;
+    }
+    std::printf("  %llu / %llu dropped counted, %llu frames wrong\n",
+                (unsigned long long)c.estimate().dropped, (unsigned long long)dropped,
+                (unsigned long long)wrong);
+    EXPECT_TRUE(c.estimate().dropped == dropped && wrong == 0);
+}
+
+// tick rate not configured: 100 MHz detected from the first 0.5 s
+static void test_tick_detection() {
+    std::cout << "[camera clock] tick rate detection\n";
+    Stream s;
+    s.tick_hz = 1e8;
+    const std::vector<Stream::Frame> fr = s.frames(4000);
+    CameraClockParams p;
+    p.tick_hz = 0.0;
+    p.latency = s.latency;
+    CameraClock c(p);
+    std::vector<double> err;
+    bool early_mapped = false;
+    for (const Stream::Frame &f : fr) {
+        const CameraFrameTime t = c.on_frame(uint32_t(f.k), f.tick, f.exposure, CameraClock::time_point(f.received));
+        if (f.k < 50 && t.mapped) early_mapped = true;
+        if (f.k > 1000) err.push_back(std::fabs(CameraClock::seconds(t.capture) - f.capture));
+    }
+    std::printf("  tick %.0f Hz, p99 |err| %.1f us\n", c.estimate().tick_hz, 1e6 * percentile(err, 0.99));
+    EXPECT_TRUE(!early_mapped);
+    EXPECT_TRUE(c.estimate().tick_hz == 1e8);
+    EXPECT_TRUE(percentile(err, 0.99) < 300e-6);
+}
+
+static void test_reset() {
+    std::cout << "[camera clock] camera resets\n";
+    Stream s;
+    s.stall_p = 0.0;
+    s.drop_p  = 0.0;
+    const std::vector<Stream::Frame> fr = s.frames(9000);
+    CameraClockParams p;
+    p.latency = s.latency;
+    CameraClock c(p);
+    std::vector<double> err_back, err_fwd;
+    for (const Stream::Frame &f : fr) {
+        // device time restarts near zero at frame 3000 and is re-latched
+        // 10 s ahead at frame 6000
+        uint64_t tick = f.tick;
+        if (f.k >= 3000) tick = tick - s.tick(3000) + 1000;
+        if (f.k >= 6000) tick += uint64_t(10 * s.tick_hz);
+        const CameraFrameTime t = c.on_frame(uint32_t(f.k), tick, f.exposure, CameraClock::time_point(f.received));
+        const double e = std::fabs(CameraClock::seconds(t.capture) - f.capture);
+        if (f.k > 4000 && f.k < 6000) err_back.push_back(e);
+        if (f.k > 7000) err_fwd.push_back(e);
+    }
+    std::printf("  %llu resets, p99 |err| after %.1f us / %.1f us\n",
+                (unsigned long long)c.estimate().resets, 1e6 * percentile(err_back, 0.99),
+                1e6 * percentile(err_fwd, 0.99));
+    EXPECT_TRUE(c.estimate().resets == 2);
+    EXPECT_TRUE(c.estimate().dropped == 0);
+    EXPECT_TRUE(percentile(err_back, 0.99) < 300e-6);
+    EXPECT_TRUE(percentile(err_fwd, 0.99) < 300e-6);
+}
+
+static void bench_on_frame() {
+    std::cout << "[camera clock] cost per frame\n";
+    Stream s;
+    const std::vector<Stream::Frame> fr = s.frames(20000);
+    CameraClock c;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (const Stream::Frame &f : fr)
+        c.on_frame(uint32_t(f.k), f.tick, f.exposure, CameraClock::time_point(f.received));
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() /
+                      double(fr.size());
+    std::printf("  %.2f us per frame (refit every %.1f s)\n", us, c.params().refit_period);
+    EXPECT_TRUE(us < 50.0);
+}
+
+int main() {
+    test_mapping();
+    test_drops_without_numbers();
+    test_tick_detection();
+    test_reset();
+    bench_on_frame();
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all camera clock tests passed\n";
+    return 0;
+}
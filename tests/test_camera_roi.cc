@@ -0,0 +1,405 @@
+/*
+ * test_camera_roi.cc
+ *
+ * RoiController (calibur/worker/camera_roi.hpp) driving CameraSim
+ * (calibur/sim/camera_sim.hpp): window placement and node alignment,
+ * hysteresis against a jittering target, return to full frame on loss,
+ * and a closed loop over a moving, ranging target with detection latency,
+ * checking that every frame kept is tagged with the window it was really
+ * read out with (camera clock start times and frame order alone), how
+ * often the target stays in view, and the frame rate / bandwidth won.
+ * Also the camera worker's publish-then-resize sequence on leased SDK
+ * buffers (HikBufferPool on a mock SDK): a resize goes through once the
+ * consumers let go, and never restarts acquisition with a buffer out.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 -pthread -I . tests/test_camera_roi.cc calibur/worker/camera_roi.cpp \
+ *       calibur/sim/camera_sim.cpp calibur/worker/hik_buffers.cpp -o test_camera_roi
+ *
+ * Run:
+ *   ./test_camera_roi
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "calibur/sim/camera_sim.hpp"
+#include "calibur/worker/camera_roi.hpp"
+#include "calibur/worker/hik_buffers.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+using SteadyClock = std::chrono::steady_clock;
+using TimePoint   = SteadyClock::time_point;
+
+static constexpr double kPi = 3.14159265358979323846;
+
+static double since(TimePoint t0, TimePoint t) { return std::chrono::duration<double>(t - t0).count(); }
+
+static bool aligned(const SensorRoi &r, const SensorLimits &l) {
+    return r.x % l.inc_x == 0 && r.y % l.inc_y == 0 && (r.w == l.width || r.w % l.inc_w == 0) &&
+           (r.h == l.height || r.h % l.inc_h == 0) && r.x >= 0 && r.y >= 0 && r.x + r.w <= l.width &&
+           r.y + r.h <= l.height && r.w >= l.min_w && r.h >= l.min_h;
+}
+
+static void test_placement() {
+    std::cout << "[camera roi] window size, placement and alignment\n";
+    SensorLimits lim;
+    lim.width = 1440; lim.height = 1080;
+    lim.inc_w = 16; lim.inc_h = 4; lim.inc_x = 16; lim.inc_y = 2;
+    RoiParams p;
+    p.shrink_hold = 0.0;
+    p.resize_holdoff = 0.0;
+    const TimePoint t0 = SteadyClock::now();
+
+    // boxes in the middle and against every edge / corner
+    const float boxes[][4] = {{700, 500, 40, 30}, {0, 0, 30, 20},     {1410, 1060, 30, 20},
+                              {1400, 0, 40, 40},  {0, 1040, 40, 40},  {600, 400, 300, 200}};
+    for (const auto &b : boxes) {
+        RoiController c(lim, p);
+        RoiTarget t{b[0], b[1], b[2], b[3], t0};
+        const RoiCommand cmd = c.update(&t, t0);
+        EXPECT_TRUE(cmd.kind == RoiCommand::RESIZE);
+        EXPECT_TRUE(aligned(cmd.roi, lim));
+        // sides on the size step, except one not worth shrinking from full
+        EXPECT_TRUE((cmd.roi.w % p.size_step == 0 && cmd.roi.w >= p.min_size) || cmd.roi.w == lim.width);
+        EXPECT_TRUE(cmd.roi.h % p.size_step == 0 && cmd.roi.h >= p.min_size);
+        // the target is inside the window
+        EXPECT_TRUE(b[0] >= cmd.roi.x && b[0] + b[2] <= cmd.roi.x + cmd.roi.w);
+        EXPECT_TRUE(b[1] >= cmd.roi.y && b[1] + b[3] <= cmd.roi.y + cmd.roi.h);
+    }
+    // a target larger than the sensor allows caps at full frame: nothing to do
+    RoiController c(lim, p);
+    RoiTarget big{100, 100, 1200, 900, t0};
+    EXPECT_TRUE(c.update(&big, t0).kind == RoiCommand::NONE);
+}
+
+static void test_hysteresis_and_loss() {
+    std::cout << "[camera roi] hysteresis on a jittering target, full frame on loss\n";
+    SensorLimits lim;
+    RoiParams p;
+    CameraSim cam(CameraSimParams{}, SteadyClock::now());
+    RoiController c(lim, p);
+    const TimePoint t0 = cam.now();
+    std::mt19937 rng(3);
+    std::normal_distribution<float> jitter(0.0f, 3.0f);
+
+    uint64_t moves_after_settle = 0, resizes_after_settle = 0;
+    TimePoint full_again{};
+    RoiTarget target;
+    for (int i = 0; i < 4000; ++i) {
+        const CameraSimFrame f = cam.next_frame();
+        SensorRoi tag;
+        c.frame_roi(f.start, true, f.roi.w, f.roi.h, tag);
+        const double t = since(t0, f.capture);
+        const bool visible = t < 3.0;
+        // the last sighting stays published after the target is gone
+        if (visible) target = RoiTarget{400 + jitter(rng), 600 + jitter(rng), 70 + jitter(rng), 35 + jitter(rng), f.capture};
+
+        const uint64_t m = c.stats().moves, r = c.stats().resizes;
+        const RoiCommand cmd = c.update(&target, cam.now());
+        const TimePoint now = cam.now();
+        if (cmd.kind == RoiCommand::MOVE && cam.move_roi(cmd.roi.x, cmd.roi.y)) c.applied(cmd, now);
+        if (cmd.kind == RoiCommand::RESIZE && cam.resize_roi(cmd.roi)) c.applied(cmd, now);
+        if (t > 1.0 && t < 3.0) {
+            moves_after_settle += c.stats().moves - m;
+            resizes_after_settle += c.stats().resizes - r;
+        }
+        if (t > 3.0 && full_again == TimePoint{} && c.current() == c.full()) full_again = f.capture;
+        if (since(t0, f.capture) > 4.0) break;
+    }
+    std::printf("  %llu moves, %llu resizes in total; %llu / %llu after settling; full frame %.0f ms after loss\n",
+                (unsigned long long)c.stats().moves, (unsigned long long)c.stats().resizes,
+                (unsigned long long)moves_after_settle, (unsigned long long)resizes_after_settle,
+                1e3 * (since(t0, full_again) - 3.0));
+    EXPECT_TRUE(moves_after_settle == 0 && resizes_after_settle == 0);
+    EXPECT_TRUE(c.stats().resizes == 2);   // in, then back out
+    EXPECT_TRUE(full_again != TimePoint{});
+    EXPECT_TRUE(since(t0, full_again) - 3.0 > p.lost_timeout - 0.01 && since(t0, full_again) - 3.0 < p.lost_timeout + 0.07);
+    EXPECT_TRUE(cam.refused() == 0);
+}
+
+// Target: a box ranging between ~45 and ~105 px wide, weaving across the
+// sensor at up to ~750 px/s, out of view for a while.
+struct Scene {
+    float cx(double t) const { return 540.0f + 300.0f * float(std::sin(2 * kPi * 0.4 * t)); }
+    float cy(double t) const { return 540.0f + 160.0f * float(std::sin(2 * kPi * 0.3 * t + 1.0)); }
+    float w(double t) const { return 75.0f + 30.0f * float(std::sin(2 * kPi * 0.15 * t)); }
+    bool  visible(double t) const { return (t > 0.3 && t < 6.0) || t > 7.0; }
+};
+
+struct LoopResult {
+    uint64_t frames = 0, kept = 0, unknown = 0, mistagged = 0;
+    uint64_t in_view = 0, seen = 0;    // frames with the target in view / detected, while tracking
+    double   locked_s = 0.0;           // time spent tracking
+    uint64_t locked_frames = 0;
+    double   locked_pixels = 0.0;      // pixels read out while tracking
+    uint64_t moves = 0, resizes = 0, refused = 0;
+};
+
+static LoopResult run_loop(bool mapped, bool dynamic, double duration) {
+    SensorLimits lim;
+    CameraSim cam(CameraSimParams{}, SteadyClock::now());
+    RoiController c(lim, RoiParams());
+    const TimePoint t0 = cam.now();
+    Scene scene;
+    std::mt19937 rng(11);
+    std::normal_distribution<float> noise(0.0f, 2.0f);
+
+    // detections become available 8 ms after the frame is handed over
+    std::deque<std::pair<TimePoint, RoiTarget>> inflight;
+    RoiTarget last;
+    bool have = false;
+
+    LoopResult r;
+    double prev_capture = 0.0;
+    for (;;) {
+        const CameraSimFrame f = cam.next_frame();
+        const double t = since(t0, f.capture);
+        if (t > duration) break;
+        ++r.frames;
+
+        SensorRoi tag;
+        const bool known = c.frame_roi(f.start, mapped, f.roi.w, f.roi.h, tag);
+        if (!known) ++r.unknown;
+        else {
+            ++r.kept;
+            if (tag != f.roi) ++r.mistagged;
+        }
+
+        const float w = scene.w(t), h = 0.5f * w;
+        const float x = scene.cx(t) - 0.5f * w, y = scene.cy(t) - 0.5f * h;
+        const bool in_view = scene.visible(t) && x >= f.roi.x && y >= f.roi.y &&
+                             x + w <= f.roi.x + f.roi.w && y + h <= f.roi.y + f.roi.h;
+        const bool tracking = scene.visible(t) && t > 1.0 && !(t > 7.0 && t < 7.5);
+        if (tracking) {
+            ++r.locked_frames;
+            r.locked_s += t - prev_capture;
+            r.locked_pixels += double(f.roi.w) * f.roi.h;
+            r.in_view += in_view;
+            r.seen += in_view && known;
+        }
+        prev_capture = t;
+        if (in_view && known) {
+            inflight.emplace_back(f.delivered + std::chrono::milliseconds(8),
+                                  RoiTarget{x + noise(rng), y + noise(rng), w + noise(rng), h + noise(rng), f.capture});
+        }
+        while (!inflight.empty() && inflight.front().first <= cam.now()) {
+            last = inflight.front().second;
+            have = true;
+            inflight.pop_front();
+        }
+
+        if (!dynamic) continue;
+        const TimePoint now = cam.now();
+        const RoiCommand cmd = c.update(have ? &last : nullptr, now);
+        if (cmd.kind == RoiCommand::MOVE && cam.move_roi(cmd.roi.x, cmd.roi.y)) c.applied(cmd, now);
+        if (cmd.kind == RoiCommand::RESIZE && cam.resize_roi(cmd.roi)) c.applied(cmd, now);
+    }
+    r.moves   = c.stats().moves;
+    r.resizes = c.stats().resizes;
+    r.refused = cam.refused();
+    return r;
+}
+
+static void test_closed_loop() {
+    std::cout << "[camera roi] closed loop: moving, ranging target, 8 ms detection latency\n";
+    const LoopResult full = run_loop(true, false, 10.0);
+    const double full_fps = full.locked_frames / full.locked_s;
+    std::printf("  full frame:    %.0f fps, %.1f Mpx/s while tracking\n", full_fps,
+                1e-6 * full.locked_pixels / full.locked_s);
+
+    for (bool mapped : {true, false}) {
+        const LoopResult r = run_loop(mapped, true, 10.0);
+        const double fps = r.locked_frames / r.locked_s;
+        std::printf("  dynamic (%s): %.0f fps, %.1f Mpx/s while tracking; target in view %.2f%%, detected %.2f%%; "
+                    "%llu moves, %llu resizes, %llu / %llu frames unknown, %llu mistagged\n",
+                    mapped ? "clock" : "order", fps, 1e-6 * r.locked_pixels / r.locked_s,
+                    100.0 * r.in_view / r.locked_frames, 100.0 * r.seen / r.locked_frames,
+                    (unsigned long long)r.moves, (unsigned long long)r.resizes, (unsigned long long)r.unknown,
+                    (unsigned long long)r.frames, (unsigned long long)r.mistagged);
+        EXPECT_TRUE(r.mistagged == 0);
+        EXPECT_TRUE(r.refused == 0);
+        EXPECT_TRUE(fps > 1.8 * full_fps);
+        EXPECT_TRUE(r.locked_pixels / r.locked_s < 0.5 * full.locked_pixels / full.locked_s);
+        EXPECT_TRUE(double(r.in_view) / r.locked_frames > 0.99);
+        EXPECT_TRUE(double(r.seen) / r.locked_frames > 0.9);
+        EXPECT_TRUE(r.resizes < 15);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Publish-then-resize as CameraWorker runs it: a frame leased from an SDK
+// buffer is published, a consumer holds it for a while, and the controller
+// wants a smaller window. The SDK mock hands out `nodes` buffers; the
+// camera refuses a resize (a restart of acquisition) while any is out.
+
+struct MockSdk {
+    std::mutex                        mtx;
+    std::vector<std::vector<uint8_t>> nodes;
+    std::vector<bool>                 out;
+    unsigned int                      frame_num = 0;
+
+    explicit MockSdk(int n) : nodes(n, std::vector<uint8_t>(64)), out(n, false) {}
+
+    int outstanding() {
+        std::lock_guard<std::mutex> lk(mtx);
+        return int(std::count(out.begin(), out.end(), true));
+    }
+    int get(MV_FRAME_OUT *f) {
+        std::lock_guard<std::mutex> lk(mtx);
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            if (out[i]) continue;
+            out[i] = true;
+            f->pBufAddr                = nodes[i].data();
+            f->stFrameInfo.nWidth      = 8;
+            f->stFrameInfo.nHeight     = 8;
+            f->stFrameInfo.nFrameNum   = ++frame_num;
+            return MV_OK;
+        }
+        return int(MV_E_NODATA);
+    }
+    int release(MV_FRAME_OUT *f) {
+        std::lock_guard<std::mutex> lk(mtx);
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i].data() == f->pBufAddr && out[i]) {
+                out[i] = false;
+                return MV_OK;
+            }
+        }
+        return -1;
+    }
+};
+
+static const HikSdk kMockSdk{
+    [](void *, unsigned int) { return int(MV_OK); },
+    [](void *h, MV_FRAME_OUT *f, unsigned int) { return static_cast<MockSdk *>(h)->get(f); },
+    [](void *h, MV_FRAME_OUT *f) { return static_cast<MockSdk *>(h)->release(f); },
+};
+
+// CameraSim that checks the SDK has every buffer back on a resize
+struct CheckedCamera : CameraSim {
+    MockSdk *sdk;
+    int      restarted_with_buffers_out = 0;
+
+    explicit CheckedCamera(MockSdk *s) : sdk(s) {}
+    bool resize_roi(const SensorRoi &roi) override {
+        if (sdk->outstanding() != 0) {
+            ++restarted_with_buffers_out;
+            return false;
+        }
+        return CameraSim::resize_roi(roi);
+    }
+};
+
+struct PublishedFrame {
+    uint32_t              frame_num = 0;
+    std::shared_ptr<void> lease;
+};
+
+static void test_publish_then_resize() {
+    std::cout << "[camera roi] publish then resize on leased SDK buffers\n";
+    MockSdk       sdk(4);
+    CheckedCamera cam(&sdk);
+    HikBufferParams bp;
+    bp.buffers = 4;
+    HikBufferPool pool(&sdk, kMockSdk, bp);
+
+    RoiParams p;
+    p.shrink_hold    = 0.0;
+    p.resize_holdoff = 0.0;
+    p.lost_timeout   = 10.0;
+    RoiController ctl(cam.limits(), p);
+
+    std::shared_ptr<PublishedFrame> shared;   // SharedLatest::camera
+    const auto wait = std::chrono::milliseconds(50);
+    auto release = [&] { std::atomic_store(&shared, std::shared_ptr<PublishedFrame>()); };
+    auto idle    = [&] { return pool.wait_idle(wait); };
+
+    RoiTarget target;
+    target.x = 500.0f; target.y = 500.0f; target.w = 40.0f; target.h = 20.0f;
+
+    // one camera loop iteration; `keep` holds the published frame past the
+    // publish, as the loop did before the fix
+    auto iteration = [&](bool keep, double &took_ms) {
+        HikBuffer buf;
+        EXPECT_TRUE(pool.grab(10, buf) == MV_OK);
+        std::shared_ptr<PublishedFrame> kept;
+        {
+            auto ptr = std::make_shared<PublishedFrame>();
+            ptr->frame_num = buf.info.nFrameNum;
+            ptr->lease     = std::move(buf.lease);
+            std::atomic_store(&shared, ptr);
+            if (keep) kept = ptr;
+        }
+        // a consumer (YOLO) takes the frame and works on it for 5 ms
+        std::thread consumer([&] {
+            auto cam_frame = std::atomic_load(&shared);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        target.timestamp = SteadyClock::now();
+        const auto t0 = SteadyClock::now();
+        const RoiCommand cmd = ctl.drive(cam, &target, SteadyClock::now(), release, idle);
+        took_ms = 1e3 * since(t0, SteadyClock::now());
+        consumer.join();
+        return cmd;
+    };
+
+    // holding the published frame: the resize can never go through
+    double held_ms = 0.0;
+    const RoiCommand held = iteration(true, held_ms);
+    EXPECT_TRUE(held.kind == RoiCommand::NONE);
+    EXPECT_TRUE(ctl.stats().held == 1 && ctl.stats().resizes == 0);
+    EXPECT_TRUE(held_ms >= 45.0);
+    EXPECT_TRUE(sdk.outstanding() == 0);
+
+    // dropped after publishing: it goes through once the consumer is done
+    double ms = 0.0;
+    const RoiCommand cmd = iteration(false, ms);
+    std::printf("  frame held by the loop: put off after %.1f ms; released: resized to %dx%d after %.1f ms\n",
+                held_ms, cmd.roi.w, cmd.roi.h, ms);
+    EXPECT_TRUE(cmd.kind == RoiCommand::RESIZE);
+    EXPECT_TRUE(ms < 25.0);
+    EXPECT_TRUE(ctl.stats().resizes == 1 && cam.restarts() == 1);
+    EXPECT_TRUE(cam.roi() == cmd.roi && cmd.roi.w < cam.limits().width);
+    EXPECT_TRUE(cam.restarted_with_buffers_out == 0);
+    EXPECT_TRUE(!std::atomic_load(&shared));
+
+    // acquisition restarted: grabbing goes on
+    HikBuffer next;
+    EXPECT_TRUE(pool.grab(10, next) == MV_OK);
+    EXPECT_TRUE(pool.stats().errors == 0);
+}
+
+int main() {
+    test_placement();
+    test_hysteresis_and_loss();
+    test_closed_loop();
+    test_publish_then_resize();
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all camera roi tests passed\n";
+    return 0;
+}
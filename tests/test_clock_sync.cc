@@ -0,0 +1,270 @@
+/*
+ * test_clock_sync.cc
+ *
+ * Host <-> MCU clock synchronisation (calibur/worker/clock_sync.hpp):
+ * 32-bit tick unwrapping, offset / drift / link delay recovery from
+ * synthetic exchanges with queueing spikes, and the ping / pong loop
+ * against a stand-in MCU on a pseudo-terminal with a drifting, wrapping
+ * microsecond tick and simulated wire delay.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 -pthread -I . -I calibur -I calibur/worker -I apps/yaml-cpp/include \
+ *       tests/test_clock_sync.cc calibur/worker/clock_sync.cpp calibur/worker/command_streamer.cpp \
+ *       calibur/worker/serial_link.cpp calibur/usb_communication.cpp calibur/log.cpp \
+ *       calibur/config.cc calibur/util.cpp apps/yaml-cpp/lib/libyaml-cpp.a -lutil -o test_clock_sync
+ *
+ * Run:
+ *   ./test_clock_sync
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <pty.h>
+#include <random>
+#include <thread>
+#include <unistd.h>
+
+#include "clock_sync.hpp"
+#include "serial_link.hpp"
+#include "calibur/usb_communication.h"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+using SteadyClock = std::chrono::steady_clock;
+
+static SteadyClock::time_point at(double s) {
+    return SteadyClock::time_point(
+        std::chrono::duration_cast<SteadyClock::duration>(std::chrono::duration<double>(s)));
+}
+
+// MCU clock: runs (1 + drift) fast and starts `lead` seconds before the
+// 32-bit microsecond tick wraps
+struct McuClock {
+    double drift;
+    double base;   // MCU s at host time 0
+
+    McuClock(double drift_, double host_start, double lead)
+        : drift(drift_), base(4294.967296 - lead - host_start * (1.0 + drift_)) {}
+
+    double   seconds(double host_s) const { return base + host_s * (1.0 + drift); }
+    uint32_t tick(double host_s) const { return uint32_t(uint64_t(std::llround(seconds(host_s) * 1e6))); }
+};
+
+static void pong_payload(uint32_t seq, double t1, uint32_t t2, uint32_t t3, uint8_t *p) {
+    const uint64_t ns = uint64_t(std::llround(t1 * 1e9));
+    std::memcpy(p, &seq, 4);
+    std::memcpy(p + 4, &ns, 8);
+    std::memcpy(p + 12, &t2, 4);
+    std::memcpy(p + 16, &t3, 4);
+}
+
+// ---------------------------------------------------------------------------
+
+static void test_unwrap() {
+    std::cout << "[sync] tick unwrap\n";
+    ClockSync cs;
+    const uint32_t ticks[] = {0xFFFFFF00u, 0xFFFFFFF0u, 0xFFFFFFE0u, 0x00000010u, 0x00000005u,
+                              0x7FFFFFFFu, 0xF0000000u, 0x00000100u};
+    const uint64_t want[] = {0xFFFFFF00ull, 0xFFFFFFF0ull, 0xFFFFFFE0ull, 0x100000010ull,
+                             0x100000005ull, 0x17FFFFFFFull, 0x1F0000000ull, 0x200000100ull};
+    bool ok = true;
+    for (int i = 0; i < 8; ++i) ok = ok && cs.unwrap(ticks[i]) == want[i];
+    EXPECT_TRUE(ok);
+}
+
+static void test_synthetic() {
+    std::cout << "[sync] synthetic exchanges\n";
+    std::mt19937 rng(3);
+    std::exponential_distribution<double> queue(1.0 / 150e-6);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+
+    const double t0 = 5000.0;
+    const McuClock mcu(35e-6, t0, 20.0);   // wraps 20 s in
+    ClockSync cs;
+
+    double naive_err = 0.0, est_err = 0.0;
+    int n_err = 0;
+    uint8_t p[kUsbPongLen];
+    for (int i = 0; i < 1200; ++i) {
+        const double t1 = t0 + 0.05 * i;
+        double d_in  = 300e-6 + queue(rng);
+        double d_out = 300e-6 + queue(rng);
+        if (u(rng) < 0.05) d_out += 5e-3;      // USB frame scheduling hiccup, one way
+        const double turn = 30e-6 + 50e-6 * u(rng);
+        const uint32_t t2 = mcu.tick(t1 + d_in);
+        const uint32_t t3 = mcu.tick(t1 + d_in + turn);
+        const double t4 = t1 + d_in + turn + d_out;
+        pong_payload(uint32_t(i), t1, t2, t3, p);
+        EXPECT_TRUE(cs.on_pong(p, kUsbPongLen, at(t4)));
+
+        if (i >= 300) {
+            const double th = 0.5 * (t1 + t4);
+            const double truth = mcu.seconds(th) - th;
+            const double naive = 0.5 * ((mcu.seconds(t1 + d_in) - t1) +
+                                        (mcu.seconds(t1 + d_in + turn) - t4));
+            naive_err += std::fabs(naive - truth);
+            est_err   += std::fabs(cs.estimate().host_to_mcu(th) - th - truth);
+            ++n_err;
+        }
+    }
+
+    const ClockSyncEstimate &e = cs.estimate();
+    const double t_end = e.t_ref;
+    const double off_err = std::fabs(e.host_to_mcu(t_end) - mcu.seconds(t_end));
+    const JitterStats d = cs.delay_stats();
+    std::printf("  offset error %.1f us (mean %.1f us, single exchange %.1f us), drift %.2f ppm (35)\n",
+                1e6 * off_err, 1e6 * est_err / n_err, 1e6 * naive_err / n_err, 1e6 * e.drift);
+    std::printf("  one-way %.0f us (min %.0f us), p50 %.0f us  p99 %.0f us  max %.0f us\n",
+                1e6 * e.one_way, 1e6 * e.one_way_min, d.p50_us, d.p99_us, d.max_us);
+    EXPECT_TRUE(e.valid);
+    EXPECT_TRUE(off_err < 20e-6);
+    EXPECT_TRUE(est_err < 0.25 * naive_err);
+    EXPECT_TRUE(std::fabs(e.drift - 35e-6) < 3e-6);
+    EXPECT_TRUE(std::fabs(e.one_way - 405e-6) < 40e-6);   // 300 us + median of the queueing
+    EXPECT_TRUE(d.p99_us > 2000.0);
+
+    // host <-> MCU mapping round trip
+    const double h = t_end + 0.123;
+    EXPECT_TRUE(std::fabs(e.mcu_to_host(e.host_to_mcu(h)) - h) < 1e-9);
+
+    // malformed / too slow
+    EXPECT_TRUE(!cs.on_pong(p, kUsbPongLen - 1, at(t_end)));
+    pong_payload(0, t_end, mcu.tick(t_end), mcu.tick(t_end), p);
+    EXPECT_TRUE(!cs.on_pong(p, kUsbPongLen, at(t_end + 0.5)));
+    EXPECT_TRUE(cs.rejected() == 2);
+}
+
+// Stand-in MCU on the master side of a pty: answers pings after a
+// simulated wire delay each way, stamping with its own drifting tick.
+class PtyMcu {
+public:
+    PtyMcu(int fd, const McuClock &clock, double delay)
+        : fd_(fd), clock_(clock), delay_(delay), th_([this] { run(); }) {}
+    ~PtyMcu() { stop_.store(true); th_.join(); }
+
+    uint64_t pongs() const { return pongs_.load(); }
+
+private:
+    static double now_s() {
+        return std::chrono::duration<double>(SteadyClock::now().time_since_epoch()).count();
+    }
+
+    void run() {
+        std::mt19937 rng(11);
+        std::exponential_distribution<double> jitter(1.0 / 50e-6);
+        UsbFrameParser parser;
+        uint8_t buf[256];
+        while (!stop_.load()) {
+            pollfd p{fd_, POLLIN, 0};
+            if (::poll(&p, 1, 5) <= 0) continue;
+            const ssize_t n = ::read(fd_, buf, sizeof(buf));
+            if (n <= 0) continue;
+            parser.feed(buf, size_t(n), [&](uint8_t type, const uint8_t *pl, uint16_t len) {
+                if (type != USB_TX_PING || len != kUsbPingLen) return;
+                std::this_thread::sleep_for(std::chrono::duration<double>(delay_ + jitter(rng)));
+                uint8_t reply[kUsbPongLen];
+                std::memcpy(reply, pl, kUsbPingLen);
+                const uint32_t t2 = clock_.tick(now_s());
+                std::memcpy(reply + 12, &t2, 4);
+                const uint32_t t3 = clock_.tick(now_s());
+                std::memcpy(reply + 16, &t3, 4);
+                std::this_thread::sleep_for(std::chrono::duration<double>(delay_ + jitter(rng)));
+                uint8_t f[kUsbPongLen + kUsbFrameExtra];
+                const size_t fn = usb_encode_frame(USB_RX_PONG, reply, kUsbPongLen, f);
+                if (::write(fd_, f, fn) == ssize_t(fn)) pongs_.fetch_add(1);
+            });
+        }
+    }
+
+    int fd_;
+    McuClock clock_;
+    double delay_;
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> pongs_{0};
+    std::thread th_;
+};
+
+static void test_pty_mcu() {
+    std::cout << "[sync] pty stand-in MCU\n";
+    int master = -1, slave = -1;
+    char name[256];
+    if (openpty(&master, &slave, name, nullptr, nullptr) != 0) {
+        std::cout << "  openpty failed, skipped\n";
+        return;
+    }
+    calibur::USBCommunication usb(name);
+    EXPECT_TRUE(usb.open());
+    close(slave);
+
+    const double start = ClockSync::seconds(SteadyClock::now());
+    const McuClock mcu(150e-6, start, 1.5);   // cheap crystal, wraps 1.5 s in
+    const double kDelay = 400e-6;
+    PtyMcu sim(master, mcu, kDelay);
+
+    ClockSyncParams cp;
+    cp.ping_period = 0.01;
+    ClockSync cs(cp);
+    SerialLink link([&](uint8_t type, const uint8_t *p, uint16_t len) {
+        if (type == USB_RX_PONG) cs.on_pong(p, len, SteadyClock::now());
+    });
+    EXPECT_TRUE(link.attach(usb.fd()));
+
+    // the USBWorker loop: poll the port, ping when due
+    const auto t_end = SteadyClock::now() + std::chrono::milliseconds(3500);
+    uint64_t pings = 0;
+    while (SteadyClock::now() < t_end) {
+        link.poll(1);
+        const auto now = SteadyClock::now();
+        if (cs.due(now)) {
+            uint8_t f[kUsbPingLen + kUsbFrameExtra];
+            pings += link.send(f, cs.make_ping(now, f));
+        }
+    }
+    for (int i = 0; i < 20; ++i) link.poll(1);
+
+    const ClockSyncEstimate &e = cs.estimate();
+    const double now = ClockSync::seconds(SteadyClock::now());
+    const double off_err = std::fabs(e.host_to_mcu(now) - mcu.seconds(now));
+    const JitterStats d = cs.delay_stats();
+    std::printf("  %llu pings, %llu pongs, %llu exchanges, %llu rejected\n",
+                (unsigned long long)pings, (unsigned long long)sim.pongs(),
+                (unsigned long long)e.samples, (unsigned long long)cs.rejected());
+    std::printf("  offset error %.1f us, drift %.1f ppm (150), one-way %.0f us (min %.0f us)\n",
+                1e6 * off_err, 1e6 * e.drift, 1e6 * e.one_way, 1e6 * e.one_way_min);
+    std::printf("  one-way delay: p50 %.0f us  p99 %.0f us  max %.0f us (simulated %.0f us + jitter)\n",
+                d.p50_us, d.p99_us, d.max_us, 1e6 * kDelay);
+    EXPECT_TRUE(e.valid);
+    EXPECT_TRUE(e.samples + cs.rejected() >= sim.pongs() - 1 && e.samples > 200);
+    EXPECT_TRUE(off_err < 150e-6);
+    EXPECT_TRUE(std::fabs(e.drift - 150e-6) < 50e-6);
+    EXPECT_TRUE(e.one_way > kDelay && e.one_way < kDelay + 400e-6);
+
+    link.detach();
+}
+
+int main() {
+    test_unwrap();
+    test_synthetic();
+    test_pty_mcu();
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all clock sync tests passed\n";
+    return 0;
+}
@@ -0,0 +1,353 @@
+/*
+ * test_command_streamer.cc
+ *
+ * Fixed-rate command stage (calibur/worker/command_streamer.hpp): setpoint
+ * extrapolation and staleness, rebasing onto the gimbal attitude at send
+ * time (from the IMU history), jitter percentiles, the setpoint rate a
+ * serial link carries (and what streaming past it does to setpoint age),
+ * and a live 1 kHz / 500 Hz run fed by irregular predictions of a moving
+ * target.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 -pthread -I calibur/worker tests/test_command_streamer.cc \
+ *       calibur/worker/command_streamer.cpp -o test_command_streamer
+ *
+ * Run:
+ *   ./test_command_streamer
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+
+#include "command_streamer.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+using SteadyClock = std::chrono::steady_clock;
+
+// Same fields as PredictionOut, without the OpenCV / Eigen includes.
+struct Cmd {
+    float yaw = 0.0f, pitch = 0.0f;
+    int   aim = 0, fire = 0, chase = 0;
+    float yaw_rate = 0.0f, pitch_rate = 0.0f;
+    SteadyClock::time_point timestamp;
+    float att_yaw = 0.0f, att_pitch = 0.0f;
+    bool  att_valid = false;
+};
+
+static SteadyClock::time_point at(SteadyClock::time_point t0, double s) {
+    return t0 + std::chrono::duration_cast<SteadyClock::duration>(std::chrono::duration<double>(s));
+}
+
+// ---------------------------------------------------------------------------
+
+static void test_extrapolate() {
+    std::cout << "[stream] extrapolation\n";
+    StreamerParams p;
+    p.max_extrapolation = 0.05f;
+    p.stale_after       = 0.25f;
+
+    const auto t0 = SteadyClock::now();
+    Cmd c;
+    c.yaw = 0.1f;  c.pitch = -0.02f;
+    c.yaw_rate = 2.0f;  c.pitch_rate = -0.5f;
+    c.aim = c.fire = c.chase = 1;
+    c.timestamp = t0;
+
+    Cmd e = extrapolate_command(c, at(t0, 0.010), p);
+    EXPECT_TRUE(std::fabs(e.yaw - 0.12f) < 1e-5f);
+    EXPECT_TRUE(std::fabs(e.pitch + 0.025f) < 1e-5f);
+    EXPECT_TRUE(e.fire == 1 && e.aim == 1 && e.chase == 1);
+
+    // older than the horizon: held at the horizon
+    e = extrapolate_command(c, at(t0, 0.200), p);
+    EXPECT_TRUE(std::fabs(e.yaw - 0.2f) < 1e-5f);
+    EXPECT_TRUE(e.fire == 1);
+
+    // stale: no fire / aim
+    e = extrapolate_command(c, at(t0, 0.300), p);
+    EXPECT_TRUE(e.fire == 0 && e.aim == 0 && e.chase == 1);
+
+    // clock read before the stamp: no backwards extrapolation
+    e = extrapolate_command(c, at(t0, -0.005), p);
+    EXPECT_TRUE(e.yaw == c.yaw && e.pitch == c.pitch);
+}
+
+// The gimbal slews toward a target moving at w while setpoints computed at
+// 100 Hz are streamed at 1 kHz. A command is applied relative to the
+// attitude on arrival, so the absolute aim is attitude(send) + command.
+static void test_rebase() {
+    std::cout << "[stream] rebase on a slewing gimbal\n";
+    StreamerParams p;
+    p.max_extrapolation = 0.05f;
+
+    const auto  t0    = SteadyClock::now();
+    const float w     = 1.5f;     // target, rad/s
+    const float slew  = 4.0f;     // gimbal, rad/s
+    auto target   = [&](double s) { return float(0.3 + w * s); };
+    auto attitude = [&](double s) { return float(-0.2 + slew * s); };
+
+    double max_err = 0.0, max_err_raw = 0.0;
+    Cmd c;
+    for (int k = 0; k < 100; ++k) {
+        const double s = k * 0.001;
+        if (k % 10 == 0) {
+            c.att_yaw   = attitude(s);
+            c.att_pitch = 0.05f;
+            c.att_valid = true;
+            c.yaw       = target(s) - c.att_yaw;
+            c.pitch     = -0.1f - c.att_pitch;
+            c.yaw_rate  = w;
+            c.timestamp = at(t0, s);
+        }
+        const float pitch_now = 0.05f + 0.5f * float(s);
+        const Cmd e = extrapolate_command(c, at(t0, s), p);
+        const Cmd r = rebase_command(e, attitude(s), pitch_now);
+        max_err     = std::max(max_err, double(std::fabs(attitude(s) + r.yaw - target(s))));
+        max_err     = std::max(max_err, double(std::fabs(pitch_now + r.pitch + 0.1f)));
+        max_err_raw = std::max(max_err_raw, double(std::fabs(attitude(s) + e.yaw - target(s))));
+    }
+    std::printf("  aim error: rebased %.2e rad, relative to compute-time pose %.2e rad\n",
+                max_err, max_err_raw);
+    EXPECT_TRUE(max_err < 1e-5);
+    EXPECT_TRUE(max_err_raw > 0.03);
+
+    // yaw difference across the +-pi seam is the short way round
+    c.yaw = 0.1f;  c.att_yaw = 3.1f;  c.att_valid = true;
+    Cmd r = rebase_command(c, -3.1f, 0.0f);
+    EXPECT_TRUE(std::fabs(r.yaw - (0.1f + 6.2f - 6.28318531f)) < 1e-4f);
+
+    // no attitude: unchanged
+    c.att_valid = false;
+    r = rebase_command(c, 1.0f, 1.0f);
+    EXPECT_TRUE(r.yaw == c.yaw && r.pitch == c.pitch);
+}
+
+// The path USBWorker takes: the attitude a setpoint was computed against and
+// the attitude at send time both come from the IMU history, whose yaw is
+// the IMU's own (far from 0 after start-up; the detector's initial_yaw is
+// not subtracted on either side). A still gimbal must leave the command as
+// computed; a turning one must hold the absolute setpoint.
+static void test_rebase_on_imu() {
+    std::cout << "[stream] rebase against the IMU history\n";
+    const auto t0 = SteadyClock::now();
+    const float deg = 3.14159265f / 180.0f;
+
+    ImuHistory still;
+    for (int k = 0; k <= 20; ++k) {
+        ImuSample s;
+        s.t = at(t0, k * 0.001);
+        s.euler_deg[0] = 4.0f;     // pitch
+        s.euler_deg[2] = 73.0f;    // yaw, as left at start-up
+        still.push(s);
+    }
+    Cmd c;
+    c.yaw = 0.12f;  c.pitch = -0.03f;
+    c.att_valid = imu_yaw_pitch_at(still, at(t0, 0.0), c.att_yaw, c.att_pitch);
+    EXPECT_TRUE(c.att_valid && std::fabs(c.att_yaw - 73.0f * deg) < 1e-5f);
+    Cmd r = rebase_command_at(c, still, at(t0, 0.015));
+    EXPECT_TRUE(std::fabs(r.yaw - c.yaw) < 1e-6f && std::fabs(r.pitch - c.pitch) < 1e-6f);
+    const float still_yaw = r.yaw;
+
+    // turning at 100 deg/s through the +-180 seam
+    ImuHistory turning;
+    for (int k = 0; k <= 20; ++k) {
+        ImuSample s;
+        s.t = at(t0, k * 0.001);
+        float y = 179.5f + 100.0f * k * 0.001f;
+        if (y >= 180.0f) y -= 360.0f;
+        s.euler_deg[2] = y;
+        turning.push(s);
+    }
+    c.att_valid = imu_yaw_pitch_at(turning, at(t0, 0.0), c.att_yaw, c.att_pitch);
+    r = rebase_command_at(c, turning, at(t0, 0.010));
+    // gimbal 1 deg further round: the command shrinks by as much
+    std::printf("  still: %+.4f -> %+.4f rad, turned 1 deg: %+.4f rad\n", c.yaw, still_yaw, r.yaw);
+    EXPECT_TRUE(std::fabs(r.yaw - (c.yaw - 1.0f * deg)) < 1e-4f);
+
+    // nothing recorded yet: sent as computed
+    ImuHistory empty;
+    r = rebase_command_at(c, empty, at(t0, 0.010));
+    EXPECT_TRUE(r.yaw == c.yaw && r.pitch == c.pitch);
+}
+
+static void test_histogram() {
+    std::cout << "[stream] jitter histogram\n";
+    JitterHistogram h;
+    for (int i = 0; i < 980; ++i) h.add(10.3);
+    for (int i = 0; i < 19; ++i)  h.add(200.0);
+    h.add(1e5);                                       // overflow bin
+    JitterStats s = h.stats(3);
+    std::printf("  mean %.1f  p50 %.1f  p99 %.1f  max %.1f us\n", s.mean_us, s.p50_us, s.p99_us, s.max_us);
+    EXPECT_TRUE(s.ticks == 1000 && s.missed == 3);
+    EXPECT_TRUE(s.p50_us == 11.0);
+    EXPECT_TRUE(s.p99_us == 201.0);
+    EXPECT_TRUE(s.max_us == 1e5);
+    EXPECT_TRUE(std::fabs(s.mean_us - (980 * 10.3 + 19 * 200.0 + 1e5) / 1000.0) < 1e-6);
+
+    h.reset();
+    EXPECT_TRUE(h.stats(0).ticks == 0);
+}
+
+// 30-byte setpoints over 115200 baud (11520 B/s), simulated in 0.1 ms
+// steps with the 4 KB SerialLink backlog in front of the wire. Sending on
+// every 1 kHz tick fills the backlog with setpoints ~350 ms old and then
+// drops; the capped rate with a skip while the last one is queued keeps
+// what goes on the wire fresh.
+static void test_link_rate() {
+    std::cout << "[stream] setpoint rate over a 115200 baud link\n";
+    const int    baud = 115200;
+    const size_t frame = 30;
+    const double full = link_command_rate(baud, frame, 1.0);
+    EXPECT_TRUE(std::fabs(full - 384.0) < 1e-9);
+    EXPECT_TRUE(link_command_rate(baud, frame, 0.75) >= 250.0);
+    EXPECT_TRUE(link_command_rate(0, frame, 1.0) == 0.0);
+
+    struct Result { double age_max_ms; uint64_t sent, dropped, skipped; };
+    auto run = [&](double rate_hz, bool skip_queued) {
+        const double dt = 1e-4, bytes_per_s = baud / 10.0;
+        std::deque<double> stamps;     // per queued setpoint: when it was computed
+        double   queued = 0.0;         // bytes not on the wire yet
+        double   next_tick = 0.0, front_left = 0.0;
+        Result   r{0.0, 0, 0, 0};
+        for (double t = 0.0; t < 2.0; t += dt) {
+            if (t >= next_tick) {
+                next_tick += 1.0 / rate_hz;
+                if (skip_queued && queued >= double(frame)) {
+                    ++r.skipped;
+                } else if (queued + frame > 4096.0) {
+                    ++r.dropped;
+                } else {
+                    if (stamps.empty()) front_left = double(frame);
+                    stamps.push_back(t);
+                    queued += double(frame);
+                    ++r.sent;
+                }
+            }
+            // the wire
+            double out = bytes_per_s * dt;
+            while (out > 0.0 && !stamps.empty()) {
+                const double take = std::min(out, front_left);
+                front_left -= take;
+                queued     -= take;
+                out        -= take;
+                if (front_left <= 1e-9) {
+                    r.age_max_ms = std::max(r.age_max_ms, 1e3 * (t - stamps.front()));
+                    stamps.pop_front();
+                    front_left = double(frame);
+                }
+            }
+        }
+        return r;
+    };
+    const Result over  = run(1000.0, false);
+    const Result capped = run(250.0, true);
+    std::printf("  1 kHz unchecked: setpoints up to %.0f ms old on the wire, %llu dropped; "
+                "250 Hz skipping while queued: %.1f ms, %llu skipped\n",
+                over.age_max_ms, (unsigned long long)over.dropped, capped.age_max_ms,
+                (unsigned long long)capped.skipped);
+    EXPECT_TRUE(over.age_max_ms > 300.0 && over.dropped > 0);
+    EXPECT_TRUE(capped.age_max_ms < 5.0);
+    EXPECT_TRUE(capped.skipped == 0);
+}
+
+// Target yaw(t) = y0 + w t, predictions published every 8..25 ms (PF-like),
+// each stamped when computed and carrying the rate. Commands are checked
+// against the true yaw at the instant they are sent.
+static void live_run(double rate_hz, double seconds) {
+    std::printf("[stream] live %.0f Hz, %.1f s\n", rate_hz, seconds);
+    const float y0 = 0.3f, w = 2.0f;
+    const auto t0 = SteadyClock::now();
+    auto truth = [&](SteadyClock::time_point t) {
+        return y0 + w * std::chrono::duration<float>(t - t0).count();
+    };
+
+    std::shared_ptr<Cmd> latest;
+    std::atomic<bool> stop{false};
+
+    std::thread publisher([&] {
+        std::mt19937 rng(3);
+        std::uniform_int_distribution<int> gap_us(8000, 25000);
+        while (!stop.load()) {
+            Cmd c;
+            c.timestamp = SteadyClock::now();
+            c.yaw       = truth(c.timestamp);
+            c.yaw_rate  = w;
+            c.aim = c.fire = 1;
+            std::atomic_store(&latest, std::make_shared<Cmd>(c));
+            std::this_thread::sleep_for(std::chrono::microseconds(gap_us(rng)));
+        }
+    });
+
+    StreamerParams p;
+    p.rate_hz       = rate_hz;
+    p.report_period = 0.0;
+    CommandStreamer streamer(p);
+
+    uint64_t sent = 0;
+    double max_err = 0.0, max_err_hold = 0.0;
+    const auto t_end = at(t0, seconds);
+    std::thread stopper([&] {
+        std::this_thread::sleep_until(t_end);
+        stop.store(true);
+    });
+
+    const bool ok = streamer.run(stop, [&](SteadyClock::time_point now) {
+        const std::shared_ptr<Cmd> c = std::atomic_load(&latest);
+        if (!c) return;
+        const Cmd e = extrapolate_command(*c, now, p);
+        max_err      = std::max(max_err, double(std::fabs(e.yaw - truth(now))));
+        max_err_hold = std::max(max_err_hold, double(std::fabs(c->yaw - truth(now))));
+        ++sent;
+    });
+    stopper.join();
+    publisher.join();
+
+    const JitterStats s = streamer.total();
+    const double expected = seconds * rate_hz;
+    std::printf("  %llu ticks + %llu missed (expected ~%.0f), %llu sent\n",
+                (unsigned long long)s.ticks, (unsigned long long)s.missed, expected,
+                (unsigned long long)sent);
+    std::printf("  jitter mean %.1f  p50 %.1f  p99 %.1f  max %.1f us\n",
+                s.mean_us, s.p50_us, s.p99_us, s.max_us);
+    std::printf("  yaw error: extrapolated %.2e rad, held %.2e rad\n", max_err, max_err_hold);
+
+    EXPECT_TRUE(ok);
+    EXPECT_TRUE(std::fabs(double(s.ticks + s.missed) - expected) < 0.05 * expected + 5);
+    EXPECT_TRUE(sent + 5 >= s.ticks && sent <= s.ticks);
+    EXPECT_TRUE(s.p50_us < 1000.0);
+    EXPECT_TRUE(max_err < 1e-4);
+    EXPECT_TRUE(max_err_hold > 0.01);
+}
+
+int main() {
+    test_extrapolate();
+    test_rebase();
+    test_rebase_on_imu();
+    test_histogram();
+    test_link_rate();
+    live_run(1000.0, 1.0);
+    live_run(500.0, 0.5);
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all command streamer tests passed\n";
+    return 0;
+}
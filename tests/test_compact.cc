@@ -0,0 +1,341 @@
+/*
+ * test_compact.cc
+ *
+ * Compact particle storage (compact.hpp): fp16 / bf16 codecs, pack/unpack of
+ * one particle, filter accuracy of the 16-bit modes against fp32 on synthetic
+ * trajectories, and step time / bytes per particle. CPU backend only, no CUDA
+ * needed.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O3 -fno-math-errno -march=native -I calibur/pf -I calibur/worker \
+ *       tests/test_compact.cc calibur/pf/rbpf_cpu.cpp calibur/pf/resample.cpp \
+ *       calibur/pf/kld.cpp calibur/pf/posterior.cpp -o test_compact
+ *
+ * Run:
+ *   ./test_compact
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "rbpf_cpu.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+// ---------------------------------------------------------------------------
+
+static void test_f16_codec() {
+    std::cout << "[compact] fp16 codec\n";
+
+    // every non-NaN half survives decode -> encode
+    bool roundtrip = true, soft_decode = true;
+    for (uint32_t h = 0; h < 0x10000u; ++h) {
+        const float f = f16_to_f32_soft(uint16_t(h));
+        if (f16_to_f32(uint16_t(h)) != f && !std::isnan(f)) soft_decode = false;
+        if (std::isnan(f)) continue;
+        if (f32_to_f16_soft(f) != h || f32_to_f16(f) != h) roundtrip = false;
+    }
+    EXPECT_TRUE(roundtrip);
+    EXPECT_TRUE(soft_decode);
+
+    // encode is round-to-nearest(-even) and matches the hardware path
+    std::mt19937 rng(11);
+    bool nearest = true, same = true;
+    for (int k = 0; k < 1000000; ++k) {
+        const uint32_t bits = rng();
+        float f;
+        std::memcpy(&f, &bits, 4);
+        if (std::isnan(f)) continue;
+        const uint16_t h = f32_to_f16_soft(f);
+        if (h != f32_to_f16(f)) same = false;
+        if (std::fabs(f) >= 65520.0f) {
+            if ((h & 0x7FFFu) != 0x7C00u) nearest = false;
+            continue;
+        }
+        const double e  = std::fabs(double(f16_to_f32(h)) - f);
+        const double lo = std::fabs(double(f16_to_f32(uint16_t(h - 1))) - f);
+        const double hi = std::fabs(double(f16_to_f32(uint16_t(h + 1))) - f);
+        if ((h & 0x7FFFu) != 0 && e > lo) nearest = false;
+        if ((h & 0x7FFFu) < 0x7BFFu && e > hi) nearest = false;
+    }
+    EXPECT_TRUE(nearest);
+    EXPECT_TRUE(same);
+
+    // ties to even, overflow, subnormals
+    EXPECT_TRUE(f32_to_f16(1.0f + 1.0f / 2048.0f) == 0x3C00u);          // tie -> even
+    EXPECT_TRUE(f32_to_f16(1.0f + 3.0f / 2048.0f) == 0x3C02u);          // tie -> even
+    EXPECT_TRUE(f32_to_f16(65504.0f) == 0x7BFFu);
+    EXPECT_TRUE(f32_to_f16(65520.0f) == 0x7C00u);
+    EXPECT_TRUE(f32_to_f16(std::ldexp(1.0f, -24)) == 0x0001u);
+    EXPECT_TRUE(f32_to_f16(std::ldexp(1.0f, -26)) == 0x0000u);
+    EXPECT_TRUE(std::isnan(f16_to_f32(f32_to_f16(NAN))));
+}
+
+static void test_bf16_codec() {
+    std::cout << "[compact] bf16 codec\n";
+    bool roundtrip = true;
+    for (uint32_t h = 0; h < 0x10000u; ++h) {
+        const float f = bf16_to_f32(uint16_t(h));
+        if (std::isnan(f)) continue;
+        if (f32_to_bf16(f) != h) roundtrip = false;
+    }
+    EXPECT_TRUE(roundtrip);
+
+    std::mt19937 rng(12);
+    double worst = 0.0;
+    for (int k = 0; k < 1000000; ++k) {
+        const float f = std::ldexp(float(rng() % 100000 + 1) / 100000.0f, int(rng() % 60) - 30);
+        worst = std::max(worst, std::fabs(double(bf16_to_f32(f32_to_bf16(f))) - f) / f);
+    }
+    std::printf("  max rel err %.2e (bound 2^-8 = %.2e)\n", worst, std::ldexp(1.0, -8));
+    EXPECT_TRUE(worst <= std::ldexp(1.0, -8));
+    EXPECT_TRUE(f32_to_bf16(1.0f + 1.0f / 256.0f) == 0x3F80u);           // tie -> even
+    EXPECT_TRUE(std::isnan(bf16_to_f32(f32_to_bf16(NAN))));
+}
+
+static void test_pack_unpack() {
+    std::cout << "[compact] pack / unpack one particle\n";
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<float> u(-2.0f, 2.0f);
+
+    for (ParticleStorage s : {ParticleStorage::FP16, ParticleStorage::BF16}) {
+        const double tol = (s == ParticleStorage::FP16) ? std::ldexp(1.0, -11) : std::ldexp(1.0, -8);
+        RBPFParticleRegs a, b;
+        for (float &v : a.X) v = u(rng);
+        for (float &v : a.mean) v = u(rng);
+        for (float &v : a.Pvel) v = std::fabs(u(rng));
+        for (float &v : a.Pgeom) v = std::fabs(u(rng));
+        for (float &v : a.prev_pos) v = u(rng);
+        a.prev_yaw = u(rng);
+
+        RBPFPackedParticle p;
+        rbpf_pack_particle(a, s, p);
+        rbpf_unpack_particle(p, s, b);
+
+        bool exact = true, close = true;
+        for (int k : {IDX_TX, IDX_TY, IDX_TZ, IDX_VX, IDX_VY, IDX_VZ, IDX_YAW, IDX_OMEGA})
+            exact = exact && a.X[k] == b.X[k];
+        for (int k = 0; k < 4; ++k) exact = exact && a.mean[k] == b.mean[k];
+        for (int k = 0; k < 3; ++k) exact = exact && a.prev_pos[k] == b.prev_pos[k];
+        exact = exact && a.prev_yaw == b.prev_yaw;
+
+        auto near = [&](float x, float y) { return std::fabs(double(x) - y) <= tol * std::fabs(x); };
+        for (int k : {IDX_AX, IDX_AY, IDX_AZ, IDX_ALPHA, IDX_R1, IDX_R2, IDX_H})
+            close = close && near(a.X[k], b.X[k]);
+        for (int k = 4; k < KF_D; ++k) close = close && near(a.mean[k], b.mean[k]);
+        for (int k = 0; k < 4; ++k) close = close && near(a.Pvel[k], b.Pvel[k]);
+        for (int k = 0; k < 3; ++k) close = close && near(a.Pgeom[k], b.Pgeom[k]);
+
+        EXPECT_TRUE(exact);
+        EXPECT_TRUE(close);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Filter accuracy / cost
+
+struct Truth { float x, y, z, yaw; };
+
+static Truth truth_strafe(float t) {
+    return {0.3f * std::sin(3.14159f * t), 0.1f, 4.0f, 0.3f * std::sin(t)};
+}
+
+static Truth truth_spin(float t) {
+    // constant velocity + 6 rad/s spin
+    return {0.5f + 0.4f * t, 0.1f, 5.0f - 0.2f * t, wrap_to_pi(6.0f * t)};
+}
+
+struct RunStats {
+    double us_per_step = 0.0;
+    double rmse_pos    = 0.0;
+    double rmse_yaw    = 0.0;
+    double dev_pos     = 0.0;   // RMS distance of the mean from the fp32 run
+    double dev_geom    = 0.0;   // same for r1 / r2 / h
+    std::vector<float> means;   // [STEPS * D]
+};
+
+static RunStats run(Truth (*truth)(float), ParticleStorage s, int N, bool kld,
+                    const std::vector<float> *ref) {
+    constexpr float DT     = 0.01f;
+    constexpr int   STEPS  = 600;
+    constexpr int   WARMUP = 50;
+
+    RBPFPosYawModelCPU pf(N, default_params(), 1234ULL, s);
+    if (kld) {
+        KLDParams kp;
+        kp.min_particles = 500;
+        kp.max_particles = N;
+        pf.enable_kld(kp);
+    }
+
+    std::mt19937 rng(77);
+    std::normal_distribution<float> n_pos(0.0f, 0.03f);
+    std::normal_distribution<float> n_yaw(0.0f, 0.05f);
+    auto measure = [&](float t, float *z) {
+        const Truth g = truth(t);
+        for (int k = 0; k < D; ++k) z[k] = 0.0f;
+        z[IDX_TX]  = g.x + n_pos(rng);
+        z[IDX_TY]  = g.y + n_pos(rng);
+        z[IDX_TZ]  = g.z + n_pos(rng);
+        z[IDX_YAW] = wrap_to_pi(g.yaw + n_yaw(rng));
+        z[IDX_R1]  = 0.25f;
+        z[IDX_R2]  = 0.22f;
+        z[IDX_H]   = 0.05f;
+    };
+
+    float z[D], m[D];
+    measure(0.0f, z);
+    pf.reset(z);
+
+    RunStats rs;
+    rs.means.resize(size_t(STEPS) * D);
+    double se_pos = 0, se_yaw = 0, sd_pos = 0, sd_geom = 0, t_total = 0;
+    int counted = 0;
+    using clk = std::chrono::steady_clock;
+
+    for (int s_ = 1; s_ <= STEPS; ++s_) {
+        const float t = s_ * DT;
+        measure(t, z);
+        auto t0 = clk::now();
+        pf.step(z, DT);
+        pf.mean(m);
+        auto t1 = clk::now();
+        std::memcpy(&rs.means[size_t(s_ - 1) * D], m, sizeof(m));
+
+        if (s_ <= WARMUP) continue;
+        const Truth g = truth(t);
+        se_pos += (m[IDX_TX] - g.x) * (m[IDX_TX] - g.x)
+                + (m[IDX_TY] - g.y) * (m[IDX_TY] - g.y)
+                + (m[IDX_TZ] - g.z) * (m[IDX_TZ] - g.z);
+        const float dy = wrap_to_pi(m[IDX_YAW] - g.yaw);
+        se_yaw += dy * dy;
+        if (ref) {
+            const float *r = &(*ref)[size_t(s_ - 1) * D];
+            for (int k = 0; k < 3; ++k) {
+                sd_pos  += (m[IDX_TX + k] - r[IDX_TX + k]) * (m[IDX_TX + k] - r[IDX_TX + k]);
+                sd_geom += (m[IDX_R1 + k] - r[IDX_R1 + k]) * (m[IDX_R1 + k] - r[IDX_R1 + k]);
+            }
+        }
+        t_total += std::chrono::duration<double, std::micro>(t1 - t0).count();
+        ++counted;
+    }
+    rs.us_per_step = t_total / counted;
+    rs.rmse_pos    = std::sqrt(se_pos / counted);
+    rs.rmse_yaw    = std::sqrt(se_yaw / counted);
+    rs.dev_pos     = std::sqrt(sd_pos / counted);
+    rs.dev_geom    = std::sqrt(sd_geom / counted);
+    return rs;
+}
+
+static void benchmark_accuracy() {
+    struct Scenario { const char *name; Truth (*fn)(float); };
+    const Scenario scenarios[] = { {"strafe", truth_strafe}, {"spin", truth_spin} };
+
+    for (const auto &sc : scenarios) {
+        for (int N : {1000, 10000}) {
+            std::cout << "\n[benchmark] " << sc.name << ", N = " << N << " (600 steps @ 100 Hz)\n";
+            const RunStats f32 = run(sc.fn, ParticleStorage::FP32, N, false, nullptr);
+            std::printf("  %-5s %5zu B/particle %8.1f us/step  pos RMSE %.4f m  yaw RMSE %.4f rad\n",
+                        "fp32", RBPFPosYawModelCPU(1).bytes_per_particle(), f32.us_per_step,
+                        f32.rmse_pos, f32.rmse_yaw);
+            for (ParticleStorage s : {ParticleStorage::FP16, ParticleStorage::BF16}) {
+                const RunStats c = run(sc.fn, s, N, false, &f32.means);
+                std::printf("  %-5s %5zu B/particle %8.1f us/step  pos RMSE %.4f m  yaw RMSE %.4f rad"
+                            "  |mean - fp32|: pos %.1e m, geom %.1e m\n",
+                            particle_storage_name(s),
+                            RBPFPosYawModelCPU(1, default_params(), 1, s).bytes_per_particle(),
+                            c.us_per_step, c.rmse_pos, c.rmse_yaw, c.dev_pos, c.dev_geom);
+
+                // quantizing the slow fields must not cost tracking accuracy
+                EXPECT_TRUE(c.rmse_pos <= 1.2 * f32.rmse_pos + 0.002);
+                EXPECT_TRUE(c.rmse_yaw <= 1.2 * f32.rmse_yaw + 0.005);
+                EXPECT_TRUE(c.dev_geom < 0.01);
+            }
+        }
+    }
+}
+
+// Step time only, min over repetitions: 10k particles stay in cache, 1M
+// (132 / 100 MB) spill to DRAM where the narrower record pays off.
+static void benchmark_step_time() {
+    using clk = std::chrono::steady_clock;
+    for (int N : {10000, 1000000}) {
+        std::cout << "\n[benchmark] step time, N = " << N << "\n";
+        const int steps = (N > 100000) ? 8 : 60;
+        double base = 0.0;
+        for (ParticleStorage s : {ParticleStorage::FP32, ParticleStorage::FP16, ParticleStorage::BF16}) {
+            RBPFPosYawModelCPU pf(N, default_params(), 1234ULL, s);
+            float z[D] = {};
+            z[IDX_TZ] = 4.0f; z[IDX_R1] = z[IDX_R2] = 0.25f;
+            pf.reset(z);
+            float m[D];
+            double best = 1e30;
+            for (int k = 1; k <= steps; ++k) {
+                z[IDX_TX]  = 0.004f * k;
+                z[IDX_YAW] = wrap_to_pi(0.06f * k);
+                auto t0 = clk::now();
+                pf.step(z, 0.01f);
+                pf.mean(m);
+                if (k <= 3) continue;   // first touch of the back buffers
+                best = std::min(best, std::chrono::duration<double, std::micro>(clk::now() - t0).count());
+            }
+            if (s == ParticleStorage::FP32) base = best;
+            const double mb = double(pf.bytes_per_particle()) * N / 1e6;
+            std::printf("  %-5s %6.1f MB of particles  %10.1f us/step  (x%.2f vs fp32)\n",
+                        particle_storage_name(s), mb, best, base / best);
+        }
+    }
+}
+
+static void test_kld_and_checkpoints() {
+    std::cout << "\n[compact] KLD + checkpoints in fp16 mode\n";
+    const RunStats a = run(truth_spin, ParticleStorage::FP16, 10000, true, nullptr);
+    std::printf("  spin, adaptive N: pos RMSE %.4f m, yaw RMSE %.4f rad\n", a.rmse_pos, a.rmse_yaw);
+    EXPECT_TRUE(a.rmse_pos < 0.03);
+
+    // restore + replay reproduces the first pass bit for bit
+    RBPFPosYawModelCPU pf(2000, default_params(), 1234ULL, ParticleStorage::FP16);
+    RBPFCheckpointsCPU ck(pf, 2);
+    float z[D] = {};
+    z[IDX_TZ] = 4.0f; z[IDX_R1] = z[IDX_R2] = 0.25f;
+    pf.reset(z);
+    for (int s = 1; s <= 20; ++s) { z[IDX_TX] = 0.01f * s; pf.step(z, 0.01f); }
+    ck.checkpoint_save(0);
+    PosteriorSummary s1, s2;
+    for (int s = 21; s <= 40; ++s) { z[IDX_TX] = 0.01f * s; pf.step(z, 0.01f); }
+    pf.summary(s1);
+    ck.checkpoint_restore(0);
+    for (int s = 21; s <= 40; ++s) { z[IDX_TX] = 0.01f * s; pf.step(z, 0.01f); }
+    pf.summary(s2);
+    EXPECT_TRUE(std::memcmp(s1.mean, s2.mean, sizeof(s1.mean)) == 0);
+}
+
+int main() {
+    test_f16_codec();
+    test_bf16_codec();
+    test_pack_unpack();
+    benchmark_accuracy();
+    benchmark_step_time();
+    test_kld_and_checkpoints();
+
+    if (g_failures) {
+        std::cout << "\n" << g_failures << " check(s) FAILED\n";
+        return 1;
+    }
+    std::cout << "\nall compact tests passed\n";
+    return 0;
+}
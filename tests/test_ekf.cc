@@ -0,0 +1,242 @@
+/*
+ * test_ekf.cc
+ *
+ * EKF tracker (ekf.hpp) vs the RBPF on identical synthetic measurement
+ * streams: step cost and tracking error, yaw across +-pi, no heap allocation
+ * per step, OOSM checkpoint round trip. Both run behind the Tracker
+ * interface on the CPU, no CUDA needed.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O3 -I /usr/include/eigen3 -I calibur/pf -I calibur/worker \
+ *       tests/test_ekf.cc calibur/pf/ekf.cpp calibur/pf/oosm.cpp calibur/pf/rbpf_cpu.cpp \
+ *       calibur/pf/resample.cpp calibur/pf/kld.cpp calibur/pf/posterior.cpp -o test_ekf
+ *
+ * Run:
+ *   ./test_ekf
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <vector>
+
+#include <Eigen/Cholesky>
+#include "ekf.hpp"
+#include "rbpf_cpu.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+// heap allocation counter for the zero-allocation check
+static std::atomic<long> g_allocs{0};
+
+void *operator new(std::size_t n) {
+    ++g_allocs;
+    if (void *p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+// ---------------------------------------------------------------------------
+// Synthetic trajectories
+
+struct Truth { float x, y, z, yaw; };
+
+static Truth truth_stationary(float) {
+    return {0.5f, 0.1f, 4.0f, 0.3f};
+}
+
+static Truth truth_cv_spin(float t) {
+    // constant velocity, spinning top: yaw crosses +-pi every ~1 s
+    return {-1.0f + 0.5f * t, 0.1f, 4.0f - 0.3f * t, wrap_to_pi(6.0f * t)};
+}
+
+static Truth truth_manoeuvre(float t) {
+    return {0.8f * std::sin(0.8f * t), 0.1f + 0.05f * std::sin(3.0f * t),
+            5.0f + 0.5f * std::cos(0.6f * t), 0.8f * std::sin(2.0f * t)};
+}
+
+struct RunStats {
+    double us_per_step = 0.0;
+    double rmse_pos    = 0.0;
+    double rmse_yaw    = 0.0;
+};
+
+static RunStats run(Tracker &tr, Truth (*truth)(float)) {
+    constexpr float DT     = 0.01f;
+    constexpr int   STEPS  = 600;
+    constexpr int   WARMUP = 50;
+
+    std::mt19937 rng(77);   // same stream for every tracker
+    std::normal_distribution<float> n_pos(0.0f, 0.03f);
+    std::normal_distribution<float> n_yaw(0.0f, 0.05f);
+
+    auto measure = [&](float t, float *z) {
+        const Truth g = truth(t);
+        for (int k = 0; k < D; ++k) z[k] = 0.0f;
+        z[IDX_TX]  = g.x + n_pos(rng);
+        z[IDX_TY]  = g.y + n_pos(rng);
+        z[IDX_TZ]  = g.z + n_pos(rng);
+        z[IDX_YAW] = wrap_to_pi(g.yaw + n_yaw(rng));
+        z[IDX_R1]  = 0.25f;
+        z[IDX_R2]  = 0.25f;
+        z[IDX_H]   = 0.0f;
+    };
+
+    float z[D];
+    measure(0.0f, z);
+    tr.reset(z);
+
+    RunStats rs;
+    double se_pos = 0.0, se_yaw = 0.0, t_total = 0.0;
+    int counted = 0;
+    PosteriorSummary sm;
+    using clk = std::chrono::steady_clock;
+
+    for (int s = 1; s <= STEPS; ++s) {
+        const float t = s * DT;
+        measure(t, z);
+
+        auto t0 = clk::now();
+        tr.step(z, DT);
+        tr.request_estimate();
+        while (!tr.poll_estimate(sm)) {}
+        auto t1 = clk::now();
+
+        if (s <= WARMUP) continue;
+        const Truth g = truth(t);
+        const float *m = sm.mean;
+        se_pos += (m[IDX_TX] - g.x) * (m[IDX_TX] - g.x)
+                + (m[IDX_TY] - g.y) * (m[IDX_TY] - g.y)
+                + (m[IDX_TZ] - g.z) * (m[IDX_TZ] - g.z);
+        const float dy = wrap_to_pi(m[IDX_YAW] - g.yaw);
+        se_yaw += dy * dy;
+        t_total += std::chrono::duration<double, std::micro>(t1 - t0).count();
+        ++counted;
+    }
+
+    rs.us_per_step = t_total / counted;
+    rs.rmse_pos    = std::sqrt(se_pos / counted);
+    rs.rmse_yaw    = std::sqrt(se_yaw / counted);
+    return rs;
+}
+
+// ---------------------------------------------------------------------------
+
+static void test_no_allocation() {
+    std::cout << "[ekf] step() does not allocate\n";
+    EKFTracker ekf(4);
+    float z[D] = {};
+    z[IDX_TZ] = 4.0f; z[IDX_R1] = 0.25f; z[IDX_R2] = 0.25f;
+    ekf.reset(z);
+    ekf.step(z, 0.01f);
+
+    PosteriorSummary sm;
+    const long before = g_allocs.load();
+    for (int i = 0; i < 1000; ++i) {
+        z[IDX_TX] = 0.001f * i;
+        ekf.step(z, 0.01f);
+        ekf.poll_estimate(sm);
+        ekf.checkpoint_save(i % 4);
+    }
+    const long after = g_allocs.load();
+    std::cout << "  allocations in 1000 steps: " << (after - before) << "\n";
+    EXPECT_TRUE(after == before);
+}
+
+static void test_checkpoint() {
+    std::cout << "[ekf] checkpoint round trip\n";
+    EKFTracker ekf(2);
+    float z[D] = {};
+    z[IDX_TZ] = 4.0f; z[IDX_R1] = 0.25f; z[IDX_R2] = 0.25f;
+    ekf.reset(z);
+    for (int i = 0; i < 20; ++i) { z[IDX_TX] = 0.01f * i; ekf.step(z, 0.01f); }
+    ekf.checkpoint_save(1);
+    const EKFState saved = ekf.state();
+    for (int i = 0; i < 20; ++i) { z[IDX_TX] = 1.0f; ekf.step(z, 0.01f); }
+    ekf.checkpoint_restore(1);
+    EXPECT_TRUE(ekf.state().x == saved.x);
+    EXPECT_TRUE(ekf.state().P == saved.P);
+}
+
+static void test_covariance_sane() {
+    std::cout << "[ekf] covariance stays symmetric positive definite\n";
+    EKFTracker ekf(1);
+    std::mt19937 rng(1);
+    std::normal_distribution<float> nd(0.0f, 0.03f);
+    float z[D] = {};
+    z[IDX_TZ] = 4.0f; z[IDX_R1] = 0.25f; z[IDX_R2] = 0.25f;
+    ekf.reset(z);
+    for (int i = 0; i < 5000; ++i) {
+        const Truth g = truth_cv_spin(0.01f * i);
+        z[IDX_TX] = g.x + nd(rng); z[IDX_TY] = g.y + nd(rng); z[IDX_TZ] = g.z + nd(rng);
+        z[IDX_YAW] = wrap_to_pi(g.yaw + nd(rng));
+        ekf.step(z, (i % 7 == 0) ? 0.004f : 0.01f);   // irregular dt
+    }
+    const auto &P = ekf.state().P;
+    EXPECT_TRUE((P - P.transpose()).cwiseAbs().maxCoeff() < 1e-5f * P.cwiseAbs().maxCoeff());
+    const Eigen::LLT<EKFTracker::StateMat> llt(P);
+    EXPECT_TRUE(llt.info() == Eigen::Success);
+    EXPECT_TRUE(std::fabs(ekf.state().x(IDX_YAW)) <= RBPF_PI);
+}
+
+static void print_row(const char *name, const RunStats &r) {
+    std::printf("  %-10s %9.1f us/step  pos RMSE=%6.4f m  yaw RMSE=%6.4f rad\n",
+                name, r.us_per_step, r.rmse_pos, r.rmse_yaw);
+}
+
+static void benchmark_vs_rbpf() {
+    struct Scenario { const char *name; Truth (*fn)(float); };
+    const Scenario scenarios[] = {
+        {"stationary", truth_stationary},
+        {"cv+spin",    truth_cv_spin},
+        {"manoeuvre",  truth_manoeuvre},
+    };
+
+    for (const auto &sc : scenarios) {
+        std::cout << "\n[benchmark] " << sc.name << " (600 steps @ 100 Hz, same measurements)\n";
+        EKFTracker     ekf(2);
+        RBPFTrackerCPU rbpf1k(1000, 2);
+        RBPFTrackerCPU rbpf10k(10000, 2);
+        const RunStats e   = run(ekf, sc.fn);
+        const RunStats p1  = run(rbpf1k, sc.fn);
+        const RunStats p10 = run(rbpf10k, sc.fn);
+        print_row("ekf",        e);
+        print_row("rbpf 1k",    p1);
+        print_row("rbpf 10k",   p10);
+
+        EXPECT_TRUE(e.us_per_step < 0.1 * p1.us_per_step);
+        // on predictable motion the EKF should be in the RBPF's league
+        EXPECT_TRUE(e.rmse_pos < 2.0 * p10.rmse_pos + 0.01);
+        EXPECT_TRUE(e.rmse_yaw < 2.0 * p10.rmse_yaw + 0.02);
+    }
+}
+
+int main() {
+    test_no_allocation();
+    test_checkpoint();
+    test_covariance_sane();
+    benchmark_vs_rbpf();
+
+    if (g_failures) {
+        std::cout << "\n" << g_failures << " check(s) FAILED\n";
+        return 1;
+    }
+    std::cout << "\nall ekf tests passed\n";
+    return 0;
+}
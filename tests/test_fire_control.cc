@@ -0,0 +1,257 @@
+/*
+ * test_fire_control.cc
+ *
+ * Hit-probability fire decision (calibur/worker/fire_control.hpp): certain
+ * and uncertain posteriors, agreement with a plain scalar Monte-Carlo
+ * reference, plate selection on a spinning target, lead time, and the cost
+ * of one decision.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O3 -I calibur/worker tests/test_fire_control.cc \
+ *       calibur/worker/fire_control.cpp -o test_fire_control
+ *
+ * Run:
+ *   ./test_fire_control
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "fire_control.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+constexpr int N = ROBOT_STATE_VEC_LEN;
+
+// ---------------------------------------------------------------------------
+// Reference: same model written directly, libm trig, fresh random samples.
+
+static float wrap(float a) { return std::atan2(std::sin(a), std::cos(a)); }
+
+// Center of the plate facing the origin, for a state carried t seconds.
+static void facing_plate(const float *X, float t, float *plate) {
+    const float t2h = 0.5f * t * t;
+    float c[3];
+    for (int k = 0; k < 3; ++k)
+        c[k] = X[IDX_TX + k] + X[IDX_VX + k] * t + X[IDX_AX + k] * t2h;
+    const float yaw = X[IDX_YAW] + X[IDX_OMEGA] * t + X[IDX_ALPHA] * t2h;
+    const float los = std::atan2(-c[0], c[2]);
+    int best = 0;
+    float best_d = 1e9f;
+    for (int k = 0; k < 4; ++k) {
+        const float dk = std::fabs(wrap(yaw - k * float(M_PI_2) - los));
+        if (dk < best_d) { best_d = dk; best = k; }
+    }
+    const float yk = yaw - best * float(M_PI_2);
+    const float r  = (best & 1) ? X[IDX_R2] : X[IDX_R1];
+    plate[0] = c[0] + r * std::sin(yk);
+    plate[1] = c[1] - ((best & 1) ? X[IDX_H] : 0.0f);
+    plate[2] = c[2] - r * std::cos(yk);
+}
+
+static double reference_prob(const float *mean, const float *var, float t, const float *aim,
+                             const FireControlParams &p, int samples, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> nd(0.0f, 1.0f);
+    const float range = std::sqrt(aim[0] * aim[0] + aim[1] * aim[1] + aim[2] * aim[2]);
+    int hits = 0;
+    for (int s = 0; s < samples; ++s) {
+        float X[N];
+        for (int k = 0; k < N; ++k) X[k] = mean[k] + std::sqrt(var[k]) * nd(rng);
+
+        float plate[3];
+        facing_plate(X, t, plate);
+        const float t2h = 0.5f * t * t;
+        const float cx = mean[IDX_TX] + mean[IDX_VX] * t + mean[IDX_AX] * t2h;
+        const float cz = mean[IDX_TZ] + mean[IDX_VZ] * t + mean[IDX_AZ] * t2h;
+        const float los = std::atan2(-cx, cz);
+        const float yaw = X[IDX_YAW] + X[IDX_OMEGA] * t + X[IDX_ALPHA] * t2h;
+        float rel = 1e9f;
+        for (int k = 0; k < 4; ++k) {
+            const float dk = wrap(yaw - k * float(M_PI_2) - los);
+            if (std::fabs(dk) < std::fabs(rel)) rel = dk;
+        }
+
+        const float ch = std::sqrt(cx * cx + cz * cz);
+        const float lat = (aim[0] - plate[0]) * cz / ch - (aim[2] - plate[2]) * cx / ch
+                        + p.gun_sigma * range * nd(rng);
+        const float ver = aim[1] - plate[1] + p.gun_sigma * range * nd(rng);
+        hits += std::fabs(lat) < p.plate_half_w * std::cos(rel) && std::fabs(ver) < p.plate_half_h;
+    }
+    return double(hits) / samples;
+}
+
+// Robot 4 m ahead, slightly left and below the muzzle.
+static void base_state(float *X, float *V) {
+    for (int k = 0; k < N; ++k) { X[k] = 0.0f; V[k] = 1e-8f; }
+    X[IDX_TX] = -0.4f;  X[IDX_TY] = -0.2f;  X[IDX_TZ] = 4.0f;
+    X[IDX_YAW] = 0.2f;
+    X[IDX_R1] = 0.25f;  X[IDX_R2] = 0.22f;  X[IDX_H] = 0.05f;
+}
+
+// ---------------------------------------------------------------------------
+
+static void test_certain() {
+    std::cout << "[fire] certain posterior\n";
+    FireControl fc;
+    float X[N], V[N], aim[3];
+    base_state(X, V);
+    facing_plate(X, 0.0f, aim);
+
+    FireDecision d = fc.evaluate(X, V, 0.0f, aim);
+    std::printf("  on plate: p %.3f  range %.2f m\n", d.hit_prob, d.range);
+    EXPECT_TRUE(d.hit_prob > 0.95f && d.fire);
+
+    // off by more than a half plate sideways / vertically
+    float off[3] = {aim[0] + 0.12f, aim[1], aim[2]};
+    d = fc.evaluate(X, V, 0.0f, off);
+    EXPECT_TRUE(d.hit_prob < 0.02f && !d.fire);
+    float low[3] = {aim[0], aim[1] - 0.06f, aim[2]};
+    d = fc.evaluate(X, V, 0.0f, low);
+    EXPECT_TRUE(d.hit_prob < 0.02f && !d.fire);
+
+    // a plate seen at 40 deg is narrower (51.7 mm half width): 55 mm sideways
+    // is mostly a hit face-on, mostly a miss oblique (gun spread ~11 mm)
+    float Xa[N], Va[N];
+    base_state(Xa, Va);
+    Xa[IDX_TX] = 0.0f;
+    Xa[IDX_YAW] = 0.0f;
+    facing_plate(Xa, 0.0f, aim);
+    float side[3] = {aim[0] + 0.055f, aim[1], aim[2]};
+    const float p_face = fc.evaluate(Xa, Va, 0.0f, side).hit_prob;
+    Xa[IDX_YAW] = 0.7f;
+    facing_plate(Xa, 0.0f, aim);
+    side[0] = aim[0] + 0.055f; side[1] = aim[1]; side[2] = aim[2];
+    const float p_oblique = fc.evaluate(Xa, Va, 0.0f, side).hit_prob;
+    std::printf("  5.5 cm off-center: face-on p %.3f, 40 deg p %.3f\n", p_face, p_oblique);
+    EXPECT_TRUE(p_face > 0.8f && p_oblique < 0.45f);
+
+    // NaN posterior never fires
+    V[IDX_TX] = NAN;
+    EXPECT_TRUE(!fc.evaluate(X, V, 0.0f, aim).fire);
+}
+
+static void test_vs_reference() {
+    std::cout << "[fire] vs scalar Monte-Carlo reference\n";
+    FireControlParams p;
+    p.samples = 4096;
+    FireControl fc(p);
+
+    struct Case { const char *name; float pos_sd, yaw_sd, vel_sd, t; float aim_dx; };
+    const Case cases[] = {
+        {"tight",          0.005f, 0.02f, 0.02f, 0.00f, 0.00f},
+        {"pos 3 cm",       0.03f,  0.05f, 0.05f, 0.00f, 0.00f},
+        {"pos 3 cm, off",  0.03f,  0.05f, 0.05f, 0.00f, 0.04f},
+        {"vel 0.5, lead",  0.01f,  0.05f, 0.50f, 0.15f, 0.00f},
+        {"yaw 0.6 rad",    0.01f,  0.60f, 0.05f, 0.10f, 0.00f},
+    };
+    double max_err = 0.0;
+    for (const Case &c : cases) {
+        float X[N], V[N], aim[3];
+        base_state(X, V);
+        X[IDX_VX] = 1.0f;
+        X[IDX_OMEGA] = 4.0f;
+        for (int k = 0; k < 3; ++k) {
+            V[IDX_TX + k] = c.pos_sd * c.pos_sd;
+            V[IDX_VX + k] = c.vel_sd * c.vel_sd;
+        }
+        V[IDX_YAW] = c.yaw_sd * c.yaw_sd;
+        V[IDX_R1] = V[IDX_R2] = 1e-4f;
+        facing_plate(X, c.t, aim);
+        aim[0] += c.aim_dx;
+
+        const float  got = fc.evaluate(X, V, c.t, aim).hit_prob;
+        const double ref = reference_prob(X, V, c.t, aim, p, 200000, 5);
+        std::printf("  %-14s p %.3f  ref %.3f\n", c.name, got, ref);
+        max_err = std::max(max_err, std::fabs(got - ref));
+    }
+    EXPECT_TRUE(max_err < 0.03);
+}
+
+static void test_monotone_and_lead() {
+    std::cout << "[fire] uncertainty and lead\n";
+    FireControl fc;
+    float X[N], V[N], aim[3];
+    base_state(X, V);
+    facing_plate(X, 0.0f, aim);
+
+    // more spread -> lower probability
+    float prev = 1.1f;
+    bool monotone = true;
+    for (float sd : {0.0f, 0.01f, 0.02f, 0.04f, 0.08f, 0.16f}) {
+        for (int k = 0; k < 3; ++k) V[IDX_TX + k] = sd * sd + 1e-8f;
+        const float pk = fc.evaluate(X, V, 0.0f, aim).hit_prob;
+        monotone = monotone && pk <= prev + 1e-6f;
+        prev = pk;
+    }
+    EXPECT_TRUE(monotone);
+    EXPECT_TRUE(prev < 0.1f);
+
+    // spinning, strafing target: aim at where the plate will be at impact
+    base_state(X, V);
+    X[IDX_VX] = 1.5f;
+    X[IDX_OMEGA] = 6.0f;
+    for (int k = 0; k < N; ++k) V[k] = 1e-6f;
+    const float t = 0.2f;
+    facing_plate(X, t, aim);
+    const float p_lead = fc.evaluate(X, V, t, aim).hit_prob;
+    facing_plate(X, 0.0f, aim);
+    const float p_nolead = fc.evaluate(X, V, t, aim).hit_prob;
+    std::printf("  spinning target: aim with lead p %.3f, without p %.3f\n", p_lead, p_nolead);
+    EXPECT_TRUE(p_lead > 0.9f && p_nolead < 0.05f);
+
+    // deterministic
+    EXPECT_TRUE(fc.evaluate(X, V, t, aim).hit_prob == p_nolead);
+}
+
+static void bench() {
+    std::cout << "[fire] benchmark\n";
+    float X[N], V[N], aim[3];
+    base_state(X, V);
+    for (int k = 0; k < N; ++k) V[k] = 1e-3f;
+    facing_plate(X, 0.1f, aim);
+
+    for (int K : {64, 256, 1024}) {
+        FireControlParams p;
+        p.samples = K;
+        FireControl fc(p);
+        const int reps = 200000 / K;
+        volatile float sink = 0.0f;
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < reps; ++r) {
+            aim[0] += 1e-7f;
+            sink = sink + fc.evaluate(X, V, 0.1f, aim).hit_prob;
+        }
+        const double us = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - t0).count() / reps;
+        std::printf("  K = %4d: %6.2f us per decision (%.1f ns per sample)\n", K, us, 1e3 * us / K);
+        if (K == 256) EXPECT_TRUE(us < 20.0);
+    }
+}
+
+int main() {
+    test_certain();
+    test_vs_reference();
+    test_monotone_and_lead();
+    bench();
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all fire control tests passed\n";
+    return 0;
+}
@@ -0,0 +1,286 @@
+/*
+ * test_gimbal_model.cc
+ *
+ * Gimbal response model (calibur/worker/gimbal_model.hpp, gimbal_id.hpp):
+ * step-size dependent actuation delay, table vs direct simulation,
+ * feed-forward on a moving setpoint, identification from a synthetic
+ * command / IMU log, YAML round trip, and the per-call cost.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 -I calibur/worker -I apps/yaml-cpp/include \
+ *       tests/test_gimbal_model.cc calibur/worker/gimbal_model.cpp \
+ *       calibur/worker/gimbal_id.cpp apps/yaml-cpp/lib/libyaml-cpp.a -o test_gimbal_model
+ *
+ * Run:
+ *   ./test_gimbal_model
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "gimbal_model.hpp"
+#include "gimbal_id.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+// ---------------------------------------------------------------------------
+
+static void test_step_response() {
+    std::cout << "[gimbal] step-size dependent delay\n";
+    GimbalModelParams mp;
+    mp.yaw = {30.0f, 0.7f, 0.008f, 6.0f};
+    GimbalModel m(mp);
+    const GimbalAxisModel &a = m.yaw();
+
+    for (float s : {0.002f, 0.02f, 0.1f, 0.3f, 0.6f, 1.0f})
+        std::printf("  step %.3f rad: delay %6.1f ms  overshoot %.4f rad\n",
+                    s, 1e3f * a.delay(s), a.overshoot(s));
+
+    // inside the band from the start: dead time only
+    EXPECT_TRUE(std::fabs(a.delay(0.004f) - 0.008f) < 1e-6f);
+    EXPECT_TRUE(std::fabs(a.delay(-0.004f) - 0.008f) < 1e-6f);
+
+    // slewing: a large step takes at least step / rate_limit
+    EXPECT_TRUE(a.delay(1.0f) > 1.0f / 6.0f + 0.008f);
+    EXPECT_TRUE(a.delay(1.0f) > 2.0f * a.delay(0.1f));
+    EXPECT_TRUE(a.delay(0.6f) < a.delay(1.0f));
+
+    // past the table: clamped to the last entry
+    EXPECT_TRUE(a.delay(5.0f) == a.delay(mp.max_step));
+
+    // linear regime (no slew limit): settle time ~ ln(1/(tol/A)) / (zeta wn),
+    // grows only slowly with the step
+    GimbalModelParams lin = mp;
+    lin.yaw.rate_limit = 1e3f;
+    GimbalModel ml(lin);
+    EXPECT_TRUE(ml.yaw().delay(1.0f) < 0.4f);
+    EXPECT_TRUE(ml.yaw().overshoot(1.0f) > 0.03f);   // zeta 0.7: ~4.6 %
+}
+
+static void test_table_vs_direct() {
+    std::cout << "[gimbal] table vs direct simulation\n";
+    GimbalModelParams mp;
+    mp.yaw = {25.0f, 0.6f, 0.01f, 8.0f};
+    GimbalModel m(mp);
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> us(0.0f, mp.max_step);
+    std::vector<float> err;
+    for (int i = 0; i < 400; ++i) {
+        const float s = us(rng);
+        err.push_back(std::fabs(m.yaw().delay(s) - gimbal_step_response(mp.yaw, s, mp).settle));
+    }
+    std::sort(err.begin(), err.end());
+    const float p50 = err[err.size() / 2], p95 = err[err.size() * 95 / 100];
+    std::printf("  delay error p50 %.2f ms  p95 %.2f ms  max %.2f ms\n",
+                1e3f * p50, 1e3f * p95, 1e3f * err.back());
+    EXPECT_TRUE(p50 < 0.5e-3f);
+    EXPECT_TRUE(p95 < 3e-3f);
+}
+
+// Setpoint moving at constant rate: with u = theta_d(t + dead_time) the axis
+// still lags by 2 zeta / wn * rate; the feed-forward removes it.
+static void test_feed_forward() {
+    std::cout << "[gimbal] feed-forward on a moving setpoint\n";
+    const GimbalAxisParams p{30.0f, 0.7f, 0.008f, 12.0f};
+    GimbalModelParams grid;
+    GimbalAxisModel a(p, grid);
+
+    auto track = [&](bool ff, float w0, float acc) {
+        const float dt = 1e-4f;
+        float theta = 0.0f, omega = w0, max_err = 0.0f;
+        for (int i = 0; i < 10000; ++i) {             // 1 s
+            const float t  = i * dt;
+            const float td = t - p.dead_time;          // what the delayed input sees
+            // setpoint issued at td, led by the dead time so it refers to t
+            const float lead = td + p.dead_time;
+            float u = w0 * lead + 0.5f * acc * lead * lead;
+            if (ff) u += a.feed_forward(w0 + acc * lead, acc);
+            gimbal_axis_step(p, u, dt, theta, omega);
+            const float truth = w0 * (t + dt) + 0.5f * acc * (t + dt) * (t + dt);
+            if (t > 0.5f) max_err = std::max(max_err, std::fabs(theta - truth));
+        }
+        return max_err;
+    };
+
+    const float lag_plain = track(false, 2.0f, 0.0f);
+    const float lag_ff    = track(true, 2.0f, 0.0f);
+    const float acc_plain = track(false, 1.0f, 4.0f);
+    const float acc_ff    = track(true, 1.0f, 4.0f);
+    std::printf("  ramp 2 rad/s:      lag %.4f rad, with ff %.6f rad (2 zeta/wn w = %.4f)\n",
+                lag_plain, lag_ff, 2.0f * p.zeta / p.wn * 2.0f);
+    std::printf("  accel 4 rad/s^2:   lag %.4f rad, with ff %.6f rad\n", acc_plain, acc_ff);
+    EXPECT_TRUE(std::fabs(lag_plain - 2.0f * p.zeta / p.wn * 2.0f) < 2e-3f);
+    EXPECT_TRUE(lag_ff < 1e-3f);
+    EXPECT_TRUE(acc_ff < 0.1f * acc_plain);
+}
+
+// Synthetic log: random steps, ramps and sweeps at 1 kHz through a known
+// plant, IMU noise added, written and read back, then identified.
+static std::vector<GimbalLogRecord> synth_log(const GimbalAxisParams truth[2], unsigned seed,
+                                              double seconds) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.0f, 2e-4f);
+    std::uniform_real_distribution<float> ustep(-0.8f, 0.8f), uhold(0.05f, 0.4f);
+
+    const double dt = 1e-3;
+    const int n = int(seconds / dt);
+    const int sub = 10;
+
+    std::vector<GimbalLogRecord> log(n);
+    float set[2] = {0, 0}, theta[2] = {0, 0}, omega[2] = {0, 0};
+    float hold_until = 0.0f, base[2] = {0, 0}, rate[2] = {0, 0};
+    std::vector<float> hist[2];
+
+    for (int i = 0; i < n; ++i) {
+        const float t = float(i * dt);
+        if (t >= hold_until) {            // new segment: step, or ramp from here
+            for (int a = 0; a < 2; ++a) {
+                base[a] = std::clamp(set[a] + ustep(rng), -1.0f, 1.0f);
+                rate[a] = (rng() % 2) ? ustep(rng) * 2.0f : 0.0f;
+            }
+            hold_until = t + uhold(rng);
+        }
+        for (int a = 0; a < 2; ++a) {
+            set[a] = base[a] + rate[a] * (t - (hold_until - 0.4f));
+            hist[a].push_back(set[a]);
+        }
+
+        log[i].t = 100.0 + i * dt;
+        for (int a = 0; a < 2; ++a) {
+            log[i].set[a]  = set[a];
+            log[i].meas[a] = theta[a] + noise(rng);
+        }
+
+        // advance the plant to the next sample, input delayed by dead time
+        for (int a = 0; a < 2; ++a) {
+            for (int k = 1; k <= sub; ++k) {
+                const double td = (i + double(k) / sub) * dt - truth[a].dead_time;
+                const int j = int(std::floor(td / dt + 1e-9));
+                const float u = j >= 0 ? hist[a][std::min(j, i)] : 0.0f;
+                gimbal_axis_step(truth[a], u, float(dt / sub), theta[a], omega[a]);
+            }
+        }
+    }
+    return log;
+}
+
+static void test_identify() {
+    std::cout << "[gimbal] identification from a logged run\n";
+    const GimbalAxisParams truth[2] = {{22.0f, 0.55f, 0.012f, 6.0f},
+                                       {35.0f, 0.8f,  0.007f, 4.0f}};
+    const std::vector<GimbalLogRecord> gen = synth_log(truth, 11, 12.0);
+
+    const char *path = "/tmp/test_gimbal_log.csv";
+    {
+        GimbalLogWriter w;
+        EXPECT_TRUE(w.open(path));
+        for (const GimbalLogRecord &r : gen)
+            w.append(r.t, r.set[0], r.set[1], r.meas[0], r.meas[1]);
+    }
+    std::vector<GimbalLogRecord> log;
+    EXPECT_TRUE(gimbal_log_read(path, log));
+    EXPECT_TRUE(log.size() == gen.size());
+    std::remove(path);
+
+    for (int a = 0; a < 2; ++a) {
+        const auto t0 = std::chrono::steady_clock::now();
+        const GimbalFit fit = gimbal_identify_axis(log, a);
+        const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        const GimbalAxisParams &p = fit.params;
+        std::printf("  %-5s wn %5.1f (%4.1f)  zeta %.3f (%.2f)  dead %4.1f ms (%4.1f)  "
+                    "rate %5.2f (%4.1f)  rmse %.2e rad  %.1f s\n",
+                    a ? "pitch" : "yaw", p.wn, truth[a].wn, p.zeta, truth[a].zeta,
+                    1e3f * p.dead_time, 1e3f * truth[a].dead_time, p.rate_limit,
+                    truth[a].rate_limit, fit.rmse, s);
+        EXPECT_TRUE(fit.samples + 1 == log.size());
+        EXPECT_TRUE(std::fabs(p.wn / truth[a].wn - 1.0f) < 0.1f);
+        EXPECT_TRUE(std::fabs(p.zeta / truth[a].zeta - 1.0f) < 0.1f);
+        EXPECT_TRUE(std::fabs(p.dead_time - truth[a].dead_time) < 1.5e-3f);
+        EXPECT_TRUE(std::fabs(p.rate_limit / truth[a].rate_limit - 1.0f) < 0.1f);
+        EXPECT_TRUE(fit.rmse < 1e-3);
+
+        // the defaults fit clearly worse
+        const double def = gimbal_replay_rmse(log, a, GimbalAxisParams(), GimbalIdOptions());
+        EXPECT_TRUE(def > 3.0 * fit.rmse);
+    }
+}
+
+static void test_yaml() {
+    std::cout << "[gimbal] yaml round trip\n";
+    GimbalModelParams p;
+    p.yaw   = {21.5f, 0.61f, 0.013f, 5.5f};
+    p.pitch = {33.0f, 0.82f, 0.006f, 3.9f};
+    p.settle_tol = 0.004f;
+    const char *path = "/tmp/test_gimbal_model.yaml";
+    EXPECT_TRUE(gimbal_params_save(path, p, "identified from test\nsecond line"));
+
+    GimbalModelParams q;
+    EXPECT_TRUE(gimbal_params_load(path, q));
+    EXPECT_TRUE(q.yaw.wn == p.yaw.wn && q.yaw.zeta == p.yaw.zeta &&
+                q.yaw.dead_time == p.yaw.dead_time && q.yaw.rate_limit == p.yaw.rate_limit);
+    EXPECT_TRUE(q.pitch.wn == p.pitch.wn && q.pitch.rate_limit == p.pitch.rate_limit);
+    EXPECT_TRUE(q.settle_tol == p.settle_tol);
+    std::remove(path);
+
+    GimbalModelParams r;
+    EXPECT_TRUE(!gimbal_params_load("/nonexistent/gimbal.yaml", r));
+    EXPECT_TRUE(r.yaw.wn == GimbalAxisParams().wn);
+}
+
+static void bench() {
+    std::cout << "[gimbal] benchmark\n";
+    auto t0 = std::chrono::steady_clock::now();
+    GimbalModel m;
+    const double build_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - t0).count();
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> u(-1.5f, 1.5f);
+    std::vector<float> dy(4096), dp(4096);
+    for (size_t i = 0; i < dy.size(); ++i) { dy[i] = u(rng); dp[i] = 0.3f * u(rng); }
+
+    const int reps = 2000000;
+    volatile float sink = 0.0f;
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < reps; ++i) {
+        const size_t k = size_t(i) & 4095;
+        sink = sink + m.actuation_delay(dy[k], dp[k])
+                    + m.yaw().feed_forward(dy[k]) + m.pitch().feed_forward(dp[k]);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - t0).count() / reps;
+    std::printf("  build %.1f ms (2 x %d steps), delay + feed-forward %.1f ns per call\n",
+                build_ms, m.params().table_size, ns);
+    EXPECT_TRUE(ns < 200.0);
+}
+
+int main() {
+    test_step_response();
+    test_table_vs_direct();
+    test_feed_forward();
+    test_identify();
+    test_yaml();
+    bench();
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all gimbal model tests passed\n";
+    return 0;
+}
@@ -0,0 +1,402 @@
+/*
+ * test_hik_buffers.cc
+ *
+ * HikBufferPool (calibur/worker/hik_buffers.hpp): zero-copy acquisition
+ * on SDK-owned image buffers, against a mock SDK that models the node
+ * pool (fill, overwrite of unfetched frames, leased nodes the camera must
+ * skip, free validation, buffers still out at stop). Lease lifetime across
+ * threads, the must_copy limit, a publish / consume pipeline checking that
+ * no leased frame is overwritten while held, drain(), and the per-frame
+ * cost against the copying path.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 -pthread -I . tests/test_hik_buffers.cc calibur/worker/hik_buffers.cpp \
+ *       -o test_hik_buffers
+ *
+ * Run:
+ *   ./test_hik_buffers
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "calibur/worker/hik_buffers.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+using SteadyClock = std::chrono::steady_clock;
+
+// ---------------------------------------------------------------------------
+// Mock SDK: `nodes` image buffers. The camera thread fills a free node per
+// frame; with none free it overwrites the oldest unfetched one, and with
+// every node leased out it loses the frame. Each frame is the frame number
+// repeated over the whole buffer, so a reader can tell if it changed.
+
+struct MockCamera {
+    enum NodeState { NODE_FREE, NODE_FILLED, NODE_LEASED };
+
+    int    width = 1080, height = 1080;
+    double fps   = 200.0;
+
+    std::mutex              mtx;
+    std::condition_variable filled_cv;
+    std::vector<std::vector<uint32_t>> buf;
+    std::vector<NodeState>  state;
+    std::deque<int>         queue;     // filled nodes, oldest first
+    bool     grabbing   = false;
+    uint32_t frame_num  = 0;
+    uint64_t overwritten = 0, lost = 0, bad_free = 0, out_at_stop = 0, node_num_calls = 0;
+    std::thread       cam;
+    std::atomic<bool> run{false};
+
+    size_t bytes() const { return size_t(width) * height * 3; }
+
+    int set_nodes(unsigned int n) {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (grabbing) return int(MV_E_CALLORDER);
+        ++node_num_calls;
+        buf.assign(n, std::vector<uint32_t>(bytes() / 4));
+        state.assign(n, NODE_FREE);
+        return MV_OK;
+    }
+
+    void produce_one() {
+        std::lock_guard<std::mutex> lk(mtx);
+        int node = -1;
+        for (size_t i = 0; i < state.size(); ++i) {
+            if (state[i] == NODE_FREE) { node = int(i); break; }
+        }
+        if (node < 0 && !queue.empty()) {
+            node = queue.front();
+            queue.pop_front();
+            ++overwritten;
+        }
+        ++frame_num;
+        if (node < 0) { ++lost; return; }
+        std::fill(buf[node].begin(), buf[node].end(), frame_num);
+        state[node] = NODE_FILLED;
+        queue.push_back(node);
+        filled_cv.notify_one();
+    }
+
+    void start() {
+        if (state.empty()) set_nodes(8);
+        grabbing = true;
+        run = true;
+        cam = std::thread([this] {
+            auto next = SteadyClock::now();
+            while (run.load()) {
+                produce_one();
+                next += std::chrono::microseconds(int64_t(1e6 / fps));
+                std::this_thread::sleep_until(next);
+            }
+        });
+    }
+
+    void stop() {
+        run = false;
+        if (cam.joinable()) cam.join();
+        std::lock_guard<std::mutex> lk(mtx);
+        grabbing = false;
+        out_at_stop = uint64_t(std::count(state.begin(), state.end(), NODE_LEASED));
+    }
+
+    int get(MV_FRAME_OUT *f, unsigned int ms) {
+        std::unique_lock<std::mutex> lk(mtx);
+        if (!filled_cv.wait_for(lk, std::chrono::milliseconds(ms), [this] { return !queue.empty(); }))
+            return int(MV_E_NODATA);
+        const int node = queue.front();
+        queue.pop_front();
+        state[node] = NODE_LEASED;
+        std::memset(f, 0, sizeof(MV_FRAME_OUT));
+        f->pBufAddr                = reinterpret_cast<unsigned char *>(buf[node].data());
+        f->stFrameInfo.nWidth      = uint16_t(width);
+        f->stFrameInfo.nHeight     = uint16_t(height);
+        f->stFrameInfo.enPixelType = PixelType_Gvsp_BGR8_Packed;
+        f->stFrameInfo.nFrameNum   = buf[node][0];
+        f->stFrameInfo.nFrameLen   = unsigned(bytes());
+        return MV_OK;
+    }
+
+    int release(MV_FRAME_OUT *f) {
+        std::lock_guard<std::mutex> lk(mtx);
+        for (size_t i = 0; i < buf.size(); ++i) {
+            if (f->pBufAddr == reinterpret_cast<unsigned char *>(buf[i].data())) {
+                if (state[i] != NODE_LEASED) break;
+                state[i] = NODE_FREE;
+                return MV_OK;
+            }
+        }
+        ++bad_free;
+        return int(MV_E_PARAMETER);
+    }
+};
+
+static const HikSdk kMockSdk{
+    [](void *h, unsigned int n) { return static_cast<MockCamera *>(h)->set_nodes(n); },
+    [](void *h, MV_FRAME_OUT *f, unsigned int ms) { return static_cast<MockCamera *>(h)->get(f, ms); },
+    [](void *h, MV_FRAME_OUT *f) { return static_cast<MockCamera *>(h)->release(f); },
+};
+
+// the frame still holds the number it was handed out with
+static bool intact(const HikBuffer &b) {
+    const uint32_t *p = reinterpret_cast<const uint32_t *>(b.data);
+    const size_t n = size_t(b.info.nWidth) * b.info.nHeight * 3 / 4;
+    for (size_t i = 0; i < n; i += 4093) {
+        if (p[i] != b.info.nFrameNum) return false;
+    }
+    return p[n - 1] == b.info.nFrameNum;
+}
+
+// ---------------------------------------------------------------------------
+
+static void test_lease_lifetime() {
+    std::cout << "[hik buffers] lease lifetime\n";
+    MockCamera cam;
+    HikBufferParams p;
+    p.buffers = 4;
+    HikBufferPool pool(&cam, kMockSdk, p);
+    EXPECT_TRUE(pool.configure() == MV_OK && cam.node_num_calls == 1 && cam.buf.size() == 4);
+
+    HikBuffer b;
+    EXPECT_TRUE(pool.grab(5, b) != MV_OK && pool.stats().timeouts == 1);   // nothing captured yet
+    cam.produce_one();
+    EXPECT_TRUE(pool.grab(5, b) == MV_OK && b.info.nFrameNum == 1 && intact(b) && !b.must_copy);
+    EXPECT_TRUE(pool.stats().outstanding == 1);
+
+    // copies of the lease keep the buffer; the last one, on another
+    // thread, returns it
+    std::shared_ptr<void> copy = b.lease;
+    b.lease.reset();
+    EXPECT_TRUE(pool.stats().outstanding == 1);
+    std::thread([c = std::move(copy)]() mutable { c.reset(); }).join();
+    EXPECT_TRUE(pool.stats().outstanding == 0);
+    EXPECT_TRUE(std::count(cam.state.begin(), cam.state.end(), MockCamera::NODE_FREE) == 4);
+
+    // a lease outliving the pool still frees its buffer
+    cam.produce_one();
+    HikBuffer late;
+    {
+        HikBufferPool pool2(&cam, kMockSdk, p);
+        EXPECT_TRUE(pool2.grab(5, late) == MV_OK);
+    }
+    late.lease.reset();
+    EXPECT_TRUE(cam.bad_free == 0 && std::count(cam.state.begin(), cam.state.end(), MockCamera::NODE_FREE) == 4);
+}
+
+static void test_must_copy() {
+    std::cout << "[hik buffers] lease limit\n";
+    MockCamera cam;
+    HikBufferParams p;
+    p.buffers = 4;   // max_leased 2
+    HikBufferPool pool(&cam, kMockSdk, p);
+    pool.configure();
+    EXPECT_TRUE(pool.params().max_leased == 2);
+
+    std::vector<HikBuffer> held(4);
+    for (int i = 0; i < 4; ++i) {
+        cam.produce_one();
+        EXPECT_TRUE(pool.grab(5, held[i]) == MV_OK);
+    }
+    EXPECT_TRUE(!held[0].must_copy && !held[1].must_copy && held[2].must_copy && held[3].must_copy);
+
+    // every node leased out: the camera loses frames, the pool times out
+    cam.produce_one();
+    HikBuffer b;
+    EXPECT_TRUE(cam.lost == 1 && pool.grab(5, b) != MV_OK);
+
+    held[3].lease.reset();
+    cam.produce_one();
+    EXPECT_TRUE(pool.grab(5, b) == MV_OK && b.must_copy && b.info.nFrameNum == 6);
+    b.lease.reset();
+    for (HikBuffer &h : held) h.lease.reset();
+    EXPECT_TRUE(pool.stats().outstanding == 0 && pool.stats().copied == 3 && cam.bad_free == 0);
+}
+
+// The camera worker's shape: grab, publish the latest frame, consumers
+// pick it up and hold it for a while. A leased frame must never change
+// under a consumer and every buffer must be back after drain().
+static void test_pipeline() {
+    std::cout << "[hik buffers] publish / consume pipeline\n";
+    MockCamera cam;
+    cam.fps = 200.0;
+    HikBufferParams p;
+    p.buffers = 4;   // two held by consumers + the published one: some frames copied
+    HikBufferPool pool(&cam, kMockSdk, p);
+    pool.configure();
+    cam.start();
+
+    struct Frame {
+        HikBuffer buf;
+        std::vector<uint32_t> copy;   // must_copy frames
+    };
+    std::shared_ptr<Frame> latest;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> consumed{0}, changed{0};
+
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < 2; ++c) {
+        consumers.emplace_back([&, c] {
+            std::mt19937 rng(c + 1);
+            uint32_t last = 0;
+            while (!done.load()) {
+                std::shared_ptr<Frame> f = std::atomic_load(&latest);
+                if (!f || f->buf.info.nFrameNum == last) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(500));
+                    continue;
+                }
+                last = f->buf.info.nFrameNum;
+                const bool leased = f->copy.empty();
+                std::this_thread::sleep_for(std::chrono::microseconds(3000 + rng() % 12000));
+                if (leased && !intact(f->buf)) ++changed;
+                ++consumed;
+            }
+        });
+    }
+
+    uint64_t published = 0;
+    const auto t_end = SteadyClock::now() + std::chrono::milliseconds(1500);
+    while (SteadyClock::now() < t_end) {
+        auto f = std::make_shared<Frame>();
+        if (pool.grab(100, f->buf) != MV_OK) continue;
+        if (f->buf.must_copy) {
+            const uint32_t *src = reinterpret_cast<const uint32_t *>(f->buf.data);
+            f->copy.assign(src, src + f->buf.info.nFrameLen / 4);
+            f->buf.data = reinterpret_cast<const unsigned char *>(f->copy.data());
+            f->buf.lease.reset();
+        }
+        std::atomic_store(&latest, std::move(f));
+        ++published;
+    }
+    done = true;
+    for (auto &t : consumers) t.join();
+    std::atomic_store(&latest, std::shared_ptr<Frame>());
+    const bool drained = pool.drain(std::chrono::milliseconds(200));
+    cam.stop();
+
+    const HikBufferStats s = pool.stats();
+    std::printf("  %llu published, %llu consumed, %llu copied (lease limit), %llu overwritten unfetched,"
+                " %llu lost, %llu changed under a reader\n",
+                (unsigned long long)published, (unsigned long long)consumed, (unsigned long long)s.copied,
+                (unsigned long long)cam.overwritten, (unsigned long long)cam.lost,
+                (unsigned long long)changed.load());
+    EXPECT_TRUE(published > 200 && consumed > 100 && s.copied > 0 && s.copied < published);
+    EXPECT_TRUE(changed.load() == 0);
+    EXPECT_TRUE(drained && s.outstanding == 0 && cam.out_at_stop == 0);
+    EXPECT_TRUE(cam.bad_free == 0 && s.errors == 0);
+}
+
+static void test_drain() {
+    std::cout << "[hik buffers] drain\n";
+    MockCamera cam;
+    HikBufferPool pool(&cam, kMockSdk);
+    pool.configure();
+    cam.produce_one();
+    HikBuffer b;
+    EXPECT_TRUE(pool.grab(5, b) == MV_OK);
+
+    // released while drain() waits
+    std::thread t([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        b.lease.reset();
+    });
+    EXPECT_TRUE(pool.drain(std::chrono::milliseconds(500)));
+    t.join();
+    EXPECT_TRUE(cam.bad_free == 0 && std::count(cam.state.begin(), cam.state.end(), MockCamera::NODE_LEASED) == 0);
+
+    // a lease still out when drain() gives up is not freed into the
+    // stopped SDK
+    MockCamera cam2;
+    HikBufferPool pool2(&cam2, kMockSdk);
+    pool2.configure();
+    cam2.produce_one();
+    EXPECT_TRUE(pool2.grab(5, b) == MV_OK);
+    EXPECT_TRUE(!pool2.drain(std::chrono::milliseconds(20)));
+    b.lease.reset();
+    EXPECT_TRUE(cam2.bad_free == 0 && pool2.stats().outstanding == 0 && pool2.stats().errors == 0);
+
+    // wait_idle() (acquisition restart) keeps returning buffers to the SDK
+    MockCamera cam3;
+    HikBufferPool pool3(&cam3, kMockSdk);
+    pool3.configure();
+    cam3.produce_one();
+    EXPECT_TRUE(pool3.grab(5, b) == MV_OK);
+    EXPECT_TRUE(!pool3.wait_idle(std::chrono::milliseconds(20)));
+    b.lease.reset();
+    EXPECT_TRUE(pool3.wait_idle(std::chrono::milliseconds(20)));
+    EXPECT_TRUE(cam3.bad_free == 0 && std::count(cam3.state.begin(), cam3.state.end(), MockCamera::NODE_LEASED) == 0);
+    cam3.produce_one();
+    EXPECT_TRUE(pool3.grab(5, b) == MV_OK);
+    b.lease.reset();
+    EXPECT_TRUE(cam3.bad_free == 0 && pool3.stats().outstanding == 0);
+}
+
+// Per-frame cost of the old path (SDK copy into a static buffer, then
+// clone) against taking a lease, at 1080x1080 BGR.
+static void bench_copy_vs_lease() {
+    std::cout << "[hik buffers] per-frame cost, 1080x1080x3\n";
+    MockCamera cam;
+    HikBufferPool pool(&cam, kMockSdk);
+    pool.configure();
+    const size_t bytes = cam.bytes();
+    std::vector<unsigned char> staging(bytes);
+    const int n = 200;
+
+    double copy_us = 0.0, lease_us = 0.0;
+    uint64_t sink = 0;
+    for (int i = 0; i < n; ++i) {
+        cam.produce_one();
+        const auto t0 = SteadyClock::now();
+        HikBuffer b;
+        pool.grab(5, b);
+        std::memcpy(staging.data(), b.data, bytes);                       // GetOneFrameTimeout
+        std::vector<unsigned char> clone(staging.begin(), staging.end()); // bgr.clone()
+        b.lease.reset();
+        sink += clone[bytes / 2];
+        copy_us += std::chrono::duration<double, std::micro>(SteadyClock::now() - t0).count();
+    }
+    for (int i = 0; i < n; ++i) {
+        cam.produce_one();
+        const auto t0 = SteadyClock::now();
+        HikBuffer b;
+        pool.grab(5, b);
+        sink += b.data[bytes / 2];
+        b.lease.reset();
+        lease_us += std::chrono::duration<double, std::micro>(SteadyClock::now() - t0).count();
+    }
+    std::printf("  copy + clone %.0f us, lease %.1f us per frame (sink %llu)\n", copy_us / n, lease_us / n,
+                (unsigned long long)sink);
+    EXPECT_TRUE(lease_us < copy_us);
+}
+
+int main() {
+    test_lease_lifetime();
+    test_must_copy();
+    test_pipeline();
+    test_drain();
+    bench_copy_vs_lease();
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all hik buffer tests passed\n";
+    return 0;
+}
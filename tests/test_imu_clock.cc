@@ -0,0 +1,260 @@
+/*
+ * test_imu_clock.cc
+ *
+ * ImuClock (calibur/imu/imu_clock.hpp): IMU device tick -> host capture
+ * time. Synthetic streams with drift, one-sided arrival jitter, stalls
+ * with catch-up bursts, the 32-bit tick wrap and a device restart; then
+ * IMUReader against the pty IMU simulator (line transfer time, latency,
+ * drift, stalls), comparing mapped capture times with stamping on
+ * arrival.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 -pthread -I . tests/test_imu_clock.cc calibur/imu/imu_clock.cpp \
+ *       calibur/imu/imu_reader.cpp calibur/sim/pty_port.cpp calibur/sim/imu_sim.cpp \
+ *       -lutil -o test_imu_clock
+ *
+ * Run:
+ *   ./test_imu_clock
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "calibur/imu/imu_clock.hpp"
+#include "calibur/imu/imu_history.hpp"
+#include "calibur/imu/imu_reader.hpp"
+#include "calibur/sim/imu_sim.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+using SteadyClock = std::chrono::steady_clock;
+using TimePoint   = SteadyClock::time_point;
+
+static double percentile(std::vector<double> v, double q) {
+    if (v.empty()) return 0.0;
+    const size_t k = std::min(v.size() - 1, size_t(q * (v.size() - 1) + 0.5));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+static std::vector<double> abs_of(const std::vector<double> &v) {
+    std::vector<double> a(v.size());
+    for (size_t i = 0; i < v.size(); ++i) a[i] = std::fabs(v[i]);
+    return a;
+}
+
+// Synthetic IMU stream: sample k at host time t0 + k / rate, device tick
+// runs `drift` fast from tick0; the first byte reaches the host latency
+// later plus a one-sided delay, and stalls hold frames back until they
+// all arrive in one burst.
+struct Stream {
+    double   rate    = 1000.0;
+    double   drift   = 80e-6;
+    uint32_t tick0   = 0;
+    double   latency = 300e-6;
+    double   jitter  = 30e-6;    // half-normal sigma
+    double   stall_p = 0.01;
+    double   stall   = 3e-3;
+    double   t0      = 1000.0;   // host s
+    std::mt19937 rng{5};
+
+    double host_sample(uint64_t k) const { return t0 + k / rate; }
+    uint32_t tick(uint64_t k) const {
+        return uint32_t(uint64_t(tick0) + uint64_t(std::llround(k / rate * (1.0 + drift) * 1e6)));
+    }
+
+    // arrival times of n samples
+    std::vector<double> arrivals(uint64_t n) {
+        std::normal_distribution<double> g(0.0, jitter);
+        std::uniform_real_distribution<double> u(0.0, 1.0);
+        std::vector<double> a(n);
+        double held_until = 0.0;
+        for (uint64_t k = 0; k < n; ++k) {
+            double t = host_sample(k) + latency + std::fabs(g(rng));
+            if (u(rng) < stall_p) held_until = t + stall * (0.3 + u(rng));
+            a[k] = std::max(t, held_until);
+        }
+        return a;
+    }
+};
+
+// ---------------------------------------------------------------------------
+
+static void test_unwrap() {
+    std::cout << "[imu clock] tick unwrap\n";
+    ImuClock c;
+    Stream s;
+    s.tick0 = 0xFFFFFFFFu - 500000u;   // wraps 0.5 s in
+    double prev = -1.0;
+    bool monotonic = true;
+    for (uint64_t k = 0; k < 1500; ++k) {
+        c.on_sample(s.tick(k), ImuClock::time_point(s.host_sample(k) + s.latency));
+        const double d = c.device_seconds(s.tick(k));
+        if (d <= prev) monotonic = false;
+        prev = d;
+    }
+    EXPECT_TRUE(monotonic);
+    EXPECT_TRUE(prev > 4294.9 && prev < 4296.0);
+    // a tick slightly behind the latest (data-ready vs sample) stays close
+    EXPECT_TRUE(std::fabs(c.device_seconds(s.tick(1499) - 700) - (prev - 700e-6)) < 1e-9);
+    EXPECT_TRUE(std::fabs(c.device_seconds(s.tick(1499) + 700) - (prev + 700e-6)) < 1e-9);
+}
+
+static void test_mapping() {
+    std::cout << "[imu clock] drift, jitter, stalls, wrap\n";
+    Stream s;
+    s.tick0 = 0xFFFFFFFFu - 7000000u;   // wraps 7 s in
+    const uint64_t n = 20000;
+    const std::vector<double> arr = s.arrivals(n);
+
+    ImuClockParams p;
+    p.latency = s.latency;
+    ImuClock c(p);
+    std::vector<double> err, err_arrival;
+    for (uint64_t k = 0; k < n; ++k) {
+        const double t = ImuClock::seconds(c.on_sample(s.tick(k), ImuClock::time_point(arr[k])));
+        if (k < 3000) continue;   // after the slope settles
+        err.push_back(t - s.host_sample(k));
+        err_arrival.push_back(arr[k] - s.latency - s.host_sample(k));
+    }
+    const ImuClockEstimate &e = c.estimate();
+    const std::vector<double> ae = abs_of(err), aa = abs_of(err_arrival);
+    std::printf("  mapped: median %+.1f us, p99 |err| %.1f us, max %.1f us | on arrival: p99 %.1f us,"
+                " max %.1f us\n",
+                1e6 * percentile(err, 0.5), 1e6 * percentile(ae, 0.99), 1e6 * percentile(ae, 1.0),
+                1e6 * percentile(aa, 0.99), 1e6 * percentile(aa, 1.0));
+    std::printf("  drift %.2f ppm (80), sigma %.1f us, %d / %d rejected\n", 1e6 * e.drift(),
+                1e6 * e.sigma, e.rejected, e.used + e.rejected);
+
+    EXPECT_TRUE(e.valid && e.resets == 0);
+    EXPECT_TRUE(std::fabs(e.drift() - 80e-6) < 3e-6);
+    EXPECT_TRUE(std::fabs(percentile(err, 0.5)) < 40e-6);   // one-sided delay biases by its median
+    EXPECT_TRUE(percentile(ae, 0.99) < 60e-6);
+    EXPECT_TRUE(percentile(ae, 1.0) < 100e-6);
+    EXPECT_TRUE(percentile(aa, 0.99) > 5.0 * percentile(ae, 0.99));
+    EXPECT_TRUE(e.rejected > 0);
+
+    // data-ready stamp 400 us after the last sample stamp
+    TimePoint t_dr;
+    EXPECT_TRUE(c.to_host(s.tick(n - 1) + 400, t_dr));
+    EXPECT_TRUE(std::fabs(ImuClock::seconds(t_dr) - (s.host_sample(n - 1) + 400e-6 / (1.0 + s.drift))) < 60e-6);
+}
+
+static void test_restart() {
+    std::cout << "[imu clock] device restart\n";
+    Stream s;
+    const std::vector<double> arr = s.arrivals(8000);
+    ImuClockParams p;
+    p.latency = s.latency;
+    ImuClock c(p);
+    for (uint64_t k = 0; k < 4000; ++k) c.on_sample(s.tick(k), ImuClock::time_point(arr[k]));
+
+    // tick restarts from 0 at sample 4000; a single 40 ms stall before it
+    // must not count as one
+    c.on_sample(s.tick(4000), ImuClock::time_point(arr[4000] + 0.06));
+    EXPECT_TRUE(c.estimate().resets == 0);
+    std::vector<double> err;
+    for (uint64_t k = 4001; k < 8000; ++k) {
+        const uint32_t tick = uint32_t(std::llround((k - 4001) / s.rate * (1.0 + s.drift) * 1e6));
+        const double t = ImuClock::seconds(c.on_sample(tick, ImuClock::time_point(arr[k])));
+        if (k > 6000) err.push_back(std::fabs(t - s.host_sample(k)));
+    }
+    std::printf("  %llu resets, p99 |err| after %.1f us\n", (unsigned long long)c.estimate().resets,
+                1e6 * percentile(err, 0.99));
+    EXPECT_TRUE(c.estimate().resets == 1);
+    EXPECT_TRUE(percentile(err, 0.99) < 100e-6);
+}
+
+// IMUReader + history on the pty simulator: UART transfer time, 300 us
+// sample latency, 50 ppm drift, Gaussian jitter and 1% stalls.
+static void test_pty() {
+    std::cout << "[imu clock] IMUReader capture times on the pty simulator\n";
+    ImuSimParams sp;
+    sp.rate_hz       = 1000.0;
+    sp.jitter_us     = 30.0;
+    sp.latency_us    = 300.0;
+    sp.baud          = 460800;
+    sp.clock_drift   = 50e-6;
+    sp.tick_start_us = 0xFFFFFFFFu - 1500000u;
+    sp.stall_prob    = 0.01;
+    sp.stall_us      = 3000.0;
+    ImuSimulator sim(sp);
+    if (!sim.start()) {
+        std::cout << "  openpty failed, skipped\n";
+        return;
+    }
+    static ImuHistory h;
+    IMUReader reader(sim.device(), 460800, 0.2f);
+    ImuClockParams cp;
+    cp.latency = sp.latency_us * 1e-6;
+    reader.set_clock_params(cp);
+    reader.set_history(&h);
+    reader.start();
+
+    std::vector<double> err, err_arrival;
+    std::vector<bool> seen(65536, false);
+    const auto t_end = SteadyClock::now() + std::chrono::milliseconds(4000);
+    while (SteadyClock::now() < t_end) {
+        ImuSample s;
+        TimePoint t_emit;
+        if (h.latest(s) && !seen[s.seq] && sim.emitted_at(s.seq, t_emit)) {
+            seen[s.seq] = true;
+            const double truth = std::chrono::duration<double>(sim.start_time().time_since_epoch()).count() +
+                                 s.seq / sp.rate_hz;
+            if (s.seq > 2000) {
+                err.push_back(ImuClock::seconds(s.t) - truth);
+                // stamping at arrival with the known latency and transfer time
+                err_arrival.push_back(ImuClock::seconds(t_emit) - cp.latency - 80 * 10.0 / 460800 - truth);
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    const ImuClockEstimate e = reader.clock_estimate();
+    reader.stop();
+    const ImuSimStats st = sim.stats();
+    sim.stop();
+
+    const std::vector<double> ae = abs_of(err), aa = abs_of(err_arrival);
+    std::printf("  %zu samples (%llu stalled): mapped median %+.1f us, p90 |err| %.1f us, p99 %.1f us"
+                " | on arrival: p90 %.1f us, p99 %.1f us\n",
+                err.size(), (unsigned long long)st.stalled, 1e6 * percentile(err, 0.5),
+                1e6 * percentile(ae, 0.9), 1e6 * percentile(ae, 0.99), 1e6 * percentile(aa, 0.9),
+                1e6 * percentile(aa, 0.99));
+    std::printf("  drift %.1f ppm (50), sigma %.1f us, %d / %d rejected\n", 1e6 * e.drift(),
+                1e6 * e.sigma, e.rejected, e.used + e.rejected);
+
+    EXPECT_TRUE(err.size() > 500);
+    EXPECT_TRUE(e.valid && e.resets == 0);
+    EXPECT_TRUE(std::fabs(e.drift() - 50e-6) < 25e-6);
+    EXPECT_TRUE(std::fabs(percentile(err, 0.5)) < 150e-6);
+    EXPECT_TRUE(percentile(ae, 0.99) < percentile(aa, 0.99));
+}
+
+int main() {
+    test_unwrap();
+    test_mapping();
+    test_restart();
+    test_pty();
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all imu clock tests passed\n";
+    return 0;
+}
@@ -0,0 +1,289 @@
+/*
+ * test_imu_history.cc
+ *
+ * ImuHistory (calibur/imu/imu_history.hpp): SLERP / wrapped-angle
+ * interpolation, lookups inside and outside the retained window, torn-read
+ * detection with one writer and several readers racing over a recycling
+ * ring, lookup cost, and attitude-at-capture-time accuracy against the pty
+ * IMU simulator compared to taking the latest sample.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 -pthread -I . tests/test_imu_history.cc calibur/imu/imu_reader.cpp \
+ *       calibur/imu/imu_clock.cpp \
+ *       calibur/sim/pty_port.cpp calibur/sim/imu_sim.cpp -lutil -o test_imu_history
+ *
+ * Run:
+ *   ./test_imu_history
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "calibur/imu/imu_history.hpp"
+#include "calibur/imu/imu_reader.hpp"
+#include "calibur/sim/imu_sim.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+using SteadyClock = std::chrono::steady_clock;
+using TimePoint   = SteadyClock::time_point;
+
+static TimePoint at_us(int64_t us) {
+    return TimePoint(std::chrono::microseconds(us));
+}
+
+static double percentile(std::vector<double> v, double q) {
+    if (v.empty()) return 0.0;
+    const size_t k = std::min(v.size() - 1, size_t(q * (v.size() - 1) + 0.5));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+static float ang_diff(float a, float b) {
+    return std::fabs(std::fmod(a - b + 540.0f, 360.0f) - 180.0f);
+}
+
+static void yaw_quat(float deg, float *q) {
+    const float h = 0.5f * deg * 3.14159265f / 180.0f;
+    q[0] = std::cos(h); q[1] = 0.0f; q[2] = 0.0f; q[3] = std::sin(h);
+}
+
+// ---------------------------------------------------------------------------
+
+static void test_interpolation() {
+    std::cout << "[imu history] slerp and wrapped angles\n";
+    EXPECT_TRUE(std::fabs(imu_lerp_deg(170.0f, -170.0f, 0.5f) + 180.0f) < 1e-4f);
+    EXPECT_TRUE(std::fabs(imu_lerp_deg(170.0f, -170.0f, 0.25f) - 175.0f) < 1e-4f);
+    EXPECT_TRUE(std::fabs(imu_lerp_deg(-10.0f, 30.0f, 0.75f) - 20.0f) < 1e-4f);
+
+    float a[4], b[4], m[4], e[4];
+    yaw_quat(20.0f, a);
+    yaw_quat(100.0f, b);
+    imu_slerp(a, b, 0.25f, m);
+    yaw_quat(40.0f, e);
+    float err = 0.0f;
+    for (int i = 0; i < 4; ++i) err = std::max(err, std::fabs(m[i] - e[i]));
+    EXPECT_TRUE(err < 1e-5f);
+
+    // same rotation with the opposite sign: stays on the short arc
+    for (float &v : b) v = -v;
+    imu_slerp(a, b, 0.25f, m);
+    float dot = 0.0f;
+    for (int i = 0; i < 4; ++i) dot += m[i] * e[i];
+    EXPECT_TRUE(std::fabs(std::fabs(dot) - 1.0f) < 1e-5f);
+
+    // nearly parallel: nlerp branch, still unit
+    yaw_quat(20.001f, b);
+    imu_slerp(a, b, 0.5f, m);
+    float n = 0.0f;
+    for (float v : m) n += v * v;
+    EXPECT_TRUE(std::fabs(n - 1.0f) < 1e-6f);
+}
+
+static void test_lookup() {
+    std::cout << "[imu history] lookup window\n";
+    static ImuHistory h;
+    ImuSample s;
+    EXPECT_TRUE(!h.at(at_us(0), s) && !h.latest(s));
+
+    // 1 kHz, yaw ramps 90 deg/s through the +-180 wrap
+    const int n = 3000;
+    for (int i = 0; i < n; ++i) {
+        ImuSample x;
+        x.t   = at_us(1000000 + 1000 * int64_t(i));
+        x.seq = uint16_t(i);
+        x.euler_deg[2] = std::fmod(150.0f + 0.09f * i + 180.0f, 360.0f) - 180.0f;
+        yaw_quat(x.euler_deg[2], x.quat);
+        h.push(x);
+    }
+    EXPECT_TRUE(h.count() == n && h.latest(s) && s.seq == n - 1);
+
+    int bad = 0;
+    std::mt19937 rng(3);
+    const int64_t first_us = 1000000 + 1000 * int64_t(n - ImuHistory::kCapacity + ImuHistory::kGuard);
+    const int64_t last_us  = 1000000 + 1000 * int64_t(n - 1);
+    for (int k = 0; k < 2000; ++k) {
+        const int64_t t = first_us + int64_t(rng() % uint32_t(last_us - first_us));
+        if (!h.at(at_us(t), s)) { ++bad; continue; }
+        const float truth = 150.0f + 0.09f * float(t - 1000000) / 1000.0f;
+        float q[4];
+        yaw_quat(truth, q);
+        float d = 0.0f;
+        for (int i = 0; i < 4; ++i) d += q[i] * s.quat[i];
+        if (ang_diff(s.euler_deg[2], truth) > 2e-3f) ++bad;
+        if (std::fabs(std::fabs(d) - 1.0f) > 1e-6f) ++bad;
+    }
+    EXPECT_TRUE(bad == 0);
+
+    // past the newest: newest; before the window: none
+    EXPECT_TRUE(h.at(at_us(last_us + 5000), s) && s.seq == n - 1);
+    EXPECT_TRUE(!h.at(at_us(first_us - 1000), s));
+    EXPECT_TRUE(h.at(at_us(first_us), s));
+}
+
+// One writer recycling the ring as fast as it can, readers looking up
+// exact sample times: every result must be one whole sample.
+static void test_concurrent() {
+    std::cout << "[imu history] writer vs readers\n";
+    static ImuHistory h;
+    std::atomic<bool> done{false};
+    const uint64_t kSamples = 2000000;
+
+    std::thread writer([&] {
+        for (uint64_t i = 0; i < kSamples; ++i) {
+            ImuSample x;
+            x.t            = at_us(int64_t(i) * 1000);
+            x.seq          = uint16_t(i);
+            x.ts_sample_us = uint32_t(i);
+            for (int k = 0; k < 3; ++k) x.euler_deg[k] = x.gyro_dps[k] = float(i % 360) - 180.0f;
+            h.push(x);
+            if ((i & 1023) == 0) std::this_thread::yield();
+        }
+        done.store(true);
+    });
+
+    std::atomic<uint64_t> lookups{0}, found{0}, torn{0};
+    std::atomic<double>   ns_total{0.0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&, r] {
+            std::mt19937 rng(r + 11);
+            uint64_t n = 0, ok = 0, bad = 0;
+            const auto t0 = SteadyClock::now();
+            while (!done.load(std::memory_order_relaxed)) {
+                const uint64_t c = h.count();
+                if (c < 2) continue;
+                const uint64_t back = rng() % std::min<uint64_t>(c, ImuHistory::kCapacity);
+                const uint64_t i = c - 1 - back;
+                ImuSample s;
+                ++n;
+                if (!h.at(at_us(int64_t(i) * 1000), s)) continue;
+                ++ok;
+                const float v = float(s.ts_sample_us % 360) - 180.0f;
+                for (int k = 0; k < 3; ++k) {
+                    if (s.euler_deg[k] != v || s.gyro_dps[k] != v) { ++bad; break; }
+                }
+                if (s.seq != uint16_t(s.ts_sample_us) || s.ts_sample_us != i) ++bad;
+            }
+            const double ns = std::chrono::duration<double, std::nano>(SteadyClock::now() - t0).count();
+            lookups += n;
+            found += ok;
+            torn += bad;
+            double cur = ns_total.load();
+            while (!ns_total.compare_exchange_weak(cur, cur + ns / std::max<uint64_t>(n, 1))) {}
+        });
+    }
+    writer.join();
+    for (auto &t : readers) t.join();
+
+    std::printf("  %llu lookups, %llu found (rest recycled), %llu torn, ~%.0f ns per lookup\n",
+                (unsigned long long)lookups.load(), (unsigned long long)found.load(),
+                (unsigned long long)torn.load(), ns_total.load() / 2.0);
+    EXPECT_TRUE(torn.load() == 0);
+    EXPECT_TRUE(found.load() > lookups.load() / 2);
+}
+
+static void bench_lookup() {
+    std::cout << "[imu history] lookup cost\n";
+    static ImuHistory h;
+    for (int i = 0; i < 5000; ++i) {
+        ImuSample x;
+        x.t = at_us(1000 * int64_t(i));
+        yaw_quat(0.01f * i, x.quat);
+        h.push(x);
+    }
+    std::mt19937 rng(5);
+    float sink = 0.0f;
+    const int n = 1000000;
+    const auto t0 = SteadyClock::now();
+    for (int k = 0; k < n; ++k) {
+        ImuSample s;
+        h.at(at_us(4100000 + int64_t(rng() % 890000)), s);
+        sink += s.quat[3];
+    }
+    const double ns = std::chrono::duration<double, std::nano>(SteadyClock::now() - t0).count() / n;
+    std::printf("  %.0f ns per interpolated lookup (sink %.1f)\n", ns, sink);
+    EXPECT_TRUE(ns < 2000.0);
+}
+
+// Attitude at a past host time from the reader's history versus the latest
+// sample at that moment, against the simulator's ground truth.
+static void test_capture_time() {
+    std::cout << "[imu history] attitude at capture time on the pty simulator\n";
+    ImuSimParams p;
+    p.rate_hz    = 1000.0;
+    p.jitter_us  = 20.0;
+    p.latency_us = 0.0;
+    p.baud       = 460800;   // the reader takes the frame's transfer time off
+    p.yaw_amp    = 60.0f;
+    p.yaw_freq   = 1.0f;   // up to ~380 deg/s
+    ImuSimulator sim(p);
+    if (!sim.start()) {
+        std::cout << "  openpty failed, skipped\n";
+        return;
+    }
+    static ImuHistory h;
+    IMUReader reader(sim.device(), 460800, 0.2f);
+    reader.set_history(&h);
+    reader.start();
+
+    std::vector<double> err_at, err_latest;
+    std::mt19937 rng(9);
+    const auto t_end = SteadyClock::now() + std::chrono::milliseconds(1500);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    while (SteadyClock::now() < t_end) {
+        // "capture": now; look it up 5..30 ms later, as detection would
+        const TimePoint t_cap = SteadyClock::now();
+        ImuSample latest;
+        const bool have_latest = h.latest(latest);
+        std::this_thread::sleep_for(std::chrono::microseconds(5000 + rng() % 25000));
+
+        ImuSample s;
+        if (!have_latest || !h.at(t_cap, s)) continue;
+        // history stamps are capture times: the sample taken at t_cap
+        const double dev_t = std::chrono::duration<double>(t_cap - sim.start_time()).count();
+        const float truth = sim.sample(dev_t).euler_deg[2];
+        err_at.push_back(ang_diff(s.euler_deg[2], truth));
+        err_latest.push_back(ang_diff(latest.euler_deg[2], truth));
+    }
+    reader.stop();
+    sim.stop();
+
+    std::printf("  %zu captures: interpolated p50 %.3f p90 %.3f deg | latest sample p50 %.3f p90 %.3f deg\n",
+                err_at.size(), percentile(err_at, 0.5), percentile(err_at, 0.9),
+                percentile(err_latest, 0.5), percentile(err_latest, 0.9));
+    EXPECT_TRUE(err_at.size() > 30);
+    EXPECT_TRUE(percentile(err_at, 0.5) < percentile(err_latest, 0.5));
+    EXPECT_TRUE(percentile(err_at, 0.5) < 0.1);
+}
+
+int main() {
+    test_interpolation();
+    test_lookup();
+    test_concurrent();
+    bench_lookup();
+    test_capture_time();
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all imu history tests passed\n";
+    return 0;
+}
@@ -0,0 +1,329 @@
+/*
+ * test_imu_parser.cc
+ *
+ * ImuFrameParser (calibur/imu/imu_protocol.hpp): frames split at every
+ * boundary, bit flips, false headers and truncated frames, then parse
+ * throughput in memory and the poll-driven IMUReader against the pty IMU
+ * simulator, with the process CPU it costs compared to the old
+ * byte-at-a-time reader.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 -pthread -I . tests/test_imu_parser.cc calibur/imu/imu_reader.cpp \
+ *       calibur/imu/imu_clock.cpp \
+ *       calibur/sim/pty_port.cpp calibur/sim/imu_sim.cpp -lutil -o test_imu_parser
+ *
+ * Run:
+ *   ./test_imu_parser
+ */
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "calibur/imu/imu_protocol.hpp"
+#include "calibur/imu/imu_reader.hpp"
+#include "calibur/sim/imu_sim.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+using SteadyClock = std::chrono::steady_clock;
+
+static const ImuSimulator g_truth;
+
+static IMUData truth(uint16_t seq) {
+    return g_truth.sample(seq * 1e-3);
+}
+
+static bool same(const IMUData &a, const IMUData &b) {
+    for (int i = 0; i < 3; ++i) {
+        if (std::fabs(a.euler_deg[i] - b.euler_deg[i]) > 1e-5f) return false;
+        if (std::fabs(a.gyro_dps[i] - b.gyro_dps[i]) > 1e-5f) return false;
+        if (std::fabs(a.accel_mps2[i] - b.accel_mps2[i]) > 1e-5f) return false;
+    }
+    for (int i = 0; i < 4; ++i) {
+        if (std::fabs(a.quat[i] - b.quat[i]) > 1e-6f) return false;
+    }
+    return a.has_euler && a.has_quat && a.has_gyro && a.has_accel && a.has_temp &&
+           std::fabs(a.temp_c - b.temp_c) < 0.006f && a.ts_sample_us == b.ts_sample_us &&
+           a.fusion_state == b.fusion_state;
+}
+
+static size_t append_frame(std::vector<uint8_t> &out, uint16_t seq) {
+    uint8_t payload[IMU_MAX_PAYLOAD], frame[IMU_MAX_PAYLOAD + IMU_FRAME_EXTRA];
+    const size_t len = imu_encode_payload(truth(seq), payload);
+    const size_t n   = imu_encode_frame(seq, payload, len, frame);
+    out.insert(out.end(), frame, frame + n);
+    return n;
+}
+
+static double cpu_seconds() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+// ---------------------------------------------------------------------------
+
+static void test_split() {
+    std::cout << "[imu parser] frames split at every chunk size\n";
+    std::vector<uint8_t> stream;
+    for (uint16_t s = 0; s < 40; ++s) append_frame(stream, uint16_t(65520 + s));   // seq wraps
+
+    int bad_runs = 0;
+    for (size_t chunk = 1; chunk <= 300; ++chunk) {
+        ImuFrameParser parser;
+        uint16_t expect = 65520;
+        int got = 0, wrong = 0;
+        for (size_t i = 0; i < stream.size(); i += chunk) {
+            parser.feed(stream.data() + i, std::min(chunk, stream.size() - i), [&](const IMUData &d) {
+                if (d.seq != expect || !same(d, truth(d.seq))) ++wrong;
+                ++expect;
+                ++got;
+            });
+        }
+        if (got != 40 || wrong || parser.stats().skipped || parser.buffered()) ++bad_runs;
+    }
+    EXPECT_TRUE(bad_runs == 0);
+}
+
+static void test_direct_read() {
+    std::cout << "[imu parser] read() into the ring across its wrap\n";
+    std::vector<uint8_t> stream;
+    for (uint16_t s = 0; s < 200; ++s) append_frame(stream, s);
+
+    // odd-sized "reads" straight into write_ptr(), like IMUReader::drain
+    ImuFrameParser parser;
+    size_t off = 0, k = 0;
+    int got = 0, wrong = 0;
+    while (off < stream.size()) {
+        size_t room;
+        uint8_t *w = parser.write_ptr(room);
+        EXPECT_TRUE(room > 0);
+        const size_t n = std::min({room, stream.size() - off, size_t(97 + 61 * (k++ % 7))});
+        std::memcpy(w, stream.data() + off, n);
+        parser.commit(n);
+        off += n;
+        parser.parse([&](const IMUData &d) {
+            if (d.seq != got || !same(d, truth(d.seq))) ++wrong;
+            ++got;
+        });
+    }
+    EXPECT_TRUE(got == 200 && wrong == 0);
+    EXPECT_TRUE(stream.size() > 4 * ImuFrameParser::kRingSize);
+}
+
+static void test_faults() {
+    std::cout << "[imu parser] bit flips, false headers, truncated frames\n";
+    std::mt19937 rng(7);
+    std::vector<uint8_t> stream;
+    std::vector<bool> intact(5000, false);
+    int flipped = 0, truncated = 0, noise = 0;
+    for (uint16_t s = 0; s < 5000; ++s) {
+        const int fault = rng() % 20;
+        if (fault == 0) {
+            // noise with a false header and a plausible length
+            const uint8_t junk[] = {0x59, 0x53, uint8_t(rng()), uint8_t(rng()), uint8_t(rng() % 100)};
+            stream.insert(stream.end(), junk, junk + sizeof(junk));
+            ++noise;
+        }
+        const size_t start = stream.size();
+        const size_t n     = append_frame(stream, s);
+        if (fault == 1) {
+            stream[start + 2 + rng() % (n - 2)] ^= uint8_t(1u << (rng() % 8));
+            ++flipped;
+        } else if (fault == 2) {
+            stream.resize(start + 1 + rng() % (n - 1));
+            ++truncated;
+        } else {
+            intact[s] = true;
+        }
+    }
+
+    ImuFrameParser parser;
+    int got = 0, wrong = 0, missed = 0;
+    std::vector<bool> seen(5000, false);
+    for (size_t i = 0; i < stream.size(); i += 512) {
+        parser.feed(stream.data() + i, std::min<size_t>(512, stream.size() - i), [&](const IMUData &d) {
+            if (d.seq >= 5000 || !same(d, truth(d.seq))) { ++wrong; return; }
+            seen[d.seq] = true;
+            ++got;
+        });
+    }
+    int n_intact = 0;
+    for (int s = 0; s < 5000; ++s) {
+        n_intact += intact[s];
+        if (intact[s] && !seen[s]) ++missed;
+    }
+    std::printf("  %d flipped, %d truncated, %d false headers: %d / %d intact frames, %llu bad checksum\n",
+                flipped, truncated, noise, got, n_intact,
+                (unsigned long long)parser.stats().bad_checksum);
+    EXPECT_TRUE(wrong == 0);
+    EXPECT_TRUE(missed == 0);
+    EXPECT_TRUE(parser.stats().bad_checksum >= uint64_t(flipped));
+}
+
+static void bench_parse() {
+    std::cout << "[imu parser] throughput\n";
+    std::vector<uint8_t> stream;
+    for (int s = 0; s < 20000; ++s) append_frame(stream, uint16_t(s));
+
+    ImuFrameParser parser;
+    float sink = 0.0f;
+    const int reps = 20;
+    const auto t0 = SteadyClock::now();
+    for (int r = 0; r < reps; ++r) {
+        for (size_t i = 0; i < stream.size(); i += 1024) {
+            parser.feed(stream.data() + i, std::min<size_t>(1024, stream.size() - i),
+                        [&](const IMUData &d) { sink += d.euler_deg[2]; });
+        }
+    }
+    const double s = std::chrono::duration<double>(SteadyClock::now() - t0).count();
+    std::printf("  %.2f M frames/s, %.0f MB/s (%zu B/frame), sink %.1f\n",
+                reps * 20000 / s * 1e-6, reps * stream.size() / s * 1e-6, stream.size() / 20000, sink);
+    EXPECT_TRUE(parser.stats().frames == uint64_t(reps) * 20000);
+}
+
+// The reader this parser replaced: byte-wise header search on a
+// non-blocking fd, EAGAIN retried immediately, vectors per frame.
+class LegacyReader {
+public:
+    explicit LegacyReader(const std::string &dev) {
+        fd_ = ::open(dev.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+        termios tio{};
+        tcgetattr(fd_, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(fd_, TCSANOW, &tio);
+        running_.store(true);
+        thread_ = std::thread([this] {
+            while (running_.load()) {
+                uint8_t prev = 0, b = 0;
+                while (running_.load()) {
+                    if (::read(fd_, &b, 1) == 1) {
+                        if (prev == IMU_HDR0 && b == IMU_HDR1) break;
+                        prev = b;
+                    }
+                }
+                uint8_t head[3];
+                if (!read_exact(head, 3)) continue;
+                std::vector<uint8_t> payload(head[2]);
+                uint8_t ck[2];
+                if (!read_exact(payload.data(), payload.size()) || !read_exact(ck, 2)) continue;
+                std::vector<uint8_t> chk(head, head + 3);
+                chk.insert(chk.end(), payload.begin(), payload.end());
+                uint8_t ck1, ck2;
+                imu_checksum(chk.data(), chk.size(), ck1, ck2);
+                if (ck1 == ck[0] && ck2 == ck[1]) frames_.fetch_add(1);
+            }
+        });
+    }
+    ~LegacyReader() {
+        running_.store(false);
+        thread_.join();
+        ::close(fd_);
+    }
+    uint64_t frames() const { return frames_.load(); }
+
+private:
+    bool read_exact(uint8_t *p, size_t n) {
+        size_t got = 0;
+        while (got < n && running_.load()) {
+            const ssize_t r = ::read(fd_, p + got, n - got);
+            if (r > 0) got += size_t(r);
+        }
+        return got == n;
+    }
+
+    int fd_ = -1;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> frames_{0};
+    std::thread thread_;
+};
+
+// Process CPU over `secs` while the simulator streams and `reader` (0 none,
+// 1 IMUReader, 2 legacy) consumes; returns CPU percent, frames in `frames`.
+static double run_pty(double rate_hz, int reader, double secs, uint64_t &frames, uint64_t &sent) {
+    ImuSimParams p;
+    p.rate_hz   = rate_hz;
+    p.jitter_us = 0.0;
+    ImuSimulator sim(p);
+    frames = sent = 0;
+    if (!sim.start()) return -1.0;
+
+    IMUReader *imu = nullptr;
+    LegacyReader *legacy = nullptr;
+    if (reader == 1) { imu = new IMUReader(sim.device(), 460800, 0.2f); imu->start(); }
+    if (reader == 2) legacy = new LegacyReader(sim.device());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const uint64_t f0 = imu ? imu->stats().frames : legacy ? legacy->frames() : 0;
+    const uint64_t s0 = sim.stats().frames;
+    const double c0 = cpu_seconds();
+    const auto t0 = SteadyClock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(secs));
+    const double wall = std::chrono::duration<double>(SteadyClock::now() - t0).count();
+    const double cpu = cpu_seconds() - c0;
+    frames = (imu ? imu->stats().frames : legacy ? legacy->frames() : 0) - f0;
+    sent   = sim.stats().frames - s0;
+
+    delete imu;
+    delete legacy;
+    sim.stop();
+    return 100.0 * cpu / wall;
+}
+
+static void bench_pty() {
+    std::cout << "[imu parser] IMUReader on the pty simulator\n";
+    for (double rate : {1000.0, 4000.0}) {
+        uint64_t f, s;
+        const double base = run_pty(rate, 0, 1.5, f, s);
+        if (base < 0.0) {
+            std::cout << "  openpty failed, skipped\n";
+            return;
+        }
+        uint64_t f_new, s_new, f_old, s_old;
+        const double cpu_new = run_pty(rate, 1, 1.5, f_new, s_new) - base;
+        const double cpu_old = run_pty(rate, 2, 1.5, f_old, s_old) - base;
+        std::printf("  %5.0f Hz: poll reader %llu / %llu frames, %5.1f%% CPU | byte-wise spin %llu / %llu"
+                    " frames, %5.1f%% CPU\n",
+                    rate, (unsigned long long)f_new, (unsigned long long)s_new, cpu_new,
+                    (unsigned long long)f_old, (unsigned long long)s_old, cpu_old);
+        EXPECT_TRUE(f_new + 5 >= s_new && s_new > 0.5 * rate);
+        EXPECT_TRUE(cpu_new < 25.0);
+        EXPECT_TRUE(cpu_new < cpu_old);
+    }
+}
+
+int main() {
+    test_split();
+    test_direct_read();
+    test_faults();
+    bench_parse();
+    bench_pty();
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all imu parser tests passed\n";
+    return 0;
+}
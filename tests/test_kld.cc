@@ -0,0 +1,237 @@
+/*
+ * test_kld.cc
+ *
+ * KLD-sampling (adaptive particle count) for the RBPF: bound formula, bin
+ * counting, and a benchmark of fixed vs adaptive N on synthetic trajectories
+ * (step time, mean N / ESS, tracking error). CPU backend only, no CUDA needed.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O3 -I calibur/pf -I calibur/worker tests/test_kld.cc \
+ *       calibur/pf/rbpf_cpu.cpp calibur/pf/resample.cpp calibur/pf/kld.cpp \
+ *       calibur/pf/posterior.cpp -o test_kld
+ *
+ * Run:
+ *   ./test_kld
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "rbpf_cpu.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+// ---------------------------------------------------------------------------
+
+static void test_required_particles() {
+    std::cout << "[kld] n(k) bound\n";
+    KLDParams p;
+    p.min_particles = 1;
+    p.max_particles = 1 << 30;
+
+    // k = 100, eps = 0.05, z = 2.326 -> 990 * (1 - 2/891 + sqrt(2/891) * 2.326)^3
+    const double a   = 2.0 / 891.0;
+    const double ref = 990.0 * std::pow(1.0 - a + std::sqrt(a) * 2.326, 3.0);
+    const int n100 = kld_required_particles(100, p);
+    std::cout << "  n(100) = " << n100 << " (ref " << ref << ")\n";
+    EXPECT_TRUE(std::fabs(n100 - ref) <= 1.0);
+
+    int prev = 0;
+    bool monotone = true;
+    for (int k = 1; k < 5000; ++k) {
+        const int n = kld_required_particles(k, p);
+        if (n < prev) monotone = false;
+        prev = n;
+    }
+    EXPECT_TRUE(monotone);
+
+    // clamping
+    p.min_particles = 500;
+    p.max_particles = 4000;
+    EXPECT_TRUE(kld_required_particles(1, p)     == 500);
+    EXPECT_TRUE(kld_required_particles(2, p)     == 500);
+    EXPECT_TRUE(kld_required_particles(10000, p) == 4000);
+}
+
+static void test_bin_count() {
+    std::cout << "[kld] occupied bins vs std::set\n";
+    KLDParams p;
+    std::mt19937 rng(5);
+
+    for (float spread : {0.001f, 0.05f, 0.5f, 5.0f}) {
+        const int N = 5000;
+        std::normal_distribution<float> nd(0.0f, spread);
+        std::vector<float> X(size_t(N) * D, 0.0f);
+        std::set<uint64_t> ref;
+        for (int i = 0; i < N; ++i) {
+            float *Xi = &X[i * D];
+            Xi[IDX_TX]  = 1.0f + nd(rng);
+            Xi[IDX_TY]  = -0.3f + nd(rng);
+            Xi[IDX_TZ]  = 4.0f + nd(rng);
+            Xi[IDX_YAW] = wrap_to_pi(nd(rng));
+            ref.insert(kld_bin_key(Xi, p));
+        }
+        std::vector<uint64_t> table(kld_table_size(N));
+        const int k = cpu_kld_count_bins(X.data(), N, p, table.data(), int(table.size()));
+        std::cout << "  spread " << spread << ": " << k << " bins\n";
+        EXPECT_TRUE(k == int(ref.size()));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Synthetic trajectories
+
+struct Truth { float x, y, z, yaw; };
+
+static Truth truth_stationary(float) {
+    return {0.5f, 0.1f, 4.0f, 0.3f};
+}
+
+static Truth truth_strafe(float t) {
+    // +-0.3 m side-to-side at 0.5 Hz (peak 3 m/s^2), slow yaw wobble; the
+    // constant-acceleration model lags here with any N
+    return {0.3f * std::sin(3.14159f * t), 0.1f, 4.0f, 0.3f * std::sin(t)};
+}
+
+static Truth truth_manoeuvre(float t) {
+    // 2D drift plus fast yaw oscillation
+    return {0.8f * std::sin(0.8f * t), 0.1f + 0.05f * std::sin(3.0f * t),
+            5.0f + 0.5f * std::cos(0.6f * t), 0.8f * std::sin(2.0f * t)};
+}
+
+struct RunStats {
+    double us_per_step = 0.0;
+    double mean_N      = 0.0;
+    double mean_ess    = 0.0;
+    double rmse_pos    = 0.0;
+    double rmse_yaw    = 0.0;
+};
+
+static RunStats run(Truth (*truth)(float), bool adaptive) {
+    constexpr int   N_MAX  = 10000;
+    constexpr float DT     = 0.01f;
+    constexpr int   STEPS  = 600;
+    constexpr int   WARMUP = 50;
+
+    RBPFPosYawModelCPU pf(N_MAX);
+    if (adaptive) {
+        KLDParams kp;
+        kp.min_particles = 500;
+        kp.max_particles = N_MAX;
+        pf.enable_kld(kp);
+    }
+
+    std::mt19937 rng(77);
+    std::normal_distribution<float> n_pos(0.0f, 0.03f);
+    std::normal_distribution<float> n_yaw(0.0f, 0.05f);
+
+    auto measure = [&](float t, float *z) {
+        const Truth g = truth(t);
+        for (int k = 0; k < D; ++k) z[k] = 0.0f;
+        z[IDX_TX]  = g.x + n_pos(rng);
+        z[IDX_TY]  = g.y + n_pos(rng);
+        z[IDX_TZ]  = g.z + n_pos(rng);
+        z[IDX_YAW] = wrap_to_pi(g.yaw + n_yaw(rng));
+        z[IDX_R1]  = 0.25f;
+        z[IDX_R2]  = 0.25f;
+        z[IDX_H]   = 0.0f;
+    };
+
+    float z[D], m[D];
+    measure(0.0f, z);
+    pf.reset(z);
+
+    RunStats rs;
+    double se_pos = 0.0, se_yaw = 0.0, t_total = 0.0;
+    int counted = 0;
+    using clk = std::chrono::steady_clock;
+
+    for (int s = 1; s <= STEPS; ++s) {
+        const float t = s * DT;
+        measure(t, z);
+
+        auto t0 = clk::now();
+        pf.step(z, DT);
+        pf.mean(m);
+        auto t1 = clk::now();
+
+        if (s <= WARMUP) continue;
+        const Truth g = truth(t);
+        se_pos += (m[IDX_TX] - g.x) * (m[IDX_TX] - g.x)
+                + (m[IDX_TY] - g.y) * (m[IDX_TY] - g.y)
+                + (m[IDX_TZ] - g.z) * (m[IDX_TZ] - g.z);
+        const float dy = wrap_to_pi(m[IDX_YAW] - g.yaw);
+        se_yaw += dy * dy;
+        t_total += std::chrono::duration<double, std::micro>(t1 - t0).count();
+        rs.mean_N   += pf.telemetry.num_particles;
+        rs.mean_ess += pf.telemetry.ess;
+        ++counted;
+    }
+
+    rs.us_per_step = t_total / counted;
+    rs.mean_N     /= counted;
+    rs.mean_ess   /= counted;
+    rs.rmse_pos    = std::sqrt(se_pos / counted);
+    rs.rmse_yaw    = std::sqrt(se_yaw / counted);
+    return rs;
+}
+
+static void print_row(const char *name, const RunStats &r) {
+    std::printf("  %-10s %9.1f us/step  N=%7.0f  ESS=%7.0f  pos RMSE=%6.4f m  yaw RMSE=%6.4f rad\n",
+                name, r.us_per_step, r.mean_N, r.mean_ess, r.rmse_pos, r.rmse_yaw);
+}
+
+static void benchmark_trajectories() {
+    struct Scenario { const char *name; Truth (*fn)(float); };
+    const Scenario scenarios[] = {
+        {"stationary", truth_stationary},
+        {"strafe",     truth_strafe},
+        {"manoeuvre",  truth_manoeuvre},
+    };
+
+    for (const auto &sc : scenarios) {
+        std::cout << "\n[benchmark] " << sc.name << " (600 steps @ 100 Hz, N_max = 10000)\n";
+        const RunStats fixed    = run(sc.fn, false);
+        const RunStats adaptive = run(sc.fn, true);
+        print_row("fixed",    fixed);
+        print_row("adaptive", adaptive);
+
+        // adaptive must never fall behind the fixed filter by much
+        EXPECT_TRUE(adaptive.rmse_pos <= 1.5 * fixed.rmse_pos + 0.005);
+        EXPECT_TRUE(adaptive.rmse_yaw <= 1.5 * fixed.rmse_yaw + 0.005);
+        EXPECT_TRUE(adaptive.mean_N >= 500.0 && adaptive.mean_N <= 10000.0);
+
+        if (sc.fn == truth_stationary) {
+            // a concentrated posterior must release most of the budget
+            EXPECT_TRUE(adaptive.mean_N < 0.5 * fixed.mean_N);
+            EXPECT_TRUE(adaptive.us_per_step < fixed.us_per_step);
+        }
+    }
+}
+
+int main() {
+    test_required_particles();
+    test_bin_count();
+    benchmark_trajectories();
+
+    if (g_failures) {
+        std::cout << "\n" << g_failures << " check(s) FAILED\n";
+        return 1;
+    }
+    std::cout << "\nall kld tests passed\n";
+    return 0;
+}
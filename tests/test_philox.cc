@@ -0,0 +1,271 @@
+/*
+ * test_philox.cc
+ *
+ * Counter-based particle noise (philox.hpp): Philox4x32-10 known-answer
+ * vectors, scalar vs batched (SIMD) draws, accuracy of the libm-free
+ * Box-Muller transform, normal moments, bit-identical filter replay, and
+ * throughput against the old std::mt19937 + normal_distribution path.
+ * CPU backend only, no CUDA needed.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O3 -fno-math-errno -march=native -I calibur/pf -I calibur/worker \
+ *       tests/test_philox.cc calibur/pf/rbpf_cpu.cpp calibur/pf/resample.cpp \
+ *       calibur/pf/kld.cpp calibur/pf/posterior.cpp -o test_philox
+ *
+ * Run:
+ *   ./test_philox
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "rbpf_cpu.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+// ---------------------------------------------------------------------------
+
+static void test_known_answers() {
+    std::cout << "[philox] Random123 known-answer vectors\n";
+    struct Kat { uint32_t ctr[4]; uint32_t key[2]; uint32_t out[4]; };
+    const Kat kats[] = {
+        {{0, 0, 0, 0}, {0, 0},
+         {0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u}},
+        {{0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu}, {0xffffffffu, 0xffffffffu},
+         {0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu}},
+        {{0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u}, {0xa4093822u, 0x299f31d0u},
+         {0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u}},
+    };
+    for (const Kat &k : kats) {
+        uint32_t c[4] = {k.ctr[0], k.ctr[1], k.ctr[2], k.ctr[3]};
+        philox4x32_10(c, k.key[0], k.key[1]);
+        EXPECT_TRUE(std::memcmp(c, k.out, sizeof(c)) == 0);
+    }
+}
+
+static void test_batch_matches_scalar() {
+    std::cout << "[philox] batched draws == per-particle draws (bitwise)\n";
+    for (int n : {4, RBPF_ATTACH_NOISE, RBPF_PREDICT_NOISE}) {
+        for (int N : {1, 7, 8, 37, 1000}) {
+            const int stride = philox_batch_stride(n);
+            std::vector<float> batch(size_t(N) * stride);
+            philox_normals_batch(0xC0FFEEULL, PHILOX_PREDICT, 42u, N, n, batch.data());
+
+            bool same = true;
+            float one[16];
+            for (int i = 0; i < N; ++i) {
+                philox_normals(0xC0FFEEULL, PHILOX_PREDICT, uint32_t(i), 42u, one, n);
+                if (std::memcmp(one, &batch[size_t(i) * stride], n * sizeof(float)) != 0)
+                    same = false;
+            }
+            EXPECT_TRUE(same);
+        }
+    }
+}
+
+static void test_transform_accuracy() {
+    std::cout << "[philox] log / sincos polynomials vs libm (double)\n";
+    double err_log = 0.0, err_sc = 0.0;
+    std::mt19937 rng(3);
+    for (int k = 0; k < 2000000; ++k) {
+        const uint32_t x = rng();
+        const float u = philox_u01(x);
+        err_log = std::max(err_log, std::fabs(double(philox_log(u)) - std::log(double(u))));
+
+        float s, c;
+        philox_sincos_2pi(x, s, c);
+        const double t = double(int32_t(x) >> 8) / 16777216.0;
+        err_sc = std::max(err_sc, std::fabs(double(s) - std::sin(2.0 * M_PI * t)));
+        err_sc = std::max(err_sc, std::fabs(double(c) - std::cos(2.0 * M_PI * t)));
+    }
+    // the edges of the u grid
+    for (uint32_t x : {0u, 0xffu, 0x100u, 0x7fffffffu, 0xffffff00u, 0xffffffffu}) {
+        const float u = philox_u01(x);
+        err_log = std::max(err_log, std::fabs(double(philox_log(u)) - std::log(double(u))));
+    }
+    std::printf("  max |log err| = %.2e, max |sin/cos err| = %.2e\n", err_log, err_sc);
+    EXPECT_TRUE(err_log < 1e-6);
+    EXPECT_TRUE(err_sc < 1e-6);
+    EXPECT_TRUE(philox_log(1.0f) == 0.0f);
+}
+
+static void test_moments() {
+    std::cout << "[philox] normal moments over 16M draws\n";
+    const int N = 1 << 20;
+    const int n = 16;
+    std::vector<float> buf(size_t(N) * n);
+    philox_normals_batch(7ULL, PHILOX_PREDICT, 0u, N, n, buf.data());
+
+    double m1 = 0, m2 = 0, m3 = 0, m4 = 0, tail = 0, lag = 0;
+    for (size_t k = 0; k < buf.size(); ++k) {
+        const double v = buf[k];
+        m1 += v; m2 += v * v; m3 += v * v * v; m4 += v * v * v * v;
+        if (std::fabs(v) > 3.0) tail += 1.0;
+        if (k > 0) lag += v * buf[k - 1];
+    }
+    const double cnt = double(buf.size());
+    m1 /= cnt; m2 /= cnt; m3 /= cnt; m4 /= cnt; tail /= cnt; lag /= cnt;
+    std::printf("  mean %+.5f  var %.5f  skew %+.5f  kurt %.4f  P(|x|>3) %.5f  lag-1 corr %+.5f\n",
+                m1, m2, m3, m4, tail, lag);
+    EXPECT_TRUE(std::fabs(m1) < 2e-3);
+    EXPECT_TRUE(std::fabs(m2 - 1.0) < 3e-3);
+    EXPECT_TRUE(std::fabs(m3) < 5e-3);
+    EXPECT_TRUE(std::fabs(m4 - 3.0) < 2e-2);
+    EXPECT_TRUE(std::fabs(tail - 0.0026998) < 2e-4);
+    EXPECT_TRUE(std::fabs(lag) < 2e-3);
+
+    // neighbouring steps of one particle must not be correlated either
+    std::vector<float> a(size_t(N) * 12), b(size_t(N) * 12);
+    philox_normals_batch(7ULL, PHILOX_PREDICT, 100u, N, 11, a.data());
+    philox_normals_batch(7ULL, PHILOX_PREDICT, 101u, N, 11, b.data());
+    double cross = 0.0;
+    for (size_t k = 0; k < a.size(); ++k) cross += double(a[k]) * b[k];
+    cross /= double(a.size());
+    std::printf("  step t vs t+1 corr %+.5f\n", cross);
+    EXPECT_TRUE(std::fabs(cross) < 3e-3);
+}
+
+// ---------------------------------------------------------------------------
+// Filter replay
+
+static void measure(int s, float *z) {
+    const float t = 0.01f * s;
+    for (int k = 0; k < D; ++k) z[k] = 0.0f;
+    // deterministic "noisy" detections
+    z[IDX_TX]  = 0.4f * std::sin(1.3f * t) + 0.02f * std::sin(97.0f * t);
+    z[IDX_TY]  = 0.1f + 0.02f * std::cos(71.0f * t);
+    z[IDX_TZ]  = 4.0f + 0.3f * std::cos(0.7f * t);
+    z[IDX_YAW] = wrap_to_pi(3.0f * t + 0.04f * std::sin(53.0f * t));
+    z[IDX_R1]  = 0.25f;
+    z[IDX_R2]  = 0.25f;
+}
+
+static std::vector<PosteriorSummary> run_log(uint64_t seed, int steps) {
+    RBPFPosYawModelCPU pf(2000, default_params(), seed);
+    std::vector<PosteriorSummary> out(steps);
+    float z[D];
+    measure(0, z);
+    pf.reset(z);
+    for (int s = 1; s <= steps; ++s) {
+        measure(s, z);
+        pf.step(z, 0.01f);
+        pf.summary(out[s - 1]);
+    }
+    return out;
+}
+
+static bool same_summary(const PosteriorSummary &a, const PosteriorSummary &b) {
+    return std::memcmp(a.mean, b.mean, sizeof(a.mean)) == 0
+        && std::memcmp(a.var, b.var, sizeof(a.var)) == 0
+        && a.ess == b.ess && a.num_particles == b.num_particles;
+}
+
+static void test_replay_bit_identical() {
+    std::cout << "[philox] replayed log -> bit-identical filter output\n";
+    const auto a = run_log(1234ULL, 300);
+    const auto b = run_log(1234ULL, 300);
+    const auto c = run_log(4321ULL, 300);
+
+    bool ab = true, ac = true;
+    for (int s = 0; s < 300; ++s) {
+        ab = ab && same_summary(a[s], b[s]);
+        ac = ac && same_summary(a[s], c[s]);
+    }
+    EXPECT_TRUE(ab);
+    EXPECT_TRUE(!ac);
+
+    // checkpoint rollback rewinds the counters: re-running the same
+    // measurements after a restore reproduces the first pass exactly
+    RBPFPosYawModelCPU pf(2000);
+    RBPFCheckpointsCPU ck(pf, 2);
+    float z[D];
+    measure(0, z);
+    pf.reset(z);
+    for (int s = 1; s <= 50; ++s) { measure(s, z); pf.step(z, 0.01f); }
+    ck.checkpoint_save(0);
+
+    std::vector<PosteriorSummary> first(50), second(50);
+    for (int s = 51; s <= 100; ++s) { measure(s, z); pf.step(z, 0.01f); pf.summary(first[s - 51]); }
+    ck.checkpoint_restore(0);
+    for (int s = 51; s <= 100; ++s) { measure(s, z); pf.step(z, 0.01f); pf.summary(second[s - 51]); }
+
+    bool replay = true;
+    for (int s = 0; s < 50; ++s) replay = replay && same_summary(first[s], second[s]);
+    EXPECT_TRUE(replay);
+}
+
+// ---------------------------------------------------------------------------
+
+static void benchmark() {
+    using clk = std::chrono::steady_clock;
+    constexpr int N = 10000;
+    constexpr int REPS = 200;
+    const int n = RBPF_PREDICT_NOISE;
+    std::vector<float> out(size_t(N) * philox_batch_stride(n));
+    volatile float sink = 0.0f;
+
+    std::cout << "\n[benchmark] predict noise, N = " << N << " x " << n << " normals\n";
+
+    std::mt19937 rng(1234);
+    std::normal_distribution<float> gauss;
+    auto t0 = clk::now();
+    for (int r = 0; r < REPS; ++r) {
+        for (int i = 0; i < N; ++i)
+            for (int k = 0; k < n; ++k) out[size_t(i) * 12 + k] = gauss(rng);
+        sink = sink + out[r];
+    }
+    const double us_mt = std::chrono::duration<double, std::micro>(clk::now() - t0).count() / REPS;
+
+    t0 = clk::now();
+    for (int r = 0; r < REPS; ++r) {
+        for (int i = 0; i < N; ++i)
+            philox_normals(1234ULL, PHILOX_PREDICT, uint32_t(i), uint32_t(r), &out[size_t(i) * 12], n);
+        sink = sink + out[r];
+    }
+    const double us_scalar = std::chrono::duration<double, std::micro>(clk::now() - t0).count() / REPS;
+
+    t0 = clk::now();
+    for (int r = 0; r < REPS; ++r) {
+        philox_normals_batch(1234ULL, PHILOX_PREDICT, uint32_t(r), N, n, out.data());
+        sink = sink + out[r];
+    }
+    const double us_batch = std::chrono::duration<double, std::micro>(clk::now() - t0).count() / REPS;
+
+    const double draws = double(N) * n;
+    std::printf("  mt19937 + normal_distribution %8.1f us  (%6.1f M normals/s)\n", us_mt, draws / us_mt);
+    std::printf("  philox, per particle          %8.1f us  (%6.1f M normals/s)\n", us_scalar, draws / us_scalar);
+    std::printf("  philox, batched lanes         %8.1f us  (%6.1f M normals/s)\n", us_batch, draws / us_batch);
+    std::printf("  GPU generator state dropped: %zu B/particle, %.0f KB read+written per predict at N = %d\n",
+                size_t(48), 2.0 * 48.0 * N / 1024.0, N);
+    (void)sink;
+}
+
+int main() {
+    test_known_answers();
+    test_batch_matches_scalar();
+    test_transform_accuracy();
+    test_moments();
+    test_replay_bit_identical();
+    benchmark();
+
+    if (g_failures) {
+        std::cout << "\n" << g_failures << " check(s) FAILED\n";
+        return 1;
+    }
+    std::cout << "\nall philox tests passed\n";
+    return 0;
+}
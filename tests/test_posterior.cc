@@ -0,0 +1,296 @@
+/*
+ * test_posterior.cc
+ *
+ * Weighted posterior summary (posterior.hpp): weighted mean / variance vs a
+ * double two-pass reference, circular yaw mean across the +-pi wrap, ESS
+ * (and that the filter reports it from before resampling), and the cost of
+ * the single pass. CPU path only, no CUDA needed; the GPU kernel runs the
+ * same accumulate / merge / finalize functions.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O3 -I calibur/pf -I calibur/worker tests/test_posterior.cc \
+ *       calibur/pf/posterior.cpp calibur/pf/rbpf_cpu.cpp calibur/pf/resample.cpp \
+ *       calibur/pf/kld.cpp -o test_posterior
+ *
+ * Run:
+ *   ./test_posterior
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "posterior.hpp"
+#include "rbpf_cpu.hpp"
+#include "rbpf_model.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+// ---------------------------------------------------------------------------
+
+struct Reference {
+    double mean[D];
+    double var[D];
+    double ess;
+};
+
+// two-pass double reference; yaw via sum of unit vectors
+static Reference reference(const std::vector<float> &X, const std::vector<float> &W, int N) {
+    Reference r{};
+    double sw = 0.0, sw2 = 0.0;
+    for (int i = 0; i < N; ++i) { sw += W[i]; sw2 += double(W[i]) * W[i]; }
+    r.ess = sw * sw / sw2;
+
+    for (int k = 0; k < D; ++k) {
+        if (k == IDX_YAW) {
+            double c = 0.0, s = 0.0;
+            for (int i = 0; i < N; ++i) {
+                c += W[i] * std::cos(double(X[i * D + k]));
+                s += W[i] * std::sin(double(X[i * D + k]));
+            }
+            c /= sw; s /= sw;
+            r.mean[k] = std::atan2(s, c);
+            r.var[k]  = -2.0 * std::log(std::sqrt(c * c + s * s));
+            continue;
+        }
+        double m = 0.0;
+        for (int i = 0; i < N; ++i) m += W[i] * double(X[i * D + k]);
+        m /= sw;
+        double v = 0.0;
+        for (int i = 0; i < N; ++i) {
+            const double d = X[i * D + k] - m;
+            v += W[i] * d * d;
+        }
+        r.mean[k] = m;
+        r.var[k]  = v / sw;
+    }
+    return r;
+}
+
+static double ang_diff(double a, double b) {
+    return std::fabs(std::remainder(a - b, 2.0 * M_PI));
+}
+
+// Gaussian cloud around `centre` (yaw wrapped), random unnormalized weights.
+static void make_cloud(int N, const float *centre, float sigma, float yaw_sigma,
+                       std::mt19937 &rng, std::vector<float> &X, std::vector<float> &W) {
+    std::normal_distribution<float> nd(0.0f, 1.0f);
+    std::uniform_real_distribution<float> uw(0.1f, 3.0f);
+    X.assign(size_t(N) * D, 0.0f);
+    W.assign(N, 0.0f);
+    for (int i = 0; i < N; ++i) {
+        for (int k = 0; k < D; ++k) {
+            const float s = (k == IDX_YAW) ? yaw_sigma : sigma;
+            X[i * D + k] = centre[k] + s * nd(rng);
+        }
+        X[i * D + IDX_YAW] = wrap_to_pi(X[i * D + IDX_YAW]);
+        W[i] = uw(rng);
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+static void test_weighted_moments() {
+    std::cout << "[posterior] weighted mean / variance vs double reference\n";
+    std::mt19937 rng(3);
+    float centre[D];
+    for (int k = 0; k < D; ++k) centre[k] = 0.1f * k - 0.5f;
+    // targets sit metres away: the shifted accumulation must not lose variance
+    centre[IDX_TX] = 3.0f; centre[IDX_TY] = -1.5f; centre[IDX_TZ] = 7.0f;
+
+    for (int N : {1, 7, 1000, 10000}) {
+        std::vector<float> X, W;
+        make_cloud(N, centre, 0.02f, 0.1f, rng, X, W);
+        PosteriorSummary sm;
+        cpu_posterior_summary(X.data(), W.data(), N, sm);
+        const Reference ref = reference(X, W, N);
+
+        double max_mean = 0.0, max_var = 0.0;
+        for (int k = 0; k < D; ++k) {
+            const double dm = (k == IDX_YAW) ? ang_diff(sm.mean[k], ref.mean[k])
+                                             : std::fabs(sm.mean[k] - ref.mean[k]);
+            const double dv = std::fabs(sm.var[k] - ref.var[k]) / (ref.var[k] + 1e-6);
+            max_mean = std::max(max_mean, dm);
+            max_var  = std::max(max_var, dv);
+        }
+        std::printf("  N=%5d  max |dmean| = %.2e  max rel dvar = %.2e  ESS %.1f (ref %.1f)\n",
+                    N, max_mean, max_var, sm.ess, ref.ess);
+        EXPECT_TRUE(max_mean < 1e-4);
+        EXPECT_TRUE(max_var  < 2e-2);
+        EXPECT_TRUE(std::fabs(sm.ess - ref.ess) <= 1e-3 * ref.ess);
+        EXPECT_TRUE(sm.num_particles == N);
+    }
+}
+
+static void test_yaw_wrap() {
+    std::cout << "[posterior] circular yaw across +-pi\n";
+    std::mt19937 rng(11);
+
+    for (double yc : {M_PI - 0.01, -M_PI + 0.02, M_PI, 0.0, 1.2}) {
+        float centre[D] = {};
+        centre[IDX_YAW] = float(yc);
+        std::vector<float> X, W;
+        make_cloud(5000, centre, 0.01f, 0.15f, rng, X, W);
+
+        PosteriorSummary sm;
+        cpu_posterior_summary(X.data(), W.data(), 5000, sm);
+
+        // the arithmetic mean is what the old mean_kernel returned
+        double arith = 0.0, sw = 0.0;
+        for (int i = 0; i < 5000; ++i) { arith += W[i] * X[i * D + IDX_YAW]; sw += W[i]; }
+        arith /= sw;
+
+        std::printf("  centre %+.3f: circular %+.4f (err %.4f)  arithmetic %+.4f  std %.3f\n",
+                    yc, sm.mean[IDX_YAW], ang_diff(sm.mean[IDX_YAW], yc), arith,
+                    std::sqrt(sm.var[IDX_YAW]));
+        EXPECT_TRUE(ang_diff(sm.mean[IDX_YAW], yc) < 0.01);
+        EXPECT_TRUE(sm.mean[IDX_YAW] >= -M_PI && sm.mean[IDX_YAW] <= M_PI);
+        EXPECT_TRUE(std::fabs(std::sqrt(sm.var[IDX_YAW]) - 0.15) < 0.01);
+    }
+
+    // two particles straddling the wrap: mean is pi, not 0
+    {
+        std::vector<float> X(2 * D, 0.0f), W = {1.0f, 1.0f};
+        X[IDX_YAW]     = float( M_PI - 0.1);
+        X[D + IDX_YAW] = float(-M_PI + 0.1);
+        PosteriorSummary sm;
+        cpu_posterior_summary(X.data(), W.data(), 2, sm);
+        std::printf("  pair +-(pi-0.1): mean %+.4f\n", sm.mean[IDX_YAW]);
+        EXPECT_TRUE(ang_diff(sm.mean[IDX_YAW], M_PI) < 1e-5);
+    }
+
+    // weights decide: heavy particle at +3.0 rad, light one at -3.0 rad
+    {
+        std::vector<float> X(2 * D, 0.0f), W = {3.0f, 1.0f};
+        X[IDX_YAW]     =  3.0f;
+        X[D + IDX_YAW] = -3.0f;
+        PosteriorSummary sm;
+        cpu_posterior_summary(X.data(), W.data(), 2, sm);
+        const double ref = std::atan2(3.0 * std::sin(3.0) + std::sin(-3.0),
+                                      3.0 * std::cos(3.0) + std::cos(-3.0));
+        EXPECT_TRUE(ang_diff(sm.mean[IDX_YAW], ref) < 1e-5);
+        EXPECT_TRUE(sm.mean[IDX_YAW] > 3.0f);
+    }
+}
+
+static void test_ess() {
+    std::cout << "[posterior] ESS\n";
+    const int N = 4096;
+    std::vector<float> X(size_t(N) * D, 0.5f), W(N, 1.0f / N);
+    PosteriorSummary sm;
+
+    cpu_posterior_summary(X.data(), W.data(), N, sm);
+    EXPECT_TRUE(std::fabs(sm.ess - N) < 1e-2f * N);
+    EXPECT_TRUE(std::fabs(sm.weight_sum - 1.0f) < 1e-4f);
+
+    // unnormalized uniform weights: same ESS, same mean
+    std::fill(W.begin(), W.end(), 17.0f);
+    cpu_posterior_summary(X.data(), W.data(), N, sm);
+    EXPECT_TRUE(std::fabs(sm.ess - N) < 1e-2f * N);
+    EXPECT_TRUE(std::fabs(sm.mean[IDX_TX] - 0.5f) < 1e-6f);
+
+    // nullptr weights = uniform
+    cpu_posterior_summary(X.data(), nullptr, N, sm);
+    EXPECT_TRUE(std::fabs(sm.ess - N) < 1e-2f * N);
+
+    // one-hot: ESS 1, mean is that particle, variance 0
+    std::fill(W.begin(), W.end(), 0.0f);
+    W[123] = 0.7f;
+    X[123 * D + IDX_TZ] = 4.0f;
+    cpu_posterior_summary(X.data(), W.data(), N, sm);
+    EXPECT_TRUE(std::fabs(sm.ess - 1.0f) < 1e-5f);
+    EXPECT_TRUE(std::fabs(sm.mean[IDX_TZ] - 4.0f) < 1e-5f);
+    EXPECT_TRUE(sm.var[IDX_TZ] < 1e-6f);
+}
+
+// Every step resamples, so the summarized weights are uniform again; the
+// filter's ESS must be that of the update, and N again after a reset.
+static void test_filter_ess() {
+    std::cout << "[posterior] filter ESS before resampling\n";
+    const int N = 2000;
+    RBPFPosYawModelCPU pf(N);
+    float z[D] = {};
+    z[IDX_TZ] = 4.0f;
+    z[IDX_R1] = z[IDX_R2] = 0.25f;
+    pf.reset(z);
+
+    PosteriorSummary sm;
+    pf.summary(sm);
+    EXPECT_TRUE(sm.ess == float(N));
+
+    // a measurement well off the particle cloud: most weights collapse
+    float ess_min = float(N);
+    for (int s = 0; s < 5; ++s) {
+        z[IDX_TX] = 0.3f * float(s + 1);
+        pf.step(z, 0.01f);
+        pf.summary(sm);
+        EXPECT_TRUE(sm.ess == pf.telemetry.ess);
+        ess_min = std::min(ess_min, sm.ess);
+    }
+    std::printf("  lowest ESS over the jumps %.1f of %d\n", ess_min, N);
+    EXPECT_TRUE(ess_min < 0.5f * N);
+
+    pf.reset(z);
+    pf.summary(sm);
+    EXPECT_TRUE(sm.ess == float(N));
+}
+
+// ---------------------------------------------------------------------------
+
+static void benchmark() {
+    std::cout << "\n[benchmark] one-pass summary vs two-pass double reference\n";
+    std::mt19937 rng(9);
+    float centre[D] = {};
+    for (int N : {1000, 10000}) {
+        std::vector<float> X, W;
+        make_cloud(N, centre, 0.05f, 0.2f, rng, X, W);
+        using clk = std::chrono::steady_clock;
+        constexpr int REPS = 200;
+
+        PosteriorSummary sm;
+        volatile float sink = 0.0f;
+        auto t0 = clk::now();
+        for (int r = 0; r < REPS; ++r) {
+            cpu_posterior_summary(X.data(), W.data(), N, sm);
+            sink = sink + sm.mean[0];
+        }
+        auto t1 = clk::now();
+        for (int r = 0; r < REPS; ++r) {
+            const Reference ref = reference(X, W, N);
+            sink = sink + float(ref.mean[0]);
+        }
+        auto t2 = clk::now();
+
+        const double us_fused = std::chrono::duration<double, std::micro>(t1 - t0).count() / REPS;
+        const double us_ref   = std::chrono::duration<double, std::micro>(t2 - t1).count() / REPS;
+        std::printf("  N=%5d  fused %8.1f us   reference %8.1f us\n", N, us_fused, us_ref);
+    }
+}
+
+int main() {
+    test_weighted_moments();
+    test_yaw_wrap();
+    test_ess();
+    test_filter_ess();
+    benchmark();
+
+    if (g_failures) {
+        std::cout << "\n" << g_failures << " check(s) FAILED\n";
+        return 1;
+    }
+    std::cout << "\nall posterior tests passed\n";
+    return 0;
+}
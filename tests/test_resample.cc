@@ -0,0 +1,363 @@
+/*
+ * test_resample.cc
+ *
+ * Correctness tests + benchmark for the particle resampling module
+ * (calibur/pf/resample.hpp). CPU path only, no CUDA needed.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O3 -I calibur/pf tests/test_resample.cc calibur/pf/resample.cpp -o test_resample
+ *
+ * Run:
+ *   ./test_resample
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "resample.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+static std::vector<float> random_weights(int N, uint32_t seed, bool peaked) {
+    std::mt19937 rng(seed);
+    std::vector<float> w(N);
+    if (peaked) {
+        // log-likelihood style: a few dominant particles
+        std::normal_distribution<float> nd(0.0f, 3.0f);
+        float mx = -1e30f;
+        for (auto &v : w) { v = nd(rng); mx = std::max(mx, v); }
+        for (auto &v : w) v = std::exp(v - mx);
+    } else {
+        std::uniform_real_distribution<float> ud(0.0f, 1.0f);
+        for (auto &v : w) v = ud(rng);
+    }
+    float s = 0.0f;
+    for (float v : w) s += v;
+    for (auto &v : w) v /= s;
+    return w;
+}
+
+static std::vector<int> offspring_counts(const std::vector<int> &anc, int N) {
+    std::vector<int> c(N, 0);
+    for (int a : anc) {
+        if (a >= 0 && a < N) ++c[a];
+    }
+    return c;
+}
+
+// ---------------------------------------------------------------------------
+
+static void test_scan() {
+    std::cout << "[scan] blocked Blelloch vs sequential\n";
+    for (int N : {1, 7, 511, 512, 513, 10000, 70001}) {
+        std::vector<float> in(N), out(N);
+        for (int i = 0; i < N; ++i) in[i] = float((i * 37) % 11);  // integers: exact
+        cpu_inclusive_scan(in.data(), out.data(), N);
+
+        double ref = 0.0;
+        bool ok = true;
+        for (int i = 0; i < N; ++i) {
+            ref += in[i];
+            if (double(out[i]) != ref) { ok = false; break; }
+        }
+        EXPECT_TRUE(ok);
+
+        // in-place
+        std::vector<float> inplace = in;
+        cpu_inclusive_scan(inplace.data(), inplace.data(), N);
+        EXPECT_TRUE(inplace == out);
+    }
+}
+
+static void test_systematic_matches_binary_search() {
+    std::cout << "[systematic] O(N) spans vs binary search\n";
+    const int N = 10000;
+    for (uint32_t seed = 1; seed <= 5; ++seed) {
+        auto w = random_weights(N, seed, seed % 2 == 0);
+        std::vector<float> cdf(N), aux(N), cdf_ref(N);
+        std::vector<int> anc(N, -1), anc_ref(N, -1);
+
+        cpu_resample_ancestors(w.data(), N, N, ResampleScheme::SYSTEMATIC, 42, seed,
+                               cdf.data(), aux.data(), anc.data());
+        const float u = resample_uniform(42, seed, 0xFFFFFFFFu);
+        cpu_resample_binary_search(w.data(), N, u, cdf_ref.data(), anc_ref.data());
+
+        // every slot written, ancestors non-decreasing
+        EXPECT_TRUE(std::find(anc.begin(), anc.end(), -1) == anc.end());
+        EXPECT_TRUE(std::is_sorted(anc.begin(), anc.end()));
+
+        // exact answer: double CDF + binary search at the same slot positions
+        std::vector<double> cdf_d(N);
+        double acc = 0.0;
+        for (int i = 0; i < N; ++i) { acc += w[i]; cdf_d[i] = acc; }
+        std::vector<int> anc_exact(N);
+        for (int j = 0; j < N; ++j) {
+            const double x = (j + double(u)) / N * acc;
+            anc_exact[j] = std::min(int(std::lower_bound(cdf_d.begin(), cdf_d.end(), x)
+                                        - cdf_d.begin()), N - 1);
+        }
+
+        // float rounding may move a slot that sits within an ulp of a particle
+        // edge to the neighbour; offspring counts must still agree to within one
+        auto c_exact = offspring_counts(anc_exact, N);
+        auto c_new   = offspring_counts(anc, N);
+        auto c_ref   = offspring_counts(anc_ref, N);
+        int moved_new = 0, moved_ref = 0;
+        for (int i = 0; i < N; ++i) {
+            EXPECT_TRUE(std::abs(c_new[i] - c_exact[i]) <= 1);
+            moved_new += std::abs(c_new[i] - c_exact[i]);
+            moved_ref += std::abs(c_ref[i] - c_exact[i]);
+        }
+        std::cout << "  seed " << seed << ": slots off exact, O(N) = " << moved_new / 2
+                  << ", binary search = " << moved_ref / 2 << "\n";
+        EXPECT_TRUE(moved_new <= N / 500);
+
+        // systematic: |count - N w| < 1 (+ float slack)
+        auto c = offspring_counts(anc, N);
+        for (int i = 0; i < N; ++i) {
+            EXPECT_TRUE(std::fabs(c[i] - N * w[i]) < 1.01f);
+        }
+    }
+}
+
+static void test_scheme_properties(ResampleScheme scheme, const char *name) {
+    std::cout << "[" << name << "] coverage + unbiasedness\n";
+    const int N = 4096;
+    auto w = random_weights(N, 7, true);
+
+    std::vector<float> cdf(N), aux(N);
+    std::vector<int> anc(N);
+    std::vector<double> mean_count(N, 0.0);
+
+    const int trials = 400;
+    for (int t = 0; t < trials; ++t) {
+        std::fill(anc.begin(), anc.end(), -1);
+        cpu_resample_ancestors(w.data(), N, N, scheme, 99, uint32_t(t),
+                               cdf.data(), aux.data(), anc.data());
+
+        // every slot assigned exactly once with a valid ancestor
+        bool all_set = std::all_of(anc.begin(), anc.end(),
+                                   [N](int a) { return a >= 0 && a < N; });
+        EXPECT_TRUE(all_set);
+        if (!all_set) return;
+
+        // systematic slots are handed out in particle order
+        if (scheme == ResampleScheme::SYSTEMATIC) {
+            EXPECT_TRUE(std::is_sorted(anc.begin(), anc.end()));
+        }
+
+        auto c = offspring_counts(anc, N);
+        for (int i = 0; i < N; ++i) {
+            mean_count[i] += c[i];
+            if (scheme == ResampleScheme::RESIDUAL) {
+                // deterministic part always present
+                EXPECT_TRUE(c[i] >= int(std::floor(N * w[i] - 1e-3f)));
+            }
+        }
+    }
+
+    // E[count_i] == N w_i: check heavy particles where the estimate is tight
+    double max_rel = 0.0;
+    for (int i = 0; i < N; ++i) {
+        const double expect = double(N) * w[i];
+        if (expect < 5.0) continue;
+        max_rel = std::max(max_rel, std::fabs(mean_count[i] / trials - expect) / expect);
+    }
+    std::cout << "  max relative bias on heavy particles: " << max_rel << "\n";
+    EXPECT_TRUE(max_rel < 0.05);
+}
+
+// Fill kernels run one thread per source particle in no particular order, so
+// slot ranges must be disjoint: forward and reverse fill must agree.
+static void test_spans_disjoint() {
+    std::cout << "[spans] fill order independence\n";
+    const int N = 3000;
+    for (uint32_t seed = 1; seed <= 4; ++seed) {
+        auto w = random_weights(N, seed, seed % 2 == 0);
+        std::vector<float> cdf(N), n_cdf(N), r_cdf(N);
+        cpu_inclusive_scan(w.data(), cdf.data(), N);
+        const float scale = float(N) / cdf[N - 1];
+        for (int i = 0; i < N; ++i) {
+            const float nw = w[i] * scale;
+            n_cdf[i] = std::floor(nw);
+            r_cdf[i] = nw - n_cdf[i];
+        }
+        cpu_inclusive_scan(n_cdf.data(), n_cdf.data(), N);
+        cpu_inclusive_scan(r_cdf.data(), r_cdf.data(), N);
+        const float u = resample_uniform(7, seed, 0xFFFFFFFFu);
+
+        std::vector<int> fwd(N, -1), rev(N, -1);
+        for (int i = 0; i < N; ++i)      systematic_fill(cdf.data(), i, N, N, scale, u, fwd.data());
+        for (int i = N - 1; i >= 0; --i) systematic_fill(cdf.data(), i, N, N, scale, u, rev.data());
+        EXPECT_TRUE(fwd == rev);
+
+        std::fill(fwd.begin(), fwd.end(), -1);
+        std::fill(rev.begin(), rev.end(), -1);
+        for (int i = 0; i < N; ++i)      residual_fill(n_cdf.data(), r_cdf.data(), i, N, N, u, fwd.data());
+        for (int i = N - 1; i >= 0; --i) residual_fill(n_cdf.data(), r_cdf.data(), i, N, N, u, rev.data());
+        EXPECT_TRUE(fwd == rev);
+        EXPECT_TRUE(std::find(fwd.begin(), fwd.end(), -1) == fwd.end());
+    }
+}
+
+static void test_degenerate() {
+    std::cout << "[degenerate] single heavy particle / zero weights\n";
+    const int N = 1000;
+    std::vector<float> w(N, 0.0f), cdf(N), aux(N);
+    std::vector<int> anc(N);
+    w[123] = 1.0f;
+
+    for (auto scheme : {ResampleScheme::SYSTEMATIC, ResampleScheme::STRATIFIED,
+                        ResampleScheme::RESIDUAL}) {
+        std::fill(anc.begin(), anc.end(), -1);
+        cpu_resample_ancestors(w.data(), N, N, scheme, 1, 0, cdf.data(), aux.data(), anc.data());
+        EXPECT_TRUE(std::all_of(anc.begin(), anc.end(), [](int a) { return a == 123; }));
+    }
+
+    // unnormalized weights behave like normalized ones
+    auto wn = random_weights(N, 3, false);
+    std::vector<float> ws = wn;
+    for (auto &v : ws) v *= 37.5f;
+    std::vector<int> a1(N), a2(N);
+    cpu_resample_ancestors(wn.data(), N, N, ResampleScheme::SYSTEMATIC, 5, 5, cdf.data(), aux.data(), a1.data());
+    cpu_resample_ancestors(ws.data(), N, N, ResampleScheme::SYSTEMATIC, 5, 5, cdf.data(), aux.data(), a2.data());
+    int diff = 0;
+    for (int i = 0; i < N; ++i) diff += (a1[i] != a2[i]);
+    EXPECT_TRUE(diff <= 2);
+}
+
+// N sources -> M slots (adaptive particle count): every slot set, order
+// independent, E[count_i] == M w_i.
+static void test_resize() {
+    std::cout << "[resize] N -> M shrink / grow\n";
+    const int N = 2000;
+    auto w = random_weights(N, 21, true);
+    std::vector<float> cdf(N), aux(N);
+
+    for (int M : {1, 137, 500, 2000, 7919}) {
+        for (auto scheme : {ResampleScheme::SYSTEMATIC, ResampleScheme::STRATIFIED,
+                            ResampleScheme::RESIDUAL}) {
+            std::vector<double> mean_count(N, 0.0);
+            const int trials = 200;
+            bool ok = true;
+            for (int t = 0; t < trials; ++t) {
+                std::vector<int> anc(M, -1);
+                cpu_resample_ancestors(w.data(), N, M, scheme, 3, uint32_t(t),
+                                       cdf.data(), aux.data(), anc.data());
+                for (int a : anc) {
+                    if (a < 0 || a >= N) { ok = false; break; }
+                    mean_count[a] += 1.0;
+                }
+            }
+            EXPECT_TRUE(ok);
+
+            double max_rel = 0.0;
+            for (int i = 0; i < N; ++i) {
+                const double expect = double(M) * w[i];
+                if (expect < 5.0) continue;
+                max_rel = std::max(max_rel, std::fabs(mean_count[i] / trials - expect) / expect);
+            }
+            EXPECT_TRUE(max_rel < 0.05);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark: previous pipeline vs new pipeline, full particle copy included.
+
+constexpr int D    = 15;
+constexpr int KF_D = 7;
+
+struct Particles {
+    std::vector<float> X, kf, Pv, Pg;
+    explicit Particles(int N) : X(N * D), kf(N * KF_D), Pv(N * 4), Pg(N * 3) {}
+};
+
+static void gather(const Particles &src, Particles &dst, const int *anc, int N) {
+    for (int i = 0; i < N; ++i) {
+        const int a = anc[i];
+        std::memcpy(&dst.X[i * D],     &src.X[a * D],     D * sizeof(float));
+        std::memcpy(&dst.kf[i * KF_D], &src.kf[a * KF_D], KF_D * sizeof(float));
+        std::memcpy(&dst.Pv[i * 4],    &src.Pv[a * 4],    4 * sizeof(float));
+        std::memcpy(&dst.Pg[i * 3],    &src.Pg[a * 3],    3 * sizeof(float));
+    }
+}
+
+static void benchmark() {
+    std::cout << "\n[benchmark] N=10000, 2000 iterations\n";
+    const int N = 10000, iters = 2000;
+    auto w = random_weights(N, 11, true);
+
+    Particles front(N), back(N);
+    for (size_t i = 0; i < front.X.size(); ++i) front.X[i] = float(i);
+    std::vector<float> cdf(N), aux(N);
+    std::vector<int> anc(N);
+
+    using clk = std::chrono::steady_clock;
+
+    // previous: serial CDF + binary search per slot + copy to scratch + copy back
+    auto t0 = clk::now();
+    for (int it = 0; it < iters; ++it) {
+        cpu_resample_binary_search(w.data(), N, 0.5f, cdf.data(), anc.data());
+        gather(front, back, anc.data(), N);
+        front.X = back.X; front.kf = back.kf; front.Pv = back.Pv; front.Pg = back.Pg;
+    }
+    auto t1 = clk::now();
+
+    // new: blocked scan + O(N) spans + gather + pointer swap
+    Particles *f = &front, *b = &back;
+    double per_scheme_us[3];
+    const ResampleScheme schemes[3] = {ResampleScheme::SYSTEMATIC,
+                                       ResampleScheme::STRATIFIED,
+                                       ResampleScheme::RESIDUAL};
+    for (int s = 0; s < 3; ++s) {
+        auto ts0 = clk::now();
+        for (int it = 0; it < iters; ++it) {
+            cpu_resample_ancestors(w.data(), N, N, schemes[s], 1, uint32_t(it),
+                                   cdf.data(), aux.data(), anc.data());
+            gather(*f, *b, anc.data(), N);
+            std::swap(f, b);
+        }
+        auto ts1 = clk::now();
+        per_scheme_us[s] = std::chrono::duration<double, std::micro>(ts1 - ts0).count() / iters;
+    }
+
+    const double legacy_us = std::chrono::duration<double, std::micro>(t1 - t0).count() / iters;
+    std::cout << "  binary search + memcpy : " << legacy_us         << " us/step\n";
+    std::cout << "  systematic O(N) + swap : " << per_scheme_us[0]  << " us/step\n";
+    std::cout << "  stratified O(N) + swap : " << per_scheme_us[1]  << " us/step\n";
+    std::cout << "  residual   O(N) + swap : " << per_scheme_us[2]  << " us/step\n";
+}
+
+int main() {
+    test_scan();
+    test_systematic_matches_binary_search();
+    test_scheme_properties(ResampleScheme::SYSTEMATIC, "systematic");
+    test_scheme_properties(ResampleScheme::STRATIFIED, "stratified");
+    test_scheme_properties(ResampleScheme::RESIDUAL,   "residual");
+    test_spans_disjoint();
+    test_resize();
+    test_degenerate();
+    benchmark();
+
+    if (g_failures) {
+        std::cout << "\n" << g_failures << " check(s) FAILED\n";
+        return 1;
+    }
+    std::cout << "\nall resample tests passed\n";
+    return 0;
+}
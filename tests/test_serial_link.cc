@@ -0,0 +1,358 @@
+/*
+ * test_serial_link.cc
+ *
+ * Serial transport (calibur/worker/serial_link.hpp, usb_protocol.hpp): CRC
+ * table, command encoding, and the non-blocking engine over a pseudo-
+ * terminal loopback — round-trip latency, burst throughput against the old
+ * two-vector / two-write send, back-pressure with a stalled reader, and
+ * hang-up detection.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 -pthread -I . -I calibur -I calibur/worker -I apps/yaml-cpp/include \
+ *       tests/test_serial_link.cc calibur/worker/serial_link.cpp \
+ *       calibur/usb_communication.cpp calibur/log.cpp calibur/config.cc calibur/util.cpp \
+ *       apps/yaml-cpp/lib/libyaml-cpp.a -lutil -o test_serial_link
+ *
+ * Run:
+ *   ./test_serial_link
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <pty.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "serial_link.hpp"
+#include "usb_protocol.hpp"
+#include "calibur/usb_communication.h"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+using SteadyClock = std::chrono::steady_clock;
+
+static double us_since(SteadyClock::time_point t0) {
+    return std::chrono::duration<double, std::micro>(SteadyClock::now() - t0).count();
+}
+
+static double percentile(std::vector<double> v, double q) {
+    if (v.empty()) return 0.0;
+    const size_t k = std::min(v.size() - 1, size_t(q * (v.size() - 1) + 0.5));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+// Pty pair with the host side opened through USBCommunication (raw mode)
+struct Loopback {
+    int master = -1;
+    char name[256] = {};
+    calibur::USBCommunication *usb = nullptr;
+
+    bool open() {
+        int slave = -1;
+        if (openpty(&master, &slave, name, nullptr, nullptr) != 0) return false;
+        usb = new calibur::USBCommunication(name);
+        const bool ok = usb->open();
+        ::close(slave);
+        return ok;
+    }
+    ~Loopback() {
+        delete usb;
+        if (master >= 0) ::close(master);
+    }
+};
+
+// Stand-in MCU: echoes whatever the host sends
+class Echo {
+public:
+    explicit Echo(int fd) : fd_(fd), th_([this] { run(); }) {}
+    ~Echo() { stop_.store(true); th_.join(); }
+
+private:
+    void run() {
+        uint8_t buf[4096];
+        while (!stop_.load()) {
+            pollfd p{fd_, POLLIN, 0};
+            if (::poll(&p, 1, 5) <= 0) continue;
+            const ssize_t n = ::read(fd_, buf, sizeof(buf));
+            if (n <= 0) continue;
+            for (ssize_t off = 0; off < n;) {
+                const ssize_t w = ::write(fd_, buf + off, size_t(n - off));
+                if (w > 0) off += w;
+            }
+        }
+    }
+
+    int fd_;
+    std::atomic<bool> stop_{false};
+    std::thread th_;
+};
+
+// What usb_send_tx did before: two vectors, two write() calls
+static bool legacy_send(int fd, float yaw, float pitch, int aim, int fire, int chase) {
+    {
+        uint16_t len = 8;
+        std::vector<uint8_t> packet = {0xAA, uint8_t(len & 0xFF), uint8_t(len >> 8), 0x01};
+        uint8_t b[4];
+        memcpy(b, &yaw, 4);   packet.insert(packet.end(), b, b + 4);
+        memcpy(b, &pitch, 4); packet.insert(packet.end(), b, b + 4);
+        packet.push_back(usb_checksum(packet.data(), packet.size()));
+        if (write(fd, packet.data(), packet.size()) != ssize_t(packet.size())) return false;
+    }
+    {
+        uint16_t len = 12;
+        std::vector<uint8_t> packet = {0xAA, uint8_t(len & 0xFF), uint8_t(len >> 8), 0x02};
+        uint8_t b[4];
+        memcpy(b, &aim, 4);   packet.insert(packet.end(), b, b + 4);
+        memcpy(b, &fire, 4);  packet.insert(packet.end(), b, b + 4);
+        memcpy(b, &chase, 4); packet.insert(packet.end(), b, b + 4);
+        packet.push_back(usb_checksum(packet.data(), packet.size()));
+        if (write(fd, packet.data(), packet.size()) != ssize_t(packet.size())) return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+
+static void test_crc() {
+    std::cout << "[serial] crc8 table\n";
+    auto bitwise = [](const uint8_t *p, size_t n) {
+        uint8_t c = 0xFF;
+        for (size_t i = 0; i < n; ++i) {
+            c ^= p[i];
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? uint8_t((c >> 1) ^ 0x8C) : uint8_t(c >> 1);
+        }
+        return c;
+    };
+    uint8_t data[256];
+    for (int i = 0; i < 256; ++i) data[i] = uint8_t(i * 37 + 11);
+    bool same = true;
+    for (size_t n = 0; n <= sizeof(data); n += 7) same = same && usb_checksum(data, n) == bitwise(data, n);
+    EXPECT_TRUE(same);
+
+    // every single-bit error and every adjacent byte swap in a command frame
+    uint8_t cmd[kUsbCommandBytes];
+    usb_encode_command(0.25f, -0.125f, 1, 0, 7, cmd);
+    int missed_bits = 0, missed_swaps = 0;
+    for (size_t i = 0; i < kUsbAimLen + 4; ++i) {
+        for (int b = 0; b < 8; ++b) {
+            uint8_t f[kUsbCommandBytes];
+            memcpy(f, cmd, sizeof(f));
+            f[i] ^= uint8_t(1u << b);
+            missed_bits += usb_checksum(f, kUsbAimLen + 4) == cmd[kUsbAimLen + 4];
+        }
+        if (i + 1 < kUsbAimLen + 4 && cmd[i] != cmd[i + 1]) {
+            uint8_t f[kUsbCommandBytes];
+            memcpy(f, cmd, sizeof(f));
+            std::swap(f[i], f[i + 1]);
+            missed_swaps += usb_checksum(f, kUsbAimLen + 4) == cmd[kUsbAimLen + 4];
+        }
+    }
+    std::printf("  undetected: %d bit flips, %d byte swaps\n", missed_bits, missed_swaps);
+    EXPECT_TRUE(missed_bits == 0);
+    EXPECT_TRUE(missed_swaps == 0);
+}
+
+static void test_encode_command() {
+    std::cout << "[serial] command encoding\n";
+    uint8_t f[kUsbCommandBytes];
+    const size_t n = usb_encode_command(0.5f, -0.25f, 1, 1, 0, f);
+    EXPECT_TRUE(n == 30);
+    EXPECT_TRUE(f[0] == kUsbHeader && f[1] == 8 && f[2] == 0 && f[3] == USB_TX_AIM);
+    EXPECT_TRUE(f[13] == kUsbHeader && f[14] == 12 && f[15] == 0 && f[16] == USB_TX_STATE);
+
+    UsbFrameParser parser;
+    float yaw = 0, pitch = 0;
+    int32_t st[3] = {};
+    int frames = 0;
+    parser.feed(f, n, [&](uint8_t type, const uint8_t *p, uint16_t len) {
+        ++frames;
+        if (type == USB_TX_AIM && len == kUsbAimLen) { memcpy(&yaw, p, 4); memcpy(&pitch, p + 4, 4); }
+        if (type == USB_TX_STATE && len == kUsbStateLen) memcpy(st, p, 12);
+    });
+    EXPECT_TRUE(frames == 2);
+    EXPECT_TRUE(yaw == 0.5f && pitch == -0.25f);
+    EXPECT_TRUE(st[0] == 1 && st[1] == 1 && st[2] == 0);
+}
+
+static void test_loopback() {
+    std::cout << "[serial] pty loopback\n";
+    Loopback lb;
+    if (!lb.open()) {
+        std::cout << "  openpty failed, skipped\n";
+        return;
+    }
+
+    int64_t last_seq = -1;
+    uint64_t states = 0, aims = 0;
+    SerialLink link([&](uint8_t type, const uint8_t *p, uint16_t len) {
+        if (type == USB_TX_AIM && len == kUsbAimLen) ++aims;
+        if (type == USB_TX_STATE && len == kUsbStateLen) {
+            int32_t seq;
+            memcpy(&seq, p + 8, 4);
+            last_seq = seq;
+            ++states;
+        }
+    });
+    EXPECT_TRUE(link.attach(lb.usb->fd()));
+    Echo echo(lb.master);
+
+    // round trip, one command in flight
+    const int kPing = 2000;
+    std::vector<double> rtt;
+    rtt.reserve(kPing);
+    uint8_t f[kUsbCommandBytes];
+    for (int i = 0; i < kPing; ++i) {
+        usb_encode_command(0.01f * i, -0.01f, 1, i & 1, i, f);
+        const auto t0 = SteadyClock::now();
+        if (!link.send(f, sizeof(f))) break;
+        while (last_seq != i && us_since(t0) < 100000.0) link.poll(10);
+        rtt.push_back(us_since(t0));
+    }
+    std::printf("  round trip (%d): p50 %.1f us  p90 %.1f us  p99 %.1f us  max %.1f us\n", kPing,
+                percentile(rtt, 0.5), percentile(rtt, 0.9), percentile(rtt, 0.99),
+                percentile(rtt, 1.0));
+    EXPECT_TRUE(states == uint64_t(kPing) && aims == uint64_t(kPing));
+    EXPECT_TRUE(link.stats().tx_writes == uint64_t(kPing));   // one syscall per command
+    EXPECT_TRUE(link.parser_stats().bad_checksum == 0);
+
+    // burst: as fast as the link takes them, echo running; a full backlog
+    // waits for the port like the blocking writes below
+    const int kBurst = 50000;
+    states = aims = 0;
+    const SerialLinkStats s0 = link.stats();
+    auto t0 = SteadyClock::now();
+    int sent = 0;
+    for (int i = 0; i < kBurst; ++i) {
+        usb_encode_command(0.01f * i, 0.0f, 1, 0, i, f);
+        while (!link.send(f, sizeof(f)) && us_since(t0) < 5e6) link.poll(1);
+        ++sent;
+        link.poll(0);
+    }
+    while ((link.backlog() > 0 || states < uint64_t(sent)) && us_since(t0) < 5e6) link.poll(1);
+    const double t_new = us_since(t0);
+    const SerialLinkStats &s1 = link.stats();
+    std::printf("  burst: %d/%d commands in %.1f ms, %.2f us/command, %.2f MB/s, %.3f writes/command,"
+                " %llu partial, %llu refused\n",
+                sent, kBurst, 1e-3 * t_new, t_new / kBurst, sent * 30.0 / t_new,
+                double(s1.tx_writes - s0.tx_writes) / kBurst,
+                (unsigned long long)(s1.tx_partial - s0.tx_partial),
+                (unsigned long long)(s1.tx_dropped - s0.tx_dropped));
+    EXPECT_TRUE(sent == kBurst && states == uint64_t(kBurst));
+    EXPECT_TRUE(link.parser_stats().bad_checksum == 0);
+
+    // same burst the old way (blocking fd, two vectors, two writes)
+    link.detach();
+    const int fd = lb.usb->fd();
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    std::atomic<bool> draining{true};
+    std::thread sink([&] {   // host RX side, so the echo never blocks
+        uint8_t buf[4096];
+        while (draining.load()) {
+            pollfd p{fd, POLLIN, 0};
+            if (::poll(&p, 1, 5) > 0) (void)::read(fd, buf, sizeof(buf));
+        }
+    });
+    t0 = SteadyClock::now();
+    int legacy_ok = 0;
+    for (int i = 0; i < kBurst; ++i) legacy_ok += legacy_send(fd, 0.01f * i, 0.0f, 1, 0, i);
+    const double t_old = us_since(t0);
+    draining.store(false);
+    sink.join();
+    std::printf("  legacy: %d/%d commands in %.1f ms, %.2f us/command, 2 writes/command\n",
+                legacy_ok, kBurst, 1e-3 * t_old, t_old / kBurst);
+    std::printf("  per command: %.2f us -> %.2f us\n", t_old / kBurst, t_new / kBurst);
+    EXPECT_TRUE(legacy_ok == kBurst);
+}
+
+// Nobody reads the MCU side: the driver buffer fills, the backlog takes
+// the rest, then whole commands are refused. Once the reader starts, every
+// accepted command arrives intact and in order.
+static void test_backpressure() {
+    std::cout << "[serial] back-pressure\n";
+    Loopback lb;
+    if (!lb.open()) {
+        std::cout << "  openpty failed, skipped\n";
+        return;
+    }
+    SerialLink link(nullptr);
+    EXPECT_TRUE(link.attach(lb.usb->fd()));
+
+    std::vector<int32_t> accepted;
+    uint8_t f[kUsbCommandBytes];
+    int seq = 0;
+    while (link.stats().tx_dropped < 10 && seq < 1000000) {
+        usb_encode_command(0.0f, 0.0f, 1, 0, seq, f);
+        if (link.send(f, sizeof(f))) accepted.push_back(seq);
+        ++seq;
+        link.poll(0);
+    }
+    const SerialLinkStats s = link.stats();
+    std::printf("  stalled: %zu accepted, backlog %zu bytes, %llu partial writes, %llu dropped\n",
+                accepted.size(), link.backlog(), (unsigned long long)s.tx_partial,
+                (unsigned long long)s.tx_dropped);
+    EXPECT_TRUE(s.tx_partial > 0);
+    EXPECT_TRUE(s.tx_dropped == 10);
+    EXPECT_TRUE(link.backlog() > SerialLink::kTxBacklog - kUsbCommandBytes);
+
+    // MCU starts reading
+    std::vector<int32_t> received;
+    UsbFrameParser mcu;
+    uint8_t buf[4096];
+    const auto t0 = SteadyClock::now();
+    while ((link.backlog() > 0 || received.size() < accepted.size()) && us_since(t0) < 5e6) {
+        link.poll(1);
+        const ssize_t n = ::read(lb.master, buf, sizeof(buf));
+        if (n > 0) {
+            mcu.feed(buf, size_t(n), [&](uint8_t type, const uint8_t *p, uint16_t len) {
+                if (type == USB_TX_STATE && len == kUsbStateLen) {
+                    int32_t v;
+                    memcpy(&v, p + 8, 4);
+                    received.push_back(v);
+                }
+            });
+        }
+    }
+    std::printf("  drained: %zu received, %llu bad checksum, %llu bytes skipped\n", received.size(),
+                (unsigned long long)mcu.stats().bad_checksum, (unsigned long long)mcu.stats().skipped);
+    EXPECT_TRUE(received == accepted);
+    EXPECT_TRUE(mcu.stats().bad_checksum == 0 && mcu.stats().skipped == 0);
+    EXPECT_TRUE(link.backlog() == 0);
+
+    // MCU unplugged
+    ::close(lb.master);
+    lb.master = -1;
+    int r = 0;
+    for (int i = 0; i < 10 && r >= 0; ++i) r = link.poll(10);
+    EXPECT_TRUE(r < 0);
+}
+
+int main() {
+    test_crc();
+    test_encode_command();
+    test_loopback();
+    test_backpressure();
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all serial link tests passed\n";
+    return 0;
+}
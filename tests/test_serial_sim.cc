@@ -0,0 +1,257 @@
+/*
+ * test_serial_sim.cc
+ *
+ * Hardware-free serial stack (calibur/sim): the IMU simulator against the
+ * real IMUReader, and the MCU simulator against the host USB stack
+ * (SerialLink, BulletSpeedRx, ClockSync) in a closed gimbal loop, both with
+ * line faults injected. Reports delivery, latency and throughput.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 -pthread -I . -I calibur -I calibur/worker -I apps/yaml-cpp/include \
+ *       tests/test_serial_sim.cc calibur/sim/pty_port.cpp calibur/sim/imu_sim.cpp \
+ *       calibur/sim/mcu_sim.cpp calibur/imu/imu_reader.cpp calibur/imu/imu_clock.cpp \
+ *       calibur/worker/serial_link.cpp \
+ *       calibur/worker/bullet_speed.cpp calibur/worker/clock_sync.cpp \
+ *       calibur/worker/command_streamer.cpp calibur/usb_communication.cpp calibur/log.cpp \
+ *       calibur/config.cc calibur/util.cpp apps/yaml-cpp/lib/libyaml-cpp.a -lutil -o test_serial_sim
+ *
+ * Run:
+ *   ./test_serial_sim
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "calibur/sim/imu_sim.hpp"
+#include "calibur/sim/mcu_sim.hpp"
+#include "calibur/imu/imu_reader.hpp"
+#include "calibur/imu/imu_protocol.hpp"
+#include "bullet_speed.hpp"
+#include "clock_sync.hpp"
+#include "serial_link.hpp"
+#include "calibur/usb_communication.h"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+using SteadyClock = std::chrono::steady_clock;
+
+static double percentile(std::vector<double> v, double q) {
+    if (v.empty()) return 0.0;
+    const size_t k = std::min(v.size() - 1, size_t(q * (v.size() - 1) + 0.5));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+// ---------------------------------------------------------------------------
+
+static void test_imu_frame() {
+    std::cout << "[sim] imu frame encoding\n";
+    ImuSimulator sim;
+    const IMUData d = sim.sample(0.37);
+    uint8_t payload[IMU_MAX_PAYLOAD], frame[IMU_MAX_PAYLOAD + IMU_FRAME_EXTRA];
+    const size_t len = imu_encode_payload(d, payload);
+    const size_t n   = imu_encode_frame(0x1234, payload, len, frame);
+    EXPECT_TRUE(len <= IMU_MAX_PAYLOAD);
+    EXPECT_TRUE(frame[0] == 0x59 && frame[1] == 0x53 && frame[2] == 0x34 && frame[3] == 0x12);
+    EXPECT_TRUE(frame[4] == len && n == len + IMU_FRAME_EXTRA);
+
+    uint8_t ck1, ck2;
+    imu_checksum(frame + 2, len + 3, ck1, ck2);
+    EXPECT_TRUE(ck1 == frame[n - 2] && ck2 == frame[n - 1]);
+
+    // unit quaternion consistent with the euler angles
+    const float qn = d.quat[0] * d.quat[0] + d.quat[1] * d.quat[1] + d.quat[2] * d.quat[2] +
+                     d.quat[3] * d.quat[3];
+    const float yaw_q = std::atan2(2.0f * (d.quat[0] * d.quat[3] + d.quat[1] * d.quat[2]),
+                                   1.0f - 2.0f * (d.quat[2] * d.quat[2] + d.quat[3] * d.quat[3]));
+    EXPECT_TRUE(std::fabs(qn - 1.0f) < 1e-5f);
+    EXPECT_TRUE(std::fabs(yaw_q * 180.0f / 3.14159265f - d.euler_deg[2]) < 1e-3f);
+}
+
+// Simulated IMU at 500 Hz with corrupted frames, line noise and split
+// writes, read by the production IMUReader
+static void test_imu_reader() {
+    std::cout << "[sim] IMUReader against the IMU simulator\n";
+    ImuSimParams p;
+    p.rate_hz      = 500.0;
+    p.corrupt_prob = 0.02;
+    p.garbage_prob = 0.02;
+    p.max_chunk    = 7;
+    ImuSimulator sim(p);
+    if (!sim.start()) {
+        std::cout << "  openpty failed, skipped\n";
+        return;
+    }
+    IMUReader reader(sim.device(), 460800, 0.2f);
+    reader.start();
+
+    std::vector<double> latency_us;
+    std::vector<bool> seen(65536, false);
+    int distinct = 0, wrong = 0;
+    const auto t_end = SteadyClock::now() + std::chrono::milliseconds(2000);
+    while (SteadyClock::now() < t_end) {
+        IMUData d;
+        if (reader.get_latest(d) && !seen[d.seq]) {
+            const auto now = SteadyClock::now();
+            seen[d.seq] = true;
+            ++distinct;
+            const IMUData truth = sim.sample(d.seq / p.rate_hz);
+            if (std::fabs(d.euler_deg[2] - truth.euler_deg[2]) > 1e-5f ||
+                d.ts_sample_us != truth.ts_sample_us) {
+                ++wrong;
+            }
+            SteadyClock::time_point t_emit;
+            if (sim.emitted_at(d.seq, t_emit)) {
+                latency_us.push_back(std::chrono::duration<double, std::micro>(now - t_emit).count());
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    reader.stop();
+    const ImuSimStats s = sim.stats();
+    sim.stop();
+
+    std::printf("  sim: %llu frames (%llu corrupted, %llu noise bursts), reader: %d distinct, %d wrong\n",
+                (unsigned long long)s.frames, (unsigned long long)s.corrupted,
+                (unsigned long long)s.garbage, distinct, wrong);
+    std::printf("  write -> get_latest: p50 %.0f us  p90 %.0f us  p99 %.0f us\n",
+                percentile(latency_us, 0.5), percentile(latency_us, 0.9), percentile(latency_us, 0.99));
+    EXPECT_TRUE(s.frames > 900);
+    EXPECT_TRUE(wrong == 0);
+    EXPECT_TRUE(distinct > int(0.7 * (s.frames - s.corrupted)));
+}
+
+// Host USB stack against the MCU simulator: 1 kHz relative commands close
+// the loop on the gimbal feedback, fire in the second half, pings for the
+// clock; outgoing MCU frames are corrupted / noisy, shooter reports have
+// outliers.
+static void test_mcu_loop() {
+    std::cout << "[sim] USB stack against the MCU simulator\n";
+    McuSimParams mp;
+    mp.link_delay_us      = 300.0;
+    mp.clock_drift        = 80e-6;
+    mp.tick_start_us      = 0xFFFFFFFFu - 1500000u;   // tick wraps 1.5 s in
+    mp.shot_rate_hz       = 20.0;
+    mp.bullet_speed       = 15.5f;
+    mp.speed_outlier_prob = 0.05;
+    mp.corrupt_prob       = 0.01;
+    mp.garbage_prob       = 0.01;
+    McuSimulator mcu(mp);
+    if (!mcu.start()) {
+        std::cout << "  openpty failed, skipped\n";
+        return;
+    }
+
+    calibur::USBCommunication usb(mcu.device());
+    EXPECT_TRUE(usb.open());
+
+    std::atomic<float> bullet_speed{0.0f};
+    BulletSpeedRx speed_rx(BulletSpeedParams(), bullet_speed);
+    ClockSyncParams cp;
+    cp.ping_period = 0.01;
+    ClockSync sync(cp);
+    float fb_yaw = 0.0f, fb_pitch = 0.0f;
+    uint64_t feedback = 0;
+    SerialLink link([&](uint8_t type, const uint8_t *p, uint16_t len) {
+        if (type == USB_RX_PONG) {
+            sync.on_pong(p, len, SteadyClock::now());
+        } else if (type == USB_RX_GIMBAL && len == kUsbGimbalLen) {
+            std::memcpy(&fb_yaw, p, 4);
+            std::memcpy(&fb_pitch, p + 4, 4);
+            ++feedback;
+        } else {
+            speed_rx.on_frame(type, p, len);
+        }
+    });
+    EXPECT_TRUE(link.attach(usb.fd()));
+
+    const float kYaw = 0.4f, kPitch = -0.1f;
+    const auto t0 = SteadyClock::now();
+    auto next = t0;
+    uint64_t commands = 0;
+    for (;;) {
+        const auto now = SteadyClock::now();
+        const double t = std::chrono::duration<double>(now - t0).count();
+        if (t > 3.0) break;
+        link.poll(0);
+        if (now >= next) {
+            uint8_t f[kUsbCommandBytes];
+            usb_encode_command(kYaw - fb_yaw, kPitch - fb_pitch, 1, t > 1.5 ? 1 : 0, 0, f);
+            commands += link.send(f, sizeof(f));
+            next += std::chrono::milliseconds(1);
+        }
+        if (sync.due(now)) {
+            uint8_t f[kUsbPingLen + kUsbFrameExtra];
+            link.send(f, sync.make_ping(now, f));
+        }
+        link.poll(1);
+    }
+    // commands stop; let the wire drain
+    for (int i = 0; i < 20; ++i) link.poll(1);
+
+    const McuSimStats ms = mcu.stats();
+    float g_yaw = 0.0f, g_pitch = 0.0f;
+    mcu.gimbal(g_yaw, g_pitch);
+    const ClockSyncEstimate &e = sync.estimate();
+    const JitterStats d = sync.delay_stats();
+    const auto now = SteadyClock::now();
+    const double off_err = std::fabs(e.host_to_mcu(ClockSync::seconds(now)) - mcu.mcu_seconds(now));
+    const UsbFrameParser::Stats &ps = link.parser_stats();
+
+    std::printf("  host: %llu commands (%.0f/s), %llu feedback, %llu shooter reports, %llu bad checksum\n",
+                (unsigned long long)commands, commands / 3.0, (unsigned long long)feedback,
+                (unsigned long long)speed_rx.estimator().accepted() + speed_rx.estimator().rejected(),
+                (unsigned long long)ps.bad_checksum);
+    std::printf("  mcu: %llu aim, %llu state, %llu ping, %llu bad, %llu shots, %llu corrupted\n",
+                (unsigned long long)ms.aims, (unsigned long long)ms.states,
+                (unsigned long long)ms.pings, (unsigned long long)ms.rx_bad,
+                (unsigned long long)ms.shots, (unsigned long long)ms.corrupted);
+    std::printf("  gimbal %.4f / %.4f rad (target %.2f / %.2f), bullet speed %.3f m/s\n",
+                g_yaw, g_pitch, kYaw, kPitch, bullet_speed.load());
+    std::printf("  clock: offset error %.0f us, drift %.1f ppm (80), one-way p50 %.0f us p99 %.0f us"
+                " (wire %.0f us)\n",
+                1e6 * off_err, 1e6 * e.drift, d.p50_us, d.p99_us, mp.link_delay_us);
+
+    EXPECT_TRUE(commands > 2000);
+    EXPECT_TRUE(ms.aims == commands && ms.states == commands && ms.rx_bad == 0);
+    EXPECT_TRUE(std::fabs(g_yaw - kYaw) < 0.01f && std::fabs(g_pitch - kPitch) < 0.01f);
+    EXPECT_TRUE(ms.shots > 20);
+    EXPECT_TRUE(ps.bad_checksum > 0 || ms.corrupted == 0);
+    EXPECT_TRUE(std::fabs(bullet_speed.load() - 15.5f) < 0.2f);
+    EXPECT_TRUE(e.valid && e.samples > 100);
+    EXPECT_TRUE(std::fabs(e.drift - 80e-6) < 40e-6);
+    EXPECT_TRUE(off_err < 200e-6);
+    EXPECT_TRUE(d.p50_us > 300.0);
+
+    link.detach();
+    mcu.stop();
+}
+
+int main() {
+    test_imu_frame();
+    test_imu_reader();
+    test_mcu_loop();
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all serial sim tests passed\n";
+    return 0;
+}
@@ -0,0 +1,291 @@
+/*
+ * test_tune.cc
+ *
+ * Offline RBPF tuner (tune.hpp, pf_tune): YAML parameter files, detection
+ * log round trip, replay scoring on synthetic logs, and that the search
+ * improves a badly tuned start, is reproducible for a fixed seed and batch
+ * regardless of the thread count, sizes its rounds to the thread count by
+ * default, and replays much faster than real time. CPU backend only, no
+ * CUDA needed.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O3 -fno-math-errno -I calibur/pf -I calibur/worker -I apps/yaml-cpp/include \
+ *       tests/test_tune.cc calibur/pf/tune.cpp calibur/pf/rbpf_params_yaml.cpp \
+ *       calibur/pf/detection_log.cpp calibur/pf/rbpf_cpu.cpp calibur/pf/resample.cpp \
+ *       calibur/pf/kld.cpp calibur/pf/posterior.cpp apps/yaml-cpp/lib/libyaml-cpp.a \
+ *       -pthread -o test_tune
+ *
+ * Run:
+ *   ./test_tune
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "tune.hpp"
+#include "rbpf_params_yaml.hpp"
+#include "rbpf_model.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+static bool same_params(const RBPFParams &a, const RBPFParams &b) {
+    return std::memcmp(&a, &b, sizeof(RBPFParams)) == 0;
+}
+
+// ---------------------------------------------------------------------------
+
+static void test_params_yaml() {
+    std::cout << "[tune] params yaml\n";
+    const std::string path = "/tmp/test_tune_params.yaml";
+
+    // full round trip is exact
+    RBPFParams p = default_params();
+    p.Q_pos_diag[1] = 3.3e-4f;
+    p.Rz_yaw        = 0.0123456f;
+    p.init_vel_std[3] = 0.77f;
+    EXPECT_TRUE(rbpf_params_save(path, p, "test header\nsecond line"));
+
+    RBPFParams q = default_params();
+    EXPECT_TRUE(rbpf_params_load(path, q));
+    EXPECT_TRUE(same_params(p, q));
+
+    // partial file overrides only what it names; scalars fill every axis
+    {
+        std::ofstream f(path);
+        f << "rbpf:\n  q_yaw: 0.5\n  rz_pos: 0.01\n";
+    }
+    q = default_params();
+    EXPECT_TRUE(rbpf_params_load(path, q));
+    const RBPFParams d = default_params();
+    EXPECT_TRUE(q.Q_yaw == 0.5f);
+    EXPECT_TRUE(q.Rz_pos_diag[0] == 0.01f && q.Rz_pos_diag[2] == 0.01f);
+    EXPECT_TRUE(q.Q_acc_diag[0] == d.Q_acc_diag[0] && q.Rz_yaw == d.Rz_yaw);
+
+    // wrong count / missing file: false, p untouched
+    {
+        std::ofstream f(path);
+        f << "rbpf:\n  q_yaw: 0.5\n  q_vel: [1, 2]\n";
+    }
+    q = default_params();
+    EXPECT_TRUE(!rbpf_params_load(path, q));
+    EXPECT_TRUE(same_params(q, d));
+    EXPECT_TRUE(!rbpf_params_load("/tmp/test_tune_does_not_exist.yaml", q));
+    EXPECT_TRUE(same_params(q, d));
+}
+
+static void test_detection_log() {
+    std::cout << "[tune] detection log\n";
+    const std::string path = "/tmp/test_tune_log.csv";
+
+    std::vector<DetectionRecord> in(50);
+    for (size_t i = 0; i < in.size(); ++i) {
+        DetectionRecord &r = in[i];
+        r = DetectionRecord{};
+        r.t = 12345.0 + 0.01 * i;
+        r.z[IDX_TX] = 0.1f * i;  r.z[IDX_TY] = -0.2f;  r.z[IDX_TZ] = 4.5f;
+        r.z[IDX_YAW] = 0.03f * i;
+        r.z[IDX_R1] = 0.25f;  r.z[IDX_R2] = 0.22f;  r.z[IDX_H] = 0.05f;
+    }
+    {
+        DetectionLogWriter w;
+        EXPECT_TRUE(w.open(path));
+        for (const DetectionRecord &r : in) w.append(r.t, r.z);
+    }
+
+    std::vector<DetectionRecord> out;
+    EXPECT_TRUE(detection_log_read(path, out));
+    EXPECT_TRUE(out.size() == in.size());
+    bool close = out.size() == in.size();
+    for (size_t i = 0; close && i < in.size(); ++i) {
+        close = std::fabs(out[i].t - in[i].t) < 1e-6;
+        for (int k = 0; k < D; ++k)
+            close = close && std::fabs(out[i].z[k] - in[i].z[k]) <= 1e-5f * (1.0f + std::fabs(in[i].z[k]));
+    }
+    EXPECT_TRUE(close);
+
+    {
+        std::ofstream f(path);
+        f << "# comment\nt,x,y,z,yaw,r1,r2,h\n0.0,1,2,3,0,0.25,0.25,0\n0.01,1,2\n";
+    }
+    out.clear();
+    EXPECT_TRUE(!detection_log_read(path, out));
+}
+
+static void test_space() {
+    std::cout << "[tune] search space\n";
+
+    // defaults sit inside the box and decode back to themselves
+    const RBPFParams d = default_params();
+    const TunePoint u = tune_encode(d);
+    bool inside = true;
+    for (float x : u) inside = inside && x > 0.0f && x < 1.0f;
+    EXPECT_TRUE(inside);
+
+    RBPFParams p = d;
+    tune_apply(u, p);
+    const float *a = reinterpret_cast<const float *>(&p);
+    const float *b = reinterpret_cast<const float *>(&d);
+    bool close = true;
+    for (size_t k = 0; k < sizeof(RBPFParams) / sizeof(float); ++k)
+        close = close && std::fabs(a[k] - b[k]) <= 1e-4f * std::fabs(b[k]) + 1e-12f;
+    EXPECT_TRUE(close);
+}
+
+// ---------------------------------------------------------------------------
+// Replay on synthetic logs
+
+// Strafing, spinning target at 100 Hz with detection jitter; each log holds
+// two engagements separated by a gap longer than the coast limit.
+static DetectionLog make_log(uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> n_pos(0.0f, 0.01f);
+    std::normal_distribution<float> n_yaw(0.0f, 0.03f);
+    std::normal_distribution<float> jitter(0.0f, 0.0015f);
+
+    DetectionLog log;
+    double t = 0.0;
+    for (int eng = 0; eng < 2; ++eng) {
+        for (int i = 0; i < 300; ++i) {
+            const float ts = float(t);
+            DetectionRecord r{};
+            r.t = t + jitter(rng);
+            r.z[IDX_TX]  = 0.4f * std::sin(2.5f * ts) + n_pos(rng);
+            r.z[IDX_TY]  = 0.1f + n_pos(rng);
+            r.z[IDX_TZ]  = 4.0f + 0.2f * ts + n_pos(rng);
+            r.z[IDX_YAW] = wrap_to_pi(3.0f * ts + n_yaw(rng));
+            r.z[IDX_R1]  = 0.25f;
+            r.z[IDX_R2]  = 0.22f;
+            r.z[IDX_H]   = 0.05f;
+            log.push_back(r);
+            t += 0.01;
+        }
+        t += 1.0;
+    }
+    return log;
+}
+
+static RBPFParams bad_params() {
+    // sluggish: tiny process noise, measurements trusted very little
+    TunePoint u = tune_encode(default_params());
+    for (int k = 0; k < 7; ++k) u[k] = 0.02f;     // Q_*
+    for (int k = 7; k < 12; ++k) u[k] = 0.98f;    // R_*
+    RBPFParams p = default_params();
+    tune_apply(u, p);
+    return p;
+}
+
+static void test_evaluate(const std::vector<DetectionLog> &logs, const TuneOptions &opt) {
+    std::cout << "[tune] evaluate\n";
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const TuneScore a = tune_evaluate(logs, default_params(), opt);
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const TuneScore b = tune_evaluate(logs, default_params(), opt);
+    const TuneScore c = tune_evaluate(logs, bad_params(), opt);
+
+    std::printf("  defaults: loss %.4f  hit %.1f%%  track %.4f m  pred %.4f m  (%d steps, %d preds)\n",
+                a.loss, 100.0 * a.hit_rate, a.track_rmse, a.pred_rmse, a.steps, a.predictions);
+    std::printf("  bad:      loss %.4f  hit %.1f%%  track %.4f m  pred %.4f m\n",
+                c.loss, 100.0 * c.hit_rate, c.track_rmse, c.pred_rmse);
+    std::printf("  replay: %.2f s of log in %.3f s, %.0fx real time\n",
+                a.log_seconds, wall, a.log_seconds / wall);
+
+    // 2 logs x 2 engagements x (299 steps - warm-up); the last ~15 steps of
+    // each engagement have no detection at the horizon
+    const int engagements = 2 * int(logs.size());
+    EXPECT_TRUE(a.steps == engagements * (299 - opt.warmup_steps));
+    EXPECT_TRUE(a.predictions > engagements * (299 - opt.warmup_steps - 16));
+    EXPECT_TRUE(a.predictions <= a.steps);
+    EXPECT_TRUE(a.loss == b.loss && a.hit_rate == b.hit_rate);   // deterministic
+    EXPECT_TRUE(std::fabs(a.log_seconds - 6.99 * logs.size()) < 0.02);      // 2 x 3 s + 1 s gap each
+    EXPECT_TRUE(c.loss > a.loss && c.hit_rate <= a.hit_rate);
+    EXPECT_TRUE(a.log_seconds / wall > 10.0);
+}
+
+static void test_search(const std::vector<DetectionLog> &logs, const TuneOptions &opt) {
+    std::cout << "[tune] search\n";
+
+    const RBPFParams base = bad_params();
+    TuneSearch s;
+    s.trials  = 40;
+    s.startup = 16;
+    s.batch   = 8;
+    s.seed    = 7;
+
+    s.threads = 1;
+    const std::vector<TuneTrial> t1 = tune_run(logs, base, s, opt);
+    s.threads = 2;
+    const std::vector<TuneTrial> t2 = tune_run(logs, base, s, opt);
+
+    EXPECT_TRUE(int(t1.size()) == s.trials && t1.size() == t2.size());
+    EXPECT_TRUE(same_params(t1[0].params, base));
+
+    bool same = t1.size() == t2.size();
+    for (size_t i = 0; same && i < t1.size(); ++i)
+        same = t1[i].score.loss == t2[i].score.loss && t1[i].u == t2[i].u;
+    EXPECT_TRUE(same);
+
+    // default batch: one trial per thread, the same search as that batch
+    s.batch   = 0;
+    s.threads = 4;
+    const std::vector<TuneTrial> t4 = tune_run(logs, base, s, opt);
+    s.batch   = 4;
+    s.threads = 1;
+    const std::vector<TuneTrial> b4 = tune_run(logs, base, s, opt);
+    same = t4.size() == b4.size();
+    for (size_t i = 0; same && i < t4.size(); ++i)
+        same = t4[i].score.loss == b4[i].score.loss && t4[i].u == b4[i].u;
+    EXPECT_TRUE(same);
+
+    size_t best = 0;
+    for (size_t i = 1; i < t1.size(); ++i)
+        if (t1[i].score.loss < t1[best].score.loss) best = i;
+    std::printf("  base loss %.4f (hit %.1f%%) -> best #%zu loss %.4f (hit %.1f%%)\n",
+                t1[0].score.loss, 100.0 * t1[0].score.hit_rate, best,
+                t1[best].score.loss, 100.0 * t1[best].score.hit_rate);
+    EXPECT_TRUE(t1[best].score.loss < 0.8 * t1[0].score.loss);
+    EXPECT_TRUE(t1[best].score.hit_rate > t1[0].score.hit_rate);
+
+    // TPE round beats the random start-up trials on average
+    double mean_rand = 0.0, mean_tpe = 0.0;
+    for (int i = 1; i < s.startup; ++i) mean_rand += t1[i].score.loss;
+    for (int i = s.startup; i < s.trials; ++i) mean_tpe += t1[i].score.loss;
+    mean_rand /= s.startup - 1;
+    mean_tpe  /= s.trials - s.startup;
+    std::printf("  mean loss: random %.4f, tpe %.4f\n", mean_rand, mean_tpe);
+    EXPECT_TRUE(mean_tpe < mean_rand);
+}
+
+int main() {
+    test_params_yaml();
+    test_detection_log();
+    test_space();
+
+    const std::vector<DetectionLog> logs = {make_log(1), make_log(2)};
+    TuneOptions opt;
+    opt.num_particles = 500;
+    test_evaluate(logs, opt);
+    test_search(logs, opt);
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all tune tests passed\n";
+    return 0;
+}
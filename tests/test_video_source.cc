@@ -0,0 +1,357 @@
+/*
+ * test_video_source.cc
+ *
+ * VideoSource (calibur/worker/video_source.hpp): decode-ahead video
+ * playback, against a synthetic decoder with a per-frame cost, key frame
+ * spikes and a slow rewind. Frame order and content across seamless loops,
+ * the three pacings (native real time, max speed, fixed rate), frames
+ * dropped for a slow reader, the bounded frame pool and its leases, the
+ * end of a file without loop, and delivery lateness against decoding on
+ * the reader's thread as CameraMode::VIDEO_FILE used to.
+ *
+ * Compile:
+ *   g++ -std=c++17 -O2 -pthread -I . tests/test_video_source.cc calibur/worker/video_source.cpp \
+ *       -o test_video_source
+ *
+ * Run:
+ *   ./test_video_source
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "calibur/worker/video_source.hpp"
+
+static int g_failures = 0;
+
+#define EXPECT_TRUE(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::cout << "  FAILED: " #cond " (" << __FILE__ << ":" << __LINE__ \
+                      << ")\n";                                                  \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+using SteadyClock = std::chrono::steady_clock;
+
+static double ms_between(SteadyClock::time_point a, SteadyClock::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+// ---------------------------------------------------------------------------
+// Synthetic decoder: `frames` frames a file, each filled with its position
+// in the file (low byte) so a reader can tell which one it has and whether
+// it changed. Decoding sleeps `cost` ms, `key_cost` every key_every frames;
+// a rewind sleeps rewind_cost ms.
+
+struct SyntheticDecoder : VideoDecoder {
+    int    frames = 50;
+    int    width = 320, height = 240;
+    double rate = 100.0;
+    double cost = 1.0, key_cost = 1.0, rewind_cost = 1.0;   // ms
+    int    key_every = 10;
+
+    int pos = 0;
+
+    double fps() const override { return rate; }
+
+    bool read(VideoImage &out) override {
+        if (pos >= frames) return false;
+        const double c = (pos % key_every == 0) ? key_cost : cost;
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(c));
+        out.width    = width;
+        out.height   = height;
+        out.channels = 3;
+        out.step     = std::size_t(width) * 3;
+        out.data.resize(out.step * height);
+        std::memset(out.data.data(), pos & 0xff, out.data.size());
+        ++pos;
+        return true;
+    }
+
+    bool rewind() override {
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(rewind_cost));
+        pos = 0;
+        return true;
+    }
+};
+
+static std::unique_ptr<SyntheticDecoder> make_decoder(int frames, double rate, double cost) {
+    auto d = std::make_unique<SyntheticDecoder>();
+    d->frames   = frames;
+    d->rate     = rate;
+    d->cost     = cost;
+    d->key_cost = cost;
+    return d;
+}
+
+static bool uniform(const VideoFrame &f, int value) {
+    const std::size_t n = f.step * f.height;
+    for (std::size_t i = 0; i < n; i += 997) {
+        if (f.data[i] != uint8_t(value)) return false;
+    }
+    return f.data[n - 1] == uint8_t(value);
+}
+
+// ---------------------------------------------------------------------------
+
+static void test_max_loop() {
+    std::cout << "[video source] max speed, seamless loop\n";
+    VideoSourceParams p;
+    p.pacing = VideoPacing::MAX;
+    VideoSource src(make_decoder(50, 100.0, 0.2), p);
+    src.start();
+    EXPECT_TRUE(src.period() == 0.0);
+
+    std::set<const uint8_t *> buffers;
+    bool in_order = true, content = true;
+    const int n = 175;
+    for (int i = 0; i < n; ++i) {
+        VideoFrame f;
+        if (!src.next(f, std::chrono::milliseconds(500))) {
+            in_order = false;
+            break;
+        }
+        in_order = in_order && f.index == uint64_t(i) && f.loop == uint32_t(i / 50) && f.dropped == 0;
+        content  = content && uniform(f, i % 50);
+        buffers.insert(f.data);
+    }
+    const VideoSourceStats s = src.stats();
+    src.stop();
+    std::printf("  %llu delivered, %llu loops, %zu buffers, decode %.2f ms mean / %.2f ms max\n",
+                (unsigned long long)s.delivered, (unsigned long long)s.loops, buffers.size(),
+                1e3 * s.decode_mean, 1e3 * s.decode_max);
+    EXPECT_TRUE(in_order);
+    EXPECT_TRUE(content);
+    EXPECT_TRUE(s.loops == 3);
+    EXPECT_TRUE(s.delivered == uint64_t(n));
+    EXPECT_TRUE(int(buffers.size()) <= p.slots);
+    EXPECT_TRUE(s.decode_mean >= 0.0002 && s.decode_mean < 0.005);
+}
+
+static void test_clocked(VideoPacing pacing, double decoder_fps, double rate, double want_period) {
+    VideoSourceParams p;
+    p.pacing = pacing;
+    p.rate   = rate;
+    VideoSource src(make_decoder(40, decoder_fps, 0.5), p);
+    src.start();
+    EXPECT_TRUE(std::abs(src.period() - want_period) < 1e-9);
+
+    const int n = 80;
+    std::vector<VideoFrame::TimePoint> stamps;
+    double late_max = 0.0;
+    bool   in_order = true;
+    const auto t0 = SteadyClock::now();
+    for (int i = 0; i < n; ++i) {
+        VideoFrame f;
+        if (!src.next(f, std::chrono::milliseconds(500))) break;
+        late_max = std::max(late_max, ms_between(f.timestamp, SteadyClock::now()));
+        in_order = in_order && f.index == uint64_t(i);
+        stamps.push_back(f.timestamp);
+    }
+    const double elapsed = ms_between(t0, SteadyClock::now());
+    const VideoSourceStats s = src.stats();
+    src.stop();
+
+    double spacing_err = 0.0;
+    for (std::size_t i = 1; i < stamps.size(); ++i) {
+        spacing_err = std::max(spacing_err, std::abs(ms_between(stamps[i - 1], stamps[i]) - 1e3 * want_period));
+    }
+    std::printf("  %d frames in %.1f ms (schedule %.1f ms), spacing error %.4f ms, late %.2f ms max, "
+                "%llu dropped, %llu slips\n",
+                int(stamps.size()), elapsed, 1e3 * want_period * (n - 1), spacing_err, late_max,
+                (unsigned long long)s.dropped, (unsigned long long)s.slips);
+    EXPECT_TRUE(int(stamps.size()) == n);
+    EXPECT_TRUE(in_order);
+    EXPECT_TRUE(spacing_err < 0.001);
+    EXPECT_TRUE(elapsed > 1e3 * want_period * (n - 1) * 0.98);
+    EXPECT_TRUE(late_max < 5.0);   // wake-up jitter
+    EXPECT_TRUE(s.dropped == 0 && s.slips == 0);
+}
+
+static void test_pacing() {
+    std::cout << "[video source] native real time, 200 fps stream\n";
+    test_clocked(VideoPacing::NATIVE, 200.0, 30.0, 1.0 / 200.0);
+    std::cout << "[video source] native real time, stream without a rate (fallback 250 fps)\n";
+    test_clocked(VideoPacing::NATIVE, 0.0, 250.0, 1.0 / 250.0);
+    std::cout << "[video source] fixed rate, 400 fps over a 100 fps stream\n";
+    test_clocked(VideoPacing::FIXED, 100.0, 400.0, 1.0 / 400.0);
+}
+
+// A reader slower than the stream gets the newest due frame, like a
+// camera; the skipped ones show up in `dropped` and the stamps stay on the
+// stream's grid.
+static void test_slow_reader() {
+    std::cout << "[video source] slow reader drops frames\n";
+    VideoSourceParams p;
+    p.pacing = VideoPacing::NATIVE;
+    p.ahead  = 6;
+    p.slots  = 10;
+    VideoSource src(make_decoder(100, 500.0, 0.2), p);   // 2 ms period
+    src.start();
+
+    bool     consistent = true, on_grid = true;
+    uint64_t prev = 0, dropped = 0;
+    VideoFrame::TimePoint first{};
+    for (int i = 0; i < 40; ++i) {
+        VideoFrame f;
+        if (!src.next(f, std::chrono::milliseconds(500))) {
+            consistent = false;
+            break;
+        }
+        if (i == 0) {
+            first = f.timestamp;
+        } else {
+            consistent = consistent && f.index - prev - 1 == f.dropped;
+            dropped += f.dropped;
+        }
+        const double k = ms_between(first, f.timestamp) / 2.0;
+        on_grid = on_grid && std::abs(k - double(f.index)) < 1e-3;
+        prev = f.index;
+        std::this_thread::sleep_for(std::chrono::microseconds(5000));   // 2.5 periods
+    }
+    const VideoSourceStats s = src.stats();
+    src.stop();
+    std::printf("  40 frames, %llu dropped (%.2f per frame), %llu slips\n", (unsigned long long)dropped,
+                double(dropped) / 39.0, (unsigned long long)s.slips);
+    EXPECT_TRUE(consistent);
+    EXPECT_TRUE(on_grid);
+    EXPECT_TRUE(dropped >= 39 && dropped == s.dropped);
+    EXPECT_TRUE(s.slips == 0);
+}
+
+// The pool is bounded: with every buffer leased the decoder waits, and
+// frames handed out keep their pixels until released, also past stop().
+static void test_leases() {
+    std::cout << "[video source] bounded pool and leases\n";
+    VideoSourceParams p;
+    p.pacing = VideoPacing::MAX;
+    p.ahead  = 2;
+    p.slots  = 4;
+    auto src = std::make_unique<VideoSource>(make_decoder(50, 100.0, 0.1), p);
+    src->start();
+
+    std::vector<VideoFrame> held;
+    for (int i = 0; i < 4; ++i) {
+        VideoFrame f;
+        EXPECT_TRUE(src->next(f, std::chrono::milliseconds(200)));
+        held.push_back(f);
+    }
+    VideoFrame extra;
+    EXPECT_TRUE(!src->next(extra, std::chrono::milliseconds(30)));   // every buffer held
+
+    held.erase(held.begin());   // frame 0 back to the pool
+    EXPECT_TRUE(src->next(extra, std::chrono::milliseconds(200)));
+    EXPECT_TRUE(extra.index == 4 && uniform(extra, 4));
+    held.push_back(extra);
+
+    bool intact = true;
+    for (const VideoFrame &f : held) intact = intact && uniform(f, int(f.index));
+    src->stop();
+    src.reset();
+    for (const VideoFrame &f : held) intact = intact && uniform(f, int(f.index));
+    held.clear();   // releases after the source is gone
+    EXPECT_TRUE(intact);
+}
+
+static void test_end_without_loop() {
+    std::cout << "[video source] end of file without loop\n";
+    VideoSourceParams p;
+    p.pacing = VideoPacing::MAX;
+    p.loop   = false;
+    VideoSource src(make_decoder(5, 100.0, 0.1), p);
+    src.start();
+    int got = 0;
+    VideoFrame f;
+    while (src.next(f, std::chrono::milliseconds(200))) ++got;
+    EXPECT_TRUE(got == 5);
+    EXPECT_TRUE(src.finished());
+    EXPECT_TRUE(src.stats().loops == 0);
+}
+
+// Real time at 100 fps with 3 ms decodes, 15 ms key frames and a 25 ms
+// rewind every 30 frames. Decoding on the reader's thread runs each spike
+// into the frame's delivery; decoding ahead absorbs them.
+static void test_decode_ahead() {
+    std::cout << "[video source] decode ahead vs decode on the reader thread, 100 fps\n";
+    auto make = [] {
+        auto d = std::make_unique<SyntheticDecoder>();
+        d->frames      = 30;
+        d->rate        = 100.0;
+        d->cost        = 3.0;
+        d->key_cost    = 15.0;
+        d->rewind_cost = 25.0;
+        return d;
+    };
+    const int    n      = 120;
+    const double period = 10.0;   // ms
+
+    // inline: read, rewinding at the end, then publish on the due time if
+    // not already past it
+    double inline_late = 0.0;
+    {
+        auto dec = make();
+        VideoImage img;
+        const auto t0 = SteadyClock::now();
+        for (int i = 0; i < n; ++i) {
+            const auto due = t0 + std::chrono::duration_cast<SteadyClock::duration>(
+                                      std::chrono::duration<double, std::milli>(period * i));
+            if (!dec->read(img)) {
+                dec->rewind();
+                dec->read(img);
+            }
+            std::this_thread::sleep_until(due);
+            inline_late = std::max(inline_late, ms_between(due, SteadyClock::now()));
+        }
+    }
+
+    double ahead_late = 0.0;
+    VideoSourceStats s;
+    {
+        VideoSourceParams p;
+        p.pacing = VideoPacing::NATIVE;
+        p.ahead  = 4;
+        VideoSource src(make(), p);
+        src.start();
+        for (int i = 0; i < n; ++i) {
+            VideoFrame f;
+            if (!src.next(f, std::chrono::milliseconds(500))) break;
+            ahead_late = std::max(ahead_late, ms_between(f.timestamp, SteadyClock::now()));
+        }
+        s = src.stats();
+    }
+    std::printf("  late by up to %.2f ms inline, %.2f ms decoded ahead; decode %.2f ms mean / %.2f ms max, "
+                "rewind %.1f ms, %llu loops, %llu dropped, %llu slips\n",
+                inline_late, ahead_late, 1e3 * s.decode_mean, 1e3 * s.decode_max, 1e3 * s.rewind_max,
+                (unsigned long long)s.loops, (unsigned long long)s.dropped, (unsigned long long)s.slips);
+    EXPECT_TRUE(inline_late > 10.0);
+    EXPECT_TRUE(ahead_late < 5.0);
+    EXPECT_TRUE(s.loops >= 3);
+    EXPECT_TRUE(s.dropped == 0 && s.slips == 0);
+    EXPECT_TRUE(s.rewind_max >= 0.025);
+    EXPECT_TRUE(s.decode_max >= 0.015 && s.decode_max < 0.025);   // rewinds aside
+}
+
+int main() {
+    test_max_loop();
+    test_pacing();
+    test_slow_reader();
+    test_leases();
+    test_end_without_loop();
+    test_decode_ahead();
+
+    if (g_failures) {
+        std::cout << g_failures << " FAILURES\n";
+        return 1;
+    }
+    std::cout << "all video source tests passed\n";
+    return 0;
+}